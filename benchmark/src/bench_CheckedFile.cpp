@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: BSL-1.0
+
+// Benchmarks of the page checksums & the paged file I/O.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "CRC32C.h"
+#include "CheckedFile.h"
+
+namespace
+{
+   // Size of the file written & read by the CheckedFile benchmarks
+   constexpr size_t cFileByteCount = 64 * 1024 * 1024;
+
+   const e57::ustring cFileName = "./BenchCheckedFile.e57";
+
+   std::vector<char> randomBytes( size_t count )
+   {
+      std::mt19937 generator( 42 );
+
+      std::vector<char> bytes( count );
+
+      for ( auto &byte : bytes )
+      {
+         byte = static_cast<char>( generator() );
+      }
+
+      return bytes;
+   }
+
+   void writeFile( const std::vector<char> &bytes, size_t chunkSize )
+   {
+      e57::CheckedFile file( cFileName, e57::CheckedFile::Write, e57::ChecksumAll );
+
+      for ( size_t offset = 0; offset < bytes.size(); offset += chunkSize )
+      {
+         file.write( bytes.data() + offset, std::min( chunkSize, bytes.size() - offset ) );
+      }
+
+      file.close();
+   }
+}
+
+// Arguments: number of pages
+static void CRC32CPage( benchmark::State &state )
+{
+   const auto cPageCount = static_cast<size_t>( state.range( 0 ) );
+
+   const auto cPages = randomBytes( cPageCount * e57::CheckedFile::physicalPageSize );
+
+   for ( auto _ : state )
+   {
+      for ( size_t page = 0; page < cPageCount; ++page )
+      {
+         benchmark::DoNotOptimize( e57::CRC32C::calculate(
+            cPages.data() + page * e57::CheckedFile::physicalPageSize,
+            e57::CheckedFile::logicalPageSize ) );
+      }
+   }
+
+   state.SetBytesProcessed(
+      static_cast<int64_t>( state.iterations() * cPageCount * e57::CheckedFile::logicalPageSize ) );
+}
+BENCHMARK( CRC32CPage )->Arg( 64 )->Arg( 1024 );
+
+// Arguments: number of pages
+static void CRC32CPageSoftware( benchmark::State &state )
+{
+   const auto cPageCount = static_cast<size_t>( state.range( 0 ) );
+
+   const auto cPages = randomBytes( cPageCount * e57::CheckedFile::physicalPageSize );
+
+   for ( auto _ : state )
+   {
+      for ( size_t page = 0; page < cPageCount; ++page )
+      {
+         benchmark::DoNotOptimize( e57::CRC32C::calculateSoftware(
+            cPages.data() + page * e57::CheckedFile::physicalPageSize,
+            e57::CheckedFile::logicalPageSize ) );
+      }
+   }
+
+   state.SetBytesProcessed(
+      static_cast<int64_t>( state.iterations() * cPageCount * e57::CheckedFile::logicalPageSize ) );
+}
+BENCHMARK( CRC32CPageSoftware )->Arg( 64 );
+
+// Arguments: number of pages
+static void CRC32CBlocks( benchmark::State &state )
+{
+   const auto cPageCount = static_cast<size_t>( state.range( 0 ) );
+
+   const auto cPages = randomBytes( cPageCount * e57::CheckedFile::physicalPageSize );
+
+   std::vector<uint32_t> checksums( cPageCount );
+
+   for ( auto _ : state )
+   {
+      e57::CRC32C::calculateBlocks( cPages.data(), cPageCount, e57::CheckedFile::physicalPageSize,
+                                    e57::CheckedFile::logicalPageSize, checksums.data() );
+
+      benchmark::DoNotOptimize( checksums.data() );
+   }
+
+   state.SetBytesProcessed(
+      static_cast<int64_t>( state.iterations() * cPageCount * e57::CheckedFile::logicalPageSize ) );
+}
+BENCHMARK( CRC32CBlocks )->Arg( 64 )->Arg( 1024 );
+
+// Arguments: number of bytes written in each call
+static void CheckedFileWrite( benchmark::State &state )
+{
+   const auto cChunkSize = static_cast<size_t>( state.range( 0 ) );
+
+   const auto cBytes = randomBytes( cFileByteCount );
+
+   for ( auto _ : state )
+   {
+      writeFile( cBytes, cChunkSize );
+   }
+
+   state.SetBytesProcessed( static_cast<int64_t>( state.iterations() * cFileByteCount ) );
+}
+BENCHMARK( CheckedFileWrite )
+   ->Arg( 1020 )
+   ->Arg( 64 * 1024 )
+   ->Arg( 1024 * 1024 )
+   ->Unit( benchmark::kMillisecond )
+   ->UseRealTime();
+
+// Arguments: checksum policy, read backend (0 for file, 1 for memory mapped), number of bytes
+// read in each call
+static void CheckedFileRead( benchmark::State &state )
+{
+   const auto cPolicy = static_cast<e57::ReadChecksumPolicy>( state.range( 0 ) );
+   const auto cMode =
+      ( state.range( 1 ) == 0 ) ? e57::CheckedFile::Read : e57::CheckedFile::ReadMemoryMapped;
+   const auto cChunkSize = static_cast<size_t>( state.range( 2 ) );
+
+   writeFile( randomBytes( cFileByteCount ), 1024 * 1024 );
+
+   std::vector<char> buffer( cChunkSize );
+
+   for ( auto _ : state )
+   {
+      e57::CheckedFile file( cFileName, cMode, cPolicy );
+
+      for ( size_t offset = 0; offset < cFileByteCount; offset += cChunkSize )
+      {
+         file.read( buffer.data(), std::min( cChunkSize, cFileByteCount - offset ) );
+      }
+
+      benchmark::DoNotOptimize( buffer.data() );
+
+      file.close();
+   }
+
+   state.SetBytesProcessed( static_cast<int64_t>( state.iterations() * cFileByteCount ) );
+}
+BENCHMARK( CheckedFileRead )
+   ->ArgsProduct(
+      { { e57::ChecksumNone, e57::ChecksumAll }, { 0, 1 }, { 64 * 1024, 1024 * 1024 } } )
+   ->Unit( benchmark::kMillisecond )
+   ->UseRealTime();
+
+// Positional reads of separate ranges, as by the parallel readers. Arguments: number of bytes
+// read in each call
+static void CheckedFileReadAt( benchmark::State &state )
+{
+   const auto cChunkSize = static_cast<size_t>( state.range( 0 ) );
+
+   writeFile( randomBytes( cFileByteCount ), 1024 * 1024 );
+
+   e57::CheckedFile file( cFileName, e57::CheckedFile::Read, e57::ChecksumAll );
+
+   const uint64_t cLogicalLength = file.length();
+   const size_t cReadCount = static_cast<size_t>( cLogicalLength / cChunkSize );
+
+   std::vector<char> buffer( cChunkSize );
+
+   // Read the chunks in a scattered order
+   std::vector<uint64_t> offsets( cReadCount );
+
+   for ( size_t i = 0; i < cReadCount; ++i )
+   {
+      offsets[i] = i * cChunkSize;
+   }
+
+   std::shuffle( offsets.begin(), offsets.end(), std::mt19937( 7 ) );
+
+   for ( auto _ : state )
+   {
+      for ( const uint64_t offset : offsets )
+      {
+         file.readAt( offset, buffer.data(), cChunkSize );
+      }
+
+      benchmark::DoNotOptimize( buffer.data() );
+   }
+
+   file.close();
+
+   state.SetBytesProcessed( static_cast<int64_t>( state.iterations() * cReadCount * cChunkSize ) );
+}
+BENCHMARK( CheckedFileReadAt )
+   ->Arg( 64 * 1024 )
+   ->Arg( 1024 * 1024 )
+   ->Unit( benchmark::kMillisecond )
+   ->UseRealTime();
@@ -0,0 +1,351 @@
+// SPDX-License-Identifier: BSL-1.0
+
+// Benchmarks of the bytestream encoders & decoders, one field at a time.
+
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "Decoder.h"
+#include "Encoder.h"
+#include "ImageFileImpl.h"
+#include "Packet.h"
+#include "SourceDestBufferImpl.h"
+
+namespace
+{
+   // Number of records encoded or decoded in each iteration
+   constexpr size_t cRecordCount = 1 << 20;
+
+   // The decoders are fed at most this many bytes at a time, as from one data packet
+   constexpr size_t cPacketByteCount = e57::DATA_PACKET_MAX;
+
+   // Only used to create the buffers: nothing is written to it
+   e57::ImageFile &scratchFile()
+   {
+      static e57::ImageFile imf( "./BenchCodec.e57", "w" );
+
+      return imf;
+   }
+
+   int64_t fieldMaximum( unsigned bits )
+   {
+      return ( bits == 64 ) ? std::numeric_limits<int64_t>::max()
+                            : static_cast<int64_t>( ( uint64_t( 1 ) << bits ) - 1 );
+   }
+
+   int64_t fieldMinimum( unsigned bits )
+   {
+      return ( bits == 64 ) ? std::numeric_limits<int64_t>::lowest() : 0;
+   }
+
+   std::vector<int64_t> randomIntegers( unsigned bits )
+   {
+      std::mt19937_64 generator( bits );
+      std::uniform_int_distribution<int64_t> distribution( fieldMinimum( bits ),
+                                                           fieldMaximum( bits ) );
+
+      std::vector<int64_t> values( cRecordCount );
+
+      for ( auto &value : values )
+      {
+         value = distribution( generator );
+      }
+
+      return values;
+   }
+
+   template <typename T> std::vector<T> randomReals()
+   {
+      std::mt19937_64 generator( sizeof( T ) );
+      std::uniform_real_distribution<T> distribution( -1000.0, 1000.0 );
+
+      std::vector<T> values( cRecordCount );
+
+      for ( auto &value : values )
+      {
+         value = distribution( generator );
+      }
+
+      return values;
+   }
+
+   // Encode all the values of the source buffer, passing the output to @a sink a packet at a time
+   template <typename Sink> void encodeAll( e57::Encoder &encoder, size_t count, Sink sink )
+   {
+      const uint64_t cEnd = encoder.currentRecordIndex() + count;
+
+      while ( encoder.currentRecordIndex() < cEnd )
+      {
+         encoder.processRecords( static_cast<size_t>( cEnd - encoder.currentRecordIndex() ) );
+
+         sink( encoder );
+      }
+
+      encoder.registerFlushToOutput();
+
+      sink( encoder );
+   }
+
+   std::vector<char> encodedBytes( e57::Encoder &encoder, size_t count )
+   {
+      std::vector<char> bytes;
+
+      encodeAll( encoder, count, [&bytes]( e57::Encoder &e ) {
+         const size_t cAvailable = e.outputAvailable();
+         const size_t cSize = bytes.size();
+
+         bytes.resize( cSize + cAvailable );
+         e.outputRead( bytes.data() + cSize, cAvailable );
+         e.outputClear();
+      } );
+
+      return bytes;
+   }
+
+   void decodeAll( e57::Decoder &decoder, const std::vector<char> &bytes )
+   {
+      decoder.stateReset( 0 );
+
+      size_t offset = 0;
+
+      while ( decoder.totalRecordsCompleted() < cRecordCount )
+      {
+         const size_t cCount = std::min( cPacketByteCount, bytes.size() - offset );
+
+         offset += decoder.inputProcess( bytes.data() + offset, cCount );
+      }
+   }
+
+   template <typename RegisterT> std::unique_ptr<e57::Encoder>
+   integerEncoder( e57::SourceDestBuffer &sbuf, unsigned bits, bool isScaledInteger, double scale )
+   {
+      return std::unique_ptr<e57::Encoder>( new e57::BitpackIntegerEncoder<RegisterT>(
+         isScaledInteger, 0, sbuf, e57::DATA_PACKET_MAX, fieldMinimum( bits ), fieldMaximum( bits ),
+         scale, 0.0 ) );
+   }
+
+   // Pick the register size like Encoder::EncoderFactory()
+   std::unique_ptr<e57::Encoder> makeIntegerEncoder( e57::SourceDestBuffer &sbuf, unsigned bits,
+                                                     bool isScaledInteger = false,
+                                                     double scale = 1.0 )
+   {
+      if ( bits <= 8 )
+      {
+         return integerEncoder<uint8_t>( sbuf, bits, isScaledInteger, scale );
+      }
+
+      if ( bits <= 16 )
+      {
+         return integerEncoder<uint16_t>( sbuf, bits, isScaledInteger, scale );
+      }
+
+      if ( bits <= 32 )
+      {
+         return integerEncoder<uint32_t>( sbuf, bits, isScaledInteger, scale );
+      }
+
+      return integerEncoder<uint64_t>( sbuf, bits, isScaledInteger, scale );
+   }
+
+   template <typename RegisterT> std::unique_ptr<e57::Decoder>
+   integerDecoder( e57::SourceDestBuffer &dbuf, unsigned bits, bool isScaledInteger, double scale )
+   {
+      return std::unique_ptr<e57::Decoder>( new e57::BitpackIntegerDecoder<RegisterT>(
+         isScaledInteger, 0, dbuf, fieldMinimum( bits ), fieldMaximum( bits ), scale, 0.0,
+         cRecordCount ) );
+   }
+
+   // Pick the register size like Decoder::DecoderFactory()
+   std::unique_ptr<e57::Decoder> makeIntegerDecoder( e57::SourceDestBuffer &dbuf, unsigned bits,
+                                                     bool isScaledInteger = false,
+                                                     double scale = 1.0 )
+   {
+      if ( bits <= 8 )
+      {
+         return integerDecoder<uint8_t>( dbuf, bits, isScaledInteger, scale );
+      }
+
+      if ( bits <= 16 )
+      {
+         return integerDecoder<uint16_t>( dbuf, bits, isScaledInteger, scale );
+      }
+
+      if ( bits <= 32 )
+      {
+         return integerDecoder<uint32_t>( dbuf, bits, isScaledInteger, scale );
+      }
+
+      return integerDecoder<uint64_t>( dbuf, bits, isScaledInteger, scale );
+   }
+
+   void setCounters( benchmark::State &state, size_t byteCount )
+   {
+      state.SetItemsProcessed( static_cast<int64_t>( state.iterations() * cRecordCount ) );
+      state.SetBytesProcessed( static_cast<int64_t>( state.iterations() * byteCount ) );
+   }
+}
+
+// Arguments: bits per value
+static void BitpackIntegerEncoder( benchmark::State &state )
+{
+   const auto cBits = static_cast<unsigned>( state.range( 0 ) );
+
+   auto values = randomIntegers( cBits );
+
+   e57::SourceDestBuffer sbuf( scratchFile(), "value", values.data(), cRecordCount, true );
+
+   auto encoder = makeIntegerEncoder( sbuf, cBits );
+
+   size_t byteCount = 0;
+
+   for ( auto _ : state )
+   {
+      sbuf.impl()->rewind();
+
+      byteCount = 0;
+
+      encodeAll( *encoder, cRecordCount, [&byteCount]( e57::Encoder &e ) {
+         byteCount += e.outputAvailable();
+         e.outputClear();
+      } );
+   }
+
+   setCounters( state, byteCount );
+}
+BENCHMARK( BitpackIntegerEncoder )->DenseRange( 4, 64, 4 )->Arg( 1 )->Arg( 13 )->Arg( 63 );
+
+// Arguments: bits per value
+static void BitpackIntegerDecoder( benchmark::State &state )
+{
+   const auto cBits = static_cast<unsigned>( state.range( 0 ) );
+
+   auto values = randomIntegers( cBits );
+
+   e57::SourceDestBuffer sbuf( scratchFile(), "value", values.data(), cRecordCount, true );
+
+   const auto cBytes = encodedBytes( *makeIntegerEncoder( sbuf, cBits ), cRecordCount );
+
+   std::vector<int64_t> decoded( cRecordCount );
+   e57::SourceDestBuffer dbuf( scratchFile(), "value", decoded.data(), cRecordCount, true );
+
+   auto decoder = makeIntegerDecoder( dbuf, cBits );
+
+   for ( auto _ : state )
+   {
+      dbuf.impl()->rewind();
+
+      decodeAll( *decoder, cBytes );
+
+      benchmark::DoNotOptimize( decoded.data() );
+   }
+
+   if ( decoded != values )
+   {
+      state.SkipWithError( "decoded values differ" );
+   }
+
+   setCounters( state, cBytes.size() );
+}
+BENCHMARK( BitpackIntegerDecoder )->DenseRange( 4, 64, 4 )->Arg( 1 )->Arg( 13 )->Arg( 63 );
+
+// Scaled integers decoded to doubles, as for cartesian coordinates. Arguments: bits per value
+static void BitpackScaledIntegerDecoder( benchmark::State &state )
+{
+   const auto cBits = static_cast<unsigned>( state.range( 0 ) );
+   constexpr double cScale = 0.001;
+
+   auto values = randomIntegers( cBits );
+
+   std::vector<double> scaled( cRecordCount );
+
+   for ( size_t i = 0; i < cRecordCount; ++i )
+   {
+      scaled[i] = static_cast<double>( values[i] ) * cScale;
+   }
+
+   e57::SourceDestBuffer sbuf( scratchFile(), "value", scaled.data(), cRecordCount, true, true );
+
+   const auto cBytes =
+      encodedBytes( *makeIntegerEncoder( sbuf, cBits, true, cScale ), cRecordCount );
+
+   std::vector<double> decoded( cRecordCount );
+   e57::SourceDestBuffer dbuf( scratchFile(), "value", decoded.data(), cRecordCount, true, true );
+
+   auto decoder = makeIntegerDecoder( dbuf, cBits, true, cScale );
+
+   for ( auto _ : state )
+   {
+      dbuf.impl()->rewind();
+
+      decodeAll( *decoder, cBytes );
+
+      benchmark::DoNotOptimize( decoded.data() );
+   }
+
+   setCounters( state, cBytes.size() );
+}
+BENCHMARK( BitpackScaledIntegerDecoder )->Arg( 16 )->Arg( 20 )->Arg( 24 )->Arg( 32 );
+
+// Arguments: 1 for single precision, 2 for double precision
+static void BitpackFloatEncoder( benchmark::State &state )
+{
+   const auto cPrecision = ( state.range( 0 ) == 1 ) ? e57::PrecisionSingle : e57::PrecisionDouble;
+
+   auto values = randomReals<double>();
+
+   e57::SourceDestBuffer sbuf( scratchFile(), "value", values.data(), cRecordCount, true );
+
+   e57::BitpackFloatEncoder encoder( 0, sbuf, e57::DATA_PACKET_MAX, cPrecision );
+
+   size_t byteCount = 0;
+
+   for ( auto _ : state )
+   {
+      sbuf.impl()->rewind();
+
+      byteCount = 0;
+
+      encodeAll( encoder, cRecordCount, [&byteCount]( e57::Encoder &e ) {
+         byteCount += e.outputAvailable();
+         e.outputClear();
+      } );
+   }
+
+   setCounters( state, byteCount );
+}
+BENCHMARK( BitpackFloatEncoder )->Arg( 1 )->Arg( 2 );
+
+// Arguments: 1 for single precision, 2 for double precision
+static void BitpackFloatDecoder( benchmark::State &state )
+{
+   const auto cPrecision = ( state.range( 0 ) == 1 ) ? e57::PrecisionSingle : e57::PrecisionDouble;
+
+   auto values = randomReals<double>();
+
+   e57::SourceDestBuffer sbuf( scratchFile(), "value", values.data(), cRecordCount, true );
+
+   e57::BitpackFloatEncoder encoder( 0, sbuf, e57::DATA_PACKET_MAX, cPrecision );
+
+   const auto cBytes = encodedBytes( encoder, cRecordCount );
+
+   std::vector<double> decoded( cRecordCount );
+   e57::SourceDestBuffer dbuf( scratchFile(), "value", decoded.data(), cRecordCount, true );
+
+   e57::BitpackFloatDecoder decoder( 0, dbuf, cPrecision, cRecordCount );
+
+   for ( auto _ : state )
+   {
+      dbuf.impl()->rewind();
+
+      decodeAll( decoder, cBytes );
+
+      benchmark::DoNotOptimize( decoded.data() );
+   }
+
+   setCounters( state, cBytes.size() );
+}
+BENCHMARK( BitpackFloatDecoder )->Arg( 1 )->Arg( 2 );
@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: BSL-1.0
+
+// Benchmarks of writing & reading whole scans of synthetic points through the Simple API.
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+#include "E57SimpleReader.h"
+#include "E57SimpleWriter.h"
+
+namespace
+{
+   // Number of points written or read in each call
+   constexpr size_t cBlockPointCount = 1 << 20;
+
+   // The parallel reads use buffers for the whole scan, so they are limited to this size
+   constexpr int64_t cParallelReadMaxPoints = 100000000;
+
+   std::string scanFileName( int64_t pointCount )
+   {
+      return "./BenchScan-" + std::to_string( pointCount ) + ".e57";
+   }
+
+   // Scaled integer coordinates within a 2 km cube, with intensity & colour
+   e57::Data3D scanHeader( int64_t pointCount )
+   {
+      e57::Data3D header;
+      header.guid = "Benchmark Scan GUID";
+      header.pointCount = pointCount;
+
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+      header.pointFields.pointRangeScale = 0.001;
+      header.pointFields.pointRangeMinimum = -1000.0;
+      header.pointFields.pointRangeMaximum = 1000.0;
+
+      header.pointFields.intensityField = true;
+      header.intensityLimits.intensityMaximum = 1.0;
+
+      header.pointFields.colorRedField = true;
+      header.pointFields.colorGreenField = true;
+      header.pointFields.colorBlueField = true;
+      header.colorLimits.colorRedMaximum = 255;
+      header.colorLimits.colorGreenMaximum = 255;
+      header.colorLimits.colorBlueMaximum = 255;
+
+      return header;
+   }
+
+   e57::Data3D blockHeader( const e57::Data3D &header, size_t blockPointCount = cBlockPointCount )
+   {
+      e57::Data3D block = header;
+      block.pointCount = static_cast<int64_t>( blockPointCount );
+
+      return block;
+   }
+
+   void fillBlock( e57::Data3DPointsFloat &points, uint64_t firstPoint, size_t count )
+   {
+      // A cheap, repeatable sequence of scattered points
+      uint64_t state = firstPoint * 6364136223846793005ULL + 1442695040888963407ULL;
+
+      auto next = [&state]() {
+         state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+         return static_cast<uint32_t>( state >> 32 );
+      };
+
+      for ( size_t i = 0; i < count; ++i )
+      {
+         points.cartesianX[i] = static_cast<float>( next() % 2000000 ) * 0.001f - 1000.0f;
+         points.cartesianY[i] = static_cast<float>( next() % 2000000 ) * 0.001f - 1000.0f;
+         points.cartesianZ[i] = static_cast<float>( next() % 200000 ) * 0.001f - 100.0f;
+         points.intensity[i] = static_cast<float>( next() % 1000 ) * 0.001f;
+
+         const uint32_t cColour = next();
+         points.colorRed[i] = static_cast<uint16_t>( cColour & 0xFF );
+         points.colorGreen[i] = static_cast<uint16_t>( ( cColour >> 8 ) & 0xFF );
+         points.colorBlue[i] = static_cast<uint16_t>( ( cColour >> 16 ) & 0xFF );
+      }
+   }
+
+   void writeScan( const std::string &fileName, int64_t pointCount,
+                   const e57::WriterOptions &options, size_t blockPointCount = cBlockPointCount )
+   {
+      e57::Writer writer( fileName, options );
+
+      e57::Data3D header = scanHeader( pointCount );
+
+      const int64_t cScanIndex = writer.NewData3D( header );
+
+      e57::Data3D block = blockHeader( header, blockPointCount );
+      e57::Data3DPointsFloat points( block );
+
+      auto vectorWriter = writer.SetUpData3DPointsData( cScanIndex, blockPointCount, points );
+
+      const auto cBlockSize = static_cast<int64_t>( blockPointCount );
+
+      for ( int64_t start = 0; start < pointCount; start += cBlockSize )
+      {
+         const auto cCount =
+            static_cast<size_t>( std::min<int64_t>( cBlockSize, pointCount - start ) );
+
+         fillBlock( points, static_cast<uint64_t>( start ), cCount );
+
+         vectorWriter.write( cCount );
+      }
+
+      vectorWriter.close();
+      writer.Close();
+   }
+
+   // Write the scan read by the read benchmarks once for each size
+   const std::string &scanFile( int64_t pointCount )
+   {
+      static std::set<std::string> written;
+
+      const auto cInserted = written.insert( scanFileName( pointCount ) );
+
+      if ( cInserted.second )
+      {
+         writeScan( *cInserted.first, pointCount, {} );
+      }
+
+      return *cInserted.first;
+   }
+
+   void setCounters( benchmark::State &state, int64_t pointCount )
+   {
+      state.SetItemsProcessed( state.iterations() * pointCount );
+   }
+
+   // Read all the points of the scan, with only the fields enabled in @a fields
+   void readScan( const e57::Reader &reader, const e57::Data3D &fields )
+   {
+      e57::Data3D block = blockHeader( fields );
+      e57::Data3DPointsFloat points( block );
+
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cBlockPointCount, points );
+
+      while ( vectorReader.read() > 0 )
+      {
+         benchmark::DoNotOptimize( points.cartesianX );
+      }
+
+      vectorReader.close();
+   }
+}
+
+// Arguments: number of points, encode threads (0 for hardware concurrency), background write
+static void WriteScan( benchmark::State &state )
+{
+   const int64_t cPointCount = state.range( 0 );
+
+   e57::WriterOptions options;
+   options.compressedVectorWriter.encodeThreadCount = static_cast<unsigned>( state.range( 1 ) );
+   options.compressedVectorWriter.backgroundWrite = ( state.range( 2 ) != 0 );
+   options.compressedVectorWriter.expectedRecordCount = static_cast<uint64_t>( cPointCount );
+
+   for ( auto _ : state )
+   {
+      writeScan( "./BenchWriteScan.e57", cPointCount, options );
+   }
+
+   setCounters( state, cPointCount );
+}
+BENCHMARK( WriteScan )
+   ->ArgsProduct( { benchmark::CreateRange( 1000000, E57_BENCHMARK_MAX_POINTS, 10 ), { 1, 0 },
+                    { 0, 1 } } )
+   ->Unit( benchmark::kMillisecond )
+   ->UseRealTime();
+
+// Arguments: points written in each call, staging records (0 for none)
+static void WriteScanSmallBlocks( benchmark::State &state )
+{
+   constexpr int64_t cPointCount = 10000000;
+
+   e57::WriterOptions options;
+   options.compressedVectorWriter.stagingRecordCount = static_cast<size_t>( state.range( 1 ) );
+
+   for ( auto _ : state )
+   {
+      writeScan( "./BenchWriteScan.e57", cPointCount, options,
+                 static_cast<size_t>( state.range( 0 ) ) );
+   }
+
+   setCounters( state, cPointCount );
+}
+BENCHMARK( WriteScanSmallBlocks )
+   ->ArgsProduct( { { 1024, 4096, 1 << 20 }, { 0, 1 << 16 } } )
+   ->Unit( benchmark::kMillisecond )
+   ->UseRealTime();
+
+// Arguments: number of points, read backend
+static void ReadScan( benchmark::State &state )
+{
+   const int64_t cPointCount = state.range( 0 );
+
+   e57::ReaderOptions options;
+   options.readBackend = static_cast<e57::ReadBackend>( state.range( 1 ) );
+
+   const std::string &cFileName = scanFile( cPointCount );
+
+   for ( auto _ : state )
+   {
+      e57::Reader reader( cFileName, options );
+
+      e57::Data3D header;
+      reader.ReadData3D( 0, header );
+
+      readScan( reader, header );
+   }
+
+   setCounters( state, cPointCount );
+}
+BENCHMARK( ReadScan )
+   ->ArgsProduct( { benchmark::CreateRange( 1000000, E57_BENCHMARK_MAX_POINTS, 10 ),
+                    { e57::ReadBackendFile, e57::ReadBackendMemoryMapped } } )
+   ->Unit( benchmark::kMillisecond )
+   ->UseRealTime();
+
+// Read only the coordinates. Arguments: number of points, projected packet reads
+static void ReadScanCartesianOnly( benchmark::State &state )
+{
+   const int64_t cPointCount = state.range( 0 );
+
+   e57::ReaderOptions options;
+   options.packetCache.projectedRead = ( state.range( 1 ) != 0 );
+
+   const std::string &cFileName = scanFile( cPointCount );
+
+   for ( auto _ : state )
+   {
+      e57::Reader reader( cFileName, options );
+
+      e57::Data3D header;
+      reader.ReadData3D( 0, header );
+
+      header.pointFields.intensityField = false;
+      header.pointFields.colorRedField = false;
+      header.pointFields.colorGreenField = false;
+      header.pointFields.colorBlueField = false;
+
+      readScan( reader, header );
+   }
+
+   setCounters( state, cPointCount );
+}
+BENCHMARK( ReadScanCartesianOnly )
+   ->ArgsProduct( { benchmark::CreateRange( 1000000, E57_BENCHMARK_MAX_POINTS, 10 ), { 0, 1 } } )
+   ->Unit( benchmark::kMillisecond )
+   ->UseRealTime();
+
+// Arguments: number of points, threads (0 for hardware concurrency)
+static void ReadScanParallel( benchmark::State &state )
+{
+   const int64_t cPointCount = state.range( 0 );
+
+   if ( cPointCount > cParallelReadMaxPoints )
+   {
+      state.SkipWithError( "scan too large for whole-scan buffers" );
+      return;
+   }
+
+   e57::ParallelReadOptions options;
+   options.threadCount = static_cast<unsigned>( state.range( 1 ) );
+
+   const std::string &cFileName = scanFile( cPointCount );
+
+   e57::Reader reader( cFileName, {} );
+
+   e57::Data3D header;
+   reader.ReadData3D( 0, header );
+
+   e57::Data3DPointsFloat points( header );
+
+   for ( auto _ : state )
+   {
+      reader.ReadData3DPointsDataParallel( { 0 }, { &points }, options );
+
+      benchmark::DoNotOptimize( points.cartesianX );
+   }
+
+   setCounters( state, cPointCount );
+}
+BENCHMARK( ReadScanParallel )
+   ->ArgsProduct( { benchmark::CreateRange( 1000000, E57_BENCHMARK_MAX_POINTS, 10 ), { 2, 4, 0 } } )
+   ->Unit( benchmark::kMillisecond )
+   ->UseRealTime();
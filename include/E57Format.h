@@ -33,6 +33,9 @@
 
 #include <cfloat>
 #include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
 #include <memory>
 #include <vector>
 
@@ -114,6 +117,7 @@ namespace e57
       Real32 = 9,   ///< C++ float type
       Real64 = 10,  ///< C++ double type
       UString = 11, ///< Unicode UTF-8 std::string
+      Real16 = 12,  ///< IEEE 754 half precision float (e57::Float16)
 
       /// @deprecated Will be removed in 4.0. Use e57::Int8.
       E57_INT8 E57_DEPRECATED_ENUM( "Will be removed in 4.0. Use Int8." ) = Int8,
@@ -139,6 +143,16 @@ namespace e57
       E57_USTRING E57_DEPRECATED_ENUM( "Will be removed in 4.0. Use UString." ) = UString
    };
 
+   /// @brief An IEEE 754 half precision (binary16) floating point number, the element type of
+   /// ::Real16 buffers (see SourceDestBuffer).
+   /// @details C++ has no half precision type, so this only holds its bits (e.g. to be copied to a
+   /// GPU). Values are rounded to the nearest half as they are stored in a buffer.
+   struct Float16
+   {
+      /// The sign bit, 5 exponent bits & 10 significand bits
+      uint16_t bits;
+   };
+
    /// @brief Default checksum policies for e57::ReadChecksumPolicy
    /// @details These are some convenient default checksum policies, though you can use any value
    /// you want (0-100).
@@ -155,6 +169,89 @@ namespace e57
    /// @see e57::ChecksumPolicy
    using ReadChecksumPolicy = int;
 
+   /// @brief Specifies how an ImageFile opened for reading accesses the file on disk.
+   enum ReadBackend
+   {
+      ReadBackendFile = 0, ///< Read each page using seek & read on the file. This is the default.
+      ReadBackendMemoryMapped ///< Map the whole file into memory once and read pages from there.
+   };
+
+   /// @brief Specifies how an ImageFile uses the operating system's file cache.
+   enum FileCacheMode
+   {
+      FileCacheNormal = 0, ///< Go through the file cache, hinting sequential reads. This is the
+                           ///< default.
+      FileCacheBypass ///< Where supported, bypass the file cache (direct I/O) or drop pages from it
+                      ///< once they are read or written. This suits bulk ingest of files which
+                      ///< would otherwise evict everything else from the cache.
+   };
+
+   /// @brief Specifies how much of the XML section an ImageFile opened for reading builds into
+   /// nodes when it is opened.
+   enum XmlLoadMode
+   {
+      XmlLoadFull = 0, ///< Build the whole node tree when the file is opened. This is the default.
+      XmlLoadLazy ///< Only note where each child of the top-level vectors (e.g. each /data3D &
+                  ///< /images2D entry) is in the XML section, and build its nodes the first time
+                  ///< it is accessed. This makes opening files with large metadata sections
+                  ///< faster when only some of the entries are needed.
+   };
+
+   /// @brief Specifies when the checksums of the pages read from an ImageFile are verified (see
+   /// ReadChecksumPolicy for which of them are).
+   enum ChecksumVerification
+   {
+      ChecksumVerifyInline = 0, ///< Verify each page as it is read, before its data is used. This
+                                ///< is the default.
+      ChecksumVerifyDeferred, ///< Hand the pages to a background thread to verify while the data
+                              ///< is used. A failure (ErrorBadChecksum) is reported by every read
+                              ///< of the file from then on, e.g. the next
+                              ///< CompressedVectorReader::read(), and by ImageFile::close().
+      ChecksumVerifyDeferredUntilClose ///< As ChecksumVerifyDeferred, but only report a failure
+                                       ///< from ImageFile::close() (or
+                                       ///< ImageFile::finishChecksumVerification()).
+   };
+
+   /// @brief Specifies which packet the packet cache of a CompressedVectorReader replaces when it
+   /// is full.
+   enum PacketCachePolicy
+   {
+      PacketCacheLeastRecentlyUsed = 0, ///< Replace the least recently used packet. This is the
+                                        ///< default.
+      PacketCacheLowestOffset ///< Replace the packet nearest the start of the file. This suits
+                              ///< reading forwards, where earlier packets aren't needed again.
+   };
+
+   /// @brief Options for the packet cache of a CompressedVectorReader.
+   struct E57_DLL PacketCacheOptions
+   {
+      /// Number of packets (up to 64 KB each) to keep in memory. Must be at least 1.
+      unsigned packetCount = 32;
+
+      /// Which packet to replace when the cache is full.
+      PacketCachePolicy policy = PacketCacheLeastRecentlyUsed;
+
+      /// When a packet isn't in the cache, also read up to this many of the packets following it
+      /// with the same read. At most half of the cache is used for these. 0 turns read-ahead off.
+      unsigned readAheadCount = 3;
+
+      /// Read the packets beyond those read ahead on a background thread, so that reading the file
+      /// overlaps decoding the packets already in the cache. This uses one extra thread per reader.
+      bool backgroundReadAhead = false;
+
+      /// Only read the bytestreams of the fields being read from each data packet instead of whole
+      /// packets. This saves I/O and checksum time when a few of many fields are read (e.g. only
+      /// cartesianX/Y/Z), and packets holding none of them only cost a read of their header.
+      /// Read-ahead isn't used when this applies. It has no effect if all the fields are read.
+      bool projectedRead = false;
+
+      /// Keep the packets in the cache shared by the readers of the ImageFile, if it has one (see
+      /// ImageFile::setSharedPacketCache()), instead of in a cache of this reader's own. The
+      /// packets read ahead go there too. Projected reads still use a cache of packetCount packets
+      /// of their own, as they only read part of each packet.
+      bool useSharedCache = true;
+   };
+
    /// @name Deprecated Checksum Policies
    /// These have been replaced by the enum e57::ChecksumPolicy.
    ///@{
@@ -181,6 +278,373 @@ namespace e57
 
    ///@}
 
+   /// @brief Runs each of the given tasks and returns once they have all finished.
+   /// @details Used to run the parallel operations of the library on an existing thread pool. The
+   /// tasks may be run in any order and on any threads. The tasks themselves do not throw.
+   using TaskExecutor = std::function<void( const std::vector<std::function<void()>> &tasks )>;
+
+   /// @brief Sets the executor which runs the parallel work of the library when none is given.
+   /// @details Without one (the default), the library starts one thread fewer than
+   /// std::thread::hardware_concurrency() the first time it needs them, and shares them between
+   /// all the readers & writers in the process so together they don't use more threads than
+   /// there are cores. The thread count given to each operation then limits how many of those it
+   /// uses at once. Set one to run the parallel reads, writes & verification which aren't given
+   /// an executor of their own on an existing thread pool (e.g. a TBB arena) instead, or an empty
+   /// one to go back to the shared threads. Applies to the work started afterwards.
+   E57_DLL void setDefaultTaskExecutor( TaskExecutor executor );
+
+   /// @brief Called once an asynchronous operation (e.g. CompressedVectorWriter::closeAsync()) has
+   /// finished, on the background I/O thread which ran it (never the one which started it).
+   /// @details @a error is the exception the operation threw, or nullptr if it succeeded. The
+   /// completion itself shouldn't throw, and shouldn't block waiting for another asynchronous
+   /// operation, as that may need the thread it is holding.
+   using AsyncCompletion = std::function<void( std::exception_ptr error )>;
+
+   /// @brief Called once CompressedVectorReader::readAsync() has finished, on the background I/O
+   /// thread which ran it, with the number of records read.
+   /// @details @a error is the exception the read threw, or nullptr if it succeeded. The
+   /// completion itself shouldn't throw, or block waiting for another asynchronous operation.
+   using AsyncReadCompletion =
+      std::function<void( unsigned recordCount, std::exception_ptr error )>;
+
+   /// @brief Options for a CompressedVectorWriter.
+   struct E57_DLL CompressedVectorWriterOptions
+   {
+      /// Number of threads used to encode the fields (bytestreams) of each packet concurrently.
+      /// 1 (the default) encodes them one after another on the calling thread. 0 means
+      /// std::thread::hardware_concurrency(). They are taken from the threads the library shares
+      /// between its readers & writers (see setDefaultTaskExecutor()).
+      unsigned encodeThreadCount = 1;
+
+      /// Optional executor used to run the encoding instead of the shared threads. If set,
+      /// fields are encoded concurrently whatever encodeThreadCount is.
+      TaskExecutor encodeExecutor;
+
+      /// Write the data packets on a background thread, so that writing the file overlaps
+      /// encoding the next packets. This uses one extra thread per writer.
+      bool backgroundWrite = false;
+
+      /// Number of encoded packets (up to 64 KB each) which may wait to be written in the
+      /// background before the writer waits for them. Must be at least 1.
+      unsigned writeQueuePacketCount = 4;
+
+      /// Number of records expected to be written, or 0 if not known. This is only a hint: the
+      /// writer uses it to reserve its index storage and file space, and to split the records into
+      /// evenly sized chunks. Writing more or fewer records is not an error.
+      uint64_t expectedRecordCount = 0;
+
+      /// Groups of fields (path names in the prototype, e.g. {"cartesianX", "cartesianY",
+      /// "cartesianZ"}) whose bytestreams are written in data packets of their own, instead of
+      /// interleaving every field in each packet. Fields which aren't in any group share one more
+      /// group, and names which aren't in the prototype are ignored. A field may only be in one
+      /// group. The file is still a standard E57 file, but a reader which only reads some of the
+      /// groups can skip the packets of the others (see PacketCacheOptions::projectedRead).
+      std::vector<std::vector<ustring>> packetFieldGroups;
+
+      /// Record the minimum & maximum of each numeric field in each chunk of records, and save
+      /// them in an extension beside the compressed vector when the writer is closed. Readers use
+      /// them to find the records which might be in a range of values (see
+      /// CompressedVectorReader::matchingRecordRanges()). Only used if the CompressedVectorNode
+      /// is in a StructureNode.
+      bool chunkStatistics = false;
+
+      /// Fill each data packet as close to its maximum size (64 KB) as possible. The fields are
+      /// encoded in steps sized from their bits per record so they reach the end of the packet
+      /// together, and a packet is only written when it is full. By default a packet is written
+      /// once it is three quarters full. Fuller packets mean fewer packets to read, cache and
+      /// index. See CompressedVectorWriterStatistics::dataPacketFill.
+      bool fillPackets = false;
+
+      /// Number of records the writer copies the records of each write() call into, in buffers
+      /// of its own, before encoding them. 0 (the default) encodes the records of each call from
+      /// the caller's buffers. Staging makes many small writes (such as a few thousand points
+      /// from each callback of a scanner) as fast as a few large ones: the records are encoded
+      /// in large batches from packed buffers. The staged records are encoded when the staging
+      /// buffers are full, by CompressedVectorWriter::flush() and when the writer is closed, so
+      /// a bad value is only reported then.
+      size_t stagingRecordCount = 0;
+
+      /// Check the values written to float fields against the minimum & maximum of their
+      /// FloatNode, and report those outside them with ::ErrorValueOutOfBounds, as for integer
+      /// fields. They are checked a block at a time with vector compares, and not at all when the
+      /// limits admit every finite value. By default float values are written unchecked.
+      bool checkFloatLimits = false;
+
+      /// Allow the writer to be open at the same time as other concurrent writers of the same
+      /// ImageFile (e.g. one per scan, each used on its own thread). A concurrent writer keeps its
+      /// data packets in memory and writes its whole section at the end of the file when it is
+      /// closed, one writer at a time, so the memory used grows with the size of the encoded
+      /// records. Other writers, BlobWriters & BlobNodes can't be created while concurrent writers
+      /// are open, and the node tree must not be changed while they are being closed (a writer
+      /// adds its chunk statistics to it). backgroundWrite is ignored.
+      bool concurrent = false;
+
+      /// Approximate number of data packets (64 KB of encoded records each) in each chunk of
+      /// records, which is the unit of the index written with the records. 0 (the default) gives
+      /// chunks of about 1 MB. Smaller chunks make seeking, reading in parallel and the chunk
+      /// statistics finer grained, at the cost of a larger index & slightly less full packets.
+      /// When there are more chunks than an index packet holds (2048), the index is written as a
+      /// tree of index packets.
+      unsigned indexPacketInterval = 0;
+
+      /// Path names (in the prototype) of Integer & ScaledInteger fields to encode with the delta
+      /// codec of this library rather than bitPackCodec. It stores the difference of each record
+      /// with the one before it, in blocks of 64 records bit-packed with the width of their
+      /// largest difference, which is much smaller than bitPackCodec for fields which vary slowly
+      /// from one record to the next (e.g. the coordinates or timestamps of a scan in acquisition
+      /// order). The choice is recorded in the codecs of the compressed vector, under an extension
+      /// which readers other than this library don't know (so they can't read those fields).
+      /// Other fields, and fields already in the codecs, are left alone.
+      std::vector<ustring> deltaCodecFields;
+
+      /// Path names (in the prototype) of fields to encode with the LZ codec of this library: the
+      /// bitPackCodec bytestream of the field is compressed in blocks of 16 KB with an LZ4 style
+      /// compressor. It suits fields whose values repeat (e.g. colours, intensities, strings,
+      /// invalid states), and costs little to decode. Like the delta codec it is recorded in the
+      /// codecs under an extension which only this library knows. A field in both lists uses
+      /// the delta codec.
+      std::vector<ustring> lzCodecFields;
+   };
+
+   /// @brief An affine transform applied to the coordinates of the records as they are read (see
+   /// CompressedVectorReader::setCoordinateTransform()).
+   struct E57_DLL CoordinateTransform
+   {
+      /// Path names of the X, Y & Z fields in the prototype. Their buffers must be float or
+      /// double buffers.
+      ustring xPathName = "cartesianX";
+      ustring yPathName = "cartesianY";
+      ustring zPathName = "cartesianZ";
+
+      /// The first three rows of the 4x4 matrix of the transform, in row major order. The point
+      /// (x, y, z) becomes (matrix[0][0] * x + matrix[0][1] * y + matrix[0][2] * z + matrix[0][3],
+      /// ...). The default is the identity.
+      double matrix[3][4] = { { 1.0, 0.0, 0.0, 0.0 },
+                              { 0.0, 1.0, 0.0, 0.0 },
+                              { 0.0, 0.0, 1.0, 0.0 } };
+
+      /// If true, the three fields are the range, azimuth & elevation of spherical coordinates
+      /// (e.g. "sphericalRange", "sphericalAzimuth" & "sphericalElevation"). They are converted to
+      /// cartesian X, Y & Z, in place, before the matrix is applied, so their buffers hold
+      /// cartesian coordinates after each read.
+      bool sphericalInput = false;
+   };
+
+   /// @brief Selects the records returned by a CompressedVectorReader (see
+   /// CompressedVectorReader::setSampling()), e.g. to make a preview of a scan.
+   struct E57_DLL RecordSampling
+   {
+      /// Return only the records whose number is a multiple of this (e.g. 100 for every 100th
+      /// record). 1 returns every record.
+      uint64_t step = 1;
+
+      /// Fraction of those records to return, between 0 and 1. They are chosen pseudo-randomly
+      /// from their record numbers & the seed, so the same records are returned by every reader.
+      /// 1 returns all of them.
+      double rate = 1.0;
+
+      /// Changes the records chosen when rate is less than 1
+      uint64_t seed = 0;
+   };
+
+   /// @brief A range of values of one field of a compressed vector (see
+   /// CompressedVectorReader::matchingRecordRanges()).
+   struct E57_DLL FieldValueRange
+   {
+      /// Path name of the field in the prototype (e.g. "cartesianX")
+      ustring pathName;
+
+      /// Smallest value in the range. For scaled integer fields this is the scaled value.
+      double minimum = -DBL_MAX;
+
+      /// Largest value in the range. For scaled integer fields this is the scaled value.
+      double maximum = DBL_MAX;
+   };
+
+   /// @brief Selects the records left out of the reads of a CompressedVectorReader (see
+   /// CompressedVectorReader::setRecordFilter()), e.g. points with no return. A record is
+   /// returned if it passes all the tests.
+   struct E57_DLL RecordFilter
+   {
+      /// Only return the records where each of these fields is 0 (e.g. "cartesianInvalidState" &
+      /// "isIntensityInvalid"). Each of them must be one of the fields read.
+      std::vector<ustring> invalidStateFields;
+
+      /// Only return the records where the value of each of these fields is within its range
+      /// (e.g. "sphericalRange" up to 80 or a window of "timeStamp"), limits included. Each of
+      /// them must be one of the fields read.
+      std::vector<FieldValueRange> ranges;
+   };
+
+   /// @brief Maps the values of a field to the full range of its buffer as they are read (see
+   /// CompressedVectorReader::setNormalization()), e.g. intensities to floats from 0 to 1 or
+   /// colours to bytes.
+   struct E57_DLL FieldNormalization
+   {
+      /// Path name of the field in the prototype (e.g. "intensity")
+      ustring pathName;
+
+      /// Value stored as 0. For scaled integer fields this is the scaled value.
+      double minimum = 0.0;
+
+      /// Value stored as 1 in floating point buffers, and as the largest value of the type in
+      /// integer buffers (e.g. 255 in uint8_t buffers). For scaled integer fields this is the
+      /// scaled value.
+      double maximum = 1.0;
+   };
+
+   /// @brief A run of consecutive records of a compressed vector.
+   struct E57_DLL RecordRange
+   {
+      uint64_t firstRecord = 0;
+      uint64_t recordCount = 0;
+   };
+
+   /// @brief A chunk of the records of a compressed vector, from the index of its binary section
+   /// (see CompressedVectorNode::readIndex()). Reading may start at the first record of any chunk.
+   struct E57_DLL CompressedVectorChunk
+   {
+      uint64_t firstRecord = 0;    ///< first record of the chunk
+      uint64_t recordCount = 0;    ///< number of records in the chunk
+      uint64_t physicalOffset = 0; ///< file offset of the data packet the chunk starts in
+   };
+
+   /// @brief Counts of the work done on the file of an ImageFile (see ImageFile::statistics()).
+   struct E57_DLL ImageFileStatistics
+   {
+      /// Physical pages (1024 bytes) read from the file, or from memory if it is memory mapped
+      /// or read from a buffer
+      uint64_t pagesRead = 0;
+
+      /// Physical pages written to the file
+      uint64_t pagesWritten = 0;
+
+      /// Pages whose checksum was verified (see ReadChecksumPolicy). Each page is verified at most
+      /// once, however often it is read.
+      uint64_t checksumsVerified = 0;
+
+      /// Time spent verifying the checksums of the pages read & computing those of the pages
+      /// written
+      double checksumSeconds = 0.0;
+
+      /// Time spent parsing the XML section, including the parts parsed later (see XmlLoadLazy)
+      double xmlParseSeconds = 0.0;
+
+      /// Packets found in the shared packet cache (see ImageFile::setSharedPacketCache())
+      uint64_t sharedCacheHits = 0;
+
+      /// Packets which weren't in the shared packet cache, and were read from the file
+      uint64_t sharedCacheMisses = 0;
+
+      /// Packets evicted from the shared packet cache to stay within its budget
+      uint64_t sharedCacheEvictions = 0;
+
+      /// Bytes of the packets in the shared packet cache
+      uint64_t sharedCacheBytes = 0;
+   };
+
+   /// @brief Options for ImageFile::verifyFile().
+   struct E57_DLL FileVerifyOptions
+   {
+      /// Maximum number of threads to use. 0 means use std::thread::hardware_concurrency().
+      /// If an executor is set, this is only used to decide how many pieces to split the work
+      /// into.
+      unsigned threadCount = 0;
+
+      /// Optional executor used to run the work (e.g. on an existing thread pool).
+      TaskExecutor executor;
+
+      /// Number of physical pages (1024 bytes) read at once by each thread. Must be at least 1.
+      size_t blockPageCount = 4096;
+
+      /// Set how the operating system's file cache is used (see FileCacheMode).
+      FileCacheMode fileCache = FileCacheNormal;
+   };
+
+   /// @brief Results of ImageFile::verifyFile().
+   struct E57_DLL FileVerifyReport
+   {
+      /// Physical pages (1024 bytes) whose checksum was verified: all the whole pages of the file
+      uint64_t pageCount = 0;
+
+      /// Pages whose checksum doesn't match their contents, in increasing order
+      std::vector<uint64_t> badPages;
+
+      /// The length of the file isn't a whole number of pages, so its end couldn't be verified
+      bool partialLastPage = false;
+
+      /// Time taken, including opening the file
+      double seconds = 0.0;
+
+      /// Physical bytes verified per second
+      double bytesPerSecond = 0.0;
+   };
+
+   /// @brief Counts of the work done on one bytestream (field) of a compressed vector.
+   struct E57_DLL BytestreamStatistics
+   {
+      /// Path name of the field in the prototype (e.g. "cartesianX")
+      ustring pathName;
+
+      /// Bytes of the bytestream decoded (reading) or encoded (writing)
+      uint64_t byteCount = 0;
+
+      /// Time spent decoding the bytestream. This is only measured when reading.
+      double decodeSeconds = 0.0;
+   };
+
+   /// @brief Counts of the work done by a CompressedVectorReader (see
+   /// CompressedVectorReader::statistics()).
+   struct E57_DLL CompressedVectorReaderStatistics
+   {
+      /// Data packets found in the packet cache
+      uint64_t packetCacheHits = 0;
+
+      /// Data packets which had to be read from the file
+      uint64_t packetCacheMisses = 0;
+
+      /// Packets dropped from the cache to make room for others, including those read ahead
+      uint64_t packetCacheEvictions = 0;
+
+      /// Bytes of data packets which weren't read (see CompressedVectorReader::skippedByteCount())
+      uint64_t skippedByteCount = 0;
+
+      /// Spans of packets read from the file, one for each miss (see
+      /// PacketCacheOptions::readAheadCount)
+      uint64_t readAheadSpans = 0;
+
+      /// Spans which the background thread had already read when they were needed (see
+      /// PacketCacheOptions::backgroundReadAhead)
+      uint64_t prefetchedSpans = 0;
+
+      /// Times reading had to wait for the background thread to finish reading a span. Few waits
+      /// mean that reading the file overlapped decoding.
+      uint64_t readAheadWaits = 0;
+
+      /// One entry for each field being read, in the order of the buffers
+      std::vector<BytestreamStatistics> bytestreams;
+   };
+
+   /// @brief Counts of the work done by a CompressedVectorWriter (see
+   /// CompressedVectorWriter::statistics()).
+   struct E57_DLL CompressedVectorWriterStatistics
+   {
+      /// Data packets written so far
+      uint64_t dataPacketCount = 0;
+
+      /// Index packets written so far. They are written when the writer is closed.
+      uint64_t indexPacketCount = 0;
+
+      /// Total bytes of the data packets written so far
+      uint64_t dataPacketByteCount = 0;
+
+      /// Average size of the data packets as a fraction of the maximum (64 KB)
+      double dataPacketFill = 0.0;
+
+      /// One entry for each bytestream, in the order of the fields in the prototype
+      std::vector<BytestreamStatistics> bytestreams;
+   };
+
    /// @brief The URI of ASTM E57 v1.0 standard XML namespace
    /// @note Even though this URI does not point to a valid document, the standard (section 8.4.2.3)
    /// says that this is the required namespace.
@@ -221,6 +685,10 @@ public:
 
    class BlobNode;
    class BlobNodeImpl;
+   class BlobView;
+   class BlobViewImpl;
+   class BlobWriter;
+   class BlobWriterImpl;
    class CompressedVectorNode;
    class CompressedVectorNodeImpl;
    class CompressedVectorReader;
@@ -231,6 +699,8 @@ public:
    class FloatNodeImpl;
    class ImageFile;
    class ImageFileImpl;
+   class ImageFilePool;
+   class ImageFilePoolImpl;
    class IntegerNode;
    class IntegerNodeImpl;
    class Node;
@@ -363,6 +833,63 @@ public:
       /// @endcond
    };
 
+   /// @brief Strings stored one after another in one block of memory.
+   ///
+   /// Like Apache Arrow's string layout, string @a i is the bytes of @a bytes from offsets[i] up to
+   /// offsets[i + 1]. Use it with a SourceDestBuffer to read or write strings without allocating
+   /// memory for each one.
+   struct E57_DLL StringArena
+   {
+      /// The characters of all the strings
+      std::string bytes;
+
+      /// Where each string starts in @a bytes, followed by the end of the last one
+      std::vector<uint64_t> offsets = { 0 };
+
+      /// Number of strings
+      size_t size() const
+      {
+         return offsets.empty() ? 0 : offsets.size() - 1;
+      }
+
+      /// First character of string @a index
+      const char *data( size_t index ) const
+      {
+         return bytes.data() + offsets[index];
+      }
+
+      /// Number of bytes in string @a index
+      size_t length( size_t index ) const
+      {
+         return static_cast<size_t>( offsets[index + 1] - offsets[index] );
+      }
+
+      /// Copy of string @a index
+      ustring at( size_t index ) const
+      {
+         return ustring( data( index ), length( index ) );
+      }
+
+      /// Add a string at the end
+      void append( const char *chars, size_t count )
+      {
+         if ( offsets.empty() )
+         {
+            offsets.push_back( 0 );
+         }
+
+         bytes.append( chars, count );
+         offsets.push_back( bytes.size() );
+      }
+
+      /// Remove all the strings, keeping the memory allocated
+      void clear()
+      {
+         bytes.clear();
+         offsets.assign( 1, 0 );
+      }
+   };
+
    class E57_DLL SourceDestBuffer
    {
    public:
@@ -397,8 +924,13 @@ public:
       SourceDestBuffer( const ImageFile &destImageFile, const ustring &pathName, double *b,
                         size_t capacity, bool doConversion = false, bool doScaling = false,
                         size_t stride = sizeof( double ) );
+      SourceDestBuffer( const ImageFile &destImageFile, const ustring &pathName, Float16 *b,
+                        size_t capacity, bool doConversion = false, bool doScaling = false,
+                        size_t stride = sizeof( Float16 ) );
       SourceDestBuffer( const ImageFile &destImageFile, const ustring &pathName,
                         std::vector<ustring> *b );
+      SourceDestBuffer( const ImageFile &destImageFile, const ustring &pathName, StringArena *b,
+                        size_t capacity );
 
       ustring pathName() const;
       enum MemoryRepresentation memoryRepresentation() const;
@@ -412,6 +944,13 @@ public:
       void checkInvariant( bool doRecurse = true ) const;
 
       /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+   private:
+      friend class CompressedVectorNodeImpl;
+      friend class CompressedVectorReaderImpl;
+      friend class CompressedVectorWriterImpl;
+
+      explicit SourceDestBuffer( std::shared_ptr<SourceDestBufferImpl> ni );
+
       E57_INTERNAL_ACCESS( SourceDestBuffer )
 
    protected:
@@ -426,10 +965,24 @@ public:
 
       unsigned read();
       unsigned read( std::vector<SourceDestBuffer> &dbufs );
-      void seek( int64_t recordNumber ); // !!! not implemented yet
+      std::future<unsigned> readAsync();
+      void readAsync( AsyncReadCompletion completion );
+      void seek( int64_t recordNumber );
       void close();
       bool isOpen();
       CompressedVectorNode compressedVectorNode() const;
+      uint64_t skippedByteCount() const;
+      CompressedVectorReaderStatistics statistics() const;
+      std::vector<RecordRange>
+         matchingRecordRanges( const std::vector<FieldValueRange> &ranges ) const;
+      void setCoordinateTransform( const CoordinateTransform &transform );
+      void clearCoordinateTransform();
+      void setSampling( const RecordSampling &sampling );
+      void setTrustedRanges( bool trusted );
+      void setRecordFilter( const RecordFilter &filter );
+      void setNormalization( const std::vector<FieldNormalization> &normalizations );
+      void rebind( std::vector<SourceDestBuffer> &dbufs );
+      void setRecordRange( int64_t firstRecord, int64_t recordCount );
 
       void dump( int indent = 0, std::ostream &os = std::cout ) const;
       void checkInvariant( bool doRecurse = true );
@@ -454,9 +1007,15 @@ public:
 
       void write( size_t recordCount );
       void write( std::vector<SourceDestBuffer> &sbufs, size_t recordCount );
+      std::future<void> writeAsync( size_t recordCount );
+      void writeAsync( size_t recordCount, AsyncCompletion completion );
+      void flush();
       void close();
+      std::future<void> closeAsync();
+      void closeAsync( AsyncCompletion completion );
       bool isOpen();
       CompressedVectorNode compressedVectorNode() const;
+      CompressedVectorWriterStatistics statistics() const;
 
       void dump( int indent = 0, std::ostream &os = std::cout ) const;
       void checkInvariant( bool doRecurse = true );
@@ -487,7 +1046,21 @@ public:
 
       // Iterators
       CompressedVectorWriter writer( std::vector<SourceDestBuffer> &sbufs );
+      CompressedVectorWriter writer( std::vector<SourceDestBuffer> &sbufs,
+                                     const CompressedVectorWriterOptions &options );
       CompressedVectorReader reader( const std::vector<SourceDestBuffer> &dbufs );
+      CompressedVectorReader reader( const std::vector<SourceDestBuffer> &dbufs,
+                                     const PacketCacheOptions &cacheOptions );
+
+      // Read all records using several threads
+      uint64_t readParallel( const std::vector<SourceDestBuffer> &dbufs, unsigned threadCount = 0,
+                             const TaskExecutor &executor = {} );
+
+      // Copy to another file without decoding the records
+      CompressedVectorNode copyTo( const ImageFile &destImageFile ) const;
+
+      // Read the index of the records without reading them
+      std::vector<CompressedVectorChunk> readIndex() const;
 
       // Up/Down cast conversion
       operator Node() const;
@@ -693,7 +1266,10 @@ public:
 
       int64_t byteCount() const;
       void read( uint8_t *buf, int64_t start, size_t count );
+      std::future<void> readAsync( uint8_t *buf, int64_t start, size_t count );
+      void readAsync( uint8_t *buf, int64_t start, size_t count, AsyncCompletion completion );
       void write( uint8_t *buf, int64_t start, size_t count );
+      BlobView view( int64_t start, size_t count ) const;
 
       // Up/Down cast conversion
       operator Node() const;
@@ -714,6 +1290,7 @@ public:
       /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
    private:
       friend class E57XmlParser;
+      friend class BlobWriter;
 
       explicit BlobNode( std::shared_ptr<BlobNodeImpl> ni );
 
@@ -727,14 +1304,113 @@ public:
       /// @endcond
    };
 
+   class E57_DLL BlobView
+   {
+   public:
+      BlobView() = default;
+
+      int64_t byteCount() const;
+      size_t segmentCount() const;
+      const uint8_t *segmentData( size_t index ) const;
+      size_t segmentSize( size_t index ) const;
+
+      /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+   private:
+      friend class BlobNode;
+
+      explicit BlobView( std::shared_ptr<BlobViewImpl> impl );
+
+      E57_INTERNAL_ACCESS( BlobView )
+
+   protected:
+      std::shared_ptr<BlobViewImpl> impl_;
+      /// @endcond
+   };
+
+   class E57_DLL BlobWriter
+   {
+   public:
+      BlobWriter() = delete;
+      explicit BlobWriter( const ImageFile &destImageFile );
+
+      void write( const uint8_t *buf, size_t count );
+      uint8_t *buffer( size_t &capacity );
+      void commit( size_t count );
+
+      int64_t byteCount() const;
+      bool isOpen() const;
+      ImageFile destImageFile() const;
+
+      BlobNode close();
+
+      /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+   private:
+      E57_INTERNAL_ACCESS( BlobWriter )
+
+   protected:
+      std::shared_ptr<BlobWriterImpl> impl_;
+      /// @endcond
+   };
+
+   class E57_DLL ReadSource
+   {
+   public:
+      virtual ~ReadSource();
+
+      virtual uint64_t size() = 0;
+      virtual void readAt( uint64_t offset, char *buffer, size_t count ) = 0;
+
+      virtual ustring name() const;
+      virtual size_t blockSize() const;
+      virtual size_t blockCount() const;
+   };
+
+   class E57_DLL WriteSink
+   {
+   public:
+      virtual ~WriteSink();
+
+      virtual void writeAt( uint64_t offset, const char *buffer, size_t count ) = 0;
+      virtual void readAt( uint64_t offset, char *buffer, size_t count ) = 0;
+
+      virtual ustring name() const;
+      virtual void reserve( uint64_t size );
+      virtual void finish();
+      virtual void discard();
+   };
+
+   class E57_DLL MemoryWriteSink : public WriteSink
+   {
+   public:
+      void writeAt( uint64_t offset, const char *buffer, size_t count ) override;
+      void readAt( uint64_t offset, char *buffer, size_t count ) override;
+
+      ustring name() const override;
+      void reserve( uint64_t size ) override;
+
+      const std::vector<char> &data() const;
+      std::vector<char> takeData();
+
+      /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+   private:
+      std::vector<char> data_;
+      /// @endcond
+   };
+
    class E57_DLL ImageFile
    {
    public:
       ImageFile() = delete;
       ImageFile( const ustring &fname, const ustring &mode,
-                 ReadChecksumPolicy checksumPolicy = ChecksumAll );
+                 ReadChecksumPolicy checksumPolicy = ChecksumAll,
+                 ReadBackend readBackend = ReadBackendFile,
+                 FileCacheMode fileCache = FileCacheNormal, XmlLoadMode xmlLoad = XmlLoadFull );
       ImageFile( const char *input, uint64_t size,
                  ReadChecksumPolicy checksumPolicy = ChecksumAll );
+      ImageFile( std::shared_ptr<ReadSource> source,
+                 ReadChecksumPolicy checksumPolicy = ChecksumAll,
+                 XmlLoadMode xmlLoad = XmlLoadFull );
+      explicit ImageFile( std::shared_ptr<WriteSink> sink );
 
       StructureNode root() const;
       void close();
@@ -744,6 +1420,14 @@ public:
       ustring fileName() const;
       int writerCount() const;
       int readerCount() const;
+      void reserveSpace( uint64_t byteCount );
+      ImageFileStatistics statistics() const;
+      void setChecksumVerification( ChecksumVerification verification );
+      void finishChecksumVerification();
+      void setSharedPacketCache( uint64_t byteBudget, unsigned shardCount = 8 );
+
+      static FileVerifyReport verifyFile( const ustring &fname,
+                                          const FileVerifyOptions &options = {} );
 
       // Manipulate registered extensions in the file
       void extensionsAdd( const ustring &prefix, const ustring &uri );
@@ -778,6 +1462,7 @@ public:
       friend class FloatNode;
       friend class StringNode;
       friend class BlobNode;
+      friend class BlobWriter;
 
       explicit ImageFile( std::shared_ptr<ImageFileImpl> imfi );
 
@@ -787,4 +1472,27 @@ public:
       std::shared_ptr<ImageFileImpl> impl_;
       /// @endcond
    };
+
+   class E57_DLL ImageFilePool
+   {
+   public:
+      explicit ImageFilePool( size_t capacity = 16 );
+
+      static ImageFilePool &global();
+
+      ImageFile open( const ustring &fname, ReadChecksumPolicy checksumPolicy = ChecksumAll,
+                      ReadBackend readBackend = ReadBackendFile );
+      void remove( const ustring &fname );
+      void clear();
+      size_t size() const;
+      size_t capacity() const;
+
+      /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+   private:
+      E57_INTERNAL_ACCESS( ImageFilePool )
+
+   protected:
+      std::shared_ptr<ImageFilePoolImpl> impl_;
+      /// @endcond
+   };
 }
@@ -0,0 +1,101 @@
+#pragma once
+// SPDX-License-Identifier: BSL-1.0
+
+/// @file E57Memory.h Accounting of the memory used by the library, and an optional budget.
+
+#include <cstdint>
+
+#include "E57Export.h"
+
+namespace e57
+{
+   namespace Memory
+   {
+      /// @brief Bytes used by one part of the library.
+      struct E57_DLL Usage
+      {
+         /// Bytes in use now
+         uint64_t currentBytes = 0;
+
+         /// Most bytes in use at once since the library was loaded or resetPeaks() was called
+         uint64_t peakBytes = 0;
+      };
+
+      /// @brief Memory used by the library, by part (see statistics()).
+      struct E57_DLL Statistics
+      {
+         /// The packet caches of the CompressedVectorReader objects, and their read-ahead buffers
+         Usage packetCaches;
+
+         /// The packets of the caches shared by all the readers of a file (see
+         /// ImageFile::setSharedPacketCache())
+         Usage sharedPacketCaches;
+
+         /// The input buffers of the decoders of the readers
+         Usage decoders;
+
+         /// The packets, output buffers of the encoders & section spools of the writers, and the
+         /// packets waiting to be written in the background
+         Usage writers;
+
+         /// The node objects of the trees of the files (not counting the strings they hold)
+         Usage nodes;
+
+         /// The buffers allocated by Data3DPointsData_t (not those in a caller's arena)
+         Usage pointBuffers;
+
+         /// All of the above
+         Usage total;
+
+         /// The budget set with setBudget(), or 0 if there is none
+         uint64_t budget = 0;
+
+         /// Number of times a cache or queue was made smaller than asked for to stay within the
+         /// budget
+         uint64_t budgetReductions = 0;
+      };
+
+      /*!
+      @brief Get the memory used by the library now, and the most used at once.
+
+      @details
+      This counts the large buffers & objects of the library, in every thread, as they are
+      allocated & freed. It may be called at any time (e.g. to export the counts to a monitoring
+      system), from any thread.
+
+      @returns The counts so far.
+
+      @throw No E57Exceptions.
+      */
+      E57_DLL Statistics statistics();
+
+      /*!
+      @brief Set the peak of each part to the bytes it uses now.
+
+      @throw No E57Exceptions.
+      */
+      E57_DLL void resetPeaks();
+
+      /*!
+      @brief Set a budget for the total memory of the library.
+
+      @param [in] byteBudget Bytes which the total shouldn't grow beyond, or 0 (the default) for
+      no budget.
+
+      @details
+      With a budget, the caches & queues created while the total is near it are made smaller than
+      asked for, down to the smallest size they work with: the packet caches of readers
+      (PacketCacheOptions::packetCount), the background write queues of writers
+      (CompressedVectorWriterOptions::writeQueuePacketCount), and the shared packet caches, which
+      also evict packets to bring the total back within the budget. Nothing blocks or fails
+      because of the budget, so what can't shrink (nodes, point buffers, the packets being read or
+      written) may still take the total beyond it. Each reduction is counted in
+      Statistics::budgetReductions.
+
+      This may be called at any time, from any thread. It applies to what is created afterwards.
+
+      @throw No E57Exceptions.
+      */
+      E57_DLL void setBudget( uint64_t byteBudget );
+   }
+}
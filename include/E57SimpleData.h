@@ -364,6 +364,39 @@ namespace e57
       SphericalBounds sphericalBounds;
    };
 
+   /// @brief Stores all the LineGroupRecord of a groupingByLine, one field per vector
+   /// @details Each vector holds one entry per group, or is empty if the groups don't have that
+   /// field.
+   struct E57_DLL LineGroupTable
+   {
+      /// @brief The idElementValue of each group
+      std::vector<int64_t> idElementValue;
+
+      /// @brief The startPointIndex of each group
+      std::vector<int64_t> startPointIndex;
+
+      /// @brief The pointCount of each group
+      std::vector<int64_t> pointCount;
+   };
+
+   /// @brief One node of the level-of-detail octree of a scan (see
+   /// WriterOptions::lodNodePointCount)
+   struct E57_DLL LODNode
+   {
+      /// @brief Depth of the node in the octree, 0 for the root.
+      int32_t level = 0;
+
+      /// @brief The region of space covered by the node and its children.
+      /// @details These are in the local coordinate system of the points.
+      CartesianBounds bounds;
+
+      /// @brief Index of the first point of the node in the points of the scan.
+      int64_t firstPoint = 0;
+
+      /// @brief Number of points in the node, which follow firstPoint.
+      int64_t pointCount = 0;
+   };
+
    /// @brief Stores a set of point groups organized by the rowIndex or columnIndex attribute of the
    /// PointRecord
    struct E57_DLL GroupingByLine
@@ -616,6 +649,21 @@ namespace e57
       size_t pointCount = 0;
    };
 
+   /// @brief Interface to supply the memory for the buffers of a Data3DPointsData_t (e.g. from
+   /// huge pages or a NUMA node).
+   class E57_DLL Data3DPointsAllocator
+   {
+   public:
+      virtual ~Data3DPointsAllocator() = default;
+
+      /// @brief Allocate @a size bytes aligned to at least @a alignment bytes. Must not return
+      /// nullptr (throw instead).
+      virtual void *allocate( size_t size, size_t alignment ) = 0;
+
+      /// @brief Free a block of @a size bytes returned by allocate().
+      virtual void deallocate( void *block, size_t size ) = 0;
+   };
+
    /// @brief Stores pointers to user-provided buffers
    template <typename COORDTYPE> struct Data3DPointsData_t
    {
@@ -639,10 +687,51 @@ namespace e57
       */
       explicit Data3DPointsData_t( e57::Data3D &data3D );
 
+      /*!
+      @brief Constructor which allocates buffers for all valid fields in the given Data3D header
+      from @a allocator.
+
+      @details
+      Like Data3DPointsData_t( e57::Data3D & ), but all the buffers are laid out in one block
+      from @a allocator, each aligned to 64 bytes. The block is returned to @a allocator by the
+      destructor, so @a allocator must outlive this object.
+
+      @param [in] data3D Completed header which indicates the fields we are using
+      @param [in] allocator Supplies the memory for the buffers
+
+      @throw ::ErrorValueOutOfBounds
+      @throw ::ErrorInvalidNodeType
+      */
+      Data3DPointsData_t( e57::Data3D &data3D, Data3DPointsAllocator &allocator );
+
+      /*!
+      @brief Constructor which lays out buffers for all valid fields in the given Data3D header
+      inside a caller-supplied arena.
+
+      @details
+      Like Data3DPointsData_t( e57::Data3D & ), but the buffers are placed one after another in
+      @a arena, each aligned to 64 bytes. The arena is not freed by the destructor, so it may be
+      reused for the next scan once this object is gone.
+
+      @param [in] data3D Completed header which indicates the fields we are using
+      @param [in] arena Memory to hold the buffers
+      @param [in] size Size of @a arena in bytes. Must be at least arenaSize( data3D ).
+
+      @throw ::ErrorBadAPIArgument
+      @throw ::ErrorValueOutOfBounds
+      @throw ::ErrorInvalidNodeType
+      */
+      Data3DPointsData_t( e57::Data3D &data3D, void *arena, size_t size );
+
       /// @brief Destructor will delete any memory allocated using the Data3DPointsData_t( const
-      /// e57::Data3D & ) constructor
+      /// e57::Data3D & ) constructor, or return it to the allocator it came from.
       ~Data3DPointsData_t();
 
+      /// @brief Returns the arena size in bytes needed by Data3DPointsData_t( e57::Data3D &, void
+      /// *, size_t ) for the fields & pointCount of @a data3D. This includes room to align the
+      /// start of the arena.
+      static size_t arenaSize( const e57::Data3D &data3D );
+
       /// @brief Pointer to a buffer with the X coordinate (in meters) of the point in Cartesian
       /// coordinates
       COORDTYPE *cartesianX = nullptr;
@@ -729,9 +818,20 @@ namespace e57
       ///@}
 
    private:
+      /// @brief Lay out the buffers of the fields of @a data3D in @a block and return the number
+      /// of bytes used. With a null @a block only the size is calculated.
+      size_t _layOutBuffers( const e57::Data3D &data3D, char *block );
+
       /// @brief Keeps track of whether we used the Data3D constructor or not so we can free our
       /// memory.
       bool _selfAllocated = false;
+
+      /// @brief Allocator the buffers came from, if any.
+      Data3DPointsAllocator *_allocator = nullptr;
+
+      /// @brief The block holding all the buffers when _selfAllocated, and its size.
+      void *_block = nullptr;
+      size_t _blockSize = 0;
    };
 
    using Data3DPointsFloat = Data3DPointsData_t<float>;
@@ -747,6 +847,205 @@ namespace e57
    extern template struct Data3DPointsData_t<float>;
    extern template struct Data3DPointsData_t<double>;
 
+   /*!
+   @brief Describes a buffer of points stored interleaved, one structure per point, such as a
+   buffer to upload to a GPU.
+
+   @details
+   Each field is given by the address of its member in the first point, and the points are
+   @a stride bytes apart. The fields use the names of the fields in the prototype of the points,
+   which are the names of the members of Data3DPointsData_t (e.g. "cartesianX", "colorRed" or
+   "nor:normalX"). For example:
+
+   @code
+   struct Point
+   {
+      float x, y, z;
+      float intensity;
+      uint8_t rgb[3];
+   };
+
+   std::vector<Point> points( pointCount );
+
+   e57::Data3DPointsInterleaved buffers( sizeof( Point ) );
+   buffers.add( "cartesianX", &points[0].x )
+      .add( "cartesianY", &points[0].y )
+      .add( "cartesianZ", &points[0].z )
+      .add( "intensity", &points[0].intensity )
+      .add( "colorRed", &points[0].rgb[0] )
+      .add( "colorGreen", &points[0].rgb[1] )
+      .add( "colorBlue", &points[0].rgb[2] );
+
+   auto reader = e57Reader.SetUpData3DPointsData( scanIndex, pointCount, buffers );
+   @endcode
+
+   Values are converted to & from the type of each member, and scaled integers are scaled. Fields
+   which aren't in the scan are ignored when reading, and when writing.
+   */
+   struct E57_DLL Data3DPointsInterleaved
+   {
+      /// @brief One field of the points
+      struct Field
+      {
+         /// Name of the field in the prototype (e.g. "cartesianX")
+         ustring pathName;
+
+         /// Type of the member holding the field
+         MemoryRepresentation representation = Real64;
+
+         /// Address of the member in the first point
+         void *first = nullptr;
+
+         /// Apply the scale & offset of the field if it is a ScaledInteger. When this is false
+         /// the member holds the raw integers of the field instead (see QuantizedField).
+         bool scaled = true;
+
+         /// Distance in bytes between the values of this field, or 0 for the stride of the
+         /// points. This lets a field be in an array of its own.
+         size_t stride = 0;
+
+         /// Normalize the values read with the limits of the scan (see addNormalized()). Only
+         /// used when reading.
+         bool normalized = false;
+      };
+
+      Data3DPointsInterleaved() = default;
+
+      /// @brief Describe points which are @a pointStride bytes apart (usually the size of the point
+      /// structure).
+      explicit Data3DPointsInterleaved( size_t pointStride ) : stride( pointStride )
+      {
+      }
+
+      /// @brief Add the field @a pathName, held in the member at @a first of the first point.
+      template <typename T> Data3DPointsInterleaved &add( const ustring &pathName, T *first )
+      {
+         fields.push_back( { pathName, representationOf( first ), first } );
+
+         return *this;
+      }
+
+      /// @brief Add the field @a pathName with its raw integers if it is a ScaledInteger (see
+      /// QuantizedField), held in the member at @a first of the first point. The values are
+      /// @a fieldStride bytes apart, or the stride of the points if it is 0.
+      /// @details When writing, integers already in units of the scale (e.g. the ticks of a
+      /// scanner) are checked against the minimum & maximum of the field and packed as they are,
+      /// without converting them to floating point and back.
+      template <typename T>
+      Data3DPointsInterleaved &addRaw( const ustring &pathName, T *first, size_t fieldStride = 0 )
+      {
+         fields.push_back( { pathName, representationOf( first ), first, false, fieldStride } );
+
+         return *this;
+      }
+
+      /// @brief Add the field @a pathName normalized, held in the member at @a first of the first
+      /// point. The values are @a fieldStride bytes apart, or the stride of the points if it is 0.
+      /// @details When reading, "intensity" is mapped from the intensity limits of the scan,
+      /// "colorRed", "colorGreen" & "colorBlue" from its colour limits, and the surface normals
+      /// "nor:normalX", "nor:normalY" & "nor:normalZ" from -1 - 1, to 0 - 1 in a Float16, a float
+      /// or a double, to 0 - 255 in a uint8_t (0 - 65535 in a uint16_t...), or to -127 - 127 in an
+      /// int8_t (-32767 - 32767 in an int16_t...). Values outside the limits are clamped. This
+      /// is done as the values are decoded, so there's no separate pass over the points, and they
+      /// can be read straight into the narrow types a renderer uses (see
+      /// CompressedVectorReader::setNormalization()). Reading throws ::ErrorBadAPIArgument
+      /// for other fields, other types, or if the limits of the scan are empty.
+      template <typename T>
+      Data3DPointsInterleaved &addNormalized( const ustring &pathName, T *first,
+                                              size_t fieldStride = 0 )
+      {
+         fields.push_back(
+            { pathName, representationOf( first ), first, true, fieldStride, true } );
+
+         return *this;
+      }
+
+      /// @brief Add the colour fields normalized to 0 - 255 (see addNormalized()), packed as the
+      /// red, green & blue bytes from @a rgba of each point, e.g. in the 4 bytes of an RGBA8
+      /// colour. The fourth (alpha) byte isn't changed. The colours are @a fieldStride bytes
+      /// apart, or the stride of the points if it is 0.
+      Data3DPointsInterleaved &addNormalizedColor( uint8_t *rgba, size_t fieldStride = 0 )
+      {
+         return addNormalized( "colorRed", rgba, fieldStride )
+            .addNormalized( "colorGreen", rgba + 1, fieldStride )
+            .addNormalized( "colorBlue", rgba + 2, fieldStride );
+      }
+
+      /// Distance in bytes between the points
+      size_t stride = 0;
+
+      /// The fields of the points
+      std::vector<Field> fields;
+
+   private:
+      static MemoryRepresentation representationOf( int8_t * )
+      {
+         return Int8;
+      }
+      static MemoryRepresentation representationOf( uint8_t * )
+      {
+         return UInt8;
+      }
+      static MemoryRepresentation representationOf( int16_t * )
+      {
+         return Int16;
+      }
+      static MemoryRepresentation representationOf( uint16_t * )
+      {
+         return UInt16;
+      }
+      static MemoryRepresentation representationOf( int32_t * )
+      {
+         return Int32;
+      }
+      static MemoryRepresentation representationOf( uint32_t * )
+      {
+         return UInt32;
+      }
+      static MemoryRepresentation representationOf( int64_t * )
+      {
+         return Int64;
+      }
+      static MemoryRepresentation representationOf( bool * )
+      {
+         return Bool;
+      }
+      static MemoryRepresentation representationOf( Float16 * )
+      {
+         return Real16;
+      }
+      static MemoryRepresentation representationOf( float * )
+      {
+         return Real32;
+      }
+      static MemoryRepresentation representationOf( double * )
+      {
+         return Real64;
+      }
+   };
+
+   /// @brief A ScaledInteger field of the points of a scan, as returned by
+   /// Reader::ReadData3DQuantizedFields()
+   /// @details The value of the field is raw * scale + offset, where raw is an integer from
+   /// minimum to maximum. Reading the raw integers (see Data3DPointsInterleaved::addRaw()) in
+   /// the narrowest type holding them takes less memory than reading the scaled values, and the
+   /// scaling can be done later (e.g. on a GPU).
+   struct E57_DLL QuantizedField
+   {
+      /// Name of the field in the prototype (e.g. "cartesianX")
+      ustring pathName;
+
+      /// The narrowest integer type holding every raw integer of the field: unsigned if the
+      /// minimum isn't negative, and at most 32 bits unless the range doesn't fit.
+      MemoryRepresentation representation = Int64;
+
+      int64_t minimum = 0; ///< Smallest raw integer
+      int64_t maximum = 0; ///< Largest raw integer
+
+      double scale = 1.0;  ///< Scale of the raw integers
+      double offset = 0.0; ///< Offset of the raw integers
+   };
+
    /// @brief Stores an image that is to be used only as a visual reference.
    struct E57_DLL VisualReferenceRepresentation
    {
@@ -44,8 +44,112 @@ namespace e57
    {
       /// Set how frequently to verify the checksums (see ReadChecksumPolicy).
       ReadChecksumPolicy checksumPolicy = ChecksumAll;
+
+      /// Set when the checksums are verified (see ChecksumVerification). With a deferred mode,
+      /// Close() also reports a failure found in the background.
+      ChecksumVerification checksumVerification = ChecksumVerifyInline;
+
+      /// Set how the file is accessed (see ReadBackend).
+      ReadBackend readBackend = ReadBackendFile;
+
+      /// Set how the operating system's file cache is used (see FileCacheMode).
+      FileCacheMode fileCache = FileCacheNormal;
+
+      /// Set the packet cache used by each point & group reader (see PacketCacheOptions).
+      PacketCacheOptions packetCache;
+
+      /// If not 0, the point & group readers share one packet cache of this many bytes (see
+      /// ImageFile::setSharedPacketCache()), e.g. when several threads read the same scans.
+      uint64_t sharedPacketCacheBytes = 0;
+
+      /// Set when the nodes of each scan & image are built (see XmlLoadMode).
+      XmlLoadMode xmlLoad = XmlLoadFull;
+
+      /// Apply the pose of each scan to the cartesian coordinates as they are read, so points come
+      /// back in the file's coordinate system. Only scans with a pose whose X, Y & Z are all read
+      /// into floating point buffers of the same type are affected.
+      bool applyPose = false;
+
+      /// Read scans which only have spherical coordinates as cartesian ones. ReadData3D() reports
+      /// cartesian X, Y & Z fields for them, and the range, azimuth & elevation are converted to
+      /// X, Y & Z as they are read into the cartesian buffers of the Data3DPointsData (combined
+      /// with the pose if applyPose is set). The spherical buffers aren't filled.
+      bool sphericalToCartesian = false;
+
+      /// Trust the values of the file to be within the limits of their fields, e.g. for files
+      /// written by your own pipeline. The limits are checked against the type of each buffer
+      /// when a reader is set up, and the values of the fields which always fit are stored without
+      /// checking them one by one (see CompressedVectorReader::setTrustedRanges()). The chunk
+      /// readers used when ReadData3DPointsDataParallel() splits a scan still check every value.
+      bool trustedInput = false;
+
+      /// Only return valid points from the readers of the points of scans. The points whose
+      /// cartesianInvalidState, sphericalInvalidState, isIntensityInvalid, isColorInvalid or
+      /// isTimeStampInvalid is not 0 are dropped as they are decoded (see
+      /// CompressedVectorReader::setRecordFilter()), so the buffers only hold valid points and
+      /// read() returns their number. Only the invalid state fields being read are tested.
+      /// ReadData3DPointsDataParallel() then reads each scan with a single reader.
+      bool validPointsOnly = false;
    };
 
+   /// Headers of a file, as returned by Reader::ReadHeaders()
+   struct E57_DLL FileHeaders
+   {
+      E57Root root;                 ///< File information
+      std::vector<Data3D> data3D;   ///< Header of each scan
+      std::vector<Image2D> images2D; ///< Header of each image
+   };
+
+   /// Options for Reader::ReadData3DPointsDataParallel()
+   struct E57_DLL ParallelReadOptions
+   {
+      /// Maximum number of threads to use. 0 means use std::thread::hardware_concurrency().
+      /// If an executor is set, this is only used to decide how many pieces to split the reads
+      /// into.
+      unsigned threadCount = 0;
+
+      /// Optional executor used to run the reads (e.g. on an existing thread pool).
+      TaskExecutor executor;
+   };
+
+   /// One image to read with Reader::ReadImage2DDataParallel()
+   struct E57_DLL Image2DReadRequest
+   {
+      /// Index of the image. Must be less than Reader::GetImage2DCount().
+      int64_t imageIndex = 0;
+
+      /// Projection of the image to read.
+      Image2DProjection imageProjection = ProjectionVisual;
+
+      /// Format of the image to read.
+      Image2DType imageType = ImageJPEG;
+
+      /// Buffer to read the whole image into, which must hold its size (see
+      /// Reader::GetImage2DSizes()). If nullptr, the image is passed to the callback instead.
+      uint8_t *buffer = nullptr;
+   };
+
+   /// Called by Reader::ReadImage2DDataParallel() with the bytes of each request which has no
+   /// buffer. The bytes are only valid during the call. It may be called from several threads at
+   /// once.
+   using Image2DReadCallback =
+      std::function<void( size_t requestIndex, const uint8_t *data, size_t byteCount )>;
+
+   /// Options for Data3DPointsStream_t
+   struct E57_DLL Data3DStreamOptions
+   {
+      /// Number of points in each block. Must be at least 1.
+      size_t blockPointCount = 65536;
+
+      /// Number of buffer sets to rotate through. Must be at least 1.
+      /// The buffers holding a block stay untouched until this many more blocks have been read, so
+      /// with 2 or more one block can be processed (e.g. on another thread) while the next one is
+      /// read.
+      unsigned bufferCount = 1;
+   };
+
+   template <typename COORDTYPE> class Data3DPointsStream_t;
+
    /// @brief Used for reading an E57 file using E57 Simple API.
    ///
    /// The Reader includes support for the
@@ -58,6 +162,23 @@ namespace e57
       /// @param [in] options Options to be used for the file
       Reader( const ustring &filePath, const ReaderOptions &options );
 
+      /// @brief Reader constructor for an E57 file in memory
+      /// @details The file is read straight from @a buffer, which isn't copied, so it must stay
+      /// unchanged until the Reader is destroyed. ReaderOptions::readBackend, fileCache and
+      /// xmlLoad don't apply to a file in memory.
+      /// @param [in] buffer The contents of the E57 file
+      /// @param [in] size The size of @a buffer in bytes
+      /// @param [in] options Options to be used for the file
+      Reader( const char *buffer, uint64_t size, const ReaderOptions &options );
+
+      /// @brief Reader constructor for an E57 file read through a ReadSource
+      /// @details Use this to read a file from object storage with range requests, or from
+      /// anywhere else other than a local file. ReaderOptions::readBackend and fileCache don't
+      /// apply.
+      /// @param [in] source Where the file is read from
+      /// @param [in] options Options to be used for the file
+      Reader( std::shared_ptr<ReadSource> source, const ReaderOptions &options );
+
       /// @brief Reader constructor (deprecated)
       /// @param [in] filePath Path to E57 file
       /// @deprecated Will be removed in 4.0. Use Reader( const ustring &, const ReaderOptions & )
@@ -80,6 +201,14 @@ namespace e57
       /// @return Returns true if successful
       bool GetE57Root( E57Root &fileHeader ) const;
 
+      /// @brief Reads the headers of all the scans & images of a file, e.g. to catalog it
+      /// @details Only the XML of the headers is parsed (see XmlLoadLazy), whatever
+      /// ReaderOptions::xmlLoad is, and the file is closed before returning.
+      /// @param [in] filePath Path to E57 file
+      /// @param [in] options Options to be used for the file
+      /// @return Returns the headers
+      static FileHeaders ReadHeaders( const ustring &filePath, const ReaderOptions &options );
+
       ///@}
 
       /// @name Image2D
@@ -125,6 +254,29 @@ namespace e57
                                Image2DType imageType, void *buffer, int64_t start,
                                int64_t count ) const;
 
+      /// @brief Gets a read-only view of a whole image, which doesn't copy it when the file is
+      /// memory mapped (see BlobNode::view())
+      /// @param [in] imageIndex index of the image. Must be less than GetImage2DCount()
+      /// @param [in] imageProjection identifies the projection desired.
+      /// @param [in] imageType identifies the image format desired.
+      /// @param [out] view the view of the image's bytes, valid while the file is open
+      /// @return Returns true if the image is in the file.
+      bool ViewImage2DData( int64_t imageIndex, Image2DProjection imageProjection,
+                            Image2DType imageType, BlobView &view ) const;
+
+      /// @brief Reads several images concurrently
+      /// @details The images are read in the order they are in the file, so the reads are as
+      /// sequential as possible, into the buffer of their request or else through @a callback.
+      /// @param [in] requests the images to read
+      /// @param [in] callback called with each image whose request has no buffer
+      /// @param [in] options threads or executor to use
+      /// @return The number of bytes read for each request, 0 if the image isn't in the file
+      /// @throw E57Exception if the arguments are invalid or if any of the reads fails. In the
+      /// latter case the first failure is rethrown once all the reads have finished.
+      std::vector<int64_t> ReadImage2DDataParallel( const std::vector<Image2DReadRequest> &requests,
+                                                    const Image2DReadCallback &callback = {},
+                                                    const ParallelReadOptions &options = {} ) const;
+
       ///@}
 
       /// @name Data3D
@@ -167,6 +319,66 @@ namespace e57
       bool ReadData3DGroupsData( int64_t dataIndex, size_t groupCount, int64_t *idElementValue,
                                  int64_t *startPointIndex, int64_t *pointCount ) const;
 
+      /// @brief Returns all the group data of a scan
+      /// @details The groups are decoded once per scan and kept by the Reader, so this and
+      /// ReadData3DGroupsData() only copy them after the first call. This may be called from
+      /// several threads.
+      /// @param [in] dataIndex This in the index into the images3D vector. Must be less than
+      /// GetData3DCount().
+      /// @return The groups, which stay valid until the Reader is destroyed, or nullptr if the
+      /// scan has no groupingByLine
+      const LineGroupTable *ReadData3DGroups( int64_t dataIndex ) const;
+
+      /// @brief Returns the nodes of the level-of-detail octree of a scan which are at most
+      /// @a maximumLevel deep and whose bounds intersect @a box
+      /// @details The nodes are in the order of their points: by level from the root, then
+      /// along a Morton curve. Reading the points of all the nodes of the first levels gives a
+      /// coarse view of the scan, which the nodes of the deeper levels refine. Use
+      /// CompressedVectorReader::seek() to go to the first point of a node. See
+      /// WriterOptions::lodNodePointCount.
+      /// @param [in] dataIndex This in the index into the images3D vector. Must be less than
+      /// GetData3DCount().
+      /// @param [in] maximumLevel the deepest level to return nodes of
+      /// @param [in] box the region of space to return nodes in (by default, all of it)
+      /// @return The nodes, or an empty vector if the scan has no octree
+      std::vector<LODNode> ReadData3DLODNodes( int64_t dataIndex, int32_t maximumLevel,
+                                               const CartesianBounds &box = {} ) const;
+
+      /// @brief Returns the ScaledInteger fields of the points of a scan, with the narrowest type
+      /// of their raw integers & how to scale them
+      /// @details Read the raw integers with Data3DPointsInterleaved::addRaw(), e.g. into an
+      /// array of the representation of each field, to scale them later (for instance on a
+      /// GPU, as float( raw ) * scale + offset).
+      /// @param [in] dataIndex This in the index into the images3D vector. Must be less than
+      /// GetData3DCount().
+      /// @return The fields, in the order of the prototype
+      std::vector<QuantizedField> ReadData3DQuantizedFields( int64_t dataIndex ) const;
+
+      /// @brief Reads whole lines of a scan using a groupingByLine into a dense 2D image
+      /// @details The lines are columns if the idElementName is "columnIndex" (see
+      /// GetData3DSizes()) and rows otherwise. Lines [firstLine, firstLine + lineCount) are read,
+      /// numbered like the idElementValue of the groups, using the startPointIndex of each group
+      /// to go straight to its points. The image is line-major: a point goes to the element
+      /// ( line - firstLine ) * lineLength + position, where lineLength is rowMax for columns or
+      /// columnMax for rows and position is the row or column index of the point less its
+      /// minimum in the indexBounds. All the non-NULL buffers in @a image must hold
+      /// lineCount * lineLength elements. Elements with no point are left alone, as are lines
+      /// with no group.
+      /// @param [in] dataIndex This in the index into the images3D vector. Must be less than
+      /// GetData3DCount().
+      /// @param [in] firstLine the first line to read
+      /// @param [in] lineCount the number of lines to read
+      /// @param [in] image the buffers to read the lines into
+      /// @return The number of points stored in @a image
+      /// @throw ::ErrorBadAPIArgument if the scan has no groupingByLine, index bounds, or
+      /// startPointIndex and pointCount for its groups
+      int64_t ReadData3DLines( int64_t dataIndex, int64_t firstLine, int64_t lineCount,
+                               const Data3DPointsFloat &image ) const;
+
+      /// @overload
+      int64_t ReadData3DLines( int64_t dataIndex, int64_t firstLine, int64_t lineCount,
+                               const Data3DPointsDouble &image ) const;
+
       /// @brief Use this to read the actual 3D data
       /// @details All the non-NULL buffers in buffers have number of elements = pointCount.
       ///          Call the CompressedVectorReader::read() until all data is read.
@@ -181,6 +393,38 @@ namespace e57
       CompressedVectorReader SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
                                                     const Data3DPointsDouble &buffers ) const;
 
+      /// @brief Use this to read the 3D data into interleaved points (see
+      /// Data3DPointsInterleaved)
+      /// @details The buffer holds pointCount points. Fields of @a buffers which aren't in the
+      /// scan are left alone. Call the CompressedVectorReader::read() until all data is read.
+      /// @param [in] dataIndex data block index
+      /// @param [in] pointCount number of points in the buffer
+      /// @param [in] buffers the fields of the points & their layout
+      /// @return vector reader setup to read the selected data into the provided buffer
+      CompressedVectorReader SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
+                                                    const Data3DPointsInterleaved &buffers ) const;
+
+      /// @brief Reads all the points of several Data3D blocks concurrently
+      /// @details Each block is read into its own buffers, which must be able to hold the
+      /// pointCount of that block's header (e.g. created using Data3DPointsFloat( data3DHeader )).
+      /// If there are fewer blocks than threads, large blocks are also split into chunks using
+      /// their index and the chunks are decoded in parallel. The readers are set up on the
+      /// calling thread and then drained in parallel.
+      /// @param [in] dataIndices indices of the Data3D blocks to read
+      /// @param [in] buffers the buffers for each entry of dataIndices
+      /// @param [in] options threads or executor to use
+      /// @return The number of points read for each entry of dataIndices
+      /// @throw E57Exception if the arguments are invalid or if any of the reads fails. In the
+      /// latter case the first failure is rethrown once all the reads have finished.
+      std::vector<uint64_t> ReadData3DPointsDataParallel(
+         const std::vector<int64_t> &dataIndices, const std::vector<Data3DPointsFloat *> &buffers,
+         const ParallelReadOptions &options = {} ) const;
+
+      /// @overload
+      std::vector<uint64_t> ReadData3DPointsDataParallel(
+         const std::vector<int64_t> &dataIndices, const std::vector<Data3DPointsDouble *> &buffers,
+         const ParallelReadOptions &options = {} ) const;
+
       ///@}
 
       /// @name File information
@@ -203,6 +447,7 @@ namespace e57
       /// @cond documentNonPublic The following isn't part of the API, and isn't documented.
    protected:
       friend class ReaderImpl;
+      template <typename COORDTYPE> friend class Data3DPointsStream_t;
 
       E57_INTERNAL_ACCESS( Reader )
 
@@ -211,4 +456,71 @@ namespace e57
       /// @endcond
    }; // end Reader class
 
+   /// @brief Reads the points of a Data3D block in fixed-size blocks using bounded memory.
+   ///
+   /// The stream allocates Data3DStreamOptions::bufferCount buffer sets of blockPointCount points
+   /// once and reuses them until the end of the section. Only the fields enabled in the pointFields
+   /// of the header given to the constructor are read, so turn off the ones that aren't needed.
+   ///
+   /// @code
+   /// e57::Data3D header;
+   /// reader.ReadData3D( 0, header );
+   /// header.pointFields.colorRedField = false; // etc.
+   ///
+   /// e57::Data3DPointsStreamFloat stream( reader, 0, header );
+   ///
+   /// while ( const size_t count = stream.next() )
+   /// {
+   ///    process( stream.block(), count );
+   /// }
+   /// @endcode
+   template <typename COORDTYPE> class Data3DPointsStream_t
+   {
+   public:
+      /// @brief Sets up a stream of the points of a Data3D block
+      /// @param [in] reader Reader of the file. Must outlive the stream.
+      /// @param [in] dataIndex data block index
+      /// @param [in] data3DHeader header whose pointFields select the fields to read (its
+      /// pointCount is ignored)
+      /// @param [in] options block size & number of buffer sets
+      /// @throw ::ErrorBadAPIArgument
+      Data3DPointsStream_t( const Reader &reader, int64_t dataIndex, const Data3D &data3DHeader,
+                            const Data3DStreamOptions &options = {} );
+
+      Data3DPointsStream_t( const Data3DPointsStream_t & ) = delete;
+      Data3DPointsStream_t &operator=( const Data3DPointsStream_t & ) = delete;
+
+      Data3DPointsStream_t( Data3DPointsStream_t && ) noexcept = default;
+      Data3DPointsStream_t &operator=( Data3DPointsStream_t && ) noexcept = default;
+
+      ~Data3DPointsStream_t();
+
+      /// @brief Reads the next block into the next buffer set
+      /// @return The number of points in the block, or 0 at the end of the section
+      size_t next();
+
+      /// @brief Returns the buffers holding the block read by the last call to next()
+      const Data3DPointsData_t<COORDTYPE> &block() const;
+
+      /// @brief Returns the total number of points read so far
+      uint64_t pointsRead() const;
+
+      /// @brief Closes the underlying CompressedVectorReader. Called by the destructor.
+      void close();
+
+   private:
+      std::vector<std::unique_ptr<Data3DPointsData_t<COORDTYPE>>> buffers_;
+      std::vector<std::vector<SourceDestBuffer>> destBuffers_;
+      std::unique_ptr<CompressedVectorReader> reader_;
+
+      size_t current_ = 0;
+      uint64_t pointsRead_ = 0;
+   };
+
+   using Data3DPointsStreamFloat = Data3DPointsStream_t<float>;
+   using Data3DPointsStreamDouble = Data3DPointsStream_t<double>;
+
+   extern template class Data3DPointsStream_t<float>;
+   extern template class Data3DPointsStream_t<double>;
+
 } // end namespace e57
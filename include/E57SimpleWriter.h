@@ -39,6 +39,15 @@
 
 namespace e57
 {
+   /// @brief Specifies the order in which Writer::WriteData3DData() writes the points of a scan.
+   enum PointOrder
+   {
+      PointOrderAcquisition = 0, ///< Keep the order of the buffers. This is the default.
+      PointOrderMorton,          ///< Sort the points along a Morton (Z-order) curve.
+      PointOrderHilbert ///< Sort the points along a Hilbert curve, which keeps neighbouring points
+                        ///< a little closer together than a Morton curve.
+   };
+
    /// Options to the Writer constructor
    struct E57_DLL WriterOptions
    {
@@ -47,6 +56,86 @@ namespace e57
 
       /// Information describing the Coordinate Reference System to be used for the file
       ustring coordinateMetadata;
+
+      /// Set how the point & group writers encode their data (see CompressedVectorWriterOptions).
+      CompressedVectorWriterOptions compressedVectorWriter;
+
+      /// Set how the operating system's file cache is used (see FileCacheMode).
+      FileCacheMode fileCache = FileCacheNormal;
+
+      /// Compute the cartesianBounds & sphericalBounds of each scan from its points while they are
+      /// encoded, and save them when the points are finished (or when the file is closed, for
+      /// the writers from SetUpData3DPointsData()). Bounds set in the Data3D header are kept.
+      /// The bounds include the points with an invalid state.
+      bool computeBounds = false;
+
+      /// Reorder the points of the scans written by WriteData3DData() along a space-filling curve
+      /// through their cartesian coordinates (converted from spherical ones for spherical scans),
+      /// so points which are close together in space are close together in the file. Points with
+      /// an invalid state are written last, in their original order. The chunk statistics of the
+      /// points are saved (see CompressedVectorWriterOptions::chunkStatistics), so a reader can
+      /// find the records inside a box with CompressedVectorReader::matchingRecordRanges() and
+      /// only read the packets near them. The curve & the box it was fitted to are recorded in
+      /// the scan, in an extension. Scans written with SetUpData3DPointsData() aren't reordered.
+      PointOrder pointOrder = PointOrderAcquisition;
+
+      /// Build a level-of-detail octree of the scans written by WriteData3DData(), with at most
+      /// this many points in each of its nodes (0, the default, doesn't build one). Each node
+      /// holds an even sample of the points in its cell which aren't in one of its ancestors, so
+      /// reading the nodes of the first levels gives a coarse view of the scan, which the
+      /// deeper levels refine. The points are written node by node, the coarse levels first,
+      /// and the nodes are saved in the scan, in an extension (see
+      /// Reader::ReadData3DLODNodes()). Readers which don't know the extension still see an
+      /// ordinary scan with all its points. This replaces pointOrder; the points of each node
+      /// are in Morton order. Scans written with SetUpData3DPointsData() don't get an octree.
+      uint32_t lodNodePointCount = 0;
+
+      /// Store the cartesian coordinates & ranges of the scans written by WriteData3DData() as
+      /// ScaledIntegers with this precision (e.g. 0.0001 for 0.1 mm) instead of floats, unless
+      /// their pointRangeNodeType is already ScaledInteger. The range of the integers is the one
+      /// of the points, so each value takes only as many bits as its range at that precision
+      /// needs (e.g. 21 bits for 200 m at 0.1 mm, instead of 64 for a double). The values are
+      /// rounded to the nearest multiple of the precision. 0 (the default) keeps the node type
+      /// of the Data3D header. The header is updated with the scale & limits used.
+      double pointPrecision = 0.0;
+
+      /// Store the spherical angles of the scans written by WriteData3DData() as ScaledIntegers
+      /// with this precision in radians, in the same way as pointPrecision.
+      double anglePrecision = 0.0;
+
+      /// Add to an existing file instead of creating a new one. Its scans & images are kept where
+      /// they are in the file and the new ones are written after them, so the time taken doesn't
+      /// depend on the size of the file. The guid & coordinateMetadata of the file are kept (the
+      /// options for them are ignored). See the append mode of ImageFile::ImageFile().
+      bool append = false;
+   };
+
+   /// Options to Writer::MergeFrom()
+   struct E57_DLL MergeOptions
+   {
+      /// Number of threads opening the input files & reading their binary sections ahead of the
+      /// copy, which is written by the calling thread. 0 means std::thread::hardware_concurrency().
+      unsigned threadCount = 0;
+
+      /// Most bytes read ahead from the input files which haven't been written yet
+      uint64_t readAheadBytes = 256 * 1024 * 1024;
+
+      /// Give every scan & image a new guid. Otherwise only those whose guid is already used in
+      /// the file (e.g. by a scan of another input) get one.
+      bool newGuids = false;
+   };
+
+   /// What Writer::MergeFrom() copied
+   struct E57_DLL MergeReport
+   {
+      /// Number of scans copied
+      int64_t data3DCount = 0;
+
+      /// Number of images copied
+      int64_t images2DCount = 0;
+
+      /// Total length of the binary sections (points & images) copied
+      uint64_t bytesCopied = 0;
    };
 
    /// @brief Used for writing an E57 file using the E57 Simple API.
@@ -61,6 +150,14 @@ namespace e57
       /// @param [in] options Options to be used for the file
       Writer( const ustring &filePath, const WriterOptions &options );
 
+      /// @brief Writer constructor for an E57 file written to a WriteSink
+      /// @details Use this to write a file into memory (see MemoryWriteSink) or straight into
+      /// object storage instead of to a local file. WriterOptions::append and fileCache don't
+      /// apply.
+      /// @param [in] sink Where the file is written
+      /// @param [in] options Options to be used for the file
+      Writer( std::shared_ptr<WriteSink> sink, const WriterOptions &options );
+
       /// @brief Writer constructor (deprecated)
       /// @param [in] filePath Path to E57 file
       /// @param [in] coordinateMetadata Information describing the Coordinate Reference System to
@@ -77,6 +174,11 @@ namespace e57
       /// @brief Closes the file
       bool Close();
 
+      /// @brief Closes the file on one of the library's background I/O threads
+      /// @details The future holds the result of Close(), or the exception it threw. Don't use the
+      /// Writer until it is ready.
+      std::future<bool> CloseAsync();
+
       /// @name Image2D
       ///@{
 
@@ -149,6 +251,17 @@ namespace e57
       CompressedVectorWriter SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
                                                     const Data3DPointsDouble &buffers );
 
+      /// @brief Sets up a writer to write the scan data from interleaved points (see
+      /// Data3DPointsInterleaved)
+      /// @details @a buffers must have a field for each field of the scan's prototype (from the
+      /// pointFields of the Data3D header). Its other fields are ignored.
+      /// @param [in] dataIndex index returned by NewData3D
+      /// @param [in] pointCount Number of points in the buffer
+      /// @param [in] buffers the fields of the points & their layout
+      /// @return returns a vector writer setup to write the selected scan data
+      CompressedVectorWriter SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
+                                                    const Data3DPointsInterleaved &buffers );
+
       /// @brief Writes out the group data
       /// @param [in] dataIndex data block index given by the NewData3D
       /// @param [in] groupCount size of each of the buffers given
@@ -162,6 +275,31 @@ namespace e57
 
       ///@}
 
+      /// @name Merging
+      ///@{
+
+      /// @brief Copies all the scans (Data3D) & images (Image2D) of other E57 files into this one
+      /// @details The binary sections of the points & images are copied as they are, without
+      /// decoding & re-encoding them, so the copy runs at the speed of the disks. The input files
+      /// are opened & read ahead by a pool of threads while the calling thread writes this file,
+      /// in the order of @a inputPaths. The scans & images are added, in order, after those
+      /// already written.
+      ///
+      /// A scan or image keeps its guid unless it is already used in this file (or
+      /// MergeOptions::newGuids is set). A scan given a new guid has its old one added to its
+      /// originalGuids, and the images of the same input which refer to it (through
+      /// associatedData3DGuid) are changed to match. The per-file fields of the inputs (e.g.
+      /// their guid & coordinateMetadata) are not copied, but the extensions their scans &
+      /// images use are.
+      /// @param [in] inputPaths Paths of the E57 files to copy from
+      /// @param [in] options How to read the input files and assign the guids
+      /// @return What was copied
+      /// @throw ::ErrorTooManyWriters if a writer of this file is open
+      MergeReport MergeFrom( const std::vector<ustring> &inputPaths,
+                             const MergeOptions &options = {} );
+
+      ///@}
+
       /// @name File information
       ///@{
 
@@ -0,0 +1,56 @@
+#pragma once
+// SPDX-License-Identifier: BSL-1.0
+
+/// @file E57Tracing.h Hooks for timeline profilers.
+
+#include "E57Export.h"
+
+namespace e57
+{
+   namespace Tracing
+   {
+      /// Called when a zone starts on the current thread. @a zoneName is a string literal, so its
+      /// address may be used as a key. The returned value is passed to the matching ZoneEnd.
+      using ZoneBegin = void *(*)( const char *zoneName, void *userData );
+
+      /// Called when the zone started by ZoneBegin ends, on the same thread.
+      using ZoneEnd = void (*)( void *zone, void *userData );
+
+      /// @brief Functions forwarding the library's tracing zones to a profiler (Tracy, Perfetto,
+      /// ITT, ...).
+      struct E57_DLL Callbacks
+      {
+         ZoneBegin begin = nullptr;
+         ZoneEnd end = nullptr;
+
+         /// Passed to both functions.
+         void *userData = nullptr;
+      };
+
+      /*!
+      @brief Check if the library was built with tracing zones.
+
+      @details
+      The zones are only compiled in with the E57_ENABLE_TRACING CMake option. Without it
+      setCallbacks() has no effect.
+
+      @returns True if the library calls the tracing callbacks.
+      */
+      E57_DLL bool available();
+
+      /*!
+      @brief Set the functions called at the start & end of each tracing zone.
+
+      @param [in] callbacks The functions to call. Defaults to none.
+
+      @details
+      The zones cover file reads & writes, packet reads, decoding, packet writes, XML parsing and
+      closing ImageFiles. They may be entered on any thread, so the callbacks must be thread safe.
+
+      This must not be called while the library is being used on other threads.
+
+      @throw No E57Exceptions.
+      */
+      E57_DLL void setCallbacks( const Callbacks &callbacks = {} );
+   }
+}
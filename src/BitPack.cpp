@@ -0,0 +1,672 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <cstring>
+
+#include "BitPack.h"
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define E57_BITPACK_X86 1
+#include <immintrin.h>
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+#define E57_BITPACK_TARGET
+#else
+#define E57_BITPACK_TARGET __attribute__( ( target( "avx2" ) ) )
+#endif
+#endif
+
+namespace
+{
+   using UnpackFunc = void ( * )( const char *, size_t, size_t, unsigned, int64_t, size_t,
+                                  int64_t * );
+   using ScaleFunc = void ( * )( const int64_t *, size_t, double, double, double * );
+   template <typename T> using RangeFunc = size_t ( * )( const T *, size_t, T, T );
+   template <typename T> using MinMaxFunc = void ( * )( const T *, size_t, T &, T & );
+   using PackFunc = size_t ( * )( const int64_t *, size_t, int64_t, unsigned, unsigned,
+                                  e57::BitPack::PackState &, char * );
+
+   inline uint64_t fieldMask( unsigned bitsPerField )
+   {
+      return ( bitsPerField >= 64 ) ? ~uint64_t( 0 ) : ( ( uint64_t( 1 ) << bitsPerField ) - 1 );
+   }
+
+   inline uint64_t load64( const char *p )
+   {
+      uint64_t value;
+      memcpy( &value, p, sizeof( value ) );
+      return value;
+   }
+
+   // Add as unsigned so values wrap the same way as the original per-record decoder.
+   inline int64_t addMinimum( int64_t minimum, uint64_t field )
+   {
+      return static_cast<int64_t>( static_cast<uint64_t>( minimum ) + field );
+   }
+
+   // Extract one field, reading only the bytes it covers.
+   inline uint64_t extractField( const char *in, size_t bit, unsigned bitsPerField )
+   {
+      const size_t byte = bit / 8;
+      const unsigned shift = static_cast<unsigned>( bit % 8 );
+      const unsigned byteCount = ( shift + bitsPerField + 7 ) / 8; // at most 9
+
+      uint64_t low = 0;
+
+      for ( unsigned i = 0; ( i < byteCount ) && ( i < 8 ); ++i )
+      {
+         low |= uint64_t( static_cast<uint8_t>( in[byte + i] ) ) << ( 8 * i );
+      }
+
+      uint64_t field = low >> shift;
+
+      // A 58-64 bit field can spill into a ninth byte (shift can't be 0 then).
+      if ( byteCount > 8 )
+      {
+         field |= uint64_t( static_cast<uint8_t>( in[byte + 8] ) ) << ( 64 - shift );
+      }
+
+      return field & fieldMask( bitsPerField );
+   }
+
+   // Number of the fields (from the first) which can be read with one 8-byte load each without
+   // going past readableBytes. Fields wider than 57 bits may need 9 bytes, so never count them.
+   size_t wordLoadCount( size_t readableBytes, size_t firstBit, unsigned bitsPerField,
+                         size_t count )
+   {
+      if ( ( bitsPerField > 57 ) || ( readableBytes < 8 ) )
+      {
+         return 0;
+      }
+
+      const size_t lastStartBit = ( readableBytes - 8 ) * 8 + 7;
+
+      if ( lastStartBit < firstBit )
+      {
+         return 0;
+      }
+
+      return std::min( count, ( lastStartBit - firstBit ) / bitsPerField + 1 );
+   }
+
+   void unpackScalar( const char *in, size_t readableBytes, size_t firstBit,
+                      unsigned bitsPerField, int64_t minimum, size_t count, int64_t *out )
+   {
+      const uint64_t mask = fieldMask( bitsPerField );
+      const size_t wordCount = wordLoadCount( readableBytes, firstBit, bitsPerField, count );
+
+      size_t bit = firstBit;
+      size_t i = 0;
+
+      for ( ; i < wordCount; ++i, bit += bitsPerField )
+      {
+         const uint64_t field = ( load64( in + bit / 8 ) >> ( bit % 8 ) ) & mask;
+
+         out[i] = addMinimum( minimum, field );
+      }
+
+      for ( ; i < count; ++i, bit += bitsPerField )
+      {
+         out[i] = addMinimum( minimum, extractField( in, bit, bitsPerField ) );
+      }
+   }
+
+   void scaleScalar( const int64_t *values, size_t count, double scale, double offset,
+                     double *out )
+   {
+      for ( size_t i = 0; i < count; ++i )
+      {
+         out[i] = static_cast<double>( values[i] ) * scale + offset;
+      }
+   }
+
+   // Written so that NaNs are never out of range, like the ordered vector compares
+   template <typename T>
+   size_t findOutOfRangeScalar( const T *values, size_t count, T minimum, T maximum )
+   {
+      for ( size_t i = 0; i < count; ++i )
+      {
+         if ( ( values[i] < minimum ) || ( values[i] > maximum ) )
+         {
+            return i;
+         }
+      }
+
+      return count;
+   }
+
+   // Written so that NaNs are skipped, like the vector min & max instructions do
+   template <typename T> void minMaxScalar( const T *values, size_t count, T &minimum, T &maximum )
+   {
+      for ( size_t i = 0; i < count; ++i )
+      {
+         minimum = ( values[i] < minimum ) ? values[i] : minimum;
+         maximum = ( values[i] > maximum ) ? values[i] : maximum;
+      }
+   }
+
+   // Bits are collected in a 64-bit word and written 8 bytes at a time whatever the output word
+   // size. The words of a little-endian bitstream don't depend on the word size, so this gives the
+   // same bytes as writing one output word at a time (on the little-endian hosts the library
+   // supports).
+   class BitWriter
+   {
+   public:
+      BitWriter( e57::BitPack::PackState &state, char *out ) :
+         word_( state.word ), bitsUsed_( state.bitsUsed ), begin_( out ), out_( out )
+      {
+      }
+
+      // Append the low @a width bits (1-64) of @a field (which must have no higher bits set)
+      inline void put( uint64_t field, unsigned width )
+      {
+         word_ |= field << bitsUsed_;
+
+         const unsigned total = bitsUsed_ + width;
+
+         if ( total < 64 )
+         {
+            bitsUsed_ = total;
+            return;
+         }
+
+         memcpy( out_, &word_, sizeof( word_ ) );
+         out_ += sizeof( word_ );
+
+         word_ = ( bitsUsed_ == 0 ) ? 0 : ( field >> ( 64 - bitsUsed_ ) );
+         bitsUsed_ = total - 64;
+      }
+
+      // Write the remaining whole words of @a wordBytes bytes, save the rest in @a state, and
+      // return the number of words written in total.
+      size_t finish( unsigned wordBytes, e57::BitPack::PackState &state )
+      {
+         const unsigned wordBits = wordBytes * 8;
+
+         while ( bitsUsed_ >= wordBits )
+         {
+            memcpy( out_, &word_, wordBytes );
+            out_ += wordBytes;
+
+            word_ = ( wordBits == 64 ) ? 0 : ( word_ >> wordBits );
+            bitsUsed_ -= wordBits;
+         }
+
+         state.word = word_;
+         state.bitsUsed = bitsUsed_;
+
+         return static_cast<size_t>( out_ - begin_ ) / wordBytes;
+      }
+
+   private:
+      uint64_t word_;
+      unsigned bitsUsed_;
+      char *const begin_;
+      char *out_;
+   };
+
+   size_t packScalar( const int64_t *values, size_t count, int64_t minimum,
+                      unsigned bitsPerField, unsigned wordBytes, e57::BitPack::PackState &state,
+                      char *out )
+   {
+      const uint64_t mask = fieldMask( bitsPerField );
+
+      BitWriter writer( state, out );
+
+      for ( size_t i = 0; i < count; ++i )
+      {
+         const uint64_t field =
+            ( static_cast<uint64_t>( values[i] ) - static_cast<uint64_t>( minimum ) ) & mask;
+
+         writer.put( field, bitsPerField );
+      }
+
+      return writer.finish( wordBytes, state );
+   }
+
+#if defined( E57_BITPACK_X86 )
+   E57_BITPACK_TARGET void unpackAvx2( const char *in, size_t readableBytes, size_t firstBit,
+                                       unsigned bitsPerField, int64_t minimum, size_t count,
+                                       int64_t *out )
+   {
+      const size_t wordCount = wordLoadCount( readableBytes, firstBit, bitsPerField, count );
+
+      const auto cBits = static_cast<long long>( bitsPerField );
+      const auto cFirst = static_cast<long long>( firstBit );
+
+      const __m256i vMask =
+         _mm256_set1_epi64x( static_cast<long long>( fieldMask( bitsPerField ) ) );
+      const __m256i vMinimum = _mm256_set1_epi64x( minimum );
+      const __m256i vStep = _mm256_set1_epi64x( 4 * cBits );
+      const __m256i vSeven = _mm256_set1_epi64x( 7 );
+
+      // Start bit of each of the four fields being decoded
+      __m256i vBit = _mm256_set_epi64x( cFirst + 3 * cBits, cFirst + 2 * cBits, cFirst + cBits,
+                                        cFirst );
+
+      size_t i = 0;
+
+      for ( ; i + 4 <= wordCount; i += 4 )
+      {
+         const __m256i vByte = _mm256_srli_epi64( vBit, 3 );
+         const __m256i vWord =
+            _mm256_i64gather_epi64( reinterpret_cast<const long long *>( in ), vByte, 1 );
+         const __m256i vField =
+            _mm256_and_si256( _mm256_srlv_epi64( vWord, _mm256_and_si256( vBit, vSeven ) ), vMask );
+
+         _mm256_storeu_si256( reinterpret_cast<__m256i *>( out + i ),
+                              _mm256_add_epi64( vField, vMinimum ) );
+
+         vBit = _mm256_add_epi64( vBit, vStep );
+      }
+
+      unpackScalar( in, readableBytes, firstBit + i * bitsPerField, bitsPerField, minimum,
+                    count - i, out + i );
+   }
+
+   E57_BITPACK_TARGET void scaleAvx2( const int64_t *values, size_t count, double scale,
+                                      double offset, double *out )
+   {
+      // Integers in [-2^51, 2^51) convert exactly by adding them to the bits of 2^52 + 2^51 and
+      // then subtracting that as a double. AVX2 has no int64 -> double conversion.
+      const __m256d vMagic = _mm256_set1_pd( 6755399441055744.0 );
+      const __m256i vMagicBits = _mm256_castpd_si256( vMagic );
+      const __m256d vScale = _mm256_set1_pd( scale );
+      const __m256d vOffset = _mm256_set1_pd( offset );
+
+      size_t i = 0;
+
+      for ( ; i + 4 <= count; i += 4 )
+      {
+         const __m256i vValue =
+            _mm256_loadu_si256( reinterpret_cast<const __m256i *>( values + i ) );
+         const __m256d vDouble =
+            _mm256_sub_pd( _mm256_castsi256_pd( _mm256_add_epi64( vValue, vMagicBits ) ), vMagic );
+
+         // Multiply then add (not fused) to match the scalar calculation exactly.
+         _mm256_storeu_pd( out + i, _mm256_add_pd( _mm256_mul_pd( vDouble, vScale ), vOffset ) );
+      }
+
+      scaleScalar( values + i, count - i, scale, offset, out + i );
+   }
+
+   E57_BITPACK_TARGET size_t findOutOfRangeAvx2( const int64_t *values, size_t count,
+                                                 int64_t minimum, int64_t maximum )
+   {
+      const __m256i vMinimum = _mm256_set1_epi64x( minimum );
+      const __m256i vMaximum = _mm256_set1_epi64x( maximum );
+
+      size_t i = 0;
+
+      for ( ; i + 4 <= count; i += 4 )
+      {
+         const __m256i vValue =
+            _mm256_loadu_si256( reinterpret_cast<const __m256i *>( values + i ) );
+         const __m256i vBad = _mm256_or_si256( _mm256_cmpgt_epi64( vMinimum, vValue ),
+                                               _mm256_cmpgt_epi64( vValue, vMaximum ) );
+
+         if ( !_mm256_testz_si256( vBad, vBad ) )
+         {
+            break;
+         }
+      }
+
+      return i + findOutOfRangeScalar( values + i, count - i, minimum, maximum );
+   }
+
+   E57_BITPACK_TARGET size_t findOutOfRangeAvx2( const double *values, size_t count,
+                                                 double minimum, double maximum )
+   {
+      const __m256d vMinimum = _mm256_set1_pd( minimum );
+      const __m256d vMaximum = _mm256_set1_pd( maximum );
+
+      size_t i = 0;
+
+      for ( ; i + 4 <= count; i += 4 )
+      {
+         const __m256d vValue = _mm256_loadu_pd( values + i );
+         const __m256d vBad = _mm256_or_pd( _mm256_cmp_pd( vValue, vMinimum, _CMP_LT_OQ ),
+                                            _mm256_cmp_pd( vValue, vMaximum, _CMP_GT_OQ ) );
+
+         if ( _mm256_movemask_pd( vBad ) != 0 )
+         {
+            break;
+         }
+      }
+
+      return i + findOutOfRangeScalar( values + i, count - i, minimum, maximum );
+   }
+
+   E57_BITPACK_TARGET size_t findOutOfRangeAvx2( const float *values, size_t count,
+                                                 float minimum, float maximum )
+   {
+      const __m256 vMinimum = _mm256_set1_ps( minimum );
+      const __m256 vMaximum = _mm256_set1_ps( maximum );
+
+      size_t i = 0;
+
+      for ( ; i + 8 <= count; i += 8 )
+      {
+         const __m256 vValue = _mm256_loadu_ps( values + i );
+         const __m256 vBad = _mm256_or_ps( _mm256_cmp_ps( vValue, vMinimum, _CMP_LT_OQ ),
+                                           _mm256_cmp_ps( vValue, vMaximum, _CMP_GT_OQ ) );
+
+         if ( _mm256_movemask_ps( vBad ) != 0 )
+         {
+            break;
+         }
+      }
+
+      return i + findOutOfRangeScalar( values + i, count - i, minimum, maximum );
+   }
+
+   E57_BITPACK_TARGET void minMaxAvx2( const int64_t *values, size_t count, int64_t &minimum,
+                                       int64_t &maximum )
+   {
+      if ( count < 4 )
+      {
+         minMaxScalar( values, count, minimum, maximum );
+         return;
+      }
+
+      __m256i vMinimum = _mm256_set1_epi64x( minimum );
+      __m256i vMaximum = _mm256_set1_epi64x( maximum );
+
+      size_t i = 0;
+
+      for ( ; i + 4 <= count; i += 4 )
+      {
+         const __m256i vValue =
+            _mm256_loadu_si256( reinterpret_cast<const __m256i *>( values + i ) );
+
+         vMinimum = _mm256_blendv_epi8( vMinimum, vValue, _mm256_cmpgt_epi64( vMinimum, vValue ) );
+         vMaximum = _mm256_blendv_epi8( vMaximum, vValue, _mm256_cmpgt_epi64( vValue, vMaximum ) );
+      }
+
+      alignas( 32 ) int64_t lanes[8];
+      _mm256_store_si256( reinterpret_cast<__m256i *>( lanes ), vMinimum );
+      _mm256_store_si256( reinterpret_cast<__m256i *>( lanes + 4 ), vMaximum );
+
+      minMaxScalar( lanes, 4, minimum, maximum );
+      minMaxScalar( lanes + 4, 4, minimum, maximum );
+      minMaxScalar( values + i, count - i, minimum, maximum );
+   }
+
+   E57_BITPACK_TARGET void minMaxAvx2( const double *values, size_t count, double &minimum,
+                                       double &maximum )
+   {
+      __m256d vMinimum = _mm256_set1_pd( minimum );
+      __m256d vMaximum = _mm256_set1_pd( maximum );
+
+      size_t i = 0;
+
+      // The second operand is returned if either is a NaN, so NaN values are skipped
+      for ( ; i + 4 <= count; i += 4 )
+      {
+         const __m256d vValue = _mm256_loadu_pd( values + i );
+
+         vMinimum = _mm256_min_pd( vValue, vMinimum );
+         vMaximum = _mm256_max_pd( vValue, vMaximum );
+      }
+
+      alignas( 32 ) double lanes[8];
+      _mm256_store_pd( lanes, vMinimum );
+      _mm256_store_pd( lanes + 4, vMaximum );
+
+      minMaxScalar( lanes, 4, minimum, maximum );
+      minMaxScalar( lanes + 4, 4, minimum, maximum );
+      minMaxScalar( values + i, count - i, minimum, maximum );
+   }
+
+   E57_BITPACK_TARGET void minMaxAvx2( const float *values, size_t count, float &minimum,
+                                       float &maximum )
+   {
+      __m256 vMinimum = _mm256_set1_ps( minimum );
+      __m256 vMaximum = _mm256_set1_ps( maximum );
+
+      size_t i = 0;
+
+      for ( ; i + 8 <= count; i += 8 )
+      {
+         const __m256 vValue = _mm256_loadu_ps( values + i );
+
+         vMinimum = _mm256_min_ps( vValue, vMinimum );
+         vMaximum = _mm256_max_ps( vValue, vMaximum );
+      }
+
+      alignas( 32 ) float lanes[16];
+      _mm256_store_ps( lanes, vMinimum );
+      _mm256_store_ps( lanes + 8, vMaximum );
+
+      minMaxScalar( lanes, 8, minimum, maximum );
+      minMaxScalar( lanes + 8, 8, minimum, maximum );
+      minMaxScalar( values + i, count - i, minimum, maximum );
+   }
+
+   E57_BITPACK_TARGET size_t packAvx2( const int64_t *values, size_t count, int64_t minimum,
+                                       unsigned bitsPerField, unsigned wordBytes,
+                                       e57::BitPack::PackState &state, char *out )
+   {
+      const __m256i vMinimum = _mm256_set1_epi64x( minimum );
+      const __m256i vMask =
+         _mm256_set1_epi64x( static_cast<long long>( fieldMask( bitsPerField ) ) );
+      const __m128i vShift = _mm_cvtsi32_si128( static_cast<int>( bitsPerField ) );
+      const __m128i vShift2 = _mm_cvtsi32_si128( static_cast<int>( 2 * bitsPerField ) );
+
+      BitWriter writer( state, out );
+
+      size_t i = 0;
+
+      // Four fields at a time: subtract the minimum & mask in vector registers, then merge
+      // neighbouring fields into wider ones so there are fewer to append to the bitstream.
+      for ( ; i + 4 <= count; i += 4 )
+      {
+         const __m256i vValue =
+            _mm256_loadu_si256( reinterpret_cast<const __m256i *>( values + i ) );
+         const __m256i vField = _mm256_and_si256( _mm256_sub_epi64( vValue, vMinimum ), vMask );
+
+         if ( 2 * bitsPerField > 64 )
+         {
+            alignas( 32 ) uint64_t fields[4];
+
+            _mm256_store_si256( reinterpret_cast<__m256i *>( fields ), vField );
+
+            writer.put( fields[0], bitsPerField );
+            writer.put( fields[1], bitsPerField );
+            writer.put( fields[2], bitsPerField );
+            writer.put( fields[3], bitsPerField );
+            continue;
+         }
+
+         // field[0] | field[1] << bits, field[2] | field[3] << bits in 64-bit lanes 0 & 2
+         const __m256i vPair = _mm256_or_si256(
+            vField, _mm256_sll_epi64( _mm256_srli_si256( vField, 8 ), vShift ) );
+
+         const __m128i vLow = _mm256_castsi256_si128( vPair );
+         const __m128i vHigh = _mm256_extracti128_si256( vPair, 1 );
+
+         if ( 4 * bitsPerField > 64 )
+         {
+            writer.put( static_cast<uint64_t>( _mm_cvtsi128_si64( vLow ) ), 2 * bitsPerField );
+            writer.put( static_cast<uint64_t>( _mm_cvtsi128_si64( vHigh ) ), 2 * bitsPerField );
+            continue;
+         }
+
+         const __m128i vQuad = _mm_or_si128( vLow, _mm_sll_epi64( vHigh, vShift2 ) );
+
+         writer.put( static_cast<uint64_t>( _mm_cvtsi128_si64( vQuad ) ), 4 * bitsPerField );
+      }
+
+      const uint64_t mask = fieldMask( bitsPerField );
+
+      for ( ; i < count; ++i )
+      {
+         const uint64_t field =
+            ( static_cast<uint64_t>( values[i] ) - static_cast<uint64_t>( minimum ) ) & mask;
+
+         writer.put( field, bitsPerField );
+      }
+
+      return writer.finish( wordBytes, state );
+   }
+
+   bool detectSimd()
+   {
+#if defined( _MSC_VER ) && !defined( __clang__ )
+      int info[4];
+      __cpuid( info, 0 );
+
+      if ( info[0] < 7 )
+      {
+         return false;
+      }
+
+      __cpuid( info, 1 );
+
+      // CPUID.01H:ECX.OSXSAVE[bit 27] & AVX[bit 28]
+      const int cOsxsaveAvx = ( 1 << 27 ) | ( 1 << 28 );
+
+      if ( ( info[2] & cOsxsaveAvx ) != cOsxsaveAvx )
+      {
+         return false;
+      }
+
+      // The OS must save the YMM registers
+      if ( ( _xgetbv( 0 ) & 0x6 ) != 0x6 )
+      {
+         return false;
+      }
+
+      __cpuidex( info, 7, 0 );
+
+      // CPUID.07H:EBX.AVX2[bit 5]
+      return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+      return __builtin_cpu_supports( "avx2" ) != 0;
+#endif
+   }
+#endif
+
+   struct Implementation
+   {
+      bool simd;
+      UnpackFunc unpack;
+      ScaleFunc scale;
+      RangeFunc<int64_t> findOutOfRange;
+      PackFunc pack;
+      MinMaxFunc<int64_t> minMaxInteger;
+      MinMaxFunc<double> minMaxDouble;
+      MinMaxFunc<float> minMaxFloat;
+      RangeFunc<double> findOutOfRangeDouble;
+      RangeFunc<float> findOutOfRangeFloat;
+   };
+
+   const Implementation &implementation()
+   {
+      static const Implementation sImpl = []() -> Implementation {
+#if defined( E57_BITPACK_X86 )
+         if ( detectSimd() )
+         {
+            return { true,       unpackAvx2, scaleAvx2,  findOutOfRangeAvx2, packAvx2,
+                     minMaxAvx2, minMaxAvx2, minMaxAvx2, findOutOfRangeAvx2, findOutOfRangeAvx2 };
+         }
+#endif
+         return { false,
+                  unpackScalar,
+                  scaleScalar,
+                  findOutOfRangeScalar<int64_t>,
+                  packScalar,
+                  minMaxScalar<int64_t>,
+                  minMaxScalar<double>,
+                  minMaxScalar<float>,
+                  findOutOfRangeScalar<double>,
+                  findOutOfRangeScalar<float> };
+      }();
+
+      return sImpl;
+   }
+}
+
+namespace e57
+{
+   namespace BitPack
+   {
+      bool simdSupported()
+      {
+         return implementation().simd;
+      }
+
+      void unpack( const char *in, size_t readableBytes, size_t firstBit, unsigned bitsPerField,
+                   int64_t minimum, size_t count, int64_t *out )
+      {
+         implementation().unpack( in, readableBytes, firstBit, bitsPerField, minimum, count, out );
+      }
+
+      void unpackSoftware( const char *in, size_t readableBytes, size_t firstBit,
+                           unsigned bitsPerField, int64_t minimum, size_t count, int64_t *out )
+      {
+         unpackScalar( in, readableBytes, firstBit, bitsPerField, minimum, count, out );
+      }
+
+      void scale( const int64_t *values, size_t count, double scale, double offset, double *out )
+      {
+         implementation().scale( values, count, scale, offset, out );
+      }
+
+      size_t findOutOfRange( const int64_t *values, size_t count, int64_t minimum,
+                             int64_t maximum )
+      {
+         return implementation().findOutOfRange( values, count, minimum, maximum );
+      }
+
+      size_t findOutOfRange( const double *values, size_t count, double minimum, double maximum )
+      {
+         return implementation().findOutOfRangeDouble( values, count, minimum, maximum );
+      }
+
+      size_t findOutOfRange( const float *values, size_t count, float minimum, float maximum )
+      {
+         return implementation().findOutOfRangeFloat( values, count, minimum, maximum );
+      }
+
+      size_t findOutOfRangeSoftware( const double *values, size_t count, double minimum,
+                                     double maximum )
+      {
+         return findOutOfRangeScalar( values, count, minimum, maximum );
+      }
+
+      void minMax( const int64_t *values, size_t count, int64_t &minimum, int64_t &maximum )
+      {
+         implementation().minMaxInteger( values, count, minimum, maximum );
+      }
+
+      void minMax( const double *values, size_t count, double &minimum, double &maximum )
+      {
+         implementation().minMaxDouble( values, count, minimum, maximum );
+      }
+
+      void minMax( const float *values, size_t count, float &minimum, float &maximum )
+      {
+         implementation().minMaxFloat( values, count, minimum, maximum );
+      }
+
+      void minMaxSoftware( const double *values, size_t count, double &minimum, double &maximum )
+      {
+         minMaxScalar( values, count, minimum, maximum );
+      }
+
+      size_t pack( const int64_t *values, size_t count, int64_t minimum, unsigned bitsPerField,
+                   unsigned wordBytes, PackState &state, char *out )
+      {
+         return implementation().pack( values, count, minimum, bitsPerField, wordBytes, state,
+                                       out );
+      }
+
+      size_t packSoftware( const int64_t *values, size_t count, int64_t minimum,
+                           unsigned bitsPerField, unsigned wordBytes, PackState &state,
+                           char *out )
+      {
+         return packScalar( values, count, minimum, bitsPerField, wordBytes, state, out );
+      }
+   }
+}
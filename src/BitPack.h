@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "Common.h"
+
+namespace e57
+{
+   /// Block kernels for the bit-packed integer fields of compressed vectors, and the statistics of
+   /// their values.
+   ///
+   /// Fields are packed starting at the least significant bit of a little-endian stream, as in the
+   /// E57 bytestreams. When the CPU supports it (AVX2 on x86-64, detected at runtime) these use
+   /// vector instructions. Otherwise they fall back to portable scalar loops.
+   namespace BitPack
+   {
+      /// Bits which have been packed but don't fill a whole output word yet
+      struct PackState
+      {
+         uint64_t word = 0;
+         unsigned bitsUsed = 0;
+      };
+
+      /// Returns true if a vector implementation is available and will be used.
+      bool simdSupported();
+
+      /// Unpack @a count fields of @a bitsPerField bits (1-64) starting @a firstBit bits into
+      /// @a in, add @a minimum to each, and store them in @a out.
+      ///
+      /// Only the first @a readableBytes bytes of @a in are read. They must hold all the fields.
+      void unpack( const char *in, size_t readableBytes, size_t firstBit, unsigned bitsPerField,
+                   int64_t minimum, size_t count, int64_t *out );
+
+      /// Same as unpack(), always using the scalar implementation.
+      void unpackSoftware( const char *in, size_t readableBytes, size_t firstBit,
+                           unsigned bitsPerField, int64_t minimum, size_t count, int64_t *out );
+
+      /// Calculate @a values[i] * @a scale + @a offset for @a count values and store them in
+      /// @a out. The results are identical to doing this one value at a time.
+      ///
+      /// All the values must be in [-2^51, 2^51).
+      void scale( const int64_t *values, size_t count, double scale, double offset,
+                  double *out );
+
+      /// Returns the index of the first of @a count values outside [@a minimum, @a maximum], or
+      /// @a count if they are all in range. NaNs are never out of range.
+      size_t findOutOfRange( const int64_t *values, size_t count, int64_t minimum,
+                             int64_t maximum );
+      size_t findOutOfRange( const double *values, size_t count, double minimum, double maximum );
+      size_t findOutOfRange( const float *values, size_t count, float minimum, float maximum );
+
+      /// Same as findOutOfRange(), always using the scalar implementation.
+      size_t findOutOfRangeSoftware( const double *values, size_t count, double minimum,
+                                     double maximum );
+
+      /// Lower @a minimum and raise @a maximum to include @a count values. NaNs are skipped.
+      void minMax( const int64_t *values, size_t count, int64_t &minimum, int64_t &maximum );
+      void minMax( const double *values, size_t count, double &minimum, double &maximum );
+      void minMax( const float *values, size_t count, float &minimum, float &maximum );
+
+      /// Same as minMax(), always using the scalar implementation.
+      void minMaxSoftware( const double *values, size_t count, double &minimum, double &maximum );
+
+      /// Subtract @a minimum from @a count values, pack the low @a bitsPerField bits (1-64) of
+      /// each after the bits already in @a state, and write all the completed words of
+      /// @a wordBytes bytes (1, 2, 4, or 8) to @a out. Returns the number of words written.
+      ///
+      /// Afterwards @a state holds the bits (fewer than a word) which didn't fill a word.
+      /// @a bitsPerField must not be more than the bits in a word.
+      size_t pack( const int64_t *values, size_t count, int64_t minimum, unsigned bitsPerField,
+                   unsigned wordBytes, PackState &state, char *out );
+
+      /// Same as pack(), always using the scalar implementation.
+      size_t packSoftware( const int64_t *values, size_t count, int64_t minimum,
+                           unsigned bitsPerField, unsigned wordBytes, PackState &state,
+                           char *out );
+   }
+}
@@ -30,6 +30,7 @@
 /// @file BlobNode.cpp
 
 #include "BlobNodeImpl.h"
+#include "Parallel.h"
 #include "StringFunctions.h"
 
 using namespace e57;
@@ -125,9 +126,11 @@ is an error to attempt to attach the BlobNode to a different ImageFile.
 @pre The @a destImageFile must have been opened in write mode (i.e. destImageFile.isWritable()
 must be true).
 @pre byteCount >= 0
+@pre There must be no open BlobWriter of @a destImageFile.
 
 @throw ::ErrorBadAPIArgument
 @throw ::ErrorImageFileNotOpen
+@throw ::ErrorTooManyWriters
 @throw ::ErrorFileReadOnly
 @throw ::ErrorInternal All objects in undocumented state
 
@@ -247,6 +250,91 @@ void BlobNode::read( uint8_t *buf, int64_t start, size_t count )
    impl_->read( buf, start, count );
 }
 
+/*!
+@brief Start reading a buffer of bytes from a Blob in the background.
+
+@param [out] buf A memory buffer to store bytes read.
+@param [in] start Index of first byte in Blob to read to buf.
+@param [in] count Number of bytes to read.
+
+@details
+Does the same as BlobNode::read() on one of the library's background I/O threads and returns
+straight away. @a buf must stay valid, and the ImageFile mustn't be used from other
+threads, until the read is done.
+
+@return A future which is ready once the bytes are read, or holds the exception that read() threw.
+
+@throw No E57Exceptions (they are passed on by the future).
+
+@see BlobNode::read, BlobNode::readAsync(uint8_t*,int64_t,size_t,AsyncCompletion)
+*/
+std::future<void> BlobNode::readAsync( uint8_t *buf, int64_t start, size_t count )
+{
+   BlobNode blob( *this );
+
+   return runAsync( [blob, buf, start, count]() mutable { blob.read( buf, start, count ); } );
+}
+
+/*!
+@brief Start reading a buffer of bytes from a Blob in the background, and call @a completion once
+it's done.
+
+@param [out] buf A memory buffer to store bytes read.
+@param [in] start Index of first byte in Blob to read to buf.
+@param [in] count Number of bytes to read.
+@param [in] completion Called on the thread which did the read with nullptr, or the exception that
+read() threw.
+
+@details
+The same as BlobNode::readAsync(uint8_t*,int64_t,size_t), but calls @a completion instead of
+returning a future.
+
+@throw ::ErrorBadAPIArgument If there's no @a completion.
+
+@see BlobNode::readAsync(uint8_t*,int64_t,size_t)
+*/
+void BlobNode::readAsync( uint8_t *buf, int64_t start, size_t count, AsyncCompletion completion )
+{
+   BlobNode blob( *this );
+
+   runAsync( [blob, buf, start, count]() mutable { blob.read( buf, start, count ); },
+             std::move( completion ) );
+}
+
+/*!
+@brief Get a read-only view of a range of bytes of a blob, avoiding a copy when possible.
+
+@param [in] start The index of the first byte in blob to view.
+@param [in] count The number of bytes to view.
+
+@details
+When the ImageFile is read through a memory mapping (see ::ReadBackendMemoryMapped) or from a
+memory buffer, the view is made of segments pointing at the bytes in each page of the file, so
+nothing is copied, and the checksum of each page is verified the first time its segment is
+accessed (following the ReadChecksumPolicy of the ImageFile). Otherwise the bytes are read (and
+their checksums verified) into a buffer owned by the view, which then has one segment.
+
+The view may be used while the ImageFile is open.
+
+@pre The destination ImageFile must be open (i.e. destImageFile().isOpen()).
+@pre 0 <= @a start
+@pre (@a start + @a count) <= byteCount()
+
+@return The view of the bytes.
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorReadFailed
+@throw ::ErrorBadChecksum
+@throw ::ErrorInternal All objects in undocumented state
+
+@see BlobNode::read, BlobView
+*/
+BlobView BlobNode::view( int64_t start, size_t count ) const
+{
+   return BlobView( impl_->view( start, count ) );
+}
+
 /*!
 @brief Write a buffer of bytes to a blob.
 
@@ -40,6 +40,13 @@ namespace e57
 
       ImageFileImplSharedPtr imf( destImageFile );
 
+      // The space is allocated at the end of the file, where an open BlobWriter adds its bytes
+      // (as do concurrent CompressedVectorWriters when they are closed)
+      if ( imf->isBlobWriterOpen() || ( imf->concurrentWriterCount() > 0 ) )
+      {
+         throw E57_EXCEPTION2( ErrorTooManyWriters, "fileName=" + imf->fileName() );
+      }
+
       // This what caller thinks blob length is
       blobLogicalLength_ = byteCount;
 
@@ -65,6 +72,8 @@ namespace e57
       // Write header at beginning of section
       imf->file_->seek( binarySectionLogicalStart_ );
       imf->file_->write( reinterpret_cast<char *>( &header ), sizeof( header ) );
+
+      memory_.set( Memory::Nodes, sizeof( *this ) );
    }
 
    BlobNodeImpl::BlobNodeImpl( ImageFileImplWeakPtr destImageFile, int64_t fileOffset,
@@ -80,6 +89,8 @@ namespace e57
       blobLogicalLength_ = length;
       binarySectionLogicalStart_ = imf->file_->physicalToLogical( fileOffset );
       binarySectionLogicalLength_ = sizeof( BlobSectionHeader ) + blobLogicalLength_;
+
+      memory_.set( Memory::Nodes, sizeof( *this ) );
    }
 
    bool BlobNodeImpl::isTypeEquivalent( NodeImplSharedPtr ni )
@@ -135,9 +146,28 @@ namespace e57
       }
 
       ImageFileImplSharedPtr imf( destImageFile_ );
-      imf->file_->seek( binarySectionLogicalStart_ + sizeof( BlobSectionHeader ) + start );
-      imf->file_->read( reinterpret_cast<char *>( buf ),
-                        static_cast<size_t>( count ) ); //??? arg1 void* ?
+      imf->finishPacketWrites();
+      imf->file_->readAt( binarySectionLogicalStart_ + sizeof( BlobSectionHeader ) + start,
+                          reinterpret_cast<char *>( buf ), count );
+   }
+
+   std::shared_ptr<BlobViewImpl> BlobNodeImpl::view( int64_t start, size_t count )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( ( start < 0 ) || ( static_cast<uint64_t>( start ) + count > blobLogicalLength_ ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "this->pathName=" + this->pathName() +
+                                  " start=" + toString( start ) + " count=" + toString( count ) +
+                                  " length=" + toString( blobLogicalLength_ ) );
+      }
+
+      ImageFileImplSharedPtr imf( destImageFile_ );
+      imf->finishPacketWrites();
+
+      return std::make_shared<BlobViewImpl>(
+         imf, binarySectionLogicalStart_ + sizeof( BlobSectionHeader ) + start, count );
    }
 
    void BlobNodeImpl::write( uint8_t *buf, int64_t start, size_t count )
@@ -165,6 +195,7 @@ namespace e57
       }
 
       ImageFileImplSharedPtr imf( destImageFile_ );
+      imf->finishPacketWrites();
       imf->file_->seek( binarySectionLogicalStart_ + sizeof( BlobSectionHeader ) + start );
       imf->file_->write( reinterpret_cast<char *>( buf ),
                          static_cast<size_t>( count ) ); //??? arg1 void* ?
@@ -228,4 +259,90 @@ namespace e57
    }
 #endif
 
+
+   BlobViewImpl::BlobViewImpl( ImageFileImplSharedPtr imf, uint64_t logicalStart, size_t count ) :
+      imf_( imf ), byteCount_( count )
+   {
+      if ( count == 0 )
+      {
+         return;
+      }
+
+      CheckedFile *file = imf->file();
+
+      uint64_t page = logicalStart / CheckedFile::logicalPageSize;
+      auto pageOffset = static_cast<size_t>( logicalStart - page * CheckedFile::logicalPageSize );
+
+      // Point into the file's memory page by page
+      if ( file->pageInMemory( page ) != nullptr )
+      {
+         segments_.reserve( ( pageOffset + count + CheckedFile::logicalPageSize - 1 ) /
+                            CheckedFile::logicalPageSize );
+
+         while ( count > 0 )
+         {
+            const char *pageData = file->pageInMemory( page );
+
+            if ( pageData == nullptr )
+            {
+               throw E57_EXCEPTION2( ErrorReadFailed, "fileName=" + imf->fileName() +
+                                                         " page=" + toString( page ) );
+            }
+
+            const size_t cSize = std::min( count, CheckedFile::logicalPageSize - pageOffset );
+
+            segments_.push_back( { pageData + pageOffset, cSize, page, false } );
+
+            count -= cSize;
+            pageOffset = 0;
+            ++page;
+         }
+
+         return;
+      }
+
+      // Otherwise read the bytes, verifying the checksums as they are read
+      buffer_.resize( count );
+      file->readAt( logicalStart, buffer_.data(), count );
+
+      segments_.push_back( { buffer_.data(), count, 0, true } );
+   }
+
+   const uint8_t *BlobViewImpl::segmentData( size_t index )
+   {
+      checkIndex( index );
+
+      ImageFileImplSharedPtr imf( imf_.lock() );
+
+      if ( !imf || !imf->isOpen() )
+      {
+         throw E57_EXCEPTION2( ErrorImageFileNotOpen, "index=" + toString( index ) );
+      }
+
+      Segment &segment = segments_[index];
+
+      if ( !segment.verified )
+      {
+         imf->file()->verifyPageInMemory( segment.page, index == segments_.size() - 1 );
+         segment.verified = true;
+      }
+
+      return reinterpret_cast<const uint8_t *>( segment.data );
+   }
+
+   size_t BlobViewImpl::segmentSize( size_t index ) const
+   {
+      checkIndex( index );
+
+      return segments_[index].size;
+   }
+
+   void BlobViewImpl::checkIndex( size_t index ) const
+   {
+      if ( index >= segments_.size() )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "index=" + toString( index ) + " segmentCount=" +
+                                                       toString( segments_.size() ) );
+      }
+   }
 }
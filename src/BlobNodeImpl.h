@@ -58,9 +58,55 @@ namespace e57
       void dump( int indent = 0, std::ostream &os = std::cout ) const override;
 #endif
 
+      std::shared_ptr<BlobViewImpl> view( int64_t start, size_t count );
+
+      /// Logical offset of the blob's binary section in the file
+      uint64_t sectionLogicalStart() const
+      {
+         return binarySectionLogicalStart_;
+      }
+
    private:
       uint64_t blobLogicalLength_;
       uint64_t binarySectionLogicalStart_;
       uint64_t binarySectionLogicalLength_;
    };
+
+   class BlobViewImpl
+   {
+   public:
+      BlobViewImpl( ImageFileImplSharedPtr imf, uint64_t logicalStart, size_t count );
+
+      uint64_t byteCount() const
+      {
+         return byteCount_;
+      }
+
+      size_t segmentCount() const
+      {
+         return segments_.size();
+      }
+
+      const uint8_t *segmentData( size_t index );
+      size_t segmentSize( size_t index ) const;
+
+   private:
+      struct Segment
+      {
+         const char *data;
+         size_t size;
+         uint64_t page;  // physical page holding the segment when the file is in memory
+         bool verified;  // checksum verified, or the segment was read into buffer_
+      };
+
+      void checkIndex( size_t index ) const;
+
+      ImageFileImplWeakPtr imf_;
+      uint64_t byteCount_;
+
+      std::vector<Segment> segments_;
+
+      // The bytes, if the file isn't in memory
+      std::vector<char> buffer_;
+   };
 }
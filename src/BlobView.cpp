@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: BSL-1.0
+
+/// @file BlobView.cpp
+
+#include "BlobNodeImpl.h"
+#include "StringFunctions.h"
+
+using namespace e57;
+
+/*!
+@class e57::BlobView
+@brief A read-only view of a range of the bytes of a Blob, as returned by BlobNode::view().
+
+@details
+The bytes are in one or more segments of contiguous memory, in order. A default constructed view
+has no bytes.
+*/
+
+/*!
+@brief Get the number of bytes in the view.
+*/
+int64_t BlobView::byteCount() const
+{
+   return impl_ ? static_cast<int64_t>( impl_->byteCount() ) : 0;
+}
+
+/*!
+@brief Get the number of segments the bytes of the view are in.
+*/
+size_t BlobView::segmentCount() const
+{
+   return impl_ ? impl_->segmentCount() : 0;
+}
+
+/*!
+@brief Get the bytes of a segment of the view.
+
+@param [in] index The index of the segment, less than segmentCount().
+
+@details
+The checksum of the page holding the segment is verified the first time its bytes are accessed,
+if they weren't read when the view was made.
+
+@pre The ImageFile of the blob must be open.
+
+@return The first of segmentSize( @a index ) bytes.
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorBadChecksum
+*/
+const uint8_t *BlobView::segmentData( size_t index ) const
+{
+   if ( !impl_ )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "index=" + toString( index ) );
+   }
+
+   return impl_->segmentData( index );
+}
+
+/*!
+@brief Get the number of bytes in a segment of the view.
+
+@param [in] index The index of the segment, less than segmentCount().
+
+@throw ::ErrorBadAPIArgument
+*/
+size_t BlobView::segmentSize( size_t index ) const
+{
+   if ( !impl_ )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "index=" + toString( index ) );
+   }
+
+   return impl_->segmentSize( index );
+}
+
+/// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+BlobView::BlobView( std::shared_ptr<BlobViewImpl> impl ) : impl_( std::move( impl ) )
+{
+}
+/// @endcond
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: BSL-1.0
+
+/// @file BlobWriter.cpp
+
+#include "BlobNodeImpl.h"
+#include "BlobWriterImpl.h"
+
+using namespace e57;
+
+/*!
+@class e57::BlobWriter
+@brief An object for writing the bytes of a new Blob as they are produced, without knowing their
+number in advance.
+
+@details
+The bytes are staged in a buffer owned by the writer and written to the end of the file a batch of
+whole pages at a time. They can be copied in with write(), or produced in place: buffer() gives
+the free part of the staging buffer and commit() adds the bytes put there.
+
+close() finishes the blob and returns its BlobNode, which can then be set in the tree like a
+BlobNode made with a byte count (e.g. as the jpegImage of an image representation). Nothing else
+can add data to the file while the writer is open, so it counts as one of the writers of the
+ImageFile (see ImageFile::writerCount()): no CompressedVectorWriter or BlobNode can be
+created until it is closed. If the writer is destroyed without being closed, the bytes written so
+far are left unused in the file.
+
+@see BlobNode, CompressedVectorWriter
+*/
+
+/*!
+@brief Create a writer of a new blob at the end of an ImageFile.
+
+@param [in] destImageFile The ImageFile to write the blob to.
+
+@pre The @a destImageFile must be open and writable.
+@pre There must be no open writers of @a destImageFile (i.e. destImageFile.writerCount() == 0).
+@post destImageFile.writerCount() is incremented.
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorFileReadOnly
+@throw ::ErrorTooManyWriters
+@throw ::ErrorWriteFailed
+@throw ::ErrorInternal All objects in undocumented state
+*/
+BlobWriter::BlobWriter( const ImageFile &destImageFile ) :
+   impl_( new BlobWriterImpl( destImageFile.impl() ) )
+{
+}
+
+/*!
+@brief Add bytes to the end of the blob.
+
+@param [in] buf The bytes to add.
+@param [in] count The number of bytes to add.
+
+@pre The writer must be open (i.e. isOpen()).
+
+@throw ::ErrorWriterNotOpen
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorWriteFailed
+*/
+void BlobWriter::write( const uint8_t *buf, size_t count )
+{
+   impl_->write( buf, count );
+}
+
+/*!
+@brief Get the free part of the staging buffer, to produce the next bytes of the blob in place.
+
+@param [out] capacity The number of bytes which can be put in the buffer, at least 1.
+
+@details
+Call commit() with the number of bytes put in the buffer. The buffer is only valid until the next
+call to a function of the writer.
+
+@pre The writer must be open (i.e. isOpen()).
+
+@return The start of the free part of the staging buffer.
+
+@throw ::ErrorWriterNotOpen
+@throw ::ErrorImageFileNotOpen
+
+@see BlobWriter::commit
+*/
+uint8_t *BlobWriter::buffer( size_t &capacity )
+{
+   return impl_->buffer( capacity );
+}
+
+/*!
+@brief Add the bytes put in the buffer returned by buffer() to the end of the blob.
+
+@param [in] count The number of bytes put in the buffer, at most the capacity returned.
+
+@pre The writer must be open (i.e. isOpen()).
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorWriterNotOpen
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorWriteFailed
+
+@see BlobWriter::buffer
+*/
+void BlobWriter::commit( size_t count )
+{
+   impl_->commit( count );
+}
+
+/*!
+@brief Get the number of bytes added to the blob so far.
+*/
+int64_t BlobWriter::byteCount() const
+{
+   return static_cast<int64_t>( impl_->byteCount() );
+}
+
+/*!
+@brief Test whether the writer is still open for writing.
+*/
+bool BlobWriter::isOpen() const
+{
+   return impl_->isOpen();
+}
+
+/*!
+@brief Get the ImageFile the blob is written to.
+*/
+ImageFile BlobWriter::destImageFile() const
+{
+   return ImageFile( impl_->destImageFile() );
+}
+
+/*!
+@brief Write the remaining bytes & finish the blob.
+
+@details
+The returned BlobNode isn't attached yet; set it in the tree to have it saved in the file.
+
+@pre The writer must be open (i.e. isOpen()).
+@post The writer is closed & destImageFile().writerCount() is decremented.
+
+@return The BlobNode of the bytes written, whose byteCount() is byteCount().
+
+@throw ::ErrorWriterNotOpen
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorWriteFailed
+@throw ::ErrorInternal All objects in undocumented state
+*/
+BlobNode BlobWriter::close()
+{
+   return BlobNode( impl_->close() );
+}
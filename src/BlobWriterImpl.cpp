@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <cstring>
+
+#include "BlobNodeImpl.h"
+#include "BlobWriterImpl.h"
+#include "CheckedFile.h"
+#include "ImageFileImpl.h"
+#include "SectionHeaders.h"
+#include "StringFunctions.h"
+
+namespace e57
+{
+   namespace
+   {
+      // Number of logical pages staged before they are written
+      constexpr size_t cStagingPageCount = 64;
+
+      // Number of staged bytes to write next, so the write ends on a page boundary
+      size_t stagingLimit( uint64_t logicalPosition )
+      {
+         const auto cPageOffset =
+            static_cast<size_t>( logicalPosition % CheckedFile::logicalPageSize );
+
+         return cStagingPageCount * CheckedFile::logicalPageSize - cPageOffset;
+      }
+   }
+
+   BlobWriterImpl::BlobWriterImpl( ImageFileImplSharedPtr imf ) : imf_( imf )
+   {
+      if ( !imf->isWriter() )
+      {
+         throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + imf->fileName() );
+      }
+
+      if ( imf->writerCount() > 0 )
+      {
+         throw E57_EXCEPTION2( ErrorTooManyWriters,
+                               "fileName=" + imf->fileName() +
+                                  " writerCount=" + toString( imf->writerCount() ) );
+      }
+
+      // The header is written with the length when closing
+      sectionLogicalStart_ = imf->allocateSpace( sizeof( BlobSectionHeader ), true );
+
+      staging_.resize( cStagingPageCount * CheckedFile::logicalPageSize );
+      stagingLimit_ = stagingLimit( sectionLogicalStart_ + sizeof( BlobSectionHeader ) );
+
+      imf->incrWriterCount();
+      imf->setBlobWriterOpen( true );
+   }
+
+   BlobWriterImpl::~BlobWriterImpl()
+   {
+      // The bytes written so far are left unused in the file
+      if ( isOpen_ )
+      {
+         try
+         {
+            finish();
+         }
+         catch ( ... )
+         {
+            //??? report?
+         }
+      }
+   }
+
+   void BlobWriterImpl::write( const uint8_t *buf, size_t count )
+   {
+      checkOpen( static_cast<const char *>( __FUNCTION__ ) );
+
+      while ( count > 0 )
+      {
+         const size_t cCopied = std::min( count, stagingLimit_ - stagedCount_ );
+
+         memcpy( staging_.data() + stagedCount_, buf, cCopied );
+
+         stagedCount_ += cCopied;
+         buf += cCopied;
+         count -= cCopied;
+
+         if ( stagedCount_ == stagingLimit_ )
+         {
+            flush();
+         }
+      }
+   }
+
+   uint8_t *BlobWriterImpl::buffer( size_t &capacity )
+   {
+      checkOpen( static_cast<const char *>( __FUNCTION__ ) );
+
+      capacity = stagingLimit_ - stagedCount_;
+
+      return staging_.data() + stagedCount_;
+   }
+
+   void BlobWriterImpl::commit( size_t count )
+   {
+      checkOpen( static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( count > stagingLimit_ - stagedCount_ )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "count=" + toString( count ) +
+                                  " capacity=" + toString( stagingLimit_ - stagedCount_ ) );
+      }
+
+      stagedCount_ += count;
+
+      if ( stagedCount_ == stagingLimit_ )
+      {
+         flush();
+      }
+   }
+
+   uint64_t BlobWriterImpl::byteCount() const
+   {
+      return flushedCount_ + stagedCount_;
+   }
+
+   bool BlobWriterImpl::isOpen() const
+   {
+      return isOpen_;
+   }
+
+   ImageFileImplSharedPtr BlobWriterImpl::destImageFile() const
+   {
+      return imf_.lock();
+   }
+
+   std::shared_ptr<BlobNodeImpl> BlobWriterImpl::close()
+   {
+      checkOpen( static_cast<const char *>( __FUNCTION__ ) );
+
+      flush();
+
+      ImageFileImplSharedPtr imf( imf_ );
+
+      // Pad the section so its length is a multiple of 4, as BlobNodeImpl does
+      BlobSectionHeader header;
+      header.sectionLogicalLength = sizeof( BlobSectionHeader ) + flushedCount_;
+
+      const auto cRemainder = static_cast<unsigned>( header.sectionLogicalLength % 4 );
+
+      if ( cRemainder > 0 )
+      {
+         imf->allocateSpace( 4 - cRemainder, true );
+         header.sectionLogicalLength += 4 - cRemainder;
+      }
+
+      imf->file()->seek( sectionLogicalStart_ );
+      imf->file()->write( reinterpret_cast<char *>( &header ), sizeof( header ) );
+
+      finish();
+
+      const auto cPhysicalStart =
+         static_cast<int64_t>( CheckedFile::logicalToPhysical( sectionLogicalStart_ ) );
+
+      return std::make_shared<BlobNodeImpl>( imf, cPhysicalStart,
+                                             static_cast<int64_t>( flushedCount_ ) );
+   }
+
+   void BlobWriterImpl::checkOpen( const char *srcFunctionName ) const
+   {
+      if ( !isOpen_ )
+      {
+         throw E57_EXCEPTION2( ErrorWriterNotOpen, std::string( "function=" ) + srcFunctionName );
+      }
+
+      ImageFileImplSharedPtr imf( imf_.lock() );
+
+      if ( !imf || !imf->isOpen() )
+      {
+         throw E57_EXCEPTION2( ErrorImageFileNotOpen, std::string( "function=" ) +
+                                                         srcFunctionName );
+      }
+   }
+
+   void BlobWriterImpl::flush()
+   {
+      if ( stagedCount_ == 0 )
+      {
+         return;
+      }
+
+      ImageFileImplSharedPtr imf( imf_ );
+
+      // Nothing else can allocate while this is open, so the space follows the bytes written
+      const uint64_t cLogicalStart = imf->allocateSpace( stagedCount_, false );
+
+      if ( cLogicalStart != sectionLogicalStart_ + sizeof( BlobSectionHeader ) + flushedCount_ )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "logicalStart=" + toString( cLogicalStart ) +
+                                                 " flushedCount=" + toString( flushedCount_ ) );
+      }
+
+      // The file computes the checksums of the whole pages in batches
+      imf->file()->seek( cLogicalStart );
+      imf->file()->write( reinterpret_cast<char *>( staging_.data() ), stagedCount_ );
+
+      flushedCount_ += stagedCount_;
+      stagedCount_ = 0;
+      stagingLimit_ = stagingLimit( sectionLogicalStart_ + sizeof( BlobSectionHeader ) +
+                                    flushedCount_ );
+   }
+
+   void BlobWriterImpl::finish()
+   {
+      isOpen_ = false;
+
+      ImageFileImplSharedPtr imf( imf_.lock() );
+
+      if ( imf )
+      {
+         imf->decrWriterCount();
+         imf->setBlobWriterOpen( false );
+      }
+   }
+}
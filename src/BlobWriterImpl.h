@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "Common.h"
+
+namespace e57
+{
+   class BlobNodeImpl;
+
+   /// Writes the bytes of a new blob at the end of the file as they are produced, so its length
+   /// doesn't have to be known up front. Nothing else may allocate space in the file while it is
+   /// open, so it counts as a writer of the ImageFile.
+   class BlobWriterImpl
+   {
+   public:
+      explicit BlobWriterImpl( ImageFileImplSharedPtr imf );
+      ~BlobWriterImpl();
+
+      BlobWriterImpl( const BlobWriterImpl & ) = delete;
+      BlobWriterImpl &operator=( const BlobWriterImpl & ) = delete;
+
+      void write( const uint8_t *buf, size_t count );
+      uint8_t *buffer( size_t &capacity );
+      void commit( size_t count );
+
+      uint64_t byteCount() const;
+      bool isOpen() const;
+      ImageFileImplSharedPtr destImageFile() const;
+
+      std::shared_ptr<BlobNodeImpl> close();
+
+   private:
+      void checkOpen( const char *srcFunctionName ) const;
+      void flush();
+      void finish();
+
+      ImageFileImplWeakPtr imf_;
+      bool isOpen_ = true;
+
+      uint64_t sectionLogicalStart_ = 0;
+      uint64_t flushedCount_ = 0; // bytes of the blob in the file
+
+      // Staged bytes. Each flush ends on a page boundary so pages are only written once.
+      std::vector<uint8_t> staging_;
+      size_t stagedCount_ = 0;
+      size_t stagingLimit_ = 0;
+   };
+}
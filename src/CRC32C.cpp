@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <cstring>
+
+#include "CRC.h"
+
+#include "CRC32C.h"
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define E57_CRC32C_X86 1
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+#include <nmmintrin.h>
+#define E57_CRC32C_TARGET
+#else
+#include <nmmintrin.h>
+#define E57_CRC32C_TARGET __attribute__( ( target( "sse4.2" ) ) )
+#endif
+#elif ( defined( __aarch64__ ) || defined( _M_ARM64 ) ) && defined( __ARM_FEATURE_CRC32 )
+#define E57_CRC32C_ARM 1
+#include <arm_acle.h>
+#define E57_CRC32C_TARGET
+#endif
+
+namespace
+{
+   using CalculateFunc = uint32_t ( * )( const char *, size_t );
+   using CalculateBlocksFunc = void ( * )( const char *, size_t, size_t, size_t, uint32_t * );
+
+   uint32_t calculateTable( const char *buf, size_t size )
+   {
+      static const CRC::Parameters<crcpp_uint32, 32> sCRCParams{ 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF,
+                                                                 true, true };
+
+      static const CRC::Table<crcpp_uint32, 32> sCRCTable = sCRCParams.MakeTable();
+
+      return CRC::Calculate<crcpp_uint32, 32>( buf, size, sCRCTable );
+   }
+
+   void calculateBlocksTable( const char *buf, size_t blockCount, size_t blockStride,
+                              size_t blockSize, uint32_t *results )
+   {
+      for ( size_t i = 0; i < blockCount; ++i )
+      {
+         results[i] = calculateTable( buf + i * blockStride, blockSize );
+      }
+   }
+
+#if defined( E57_CRC32C_X86 ) || defined( E57_CRC32C_ARM )
+   inline uint64_t load64( const char *p )
+   {
+      uint64_t value;
+      memcpy( &value, p, sizeof( value ) );
+      return value;
+   }
+
+#if defined( E57_CRC32C_X86 )
+   E57_CRC32C_TARGET inline uint32_t crcWord( uint32_t crc, uint64_t value )
+   {
+      return static_cast<uint32_t>( _mm_crc32_u64( crc, value ) );
+   }
+
+   E57_CRC32C_TARGET inline uint32_t crcByte( uint32_t crc, uint8_t value )
+   {
+      return _mm_crc32_u8( crc, value );
+   }
+#else
+   inline uint32_t crcWord( uint32_t crc, uint64_t value )
+   {
+      return __crc32cd( crc, value );
+   }
+
+   inline uint32_t crcByte( uint32_t crc, uint8_t value )
+   {
+      return __crc32cb( crc, value );
+   }
+#endif
+
+   E57_CRC32C_TARGET uint32_t calculateHardware( const char *buf, size_t size )
+   {
+      uint32_t crc = 0xFFFFFFFF;
+
+      for ( ; size >= sizeof( uint64_t ); size -= sizeof( uint64_t ), buf += sizeof( uint64_t ) )
+      {
+         crc = crcWord( crc, load64( buf ) );
+      }
+
+      for ( ; size > 0; --size, ++buf )
+      {
+         crc = crcByte( crc, static_cast<uint8_t>( *buf ) );
+      }
+
+      return ~crc;
+   }
+
+   // The crc32 instruction has a latency of ~3 cycles but a throughput of one per cycle, so run
+   // three independent blocks through it at once.
+   E57_CRC32C_TARGET void calculateBlocksHardware( const char *buf, size_t blockCount,
+                                                   size_t blockStride, size_t blockSize,
+                                                   uint32_t *results )
+   {
+      const size_t wordCount = blockSize / sizeof( uint64_t );
+      const size_t tailStart = wordCount * sizeof( uint64_t );
+
+      size_t i = 0;
+
+      for ( ; i + 3 <= blockCount; i += 3 )
+      {
+         const char *a = buf + i * blockStride;
+         const char *b = a + blockStride;
+         const char *c = b + blockStride;
+
+         uint32_t crcA = 0xFFFFFFFF;
+         uint32_t crcB = 0xFFFFFFFF;
+         uint32_t crcC = 0xFFFFFFFF;
+
+         for ( size_t offset = 0; offset < tailStart; offset += sizeof( uint64_t ) )
+         {
+            crcA = crcWord( crcA, load64( a + offset ) );
+            crcB = crcWord( crcB, load64( b + offset ) );
+            crcC = crcWord( crcC, load64( c + offset ) );
+         }
+
+         for ( size_t offset = tailStart; offset < blockSize; ++offset )
+         {
+            crcA = crcByte( crcA, static_cast<uint8_t>( a[offset] ) );
+            crcB = crcByte( crcB, static_cast<uint8_t>( b[offset] ) );
+            crcC = crcByte( crcC, static_cast<uint8_t>( c[offset] ) );
+         }
+
+         results[i] = ~crcA;
+         results[i + 1] = ~crcB;
+         results[i + 2] = ~crcC;
+      }
+
+      for ( ; i < blockCount; ++i )
+      {
+         results[i] = calculateHardware( buf + i * blockStride, blockSize );
+      }
+   }
+
+   bool detectHardware()
+   {
+#if defined( E57_CRC32C_X86 )
+#if defined( _MSC_VER ) && !defined( __clang__ )
+      int info[4];
+      __cpuid( info, 1 );
+
+      // CPUID.01H:ECX.SSE42[bit 20]
+      return ( info[2] & ( 1 << 20 ) ) != 0;
+#else
+      return __builtin_cpu_supports( "sse4.2" ) != 0;
+#endif
+#else
+      // The compiler was told the CRC extension is available.
+      return true;
+#endif
+   }
+#endif
+
+   struct Implementation
+   {
+      bool hardware;
+      CalculateFunc calculate;
+      CalculateBlocksFunc calculateBlocks;
+   };
+
+   const Implementation &implementation()
+   {
+      static const Implementation sImpl = []() -> Implementation {
+#if defined( E57_CRC32C_X86 ) || defined( E57_CRC32C_ARM )
+         if ( detectHardware() )
+         {
+            return { true, calculateHardware, calculateBlocksHardware };
+         }
+#endif
+         return { false, calculateTable, calculateBlocksTable };
+      }();
+
+      return sImpl;
+   }
+}
+
+namespace e57
+{
+   namespace CRC32C
+   {
+      bool hardwareSupported()
+      {
+         return implementation().hardware;
+      }
+
+      uint32_t calculate( const char *buf, size_t size )
+      {
+         return implementation().calculate( buf, size );
+      }
+
+      uint32_t calculateSoftware( const char *buf, size_t size )
+      {
+         return calculateTable( buf, size );
+      }
+
+      void calculateBlocks( const char *buf, size_t blockCount, size_t blockStride,
+                            size_t blockSize, uint32_t *results )
+      {
+         implementation().calculateBlocks( buf, blockCount, blockStride, blockSize, results );
+      }
+   }
+}
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "Common.h"
+
+namespace e57
+{
+   /// CRC32C (Castagnoli) calculation used to protect the pages of an E57 file.
+   ///
+   /// When the CPU supports it (SSE4.2 on x86-64, the CRC extension on ARMv8) this uses the
+   /// hardware crc32 instructions. This is detected at runtime on x86-64. Otherwise it falls back
+   /// to the table-driven CRCpp implementation.
+   ///
+   /// The values returned are the standard CRC32C (as in RFC 3720), not byte-swapped.
+   namespace CRC32C
+   {
+      /// Returns true if a hardware implementation is available and will be used.
+      bool hardwareSupported();
+
+      /// Calculate the CRC32C of @a size bytes of @a buf.
+      uint32_t calculate( const char *buf, size_t size );
+
+      /// Calculate the CRC32C of @a size bytes of @a buf using the table-driven implementation.
+      uint32_t calculateSoftware( const char *buf, size_t size );
+
+      /// Calculate the CRC32C of @a blockCount blocks of @a blockSize bytes, each starting
+      /// @a blockStride bytes after the previous one, and store them in @a results.
+      ///
+      /// With hardware support several blocks are processed in interleaved streams to hide the
+      /// latency of the crc32 instruction, so this is faster than calling calculate() per block.
+      void calculateBlocks( const char *buf, size_t blockCount, size_t blockStride,
+                            size_t blockSize, uint32_t *results );
+   }
+}
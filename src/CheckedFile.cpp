@@ -41,12 +41,20 @@
 #ifndef __LARGE64_FILES
 #define __LARGE64_FILES
 #endif
+#include <io.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #else
 #error "no supported compiler defined"
 #endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
 #elif defined( __linux__ ) || defined( __EMSCRIPTEN__ )
 #ifndef _LARGEFILE64_SOURCE
 #define _LARGEFILE64_SOURCE
@@ -54,13 +62,16 @@
 #ifndef __LARGE64_FILES
 #define __LARGE64_FILES
 #endif
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #elif defined( __APPLE__ )
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <unistd.h>
 #elif defined( __BSD )
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -68,15 +79,27 @@
 #error "no supported OS platform defined"
 #endif
 
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstring>
+#include <deque>
 #include <fcntl.h>
-
-#include "CRC.h"
-
+#include <functional>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CRC32C.h"
 #include "CheckedFile.h"
+#include "Memory.h"
+#include "Statistics.h"
 #include "StringFunctions.h"
+#include "Tracing.h"
 
 // #define E57_CHECK_FILE_DEBUG
 #ifdef E57_CHECK_FILE_DEBUG
@@ -102,20 +125,57 @@ namespace
    }
 
    /// Calc CRC32C of given data
-   uint32_t checksum( char *buf, size_t size )
+   uint32_t checksum( const char *buf, size_t size )
    {
-      static const CRC::Parameters<crcpp_uint32, 32> sCRCParams{ 0x1EDC6F41, 0xFFFFFFFF, 0xFFFFFFFF,
-                                                                 true, true };
-
-      static const CRC::Table<crcpp_uint32, 32> sCRCTable = sCRCParams.MakeTable();
-
-      auto crc = CRC::Calculate<crcpp_uint32, 32>( buf, size, sCRCTable );
+      auto crc = CRC32C::calculate( buf, size );
 
       // (Andy) I don't understand why we need to swap bytes here
       crc = swap_uint32( crc );
 
       return crc;
    }
+
+   /// Maximum number of physical pages CheckedFile::read() reads (and verifies) at once.
+   constexpr size_t cReadBatchPageCount = 64;
+
+   /// Maximum number of physical pages CheckedFile::write() & extend() checksum and write at once.
+   constexpr size_t cWriteBatchPageCount = 256;
+
+   /// Alignment of the offsets, lengths & buffers of direct I/O reads. This suits all common
+   /// block devices.
+   constexpr size_t cDirectAlignment = 4096;
+
+   /// Number of bytes written with FileCacheBypass before they are flushed & dropped from the cache
+   constexpr uint64_t cCacheDropWindow = 8 * 1024 * 1024;
+
+   /// Buffer for direct I/O, aligned to (at least) cDirectAlignment
+   class AlignedBuffer
+   {
+   public:
+      explicit AlignedBuffer( size_t size ) :
+         data_( static_cast<char *>(
+            Memory::allocateAligned( std::max( size, cDirectAlignment ) ) ) )
+      {
+         static_assert( cDirectAlignment <= Memory::cPageSize,
+                        "allocations of a page or more are page aligned" );
+      }
+
+      ~AlignedBuffer()
+      {
+         Memory::freeAligned( data_ );
+      }
+
+      AlignedBuffer( const AlignedBuffer & ) = delete;
+      AlignedBuffer &operator=( const AlignedBuffer & ) = delete;
+
+      char *data() const
+      {
+         return data_;
+      }
+
+   private:
+      char *data_ = nullptr;
+   };
 }
 
 /// Tool class to read buffer efficiently without multiplying copy operations.
@@ -159,14 +219,10 @@ public:
       return true;
    }
 
-   void read( char *buffer, uint64_t count )
+   /// Direct access to the buffer at @a offset, avoiding a copy.
+   const char *data( uint64_t offset ) const
    {
-      const uint64_t start = cursorStream_;
-      for ( uint64_t i = 0; i < count; ++i )
-      {
-         buffer[i] = stream_[start + i];
-         ++cursorStream_;
-      }
+      return stream_ + offset;
    }
 
 private:
@@ -175,12 +231,322 @@ private:
    const char *stream_;
 };
 
-CheckedFile::CheckedFile( const ustring &fileName, Mode mode, ReadChecksumPolicy policy ) :
+/// Reads a ReadSource through a cache of its most recently used blocks, so the many small reads
+/// of the pages of a file turn into a few large range reads. Reads of at least a block go straight
+/// to the source. It may be used from several threads at once.
+class e57::SourceReader
+{
+public:
+   explicit SourceReader( std::shared_ptr<ReadSource> source ) :
+      source_( std::move( source ) ), length_( source_->size() ),
+      blockSize_( source_->blockSize() ),
+      blockCount_( std::max<size_t>( source_->blockCount(), 1 ) )
+   {
+   }
+
+   uint64_t length() const
+   {
+      return length_;
+   }
+
+   ustring name() const
+   {
+      return source_->name();
+   }
+
+   /// Position used by the sequential reads (see CheckedFile::read()), with the same behaviour as
+   /// BufferView::seek().
+   uint64_t pos() const
+   {
+      return cursor_;
+   }
+
+   bool seek( uint64_t offset, int whence )
+   {
+      if ( whence == SEEK_CUR )
+      {
+         cursor_ += offset;
+      }
+      else if ( whence == SEEK_SET )
+      {
+         cursor_ = offset;
+      }
+      else if ( whence == SEEK_END )
+      {
+         cursor_ = length_ - offset;
+      }
+
+      if ( cursor_ > length_ )
+      {
+         cursor_ = length_;
+         return false;
+      }
+
+      return true;
+   }
+
+   void read( char *buf, uint64_t offset, size_t byteCount )
+   {
+      if ( ( blockSize_ == 0 ) || ( byteCount >= blockSize_ ) )
+      {
+         fetch( offset, buf, byteCount );
+         return;
+      }
+
+      while ( byteCount > 0 )
+      {
+         const uint64_t index = offset / blockSize_;
+         const auto blockOffset = static_cast<size_t>( offset - index * blockSize_ );
+
+         const BlockPtr data = block( index );
+
+         if ( blockOffset >= data->size() )
+         {
+            throw E57_EXCEPTION2( ErrorReadFailed,
+                                  "fileName=" + name() + " offset=" + toString( offset ) );
+         }
+
+         const size_t n = std::min( byteCount, data->size() - blockOffset );
+
+         memcpy( buf, data->data() + blockOffset, n );
+
+         buf += n;
+         offset += n;
+         byteCount -= n;
+      }
+   }
+
+private:
+   using BlockPtr = std::shared_ptr<const std::vector<char>>;
+
+   // Report the errors of the source as ours
+   void fetch( uint64_t offset, char *buf, size_t byteCount )
+   {
+      try
+      {
+         source_->readAt( offset, buf, byteCount );
+      }
+      catch ( E57Exception & )
+      {
+         throw;
+      }
+      catch ( std::exception &err )
+      {
+         throw E57_EXCEPTION2( ErrorReadFailed, "fileName=" + name() + " offset=" +
+                                                   toString( offset ) + " what=" + err.what() );
+      }
+   }
+
+   BlockPtr block( uint64_t index )
+   {
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+
+         for ( auto iter = blocks_.begin(); iter != blocks_.end(); ++iter )
+         {
+            if ( iter->first == index )
+            {
+               blocks_.splice( blocks_.begin(), blocks_, iter );
+               return blocks_.front().second;
+            }
+         }
+      }
+
+      // Fetch it without holding the lock so other threads can fetch blocks at the same time. If
+      // two of them want the same block, both fetch it.
+      const uint64_t start = index * blockSize_;
+      const auto size = static_cast<size_t>( std::min<uint64_t>( blockSize_, length_ - start ) );
+
+      auto data = std::make_shared<std::vector<char>>( size );
+
+      fetch( start, data->data(), size );
+
+      std::lock_guard<std::mutex> lock( mutex_ );
+
+      blocks_.emplace_front( index, data );
+
+      if ( blocks_.size() > blockCount_ )
+      {
+         blocks_.pop_back();
+      }
+
+      return data;
+   }
+
+   const std::shared_ptr<ReadSource> source_;
+   const uint64_t length_;
+   const size_t blockSize_;
+   const size_t blockCount_;
+
+   uint64_t cursor_ = 0;
+
+   // Most recently used first
+   std::mutex mutex_;
+   std::list<std::pair<uint64_t, BlockPtr>> blocks_;
+};
+
+/// Verifies the checksums of runs of pages on a background thread (see ChecksumVerification).
+/// Pages read from the file are copied, those of a file in memory are verified where they are.
+/// The first failure is kept, and reported by every call which reports errors from then on.
+class e57::ChecksumVerifier
+{
+public:
+   using VerifyFunction = std::function<void( const char *, uint64_t, size_t )>;
+
+   explicit ChecksumVerifier( VerifyFunction verify ) : verify_( std::move( verify ) )
+   {
+      thread_ = std::thread( &ChecksumVerifier::run, this );
+   }
+
+   ~ChecksumVerifier()
+   {
+      {
+         std::lock_guard<std::mutex> guard( mutex_ );
+         stop_ = true;
+      }
+
+      changed_.notify_all();
+      thread_.join();
+   }
+
+   ChecksumVerifier( const ChecksumVerifier & ) = delete;
+   ChecksumVerifier &operator=( const ChecksumVerifier & ) = delete;
+
+   /// Queue the @a pageCount physical pages at @a pages, starting with page @a firstPage. Unless
+   /// @a copy is set they must stay in memory until finish(). This waits while many pages are
+   /// queued, so the verification can't fall far behind.
+   void push( const char *pages, uint64_t firstPage, size_t pageCount, bool copy )
+   {
+      Job job;
+      job.firstPage = firstPage;
+      job.pageCount = pageCount;
+
+      if ( copy )
+      {
+         job.storage.assign( pages, pages + pageCount * CheckedFile::physicalPageSize );
+         pages = job.storage.data();
+      }
+
+      job.pages = pages;
+
+      {
+         std::unique_lock<std::mutex> guard( mutex_ );
+
+         changed_.wait( guard, [this] { return queuedPages_ < cMaxQueuedPages; } );
+
+         queuedPages_ += pageCount;
+         queued_.push_back( std::move( job ) );
+      }
+
+      changed_.notify_all();
+   }
+
+   /// Rethrow the first failure, if there has been one.
+   void rethrowError()
+   {
+      std::lock_guard<std::mutex> guard( mutex_ );
+
+      rethrowLockedError();
+   }
+
+   /// Wait for all the queued pages to be verified, then rethrowError().
+   void finish()
+   {
+      std::unique_lock<std::mutex> guard( mutex_ );
+
+      changed_.wait( guard, [this] { return queued_.empty() && !verifying_; } );
+
+      rethrowLockedError();
+   }
+
+private:
+   /// Most pages waiting to be verified (about 1 MB)
+   static constexpr size_t cMaxQueuedPages = 1024;
+
+   struct Job
+   {
+      const char *pages = nullptr;
+      uint64_t firstPage = 0;
+      size_t pageCount = 0;
+      std::vector<char> storage;
+   };
+
+   // Must be called with mutex_ locked.
+   void rethrowLockedError()
+   {
+      if ( error_ )
+      {
+         std::rethrow_exception( error_ );
+      }
+   }
+
+   void run()
+   {
+      std::unique_lock<std::mutex> guard( mutex_ );
+
+      while ( true )
+      {
+         changed_.wait( guard, [this] { return stop_ || !queued_.empty(); } );
+
+         if ( stop_ )
+         {
+            return;
+         }
+
+         Job job = std::move( queued_.front() );
+         queued_.pop_front();
+
+         verifying_ = true;
+
+         guard.unlock();
+
+         std::exception_ptr error;
+
+         try
+         {
+            verify_( job.pages, job.firstPage, job.pageCount );
+         }
+         catch ( ... )
+         {
+            error = std::current_exception();
+         }
+
+         guard.lock();
+
+         verifying_ = false;
+         queuedPages_ -= job.pageCount;
+
+         if ( error && !error_ )
+         {
+            error_ = error;
+         }
+
+         changed_.notify_all();
+      }
+   }
+
+   const VerifyFunction verify_;
+
+   std::mutex mutex_;
+   std::condition_variable changed_;
+   std::thread thread_;
+
+   std::deque<Job> queued_;
+   size_t queuedPages_ = 0;
+
+   bool verifying_ = false;
+   bool stop_ = false;
+   std::exception_ptr error_;
+};
+
+CheckedFile::CheckedFile( const ustring &fileName, Mode mode, ReadChecksumPolicy policy,
+                          FileCacheMode cacheMode ) :
    fileName_( fileName ), checkSumPolicy_( policy )
 {
    switch ( mode )
    {
       case Read:
+      case ReadMemoryMapped:
       {
 #if defined( _MSC_VER )
          constexpr int readFlags = O_RDONLY | O_BINARY;
@@ -189,6 +555,7 @@ CheckedFile::CheckedFile( const ustring &fileName, Mode mode, ReadChecksumPolicy
 #endif
 
          fd_ = open64( fileName_, readFlags, 0 );
+         openPositionalHandle( false );
 
          readOnly_ = true;
 
@@ -196,6 +563,17 @@ CheckedFile::CheckedFile( const ustring &fileName, Mode mode, ReadChecksumPolicy
          lseek64( 0, SEEK_SET );
 
          logicalLength_ = physicalToLogical( physicalLength_ );
+
+         setUpVerifiedPages();
+
+         if ( mode == ReadMemoryMapped )
+         {
+            mapFile();
+         }
+         else
+         {
+            setUpCacheMode( mode, cacheMode );
+         }
       }
       break;
 
@@ -212,6 +590,34 @@ CheckedFile::CheckedFile( const ustring &fileName, Mode mode, ReadChecksumPolicy
 #endif
 
          fd_ = open64( fileName_, writeFlags, writeMode );
+         openPositionalHandle( true );
+
+         setUpCacheMode( mode, cacheMode );
+      }
+      break;
+
+      case Append:
+      {
+         // Existing contents are kept, and may be read back
+
+#if defined( _MSC_VER )
+         constexpr int appendFlags = O_RDWR | O_BINARY;
+#else
+         constexpr int appendFlags = O_RDWR;
+#endif
+
+         fd_ = open64( fileName_, appendFlags, 0 );
+         openPositionalHandle( true );
+
+         physicalLength_ = lseek64( 0LL, SEEK_END );
+         lseek64( 0, SEEK_SET );
+
+         appendStart_ = physicalLength_;
+         logicalLength_ = physicalToLogical( physicalLength_ );
+         writtenLength_ = logicalLength_;
+
+         setUpVerifiedPages();
+         setUpCacheMode( mode, cacheMode );
       }
       break;
    }
@@ -228,6 +634,13 @@ CheckedFile::CheckedFile( const char *input, uint64_t size, ReadChecksumPolicy p
    lseek64( 0, SEEK_SET );
 
    logicalLength_ = physicalToLogical( physicalLength_ );
+
+   setUpVerifiedPages();
+}
+
+CheckedFile::CheckedFile( std::shared_ptr<WriteSink> sink ) :
+   fileName_( sink->name() ), sink_( std::move( sink ) )
+{
 }
 
 int CheckedFile::open64( const ustring &fileName, int flags, int mode )
@@ -270,136 +683,455 @@ int CheckedFile::open64( const ustring &fileName, int flags, int mode )
 #endif
 }
 
-CheckedFile::~CheckedFile()
+void CheckedFile::openPositionalHandle( bool writable )
 {
-   try
+#if defined( _WIN32 )
+   auto handle = reinterpret_cast<HANDLE>( ::_get_osfhandle( fd_ ) );
+
+   const DWORD access = writable ? ( GENERIC_READ | GENERIC_WRITE ) : GENERIC_READ;
+
+   // fd_ was opened with _SH_DENYNO, so share everything to be compatible with it
+   HANDLE positionalHandle = ::ReOpenFile(
+      handle, access, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0 );
+
+   if ( positionalHandle == INVALID_HANDLE_VALUE )
    {
-      close(); //??? what if already closed?
+      const auto error = static_cast<uint64_t>( ::GetLastError() );
+
+      ::_close( fd_ );
+      fd_ = -1;
+
+      throw E57_EXCEPTION2( ErrorOpenFailed, "fileName=" + fileName_ +
+                                                " GetLastError=" + toString( error ) );
    }
-   catch ( ... )
+
+   positionalHandle_ = positionalHandle;
+#else
+   E57_UNUSED( writable );
+#endif
+}
+
+void CheckedFile::closePositionalHandle()
+{
+#if defined( _WIN32 )
+   if ( positionalHandle_ != nullptr )
    {
-      //??? report?
+      ::CloseHandle( static_cast<HANDLE>( positionalHandle_ ) );
+      positionalHandle_ = nullptr;
    }
+#endif
 }
 
-void CheckedFile::read( char *buf, size_t nRead, size_t /*bufSize*/ )
+void CheckedFile::setUpCacheMode( Mode mode, FileCacheMode cacheMode )
 {
-   //??? what if read past logical end?, or physical end?
-   //??? need to keep track of logical length?
-   //??? check bufSize OK
+#if defined( __linux__ )
+   if ( cacheMode == FileCacheNormal )
+   {
+      if ( mode == Read )
+      {
+         // Lets the kernel read further ahead
+         ::posix_fadvise( fd_, 0, 0, POSIX_FADV_SEQUENTIAL );
+      }
 
-   const uint64_t end = position( Logical ) + nRead;
-   const uint64_t logicalLength = length( Logical );
+      return;
+   }
 
-   if ( end > logicalLength )
+   // Without direct I/O, pages are dropped from the cache after they are read or written
+   dropCache_ = true;
+
+   if ( mode != Read )
    {
-      throw E57_EXCEPTION2( ErrorInternal, "fileName=" + fileName_ + " end=" + toString( end ) +
-                                              " length=" + toString( logicalLength ) );
+      return;
    }
 
-   uint64_t page = 0;
-   size_t pageOffset = 0;
+   // Switch reads to direct I/O if the file system supports it. Check it accepts our alignment by
+   // reading the first block, which holds the file header.
+   const int flags = ::fcntl( fd_, F_GETFL );
+
+   if ( ( flags < 0 ) || ( ::fcntl( fd_, F_SETFL, flags | O_DIRECT ) < 0 ) )
+   {
+      return;
+   }
 
-   getCurrentPageAndOffset( page, pageOffset );
+   AlignedBuffer block( cDirectAlignment );
 
-   size_t n = std::min( nRead, logicalPageSize - pageOffset );
+   if ( ::pread64( fd_, block.data(), cDirectAlignment, 0 ) < 0 )
+   {
+      ::fcntl( fd_, F_SETFL, flags );
+      return;
+   }
 
-   // Allocate temp page buffer
-   std::vector<char> page_buffer_v( physicalPageSize );
-   char *page_buffer = page_buffer_v.data();
+   directIO_ = true;
+   dropCache_ = false;
+#elif defined( __APPLE__ )
+   (void)mode;
 
-   while ( nRead > 0 )
+   if ( cacheMode == FileCacheBypass )
    {
-      readPhysicalPage( page_buffer, page );
+      ::fcntl( fd_, F_NOCACHE, 1 );
+   }
+#else
+   (void)mode;
+   (void)cacheMode;
+#endif
+}
 
-      switch ( checkSumPolicy_ )
-      {
-         case ChecksumPolicy::ChecksumNone:
-            break;
+CheckedFile::CheckedFile( std::shared_ptr<ReadSource> source, ReadChecksumPolicy policy ) :
+   checkSumPolicy_( policy )
+{
+   if ( !source )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "source=nullptr" );
+   }
 
-         case ChecksumPolicy::ChecksumAll:
-            verifyChecksum( page_buffer, page );
-            break;
+   sourceReader_.reset( new SourceReader( std::move( source ) ) );
 
-         default:
+   fileName_ = sourceReader_->name();
+   readOnly_ = true;
+
+   physicalLength_ = sourceReader_->length();
+   logicalLength_ = physicalToLogical( physicalLength_ );
+
+   setUpVerifiedPages();
+}
+
+CheckedFile::~CheckedFile()
+{
+   try
+   {
+      // A sink which wasn't closed is abandoned, not finished
+      if ( sink_ )
+      {
+         const std::shared_ptr<WriteSink> sink( std::move( sink_ ) );
+
+         sink->discard();
+      }
+
+      close(); //??? what if already closed?
+   }
+   catch ( ... )
+   {
+      //??? report?
+   }
+}
+
+void CheckedFile::read( char *buf, size_t nRead, size_t /*bufSize*/ )
+{
+   //??? check bufSize OK
+
+   const uint64_t start = position( Logical );
+
+   readAt( start, buf, nRead );
+
+   // When done, leave cursor just past end of last byte read
+   seek( start + nRead, Logical );
+}
+
+void CheckedFile::readAt( uint64_t logicalOffset, char *buf, size_t nRead )
+{
+   E57_TRACE_ZONE( "CheckedFile::readAt" );
+
+   // Note that this must not use or change the file position so it may be called concurrently.
+
+   reportDeferredError();
+
+   const uint64_t end = logicalOffset + nRead;
+   const uint64_t logicalLength = length( Logical );
+
+   if ( end > logicalLength )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "fileName=" + fileName_ + " end=" + toString( end ) +
+                                              " length=" + toString( logicalLength ) );
+   }
+
+   // Reading back while writing (not concurrent), so the zeros from extend() must be in the file
+   if ( !readOnly_ )
+   {
+      writeZeros( end );
+   }
+
+   uint64_t page = logicalOffset / logicalPageSize;
+   size_t pageOffset = static_cast<size_t>( logicalOffset - page * logicalPageSize );
+
+   const bool inMemory = ( fd_ < 0 ) && ( bufView_ != nullptr );
+
+   // Total number of physical pages touched by this read
+   const uint64_t pageCount = ( pageOffset + nRead + logicalPageSize - 1 ) / logicalPageSize;
+
+   const auto maxBatchPages =
+      static_cast<size_t>( std::min<uint64_t>( pageCount, cReadBatchPageCount ) );
+
+   // Allocate temp buffer for a run of physical pages (not needed for in-memory input)
+   std::vector<char> batch_buffer_v( inMemory ? 0 : maxBatchPages * physicalPageSize );
+
+   while ( nRead > 0 )
+   {
+      const uint64_t pagesLeft = ( pageOffset + nRead + logicalPageSize - 1 ) / logicalPageSize;
+      const auto batchPages = static_cast<size_t>( std::min<uint64_t>( pagesLeft, maxBatchPages ) );
+
+      const char *batch_data = batch_buffer_v.data();
+
+      if ( inMemory )
+      {
+         // In-memory input (caller's buffer or mapped file), so use the pages in place rather than
+         // copying them into a buffer first.
+         if ( ( page + batchPages ) * physicalPageSize > physicalLength_ )
+         {
+            throw E57_EXCEPTION2( ErrorReadFailed, "fileName=" + fileName_ +
+                                                      " page=" + toString( page ) +
+                                                      " length=" + toString( physicalLength_ ) );
+         }
+
+         batch_data = bufView_->data( page * physicalPageSize );
+
+         counters_.pagesRead.fetch_add( batchPages, std::memory_order_relaxed );
+      }
+      else
+      {
+         readPhysicalPages( batch_buffer_v.data(), page, batchPages );
+      }
+
+      if ( checkSumPolicy_ != ChecksumPolicy::ChecksumNone )
+      {
+         ScopedTimer<std::atomic<uint64_t>> timer( counters_.checksumNanoseconds );
+
+         if ( checkSumPolicy_ == ChecksumPolicy::ChecksumAll )
+         {
+            verifyUnverifiedChecksums( batch_data, page, batchPages, inMemory );
+         }
+         else
          {
             const auto checksumMod =
                static_cast<unsigned int>( std::nearbyint( 100.0 / checkSumPolicy_ ) );
 
-            if ( !( page % checksumMod ) || ( nRead < physicalPageSize ) )
+            size_t remaining = nRead;
+            size_t offset = pageOffset;
+
+            for ( size_t i = 0; i < batchPages; ++i )
             {
-               verifyChecksum( page_buffer, page );
+               if ( ( !( ( page + i ) % checksumMod ) || ( remaining < physicalPageSize ) ) &&
+                    !pageVerified( page + i ) )
+               {
+                  verifyRun( batch_data + i * physicalPageSize, page + i, 1, inMemory );
+               }
+
+               remaining -= std::min( remaining, logicalPageSize - offset );
+               offset = 0;
             }
          }
+      }
+
+      // Strip the checksums, copying the logical part of each page to the caller's buffer
+      for ( size_t i = 0; i < batchPages; ++i )
+      {
+         const size_t n = std::min( nRead, logicalPageSize - pageOffset );
+
+         memcpy( buf, batch_data + i * physicalPageSize + pageOffset, n );
+
+         buf += n;
+         nRead -= n;
+         pageOffset = 0;
+      }
+
+      page += batchPages;
+   }
+}
+
+const char *CheckedFile::pageInMemory( uint64_t page ) const
+{
+   if ( ( fd_ >= 0 ) || ( bufView_ == nullptr ) || ( ( page + 1 ) * physicalPageSize >
+                                                     physicalLength_ ) )
+   {
+      return nullptr;
+   }
+
+   return bufView_->data( page * physicalPageSize );
+}
+
+void CheckedFile::verifyPageInMemory( uint64_t page, bool lastPage )
+{
+   const char *pageData = pageInMemory( page );
+
+   if ( pageData == nullptr )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "fileName=" + fileName_ + " page=" +
+                                              toString( page ) );
+   }
+
+   reportDeferredError();
+
+   counters_.pagesRead.fetch_add( 1, std::memory_order_relaxed );
+
+   switch ( checkSumPolicy_ )
+   {
+      case ChecksumPolicy::ChecksumNone:
          break;
+
+      case ChecksumPolicy::ChecksumAll:
+      {
+         ScopedTimer<std::atomic<uint64_t>> timer( counters_.checksumNanoseconds );
+
+         verifyUnverifiedChecksums( pageData, page, 1, true );
       }
+      break;
 
-      memcpy( buf, page_buffer + pageOffset, n );
+      default:
+      {
+         const auto checksumMod =
+            static_cast<unsigned int>( std::nearbyint( 100.0 / checkSumPolicy_ ) );
 
-      buf += n;
-      nRead -= n;
-      pageOffset = 0;
-      ++page;
+         if ( ( !( page % checksumMod ) || lastPage ) && !pageVerified( page ) )
+         {
+            ScopedTimer<std::atomic<uint64_t>> timer( counters_.checksumNanoseconds );
 
-      n = std::min( nRead, logicalPageSize );
+            verifyRun( pageData, page, 1, true );
+         }
+      }
+      break;
    }
+}
 
-   // When done, leave cursor just past end of last byte read
-   seek( end, Logical );
+void CheckedFile::checkPages( uint64_t firstPage, size_t pageCount, char *buffer,
+                              std::vector<uint64_t> &badPages )
+{
+   readPhysicalPages( buffer, firstPage, pageCount );
+
+   ScopedTimer<std::atomic<uint64_t>> timer( counters_.checksumNanoseconds );
+
+   uint32_t check_sums[cReadBatchPageCount];
+
+   for ( size_t done = 0; done < pageCount; )
+   {
+      const size_t count = std::min( pageCount - done, cReadBatchPageCount );
+      const char *pages = buffer + done * physicalPageSize;
+
+      CRC32C::calculateBlocks( pages, count, physicalPageSize, logicalPageSize, check_sums );
+
+      counters_.checksumsVerified.fetch_add( count, std::memory_order_relaxed );
+
+      for ( size_t i = 0; i < count; ++i )
+      {
+         uint32_t check_sum_in_page = 0;
+         memcpy( &check_sum_in_page, pages + i * physicalPageSize + logicalPageSize,
+                 sizeof( check_sum_in_page ) );
+
+         if ( check_sum_in_page != swap_uint32( check_sums[i] ) )
+         {
+            badPages.push_back( firstPage + done + i );
+         }
+      }
+
+      done += count;
+   }
 }
 
-void CheckedFile::write( const char *buf, size_t nWrite )
+void CheckedFile::setChecksumVerification( ChecksumVerification verification )
 {
-#ifdef E57_VERBOSE
-   // cout << "write nWrite=" << nWrite << " position()="<< position() << std::endl;
-   // //???
-#endif
-   if ( readOnly_ )
+   if ( verifier_ )
    {
-      throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + fileName_ );
+      verifier_->finish();
+      verifier_.reset();
    }
 
-   uint64_t end = position( Logical ) + nWrite;
+   verification_ = verification;
 
-   uint64_t page = 0;
-   size_t pageOffset = 0;
+   if ( ( verification != ChecksumVerifyInline ) && readOnly_ &&
+        ( checkSumPolicy_ != ChecksumPolicy::ChecksumNone ) )
+   {
+      verifier_.reset( new ChecksumVerifier(
+         [this]( const char *pages, uint64_t firstPage, size_t pageCount ) {
+            ScopedTimer<std::atomic<uint64_t>> timer( counters_.checksumNanoseconds );
 
-   getCurrentPageAndOffset( page, pageOffset );
+            verifyChecksums( pages, firstPage, pageCount );
+         } ) );
+   }
+}
 
-   size_t n = std::min( nWrite, logicalPageSize - pageOffset );
+void CheckedFile::finishVerification()
+{
+   if ( verifier_ )
+   {
+      verifier_->finish();
+   }
+}
 
-   // Allocate temp page buffer
-   std::vector<char> page_buffer_v( physicalPageSize );
-   char *page_buffer = page_buffer_v.data();
+// With ChecksumVerifyDeferred, a failure found in the background is reported by the next read
+void CheckedFile::reportDeferredError()
+{
+   if ( verifier_ && ( verification_ == ChecksumVerifyDeferred ) )
+   {
+      verifier_->rethrowError();
+   }
+}
 
-   while ( nWrite > 0 )
+void CheckedFile::write( const char *buf, size_t nWrite )
+{
+   if ( bufferWrites_ && !readOnly_ )
    {
-      const uint64_t physicalLength = length( Physical );
+      writeBuffer_.insert( writeBuffer_.end(), buf, buf + nWrite );
 
-      if ( page * physicalPageSize < physicalLength )
+      if ( writeBuffer_.size() >= cWriteBatchPageCount * logicalPageSize )
       {
-         readPhysicalPage( page_buffer, page );
+         flushWriteBuffer();
       }
 
+      return;
+   }
+
+   writeNow( buf, nWrite );
+}
+
+void CheckedFile::bufferWrites( bool enable )
+{
+   if ( !enable )
+   {
+      flushWriteBuffer();
+   }
+
+   bufferWrites_ = enable;
+}
+
+void CheckedFile::flushWriteBuffer()
+{
+   if ( writeBuffer_.empty() )
+   {
+      return;
+   }
+
+   // Take the data first, since writing uses the position, which flushes the buffer
+   std::vector<char> buffer;
+   buffer.swap( writeBuffer_ );
+
+   writeNow( buffer.data(), buffer.size() );
+
+   // Keep the allocation for the next batch
+   buffer.clear();
+   writeBuffer_.swap( buffer );
+}
+
+void CheckedFile::writeNow( const char *buf, size_t nWrite )
+{
+   E57_TRACE_ZONE( "CheckedFile::write" );
+
 #ifdef E57_VERBOSE
-      // cout << "  page_buffer[0] read: '" << page_buffer[0] << "'" << std::endl;
-      // cout << "copy " << n << "bytes to page=" << page << " pageOffset=" <<
-      // pageOffset << " buf='"; //??? for (size_t i=0; i < n; i++) cout <<
-      // buf[i]; cout << "'" << std::endl;
-#endif
-      memcpy( page_buffer + pageOffset, buf, n );
-      writePhysicalPage( page_buffer, page );
-#ifdef E57_VERBOSE
-      // cout << "  page_buffer[0] after write: '" << page_buffer[0] << "'" <<
-      // std::endl; //???
+   // cout << "write nWrite=" << nWrite << " position()="<< position() << std::endl;
+   // //???
 #endif
-      buf += n;
-      nWrite -= n;
-      pageOffset = 0;
-      page++;
-      n = std::min( nWrite, logicalPageSize );
+   if ( readOnly_ )
+   {
+      throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + fileName_ );
    }
 
+   const uint64_t start = position( Logical );
+   const uint64_t end = start + nWrite;
+
+   // Write any zeros from extend() which come before this first
+   writeZeros( start );
+
+   writePages( start, buf, nWrite );
+
+   writtenLength_ = std::max( writtenLength_, end );
+
    if ( end > logicalLength_ )
    {
       logicalLength_ = end;
@@ -431,31 +1163,19 @@ CheckedFile &CheckedFile::operator<<( uint64_t i )
 
 CheckedFile &CheckedFile::operator<<( float f )
 {
-   //??? is 7 digits right number?
-   return writeFloatingPoint( f, 7 );
+   return ( *this << floatingPointToShortestStr( f ) );
 }
 
 CheckedFile &CheckedFile::operator<<( double d )
 {
-   //??? is 17 digits right number?
-   return writeFloatingPoint( d, 17 );
-}
-
-template <class FTYPE> CheckedFile &CheckedFile::writeFloatingPoint( FTYPE value, int precision )
-{
-   static_assert( std::is_floating_point<FTYPE>::value, "Floating point type required." );
-
-#ifdef E57_VERBOSE
-   std::cout << "CheckedFile::writeFloatingPoint, value=" << value << " precision=" << precision
-             << std::endl;
-#endif
-
-   return *this << floatingPointToStr( value, precision );
+   return ( *this << floatingPointToShortestStr( d ) );
 }
 
 void CheckedFile::seek( uint64_t offset, OffsetMode omode )
 {
    //??? check for seek beyond logicalLength_
+   flushWriteBuffer();
+
    const auto pos =
       static_cast<int64_t>( omode == Physical ? offset : logicalToPhysical( offset ) );
 
@@ -468,6 +1188,36 @@ void CheckedFile::seek( uint64_t offset, OffsetMode omode )
 
 uint64_t CheckedFile::lseek64( int64_t offset, int whence )
 {
+   if ( sink_ )
+   {
+      const int64_t cBase = ( whence == SEEK_SET )   ? 0
+                            : ( whence == SEEK_CUR ) ? static_cast<int64_t>( sinkPosition_ )
+                                                     : static_cast<int64_t>( sinkLength_ );
+
+      if ( cBase + offset < 0 )
+      {
+         throw E57_EXCEPTION2( ErrorSeekFailed, "fileName=" + fileName_ +
+                                                   " offset=" + toString( offset ) +
+                                                   " whence=" + toString( whence ) );
+      }
+
+      sinkPosition_ = static_cast<uint64_t>( cBase + offset );
+
+      return sinkPosition_;
+   }
+
+   if ( sourceReader_ )
+   {
+      if ( sourceReader_->seek( static_cast<uint64_t>( offset ), whence ) )
+      {
+         return sourceReader_->pos();
+      }
+
+      throw E57_EXCEPTION2( ErrorSeekFailed, "fileName=" + fileName_ +
+                                                " offset=" + toString( offset ) +
+                                                " whence=" + toString( whence ) );
+   }
+
    if ( ( fd_ < 0 ) && ( bufView_ != nullptr ) )
    {
       const auto uoffset = static_cast<uint64_t>( offset );
@@ -504,6 +1254,8 @@ uint64_t CheckedFile::lseek64( int64_t offset, int whence )
 
 uint64_t CheckedFile::position( OffsetMode omode )
 {
+   flushWriteBuffer();
+
    // Get current file cursor position
    const uint64_t pos = lseek64( 0LL, SEEK_CUR );
 
@@ -517,6 +1269,8 @@ uint64_t CheckedFile::position( OffsetMode omode )
 
 uint64_t CheckedFile::length( OffsetMode omode )
 {
+   flushWriteBuffer();
+
    if ( omode == Physical )
    {
       if ( readOnly_ )
@@ -571,76 +1325,79 @@ void CheckedFile::extend( uint64_t newLength, OffsetMode omode )
                                " currentLength=" + toString( currentLogicalLength ) );
    }
 
-   // Calc how may zero bytes we have to add to end
-   uint64_t nWrite = newLogicalLength - currentLogicalLength;
-
-   // Seek to current end of file
-   seek( currentLogicalLength, Logical );
-
-   uint64_t page = 0;
-   size_t pageOffset = 0;
-
-   getCurrentPageAndOffset( page, pageOffset );
+   // The zeros aren't written now. Usually the caller overwrites them soon, so they are written
+   // by write() only if it skips over some of them, or when the file is closed.
+   logicalLength_ = newLogicalLength;
 
-   // Calc first write size (may be partial page)
-   // Watch out for different int sizes here.
-   size_t n = 0;
+   // When done, leave cursor at end of file
+   seek( newLogicalLength, Logical );
+}
 
-   if ( nWrite < logicalPageSize - pageOffset )
+void CheckedFile::reserve( uint64_t newLength, OffsetMode omode )
+{
+   if ( sink_ )
    {
-      n = static_cast<size_t>( nWrite );
+      sink_->reserve( ( omode == Physical ) ? newLength : logicalToPhysical( newLength ) );
+      return;
    }
-   else
+
+   if ( readOnly_ || ( fd_ < 0 ) )
    {
-      n = logicalPageSize - pageOffset;
+      return;
    }
 
-   // Allocate temp page buffer
-   std::vector<char> page_buffer_v( physicalPageSize );
-   char *page_buffer = page_buffer_v.data();
+   // Round up to whole physical pages
+   uint64_t physicalLength = ( omode == Physical ) ? newLength : logicalToPhysical( newLength );
+   physicalLength = ( physicalLength + physicalPageSizeMask ) & ~physicalPageSizeMask;
 
-   while ( nWrite > 0 )
-   {
-      const uint64_t physicalLength = length( Physical );
+   // This is only a hint, so failures (e.g. a file system which doesn't support it) are ignored.
+   // The file length must not change, since its end is where the next page is written.
+#if defined( _WIN32 )
+   auto handle = reinterpret_cast<HANDLE>( ::_get_osfhandle( fd_ ) );
 
-      if ( page * physicalPageSize < physicalLength )
-      {
-         readPhysicalPage( page_buffer, page );
-      }
+   FILE_ALLOCATION_INFO info = {};
+   info.AllocationSize.QuadPart = static_cast<LONGLONG>( physicalLength );
 
-#ifdef E57_VERBOSE
-      // cout << "extend " << n << "bytes on page=" << page << " pageOffset=" <<
-      // pageOffset << std::endl;
-      // //???
-#endif
-      memset( page_buffer + pageOffset, 0, n );
-      writePhysicalPage( page_buffer, page );
+   ::SetFileInformationByHandle( handle, FileAllocationInfo, &info, sizeof( info ) );
+#elif defined( __linux__ ) && defined( FALLOC_FL_KEEP_SIZE )
+   ::fallocate( fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>( physicalLength ) );
+#elif defined( __APPLE__ )
+   const uint64_t currentLength = length( Physical );
 
-      nWrite -= n;
-      pageOffset = 0;
-      ++page;
+   if ( physicalLength > currentLength )
+   {
+      // Try for contiguous space first
+      fstore_t store = { F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0,
+                         static_cast<off_t>( physicalLength - currentLength ), 0 };
 
-      if ( nWrite < logicalPageSize )
-      {
-         n = static_cast<size_t>( nWrite );
-      }
-      else
+      if ( ::fcntl( fd_, F_PREALLOCATE, &store ) < 0 )
       {
-         n = logicalPageSize;
+         store.fst_flags = F_ALLOCATEALL;
+         ::fcntl( fd_, F_PREALLOCATE, &store );
       }
    }
-
-   //??? what if loop above throws, logicalLength_ may be wrong
-   logicalLength_ = newLogicalLength;
-
-   // When done, leave cursor at end of file
-   seek( newLogicalLength, Logical );
+#else
+   E57_UNUSED( physicalLength );
+#endif
 }
 
 void CheckedFile::close()
 {
+   // Pages being verified may be those of the mapping
+   verifier_.reset();
+
    if ( fd_ >= 0 )
    {
+      if ( !readOnly_ )
+      {
+         flushWriteBuffer();
+
+         // Write the zeros still owed by extend()
+         writeZeros( logicalLength_ );
+      }
+
+      closePositionalHandle();
+
 #if defined( _MSC_VER )
       int result = ::_close( fd_ );
 #elif defined( __GNUC__ )
@@ -657,6 +1414,30 @@ void CheckedFile::close()
       fd_ = -1;
    }
 
+   if ( sink_ )
+   {
+      flushWriteBuffer();
+
+      // Write the zeros still owed by extend()
+      writeZeros( logicalLength_ );
+
+      // Let go of the sink even if it fails to finish
+      const std::shared_ptr<WriteSink> sink( std::move( sink_ ) );
+
+      try
+      {
+         sink->finish();
+      }
+      catch ( E57Exception & )
+      {
+         throw;
+      }
+      catch ( std::exception &err )
+      {
+         throw E57_EXCEPTION2( ErrorWriteFailed, "fileName=" + fileName_ + " what=" + err.what() );
+      }
+   }
+
    if ( bufView_ != nullptr )
    {
       delete bufView_;
@@ -665,11 +1446,31 @@ void CheckedFile::close()
       // WARNING: do NOT delete buffer of bufView_ because
       // pointer is handled by user !!
    }
+
+   sourceReader_.reset();
+
+   // ...unless it is our own mapping of the file
+   unmapFile();
 }
 
 void CheckedFile::unlink()
 {
-   close();
+   // No need to write the rest of the zeros
+   writtenLength_ = logicalLength_;
+
+   if ( sink_ )
+   {
+      writeBuffer_.clear();
+
+      const std::shared_ptr<WriteSink> sink( std::move( sink_ ) );
+
+      sink->discard();
+
+      close();
+      return;
+   }
+
+   close();
 
    // Try to remove the file, don't report a failure
    int result = std::remove( fileName_.c_str() ); //??? unicode support here
@@ -683,11 +1484,48 @@ void CheckedFile::unlink()
 #endif
 }
 
-void CheckedFile::verifyChecksum( char *page_buffer, uint64_t page )
+void CheckedFile::discardAppended()
+{
+   // No need to write the rest of the zeros, or what is collected by bufferWrites()
+   writtenLength_ = logicalLength_;
+   writeBuffer_.clear();
+
+   verifier_.reset();
+
+   if ( fd_ >= 0 )
+   {
+#if defined( _WIN32 )
+      const int result = ::_chsize_s( fd_, static_cast<__int64>( appendStart_ ) );
+#elif defined( __linux__ ) || defined( __EMSCRIPTEN__ )
+      const int result = ::ftruncate64( fd_, static_cast<off64_t>( appendStart_ ) );
+#elif defined( __APPLE__ ) || defined( __BSD )
+      const int result = ::ftruncate( fd_, static_cast<off_t>( appendStart_ ) );
+#else
+#error "no supported OS platform defined"
+#endif
+
+      // As for unlink(), don't report a failure
+#ifdef E57_VERBOSE
+      if ( result != 0 )
+      {
+         std::cout << "truncating the file failed, result=" << result << std::endl;
+      }
+#else
+      E57_UNUSED( result );
+#endif
+   }
+
+   close();
+}
+
+void CheckedFile::verifyChecksum( const char *page_buffer, uint64_t page )
 {
+   counters_.checksumsVerified.fetch_add( 1, std::memory_order_relaxed );
+
    const uint32_t check_sum = checksum( page_buffer, logicalPageSize );
-   const uint32_t check_sum_in_page =
-      *reinterpret_cast<uint32_t *>( &page_buffer[logicalPageSize] );
+
+   uint32_t check_sum_in_page = 0;
+   memcpy( &check_sum_in_page, &page_buffer[logicalPageSize], sizeof( check_sum_in_page ) );
 
    if ( check_sum_in_page != check_sum )
    {
@@ -698,6 +1536,126 @@ void CheckedFile::verifyChecksum( char *page_buffer, uint64_t page )
                                " storedChecksum=" + toString( check_sum_in_page ) + " page=" +
                                toString( page ) + " length=" + toString( physicalLength ) );
    }
+
+   setPagesVerified( page, 1 );
+}
+
+void CheckedFile::verifyChecksums( const char *pages, uint64_t firstPage, size_t pageCount )
+{
+   uint32_t check_sums[cReadBatchPageCount];
+
+   while ( pageCount > 0 )
+   {
+      const size_t count = std::min( pageCount, cReadBatchPageCount );
+
+      CRC32C::calculateBlocks( pages, count, physicalPageSize, logicalPageSize, check_sums );
+
+      counters_.checksumsVerified.fetch_add( count, std::memory_order_relaxed );
+
+      for ( size_t i = 0; i < count; ++i )
+      {
+         uint32_t check_sum_in_page = 0;
+         memcpy( &check_sum_in_page, pages + i * physicalPageSize + logicalPageSize,
+                 sizeof( check_sum_in_page ) );
+
+         if ( check_sum_in_page != swap_uint32( check_sums[i] ) )
+         {
+            // Report it the same way as a single page
+            verifyChecksum( pages + i * physicalPageSize, firstPage + i );
+         }
+      }
+
+      setPagesVerified( firstPage, count );
+
+      pages += count * physicalPageSize;
+      firstPage += count;
+      pageCount -= count;
+   }
+}
+
+// Verify the checksums of those of the pages which haven't been verified yet, a run of pages at a
+// time
+void CheckedFile::verifyUnverifiedChecksums( const char *pages, uint64_t firstPage,
+                                             size_t pageCount, bool inMemory )
+{
+   size_t i = 0;
+
+   while ( i < pageCount )
+   {
+      if ( pageVerified( firstPage + i ) )
+      {
+         ++i;
+         continue;
+      }
+
+      size_t end = i + 1;
+
+      while ( ( end < pageCount ) && !pageVerified( firstPage + end ) )
+      {
+         ++end;
+      }
+
+      verifyRun( pages + i * physicalPageSize, firstPage + i, end - i, inMemory );
+
+      i = end;
+   }
+}
+
+// Verify a run of pages now, or queue it for the background verifier. Pages which aren't in
+// memory (@a inMemory) are in a buffer about to be reused, so the verifier copies them.
+void CheckedFile::verifyRun( const char *pages, uint64_t firstPage, size_t pageCount,
+                             bool inMemory )
+{
+   if ( verifier_ )
+   {
+      // Count them as verified now so they aren't queued again
+      setPagesVerified( firstPage, pageCount );
+
+      verifier_->push( pages, firstPage, pageCount, !inMemory );
+      return;
+   }
+
+   verifyChecksums( pages, firstPage, pageCount );
+}
+
+void CheckedFile::setUpVerifiedPages()
+{
+   if ( checkSumPolicy_ == ChecksumPolicy::ChecksumNone )
+   {
+      return;
+   }
+
+   const uint64_t pageCount = ( physicalLength_ + physicalPageSizeMask ) >> physicalPageSizeLog2;
+
+   verifiedPagesWords_ = ( pageCount + 63 ) / 64;
+   verifiedPages_.reset( new std::atomic<uint64_t>[verifiedPagesWords_]() );
+}
+
+bool CheckedFile::pageVerified( uint64_t page ) const
+{
+   if ( ( page / 64 ) >= verifiedPagesWords_ )
+   {
+      return false;
+   }
+
+   const uint64_t bit = uint64_t( 1 ) << ( page % 64 );
+
+   return ( verifiedPages_[page / 64].load( std::memory_order_relaxed ) & bit ) != 0;
+}
+
+void CheckedFile::setPagesVerified( uint64_t firstPage, size_t pageCount )
+{
+   for ( uint64_t page = firstPage; page < firstPage + pageCount; ++page )
+   {
+      if ( ( page / 64 ) >= verifiedPagesWords_ )
+      {
+         return;
+      }
+
+      const uint64_t bit = uint64_t( 1 ) << ( page % 64 );
+
+      verifiedPages_[page / 64].fetch_or( bit, std::memory_order_relaxed );
+   }
 }
 
 void CheckedFile::getCurrentPageAndOffset( uint64_t &page, size_t &pageOffset, OffsetMode omode )
@@ -717,66 +1675,432 @@ void CheckedFile::getCurrentPageAndOffset( uint64_t &page, size_t &pageOffset, O
 }
 
 void CheckedFile::readPhysicalPage( char *page_buffer, uint64_t page )
+{
+   readPhysicalPages( page_buffer, page, 1 );
+}
+
+void CheckedFile::readPhysicalPages( char *page_buffer, uint64_t page, size_t pageCount )
 {
 #ifdef E57_VERBOSE
-   // cout << "readPhysicalPage, page:" << page << std::endl;
+   // cout << "readPhysicalPages, page:" << page << " count:" << pageCount << std::endl;
 #endif
 
 #ifdef E57_CHECK_FILE_DEBUG
    const uint64_t physicalLength = length( Physical );
 
-   assert( page * physicalPageSize < physicalLength );
+   assert( ( page + pageCount ) * physicalPageSize <= physicalLength );
 #endif
 
-   // Seek to start of physical page
-   seek( page * physicalPageSize, Physical );
+   uint64_t offset = page * physicalPageSize;
+   size_t byteCount = pageCount * physicalPageSize;
+
+   counters_.pagesRead.fetch_add( pageCount, std::memory_order_relaxed );
 
    if ( ( fd_ < 0 ) && ( bufView_ != nullptr ) )
    {
-      bufView_->read( page_buffer, physicalPageSize );
+      if ( offset + byteCount > physicalLength_ )
+      {
+         throw E57_EXCEPTION2( ErrorReadFailed, "fileName=" + fileName_ +
+                                                   " page=" + toString( page ) +
+                                                   " length=" + toString( physicalLength_ ) );
+      }
+
+      memcpy( page_buffer, bufView_->data( offset ), byteCount );
       return;
    }
 
-#if defined( _MSC_VER )
-   int result = ::_read( fd_, page_buffer, physicalPageSize );
-#elif defined( __GNUC__ )
-   ssize_t result = ::read( fd_, page_buffer, physicalPageSize );
+   if ( sourceReader_ )
+   {
+      if ( offset + byteCount > physicalLength_ )
+      {
+         throw E57_EXCEPTION2( ErrorReadFailed, "fileName=" + fileName_ +
+                                                   " page=" + toString( page ) +
+                                                   " length=" + toString( physicalLength_ ) );
+      }
+
+      sourceReader_->read( page_buffer, offset, byteCount );
+      return;
+   }
+
+   if ( sink_ )
+   {
+      readFromSink( page_buffer, offset, byteCount );
+      return;
+   }
+
+   if ( directIO_ )
+   {
+      // Direct reads must be aligned, so read the blocks covering the pages & copy them out. The
+      // last block may be cut short by the end of the file.
+      const uint64_t alignedOffset = offset & ~static_cast<uint64_t>( cDirectAlignment - 1 );
+      const auto skip = static_cast<size_t>( offset - alignedOffset );
+      const size_t alignedCount =
+         ( skip + byteCount + cDirectAlignment - 1 ) & ~( cDirectAlignment - 1 );
+
+      AlignedBuffer blocks( alignedCount );
+
+      readPhysicalBytes( blocks.data(), alignedOffset, alignedCount, skip + byteCount );
+
+      memcpy( page_buffer, blocks.data() + skip, byteCount );
+      return;
+   }
+
+   readPhysicalBytes( page_buffer, offset, byteCount, byteCount );
+
+#if defined( __linux__ )
+   if ( dropCache_ && readOnly_ )
+   {
+      ::posix_fadvise( fd_, static_cast<off_t>( offset ), static_cast<off_t>( byteCount ),
+                       POSIX_FADV_DONTNEED );
+   }
+#endif
+}
+
+size_t CheckedFile::readPhysicalBytes( char *buf, uint64_t offset, size_t byteCount,
+                                       size_t minCount )
+{
+   size_t total = 0;
+
+   // Positional reads don't touch the file position, so several threads can read at once. (On
+   // Windows they use positionalHandle_, which moves only its own position.)
+   // Loop since a read may return less than requested.
+   while ( total < minCount )
+   {
+#if defined( _WIN32 )
+      auto handle = static_cast<HANDLE>( positionalHandle_ );
+
+      OVERLAPPED overlapped = {};
+      overlapped.Offset = static_cast<DWORD>( offset & 0xFFFFFFFF );
+      overlapped.OffsetHigh = static_cast<DWORD>( offset >> 32 );
+
+      DWORD bytesRead = 0;
+      const BOOL success = ::ReadFile( handle, buf, static_cast<DWORD>( byteCount ),
+                                       &bytesRead, &overlapped );
+
+      const int64_t result = success ? static_cast<int64_t>( bytesRead ) : -1;
+#elif defined( __linux__ ) || defined( __EMSCRIPTEN__ )
+      const ssize_t result =
+         ::pread64( fd_, buf, byteCount, static_cast<off64_t>( offset ) );
+#elif defined( __APPLE__ ) || defined( __BSD )
+      const ssize_t result = ::pread( fd_, buf, byteCount, static_cast<off_t>( offset ) );
 #else
-#error "no supported compiler defined"
+#error "no supported OS platform defined"
 #endif
 
-   if ( result < 0 || static_cast<size_t>( result ) != physicalPageSize )
+      if ( result <= 0 )
+      {
+         throw E57_EXCEPTION2( ErrorReadFailed, "fileName=" + fileName_ +
+                                                   " offset=" + toString( offset ) +
+                                                   " result=" + toString( result ) );
+      }
+
+      buf += result;
+      offset += static_cast<uint64_t>( result );
+      byteCount -= static_cast<size_t>( result );
+      total += static_cast<size_t>( result );
+   }
+
+   return total;
+}
+
+// Report the errors of the sink as ours
+void CheckedFile::writeToSink( const char *buf, uint64_t offset, size_t byteCount )
+{
+   try
+   {
+      sink_->writeAt( offset, buf, byteCount );
+   }
+   catch ( E57Exception & )
+   {
+      throw;
+   }
+   catch ( std::exception &err )
+   {
+      throw E57_EXCEPTION2( ErrorWriteFailed, "fileName=" + fileName_ + " offset=" +
+                                                 toString( offset ) + " what=" + err.what() );
+   }
+
+   sinkLength_ = std::max( sinkLength_, offset + byteCount );
+}
+
+void CheckedFile::readFromSink( char *buf, uint64_t offset, size_t byteCount )
+{
+   try
+   {
+      sink_->readAt( offset, buf, byteCount );
+   }
+   catch ( E57Exception & )
+   {
+      throw;
+   }
+   catch ( std::exception &err )
+   {
+      throw E57_EXCEPTION2( ErrorReadFailed, "fileName=" + fileName_ + " offset=" +
+                                                toString( offset ) + " what=" + err.what() );
+   }
+}
+
+void CheckedFile::writeZeros( uint64_t logicalOffset )
+{
+   if ( logicalOffset > writtenLength_ )
+   {
+      writePages( writtenLength_, nullptr, logicalOffset - writtenLength_ );
+
+      writtenLength_ = logicalOffset;
+   }
+}
+
+void CheckedFile::writePages( uint64_t logicalOffset, const char *buf, uint64_t nWrite )
+{
+   uint64_t page = logicalOffset / logicalPageSize;
+   size_t pageOffset = static_cast<size_t>( logicalOffset - page * logicalPageSize );
+
+   // Pages past the end of the file don't have to be read back before they are written
+   const uint64_t physicalLength = length( Physical );
+
+   // Total number of physical pages touched by this write
+   const uint64_t pageCount = ( pageOffset + nWrite + logicalPageSize - 1 ) / logicalPageSize;
+
+   const auto maxBatchPages =
+      static_cast<size_t>( std::min<uint64_t>( pageCount, cWriteBatchPageCount ) );
+
+   // Allocate temp buffer for a run of physical pages
+   std::vector<char> batch_buffer_v( maxBatchPages * physicalPageSize );
+   char *batch_buffer = batch_buffer_v.data();
+
+   uint32_t check_sums[cWriteBatchPageCount];
+
+   while ( nWrite > 0 )
    {
-      throw E57_EXCEPTION2( ErrorReadFailed,
-                            "fileName=" + fileName_ + " result=" + toString( result ) );
+      const uint64_t pagesLeft = ( pageOffset + nWrite + logicalPageSize - 1 ) / logicalPageSize;
+      const auto batchPages = static_cast<size_t>( std::min<uint64_t>( pagesLeft, maxBatchPages ) );
+
+      for ( size_t i = 0; i < batchPages; ++i )
+      {
+         char *page_buffer = batch_buffer + i * physicalPageSize;
+
+         const auto n =
+            static_cast<size_t>( std::min<uint64_t>( nWrite, logicalPageSize - pageOffset ) );
+
+         // Only the first & last pages may be partly overwritten. Keep the rest of their contents.
+         if ( n < logicalPageSize )
+         {
+            if ( ( page + i ) * physicalPageSize < physicalLength )
+            {
+               readPhysicalPage( page_buffer, page + i );
+            }
+            else
+            {
+               memset( page_buffer, 0, logicalPageSize );
+            }
+         }
+
+         if ( buf != nullptr )
+         {
+            memcpy( page_buffer + pageOffset, buf, n );
+            buf += n;
+         }
+         else
+         {
+            memset( page_buffer + pageOffset, 0, n );
+         }
+
+         nWrite -= n;
+         pageOffset = 0;
+      }
+
+      // Append the checksums
+      {
+         ScopedTimer<std::atomic<uint64_t>> timer( counters_.checksumNanoseconds );
+
+         CRC32C::calculateBlocks( batch_buffer, batchPages, physicalPageSize, logicalPageSize,
+                                  check_sums );
+      }
+
+      for ( size_t i = 0; i < batchPages; ++i )
+      {
+         const uint32_t check_sum = swap_uint32( check_sums[i] );
+
+         memcpy( batch_buffer + i * physicalPageSize + logicalPageSize, &check_sum,
+                 sizeof( check_sum ) ); //??? little endian dependency
+      }
+
+      writePhysicalPages( batch_buffer, page, batchPages );
+
+      page += batchPages;
    }
 }
 
-void CheckedFile::writePhysicalPage( char *page_buffer, uint64_t page )
+void CheckedFile::writePhysicalPages( const char *page_buffer, uint64_t page, size_t pageCount )
 {
 #ifdef E57_VERBOSE
-   // cout << "writePhysicalPage, page:" << page << std::endl;
+   // cout << "writePhysicalPages, page:" << page << " count:" << pageCount << std::endl;
+#endif
+
+   uint64_t offset = page * physicalPageSize;
+   size_t byteCount = pageCount * physicalPageSize;
+
+   counters_.pagesWritten.fetch_add( pageCount, std::memory_order_relaxed );
+
+   if ( sink_ )
+   {
+      writeToSink( page_buffer, offset, byteCount );
+      return;
+   }
+
+   // Write the whole run with positional writes (on positionalHandle_ on Windows, see readAt()).
+   // Loop since a write may be shorter than requested.
+   while ( byteCount > 0 )
+   {
+#if defined( _WIN32 )
+      auto handle = static_cast<HANDLE>( positionalHandle_ );
+
+      OVERLAPPED overlapped = {};
+      overlapped.Offset = static_cast<DWORD>( offset & 0xFFFFFFFF );
+      overlapped.OffsetHigh = static_cast<DWORD>( offset >> 32 );
+
+      DWORD bytesWritten = 0;
+      const BOOL success = ::WriteFile( handle, page_buffer, static_cast<DWORD>( byteCount ),
+                                        &bytesWritten, &overlapped );
+
+      const int64_t result = success ? static_cast<int64_t>( bytesWritten ) : -1;
+#elif defined( __linux__ ) || defined( __EMSCRIPTEN__ )
+      const ssize_t result =
+         ::pwrite64( fd_, page_buffer, byteCount, static_cast<off64_t>( offset ) );
+#elif defined( __APPLE__ ) || defined( __BSD )
+      const ssize_t result = ::pwrite( fd_, page_buffer, byteCount, static_cast<off_t>( offset ) );
+#else
+#error "no supported OS platform defined"
+#endif
+
+      if ( result <= 0 )
+      {
+         throw E57_EXCEPTION2( ErrorWriteFailed, "fileName=" + fileName_ +
+                                                    " offset=" + toString( offset ) +
+                                                    " result=" + toString( result ) );
+      }
+
+      page_buffer += result;
+      offset += static_cast<uint64_t>( result );
+      byteCount -= static_cast<size_t>( result );
+   }
+
+   if ( dropCache_ )
+   {
+      dropWrittenPages( offset );
+   }
+}
+
+void CheckedFile::dropWrittenPages( uint64_t physicalEnd )
+{
+#if defined( __linux__ )
+   // Wait until a window's worth has been written since writeback was last started
+   if ( physicalEnd < writebackOffset_ + cCacheDropWindow )
+   {
+      return;
+   }
+
+   // Start writing back the new window. Then wait for the previous one, which will mostly be on
+   // disk by now, and drop it from the cache. Pages which are written again later are just read
+   // back in first.
+   ::sync_file_range( fd_, static_cast<off64_t>( writebackOffset_ ),
+                      static_cast<off64_t>( physicalEnd - writebackOffset_ ),
+                      SYNC_FILE_RANGE_WRITE );
+
+   if ( writebackOffset_ > droppedOffset_ )
+   {
+      const auto dropOffset = static_cast<off64_t>( droppedOffset_ );
+      const auto dropCount = static_cast<off64_t>( writebackOffset_ - droppedOffset_ );
+
+      ::sync_file_range( fd_, dropOffset, dropCount,
+                         SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                            SYNC_FILE_RANGE_WAIT_AFTER );
+      ::posix_fadvise( fd_, dropOffset, dropCount, POSIX_FADV_DONTNEED );
+
+      droppedOffset_ = writebackOffset_;
+   }
+
+   writebackOffset_ = physicalEnd;
+#else
+   (void)physicalEnd;
 #endif
+}
+
+void CheckedFile::mapFile()
+{
+   // Map the whole file read-only. Once mapped we no longer need the file descriptor, and all reads
+   // are served from the mapping through the BufferView code path.
+   std::string error;
+
+   if ( physicalLength_ > std::numeric_limits<size_t>::max() )
+   {
+      error = "file too large to map";
+   }
+   else if ( physicalLength_ > 0 )
+   {
+#if defined( _WIN32 )
+      auto fileHandle = reinterpret_cast<HANDLE>( ::_get_osfhandle( fd_ ) );
+      HANDLE mappingHandle =
+         ::CreateFileMappingW( fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr );
+
+      if ( mappingHandle != nullptr )
+      {
+         mapping_ =
+            static_cast<const char *>( ::MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 ) );
+
+         // The view holds a reference to the mapping object, so we can close our handle now
+         ::CloseHandle( mappingHandle );
+      }
+
+      if ( mapping_ == nullptr )
+      {
+         error = "GetLastError=" + toString( static_cast<uint64_t>( ::GetLastError() ) );
+      }
+#else
+      void *view = ::mmap( nullptr, static_cast<size_t>( physicalLength_ ), PROT_READ, MAP_PRIVATE,
+                           fd_, 0 );
 
-   // Append checksum
-   uint32_t check_sum = checksum( page_buffer, logicalPageSize );
-   *reinterpret_cast<uint32_t *>( &page_buffer[logicalPageSize] ) =
-      check_sum; //??? little endian dependency
+      if ( view == MAP_FAILED )
+      {
+         error = "errno=" + toString( errno ) + " error='" + strerror( errno ) + "'";
+      }
+      else
+      {
+         mapping_ = static_cast<const char *>( view );
+      }
+#endif
+   }
 
-   // Seek to start of physical page
-   seek( page * physicalPageSize, Physical );
+   closePositionalHandle();
 
 #if defined( _MSC_VER )
-   int result = ::_write( fd_, page_buffer, physicalPageSize );
-#elif defined( __GNUC__ )
-   ssize_t result = ::write( fd_, page_buffer, physicalPageSize );
+   ::_close( fd_ );
 #else
-#error "no supported compiler defined"
+   ::close( fd_ );
 #endif
+   fd_ = -1;
 
-   if ( result < 0 )
+   if ( !error.empty() )
+   {
+      throw E57_EXCEPTION2( ErrorOpenFailed, "fileName=" + fileName_ + " " + error +
+                                                " length=" + toString( physicalLength_ ) );
+   }
+
+   bufView_ = new BufferView( mapping_, physicalLength_ );
+}
+
+void CheckedFile::unmapFile()
+{
+   if ( mapping_ == nullptr )
    {
-      throw E57_EXCEPTION2( ErrorWriteFailed,
-                            "fileName=" + fileName_ + " result=" + toString( result ) );
+      return;
    }
+
+#if defined( _WIN32 )
+   ::UnmapViewOfFile( mapping_ );
+#else
+   ::munmap( const_cast<char *>( mapping_ ), static_cast<size_t>( physicalLength_ ) );
+#endif
+
+   mapping_ = nullptr;
 }
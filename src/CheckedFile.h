@@ -28,6 +28,9 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 #include "Common.h"
 
@@ -39,6 +42,12 @@ namespace e57
    // WARNING: pointer input is handled by user!
    class BufferView;
 
+   // Reads a ReadSource in blocks, keeping the most recent ones.
+   class SourceReader;
+
+   // Verifies checksums on a background thread.
+   class ChecksumVerifier;
+
    class CheckedFile
    {
    public:
@@ -52,7 +61,9 @@ namespace e57
       enum Mode
       {
          Read,
+         ReadMemoryMapped,
          Write,
+         Append, // existing file, written after its current end
       };
 
       enum OffsetMode
@@ -61,12 +72,64 @@ namespace e57
          Physical
       };
 
-      CheckedFile( const e57::ustring &fileName, Mode mode, ReadChecksumPolicy policy );
+      // Counts of the work done on the file. They are updated by concurrent reads too, so they
+      // may be read while other threads use the file.
+      struct Counters
+      {
+         std::atomic<uint64_t> pagesRead{ 0 };
+         std::atomic<uint64_t> pagesWritten{ 0 };
+         std::atomic<uint64_t> checksumsVerified{ 0 };
+         std::atomic<uint64_t> checksumNanoseconds{ 0 };
+      };
+
+      CheckedFile( const e57::ustring &fileName, Mode mode, ReadChecksumPolicy policy,
+                   FileCacheMode cacheMode = FileCacheNormal );
       CheckedFile( const char *input, uint64_t size, ReadChecksumPolicy policy );
+      CheckedFile( std::shared_ptr<ReadSource> source, ReadChecksumPolicy policy );
+      explicit CheckedFile( std::shared_ptr<WriteSink> sink );
       ~CheckedFile();
 
       void read( char *buf, size_t nRead, size_t bufSize = 0 );
+
+      // Read nRead logical bytes starting at logicalOffset. This does not use or change the file
+      // position, so on a read-only file it may be called from several threads at once.
+      void readAt( uint64_t logicalOffset, char *buf, size_t nRead );
+
+      // When the file is in memory (mapped, or the caller's buffer), the start of physical page
+      // @a page. Otherwise nullptr.
+      const char *pageInMemory( uint64_t page ) const;
+
+      // Verify the checksum of physical page @a page of a file in memory, if the checksum policy
+      // calls for it. As with reads, the last page of a range is always verified.
+      void verifyPageInMemory( uint64_t page, bool lastPage );
+
+      // Read @a pageCount physical pages from page @a firstPage into @a buffer (room for that many
+      // physical pages), verify their checksums whatever the checksum policy is, and add those
+      // which fail to @a badPages. This may be called from several threads at once.
+      void checkPages( uint64_t firstPage, size_t pageCount, char *buffer,
+                       std::vector<uint64_t> &badPages );
+
+      // Verify the checksums on a background thread instead of before the data is returned (see
+      // ChecksumVerification). Only read-only files are affected. This must not be called while
+      // the file is being read.
+      void setChecksumVerification( ChecksumVerification verification );
+
+      // Wait for the background verification of the pages read so far, then report its first
+      // failure, if there has been one.
+      void finishVerification();
+
       void write( const char *buf, size_t nWrite );
+
+      // While enabled, collect what is written in memory & write it a batch of whole pages at a
+      // time, instead of reading back, checksumming & rewriting a page for every small write
+      // (such as those of the XML section). Anything using the file position or length writes
+      // out what has been collected first, as does disabling it.
+      void bufferWrites( bool enable );
+
+      // For a file opened with Append: throw away what was written since it was opened, by
+      // cutting it back to its original length, and close it.
+      void discardAppended();
+
       CheckedFile &operator<<( const e57::ustring &s );
       CheckedFile &operator<<( int64_t i );
       CheckedFile &operator<<( uint64_t i );
@@ -77,11 +140,20 @@ namespace e57
       uint64_t length( OffsetMode omode = Logical );
       void extend( uint64_t newLength, OffsetMode omode = Logical );
 
+      // Ask the file system to allocate space for the file up to newLength without changing its
+      // length, so later writes don't have to grow it piece by piece. This is only a hint.
+      void reserve( uint64_t newLength, OffsetMode omode = Logical );
+
       e57::ustring fileName() const
       {
          return fileName_;
       }
 
+      const Counters &counters() const
+      {
+         return counters_;
+      }
+
       void close();
       void unlink();
 
@@ -89,26 +161,96 @@ namespace e57
       static inline uint64_t physicalToLogical( uint64_t physicalOffset );
 
    private:
-      void verifyChecksum( char *page_buffer, uint64_t page );
+      void verifyChecksum( const char *page_buffer, uint64_t page );
+      void verifyChecksums( const char *pages, uint64_t firstPage, size_t pageCount );
+      void verifyUnverifiedChecksums( const char *pages, uint64_t firstPage, size_t pageCount,
+                                      bool inMemory );
+      void verifyRun( const char *pages, uint64_t firstPage, size_t pageCount, bool inMemory );
+      void reportDeferredError();
 
-      template <class FTYPE> CheckedFile &writeFloatingPoint( FTYPE value, int precision );
+      void setUpVerifiedPages();
+      bool pageVerified( uint64_t page ) const;
+      void setPagesVerified( uint64_t firstPage, size_t pageCount );
 
       void getCurrentPageAndOffset( uint64_t &page, size_t &pageOffset,
                                     OffsetMode omode = Logical );
       void readPhysicalPage( char *page_buffer, uint64_t page );
-      void writePhysicalPage( char *page_buffer, uint64_t page );
+      void readPhysicalPages( char *page_buffer, uint64_t page, size_t pageCount );
+      size_t readPhysicalBytes( char *buf, uint64_t offset, size_t byteCount, size_t minCount );
+      void setUpCacheMode( Mode mode, FileCacheMode cacheMode );
+      void dropWrittenPages( uint64_t physicalEnd );
+      void writeNow( const char *buf, size_t nWrite );
+      void flushWriteBuffer();
+      void writeZeros( uint64_t logicalOffset );
+      void writePages( uint64_t logicalOffset, const char *buf, uint64_t nWrite );
+      void writePhysicalPages( const char *page_buffer, uint64_t page, size_t pageCount );
+      void writeToSink( const char *buf, uint64_t offset, size_t byteCount );
+      void readFromSink( char *buf, uint64_t offset, size_t byteCount );
       int open64( const e57::ustring &fileName, int flags, int mode );
+      void openPositionalHandle( bool writable );
+      void closePositionalHandle();
       uint64_t lseek64( int64_t offset, int whence );
 
+      void mapFile();
+      void unmapFile();
+
       e57::ustring fileName_;
       uint64_t logicalLength_ = 0;
       uint64_t physicalLength_ = 0;
 
+      // When writing, the logical bytes actually in the file. Those after this (up to
+      // logicalLength_) were added by extend() and are zeros which haven't been written yet.
+      uint64_t writtenLength_ = 0;
+
+      // When appending, the physical length of the file when it was opened
+      uint64_t appendStart_ = 0;
+
       ReadChecksumPolicy checkSumPolicy_ = ChecksumPolicy::ChecksumAll;
 
       int fd_ = -1;
+
+#if defined( _WIN32 )
+      // A second handle to the file (with its own file position) for the positional reads &
+      // writes. Unlike pread() & pwrite(), ReadFile() & WriteFile() at an offset also move the file
+      // position of their handle, so using that of fd_ would move the position of seek() & read().
+      void *positionalHandle_ = nullptr;
+#endif
       BufferView *bufView_ = nullptr;
+      std::unique_ptr<SourceReader> sourceReader_;
+
+      // When writing to a sink instead of a file, its position & physical length
+      std::shared_ptr<WriteSink> sink_;
+      uint64_t sinkPosition_ = 0;
+      uint64_t sinkLength_ = 0;
       bool readOnly_ = false;
+
+      // Start of the read-only mapping of the whole file when opened with ReadMemoryMapped
+      const char *mapping_ = nullptr;
+
+      // Reads use direct I/O (O_DIRECT), so they go through an aligned buffer
+      bool directIO_ = false;
+
+      // Drop pages from the OS file cache once they have been read or written
+      bool dropCache_ = false;
+
+      // When dropping written pages: physical offset up to which writeback has been started, and
+      // up to which the pages have been dropped
+      uint64_t writebackOffset_ = 0;
+      uint64_t droppedOffset_ = 0;
+
+      // For read-only files, one bit for each physical page whose checksum has been verified, so
+      // a page read more than once (such as one shared by two packets) is only verified once
+      std::unique_ptr<std::atomic<uint64_t>[]> verifiedPages_;
+      uint64_t verifiedPagesWords_ = 0;
+
+      ChecksumVerification verification_ = ChecksumVerifyInline;
+      std::unique_ptr<ChecksumVerifier> verifier_;
+
+      // Writes collected by bufferWrites()
+      bool bufferWrites_ = false;
+      std::vector<char> writeBuffer_;
+
+      Counters counters_;
    };
 
    inline uint64_t CheckedFile::logicalToPhysical( uint64_t logicalOffset )
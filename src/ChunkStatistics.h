@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+
+#include "BitPack.h"
+#include "Common.h"
+
+namespace e57
+{
+   /// URI of the extension which holds the chunk statistics of compressed vectors
+   constexpr char cChunkStatisticsUri[] =
+      "https://github.com/asmaloney/libE57Format/E57_EXT_chunk_statistics";
+
+   /// Prefix used for the extension if the file doesn't already declare one for it
+   constexpr char cChunkStatisticsPrefix[] = "libe57";
+
+   /// Name of the structure, beside the compressed vectors, holding their statistics
+   constexpr char cChunkStatisticsElement[] = "chunkStatistics";
+
+   /// Minimum & maximum value of one field in each chunk of records of a compressed vector. The
+   /// encoders add the values as they encode them. @a T is int64_t for integer & scaled integer
+   /// fields (raw values) and double for float fields.
+   template <typename T> class ChunkStatistics
+   {
+   public:
+      explicit ChunkStatistics( uint64_t chunkRecordCount ) : chunkRecordCount_( chunkRecordCount )
+      {
+      }
+
+      /// Include @a count values, the first of which is record @a firstRecord.
+      template <typename V> void add( uint64_t firstRecord, const V *values, size_t count )
+      {
+         while ( count > 0 )
+         {
+            const auto cChunk = static_cast<size_t>( firstRecord / chunkRecordCount_ );
+            const auto cInChunk = static_cast<size_t>(
+               std::min<uint64_t>( count, ( cChunk + 1 ) * chunkRecordCount_ - firstRecord ) );
+
+            // NaNs are left out, since they never match a range
+            T minimum = std::numeric_limits<T>::max();
+            T maximum = std::numeric_limits<T>::lowest();
+
+            minMax( values, cInChunk, minimum, maximum );
+
+            extend( cChunk, minimum, maximum );
+
+            firstRecord += cInChunk;
+            values += cInChunk;
+            count -= cInChunk;
+         }
+      }
+
+      /// Include @a count records starting with record @a firstRecord, which all have @a value.
+      void addConstant( uint64_t firstRecord, size_t count, T value )
+      {
+         if ( count == 0 )
+         {
+            return;
+         }
+
+         const auto cFirstChunk = static_cast<size_t>( firstRecord / chunkRecordCount_ );
+         const auto cLastChunk = static_cast<size_t>( ( firstRecord + count - 1 ) /
+                                                      chunkRecordCount_ );
+
+         for ( size_t chunk = cFirstChunk; chunk <= cLastChunk; ++chunk )
+         {
+            extend( chunk, value, value );
+         }
+      }
+
+      uint64_t chunkRecordCount() const
+      {
+         return chunkRecordCount_;
+      }
+
+      size_t chunkCount() const
+      {
+         return minimum_.size();
+      }
+
+      T minimum( size_t chunk ) const
+      {
+         return minimum_[chunk];
+      }
+
+      T maximum( size_t chunk ) const
+      {
+         return maximum_[chunk];
+      }
+
+   private:
+      static void minMax( const T *values, size_t count, T &minimum, T &maximum )
+      {
+         BitPack::minMax( values, count, minimum, maximum );
+      }
+
+      // Float fields are written from float buffers as well as double ones
+      static void minMax( const float *values, size_t count, double &minimum, double &maximum )
+      {
+         float floatMinimum = std::numeric_limits<float>::max();
+         float floatMaximum = std::numeric_limits<float>::lowest();
+
+         BitPack::minMax( values, count, floatMinimum, floatMaximum );
+
+         if ( floatMinimum <= floatMaximum )
+         {
+            minimum = std::min( minimum, static_cast<double>( floatMinimum ) );
+            maximum = std::max( maximum, static_cast<double>( floatMaximum ) );
+         }
+      }
+
+      void extend( size_t chunk, T minimum, T maximum )
+      {
+         if ( chunk >= minimum_.size() )
+         {
+            minimum_.resize( chunk + 1, std::numeric_limits<T>::max() );
+            maximum_.resize( chunk + 1, std::numeric_limits<T>::lowest() );
+         }
+
+         minimum_[chunk] = std::min( minimum_[chunk], minimum );
+         maximum_[chunk] = std::max( maximum_[chunk], maximum );
+      }
+
+      uint64_t chunkRecordCount_;
+
+      std::vector<T> minimum_;
+      std::vector<T> maximum_;
+   };
+}
@@ -0,0 +1,482 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <cstring>
+
+#include "Codecs.h"
+#include "CompressedVectorNodeImpl.h"
+#include "ImageFileImpl.h"
+#include "StringFunctions.h"
+#include "StringNodeImpl.h"
+#include "VectorNodeImpl.h"
+
+namespace e57
+{
+   namespace
+   {
+      // Path names of the prototype may be given with or without the leading "/"
+      ustring relativePath( const ustring &pathName )
+      {
+         return ( !pathName.empty() && ( pathName[0] == '/' ) ) ? pathName.substr( 1 ) : pathName;
+      }
+
+      // True if the codec @a codec (a structure in the codecs) has @a pathName in its inputs
+      bool hasInput( const NodeImplSharedPtr &codec, const ustring &pathName )
+      {
+         if ( ( codec->type() != TypeStructure ) || !codec->isDefined( "inputs" ) )
+         {
+            return false;
+         }
+
+         NodeImplSharedPtr inputs = codec->get( "inputs" );
+
+         if ( inputs->type() != TypeVector )
+         {
+            return false;
+         }
+
+         auto inputVector = std::static_pointer_cast<VectorNodeImpl>( inputs );
+
+         for ( int64_t i = 0; i < inputVector->childCount(); ++i )
+         {
+            NodeImplSharedPtr input = inputVector->get( i );
+
+            if ( ( input->type() == TypeString ) &&
+                 ( relativePath( std::static_pointer_cast<StringNodeImpl>( input )->value() ) ==
+                   pathName ) )
+            {
+               return true;
+            }
+         }
+
+         return false;
+      }
+
+      uint64_t lowBits( uint64_t value, unsigned bits )
+      {
+         return ( bits >= 64 ) ? value : ( value & ( ( uint64_t( 1 ) << bits ) - 1 ) );
+      }
+
+      // Writes values of up to 64 bits, least significant bits first
+      class BitWriter
+      {
+      public:
+         explicit BitWriter( char *out ) : out_( out )
+         {
+         }
+
+         void put( uint64_t value, unsigned bits )
+         {
+            while ( bits > 0 )
+            {
+               const unsigned cBits = std::min( bits, 32u );
+
+               word_ |= lowBits( value, cBits ) << used_;
+               used_ += cBits;
+               value = ( cBits < 64 ) ? ( value >> cBits ) : 0;
+               bits -= cBits;
+
+               while ( used_ >= 8 )
+               {
+                  *out_++ = static_cast<char>( word_ & 0xff );
+                  word_ >>= 8;
+                  used_ -= 8;
+               }
+            }
+         }
+
+         /// Write the last partial byte & return the end of the output
+         char *finish()
+         {
+            if ( used_ > 0 )
+            {
+               *out_++ = static_cast<char>( word_ & 0xff );
+               word_ = 0;
+               used_ = 0;
+            }
+
+            return out_;
+         }
+
+      private:
+         char *out_;
+         uint64_t word_ = 0;
+         unsigned used_ = 0;
+      };
+
+      // Reads values written by BitWriter, never reading a byte past the last bit needed
+      class BitReader
+      {
+      public:
+         explicit BitReader( const char *in ) : in_( in )
+         {
+         }
+
+         uint64_t get( unsigned bits )
+         {
+            uint64_t value = 0;
+            unsigned shift = 0;
+
+            while ( bits > 0 )
+            {
+               const unsigned cBits = std::min( bits, 32u );
+
+               while ( used_ < cBits )
+               {
+                  word_ |= static_cast<uint64_t>( static_cast<uint8_t>( *in_++ ) ) << used_;
+                  used_ += 8;
+               }
+
+               value |= lowBits( word_, cBits ) << shift;
+               word_ >>= cBits;
+               used_ -= cBits;
+               shift += cBits;
+               bits -= cBits;
+            }
+
+            return value;
+         }
+
+      private:
+         const char *in_;
+         uint64_t word_ = 0;
+         unsigned used_ = 0;
+      };
+   }
+
+   size_t deltaBlockMaxSize( unsigned fieldBits )
+   {
+      // Each zigzag delta takes at most one bit more than the field
+      return deltaBlockSize( static_cast<uint8_t>( std::min( fieldBits + 1, 64u ) ), fieldBits,
+                             cDeltaBlockRecordCount );
+   }
+
+   size_t deltaBlockSize( uint8_t header, unsigned fieldBits, size_t count )
+   {
+      const size_t cBits = fieldBits + ( count - 1 ) * header;
+
+      return 1 + ( cBits + 7 ) / 8;
+   }
+
+   size_t deltaBlockEncode( const int64_t *values, size_t count, int64_t minimum,
+                            unsigned fieldBits, char *out )
+   {
+      uint64_t zigzag[cDeltaBlockRecordCount];
+      uint64_t all = 0;
+
+      // The differences wrap around like the values less the minimum, so they can be undone
+      for ( size_t i = 1; i < count; ++i )
+      {
+         const uint64_t cDelta =
+            static_cast<uint64_t>( values[i] ) - static_cast<uint64_t>( values[i - 1] );
+
+         const auto cSign = static_cast<uint64_t>( static_cast<int64_t>( cDelta ) >> 63 );
+
+         zigzag[i] = ( cDelta << 1 ) ^ cSign;
+         all |= zigzag[i];
+      }
+
+      unsigned width = 0;
+
+      while ( ( width < 64 ) && ( ( all >> width ) != 0 ) )
+      {
+         ++width;
+      }
+
+      out[0] = static_cast<char>( width );
+
+      BitWriter writer( out + 1 );
+
+      writer.put( static_cast<uint64_t>( values[0] ) - static_cast<uint64_t>( minimum ),
+                  fieldBits );
+
+      for ( size_t i = 1; i < count; ++i )
+      {
+         writer.put( zigzag[i], width );
+      }
+
+      return static_cast<size_t>( writer.finish() - out );
+   }
+
+   void deltaBlockDecode( const char *in, size_t count, int64_t minimum, unsigned fieldBits,
+                          int64_t *values )
+   {
+      const auto cWidth = static_cast<unsigned>( static_cast<uint8_t>( in[0] ) );
+
+      BitReader reader( in + 1 );
+
+      uint64_t value = reader.get( fieldBits ) + static_cast<uint64_t>( minimum );
+
+      values[0] = static_cast<int64_t>( value );
+
+      for ( size_t i = 1; i < count; ++i )
+      {
+         const uint64_t cZigzag = reader.get( cWidth );
+
+         value += ( cZigzag >> 1 ) ^ ( ~( cZigzag & 1 ) + 1 );
+
+         values[i] = static_cast<int64_t>( value );
+      }
+   }
+
+   size_t lzMaxCompressedSize( size_t size )
+   {
+      return size + size / 255 + 16;
+   }
+
+   size_t lzCompress( const char *in, const size_t size, char *out )
+   {
+      constexpr unsigned cHashBits = 12;
+      constexpr size_t cMinimumMatch = 4;
+      constexpr size_t cMaximumOffset = 65535;
+
+      auto read32 = [in]( size_t position ) {
+         uint32_t value;
+         memcpy( &value, in + position, sizeof( value ) );
+         return value;
+      };
+
+      auto hash = [&read32]( size_t position ) {
+         return static_cast<size_t>( ( read32( position ) * 2654435761U ) >> ( 32 - cHashBits ) );
+      };
+
+      auto putLength = []( char *&output, size_t length ) {
+         for ( ; length >= 255; length -= 255 )
+         {
+            *output++ = static_cast<char>( 255 );
+         }
+
+         *output++ = static_cast<char>( length );
+      };
+
+      // Positions (plus one, so 0 is none) of the last 4 bytes with each hash
+      std::vector<uint32_t> table( size_t( 1 ) << cHashBits, 0 );
+
+      char *output = out;
+      size_t literalStart = 0;
+      size_t position = 0;
+
+      auto putSequence = [&]( size_t matchLength, size_t offset ) {
+         const size_t cLiteralLength = position - literalStart;
+         char *token = output++;
+
+         *token = static_cast<char>( std::min<size_t>( cLiteralLength, 15 ) << 4 );
+
+         if ( cLiteralLength >= 15 )
+         {
+            putLength( output, cLiteralLength - 15 );
+         }
+
+         memcpy( output, in + literalStart, cLiteralLength );
+         output += cLiteralLength;
+
+         if ( matchLength == 0 )
+         {
+            return;
+         }
+
+         output[0] = static_cast<char>( offset & 0xff );
+         output[1] = static_cast<char>( offset >> 8 );
+         output += 2;
+
+         const size_t cLength = matchLength - cMinimumMatch;
+
+         *token |= static_cast<char>( std::min<size_t>( cLength, 15 ) );
+
+         if ( cLength >= 15 )
+         {
+            putLength( output, cLength - 15 );
+         }
+      };
+
+      while ( position + cMinimumMatch <= size )
+      {
+         const size_t cHash = hash( position );
+         const size_t cCandidate = table[cHash];
+
+         table[cHash] = static_cast<uint32_t>( position + 1 );
+
+         if ( ( cCandidate == 0 ) || ( position - ( cCandidate - 1 ) > cMaximumOffset ) ||
+              ( read32( cCandidate - 1 ) != read32( position ) ) )
+         {
+            ++position;
+            continue;
+         }
+
+         const size_t cMatch = cCandidate - 1;
+         size_t length = cMinimumMatch;
+
+         while ( ( position + length < size ) && ( in[cMatch + length] == in[position + length] ) )
+         {
+            ++length;
+         }
+
+         putSequence( length, position - cMatch );
+
+         position += length;
+         literalStart = position;
+      }
+
+      position = size;
+      putSequence( 0, 0 );
+
+      return static_cast<size_t>( output - out );
+   }
+
+   void lzDecompress( const char *in, size_t size, char *out, size_t outSize )
+   {
+      const auto *input = reinterpret_cast<const uint8_t *>( in );
+      const uint8_t *inputEnd = input + size;
+      size_t produced = 0;
+
+      auto fail = [&]() {
+         return E57_EXCEPTION2( ErrorBadCVPacket, "lzBlockSize=" + toString( size ) +
+                                                     " produced=" + toString( produced ) );
+      };
+
+      auto getLength = [&]( size_t length ) {
+         if ( length == 15 )
+         {
+            uint8_t more;
+
+            do
+            {
+               if ( input == inputEnd )
+               {
+                  throw fail();
+               }
+
+               more = *input++;
+               length += more;
+            } while ( more == 255 );
+         }
+
+         return length;
+      };
+
+      while ( input < inputEnd )
+      {
+         const uint8_t cToken = *input++;
+         const size_t cLiteralLength = getLength( cToken >> 4 );
+
+         if ( ( cLiteralLength > static_cast<size_t>( inputEnd - input ) ) ||
+              ( cLiteralLength > outSize - produced ) )
+         {
+            throw fail();
+         }
+
+         memcpy( out + produced, input, cLiteralLength );
+         input += cLiteralLength;
+         produced += cLiteralLength;
+
+         // The last sequence has no match
+         if ( input == inputEnd )
+         {
+            break;
+         }
+
+         if ( inputEnd - input < 2 )
+         {
+            throw fail();
+         }
+
+         const size_t cOffset = input[0] | ( static_cast<size_t>( input[1] ) << 8 );
+         input += 2;
+
+         const size_t cMatchLength = getLength( cToken & 0x0f ) + 4;
+
+         if ( ( cOffset == 0 ) || ( cOffset > produced ) || ( cMatchLength > outSize - produced ) )
+         {
+            throw fail();
+         }
+
+         // The match may overlap the bytes it produces
+         for ( size_t i = 0; i < cMatchLength; ++i, ++produced )
+         {
+            out[produced] = out[produced - cOffset];
+         }
+      }
+
+      if ( produced != outSize )
+      {
+         throw fail();
+      }
+   }
+
+   Codec findCodec( const CompressedVectorNodeImpl &cVector, const ustring &pathName )
+   {
+      std::shared_ptr<VectorNodeImpl> codecs = cVector.getCodecs();
+      ustring prefix;
+
+      if ( !codecs || !codecs->destImageFile()->extensionsLookupUri( cCodecsUri, prefix ) )
+      {
+         return Codec::BitPack;
+      }
+
+      const ustring cPath = relativePath( pathName );
+      const ustring cDeltaName = prefix + ":" + cDeltaIntegerCodecElement;
+      const ustring cLzName = prefix + ":" + cLzCodecElement;
+
+      for ( int64_t i = 0; i < codecs->childCount(); ++i )
+      {
+         NodeImplSharedPtr codec = codecs->get( i );
+
+         if ( hasInput( codec, cPath ) )
+         {
+            if ( codec->isDefined( cDeltaName ) )
+            {
+               return Codec::DeltaInteger;
+            }
+
+            return codec->isDefined( cLzName ) ? Codec::Lz : Codec::BitPack;
+         }
+      }
+
+      return Codec::BitPack;
+   }
+
+   bool addCodec( CompressedVectorNodeImpl &cVector, const ustring &pathName, Codec codec )
+   {
+      std::shared_ptr<VectorNodeImpl> codecs = cVector.getCodecs();
+      ImageFileImplSharedPtr imf( cVector.destImageFile() );
+
+      if ( !codecs || ( codec == Codec::BitPack ) )
+      {
+         return false;
+      }
+
+      ustring prefix;
+
+      if ( !imf->extensionsLookupUri( cCodecsUri, prefix ) )
+      {
+         prefix = cCodecsPrefix;
+
+         ustring uri;
+
+         if ( imf->extensionsLookupPrefix( prefix, uri ) )
+         {
+            return false;
+         }
+
+         imf->extensionsAdd( prefix, cCodecsUri );
+      }
+
+      //    codecs/<n>/inputs/0                   the path name of the field
+      //    codecs/<n>/<prefix>:deltaIntegerCodec an empty structure (or <prefix>:lzCodec)
+      std::shared_ptr<StructureNodeImpl> entry( new StructureNodeImpl( imf ) );
+      std::shared_ptr<VectorNodeImpl> inputs( new VectorNodeImpl( imf, false ) );
+
+      inputs->append( NodeImplSharedPtr( new StringNodeImpl( imf, relativePath( pathName ) ) ) );
+
+      const char *cElement =
+         ( codec == Codec::DeltaInteger ) ? cDeltaIntegerCodecElement : cLzCodecElement;
+
+      entry->set( "inputs", inputs );
+      entry->set( prefix + ":" + cElement,
+                  NodeImplSharedPtr( new StructureNodeImpl( imf ) ) );
+
+      codecs->append( entry );
+
+      return true;
+   }
+}
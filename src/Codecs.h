@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "Common.h"
+
+namespace e57
+{
+   /// URI of the extension which defines the codecs of this library beside bitPackCodec
+   constexpr char cCodecsUri[] = "https://github.com/asmaloney/libE57Format/E57_EXT_codecs";
+
+   /// Prefix used for the extension if the file doesn't already declare one for it
+   constexpr char cCodecsPrefix[] = "libe57codec";
+
+   /// Name of the element of a codec (in the codecs of a compressed vector) which selects the
+   /// delta codec for its inputs
+   constexpr char cDeltaIntegerCodecElement[] = "deltaIntegerCodec";
+
+   /// Name of the element of a codec which selects the LZ codec for its inputs
+   constexpr char cLzCodecElement[] = "lzCodec";
+
+   /// Number of records in each block of the delta codec. Chunks of records start on a multiple
+   /// of this, so each chunk starts with a new block.
+   constexpr unsigned cDeltaBlockRecordCount = 64;
+
+   /// Codecs the bytestream of a field may be encoded with
+   enum class Codec
+   {
+      BitPack,     ///< bitPackCodec of the standard, used by fields which aren't in any codec
+      DeltaInteger, ///< zigzag deltas of consecutive records, bit-packed per block
+      Lz            ///< the bitPackCodec bytestream, compressed a block at a time
+   };
+
+   /// Largest encoded size of a block of the delta codec for a field of @a fieldBits bits
+   size_t deltaBlockMaxSize( unsigned fieldBits );
+
+   /// Encoded size of a block of @a count records of the delta codec for a field of @a fieldBits
+   /// bits, whose first byte is @a header.
+   size_t deltaBlockSize( uint8_t header, unsigned fieldBits, size_t count );
+
+   /// Encode a block of @a count (1 to cDeltaBlockRecordCount) raw values of a field of
+   /// @a fieldBits bits whose minimum is @a minimum into @a out, and return its size. The block
+   /// is a byte with the width w of the deltas, then (least significant bits first) the first
+   /// value less the minimum in fieldBits bits and the zigzag encoded difference of each other
+   /// value with the one before it in w bits, padded to a whole byte.
+   size_t deltaBlockEncode( const int64_t *values, size_t count, int64_t minimum,
+                            unsigned fieldBits, char *out );
+
+   /// Decode a block of @a count records written by deltaBlockEncode() from @a in.
+   void deltaBlockDecode( const char *in, size_t count, int64_t minimum, unsigned fieldBits,
+                          int64_t *values );
+
+   /// Largest number of bytes of the bitPackCodec bytestream in each block of the LZ codec
+   constexpr size_t cLzBlockMaxRawSize = 16384;
+
+   /// Size of the header of each block of the LZ codec: the number of bytes of the bytestream in
+   /// the block and the number of bytes which follow the header, both as 16 bit little endian
+   /// integers. The bytes are stored as they are when they are the same number.
+   constexpr size_t cLzBlockHeaderSize = 4;
+
+   /// Largest compressed size of @a size bytes with lzCompress()
+   size_t lzMaxCompressedSize( size_t size );
+
+   /// Compress the @a size bytes of @a in into @a out (which has room for lzMaxCompressedSize()
+   /// bytes) and return the compressed size. The format is that of LZ4 blocks: sequences of a
+   /// token (the literal length & the match length less 4 in a nibble each, extended by bytes
+   /// of 255), the literals, and a 16 bit offset to the match, the last sequence having no match.
+   size_t lzCompress( const char *in, size_t size, char *out );
+
+   /// Decompress @a size bytes written by lzCompress() from @a in into the @a outSize bytes of
+   /// @a out, throwing ErrorBadCVPacket if they are not exactly that.
+   void lzDecompress( const char *in, size_t size, char *out, size_t outSize );
+
+   /// The codec of the field @a pathName of @a cVector, from its codecs.
+   Codec findCodec( const CompressedVectorNodeImpl &cVector, const ustring &pathName );
+
+   /// Add a codec using @a codec for the field @a pathName to the codecs of @a cVector, declaring
+   /// the extension in its file. Returns false (and adds nothing) if the file uses the prefix of
+   /// the extension for something else.
+   bool addCodec( CompressedVectorNodeImpl &cVector, const ustring &pathName, Codec codec );
+}
@@ -31,6 +31,7 @@
 /// @file CompressedVectorNode.cpp
 
 #include "CompressedVectorNodeImpl.h"
+#include "Parallel.h"
 #include "StringFunctions.h"
 
 using namespace e57;
@@ -443,6 +444,35 @@ CompressedVectorWriter CompressedVectorNode::writer( std::vector<SourceDestBuffe
    return CompressedVectorWriter( impl_->writer( sbufs ) );
 }
 
+/*!
+@brief Create an iterator object for writing a series of blocks of data to a CompressedVectorNode,
+with the given encoding settings.
+
+@param [in] sbufs Vector of memory buffers that hold data to be written to a CompressedVectorNode.
+@param [in] options How to encode the data.
+
+@details
+This is the same as writer( std::vector<SourceDestBuffer> & ) except for the encoding. With more
+than one encoding thread (or an executor), each field of the prototype is encoded on its own task
+and only the assembly of the packets stays on the calling thread. The packet boundaries may differ
+from those written by a single thread, but the records are the same.
+
+With CompressedVectorWriterOptions::concurrent set, the writer may be open at the same time as other
+concurrent writers of the same ImageFile, for other CompressedVectorNodes. Each of them may be used
+from a different thread.
+
+@throw ::ErrorTooManyWriters if a writer is open which isn't a concurrent one, or this writer isn't
+concurrent and another writer is open.
+
+@see CompressedVectorNode::writer( std::vector<SourceDestBuffer> & ),
+CompressedVectorWriterOptions
+*/
+CompressedVectorWriter CompressedVectorNode::writer( std::vector<SourceDestBuffer> &sbufs,
+                                                     const CompressedVectorWriterOptions &options )
+{
+   return CompressedVectorWriter( impl_->writer( sbufs, options ) );
+}
+
 /*!
 @brief Create an iterator object for reading a series of blocks of data from a CompressedVectorNode.
 
@@ -457,6 +487,9 @@ prototype. It is not an error to create a CompressedVectorReader for an empty Co
 @pre @a dbufs can't be empty
 @pre The destination ImageFile must be open (i.e. destImageFile().isOpen()).
 @pre The destination ImageFile can't have any writers open (destImageFile().writerCount()==0)
+@pre If the destination ImageFile was opened in write mode, it can't have any readers open
+(destImageFile().readerCount()==0). Files opened for reading may have several readers open at once,
+and each of them may be used from a different thread.
 @pre This CompressedVectorNode must be attached (i.e. isAttached()).
 
 @return A smart CompressedVectorReader handle referencing the underlying iterator object.
@@ -464,6 +497,7 @@ prototype. It is not an error to create a CompressedVectorReader for an empty Co
 @throw ::ErrorBadAPIArgument
 @throw ::ErrorImageFileNotOpen
 @throw ::ErrorTooManyWriters
+@throw ::ErrorTooManyReaders
 @throw ::ErrorNodeUnattached
 @throw ::ErrorPathUndefined
 @throw ::ErrorBufferSizeMismatch
@@ -478,3 +512,150 @@ CompressedVectorReader CompressedVectorNode::reader( const std::vector<SourceDes
 {
    return CompressedVectorReader( impl_->reader( dbufs ) );
 }
+
+/*!
+@brief Create an iterator object for reading a series of blocks of data from a CompressedVectorNode,
+with the given packet cache settings.
+
+@param [in] dbufs Vector of memory buffers that will receive data read from a CompressedVectorNode.
+@param [in] cacheOptions Size, replacement policy, and read-ahead of the reader's packet cache.
+
+@details
+This is the same as reader( const std::vector<SourceDestBuffer> & ) except for the packet cache.
+Each packet in the cache uses up to 64 KB. A larger cache helps when the bytestreams of the
+prototype are spread unevenly over the packets, so that a packet would otherwise be read more than
+once.
+
+@throw ::ErrorBadAPIArgument if @a cacheOptions has a packetCount of 0.
+
+@see CompressedVectorNode::reader( const std::vector<SourceDestBuffer> & ), PacketCacheOptions
+*/
+CompressedVectorReader CompressedVectorNode::reader( const std::vector<SourceDestBuffer> &dbufs,
+                                                     const PacketCacheOptions &cacheOptions )
+{
+   return CompressedVectorReader( impl_->reader( dbufs, cacheOptions ) );
+}
+
+/*!
+@brief Read all the records of a CompressedVectorNode using several threads.
+
+@param [in] dbufs Vector of memory buffers that will receive the records. Each must have a capacity
+of at least childCount() records.
+@param [in] threadCount Maximum number of threads to use. 0 means use
+std::thread::hardware_concurrency().
+@param [in] executor Optional function used to run the tasks instead of creating threads.
+
+@details
+The index written with the binary section of the CompressedVectorNode is used to split the records
+into chunks which are decoded concurrently, each directly into its own part of the @a dbufs. If the
+file does not have a suitable index (such as files written by older versions of this library), if
+any of the @a dbufs are string buffers, or if the ImageFile was opened in write mode then the
+records are read by a single reader.
+
+@pre @a dbufs can't be empty
+@pre The destination ImageFile must be open (i.e. destImageFile().isOpen()).
+@pre The destination ImageFile can't have any writers open (destImageFile().writerCount()==0)
+@pre This CompressedVectorNode must be attached (i.e. isAttached()).
+
+@return The number of records read.
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorTooManyWriters
+@throw ::ErrorTooManyReaders
+@throw ::ErrorNodeUnattached
+@throw ::ErrorPathUndefined
+@throw ::ErrorBufferSizeMismatch
+@throw ::ErrorBufferDuplicatePathName
+@throw ::ErrorBadCVHeader
+@throw ::ErrorBadCVPacket
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompressedVectorNode::reader, SourceDestBuffer, TaskExecutor
+*/
+uint64_t CompressedVectorNode::readParallel( const std::vector<SourceDestBuffer> &dbufs,
+                                             unsigned threadCount, const TaskExecutor &executor )
+{
+   std::atomic<uint64_t> recordCount( 0 );
+   std::vector<Task> tasks;
+
+   impl_->parallelReadTasks( dbufs, resolveThreadCount( threadCount ), recordCount, tasks );
+
+   runTasks( tasks, threadCount, executor );
+
+   return recordCount;
+}
+
+/*!
+@brief Copy this CompressedVectorNode, including its records, to another ImageFile without decoding
+them.
+
+@param [in] destImageFile The ImageFile where the copy will be stored.
+
+@details
+The binary section of the records is copied a block at a time. Only the file offsets in the section
+header and the index packets are changed, so none of the records are decoded or encoded again and
+the copy has the same packets, chunks and index as this node. The prototype and codecs are copied
+as new nodes of the @a destImageFile. Any extensions used by their element names which aren't
+declared in the @a destImageFile are declared with the URIs they have in this node's ImageFile.
+
+The copy isn't attached to anything. As for a new CompressedVectorNode, it should be added
+underneath the root of the @a destImageFile (usually in place of the "points" of a Data3D
+structure, which must be copied separately); otherwise its section is left unused in the file.
+Nodes which are stored beside this one, such as its chunk statistics, aren't copied.
+
+@pre This node's ImageFile must be open (i.e. destImageFile().isOpen()).
+@pre This node's records must have been written (i.e. it was read from a file, or its writer was
+closed).
+@pre The @a destImageFile must be open and have been opened in write mode (i.e.
+destImageFile.isOpen() && destImageFile.isWritable()).
+@pre The @a destImageFile can't have any writers open (destImageFile.writerCount()==0).
+
+@return A smart CompressedVectorNode handle referencing the new node.
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorFileReadOnly
+@throw ::ErrorTooManyWriters
+@throw ::ErrorBadCVHeader
+@throw ::ErrorBadCVPacket
+@throw ::ErrorBadChecksum
+@throw ::ErrorReadFailed
+@throw ::ErrorWriteFailed
+@throw ::ErrorSeekFailed
+@throw ::ErrorNotImplemented The codecs contain a BlobNode or CompressedVectorNode.
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompressedVectorNode::CompressedVectorNode, ImageFile::root
+*/
+CompressedVectorNode CompressedVectorNode::copyTo( const ImageFile &destImageFile ) const
+{
+   return CompressedVectorNode( impl_->copyTo( destImageFile.impl() ) );
+}
+
+/*!
+@brief Read the index of the records of this CompressedVectorNode, without reading the records.
+
+@details
+The index written with the binary section divides the records into chunks, each starting at a data
+packet where decoding may begin. Only the index packets (and the header of the packet each chunk
+starts in, to check it) are read. How finely the records are divided is set when they are written
+(see CompressedVectorWriterOptions::indexPacketInterval). A file without a usable index (such as one
+written by another library) gives a single chunk of all the records.
+
+@pre The destination ImageFile must be open (i.e. destImageFile().isOpen()).
+@pre The records must have been written (i.e. a writer of this node was closed, or the file was
+opened for reading).
+
+@return The chunks, in order of their first record.
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorBadCVHeader
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompressedVectorNode::readParallel, CompressedVectorReader::seek
+*/
+std::vector<CompressedVectorChunk> CompressedVectorNode::readIndex() const
+{
+   return impl_->readIndex();
+}
@@ -25,20 +25,211 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+
 #include "CompressedVectorNodeImpl.h"
 #include "CheckedFile.h"
 #include "CompressedVectorReaderImpl.h"
 #include "CompressedVectorWriterImpl.h"
+#include "FloatNodeImpl.h"
 #include "ImageFileImpl.h"
+#include "IntegerNodeImpl.h"
+#include "ScaledIntegerNodeImpl.h"
+#include "SectionHeaders.h"
+#include "SourceDestBufferImpl.h"
 #include "StringFunctions.h"
+#include "StringNodeImpl.h"
 #include "VectorNodeImpl.h"
 
+namespace
+{
+   using namespace e57;
+
+   // Append the level 0 entries of the index packet at @a logicalOffset to @a entries, following
+   // the entries of higher level packets down the tree. The logical offset of every packet of the
+   // tree is added to @a packetOffsets, if given.
+   void readIndexEntries( CheckedFile *file, uint64_t logicalOffset, unsigned maxLevel,
+                          std::vector<IndexPacket::Entry> &entries,
+                          std::vector<uint64_t> *packetOffsets = nullptr )
+   {
+      std::unique_ptr<IndexPacket> packet( new IndexPacket );
+
+      if ( logicalOffset + sizeof( IndexPacketHeader ) > file->length( CheckedFile::Logical ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket, "logicalOffset=" + toString( logicalOffset ) );
+      }
+
+      file->readAt( logicalOffset, reinterpret_cast<char *>( &packet->header ),
+                    sizeof( IndexPacketHeader ) );
+
+      const unsigned packetLength = packet->header.packetLogicalLengthMinus1 + 1;
+
+      if ( ( packetLength > sizeof( IndexPacket ) ) ||
+           ( logicalOffset + packetLength > file->length( CheckedFile::Logical ) ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket, "packetLength=" + toString( packetLength ) );
+      }
+
+      file->readAt( logicalOffset, reinterpret_cast<char *>( packet.get() ), packetLength );
+
+      packet->verify( packetLength );
+
+      if ( packetOffsets != nullptr )
+      {
+         packetOffsets->push_back( logicalOffset );
+      }
+
+      const auto &header = packet->header;
+
+      if ( ( header.indexLevel > maxLevel ) ||
+           ( sizeof( IndexPacketHeader ) + header.entryCount * sizeof( IndexPacket::Entry ) >
+             packetLength ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket,
+                               "indexLevel=" + toString( header.indexLevel ) +
+                                  " entryCount=" + toString( header.entryCount ) );
+      }
+
+      for ( unsigned i = 0; i < header.entryCount; ++i )
+      {
+         const auto &entry = packet->entries[i];
+
+         if ( header.indexLevel == 0 )
+         {
+            entries.push_back( entry );
+         }
+         else
+         {
+            readIndexEntries( file, file->physicalToLogical( entry.chunkPhysicalOffset ),
+                              header.indexLevel - 1u, entries, packetOffsets );
+         }
+      }
+   }
+
+   // Size of the blocks a binary section is copied in by CompressedVectorNodeImpl::copyTo()
+   constexpr size_t cCopyBlockSize = 256 * CheckedFile::logicalPageSize;
+
+   // Declare the extension of @a elementName in @a dest, with the URI it has in @a source, if
+   // @a dest doesn't have its prefix yet.
+   void copyExtension( const ustring &elementName, const ImageFileImplSharedPtr &source,
+                       const ImageFileImplSharedPtr &dest )
+   {
+      ustring prefix;
+      ustring localPart;
+      ustring uri;
+
+      ImageFileImpl::elementNameParse( elementName, prefix, localPart );
+
+      if ( prefix.empty() || dest->extensionsLookupPrefix( prefix, uri ) )
+      {
+         return;
+      }
+
+      if ( !source->extensionsLookupPrefix( prefix, uri ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadPathName,
+                               "elementName=" + elementName + " prefix=" + prefix );
+      }
+
+      dest->extensionsAdd( prefix, uri );
+   }
+}
+
 namespace e57
 {
+   NodeImplSharedPtr copyTree( const NodeImplSharedPtr &node, const ImageFileImplSharedPtr &source,
+                               const ImageFileImplSharedPtr &dest, const NodeCopier &copier )
+   {
+      if ( copier )
+      {
+         if ( NodeImplSharedPtr copy = copier( node ) )
+         {
+            return copy;
+         }
+      }
+
+      switch ( node->type() )
+      {
+         case TypeStructure:
+         case TypeVector:
+         {
+            auto structure = std::static_pointer_cast<StructureNodeImpl>( node );
+
+            std::shared_ptr<StructureNodeImpl> copy;
+
+            if ( node->type() == TypeVector )
+            {
+               copy = std::make_shared<VectorNodeImpl>(
+                  dest, std::static_pointer_cast<VectorNodeImpl>( node )->allowHeteroChildren() );
+            }
+            else
+            {
+               copy = std::make_shared<StructureNodeImpl>( dest );
+            }
+
+            const int64_t cChildCount = structure->childCount();
+
+            for ( int64_t i = 0; i < cChildCount; ++i )
+            {
+               const NodeImplSharedPtr cChild = structure->get( i );
+
+               if ( node->type() == TypeVector )
+               {
+                  copy->append( copyTree( cChild, source, dest, copier ) );
+               }
+               else
+               {
+                  copyExtension( cChild->elementName(), source, dest );
+
+                  copy->set( cChild->elementName(), copyTree( cChild, source, dest, copier ) );
+               }
+            }
+
+            return copy;
+         }
+
+         case TypeInteger:
+         {
+            auto integer = std::static_pointer_cast<IntegerNodeImpl>( node );
+
+            return std::make_shared<IntegerNodeImpl>( dest, integer->value(), integer->minimum(),
+                                                      integer->maximum() );
+         }
+
+         case TypeScaledInteger:
+         {
+            auto scaled = std::static_pointer_cast<ScaledIntegerNodeImpl>( node );
+
+            return std::make_shared<ScaledIntegerNodeImpl>( dest, scaled->rawValue(),
+                                                            scaled->minimum(), scaled->maximum(),
+                                                            scaled->scale(), scaled->offset() );
+         }
+
+         case TypeFloat:
+         {
+            auto floating = std::static_pointer_cast<FloatNodeImpl>( node );
+
+            return std::make_shared<FloatNodeImpl>( dest, floating->value(), floating->precision(),
+                                                    floating->minimum(), floating->maximum() );
+         }
+
+         case TypeString:
+            return std::make_shared<StringNodeImpl>(
+               dest, std::static_pointer_cast<StringNodeImpl>( node )->value() );
+
+         default:
+            // Blobs & compressed vectors have binary sections of their own
+            throw E57_EXCEPTION2( ErrorNotImplemented, "pathName=" + node->pathName() +
+                                                          " type=" + toString( node->type() ) );
+      }
+   }
+
    CompressedVectorNodeImpl::CompressedVectorNodeImpl( ImageFileImplWeakPtr destImageFile ) :
       NodeImpl( destImageFile )
    {
       // don't checkImageFileOpen, NodeImpl() will do it
+
+      memory_.set( Memory::Nodes, sizeof( *this ) );
    }
 
    void CompressedVectorNodeImpl::setPrototype( const NodeImplSharedPtr &prototype )
@@ -266,14 +457,18 @@ namespace e57
 #endif
 
    std::shared_ptr<CompressedVectorWriterImpl> CompressedVectorNodeImpl::writer(
-      std::vector<SourceDestBuffer> sbufs )
+      std::vector<SourceDestBuffer> sbufs, const CompressedVectorWriterOptions &options )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
       ImageFileImplSharedPtr destImageFile( destImageFile_ );
 
-      // Check don't have any writers/readers open for this ImageFile
-      if ( destImageFile->writerCount() > 0 )
+      // Check don't have any writers/readers open for this ImageFile. Concurrent writers may only
+      // be open with each other.
+      const int cOtherWriters = destImageFile->writerCount() -
+                                ( options.concurrent ? destImageFile->concurrentWriterCount() : 0 );
+
+      if ( cOtherWriters > 0 )
       {
          throw E57_EXCEPTION2( ErrorTooManyWriters,
                                "fileName=" + destImageFile->fileName() +
@@ -313,12 +508,12 @@ namespace e57
 
       // Return a shared_ptr to new object
       std::shared_ptr<CompressedVectorWriterImpl> cvwi(
-         new CompressedVectorWriterImpl( cai, sbufs ) );
+         new CompressedVectorWriterImpl( cai, sbufs, options ) );
       return ( cvwi );
    }
 
    std::shared_ptr<CompressedVectorReaderImpl> CompressedVectorNodeImpl::reader(
-      std::vector<SourceDestBuffer> dbufs )
+      std::vector<SourceDestBuffer> dbufs, const PacketCacheOptions &cacheOptions )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
@@ -332,7 +527,10 @@ namespace e57
                                   " writerCount=" + toString( destImageFile->writerCount() ) +
                                   " readerCount=" + toString( destImageFile->readerCount() ) );
       }
-      if ( destImageFile->readerCount() > 0 )
+
+      // Readers of a read-only file only use positional reads and their own packet caches, so
+      // several of them may be open (and used from different threads) at once.
+      if ( destImageFile->isWriter() && ( destImageFile->readerCount() > 0 ) )
       {
          throw E57_EXCEPTION2( ErrorTooManyReaders,
                                "fileName=" + destImageFile->fileName() +
@@ -368,7 +566,389 @@ namespace e57
 #endif
       // Return a shared_ptr to new object
       std::shared_ptr<CompressedVectorReaderImpl> cvri(
-         new CompressedVectorReaderImpl( cai, dbufs ) );
+         new CompressedVectorReaderImpl( cai, dbufs, cacheOptions ) );
       return ( cvri );
    }
+
+   std::vector<ChunkIndexEntry> CompressedVectorNodeImpl::readChunkIndex() const
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      ImageFileImplSharedPtr imf( destImageFile_ );
+      CheckedFile *file = imf->file();
+
+      if ( binarySectionLogicalStart_ == 0 )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "imageFileName=" + imageFileName() +
+                                                 " cvPathName=" + pathName() );
+      }
+
+      CompressedVectorSectionHeader sectionHeader;
+      file->readAt( binarySectionLogicalStart_, reinterpret_cast<char *>( &sectionHeader ),
+                    sizeof( sectionHeader ) );
+
+#if VALIDATE_BASIC
+      sectionHeader.verify( file->length( CheckedFile::Physical ) );
+#endif
+
+      const uint64_t sectionEndLogicalOffset =
+         binarySectionLogicalStart_ + sectionHeader.sectionLogicalLength;
+
+      ChunkIndexEntry firstChunk;
+      firstChunk.packetLogicalOffset = file->physicalToLogical( sectionHeader.dataPhysicalOffset );
+
+      std::vector<ChunkIndexEntry> chunks{ firstChunk };
+
+      if ( ( sectionHeader.indexPhysicalOffset == 0 ) || ( recordCount_ <= 0 ) )
+      {
+         return chunks;
+      }
+
+      std::vector<IndexPacket::Entry> entries;
+
+      try
+      {
+         readIndexEntries( file, file->physicalToLogical( sectionHeader.indexPhysicalOffset ), 5,
+                           entries );
+      }
+      catch ( const E57Exception &ex )
+      {
+         // A damaged index stops us using it, but the records can still be read in order.
+         if ( ex.errorCode() != ErrorBadCVPacket )
+         {
+            throw;
+         }
+
+         return { firstChunk };
+      }
+
+      for ( const auto &entry : entries )
+      {
+         if ( entry.chunkRecordNumber == 0 )
+         {
+            continue;
+         }
+
+         const uint64_t packetLogicalOffset = file->physicalToLogical( entry.chunkPhysicalOffset );
+
+         // Ignore an index which isn't in order or points outside the section.
+         if ( ( entry.chunkRecordNumber <= chunks.back().recordNumber ) ||
+              ( entry.chunkRecordNumber >= static_cast<uint64_t>( recordCount_ ) ) ||
+              ( packetLogicalOffset <= chunks.back().packetLogicalOffset ) ||
+              ( packetLogicalOffset + sizeof( DataPacketHeader ) > sectionEndLogicalOffset ) )
+         {
+            return { firstChunk };
+         }
+
+         // Other writers may not restart the bytestreams at each indexed packet, so only use the
+         // index if the packet says they were.
+         DataPacketHeader header;
+         file->readAt( packetLogicalOffset, reinterpret_cast<char *>( &header ), sizeof( header ) );
+
+         if ( ( header.packetType != DATA_PACKET ) ||
+              ( ( header.packetFlags & DATA_PACKET_FLAG_COMPRESSOR_RESTART ) == 0 ) )
+         {
+            return { firstChunk };
+         }
+
+         ChunkIndexEntry chunk;
+         chunk.recordNumber = entry.chunkRecordNumber;
+         chunk.packetLogicalOffset = packetLogicalOffset;
+
+         chunks.push_back( chunk );
+      }
+
+      return chunks;
+   }
+
+   std::vector<CompressedVectorChunk> CompressedVectorNodeImpl::readIndex() const
+   {
+      const std::vector<ChunkIndexEntry> cChunks = readChunkIndex();
+      const auto cRecordCount = static_cast<uint64_t>( std::max<int64_t>( recordCount_, 0 ) );
+
+      std::vector<CompressedVectorChunk> chunks( cChunks.size() );
+
+      for ( size_t i = 0; i < cChunks.size(); ++i )
+      {
+         const uint64_t cEnd =
+            ( i + 1 < cChunks.size() ) ? cChunks[i + 1].recordNumber : cRecordCount;
+
+         chunks[i].firstRecord = cChunks[i].recordNumber;
+         chunks[i].recordCount = cEnd - cChunks[i].recordNumber;
+         chunks[i].physicalOffset =
+            CheckedFile::logicalToPhysical( cChunks[i].packetLogicalOffset );
+      }
+
+      return chunks;
+   }
+
+   void CompressedVectorNodeImpl::parallelReadTasks( const std::vector<SourceDestBuffer> &dbufs,
+                                                     size_t maxTasks,
+                                                     std::atomic<uint64_t> &recordCount,
+                                                     std::vector<Task> &tasks )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      ImageFileImplSharedPtr destImageFile( destImageFile_ );
+
+      const auto cRecordCount = static_cast<uint64_t>( recordCount_ );
+
+      // Files being written can only have one reader at a time.
+      bool canSplit = ( maxTasks > 1 ) && !destImageFile->isWriter() && ( cRecordCount > 0 );
+
+      // Each task writes straight into its part of the buffers, so they must hold all the records.
+      for ( const auto &dbuf : dbufs )
+      {
+         if ( dbuf.capacity() < cRecordCount )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                  "pathName=" + dbuf.pathName() +
+                                     " capacity=" + toString( dbuf.capacity() ) +
+                                     " recordCount=" + toString( cRecordCount ) );
+         }
+
+         // String buffers can't be split.
+         if ( dbuf.memoryRepresentation() == UString )
+         {
+            canSplit = false;
+         }
+      }
+
+      std::vector<ChunkIndexEntry> chunks;
+      std::vector<size_t> groupStarts; // index into chunks of the first chunk of each task
+
+      if ( canSplit )
+      {
+         chunks = readChunkIndex();
+
+         // Split at the chunks closest to giving each task the same number of records.
+         groupStarts.push_back( 0 );
+
+         for ( size_t i = 1; i < maxTasks; ++i )
+         {
+            const uint64_t cTargetRecord = cRecordCount / maxTasks * i;
+
+            const auto cChunk = std::lower_bound(
+               chunks.begin(), chunks.end(), cTargetRecord,
+               []( const ChunkIndexEntry &chunk, uint64_t record ) {
+                  return chunk.recordNumber < record;
+               } );
+
+            const auto cChunkIndex = static_cast<size_t>( cChunk - chunks.begin() );
+
+            if ( ( cChunkIndex < chunks.size() ) && ( cChunkIndex > groupStarts.back() ) )
+            {
+               groupStarts.push_back( cChunkIndex );
+            }
+         }
+      }
+
+      // Not splitting, so read everything with one reader.
+      if ( groupStarts.size() < 2 )
+      {
+         std::shared_ptr<CompressedVectorReaderImpl> cvri = reader( dbufs );
+
+         tasks.emplace_back( [cvri, &recordCount]() {
+            recordCount += cvri->read();
+            cvri->close();
+         } );
+
+         return;
+      }
+
+      for ( size_t group = 0; group < groupStarts.size(); ++group )
+      {
+         const ChunkIndexEntry cChunk = chunks[groupStarts[group]];
+
+         const uint64_t cEndRecord = ( group + 1 < groupStarts.size() )
+                                        ? chunks[groupStarts[group + 1]].recordNumber
+                                        : cRecordCount;
+         const uint64_t cGroupRecordCount = cEndRecord - cChunk.recordNumber;
+
+         std::vector<SourceDestBuffer> groupBuffers;
+         groupBuffers.reserve( dbufs.size() );
+
+         for ( const auto &dbuf : dbufs )
+         {
+            groupBuffers.push_back( SourceDestBuffer( dbuf.impl()->slice(
+               static_cast<size_t>( cChunk.recordNumber ),
+               static_cast<size_t>( cGroupRecordCount ) ) ) );
+         }
+
+         std::shared_ptr<CompressedVectorReaderImpl> cvri = reader( groupBuffers );
+
+         tasks.emplace_back( [cvri, cChunk, cGroupRecordCount, &recordCount]() {
+            cvri->startChunk( cChunk );
+
+            const uint64_t cRead = cvri->read();
+
+            cvri->close();
+
+            if ( cRead != cGroupRecordCount )
+            {
+               throw E57_EXCEPTION2( ErrorInternal,
+                                     "recordsRead=" + toString( cRead ) +
+                                        " expected=" + toString( cGroupRecordCount ) );
+            }
+
+            recordCount += cRead;
+         } );
+      }
+   }
+
+   std::shared_ptr<CompressedVectorNodeImpl> CompressedVectorNodeImpl::copyTo(
+      const ImageFileImplSharedPtr &destImageFile, const SectionReader &readSection ) const
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      ImageFileImplSharedPtr sourceImageFile( destImageFile_ );
+
+      if ( !destImageFile->isOpen() )
+      {
+         throw E57_EXCEPTION2( ErrorImageFileNotOpen, "fileName=" + destImageFile->fileName() );
+      }
+
+      if ( !destImageFile->isWriter() )
+      {
+         throw E57_EXCEPTION2( ErrorFileReadOnly, "fileName=" + destImageFile->fileName() );
+      }
+
+      // The section is added at the end of the file, where an open writer would be adding its own
+      if ( destImageFile->writerCount() > 0 )
+      {
+         throw E57_EXCEPTION2( ErrorTooManyWriters,
+                               "fileName=" + destImageFile->fileName() +
+                                  " writerCount=" + toString( destImageFile->writerCount() ) );
+      }
+
+      // Nothing was written to this node yet
+      if ( binarySectionLogicalStart_ == 0 )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "imageFileName=" + imageFileName() +
+                                                       " cvPathName=" + pathName() );
+      }
+
+      CheckedFile *source = sourceImageFile->file();
+
+      CompressedVectorSectionHeader sectionHeader;
+      source->readAt( binarySectionLogicalStart_, reinterpret_cast<char *>( &sectionHeader ),
+                      sizeof( sectionHeader ) );
+
+      sectionHeader.verify( source->length( CheckedFile::Physical ) );
+
+      const uint64_t cSectionLength = sectionHeader.sectionLogicalLength;
+      const uint64_t cSectionEnd = binarySectionLogicalStart_ + cSectionLength;
+
+      // Find the index packets, which are the only packets holding file offsets
+      std::vector<uint64_t> indexPacketOffsets;
+
+      if ( sectionHeader.indexPhysicalOffset != 0 )
+      {
+         std::vector<IndexPacket::Entry> entries;
+
+         readIndexEntries( source, source->physicalToLogical( sectionHeader.indexPhysicalOffset ),
+                           5, entries, &indexPacketOffsets );
+      }
+
+      for ( const uint64_t cOffset : indexPacketOffsets )
+      {
+         if ( ( cOffset < binarySectionLogicalStart_ + sizeof( sectionHeader ) ) ||
+              ( cOffset + sizeof( IndexPacketHeader ) > cSectionEnd ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadCVPacket, "indexLogicalOffset=" + toString( cOffset ) +
+                                                       " sectionEnd=" + toString( cSectionEnd ) );
+         }
+      }
+
+      // Copy the prototype & codecs before anything is written, in case they can't be
+      std::shared_ptr<CompressedVectorNodeImpl> copy(
+         new CompressedVectorNodeImpl( destImageFile ) );
+
+      copy->setPrototype( copyTree( prototype_, sourceImageFile, destImageFile ) );
+      copy->setCodecs( std::static_pointer_cast<VectorNodeImpl>(
+         copyTree( codecs_, sourceImageFile, destImageFile ) ) );
+
+      destImageFile->finishPacketWrites();
+
+      CheckedFile *dest = destImageFile->file();
+
+      const uint64_t cDestStart = destImageFile->allocateSpace( cSectionLength, false );
+
+      // Offsets are physical, so move them through the logical offsets as the checksums of the
+      // two files may fall in different places within the section.
+      const auto relocate = [&]( uint64_t physicalOffset ) {
+         return dest->logicalToPhysical( source->physicalToLogical( physicalOffset ) -
+                                         binarySectionLogicalStart_ + cDestStart );
+      };
+
+      // The data packets don't hold any offsets, so copy the whole section as it is & then
+      // rewrite the section header & the index packets.
+      std::vector<char> buffer( cCopyBlockSize );
+
+      dest->seek( cDestStart );
+
+      for ( uint64_t copied = 0; copied < cSectionLength; )
+      {
+         const auto cCount =
+            static_cast<size_t>( std::min<uint64_t>( cCopyBlockSize, cSectionLength - copied ) );
+
+         if ( readSection )
+         {
+            readSection( buffer.data(), cCount );
+         }
+         else
+         {
+            source->readAt( binarySectionLogicalStart_ + copied, buffer.data(), cCount );
+         }
+
+         dest->write( buffer.data(), cCount );
+
+         copied += cCount;
+      }
+
+      std::unique_ptr<IndexPacket> packet( new IndexPacket );
+
+      for ( const uint64_t cOffset : indexPacketOffsets )
+      {
+         source->readAt( cOffset, reinterpret_cast<char *>( &packet->header ),
+                         sizeof( IndexPacketHeader ) );
+
+         const unsigned cPacketLength = packet->header.packetLogicalLengthMinus1 + 1;
+
+         // readIndexEntries() checked the packet fits in the file, but not in the section
+         if ( cOffset + cPacketLength > cSectionEnd )
+         {
+            throw E57_EXCEPTION2( ErrorBadCVPacket, "packetLength=" + toString( cPacketLength ) );
+         }
+
+         source->readAt( cOffset, reinterpret_cast<char *>( packet.get() ), cPacketLength );
+
+         for ( unsigned i = 0; i < packet->header.entryCount; ++i )
+         {
+            packet->entries[i].chunkPhysicalOffset =
+               relocate( packet->entries[i].chunkPhysicalOffset );
+         }
+
+         dest->seek( cOffset - binarySectionLogicalStart_ + cDestStart );
+         dest->write( reinterpret_cast<const char *>( packet.get() ), cPacketLength );
+      }
+
+      if ( sectionHeader.dataPhysicalOffset != 0 )
+      {
+         sectionHeader.dataPhysicalOffset = relocate( sectionHeader.dataPhysicalOffset );
+      }
+
+      if ( sectionHeader.indexPhysicalOffset != 0 )
+      {
+         sectionHeader.indexPhysicalOffset = relocate( sectionHeader.indexPhysicalOffset );
+      }
+
+      dest->seek( cDestStart );
+      dest->write( reinterpret_cast<const char *>( &sectionHeader ), sizeof( sectionHeader ) );
+
+      copy->setRecordCount( recordCount_ );
+      copy->setBinarySectionLogicalStart( cDestStart );
+
+      return copy;
+   }
 }
@@ -26,10 +26,26 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <atomic>
+
 #include "NodeImpl.h"
+#include "Packet.h"
+#include "Parallel.h"
 
 namespace e57
 {
+   /// Makes the copy of a node for copyTree(), or returns null to have copyTree() copy it
+   using NodeCopier = std::function<NodeImplSharedPtr( const NodeImplSharedPtr &node )>;
+
+   /// Reads the next @a count bytes of a binary section being copied
+   using SectionReader = std::function<void( char *buffer, size_t count )>;
+
+   /// Copy the tree @a node of @a source into a new root node for @a dest, declaring the
+   /// extensions it uses. Blobs & compressed vectors (which have binary sections of their own)
+   /// must be copied by @a copier.
+   NodeImplSharedPtr copyTree( const NodeImplSharedPtr &node, const ImageFileImplSharedPtr &source,
+                               const ImageFileImplSharedPtr &dest, const NodeCopier &copier = {} );
+
    class CompressedVectorNodeImpl : public NodeImpl
    {
    public:
@@ -58,8 +74,30 @@ namespace e57
                      const char *forcedFieldName = nullptr ) override;
 
       /// Iterator constructors
-      std::shared_ptr<CompressedVectorWriterImpl> writer( std::vector<SourceDestBuffer> sbufs );
-      std::shared_ptr<CompressedVectorReaderImpl> reader( std::vector<SourceDestBuffer> dbufs );
+      std::shared_ptr<CompressedVectorWriterImpl> writer(
+         std::vector<SourceDestBuffer> sbufs, const CompressedVectorWriterOptions &options = {} );
+      std::shared_ptr<CompressedVectorReaderImpl> reader(
+         std::vector<SourceDestBuffer> dbufs, const PacketCacheOptions &cacheOptions = {} );
+
+      /// Read the index of the binary section. The first entry is always the first data packet.
+      std::vector<ChunkIndexEntry> readChunkIndex() const;
+
+      /// The chunks of readChunkIndex(), as given by CompressedVectorNode::readIndex()
+      std::vector<CompressedVectorChunk> readIndex() const;
+
+      /// Create up to @a maxTasks tasks which, between them, read all the records into @a dbufs.
+      /// The records are split at chunk boundaries and each task uses its own reader on its
+      /// part of the buffers. The readers are created here, but the tasks may be run
+      /// concurrently. Each task adds the number of records it read to @a recordCount.
+      void parallelReadTasks( const std::vector<SourceDestBuffer> &dbufs, size_t maxTasks,
+                              std::atomic<uint64_t> &recordCount, std::vector<Task> &tasks );
+
+      /// Create a node for @a destImageFile with a copy of the prototype, codecs & records of this
+      /// one. The binary section is copied without decoding it, only moving the file offsets in
+      /// its header & index packets. If @a readSection is set, the bytes of the section are read
+      /// with it (from the start, in order) instead of from the file.
+      std::shared_ptr<CompressedVectorNodeImpl> copyTo(
+         const ImageFileImplSharedPtr &destImageFile, const SectionReader &readSection = {} ) const;
 
       int64_t getRecordCount() const
       {
@@ -31,6 +31,7 @@
 /// @file CompressedVectorReader.cpp
 
 #include "CompressedVectorReaderImpl.h"
+#include "Parallel.h"
 
 using namespace e57;
 
@@ -254,6 +255,63 @@ unsigned CompressedVectorReader::read( std::vector<SourceDestBuffer> &dbufs )
    return impl_->read( dbufs );
 }
 
+/*!
+@brief Start reading the next block of records into the destination buffers in the background.
+
+@details
+Does the same as CompressedVectorReader::read() on one of the library's background I/O threads
+(kept apart from those of its parallel work) and returns straight away, so the calling thread
+(e.g. that of an event loop) isn't held up by reading & decoding the block.
+
+The reader & its destination buffers belong to the read until the future is ready: don't use them,
+or read from the reader's ImageFile, from other threads in the meantime. The reader is kept alive by
+the read, even if this object is destroyed first.
+
+@return A future which holds the number of records read, or the exception that read() threw.
+
+@throw No E57Exceptions (they are passed on by the future).
+
+@see CompressedVectorReader::readAsync(AsyncReadCompletion)
+*/
+std::future<unsigned> CompressedVectorReader::readAsync()
+{
+   CompressedVectorReader reader( *this );
+
+   return runAsync( [reader]() mutable { return reader.read(); } );
+}
+
+/*!
+@brief Start reading the next block of records into the destination buffers in the background, and
+call @a completion once it's done.
+
+@param [in] completion Called on the thread which did the read with the number of records read, or
+the exception that read() threw.
+
+@details
+The same as CompressedVectorReader::readAsync(), but calls @a completion instead of returning a
+future so neither the caller nor another thread has to wait for it (e.g. to resume a coroutine or
+post an event to a loop).
+
+@throw ::ErrorBadAPIArgument If there's no @a completion.
+
+@see CompressedVectorReader::readAsync()
+*/
+void CompressedVectorReader::readAsync( AsyncReadCompletion completion )
+{
+   if ( !completion )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "completion=empty" );
+   }
+
+   CompressedVectorReader reader( *this );
+   auto recordCount = std::make_shared<unsigned>( 0 );
+
+   runAsync( [reader, recordCount]() mutable { *recordCount = reader.read(); },
+             [completion, recordCount]( std::exception_ptr error ) {
+                completion( *recordCount, error );
+             } );
+}
+
 /*!
 @brief Set record number of CompressedVectorNode where next read will start.
 
@@ -265,6 +323,11 @@ This function may be called at any time (as long as ImageFile and CompressedVect
 The next read will start at the given recordNumber. It is not an error to seek to recordNumber =
 childCount() (i.e. to one record past end of CompressedVectorNode).
 
+If the CompressedVectorNode has an index (see CompressedVectorNode::readParallel), decoding restarts
+at the indexed chunk containing recordNumber. Otherwise it restarts at the first record. Records
+between there and recordNumber are decoded into the start of the buffers and discarded, so the
+contents of the buffers are undefined until the next read.
+
 @pre @a recordNumber <= childCount() of CompressedVectorNode.
 @pre The associated ImageFile must be open.
 @pre This CompressedVectorReader must be open (i.e isOpen())
@@ -338,6 +401,319 @@ CompressedVectorNode CompressedVectorReader::compressedVectorNode() const
    return impl_->compressedVectorNode();
 }
 
+/*!
+@brief Return the number of bytes of data packets which weren't read from the file because they only
+held bytestreams of fields which aren't being read.
+
+@details
+This is only non-zero if the reader was created with PacketCacheOptions::projectedRead and not all
+the fields of the CompressedVectorNode are read. It is not an error if this CompressedVectorReader
+is closed.
+
+@return The number of bytes skipped so far.
+
+@see PacketCacheOptions::projectedRead
+*/
+uint64_t CompressedVectorReader::skippedByteCount() const
+{
+   return impl_->skippedByteCount();
+}
+
+/*!
+@brief Return the packet cache & decoding statistics of this reader so far.
+
+@details
+The bytestreams are in the order of the SourceDestBuffers given to CompressedVectorNode::reader().
+Their decode times include unpacking the values into the buffers. It is not an error if this
+CompressedVectorReader is closed, in which case the statistics at the time it was closed are
+returned.
+
+@return The statistics gathered so far.
+
+@see ImageFile::statistics
+*/
+CompressedVectorReaderStatistics CompressedVectorReader::statistics() const
+{
+   return impl_->statistics();
+}
+
+/*!
+@brief Return the runs of records which might have values in all of the given ranges.
+
+@param [in] ranges The range of values of each field. A record matches if the value of every one of
+these fields is in its range.
+
+@details
+This uses the minimum & maximum of each field in each chunk of records which the writer saved with
+CompressedVectorWriterOptions::chunkStatistics. Every record which matches is in one of the runs
+returned, but they may also hold records which don't, so the values still need to be checked. Use
+seek() to read each run. If the file has no statistics for a field, its range doesn't skip any
+records.
+
+@return The matching runs of records in increasing order, with adjacent runs merged.
+
+@pre The associated ImageFile must be open.
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorPathUndefined    A field isn't in the prototype.
+@throw ::ErrorReadFailed
+@throw ::ErrorInternal         All objects in undocumented state
+
+@see CompressedVectorReader::seek, CompressedVectorWriterOptions::chunkStatistics
+*/
+std::vector<RecordRange> CompressedVectorReader::matchingRecordRanges(
+   const std::vector<FieldValueRange> &ranges ) const
+{
+   return impl_->matchingRecordRanges( ranges );
+}
+
+/*!
+@brief Transform the coordinates of the records read from now on.
+
+@param [in] transform The affine transform, and the fields it applies to.
+
+@details
+Each call to read() applies the transform to the X, Y & Z fields of the records it read, right after
+decoding them, while they are likely still in the CPU cache. This saves a separate pass over the
+buffers, for example to place the points of a scan in the world using its pose. The buffers of
+the three fields must all be float or all be double buffers. The transform keeps applying if
+new buffers are given to read( dbufs ).
+
+If CoordinateTransform::sphericalInput is set, the fields are spherical coordinates which are
+converted to cartesian ones in the same pass, so a scan stored as range, azimuth & elevation can
+be read straight into X, Y & Z.
+
+@pre The associated ImageFile must be open.
+@pre This CompressedVectorReader must be open (i.e isOpen())
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorReaderNotOpen
+@throw ::ErrorPathUndefined       A field isn't in the prototype.
+@throw ::ErrorNoBufferForElement  A field isn't being read.
+@throw ::ErrorBadAPIArgument      The buffers of the fields aren't all float or all double.
+@throw ::ErrorInternal            All objects in undocumented state
+
+@see CompressedVectorReader::clearCoordinateTransform, CoordinateTransform
+*/
+void CompressedVectorReader::setCoordinateTransform( const CoordinateTransform &transform )
+{
+   impl_->setCoordinateTransform( transform );
+}
+
+/*!
+@brief Stop transforming the coordinates of the records read.
+
+@see CompressedVectorReader::setCoordinateTransform
+*/
+void CompressedVectorReader::clearCoordinateTransform()
+{
+   impl_->clearCoordinateTransform();
+}
+
+/*!
+@brief Set which records the following calls to read() return.
+
+@param [in] sampling The records to return. The default RecordSampling returns every record.
+
+@details
+Only the chosen records are stored in the buffers, one after the other, so each read() returns the
+number of chosen records stored. The other records are still decoded, since the file is read
+in order, but they aren't converted, scaled or stored. If the file has an index of its chunks
+(as written by this library), chunks with no chosen records aren't read at all, so sparse samples
+(e.g. every 10000th record for a preview) read a small part of the file.
+
+The records chosen only depend on their numbers, so seek() followed by read() returns the chosen
+records at or after the record number given.
+
+@pre The associated ImageFile must be open.
+@pre This CompressedVectorReader must be open (i.e isOpen())
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorReaderNotOpen
+@throw ::ErrorBadAPIArgument      The step is 0, or the rate isn't between 0 and 1.
+@throw ::ErrorInternal            All objects in undocumented state
+
+@see CompressedVectorReader::read(), RecordSampling
+*/
+void CompressedVectorReader::setSampling( const RecordSampling &sampling )
+{
+   impl_->setSampling( sampling );
+}
+
+/*!
+@brief Set whether the values read are trusted to be within the limits of their fields.
+
+@param [in] trusted Skip the per-value range checks where the limits of the field fit the buffer.
+
+@details
+When storing a value in a buffer, the reader normally checks that it fits the buffer's type (e.g.
+that a scaled value fits an Int16 buffer) and throws ::ErrorValueNotRepresentable or
+::ErrorScaledValueNotRepresentable if it doesn't. For files from a trusted source, whose values are
+all within the minimum & maximum of their fields, these checks can be done once per buffer instead:
+for each buffer whose type holds every value allowed by the limits of its field, the values are
+stored without checks, in loops the compiler can vectorize. Buffers which may not hold every value
+are still checked one by one. The decision is made again when buffers are changed by rebind() or
+read( std::vector<SourceDestBuffer> & ).
+
+Values outside the limits of their fields (i.e. a corrupt or invalid file) aren't detected in
+trusted mode, and may be stored truncated. It is off by default.
+
+@pre The associated ImageFile must be open.
+@pre This CompressedVectorReader must be open (i.e isOpen())
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorReaderNotOpen
+@throw ::ErrorInternal            All objects in undocumented state
+
+@see CompressedVectorReader::read()
+*/
+void CompressedVectorReader::setTrustedRanges( bool trusted )
+{
+   impl_->setTrustedRanges( trusted );
+}
+
+/*!
+@brief Set which records the following calls to read() leave out.
+
+@param [in] filter The records to leave out. The default RecordFilter keeps every record.
+
+@details
+Once the records of a read are decoded, those which don't pass the filter are dropped, and the
+records kept after them in each buffer are moved down over them. The space freed is filled with the
+following records, so each read() fills the buffers with records which pass the filter until the
+end of the records, and returns the number stored. This saves a separate pass over the buffers to
+remove e.g. the points with no return, which may be a large part of a scan.
+
+The values are tested as they are stored in the buffers, a block of records at a time, in loops
+the compiler can vectorize. The limits of the ranges of the filter are scaled values for scaled
+integer fields, even when the raw integers are read (see SourceDestBuffer). If the
+CompressedVectorNode has statistics of its chunks (see CompressedVectorWriterOptions), the chunks
+which have no value in one of the ranges aren't read at all, as with matchingRecordRanges().
+
+The fields tested by the filter must be among the fields read, in numeric buffers. A filter can be
+combined with setSampling(): the records chosen by the sampling are then filtered, but chunks are
+only skipped for the sampling. Setting a filter replaces the previous one.
+
+@pre The associated ImageFile must be open.
+@pre This CompressedVectorReader must be open (i.e isOpen())
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorReaderNotOpen
+@throw ::ErrorBadAPIArgument      A field of the filter isn't read, is read as strings, or is
+                                  normalized (see setNormalization()).
+@throw ::ErrorInternal            All objects in undocumented state
+
+@see CompressedVectorReader::read(), RecordFilter, CompressedVectorReader::matchingRecordRanges()
+*/
+void CompressedVectorReader::setRecordFilter( const RecordFilter &filter )
+{
+   impl_->setRecordFilter( filter );
+}
+
+/*!
+@brief Set fields whose values are normalized as they are stored by the following reads.
+
+@param [in] normalizations The fields to normalize & their limits. An empty list stores every
+value as it is.
+
+@details
+The value of each of these fields is mapped from the minimum & maximum of its FieldNormalization to
+0 - 1 in Float16, float & double buffers, to 0 - the largest value of the type in uint8_t, uint16_t
+& uint32_t buffers, or to minus to plus the largest value of the type in int8_t, int16_t & int32_t
+buffers (integers are rounded to the nearest integer), and clamped to that range. Values outside the
+limits, e.g. an intensity above the intensity limits of a scan, are stored as the nearest limit.
+
+The mapping is done by the decoders as they store each block of values, in loops the compiler can
+vectorize, so e.g. intensities can be read straight into float buffers from 0 to 1 and colours into
+bytes, without reading them into wider buffers and normalizing them in a separate pass. Scaled
+integer fields are scaled before they are normalized, even if the buffer was made to receive the
+raw integers (see SourceDestBuffer).
+
+The fields must be among the fields read, and can't be tested by the filter of setRecordFilter().
+The normalization is applied again to the buffers given by rebind() or
+read( std::vector<SourceDestBuffer> & ). Setting normalizations replaces the previous ones.
+
+@pre The associated ImageFile must be open.
+@pre This CompressedVectorReader must be open (i.e isOpen())
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorReaderNotOpen
+@throw ::ErrorBadAPIArgument      A field isn't read, isn't read into a float, double or unsigned
+                                  integer buffer, is tested by the record filter, or its limits
+                                  aren't a finite non empty range.
+@throw ::ErrorInternal            All objects in undocumented state
+
+@see CompressedVectorReader::read(), FieldNormalization
+*/
+void CompressedVectorReader::setNormalization(
+   const std::vector<FieldNormalization> &normalizations )
+{
+   impl_->setNormalization( normalizations );
+}
+
+/*!
+@brief Give the reader new buffers for the same fields, without reading any records.
+
+@param [in] dbufs Buffers for the same fields as the current ones, in the same order.
+
+@details
+Unlike read( std::vector<SourceDestBuffer> & ), the capacity, type and stride of the buffers may
+differ from the current ones. The decoders, the packet cache and the position of the reader are
+kept, so a reader can be set up once and reused for many reads of different sizes, e.g. with
+setRecordRange().
+
+@pre The associated ImageFile must be open.
+@pre This CompressedVectorReader must be open (i.e isOpen())
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorReaderNotOpen
+@throw ::ErrorBuffersNotCompatible The fields of the buffers aren't the same as the current ones.
+@throw ::ErrorBadAPIArgument       The coordinate transform (see setCoordinateTransform()) or
+                                   the normalizations (see setNormalization()) can't be applied
+                                   to the new buffers.
+@throw ::ErrorPathUndefined
+@throw ::ErrorInternal             All objects in undocumented state
+
+@see CompressedVectorReader::setRecordRange()
+*/
+void CompressedVectorReader::rebind( std::vector<SourceDestBuffer> &dbufs )
+{
+   impl_->rebind( dbufs );
+}
+
+/*!
+@brief Restrict the following reads to a range of records.
+
+@param [in] firstRecord The number of the first record to read.
+@param [in] recordCount The number of records to read from firstRecord.
+
+@details
+This seeks to @a firstRecord (see seek()), and read() returns 0 once @a recordCount records have
+been read. Call it again to read another range with the same reader: its decoders and packet cache
+are reused, which is much cheaper than creating a reader for each range. Use setRecordRange( 0,
+childCount() ) to read the whole CompressedVectorNode again. seek() can't go past the end of the
+range.
+
+@pre The associated ImageFile must be open.
+@pre This CompressedVectorReader must be open (i.e isOpen())
+
+@throw ::ErrorBadAPIArgument The range isn't in the CompressedVectorNode.
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorReaderNotOpen
+@throw ::ErrorBadCVPacket
+@throw ::ErrorSeekFailed
+@throw ::ErrorReadFailed
+@throw ::ErrorBadChecksum
+@throw ::ErrorInternal       All objects in undocumented state
+
+@see CompressedVectorReader::seek(), CompressedVectorReader::rebind()
+*/
+void CompressedVectorReader::setRecordRange( int64_t firstRecord, int64_t recordCount )
+{
+   impl_->setRecordRange( static_cast<uint64_t>( firstRecord ),
+                          static_cast<uint64_t>( recordCount ) );
+}
+
 /*!
 @brief Diagnostic function to print internal state of object to output stream in an indented format.
 @copydetails Node::dump()
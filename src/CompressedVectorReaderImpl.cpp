@@ -25,20 +25,132 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
 #include "CompressedVectorReaderImpl.h"
+#include "BlobNodeImpl.h"
 #include "CheckedFile.h"
+#include "ChunkStatistics.h"
 #include "CompressedVectorNodeImpl.h"
+#include "CoordinateKernels.h"
+#include "FloatNodeImpl.h"
+#include "HalfFloat.h"
 #include "ImageFileImpl.h"
+#include "IntegerNodeImpl.h"
 #include "Packet.h"
+#include "ScaledIntegerNodeImpl.h"
 #include "SectionHeaders.h"
 #include "SourceDestBufferImpl.h"
+#include "Statistics.h"
 #include "StringFunctions.h"
+#include "StringNodeImpl.h"
+#include "StructureNodeImpl.h"
+#include "Tracing.h"
 
 namespace e57
 {
+   inline unsigned _bytestreamLength( const PacketLock &packetLock, unsigned bytestreamNumber )
+   {
+      unsigned byteCount = 0;
+      packetLock.bytestream( bytestreamNumber, byteCount );
+
+      return byteCount;
+   }
+
+   namespace
+   {
+      /// Whether the values from @a lowest to @a highest are all stored in a T without an error.
+      template <typename T> bool rangeFits( double lowest, double highest )
+      {
+         return ( lowest >= static_cast<double>( std::numeric_limits<T>::lowest() ) ) &&
+                ( highest <= static_cast<double>( std::numeric_limits<T>::max() ) );
+      }
+
+      /// Whether every value allowed by the limits of @a field can be stored in @a buffer, so the
+      /// buffer needn't check them one by one.
+      bool valuesFit( const NodeImplSharedPtr &field, const SourceDestBufferImpl &buffer )
+      {
+         double lowest = 0.0;
+         double highest = 0.0;
+
+         switch ( field->type() )
+         {
+            case TypeInteger:
+            {
+               auto integer = std::static_pointer_cast<IntegerNodeImpl>( field );
+
+               lowest = static_cast<double>( integer->minimum() );
+               highest = static_cast<double>( integer->maximum() );
+               break;
+            }
+
+            case TypeScaledInteger:
+            {
+               auto scaled = std::static_pointer_cast<ScaledIntegerNodeImpl>( field );
+
+               lowest = static_cast<double>( scaled->minimum() );
+               highest = static_cast<double>( scaled->maximum() );
+
+               if ( buffer.doScaling() )
+               {
+                  // The scale may be negative
+                  const double cFirst = lowest * scaled->scale() + scaled->offset();
+                  const double cLast = highest * scaled->scale() + scaled->offset();
+
+                  lowest = floor( std::min( cFirst, cLast ) + 0.5 );
+                  highest = floor( std::max( cFirst, cLast ) + 0.5 );
+               }
+               break;
+            }
+
+            case TypeFloat:
+            {
+               auto real = std::static_pointer_cast<FloatNodeImpl>( field );
+
+               lowest = real->minimum();
+               highest = real->maximum();
+               break;
+            }
+
+            default:
+               return false;
+         }
+
+         switch ( buffer.memoryRepresentation() )
+         {
+            case Int8:
+               return rangeFits<int8_t>( lowest, highest );
+            case UInt8:
+               return rangeFits<uint8_t>( lowest, highest );
+            case Int16:
+               return rangeFits<int16_t>( lowest, highest );
+            case UInt16:
+               return rangeFits<uint16_t>( lowest, highest );
+            case Int32:
+               return rangeFits<int32_t>( lowest, highest );
+            case UInt32:
+               return rangeFits<uint32_t>( lowest, highest );
+            case Int64:
+               return rangeFits<int64_t>( lowest, highest );
+            case Real16:
+               return ( lowest >= -HalfFloat::cMaximum ) && ( highest <= HalfFloat::cMaximum );
+            case Real32:
+               return rangeFits<float>( lowest, highest );
+            case Bool:
+            case Real64:
+               return true;
+            default:
+               return false;
+         }
+      }
+   }
+
    CompressedVectorReaderImpl::CompressedVectorReaderImpl(
-      std::shared_ptr<CompressedVectorNodeImpl> cvi,
-      std::vector<SourceDestBuffer> &dbufs ) :
+      std::shared_ptr<CompressedVectorNodeImpl> cvi, std::vector<SourceDestBuffer> &dbufs,
+      const PacketCacheOptions &cacheOptions ) :
       isOpen_( false ), // set to true when succeed below
       cVector_( cvi )
    {
@@ -60,6 +172,13 @@ namespace e57
                                                        " cvPathName=" + cVector_->pathName() );
       }
 
+      if ( cacheOptions.packetCount == 0 )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "packetCount=0 imageFileName=" +
+                                                       cVector_->imageFileName() +
+                                                       " cvPathName=" + cVector_->pathName() );
+      }
+
       // Get CompressedArray's prototype node (all array elements must match this
       // type)
       proto_ = cVector_->getPrototype();
@@ -94,6 +213,7 @@ namespace e57
 
       // Get how many records are actually defined
       maxRecordCount_ = cvi->childCount();
+      recordLimit_ = maxRecordCount_;
 
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
 
@@ -118,8 +238,8 @@ namespace e57
 
       // Read CompressedVector section header
       CompressedVectorSectionHeader sectionHeader;
-      imf->file_->seek( sectionLogicalStart, CheckedFile::Logical );
-      imf->file_->read( reinterpret_cast<char *>( &sectionHeader ), sizeof( sectionHeader ) );
+      imf->file_->readAt( sectionLogicalStart, reinterpret_cast<char *>( &sectionHeader ),
+                          sizeof( sectionHeader ) );
 
 #if VALIDATE_BASIC
       sectionHeader.verify( imf->file_->length( CheckedFile::Physical ) );
@@ -133,7 +253,10 @@ namespace e57
          imf->file_->physicalToLogical( sectionHeader.dataPhysicalOffset );
 
       //??? what if fault in this constructor?
-      cache_ = new PacketReadCache( imf->file_, 32 );
+      cache_ = new PacketReadCache(
+         imf->file_, cacheOptions,
+         cacheOptions.useSharedCache ? imf->sharedPacketCache() : nullptr );
+      cache_->setReadAheadLimit( sectionEndLogicalOffset_ );
 
       // Verify that packet given by dataPhysicalOffset is actually a data packet,
       // init channels
@@ -158,15 +281,38 @@ namespace e57
                channel.currentPacketLogicalOffset = dataLogicalOffset;
                channel.currentBytestreamBufferIndex = 0;
                channel.currentBytestreamBufferLength =
-                  dpkt->getBytestreamBufferLength( channel.bytestreamNumber );
+                  _bytestreamLength( *packetLock, channel.bytestreamNumber );
             }
          }
+
+         // When only some of the bytestreams are read, the cache can skip the others
+         if ( cacheOptions.projectedRead && ( channels_.size() < dpkt->header.bytestreamCount ) )
+         {
+            std::vector<bool> needed( dpkt->header.bytestreamCount, false );
+
+            for ( const auto &channel : channels_ )
+            {
+               if ( channel.bytestreamNumber < needed.size() )
+               {
+                  needed[channel.bytestreamNumber] = true;
+               }
+            }
+
+            cache_->setBytestreamFilter( needed );
+         }
       }
 
       // Just before return (and can't throw) increment reader count  ??? safer
       // way to assure don't miss close?
       imf->incrReaderCount();
 
+      // Reading ahead carries on between reads, until the reader or the file is closed
+      if ( cache_->readsAheadInBackground() && !imf->isWriter() )
+      {
+         imf->addReadAheadCache( cache_ );
+         keepsReadingAhead_ = true;
+      }
+
       // If get here, the reader is open
       isOpen_ = true;
    }
@@ -220,6 +366,101 @@ namespace e57
       }
 
       dbufs_ = dbufs;
+
+      applyRangeChecks();
+      applyNormalizations();
+      compactor_.bind( proto_, dbufs_ );
+   }
+
+   // Use new buffers for the same fields from now on, without reading anything. Unlike read(
+   // dbufs ), the capacity, type and stride of each buffer may change.
+   void CompressedVectorReaderImpl::rebind( std::vector<SourceDestBuffer> &dbufs )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      proto_->checkBuffers( dbufs, true );
+
+      // The channels & their decoders were created for the fields in this order
+      bool isSameFields = ( dbufs.size() == dbufs_.size() );
+
+      for ( size_t i = 0; isSameFields && ( i < dbufs.size() ); ++i )
+      {
+         isSameFields =
+            ( proto_->get( dbufs[i].pathName() ) == proto_->get( dbufs_[i].pathName() ) );
+      }
+
+      if ( !isSameFields )
+      {
+         throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
+                               "oldSize=" + toString( dbufs_.size() ) +
+                                  " newSize=" + toString( dbufs.size() ) +
+                                  " cvPathName=" + cVector_->pathName() );
+      }
+
+      const std::vector<SourceDestBuffer> cOriginals = dbufs_;
+
+      dbufs_ = dbufs;
+
+      applyRangeChecks();
+
+      try
+      {
+         applyNormalizations();
+         compactor_.bind( proto_, dbufs_ );
+      }
+      catch ( ... )
+      {
+         dbufs_ = cOriginals;
+         applyRangeChecks();
+         applyNormalizations();
+         throw;
+      }
+
+      // The coordinate buffers may have changed type
+      if ( transformCoordinates_ )
+      {
+         try
+         {
+            setCoordinateTransform( coordinateTransform_ );
+         }
+         catch ( ... )
+         {
+            dbufs_ = cOriginals;
+            throw;
+         }
+      }
+
+      for ( size_t i = 0; i < channels_.size(); ++i )
+      {
+         std::vector<SourceDestBuffer> theDbuf( 1, dbufs_[i] );
+
+         channels_[i].dbuf = dbufs_[i];
+         channels_[i].decoder->destBufferSetNew( theDbuf );
+      }
+   }
+
+   // Go to firstRecord & stop reading after recordCount records, reusing the decoders & the
+   // packet cache.
+   void CompressedVectorReaderImpl::setRecordRange( uint64_t firstRecord, uint64_t recordCount )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( ( firstRecord > maxRecordCount_ ) || ( recordCount > maxRecordCount_ - firstRecord ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "firstRecord=" + toString( firstRecord ) +
+                                  " recordCount=" + toString( recordCount ) +
+                                  " maxRecordCount=" + toString( maxRecordCount_ ) +
+                                  " cvPathName=" + cVector_->pathName() );
+      }
+
+      recordLimit_ = firstRecord + recordCount;
+
+      setRecordLimit( recordLimit_ );
+
+      seek( firstRecord );
    }
 
    unsigned CompressedVectorReaderImpl::read( std::vector<SourceDestBuffer> &dbufs )
@@ -232,6 +473,16 @@ namespace e57
       // Check compatible with current dbufs
       setBuffers( dbufs );
 
+      // Point the channels & their decoders at the new buffers. The channels were created in the
+      // same order as the buffers.
+      for ( size_t i = 0; i < channels_.size(); ++i )
+      {
+         std::vector<SourceDestBuffer> theDbuf( 1, dbufs_[i] );
+
+         channels_[i].dbuf = dbufs_[i];
+         channels_[i].decoder->destBufferSetNew( theDbuf );
+      }
+
       return ( read() );
    }
 
@@ -249,55 +500,534 @@ namespace e57
          dbuf.impl()->rewind();
       }
 
+      unsigned outputCount = decodeBuffers( 0 );
+
+      // Fill the space of the records dropped with the following ones, until the buffers are full
+      // or there are no more records
+      if ( !compactor_.keepsAll() )
+      {
+         unsigned keptCount = 0;
+
+         while ( outputCount > keptCount )
+         {
+            const auto cKept =
+               static_cast<unsigned>( compactor_.compact( dbufs_, keptCount, outputCount ) );
+
+            if ( cKept == outputCount )
+            {
+               break;
+            }
+
+            keptCount = cKept;
+            outputCount = decodeBuffers( keptCount );
+         }
+      }
+
+      // Transform the coordinates while they are still in the cache
+      if ( transformCoordinates_ && ( outputCount > 0 ) )
+      {
+         transformCoordinates( outputCount );
+      }
+
+      // Return number of records transferred to each dbuf.
+      return outputCount;
+   }
+
+   // Decode records into the buffers after the first @a firstIndex records (which are already in
+   // all of them), and return the number of records in the buffers.
+   unsigned CompressedVectorReaderImpl::decodeBuffers( unsigned firstIndex )
+   {
+      if ( !sampler_.keepsAll() )
+      {
+         decodeSampledChunks();
+      }
+      else if ( filterSkipsChunks_ )
+      {
+         decodeFilteredChunks();
+      }
+      else
+      {
+         decodeRecords();
+      }
+
+      // Reading ahead carries on between calls when the file is only read (the ImageFile stops
+      // it if it's closed first). Otherwise the file may be written in the meantime.
+      if ( !keepsReadingAhead_ )
+      {
+         cache_->finishReadAhead();
+      }
+
+      // Verify that each channel produced the same number of records
+      unsigned outputCount = 0;
+      for ( unsigned i = 0; i < channels_.size(); i++ )
+      {
+         DecodeChannel *chan = &channels_[i];
+         if ( i == 0 )
+         {
+            outputCount = chan->dbuf.impl()->nextIndex();
+         }
+         else
+         {
+            if ( outputCount != chan->dbuf.impl()->nextIndex() )
+            {
+               throw E57_EXCEPTION2(
+                  ErrorInternal, "outputCount=" + toString( outputCount ) +
+                                    " nextIndex=" + toString( chan->dbuf.impl()->nextIndex() ) );
+            }
+         }
+      }
+
+      // When sampling, the channels can be at different records: each one stops at the next record
+      // it would keep, or at the end of a chunk.
+      if ( sampler_.keepsAll() && !filterSkipsChunks_ )
+      {
+         recordCount_ += outputCount - firstIndex;
+      }
+      else if ( !channels_.empty() )
+      {
+         recordCount_ = UINT64_MAX;
+
+         for ( const auto &channel : channels_ )
+         {
+            recordCount_ = std::min( recordCount_, channel.decoder->totalRecordsCompleted() );
+         }
+      }
+
+      return outputCount;
+   }
+
+   // Fill the buffers from the records after the current ones, until they are full or the
+   // channels reach their record limit.
+   void CompressedVectorReaderImpl::decodeRecords()
+   {
       // Allow decoders to use data they already have in their queue to fill newly
       // empty dbufs This helps to keep decoder input queues smaller, which
       // reduces backtracking in the packet cache.
       for ( auto &channel : channels_ )
       {
+         ScopedTimer<uint64_t> timer( channel.decodeNanoseconds );
+
          channel.decoder->inputProcess( nullptr, 0 );
       }
 
-      // Loop until every dbuf is full or we have reached end of the binary
-      // section.
-      while ( true )
+      // Loop until every dbuf is full or we have reached end of the binary
+      // section.
+      while ( true )
+      {
+         // Find the earliest packet position for channels that are still hungry
+         // It's important to call inputProcess of the decoders before this call,
+         // so current hungriness level is reflected.
+         uint64_t earliestPacketLogicalOffset = earliestPacketNeededForInput();
+
+         // If nobody's hungry, we are done with the read
+         if ( earliestPacketLogicalOffset == UINT64_MAX )
+         {
+            break;
+         }
+
+         // Feed packet to the hungry decoders
+         feedPacketToDecoders( earliestPacketLogicalOffset );
+      }
+   }
+
+   // Decode the records of one chunk at a time, going straight to the next chunk with a record
+   // to keep when the chunk index allows it. Sparse samples then skip most of the file.
+   void CompressedVectorReaderImpl::decodeSampledChunks()
+   {
+      if ( chunks_.empty() )
+      {
+         chunks_ = cVector_->readChunkIndex();
+      }
+
+      if ( chunks_.size() < 2 )
+      {
+         decodeRecords();
+         return;
+      }
+
+      uint64_t previousFirst = UINT64_MAX;
+
+      while ( true )
+      {
+         uint64_t first = UINT64_MAX;
+         uint64_t last = 0;
+         bool isFull = true;
+
+         for ( const auto &channel : channels_ )
+         {
+            const uint64_t cRecord = channel.decoder->totalRecordsCompleted();
+
+            first = std::min( first, cRecord );
+            last = std::max( last, cRecord );
+
+            const auto &dbuf = *channel.dbuf.impl();
+
+            isFull = isFull && ( dbuf.nextIndex() == dbuf.capacity() );
+         }
+
+         // Stop when the buffers are full, or if the last chunk didn't get anywhere (e.g. the
+         // input ran out)
+         if ( isFull || ( first == previousFirst ) )
+         {
+            break;
+         }
+
+         previousFirst = first;
+
+         const uint64_t cNextKept = sampler_.nextKept( first, recordLimit_ );
+
+         // Nothing else to keep, so go to the end without decoding the rest
+         if ( cNextKept == recordLimit_ )
+         {
+            for ( auto &channel : channels_ )
+            {
+               channel.decoder->stateReset( recordLimit_ );
+               channel.inputFinished = true;
+            }
+
+            break;
+         }
+
+         auto chunk = std::upper_bound( chunks_.begin(), chunks_.end(), cNextKept,
+                                        []( uint64_t record, const ChunkIndexEntry &entry ) {
+                                           return record < entry.recordNumber;
+                                        } );
+
+         const uint64_t cChunkEnd = ( chunk == chunks_.end() )
+                                       ? recordLimit_
+                                       : std::min( recordLimit_, chunk->recordNumber );
+
+         --chunk;
+
+         if ( chunk->recordNumber > last )
+         {
+            startChunk( *chunk );
+         }
+
+         setRecordLimit( cChunkEnd );
+
+         decodeRecords();
+
+         if ( cChunkEnd == recordLimit_ )
+         {
+            break;
+         }
+      }
+
+      setRecordLimit( recordLimit_ );
+   }
+
+   // Decode the records of the chunks which may have records passing the filter (from their
+   // statistics), going straight from one to the next when the chunk index allows it.
+   void CompressedVectorReaderImpl::decodeFilteredChunks()
+   {
+      if ( chunks_.empty() )
+      {
+         chunks_ = cVector_->readChunkIndex();
+      }
+
+      if ( chunks_.size() < 2 )
+      {
+         decodeRecords();
+         return;
+      }
+
+      uint64_t previousFirst = UINT64_MAX;
+
+      while ( true )
+      {
+         uint64_t first = UINT64_MAX;
+         uint64_t last = 0;
+         bool isFull = true;
+
+         for ( const auto &channel : channels_ )
+         {
+            const uint64_t cRecord = channel.decoder->totalRecordsCompleted();
+
+            first = std::min( first, cRecord );
+            last = std::max( last, cRecord );
+
+            const auto &dbuf = *channel.dbuf.impl();
+
+            isFull = isFull && ( dbuf.nextIndex() == dbuf.capacity() );
+         }
+
+         if ( isFull || ( first == previousFirst ) )
+         {
+            break;
+         }
+
+         previousFirst = first;
+
+         const auto cRange =
+            std::find_if( filterRanges_.begin(), filterRanges_.end(),
+                          [first]( const RecordRange &range ) {
+                             return range.firstRecord + range.recordCount > first;
+                          } );
+
+         const uint64_t cStart =
+            ( cRange == filterRanges_.end() )
+               ? recordLimit_
+               : std::min( recordLimit_, std::max( first, cRange->firstRecord ) );
+
+         // No other record can pass, so go to the end without decoding the rest
+         if ( cStart == recordLimit_ )
+         {
+            for ( auto &channel : channels_ )
+            {
+               channel.decoder->stateReset( recordLimit_ );
+               channel.inputFinished = true;
+            }
+
+            break;
+         }
+
+         const uint64_t cEnd =
+            std::min( recordLimit_, cRange->firstRecord + cRange->recordCount );
+
+         auto chunk = std::upper_bound( chunks_.begin(), chunks_.end(), cStart,
+                                        []( uint64_t record, const ChunkIndexEntry &entry ) {
+                                           return record < entry.recordNumber;
+                                        } );
+         --chunk;
+
+         if ( chunk->recordNumber > last )
+         {
+            startChunk( *chunk );
+         }
+
+         setRecordLimit( cEnd );
+
+         decodeRecords();
+
+         if ( cEnd == recordLimit_ )
+         {
+            break;
+         }
+      }
+
+      setRecordLimit( recordLimit_ );
+   }
+
+   void CompressedVectorReaderImpl::setDecoderSampler( const RecordSampler &sampler )
+   {
+      for ( auto &channel : channels_ )
+      {
+         channel.decoder->setSampler( sampler );
+      }
+   }
+
+   void CompressedVectorReaderImpl::setRecordLimit( uint64_t recordLimit )
+   {
+      for ( auto &channel : channels_ )
+      {
+         channel.maxRecordCount = recordLimit;
+         channel.decoder->setRecordLimit( recordLimit );
+      }
+   }
+
+   void CompressedVectorReaderImpl::setSampling( const RecordSampling &sampling )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( ( sampling.step == 0 ) || !( sampling.rate >= 0.0 ) || ( sampling.rate > 1.0 ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "step=" + toString( sampling.step ) +
+                                                       " rate=" + toString( sampling.rate ) );
+      }
+
+      sampler_ = RecordSampler( sampling );
+
+      setDecoderSampler( sampler_ );
+   }
+
+   void CompressedVectorReaderImpl::setTrustedRanges( bool trusted )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      trustedRanges_ = trusted;
+
+      applyRangeChecks();
+   }
+
+   void CompressedVectorReaderImpl::setRecordFilter( const RecordFilter &filter )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      RecordCompactor compactor( filter );
+
+      compactor.bind( proto_, dbufs_ );
+
+      // Chunks whose statistics show none of their records are in the ranges needn't be read
+      std::vector<RecordRange> ranges;
+
+      if ( !filter.ranges.empty() )
+      {
+         ranges = matchingRecordRanges( filter.ranges );
+      }
+
+      const bool cSkipsChunks =
+         !filter.ranges.empty() &&
+         !( ( ranges.size() == 1 ) && ( ranges[0].firstRecord == 0 ) &&
+            ( ranges[0].recordCount == maxRecordCount_ ) );
+
+      compactor_ = std::move( compactor );
+      filterRanges_ = std::move( ranges );
+      filterSkipsChunks_ = cSkipsChunks;
+   }
+
+   void CompressedVectorReaderImpl::setNormalization(
+      const std::vector<FieldNormalization> &normalizations )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      const std::vector<FieldNormalization> cOriginals = normalizations_;
+
+      normalizations_ = normalizations;
+
+      // The filter can't test normalized fields
+      try
+      {
+         applyNormalizations();
+         compactor_.bind( proto_, dbufs_ );
+      }
+      catch ( ... )
+      {
+         normalizations_ = cOriginals;
+         applyNormalizations();
+         throw;
+      }
+   }
+
+   void CompressedVectorReaderImpl::applyNormalizations()
+   {
+      for ( auto &dbuf : dbufs_ )
+      {
+         dbuf.impl()->clearNormalization();
+      }
+
+      for ( const auto &normalization : normalizations_ )
+      {
+         auto found = std::find_if(
+            dbufs_.begin(), dbufs_.end(), [&normalization]( const SourceDestBuffer &dbuf ) {
+               return dbuf.pathName() == normalization.pathName;
+            } );
+
+         if ( found == dbufs_.end() )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument, "pathName=" + normalization.pathName );
+         }
+
+         found->impl()->setNormalization( normalization.minimum, normalization.maximum );
+      }
+   }
+
+   // Decide once per buffer whether the values stored in it must be checked one by one
+   void CompressedVectorReaderImpl::applyRangeChecks()
+   {
+      for ( auto &dbuf : dbufs_ )
+      {
+         const bool cFits =
+            trustedRanges_ && valuesFit( proto_->get( dbuf.pathName() ), *dbuf.impl() );
+
+         dbuf.impl()->setRangeChecks( !cFits );
+      }
+   }
+
+   void CompressedVectorReaderImpl::setCoordinateTransform( const CoordinateTransform &transform )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      const ustring cPathNames[3] = { transform.xPathName, transform.yPathName,
+                                      transform.zPathName };
+
+      size_t buffers[3] = {};
+
+      for ( size_t axis = 0; axis < 3; ++axis )
       {
-         // Find the earliest packet position for channels that are still hungry
-         // It's important to call inputProcess of the decoders before this call,
-         // so current hungriness level is reflected.
-         uint64_t earliestPacketLogicalOffset = earliestPacketNeededForInput();
+         // Match the full path names the buffers were checked with
+         const ustring cPathName = proto_->get( cPathNames[axis] )->pathName();
 
-         // If nobody's hungry, we are done with the read
-         if ( earliestPacketLogicalOffset == UINT64_MAX )
+         auto found = std::find_if( dbufs_.begin(), dbufs_.end(), [&]( const SourceDestBuffer &d ) {
+            return proto_->get( d.pathName() )->pathName() == cPathName;
+         } );
+
+         if ( found == dbufs_.end() )
          {
-            break;
+            throw E57_EXCEPTION2( ErrorNoBufferForElement, "pathName=" + cPathNames[axis] );
          }
 
-         // Feed packet to the hungry decoders
-         feedPacketToDecoders( earliestPacketLogicalOffset );
+         buffers[axis] = static_cast<size_t>( found - dbufs_.begin() );
       }
 
-      // Verify that each channel produced the same number of records
-      unsigned outputCount = 0;
-      for ( unsigned i = 0; i < channels_.size(); i++ )
+      const MemoryRepresentation cRepresentation =
+         dbufs_[buffers[0]].impl()->memoryRepresentation();
+
+      for ( const auto buffer : buffers )
       {
-         DecodeChannel *chan = &channels_[i];
-         if ( i == 0 )
-         {
-            outputCount = chan->dbuf.impl()->nextIndex();
-         }
-         else
+         const MemoryRepresentation cAxisRepresentation =
+            dbufs_[buffer].impl()->memoryRepresentation();
+
+         if ( ( ( cAxisRepresentation != Real32 ) && ( cAxisRepresentation != Real64 ) ) ||
+              ( cAxisRepresentation != cRepresentation ) )
          {
-            if ( outputCount != chan->dbuf.impl()->nextIndex() )
-            {
-               throw E57_EXCEPTION2(
-                  ErrorInternal, "outputCount=" + toString( outputCount ) +
-                                    " nextIndex=" + toString( chan->dbuf.impl()->nextIndex() ) );
-            }
+            throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                  "pathName=" + dbufs_[buffer].pathName() +
+                                     " memoryRepresentation=" + toString( cAxisRepresentation ) );
          }
       }
 
-      // Return number of records transferred to each dbuf.
-      return outputCount;
+      transformCoordinates_ = true;
+      coordinateTransform_ = transform;
+
+      std::copy( std::begin( buffers ), std::end( buffers ), std::begin( coordinateBuffers_ ) );
+   }
+
+   void CompressedVectorReaderImpl::clearCoordinateTransform()
+   {
+      transformCoordinates_ = false;
+   }
+
+   void CompressedVectorReaderImpl::transformCoordinates( unsigned recordCount )
+   {
+      const SourceDestBufferImpl &x = *dbufs_[coordinateBuffers_[0]].impl();
+      const SourceDestBufferImpl &y = *dbufs_[coordinateBuffers_[1]].impl();
+      const SourceDestBufferImpl &z = *dbufs_[coordinateBuffers_[2]].impl();
+
+      if ( x.memoryRepresentation() == Real32 )
+      {
+         transformCoordinates( static_cast<float *>( x.base() ), x.stride(),
+                               static_cast<float *>( y.base() ), y.stride(),
+                               static_cast<float *>( z.base() ), z.stride(), recordCount );
+      }
+      else
+      {
+         transformCoordinates( static_cast<double *>( x.base() ), x.stride(),
+                               static_cast<double *>( y.base() ), y.stride(),
+                               static_cast<double *>( z.base() ), z.stride(), recordCount );
+      }
+   }
+
+   template <typename T>
+   void CompressedVectorReaderImpl::transformCoordinates( T *x, size_t xStride, T *y,
+                                                          size_t yStride, T *z, size_t zStride,
+                                                          unsigned recordCount )
+   {
+      if ( coordinateTransform_.sphericalInput )
+      {
+         CoordinateKernels::sphericalToCartesian( x, xStride, y, yStride, z, zStride, recordCount,
+                                                  coordinateTransform_.matrix );
+      }
+      else
+      {
+         CoordinateKernels::transform( x, xStride, y, yStride, z, zStride, recordCount,
+                                       coordinateTransform_.matrix );
+      }
    }
 
    uint64_t CompressedVectorReaderImpl::earliestPacketNeededForInput() const
@@ -339,13 +1069,16 @@ namespace e57
       return earliestPacketLogicalOffset;
    }
 
-   DataPacket *CompressedVectorReaderImpl::dataPacket( uint64_t inLogicalOffset ) const
+   std::unique_ptr<PacketLock> CompressedVectorReaderImpl::lockDataPacket( uint64_t offset,
+                                                                           DataPacket *&dpkt ) const
    {
       char *packet = nullptr;
 
-      std::unique_ptr<PacketLock> packetLock = cache_->lock( inLogicalOffset, packet );
+      std::unique_ptr<PacketLock> packetLock = cache_->lock( offset, packet );
+
+      dpkt = reinterpret_cast<DataPacket *>( packet );
 
-      return reinterpret_cast<DataPacket *>( packet );
+      return packetLock;
    }
 
    inline bool _alreadyReadPacket( const DecodeChannel &channel,
@@ -357,8 +1090,11 @@ namespace e57
 
    void CompressedVectorReaderImpl::feedPacketToDecoders( uint64_t currentPacketLogicalOffset )
    {
-      // Get packet at currentPacketLogicalOffset into memory.
-      auto dpkt = dataPacket( currentPacketLogicalOffset );
+      E57_TRACE_ZONE( "CompressedVectorReaderImpl::feedPacketToDecoders" );
+
+      // Get packet at currentPacketLogicalOffset into memory, and keep it there while we use it.
+      DataPacket *dpkt = nullptr;
+      std::unique_ptr<PacketLock> packetLock = lockDataPacket( currentPacketLogicalOffset, dpkt );
 
       // Double check that have a data packet.  Should have already determined this.
       if ( dpkt->header.packetType != DATA_PACKET )
@@ -382,7 +1118,7 @@ namespace e57
 
          // Get bytestream buffer for this channel from packet
          unsigned int bsbLength = 0;
-         const char *bsbStart = dpkt->getBytestream( channel.bytestreamNumber, bsbLength );
+         const char *bsbStart = packetLock->bytestream( channel.bytestreamNumber, bsbLength );
 
          // Double check we are not off end of buffer
          if ( channel.currentBytestreamBufferIndex > bsbLength )
@@ -404,7 +1140,15 @@ namespace e57
          }
 
          // Feed into decoder
-         const size_t bytesProcessed = channel.decoder->inputProcess( uneatenStart, uneatenLength );
+         size_t bytesProcessed = 0;
+
+         {
+            ScopedTimer<uint64_t> timer( channel.decodeNanoseconds );
+
+            bytesProcessed = channel.decoder->inputProcess( uneatenStart, uneatenLength );
+         }
+
+         channel.byteCount += bytesProcessed;
 
 #ifdef E57_VERBOSE
          std::cout << "  stream[" << channel.bytestreamNumber << "]: feeding decoder "
@@ -436,6 +1180,9 @@ namespace e57
          }
       }
 
+      // Done with this packet, so let the cache replace it if it needs to.
+      packetLock.reset();
+
       // Skip over any index or empty packets to next data packet.
       nextPacketLogicalOffset = findNextDataPacket( nextPacketLogicalOffset );
 
@@ -451,7 +1198,7 @@ namespace e57
       if ( nextPacketLogicalOffset < UINT64_MAX )
       { //??? huh?
          // Get packet at nextPacketLogicalOffset into memory.
-         dpkt = dataPacket( nextPacketLogicalOffset );
+         packetLock = lockDataPacket( nextPacketLogicalOffset, dpkt );
 
          // Got a data packet, update the channels with exhausted input
          for ( DecodeChannel &channel : channels_ )
@@ -468,7 +1215,7 @@ namespace e57
             // It is OK if the next packet doesn't contain any data for this
             // channel, will skip packet on next iter of loop
             channel.currentBytestreamBufferLength =
-               dpkt->getBytestreamBufferLength( channel.bytestreamNumber );
+               _bytestreamLength( *packetLock, channel.bytestreamNumber );
 
 #ifdef E57_VERBOSE
             std::cout << "  set new stream buffer for channel[" << channel.bytestreamNumber
@@ -542,12 +1289,177 @@ namespace e57
       return UINT64_MAX;
    }
 
-   void CompressedVectorReaderImpl::seek( uint64_t /*recordNumber*/ )
+   // Position all channels at the start of @a chunk so the next read() begins with its first
+   // record.
+   void CompressedVectorReaderImpl::startChunk( const ChunkIndexEntry &chunk )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( chunk.recordNumber > maxRecordCount_ )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "recordNumber=" + toString( chunk.recordNumber ) +
+                                                 " maxRecordCount=" + toString( maxRecordCount_ ) );
+      }
+
+      DataPacket *dpkt = nullptr;
+      std::unique_ptr<PacketLock> packetLock = lockDataPacket( chunk.packetLogicalOffset, dpkt );
+
+      if ( dpkt->header.packetType != DATA_PACKET )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket,
+                               "packetType=" + toString( dpkt->header.packetType ) );
+      }
+
+      for ( auto &channel : channels_ )
+      {
+         channel.decoder->stateReset( chunk.recordNumber );
+
+         channel.currentPacketLogicalOffset = chunk.packetLogicalOffset;
+         channel.currentBytestreamBufferIndex = 0;
+         channel.currentBytestreamBufferLength =
+            _bytestreamLength( *packetLock, channel.bytestreamNumber );
+         channel.inputFinished = false;
+      }
+
+      recordCount_ = chunk.recordNumber;
+   }
+
+   void CompressedVectorReaderImpl::seek( uint64_t recordNumber )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkReaderOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( recordNumber > recordLimit_ )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "recordNumber=" + toString( recordNumber ) +
+                                  " recordLimit=" + toString( recordLimit_ ) +
+                                  " cvPathName=" + cVector_->pathName() +
+                                  " imageFileName=" + cVector_->imageFileName() );
+      }
+
+      // Seeking to the end doesn't need any input, so just mark everything finished.
+      if ( recordNumber == recordLimit_ )
+      {
+         for ( auto &channel : channels_ )
+         {
+            channel.decoder->stateReset( recordNumber );
+            channel.inputFinished = true;
+         }
+
+         recordCount_ = recordNumber;
+         return;
+      }
+
+      if ( chunks_.empty() )
+      {
+         chunks_ = cVector_->readChunkIndex();
+      }
+
+      // Find the last chunk starting at or before recordNumber. The first chunk starts at 0.
+      auto chunk = std::upper_bound( chunks_.begin(), chunks_.end(), recordNumber,
+                                     []( uint64_t record, const ChunkIndexEntry &entry ) {
+                                        return record < entry.recordNumber;
+                                     } );
+      --chunk;
+
+      // If we are already in that chunk and before the record, carry on from here instead. After
+      // sampled reads the channels may not all be at the same record, so start again.
+      const bool isAtEnd =
+         ( recordCount_ >= maxRecordCount_ ) ||
+         std::any_of( channels_.begin(), channels_.end(),
+                      []( const DecodeChannel &channel ) { return channel.inputFinished; } );
+      const bool isAligned =
+         std::all_of( channels_.begin(), channels_.end(), [this]( const DecodeChannel &channel ) {
+            return channel.decoder->totalRecordsCompleted() == recordCount_;
+         } );
+
+      if ( isAtEnd || !isAligned || ( recordCount_ < chunk->recordNumber ) ||
+           ( recordCount_ > recordNumber ) )
+      {
+         startChunk( *chunk );
+      }
+
+      skipRecords( recordNumber - recordCount_ );
+   }
+
+   // Decode and throw away the next @a count records. The records are decoded into the start of
+   // the current buffers, which read() overwrites anyway. They aren't sampled, filtered or
+   // transformed: all of them are decoded, and none of them is kept.
+   void CompressedVectorReaderImpl::skipRecords( uint64_t count )
+   {
+      size_t minCapacity = SIZE_MAX;
+
+      for ( const auto &channel : channels_ )
+      {
+         minCapacity = std::min( minCapacity, channel.dbuf.impl()->capacity() );
+      }
+
+      std::vector<SourceDestBuffer> originals;
+      originals.reserve( channels_.size() );
+
+      for ( const auto &channel : channels_ )
+      {
+         originals.push_back( channel.dbuf );
+      }
+
+      // Every record skipped is decoded, even those the sampler or filter would drop
+      const RecordSampler sampler = sampler_;
+      const bool cFilterSkipsChunks = filterSkipsChunks_;
+
+      sampler_ = RecordSampler();
+      setDecoderSampler( sampler_ );
+      filterSkipsChunks_ = false;
+
+      auto restoreBuffers = [this, &originals, &sampler, cFilterSkipsChunks]() {
+         for ( size_t i = 0; i < channels_.size(); ++i )
+         {
+            std::vector<SourceDestBuffer> dbuf{ originals[i] };
+
+            channels_[i].dbuf = originals[i];
+            channels_[i].decoder->destBufferSetNew( dbuf );
+         }
+
+         sampler_ = sampler;
+         setDecoderSampler( sampler_ );
+         filterSkipsChunks_ = cFilterSkipsChunks;
+      };
+
+      try
+      {
+         while ( count > 0 )
+         {
+            const auto cBatch = static_cast<size_t>( std::min<uint64_t>( count, minCapacity ) );
+
+            for ( size_t i = 0; i < channels_.size(); ++i )
+            {
+               std::vector<SourceDestBuffer> dbuf{ SourceDestBuffer(
+                  originals[i].impl()->slice( 0, cBatch ) ) };
+
+               channels_[i].dbuf = dbuf[0];
+               channels_[i].decoder->destBufferSetNew( dbuf );
+            }
+
+            // Not read(), which would compact the records by the filter & transform them
+            const unsigned cSkipped = decodeBuffers( 0 );
+
+            if ( cSkipped != cBatch )
+            {
+               throw E57_EXCEPTION2( ErrorBadCVPacket, "skipped=" + toString( cSkipped ) +
+                                                          " expected=" + toString( cBatch ) );
+            }
+
+            count -= cBatch;
+         }
+      }
+      catch ( ... )
+      {
+         restoreBuffers();
+         throw;
+      }
 
-      // !!! implement
-      throw E57_EXCEPTION1( ErrorNotImplemented );
+      restoreBuffers();
    }
 
    bool CompressedVectorReaderImpl::isOpen() const
@@ -563,12 +1475,259 @@ namespace e57
       return ( cVector_ );
    }
 
+   uint64_t CompressedVectorReaderImpl::skippedByteCount() const
+   {
+      return ( cache_ != nullptr ) ? cache_->skippedByteCount()
+                                   : closedStatistics_.skippedByteCount;
+   }
+
+   CompressedVectorReaderStatistics CompressedVectorReaderImpl::statistics() const
+   {
+      if ( cache_ == nullptr )
+      {
+         return closedStatistics_;
+      }
+
+      CompressedVectorReaderStatistics statistics;
+
+      statistics.packetCacheHits = cache_->hitCount();
+      statistics.packetCacheMisses = cache_->missCount();
+      statistics.packetCacheEvictions = cache_->evictionCount();
+      statistics.skippedByteCount = cache_->skippedByteCount();
+      statistics.readAheadSpans = cache_->readAheadSpanCount();
+      statistics.prefetchedSpans = cache_->prefetchedSpanCount();
+      statistics.readAheadWaits = cache_->readAheadWaitCount();
+
+      statistics.bytestreams.reserve( channels_.size() );
+
+      for ( const auto &channel : channels_ )
+      {
+         BytestreamStatistics bytestream;
+
+         bytestream.pathName = channel.dbuf.pathName();
+         bytestream.byteCount = channel.byteCount;
+         bytestream.decodeSeconds = nanosecondsToSeconds( channel.decodeNanoseconds );
+
+         statistics.bytestreams.push_back( bytestream );
+      }
+
+      return statistics;
+   }
+
+   namespace
+   {
+      // Returns the chunk statistics saved beside cVector (see
+      // CompressedVectorWriterImpl::statisticsWrite()), or null if there aren't any.
+      NodeImplSharedPtr
+         findChunkStatistics( const ImageFileImplSharedPtr &imf,
+                              const std::shared_ptr<CompressedVectorNodeImpl> &cVector )
+      {
+         ustring prefix;
+         NodeImplSharedPtr parent = cVector->parent();
+
+         if ( !parent || !imf->extensionsLookupUri( cChunkStatisticsUri, prefix ) )
+         {
+            return nullptr;
+         }
+
+         const ustring cPath =
+            prefix + ":" + cChunkStatisticsElement + "/" + cVector->elementName();
+
+         if ( !parent->isDefined( cPath ) )
+         {
+            return nullptr;
+         }
+
+         NodeImplSharedPtr statistics = parent->get( cPath );
+
+         if ( ( statistics->type() != TypeStructure ) ||
+              !statistics->isDefined( "chunkRecordCount" ) || !statistics->isDefined( "fields" ) ||
+              ( statistics->get( "chunkRecordCount" )->type() != TypeInteger ) )
+         {
+            return nullptr;
+         }
+
+         return statistics;
+      }
+
+      // Returns the blob holding the statistics of the field pathName, or null if there isn't one.
+      std::shared_ptr<BlobNodeImpl> findFieldStatistics( const NodeImplSharedPtr &statistics,
+                                                         const ustring &pathName )
+      {
+         NodeImplSharedPtr fieldsNode = statistics->get( "fields" );
+
+         if ( fieldsNode->type() != TypeVector )
+         {
+            return nullptr;
+         }
+
+         auto fields = std::static_pointer_cast<StructureNodeImpl>( fieldsNode );
+
+         for ( int64_t i = 0; i < fields->childCount(); ++i )
+         {
+            NodeImplSharedPtr field = fields->get( i );
+
+            if ( !field->isDefined( "pathName" ) || !field->isDefined( "values" ) )
+            {
+               continue;
+            }
+
+            NodeImplSharedPtr name = field->get( "pathName" );
+            NodeImplSharedPtr values = field->get( "values" );
+
+            if ( ( name->type() == TypeString ) && ( values->type() == TypeBlob ) &&
+                 ( std::static_pointer_cast<StringNodeImpl>( name )->value() == pathName ) )
+            {
+               return std::static_pointer_cast<BlobNodeImpl>( values );
+            }
+         }
+
+         return nullptr;
+      }
+   }
+
+   std::vector<RecordRange> CompressedVectorReaderImpl::matchingRecordRanges(
+      const std::vector<FieldValueRange> &ranges ) const
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      for ( const auto &range : ranges )
+      {
+         if ( !proto_->isDefined( range.pathName ) )
+         {
+            throw E57_EXCEPTION2( ErrorPathUndefined, "pathName=" + range.pathName +
+                                                         " cvPathName=" + cVector_->pathName() );
+         }
+      }
+
+      if ( maxRecordCount_ == 0 )
+      {
+         return {};
+      }
+
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+      NodeImplSharedPtr statistics = findChunkStatistics( imf, cVector_ );
+
+      if ( !statistics )
+      {
+         return { { 0, maxRecordCount_ } };
+      }
+
+      const int64_t cChunkRecordCount =
+         std::static_pointer_cast<IntegerNodeImpl>( statistics->get( "chunkRecordCount" ) )
+            ->value();
+
+      if ( cChunkRecordCount <= 0 )
+      {
+         return { { 0, maxRecordCount_ } };
+      }
+
+      const auto cChunkRecords = static_cast<uint64_t>( cChunkRecordCount );
+      const auto cChunkCount =
+         static_cast<size_t>( ( maxRecordCount_ + cChunkRecords - 1 ) / cChunkRecords );
+
+      std::vector<bool> matches( cChunkCount, true );
+
+      for ( const auto &range : ranges )
+      {
+         std::shared_ptr<BlobNodeImpl> blob = findFieldStatistics( statistics, range.pathName );
+
+         const uint64_t cByteCount = cChunkCount * 2 * sizeof( int64_t );
+
+         if ( !blob || ( static_cast<uint64_t>( blob->byteCount() ) != cByteCount ) )
+         {
+            continue;
+         }
+
+         std::vector<uint8_t> bytes( static_cast<size_t>( cByteCount ) );
+         blob->read( bytes.data(), 0, bytes.size() );
+
+         NodeImplSharedPtr field = proto_->get( range.pathName );
+
+         for ( size_t chunk = 0; chunk < cChunkCount; ++chunk )
+         {
+            const uint8_t *cValues = &bytes[chunk * 2 * sizeof( int64_t )];
+
+            double minimum = 0.0;
+            double maximum = 0.0;
+
+            if ( field->type() == TypeFloat )
+            {
+               memcpy( &minimum, cValues, sizeof( double ) );
+               memcpy( &maximum, cValues + sizeof( double ), sizeof( double ) );
+            }
+            else
+            {
+               int64_t rawMinimum = 0;
+               int64_t rawMaximum = 0;
+
+               memcpy( &rawMinimum, cValues, sizeof( int64_t ) );
+               memcpy( &rawMaximum, cValues + sizeof( int64_t ), sizeof( int64_t ) );
+
+               minimum = static_cast<double>( rawMinimum );
+               maximum = static_cast<double>( rawMaximum );
+
+               if ( field->type() == TypeScaledInteger )
+               {
+                  auto scaled = std::static_pointer_cast<ScaledIntegerNodeImpl>( field );
+
+                  minimum = minimum * scaled->scale() + scaled->offset();
+                  maximum = maximum * scaled->scale() + scaled->offset();
+
+                  // A negative scale reverses the order
+                  if ( minimum > maximum )
+                  {
+                     std::swap( minimum, maximum );
+                  }
+               }
+            }
+
+            if ( ( maximum < range.minimum ) || ( minimum > range.maximum ) )
+            {
+               matches[chunk] = false;
+            }
+         }
+      }
+
+      // Merge runs of matching chunks
+      std::vector<RecordRange> recordRanges;
+
+      for ( size_t chunk = 0; chunk < cChunkCount; ++chunk )
+      {
+         if ( !matches[chunk] )
+         {
+            continue;
+         }
+
+         const uint64_t cFirst = chunk * cChunkRecords;
+         const uint64_t cCount = std::min( cChunkRecords, maxRecordCount_ - cFirst );
+
+         if ( !recordRanges.empty() && ( recordRanges.back().firstRecord +
+                                            recordRanges.back().recordCount ==
+                                         cFirst ) )
+         {
+            recordRanges.back().recordCount += cCount;
+         }
+         else
+         {
+            recordRanges.push_back( { cFirst, cCount } );
+         }
+      }
+
+      return recordRanges;
+   }
+
    void CompressedVectorReaderImpl::close()
    {
       // Before anything that can throw, decrement reader count
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
       imf->decrReaderCount();
 
+      if ( cache_ != nullptr )
+      {
+         imf->removeReadAheadCache( cache_ );
+      }
+
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
       // No error if reader not open
@@ -577,9 +1736,13 @@ namespace e57
          return;
       }
 
+      closedStatistics_ = statistics();
+
       // Destroy decoders
       channels_.clear();
 
+      cache_->finishReadAhead();
+
       delete cache_;
       cache_ = nullptr;
 
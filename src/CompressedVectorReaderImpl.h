@@ -27,24 +27,40 @@
  */
 
 #include "DecodeChannel.h"
+#include "Packet.h"
+#include "RecordCompactor.h"
+#include "RecordSampler.h"
 
 namespace e57
 {
-   class DataPacket;
    class PacketReadCache;
 
    class CompressedVectorReaderImpl
    {
    public:
       CompressedVectorReaderImpl( std::shared_ptr<CompressedVectorNodeImpl> cvi,
-                                  std::vector<SourceDestBuffer> &dbufs );
+                                  std::vector<SourceDestBuffer> &dbufs,
+                                  const PacketCacheOptions &cacheOptions = {} );
       ~CompressedVectorReaderImpl();
 
       unsigned read();
       unsigned read( std::vector<SourceDestBuffer> &dbufs );
+      void rebind( std::vector<SourceDestBuffer> &dbufs );
       void seek( uint64_t recordNumber );
+      void setRecordRange( uint64_t firstRecord, uint64_t recordCount );
+      void startChunk( const ChunkIndexEntry &chunk );
       bool isOpen() const;
       std::shared_ptr<CompressedVectorNodeImpl> compressedVectorNode() const;
+      uint64_t skippedByteCount() const;
+      CompressedVectorReaderStatistics statistics() const;
+      std::vector<RecordRange>
+         matchingRecordRanges( const std::vector<FieldValueRange> &ranges ) const;
+      void setCoordinateTransform( const CoordinateTransform &transform );
+      void clearCoordinateTransform();
+      void setSampling( const RecordSampling &sampling );
+      void setTrustedRanges( bool trusted );
+      void setRecordFilter( const RecordFilter &filter );
+      void setNormalization( const std::vector<FieldNormalization> &normalizations );
       void close();
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -59,9 +75,23 @@ namespace e57
       void setBuffers( std::vector<SourceDestBuffer> &dbufs ); //???needed?
       uint64_t earliestPacketNeededForInput() const;
 
-      DataPacket *dataPacket( uint64_t inLogicalOffset ) const;
+      std::unique_ptr<PacketLock> lockDataPacket( uint64_t offset, DataPacket *&dpkt ) const;
       void feedPacketToDecoders( uint64_t currentPacketLogicalOffset );
       uint64_t findNextDataPacket( uint64_t nextPacketLogicalOffset );
+      void skipRecords( uint64_t count );
+      unsigned decodeBuffers( unsigned firstIndex );
+      void decodeRecords();
+      void decodeSampledChunks();
+      void decodeFilteredChunks();
+      void setDecoderSampler( const RecordSampler &sampler );
+      void setRecordLimit( uint64_t recordLimit );
+      void applyRangeChecks();
+      void applyNormalizations();
+      void transformCoordinates( unsigned recordCount );
+
+      template <typename T>
+      void transformCoordinates( T *x, size_t xStride, T *y, size_t yStride, T *z, size_t zStride,
+                                 unsigned recordCount );
 
       //??? no default ctor, copy, assignment?
 
@@ -71,9 +101,27 @@ namespace e57
       NodeImplSharedPtr proto_;
       std::vector<DecodeChannel> channels_;
       PacketReadCache *cache_;
+      bool keepsReadingAhead_ = false; /// cache_ reads ahead between reads (see decodeBuffers())
 
-      uint64_t recordCount_; /// number of records written so far
+      uint64_t recordCount_; /// number of records read (or skipped) so far
       uint64_t maxRecordCount_;
+      uint64_t recordLimit_; /// end of the records to read, see setRecordRange()
       uint64_t sectionEndLogicalOffset_;
+      CompressedVectorReaderStatistics closedStatistics_; /// statistics saved by close()
+
+      std::vector<ChunkIndexEntry> chunks_; /// chunk index, read on first seek()
+
+      bool transformCoordinates_ = false;     /// apply coordinateTransform_ to the records read
+      CoordinateTransform coordinateTransform_;
+      size_t coordinateBuffers_[3] = {};      /// index in dbufs_ of the X, Y & Z buffers
+
+      RecordSampler sampler_; /// records returned by read()
+      RecordCompactor compactor_; /// records dropped by read(), see setRecordFilter()
+      std::vector<RecordRange> filterRanges_; /// records which may pass the filter's ranges
+      bool filterSkipsChunks_ = false;        /// only read the chunks of filterRanges_
+
+      bool trustedRanges_ = false; /// skip the checks of values known to fit their buffers
+
+      std::vector<FieldNormalization> normalizations_; /// see setNormalization()
    };
 }
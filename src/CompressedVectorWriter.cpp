@@ -70,8 +70,8 @@ void CompressedVectorWriter::checkInvariant( bool /*doRecurse*/ )
       throw E57_EXCEPTION1( ErrorInvarianceViolation );
    }
 
-   // Dest ImageFile must have exactly 1 writer (this one)
-   if ( imf.writerCount() != 1 )
+   // Dest ImageFile must have at least 1 writer (this one, and others if they are concurrent)
+   if ( imf.writerCount() < 1 )
    {
       throw E57_EXCEPTION1( ErrorInvarianceViolation );
    }
@@ -253,6 +253,91 @@ void CompressedVectorWriter::write( std::vector<SourceDestBuffer> &sbufs, const
    impl_->write( sbufs, recordCount );
 }
 
+/*!
+@brief Encode the records copied into the staging buffers so far.
+
+@details
+If the writer was created with CompressedVectorWriterOptions::stagingRecordCount, the records of
+each write are copied into buffers of the writer, which are encoded once they are full. This
+function encodes the records in them now, so any conversion or bounds error in them is reported by
+this call. The encoded records are written to the file in data packets as those fill up, or when
+the writer is closed. The staged records are also encoded by CompressedVectorWriter::close. If the
+writer isn't staging records, this does nothing.
+
+@pre The associated ImageFile must be open.
+@pre This CompressedVectorWriter must be open (i.e isOpen())
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorWriterNotOpen
+@throw ::ErrorValueOutOfBounds This CompressedVectorWriter in undocumented state, associated
+ImageFile modified but consistent.
+@throw ::ErrorValueNotRepresentable This CompressedVectorWriter in undocumented state, associated
+ImageFile modified but consistent.
+@throw ::ErrorScaledValueNotRepresentable This CompressedVectorWriter in undocumented state,
+associated ImageFile modified but consistent.
+@throw ::ErrorReal64TooLarge This CompressedVectorWriter in undocumented state, associated ImageFile
+modified but consistent.
+@throw ::ErrorWriteFailed This CompressedVectorWriter, associated ImageFile in undocumented state
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompressedVectorWriter::write(unsigned), CompressedVectorWriter::close
+*/
+/*!
+@brief Start writing the next @a recordCount records from the source buffers in the background.
+
+@param [in] recordCount Number of records to write (see CompressedVectorWriter::write(size_t)).
+
+@details
+Does the same as CompressedVectorWriter::write(size_t) on one of the library's background I/O
+threads (kept apart from those of its parallel work) and returns straight away.
+
+The writer & its source buffers belong to the write until it's done: don't use them, or write to the
+writer's ImageFile, from other threads in the meantime. The writer is kept alive by the write, even
+if this object is destroyed first.
+
+@return A future which is ready once the records are written, or holds the exception that write()
+threw.
+
+@throw No E57Exceptions (they are passed on by the future).
+
+@see CompressedVectorWriter::writeAsync(size_t,AsyncCompletion), CompressedVectorWriter::closeAsync
+*/
+std::future<void> CompressedVectorWriter::writeAsync( size_t recordCount )
+{
+   CompressedVectorWriter writer( *this );
+
+   return runAsync( [writer, recordCount]() mutable { writer.write( recordCount ); } );
+}
+
+/*!
+@brief Start writing the next @a recordCount records from the source buffers in the background,
+and call @a completion once it's done.
+
+@param [in] recordCount Number of records to write (see CompressedVectorWriter::write(size_t)).
+@param [in] completion Called on the thread which did the write with nullptr, or the exception that
+write() threw.
+
+@details
+The same as CompressedVectorWriter::writeAsync(size_t), but calls @a completion instead of
+returning a future.
+
+@throw ::ErrorBadAPIArgument If there's no @a completion.
+
+@see CompressedVectorWriter::writeAsync(size_t)
+*/
+void CompressedVectorWriter::writeAsync( size_t recordCount, AsyncCompletion completion )
+{
+   CompressedVectorWriter writer( *this );
+
+   runAsync( [writer, recordCount]() mutable { writer.write( recordCount ); },
+             std::move( completion ) );
+}
+
+void CompressedVectorWriter::flush()
+{
+   impl_->flushStaged();
+}
+
 /*!
 @brief End the write operation.
 
@@ -283,6 +368,52 @@ void CompressedVectorWriter::close()
    impl_->close();
 }
 
+/*!
+@brief Start ending the write operation in the background.
+
+@details
+Does the same as CompressedVectorWriter::close() (encoding the last records, writing the last
+packets & the index, and waiting for those written in the background) on one of the library's
+background I/O threads, and returns straight away.
+
+The writer belongs to the close until it's done: don't use it, or write to the writer's ImageFile,
+from other threads in the meantime.
+
+@return A future which is ready once the writer is closed, or holds the exception that close()
+threw.
+
+@throw No E57Exceptions (they are passed on by the future).
+
+@see CompressedVectorWriter::closeAsync(AsyncCompletion)
+*/
+std::future<void> CompressedVectorWriter::closeAsync()
+{
+   CompressedVectorWriter writer( *this );
+
+   return runAsync( [writer]() mutable { writer.close(); } );
+}
+
+/*!
+@brief Start ending the write operation in the background, and call @a completion once it's done.
+
+@param [in] completion Called on the thread which closed the writer with nullptr, or the exception
+that close() threw.
+
+@details
+The same as CompressedVectorWriter::closeAsync(), but calls @a completion instead of returning a
+future.
+
+@throw ::ErrorBadAPIArgument If there's no @a completion.
+
+@see CompressedVectorWriter::closeAsync()
+*/
+void CompressedVectorWriter::closeAsync( AsyncCompletion completion )
+{
+   CompressedVectorWriter writer( *this );
+
+   runAsync( [writer]() mutable { writer.close(); }, std::move( completion ) );
+}
+
 /*!
 @brief Test whether CompressedVectorWriter is still open for writing.
 
@@ -315,6 +446,23 @@ CompressedVectorNode CompressedVectorWriter::compressedVectorNode() const
    return impl_->compressedVectorNode();
 }
 
+/*!
+@brief Return the number of packets & bytes of each bytestream written by this writer so far.
+
+@details
+The bytestreams are in the order of the fields of the prototype. Data still buffered in the encoders
+isn't counted until it is written in a packet, so the totals are only complete once the writer is
+closed. It is not an error if this CompressedVectorWriter is closed.
+
+@return The statistics gathered so far.
+
+@see ImageFile::statistics
+*/
+CompressedVectorWriterStatistics CompressedVectorWriter::statistics() const
+{
+   return impl_->statistics();
+}
+
 /*!
 @brief Diagnostic function to print internal state of object to output stream in an indented format.
 @copydetails Node::dump()
@@ -25,19 +25,55 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <limits>
 #include <numeric>
+#include <mutex>
+#include <system_error>
 
+#include "BlobNodeImpl.h"
 #include "CheckedFile.h"
+#include "Codecs.h"
 #include "CompressedVectorNodeImpl.h"
 #include "CompressedVectorWriterImpl.h"
 #include "ImageFileImpl.h"
+#include "IntegerNodeImpl.h"
+#include "ScaledIntegerNodeImpl.h"
 #include "SectionHeaders.h"
 #include "SourceDestBufferImpl.h"
 #include "StringFunctions.h"
+#include "StringNodeImpl.h"
+#include "Tracing.h"
+#include "VectorNodeImpl.h"
 
 namespace e57
 {
+   // Chunks start on a multiple of this many records. No encoder register is wider than 64 bits,
+   // so at these boundaries the bit-packed bytestreams always end on a whole register and nothing
+   // needs to be padded. This keeps the bytestreams the same as if they had not been chunked.
+   constexpr uint64_t cChunkRecordAlignment = 64;
+
+   // Approximate amount of bytestream data in each chunk
+   constexpr float cChunkTargetBytes = 1024.0f * 1024.0f;
+
+   // Buffer of @a capacity packed values of type T, stored in @a bytes, with the settings of
+   // @a sbuf. Used to stage the records of the caller's buffers.
+   template <typename T>
+   std::shared_ptr<SourceDestBufferImpl> packedBuffer( const SourceDestBufferImpl &sbuf,
+                                                       std::vector<char> &bytes, size_t capacity )
+   {
+      bytes.resize( capacity * sizeof( T ) );
+
+      auto buffer = std::make_shared<SourceDestBufferImpl>(
+         sbuf.destImageFile(), sbuf.pathName(), capacity, sbuf.doConversion(), sbuf.doScaling() );
+
+      buffer->setTypeInfo( reinterpret_cast<T *>( bytes.data() ) );
+
+      return buffer;
+   }
+
    struct SortByBytestreamNumber
    {
       bool operator()( const std::shared_ptr<Encoder> &lhs,
@@ -48,8 +84,10 @@ namespace e57
    };
 
    CompressedVectorWriterImpl::CompressedVectorWriterImpl(
-      std::shared_ptr<CompressedVectorNodeImpl> ni, std::vector<SourceDestBuffer> &sbufs ) :
-      cVector_( ni ), isOpen_( false ) // set to true when succeed below
+      std::shared_ptr<CompressedVectorNodeImpl> ni, std::vector<SourceDestBuffer> &sbufs,
+      const CompressedVectorWriterOptions &options ) :
+      cVector_( ni ), isOpen_( false ), // set to true when succeed below
+      fillPackets_( options.fillPackets ), encodeExecutor_( options.encodeExecutor )
    {
       //???  check if cvector already been written (can't write twice)
 
@@ -67,13 +105,27 @@ namespace e57
       // Check sbufs well formed (matches proto exactly)
       setBuffers( sbufs ); //??? copy code here?
 
+      if ( options.stagingRecordCount > 0 )
+      {
+         setUpStaging( options.stagingRecordCount );
+      }
+
+      // When staging, the encoders read the staging buffers instead of the caller's
+      std::vector<SourceDestBuffer> &encodeBufs = stagingBufs_.empty() ? sbufs_ : stagingBufs_;
+
+      setUpCodecs( options );
+
+      bytestreamPaths_.resize( sbufs_.size() );
+      bytestreamByteCounts_.resize( sbufs_.size(), 0 );
+      bytestreamBuffers_.resize( sbufs_.size(), 0 );
+
       // For each individual sbuf, create an appropriate Encoder based on the
       // cVector_ attributes
       for ( unsigned i = 0; i < sbufs_.size(); i++ )
       {
          // Create vector of single sbuf  ??? for now, may have groups later
          std::vector<SourceDestBuffer> vTemp;
-         vTemp.push_back( sbufs_.at( i ) );
+         vTemp.push_back( encodeBufs.at( i ) );
 
          ustring codecPath = sbufs_.at( i ).pathName();
 
@@ -86,6 +138,12 @@ namespace e57
             throw E57_EXCEPTION2( ErrorInternal, "sbufIndex=" + toString( i ) );
          }
 
+         if ( bytestreamNumber < bytestreamPaths_.size() )
+         {
+            bytestreamPaths_[bytestreamNumber] = codecPath;
+            bytestreamBuffers_[bytestreamNumber] = i;
+         }
+
          // EncoderFactory picks the appropriate encoder to match type declared in
          // prototype
          bytestreams_.push_back( Encoder::EncoderFactory( static_cast<unsigned>( bytestreamNumber ),
@@ -108,13 +166,117 @@ namespace e57
       }
 #endif
 
+      setUpPacketGroups( options.packetFieldGroups );
+
+      // Pick a chunk size which gives roughly cChunkTargetBytes of data per chunk, or the number
+      // of packets asked for.
+      float totalBitsPerRecord = 0;
+      for ( auto &bytestream : bytestreams_ )
+      {
+         totalBitsPerRecord += bytestream->bitsPerRecord();
+      }
+
+      const float cChunkBytes = ( options.indexPacketInterval > 0 )
+                                   ? static_cast<float>( options.indexPacketInterval ) *
+                                        static_cast<float>( DATA_PACKET_MAX )
+                                   : cChunkTargetBytes;
+
+      const auto cChunkRecords =
+         static_cast<uint64_t>( cChunkBytes * 8.0f / std::max( totalBitsPerRecord, 1.0f ) );
+
+      chunkRecordCount_ = std::max(
+         cChunkRecordAlignment, cChunkRecords / cChunkRecordAlignment * cChunkRecordAlignment );
+      chunkStartRecord_ = 0;
+      chunkStartPending_ = true;
+
+      const uint64_t cExpectedRecords = options.expectedRecordCount;
+
+      if ( cExpectedRecords > 0 )
+      {
+         // Spread the records evenly over the chunks instead of ending with a small one, so they
+         // take about the same time to decode in parallel.
+         const uint64_t cChunkCount =
+            ( cExpectedRecords + chunkRecordCount_ - 1 ) / chunkRecordCount_;
+         const uint64_t cEvenRecords = ( cExpectedRecords + cChunkCount - 1 ) / cChunkCount;
+
+         chunkRecordCount_ = ( cEvenRecords + cChunkRecordAlignment - 1 ) /
+                             cChunkRecordAlignment * cChunkRecordAlignment;
+
+         chunkIndex_.reserve( static_cast<size_t>( cChunkCount ) );
+      }
+
+      if ( options.chunkStatistics )
+      {
+         saveStatistics_ = true;
+         setUpChunkStatistics();
+      }
+
+      if ( options.checkFloatLimits )
+      {
+         for ( auto &bytestream : bytestreams_ )
+         {
+            bytestream->setCheckFloatLimits( true );
+         }
+      }
+
+      // There's no point in more threads than bytestreams
+      encodeThreadCount_ = std::min( resolveThreadCount( options.encodeThreadCount ),
+                                     static_cast<unsigned>( bytestreams_.size() ) );
+
       ImageFileImplSharedPtr imf( ni->destImageFile_ );
 
+      concurrent_ = options.concurrent;
+
+      // A concurrent writer doesn't touch the file until it's closed, so it has nothing to write
+      // in the background
+      if ( options.backgroundWrite && !concurrent_ )
+      {
+         if ( options.writeQueuePacketCount == 0 )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                  "writeQueuePacketCount=" +
+                                     toString( options.writeQueuePacketCount ) +
+                                     " imageFileName=" + cVector_->imageFileName() );
+         }
+
+         try
+         {
+            writeQueue_.reset( new PacketWriteQueue( imf->file_, options.writeQueuePacketCount ) );
+         }
+         catch ( const std::system_error & )
+         {
+            // Couldn't start the thread, so just write in the foreground
+         }
+      }
+
+      if ( cExpectedRecords > 0 )
+      {
+         // Ask for the space of the whole section up front. Add a little for the packet headers &
+         // the index.
+         const auto cDataBytes =
+            static_cast<uint64_t>( static_cast<double>( cExpectedRecords ) *
+                                   std::max( totalBitsPerRecord, 1.0f ) / 8.0 );
+
+         const uint64_t cSectionBytes = sizeof( CompressedVectorSectionHeader ) + cDataBytes +
+                                        cDataBytes / 64 + DATA_PACKET_MAX;
+
+         if ( concurrent_ )
+         {
+            spool_.reserve( static_cast<size_t>( cSectionBytes ) );
+            spoolMemory_.set( Memory::Writers, spool_.capacity() );
+         }
+         else
+         {
+            imf->reserveSpace( cSectionBytes );
+         }
+      }
+
       // Reserve space for CompressedVector binary section header, record location
       // so can save to when writer closes. Request that file be extended with
       // zeros since we will write to it at a later time (when writer closes).
+      // A concurrent writer places its whole section when it's closed.
       sectionHeaderLogicalStart_ =
-         imf->allocateSpace( sizeof( CompressedVectorSectionHeader ), true );
+         concurrent_ ? 0 : imf->allocateSpace( sizeof( CompressedVectorSectionHeader ), true );
 
       sectionLogicalLength_ = 0;
       dataPhysicalOffset_ = 0;
@@ -125,7 +287,14 @@ namespace e57
 
       // Just before return (and can't throw) increment writer count  ??? safer
       // way to assure don't miss close?
-      imf->incrWriterCount();
+      imf->incrWriterCount( concurrent_ );
+
+      if ( !concurrent_ )
+      {
+         imf->setPacketWriteQueue( writeQueue_.get() );
+      }
+
+      memory_.set( Memory::Writers, sizeof( DataPacket ) );
 
       // If get here, the writer is open
       isOpen_ = true;
@@ -148,6 +317,17 @@ namespace e57
       {
          //??? report?
       }
+
+      // If close() failed before finishing the background writes, stop the ImageFile using them
+      if ( writeQueue_ )
+      {
+         ImageFileImplSharedPtr imf( cVector_->destImageFile_.lock() );
+
+         if ( imf && ( imf->packetWriteQueue_ == writeQueue_.get() ) )
+         {
+            imf->setPacketWriteQueue( nullptr );
+         }
+      }
    }
 
    void CompressedVectorWriterImpl::close()
@@ -157,8 +337,13 @@ namespace e57
 #endif
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
 
-      // Before anything that can throw, decrement writer count
-      imf->decrWriterCount();
+      // Before anything that can throw, decrement writer count. A concurrent writer is counted
+      // until its section is in the file, so no other kind of writer can start adding to the end
+      // of the file before then.
+      if ( !concurrent_ )
+      {
+         imf->decrWriterCount();
+      }
 
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
       // don't call checkWriterOpen();
@@ -172,6 +357,33 @@ namespace e57
       // try to close again.
       isOpen_ = false;
 
+      if ( !concurrent_ )
+      {
+         finishSection();
+         return;
+      }
+
+      try
+      {
+         finishSection();
+      }
+      catch ( ... )
+      {
+         imf->decrWriterCount( true );
+         throw;
+      }
+
+      imf->decrWriterCount( true );
+   }
+
+   // Write the records left, the index & the section header.
+   void CompressedVectorWriterImpl::finishSection()
+   {
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+
+      // Encode the records still in the staging buffers
+      writeStaged();
+
       // If have any data, write packet
       // Write all remaining ioBuffers and internal encoder register cache into
       // file. Know we are done when totalOutputAvailable() returns 0 after a
@@ -179,12 +391,31 @@ namespace e57
       flush();
       while ( totalOutputAvailable() > 0 )
       {
-         packetWrite();
+         packetWriteAll();
          flush();
       }
 
-      // Write one index packet (required by standard).
-      packetWriteIndex();
+      // The index & section header are written directly, so wait for the data packets first
+      if ( writeQueue_ )
+      {
+         imf->setPacketWriteQueue( nullptr );
+
+         std::unique_ptr<PacketWriteQueue> writeQueue( std::move( writeQueue_ ) );
+         writeQueue->finish();
+      }
+
+      // Concurrent writers add their sections to the end of the file one at a time
+      std::unique_lock<std::mutex> concurrentWriteLock;
+
+      if ( concurrent_ )
+      {
+         concurrentWriteLock = std::unique_lock<std::mutex>( imf->concurrentWriteMutex() );
+
+         placeSpooledPackets();
+      }
+
+      // Write the chunk index (at least one index packet is required by the standard).
+      indexWrite();
 
       // Compute length of whole section we just wrote (from section start to
       // current start of free space).
@@ -219,6 +450,11 @@ namespace e57
       cVector_->setRecordCount( recordCount_ );
       cVector_->setBinarySectionLogicalStart( sectionHeaderLogicalStart_ );
 
+      if ( saveStatistics_ && ( recordCount_ > 0 ) )
+      {
+         statisticsWrite();
+      }
+
       // Free channels
       bytestreams_.clear();
 
@@ -241,6 +477,35 @@ namespace e57
       return cVector_;
    }
 
+   CompressedVectorWriterStatistics CompressedVectorWriterImpl::statistics() const
+   {
+      CompressedVectorWriterStatistics statistics;
+
+      statistics.dataPacketCount = dataPacketsCount_;
+      statistics.indexPacketCount = indexPacketsCount_;
+      statistics.dataPacketByteCount = dataPacketBytes_;
+
+      if ( dataPacketsCount_ > 0 )
+      {
+         statistics.dataPacketFill = static_cast<double>( dataPacketBytes_ ) /
+                                     ( static_cast<double>( dataPacketsCount_ ) * DATA_PACKET_MAX );
+      }
+
+      statistics.bytestreams.reserve( bytestreamPaths_.size() );
+
+      for ( size_t i = 0; i < bytestreamPaths_.size(); ++i )
+      {
+         BytestreamStatistics bytestream;
+
+         bytestream.pathName = bytestreamPaths_[i];
+         bytestream.byteCount = bytestreamByteCounts_[i];
+
+         statistics.bytestreams.push_back( bytestream );
+      }
+
+      return statistics;
+   }
+
    void CompressedVectorWriterImpl::setBuffers( std::vector<SourceDestBuffer> &sbufs )
    {
       // don't checkImageFileOpen
@@ -281,9 +546,173 @@ namespace e57
       // don't checkWriterOpen(), write(unsigned) will do it
 
       setBuffers( sbufs );
+
+      // Unless staging, encode from the new buffers
+      if ( stagingBufs_.empty() )
+      {
+         for ( size_t i = 0; i < bytestreams_.size(); ++i )
+         {
+            std::vector<SourceDestBuffer> vTemp{ sbufs_.at( bytestreamBuffers_[i] ) };
+
+            bytestreams_[i]->sourceBufferSetNew( vTemp );
+         }
+      }
+
       write( requestedRecordCount );
    }
 
+   void CompressedVectorWriterImpl::flushStaged()
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkWriterOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      writeStaged();
+   }
+
+   void CompressedVectorWriterImpl::writeStaged()
+   {
+      if ( stagedRecordCount_ == 0 )
+      {
+         return;
+      }
+
+      for ( auto &sbuf : stagingBufs_ )
+      {
+         sbuf.impl()->rewind();
+      }
+
+      const size_t cRecordCount = stagedRecordCount_;
+
+      stagedRecordCount_ = 0;
+
+      encodeRecords( cRecordCount );
+
+      for ( auto &strings : stagingStrings_ )
+      {
+         strings.clear();
+      }
+   }
+
+   void CompressedVectorWriterImpl::setUpStaging( size_t recordCount )
+   {
+      stagingBufs_.reserve( sbufs_.size() );
+      stagingBytes_.resize( sbufs_.size() );
+      stagingStrings_.resize( sbufs_.size() );
+
+      for ( size_t i = 0; i < sbufs_.size(); ++i )
+      {
+         const SourceDestBufferImpl &sbuf = *sbufs_[i].impl();
+         std::vector<char> &bytes = stagingBytes_[i];
+
+         std::shared_ptr<SourceDestBufferImpl> staging;
+
+         switch ( sbuf.memoryRepresentation() )
+         {
+            case Int8:
+               staging = packedBuffer<int8_t>( sbuf, bytes, recordCount );
+               break;
+            case UInt8:
+               staging = packedBuffer<uint8_t>( sbuf, bytes, recordCount );
+               break;
+            case Int16:
+               staging = packedBuffer<int16_t>( sbuf, bytes, recordCount );
+               break;
+            case UInt16:
+               staging = packedBuffer<uint16_t>( sbuf, bytes, recordCount );
+               break;
+            case Int32:
+               staging = packedBuffer<int32_t>( sbuf, bytes, recordCount );
+               break;
+            case UInt32:
+               staging = packedBuffer<uint32_t>( sbuf, bytes, recordCount );
+               break;
+            case Int64:
+               staging = packedBuffer<int64_t>( sbuf, bytes, recordCount );
+               break;
+            case Bool:
+               staging = packedBuffer<bool>( sbuf, bytes, recordCount );
+               break;
+            case Real16:
+               staging = packedBuffer<Float16>( sbuf, bytes, recordCount );
+               break;
+            case Real32:
+               staging = packedBuffer<float>( sbuf, bytes, recordCount );
+               break;
+            case Real64:
+               staging = packedBuffer<double>( sbuf, bytes, recordCount );
+               break;
+            case UString:
+               staging = std::make_shared<SourceDestBufferImpl>(
+                  sbuf.destImageFile(), sbuf.pathName(), &stagingStrings_[i], recordCount );
+               break;
+         }
+
+         stagingBufs_.push_back( SourceDestBuffer( staging ) );
+      }
+   }
+
+   void CompressedVectorWriterImpl::stage( size_t recordCount )
+   {
+      const size_t cCapacity = stagingBufs_.at( 0 ).impl()->capacity();
+
+      size_t copied = 0;
+
+      while ( copied < recordCount )
+      {
+         const size_t cCount = std::min( recordCount - copied, cCapacity - stagedRecordCount_ );
+
+         for ( size_t i = 0; i < sbufs_.size(); ++i )
+         {
+            SourceDestBufferImpl &sbuf = *sbufs_[i].impl();
+
+            if ( sbuf.memoryRepresentation() == UString )
+            {
+               // Strings are read in order, so the caller's arena offsets are checked
+               for ( size_t record = 0; record < cCount; ++record )
+               {
+                  const char *chars = nullptr;
+                  size_t length = 0;
+
+                  sbuf.getNextString( chars, length );
+                  stagingStrings_[i].append( chars, length );
+               }
+
+               continue;
+            }
+
+            const SourceDestBufferImpl &staging = *stagingBufs_[i].impl();
+
+            const size_t cElementSize = staging.stride();
+
+            const char *source = static_cast<const char *>( sbuf.base() ) + copied * sbuf.stride();
+            char *dest = static_cast<char *>( staging.base() ) + stagedRecordCount_ * cElementSize;
+
+            if ( sbuf.stride() == cElementSize )
+            {
+               memcpy( dest, source, cCount * cElementSize );
+            }
+            else
+            {
+               for ( size_t record = 0; record < cCount; ++record )
+               {
+                  memcpy( dest, source, cElementSize );
+
+                  source += sbuf.stride();
+                  dest += cElementSize;
+               }
+            }
+         }
+
+         stagedRecordCount_ += cCount;
+         copied += cCount;
+
+         if ( stagedRecordCount_ == cCapacity )
+         {
+            writeStaged();
+         }
+      }
+   }
+
    void CompressedVectorWriterImpl::write( const size_t requestedRecordCount )
    {
 #ifdef E57_VERBOSE
@@ -314,23 +743,45 @@ namespace e57
          sbuf.impl()->rewind();
       }
 
+      if ( !stagingBufs_.empty() )
+      {
+         stage( requestedRecordCount );
+         return;
+      }
+
+      encodeRecords( requestedRecordCount );
+   }
+
+   void CompressedVectorWriterImpl::encodeRecords( const size_t requestedRecordCount )
+   {
       // Loop until all channels have completed requestedRecordCount transfers
-      uint64_t endRecordIndex = recordCount_ + requestedRecordCount;
+      const uint64_t endRecordIndex = recordCount_ + requestedRecordCount;
       while ( true )
       {
+         // Don't let any channel get past the end of the current chunk
+         const uint64_t chunkEndRecord = chunkStartRecord_ + chunkRecordCount_;
+         const uint64_t stopRecordIndex = std::min( endRecordIndex, chunkEndRecord );
+
          // Calc remaining record counts for all channels
          uint64_t totalRecordCount = 0;
          for ( auto &bytestream : bytestreams_ )
          {
-            totalRecordCount += endRecordIndex - bytestream->currentRecordIndex();
+            totalRecordCount += stopRecordIndex - bytestream->currentRecordIndex();
          }
 #ifdef E57_VERBOSE
          std::cout << "  totalRecordCount=" << totalRecordCount << std::endl; //???
 #endif
 
-         // We are done if have no more work, break out of loop
          if ( totalRecordCount == 0 )
          {
+            // If all channels are at the end of the chunk, write it out and start the next one
+            if ( stopRecordIndex == chunkEndRecord )
+            {
+               chunkFinish();
+               continue;
+            }
+
+            // We are done if have no more work, break out of loop
             break;
          }
 
@@ -353,10 +804,24 @@ namespace e57
 #else
          constexpr size_t E57_TARGET_PACKET_SIZE = ( DATA_PACKET_MAX * 3 / 4 );
 #endif
+         const size_t cTargetPacketSize = fillPackets_ ? DATA_PACKET_MAX : E57_TARGET_PACKET_SIZE;
+
          // If have more than target fraction of packet, send it now
-         if ( currentPacketSize() >= E57_TARGET_PACKET_SIZE )
-         { //???
-            packetWrite();
+         bool wrotePacket = false;
+
+         for ( size_t group = 0; group < packetGroups_.size(); ++group )
+         {
+            if ( sizeof( DataPacketHeader ) + bytestreams_.size() * sizeof( uint16_t ) +
+                    groupOutputAvailable( group ) >=
+                 cTargetPacketSize )
+            {
+               packetWrite( group );
+               wrotePacket = true;
+            }
+         }
+
+         if ( wrotePacket )
+         {
             continue; // restart loop so recalc statistics (packet size may not be
                       // zero after write, if have too much data)
          }
@@ -376,21 +841,59 @@ namespace e57
          std::cout << "  totalBytesPerRecord=" << totalBytesPerRecord << std::endl; //???
 #endif
 
-         // Don't allow straggler to get too far behind. ???
-         // Don't allow a single channel to get too far ahead ???
-         // Process channels that are furthest behind first. ???
+         const uint64_t cRecordsBefore = totalRecordCount;
 
-         // !!!! For now just process one record per loop until packet is full
-         // enough, or completed request
-         for ( auto &bytestream : bytestreams_ )
+         if ( encodesInParallel() )
+         {
+            encodeParallel( stopRecordIndex, cTargetPacketSize - currentPacketSize() );
+         }
+         else
+         {
+            // Don't allow straggler to get too far behind. ???
+            // Don't allow a single channel to get too far ahead ???
+            // Process channels that are furthest behind first. ???
+
+            // When filling packets, step every bytestream by the records estimated to fill the
+            // packet, so they reach its end together. Otherwise process up to 50 records at a
+            // time until the packet is full enough, or completed request.
+            const uint64_t cStep = fillPackets_ ? recordsToFillPacket( cTargetPacketSize ) : 50;
+
+            for ( auto &bytestream : bytestreams_ )
+            {
+               if ( bytestream->currentRecordIndex() < stopRecordIndex )
+               {
+                  const uint64_t recordCount =
+                     std::min( stopRecordIndex - bytestream->currentRecordIndex(), cStep );
+
+                  bytestream->processRecords( static_cast<size_t>( recordCount ) );
+               }
+            }
+         }
+
+         // An encoder stops when its output buffer is full. If none could go on, the packet
+         // can't get any fuller, so write the fullest group.
+         if ( fillPackets_ )
          {
-            if ( bytestream->currentRecordIndex() < endRecordIndex )
+            uint64_t recordsLeft = 0;
+
+            for ( auto &bytestream : bytestreams_ )
+            {
+               recordsLeft += stopRecordIndex - bytestream->currentRecordIndex();
+            }
+
+            if ( recordsLeft == cRecordsBefore )
             {
-               // !!! For now, process up to 50 records at a time
-               uint64_t recordCount = endRecordIndex - bytestream->currentRecordIndex();
-               recordCount =
-                  ( recordCount < 50ULL ) ? recordCount : 50ULL; // min(recordCount, 50ULL);
-               bytestream->processRecords( static_cast<unsigned>( recordCount ) );
+               size_t fullestGroup = 0;
+
+               for ( size_t group = 1; group < packetGroups_.size(); ++group )
+               {
+                  if ( groupOutputAvailable( group ) > groupOutputAvailable( fullestGroup ) )
+                  {
+                     fullestGroup = group;
+                  }
+               }
+
+               packetWrite( fullestGroup );
             }
          }
       }
@@ -401,6 +904,65 @@ namespace e57
       // ioBuffers as well as partial words in Encoder registers.
    }
 
+   bool CompressedVectorWriterImpl::encodesInParallel() const
+   {
+      return ( encodeExecutor_ || ( encodeThreadCount_ > 1 ) ) && ( bytestreams_.size() > 1 );
+   }
+
+   void CompressedVectorWriterImpl::encodeParallel( uint64_t stopRecordIndex,
+                                                    size_t spaceInPacket )
+   {
+      // Estimate how many records will fill the rest of the packet, and have every bytestream
+      // encode up to that record on its own task. Each encoder has its own source buffer and
+      // output buffer, so they don't share any state.
+      float totalBitsPerRecord = 0;
+      uint64_t lowestRecordIndex = stopRecordIndex;
+
+      for ( auto &bytestream : bytestreams_ )
+      {
+         totalBitsPerRecord += bytestream->bitsPerRecord();
+         lowestRecordIndex = std::min( lowestRecordIndex, bytestream->currentRecordIndex() );
+      }
+
+      const float totalBytesPerRecord = std::max( totalBitsPerRecord / 8, 0.1F );
+
+      const auto cRecordCount =
+         std::max<uint64_t>( 1, static_cast<uint64_t>( spaceInPacket / totalBytesPerRecord ) );
+
+      const uint64_t targetRecordIndex =
+         std::min( stopRecordIndex, lowestRecordIndex + cRecordCount );
+
+      std::vector<Task> tasks;
+
+      for ( auto &bytestream : bytestreams_ )
+      {
+         if ( bytestream->currentRecordIndex() >= targetRecordIndex )
+         {
+            continue;
+         }
+
+         Encoder *encoder = bytestream.get();
+
+         tasks.emplace_back( [encoder, targetRecordIndex]() {
+            // Stop early if the encoder's output buffer is full
+            while ( encoder->currentRecordIndex() < targetRecordIndex )
+            {
+               const uint64_t recordIndex = encoder->currentRecordIndex();
+
+               encoder->processRecords(
+                  static_cast<size_t>( targetRecordIndex - recordIndex ) );
+
+               if ( encoder->currentRecordIndex() == recordIndex )
+               {
+                  break;
+               }
+            }
+         } );
+      }
+
+      runTasks( tasks, encodeThreadCount_, encodeExecutor_ );
+   }
+
    size_t CompressedVectorWriterImpl::totalOutputAvailable() const
    {
       size_t total = 0;
@@ -413,21 +975,461 @@ namespace e57
       return total;
    }
 
-   size_t CompressedVectorWriterImpl::currentPacketSize() const
+   size_t CompressedVectorWriterImpl::groupOutputAvailable( size_t group ) const
    {
-      // Calc current packet size
-      return ( sizeof( DataPacketHeader ) + bytestreams_.size() * sizeof( uint16_t ) +
-               totalOutputAvailable() );
+      size_t total = 0;
+
+      for ( const auto bytestreamIndex : packetGroups_[group] )
+      {
+         total += bytestreams_[bytestreamIndex]->outputAvailable();
+      }
+
+      return total;
    }
 
-   uint64_t CompressedVectorWriterImpl::packetWrite()
+   uint64_t CompressedVectorWriterImpl::recordsToFillPacket( size_t targetPacketSize ) const
    {
-#ifdef E57_VERBOSE
-      std::cout << "CompressedVectorWriterImpl::packetWrite() called" << std::endl; //???
+      // The fewest records which fill the packet of any group, estimated from the bits per
+      // record of its bytestreams
+      const size_t cHeaderSize =
+         sizeof( DataPacketHeader ) + bytestreams_.size() * sizeof( uint16_t );
+
+      uint64_t recordCount = UINT64_MAX;
+
+      for ( size_t group = 0; group < packetGroups_.size(); ++group )
+      {
+         const size_t cPacketSize = cHeaderSize + groupOutputAvailable( group );
+         const size_t cSpace =
+            ( cPacketSize < targetPacketSize ) ? targetPacketSize - cPacketSize : 0;
+
+         float bitsPerRecord = 0;
+
+         for ( const auto bytestreamIndex : packetGroups_[group] )
+         {
+            bitsPerRecord += bytestreams_[bytestreamIndex]->bitsPerRecord();
+         }
+
+         // Constant fields don't add anything to the packet
+         if ( bitsPerRecord > 0 )
+         {
+            const auto cGroupRecords =
+               static_cast<uint64_t>( static_cast<float>( cSpace ) * 8 / bitsPerRecord );
+
+            recordCount = std::min( recordCount, cGroupRecords );
+         }
+      }
+
+      return std::max<uint64_t>( 1, std::min<uint64_t>( recordCount, UINT32_MAX ) );
+   }
+
+   size_t CompressedVectorWriterImpl::currentPacketSize() const
+   {
+      // Calc current packet size. With several packet groups this is the fullest one.
+      size_t largestOutput = 0;
+
+      for ( size_t group = 0; group < packetGroups_.size(); ++group )
+      {
+         largestOutput = std::max( largestOutput, groupOutputAvailable( group ) );
+      }
+
+      return ( sizeof( DataPacketHeader ) + bytestreams_.size() * sizeof( uint16_t ) +
+               largestOutput );
+   }
+
+   // Add the codecs of the fields to encode with the delta & LZ codecs, so the encoders (& later
+   // the readers) find them. Fields which aren't being written, whose type the codec doesn't
+   // handle, or which already have a codec are ignored.
+   void CompressedVectorWriterImpl::setUpCodecs( const CompressedVectorWriterOptions &options )
+   {
+      auto add = [this]( const ustring &field, Codec codec ) {
+         const auto found =
+            std::find_if( sbufs_.begin(), sbufs_.end(), [&field]( const SourceDestBuffer &sbuf ) {
+               return sbuf.pathName() == field;
+            } );
+
+         if ( ( found == sbufs_.end() ) || ( findCodec( *cVector_, field ) != Codec::BitPack ) )
+         {
+            return;
+         }
+
+         const NodeType cType = proto_->get( field )->type();
+
+         if ( ( codec == Codec::Lz ) || ( cType == TypeInteger ) || ( cType == TypeScaledInteger ) )
+         {
+            addCodec( *cVector_, field, codec );
+         }
+      };
+
+      for ( const auto &field : options.deltaCodecFields )
+      {
+         add( field, Codec::DeltaInteger );
+      }
+
+      for ( const auto &field : options.lzCodecFields )
+      {
+         add( field, Codec::Lz );
+      }
+   }
+
+   // Split the bytestreams into the packet groups requested in the options. Every data packet has
+   // a buffer for each bytestream, but the packets of a group leave the buffers of the other
+   // groups empty. Fields which aren't in any group share one more group. With a single group
+   // (the default) all the bytestreams are interleaved in every packet.
+   void CompressedVectorWriterImpl::setUpPacketGroups(
+      const std::vector<std::vector<ustring>> &fieldGroups )
+   {
+      constexpr size_t cNoGroup = SIZE_MAX;
+
+      std::vector<size_t> groupOf( bytestreams_.size(), cNoGroup );
+      size_t groupCount = 0;
+
+      for ( const auto &fields : fieldGroups )
+      {
+         bool groupUsed = false;
+
+         for ( const auto &field : fields )
+         {
+            // Fields which aren't being written (e.g. colour in a file without it) are ignored
+            const auto found =
+               std::find( bytestreamPaths_.begin(), bytestreamPaths_.end(), field );
+
+            if ( found == bytestreamPaths_.end() )
+            {
+               continue;
+            }
+
+            size_t &group = groupOf[static_cast<size_t>( found - bytestreamPaths_.begin() )];
+
+            if ( ( group != cNoGroup ) && ( group != groupCount ) )
+            {
+               throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                     "fieldName=" + field +
+                                        " imageFileName=" + cVector_->imageFileName() +
+                                        " cvPathName=" + cVector_->pathName() );
+            }
+
+            group = groupCount;
+            groupUsed = true;
+         }
+
+         if ( groupUsed )
+         {
+            ++groupCount;
+         }
+      }
+
+      packetGroups_.resize( groupCount );
+
+      std::vector<size_t> ungrouped;
+
+      for ( size_t i = 0; i < groupOf.size(); ++i )
+      {
+         if ( groupOf[i] == cNoGroup )
+         {
+            ungrouped.push_back( i );
+         }
+         else
+         {
+            packetGroups_[groupOf[i]].push_back( i );
+         }
+      }
+
+      if ( !ungrouped.empty() )
+      {
+         packetGroups_.push_back( ungrouped );
+      }
+   }
+
+   // Have the encoders of the numeric fields gather the minimum & maximum of each chunk.
+   void CompressedVectorWriterImpl::setUpChunkStatistics()
+   {
+      integerStatistics_.resize( bytestreams_.size() );
+      realStatistics_.resize( bytestreams_.size() );
+
+      for ( size_t i = 0; i < bytestreams_.size(); ++i )
+      {
+         switch ( proto_->get( bytestreamPaths_[i] )->type() )
+         {
+            case TypeInteger:
+            case TypeScaledInteger:
+               integerStatistics_[i].reset( new ChunkStatistics<int64_t>( chunkRecordCount_ ) );
+               break;
+
+            case TypeFloat:
+               realStatistics_[i].reset( new ChunkStatistics<double>( chunkRecordCount_ ) );
+               break;
+
+            default:
+               break;
+         }
+
+         bytestreams_[i]->setChunkStatistics( integerStatistics_[i].get(),
+                                              realStatistics_[i].get() );
+      }
+   }
+
+   void CompressedVectorWriterImpl::gatherStatistics()
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+      checkWriterOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( recordCount_ > 0 )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "recordCount=" + toString( recordCount_ ) +
+                                  " imageFileName=" + cVector_->imageFileName() +
+                                  " cvPathName=" + cVector_->pathName() );
+      }
+
+      if ( integerStatistics_.empty() )
+      {
+         setUpChunkStatistics();
+      }
+   }
+
+   bool CompressedVectorWriterImpl::fieldLimits( const ustring &pathName, double &minimum,
+                                                 double &maximum ) const
+   {
+      const auto cFound = std::find( bytestreamPaths_.begin(), bytestreamPaths_.end(), pathName );
+
+      if ( ( cFound == bytestreamPaths_.end() ) || ( recordCount_ == 0 ) )
+      {
+         return false;
+      }
+
+      const auto cIndex = static_cast<size_t>( cFound - bytestreamPaths_.begin() );
+
+      if ( cIndex >= integerStatistics_.size() )
+      {
+         return false;
+      }
+
+      if ( integerStatistics_[cIndex] )
+      {
+         const ChunkStatistics<int64_t> &statistics = *integerStatistics_[cIndex];
+
+         int64_t rawMinimum = std::numeric_limits<int64_t>::max();
+         int64_t rawMaximum = std::numeric_limits<int64_t>::lowest();
+
+         for ( size_t chunk = 0; chunk < statistics.chunkCount(); ++chunk )
+         {
+            rawMinimum = std::min( rawMinimum, statistics.minimum( chunk ) );
+            rawMaximum = std::max( rawMaximum, statistics.maximum( chunk ) );
+         }
+
+         if ( rawMinimum > rawMaximum )
+         {
+            return false;
+         }
+
+         minimum = static_cast<double>( rawMinimum );
+         maximum = static_cast<double>( rawMaximum );
+
+         const NodeImplSharedPtr cField = proto_->get( pathName );
+
+         if ( cField->type() == TypeScaledInteger )
+         {
+            auto scaledInteger = std::static_pointer_cast<ScaledIntegerNodeImpl>( cField );
+
+            minimum = minimum * scaledInteger->scale() + scaledInteger->offset();
+            maximum = maximum * scaledInteger->scale() + scaledInteger->offset();
+
+            if ( minimum > maximum )
+            {
+               std::swap( minimum, maximum );
+            }
+         }
+
+         return true;
+      }
+
+      if ( realStatistics_[cIndex] )
+      {
+         const ChunkStatistics<double> &statistics = *realStatistics_[cIndex];
+
+         double realMinimum = std::numeric_limits<double>::max();
+         double realMaximum = std::numeric_limits<double>::lowest();
+
+         for ( size_t chunk = 0; chunk < statistics.chunkCount(); ++chunk )
+         {
+            realMinimum = std::min( realMinimum, statistics.minimum( chunk ) );
+            realMaximum = std::max( realMaximum, statistics.maximum( chunk ) );
+         }
+
+         if ( realMinimum > realMaximum )
+         {
+            return false;
+         }
+
+         minimum = realMinimum;
+         maximum = realMaximum;
+
+         return true;
+      }
+
+      return false;
+   }
+
+   namespace
+   {
+      // Append the minimum & maximum of each of chunkCount chunks to bytes
+      template <typename T>
+      void appendStatistics( const ChunkStatistics<T> &statistics, size_t chunkCount,
+                             std::vector<uint8_t> &bytes )
+      {
+         for ( size_t chunk = 0; chunk < chunkCount; ++chunk )
+         {
+            T values[2] = { std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max() };
+
+            if ( chunk < statistics.chunkCount() )
+            {
+               values[0] = statistics.minimum( chunk );
+               values[1] = statistics.maximum( chunk );
+            }
+
+            const auto *cBytes = reinterpret_cast<const uint8_t *>( values );
+
+            bytes.insert( bytes.end(), cBytes, cBytes + sizeof( values ) );
+         }
+      }
+   }
+
+   // Save the chunk statistics in an extension structure beside the compressed vector:
+   //
+   //    <prefix>:chunkStatistics/<compressed vector name>/chunkRecordCount
+   //    <prefix>:chunkStatistics/<compressed vector name>/fields/<n>/pathName
+   //    <prefix>:chunkStatistics/<compressed vector name>/fields/<n>/values
+   //
+   // values is a blob with the minimum & maximum of each chunk, as little-endian 64-bit raw
+   // integers for integer & scaled integer fields and doubles for float fields.
+   void CompressedVectorWriterImpl::statisticsWrite()
+   {
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+      NodeImplSharedPtr parent = cVector_->parent();
+
+      if ( !parent || ( parent->type() != TypeStructure ) )
+      {
+         return;
+      }
+
+      // Nothing to do if there aren't any numeric fields
+      bool hasStatistics = false;
+
+      for ( size_t i = 0; i < bytestreams_.size(); ++i )
+      {
+         hasStatistics = hasStatistics || integerStatistics_[i] || realStatistics_[i];
+      }
+
+      if ( !hasStatistics )
+      {
+         return;
+      }
+
+      ustring prefix;
+
+      if ( !imf->extensionsLookupUri( cChunkStatisticsUri, prefix ) )
+      {
+         // Don't use the prefix if the file uses it for something else
+         prefix = cChunkStatisticsPrefix;
+
+         ustring uri;
+
+         if ( imf->extensionsLookupPrefix( prefix, uri ) )
+         {
+            return;
+         }
+
+         imf->extensionsAdd( prefix, cChunkStatisticsUri );
+      }
+
+      const ustring cContainerName = prefix + ":" + cChunkStatisticsElement;
+
+      if ( !parent->isDefined( cContainerName ) )
+      {
+         std::static_pointer_cast<StructureNodeImpl>( parent )->set(
+            cContainerName, NodeImplSharedPtr( new StructureNodeImpl( imf ) ) );
+      }
+
+      NodeImplSharedPtr container = parent->get( cContainerName );
+
+      if ( ( container->type() != TypeStructure ) ||
+           container->isDefined( cVector_->elementName() ) )
+      {
+         return;
+      }
+
+      const auto cChunkCount =
+         static_cast<size_t>( ( recordCount_ + chunkRecordCount_ - 1 ) / chunkRecordCount_ );
+
+      std::shared_ptr<StructureNodeImpl> statistics( new StructureNodeImpl( imf ) );
+      std::shared_ptr<VectorNodeImpl> fields( new VectorNodeImpl( imf, false ) );
+
+      statistics->set( "chunkRecordCount",
+                       NodeImplSharedPtr( new IntegerNodeImpl(
+                          imf, static_cast<int64_t>( chunkRecordCount_ ), 0,
+                          std::numeric_limits<int64_t>::max() ) ) );
+      statistics->set( "fields", fields );
+
+      // The blobs can only be written once they are attached
+      std::vector<std::pair<std::shared_ptr<BlobNodeImpl>, std::vector<uint8_t>>> blobs;
+
+      for ( size_t i = 0; i < bytestreams_.size(); ++i )
+      {
+         std::vector<uint8_t> bytes;
+
+         if ( integerStatistics_[i] )
+         {
+            appendStatistics( *integerStatistics_[i], cChunkCount, bytes );
+         }
+         else if ( realStatistics_[i] )
+         {
+            appendStatistics( *realStatistics_[i], cChunkCount, bytes );
+         }
+         else
+         {
+            continue;
+         }
+
+         std::shared_ptr<StructureNodeImpl> field( new StructureNodeImpl( imf ) );
+         std::shared_ptr<BlobNodeImpl> blob(
+            new BlobNodeImpl( imf, static_cast<int64_t>( bytes.size() ) ) );
+
+         field->set( "pathName",
+                     NodeImplSharedPtr( new StringNodeImpl( imf, bytestreamPaths_[i] ) ) );
+         field->set( "values", blob );
+         fields->append( field );
+
+         blobs.emplace_back( blob, std::move( bytes ) );
+      }
+
+      std::static_pointer_cast<StructureNodeImpl>( container )
+         ->set( cVector_->elementName(), statistics );
+
+      for ( auto &blob : blobs )
+      {
+         blob.first->write( blob.second.data(), 0, blob.second.size() );
+      }
+   }
+
+   // Write one packet of everything the encoders have output, one more for each packet group.
+   void CompressedVectorWriterImpl::packetWriteAll()
+   {
+      for ( size_t group = 0; group < packetGroups_.size(); ++group )
+      {
+         packetWrite( group );
+      }
+   }
+
+   uint64_t CompressedVectorWriterImpl::packetWrite( size_t group )
+   {
+      E57_TRACE_ZONE( "CompressedVectorWriterImpl::packetWrite" );
+
+#ifdef E57_VERBOSE
+      std::cout << "CompressedVectorWriterImpl::packetWrite() called" << std::endl; //???
 #endif
 
       // Double check that we have work to do
-      const size_t cTotalOutput = totalOutputAvailable();
+      const size_t cTotalOutput = groupOutputAvailable( group );
       if ( cTotalOutput == 0 )
       {
          return ( 0 );
@@ -437,6 +1439,9 @@ namespace e57
       const auto &cStreams = bytestreams_;
       const auto cNumByteStreams = cStreams.size();
 
+      // Only the bytestreams of this group have data in the packet
+      const auto &cGroupStreams = packetGroups_[group];
+
       // Calc maximum number of bytestream values can put in data packet.
       const size_t cPacketMaxPayloadBytes =
          DATA_PACKET_MAX - sizeof( DataPacketHeader ) - cNumByteStreams * sizeof( uint16_t );
@@ -454,7 +1459,7 @@ namespace e57
       if ( cTotalOutput < cPacketMaxPayloadBytes )
       {
          // We can fit everything in one packet
-         for ( unsigned i = 0; i < cNumByteStreams; ++i )
+         for ( const auto i : cGroupStreams )
          {
             count.at( i ) = cStreams.at( i )->outputAvailable();
          }
@@ -466,7 +1471,7 @@ namespace e57
          // little slack for floating point weirdness.
          const float cFractionToSend =
             ( cPacketMaxPayloadBytes - 1 ) / static_cast<float>( cTotalOutput );
-         for ( unsigned i = 0; i < cNumByteStreams; ++i )
+         for ( const auto i : cGroupStreams )
          {
             // Round down here so sum <= packetMaxPayloadBytes
             count.at( i ) = static_cast<unsigned>(
@@ -497,13 +1502,22 @@ namespace e57
       // Get smart pointer to ImageFileImpl from associated CompressedVector
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
 
-      // Use temp buf in object (is 64KBytes long) instead of allocating each time here
-      char *packet = reinterpret_cast<char *>( &dataPacket_ );
+      // Use temp buf in object (is 64KBytes long) instead of allocating each time here, or the
+      // next free buffer of the background writes
+      DataPacket &dataPacket = writeQueue_ ? writeQueue_->nextPacket() : *dataPacket_;
+      char *packet = reinterpret_cast<char *>( &dataPacket );
 
       // To be safe, clear header part of packet
-      dataPacket_.header.reset();
+      dataPacket.header.reset();
 
-      // Write bytestreamBufferLength[bytestreamCount] after header, in dataPacket_
+      const bool cChunkStart = chunkStartPending_;
+
+      if ( cChunkStart )
+      {
+         dataPacket.header.packetFlags |= DATA_PACKET_FLAG_COMPRESSOR_RESTART;
+      }
+
+      // Write bytestreamBufferLength[bytestreamCount] after header, in dataPacket
       auto bsbLength = reinterpret_cast<uint16_t *>( &packet[sizeof( DataPacketHeader )] );
 #ifdef E57_VERBOSE
       std::cout << "  packet=" << static_cast<void *>( packet ) << std::endl; //???
@@ -524,7 +1538,7 @@ namespace e57
       std::cout << "  after bsbLength, p=" << static_cast<void *>( p ) << std::endl; //???
 #endif
 
-      // Write contents of each bytestream in dataPacket_
+      // Write contents of each bytestream in dataPacket
       for ( size_t i = 0; i < cNumByteStreams; ++i )
       {
          size_t n = count.at( i );
@@ -540,6 +1554,8 @@ namespace e57
          // Read from encoder output into packet
          cStreams.at( i )->outputRead( p, n );
 
+         bytestreamByteCounts_[i] += n;
+
          // Move pointer to end of current data
          p += n;
       }
@@ -567,7 +1583,7 @@ namespace e57
       {
          // Double check we aren't accidentally going to write off end of
          // vector<char>
-         if ( p >= &packet[DATA_PACKET_MAX - 1] )
+         if ( p >= &packet[DATA_PACKET_MAX] )
          {
             throw E57_EXCEPTION1( ErrorInternal );
          }
@@ -579,25 +1595,40 @@ namespace e57
 #endif
       }
 
-      // Prepare header in dataPacket_, now that we are sure of packetLength
-      dataPacket_.header.packetLogicalLengthMinus1 =
+      // Prepare header in dataPacket, now that we are sure of packetLength
+      dataPacket.header.packetLogicalLengthMinus1 =
          static_cast<uint16_t>( packetLength - 1 ); // %%% Truncation
-      dataPacket_.header.bytestreamCount =
+      dataPacket.header.bytestreamCount =
          static_cast<uint16_t>( cNumByteStreams ); // %%% Truncation
 
       // Double check that data packet is well formed
-      dataPacket_.verify( packetLength );
+      dataPacket.verify( packetLength );
 
       // Write whole data packet at beginning of free space in file
-      uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
-      uint64_t packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
-      imf->file_->seek( packetLogicalOffset ); //??? have seekLogical and seekPhysical instead?
-                                               // more explicit
-      imf->file_->write( packet, packetLength );
+      uint64_t packetPhysicalOffset = 0;
+      if ( concurrent_ )
+      {
+         packetPhysicalOffset = spoolPacket( packet, packetLength );
+      }
+      else
+      {
+         uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
+         packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
+         if ( writeQueue_ )
+         {
+            writeQueue_->push( packetLogicalOffset, packetLength );
+         }
+         else
+         {
+            imf->file_->seek( packetLogicalOffset ); //??? have seekLogical and seekPhysical
+                                                     // instead? more explicit
+            imf->file_->write( packet, packetLength );
+         }
+      }
 
 #ifdef E57_VERBOSE
 //  std::cout << "data packet:" << std::endl;
-//  dataPacket_.dump(4);
+//  dataPacket.dump(4);
 #endif
 
       // If first data packet written for this CompressedVector binary section,
@@ -611,8 +1642,18 @@ namespace e57
          dataPhysicalOffset_ = packetPhysicalOffset;
       }
       dataPacketsCount_++;
+      dataPacketBytes_ += packetLength;
 
-      // !!! update seekIndex here? if started new chunk?
+      if ( cChunkStart )
+      {
+         IndexPacket::Entry entry;
+         entry.chunkRecordNumber = chunkStartRecord_;
+         entry.chunkPhysicalOffset = packetPhysicalOffset;
+
+         chunkIndex_.push_back( entry );
+
+         chunkStartPending_ = false;
+      }
 
       // Return physical offset of data packet for potential use in seekIndex
       return ( packetPhysicalOffset ); //??? needed
@@ -624,10 +1665,10 @@ namespace e57
    {
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
 
-      dataPacket_.header.reset();
+      dataPacket_->header.reset();
 
       // Use temp buf in object (is 64KBytes long) instead of allocating each time here
-      char *packet = reinterpret_cast<char *>( &dataPacket_ );
+      char *packet = reinterpret_cast<char *>( dataPacket_.get() );
 
       auto packetLength = static_cast<unsigned int>( sizeof( DataPacketHeader ) );
 
@@ -641,17 +1682,25 @@ namespace e57
       }
 
       // Prepare header in dataPacket_, now that we are sure of packetLength
-      dataPacket_.header.packetLogicalLengthMinus1 = static_cast<uint16_t>( packetLength - 1 );
+      dataPacket_->header.packetLogicalLengthMinus1 = static_cast<uint16_t>( packetLength - 1 );
 
       // Double check that data packet is well formed
-      dataPacket_.verify( packetLength );
+      dataPacket_->verify( packetLength );
 
       // Write packet at beginning of free space in file
-      uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
-      uint64_t packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
+      uint64_t packetPhysicalOffset = 0;
+      if ( concurrent_ )
+      {
+         packetPhysicalOffset = spoolPacket( packet, packetLength );
+      }
+      else
+      {
+         uint64_t packetLogicalOffset = imf->allocateSpace( packetLength, false );
+         packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
 
-      imf->file_->seek( packetLogicalOffset );
-      imf->file_->write( packet, packetLength );
+         imf->file_->seek( packetLogicalOffset );
+         imf->file_->write( packet, packetLength );
+      }
 
       // If first data packet written for this CompressedVector binary section,
       // save address to put in section header
@@ -661,31 +1710,130 @@ namespace e57
       }
 
       dataPacketsCount_++;
+      dataPacketBytes_ += packetLength;
+   }
+
+   // Keep a data packet of a concurrent writer in memory & return its offset from the start of
+   // the section.
+   uint64_t CompressedVectorWriterImpl::spoolPacket( const char *packet, size_t packetLength )
+   {
+      const uint64_t cSectionOffset = sizeof( CompressedVectorSectionHeader ) + spool_.size();
+
+      spool_.insert( spool_.end(), packet, packet + packetLength );
+      spoolMemory_.set( Memory::Writers, spool_.capacity() );
+
+      return cSectionOffset;
+   }
+
+   // Put the data packets of a concurrent writer at the end of the file, after room for the
+   // section header, & turn their offsets into physical ones. The caller holds the ImageFile's
+   // concurrent write lock.
+   void CompressedVectorWriterImpl::placeSpooledPackets()
+   {
+      ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
+      CheckedFile *file = imf->file_;
+
+      sectionHeaderLogicalStart_ =
+         imf->allocateSpace( sizeof( CompressedVectorSectionHeader ) + spool_.size(), false );
+
+      // The header is written once the index is
+      file->seek( sectionHeaderLogicalStart_ + sizeof( CompressedVectorSectionHeader ) );
+      file->write( spool_.data(), spool_.size() );
+
+      std::vector<char>().swap( spool_ );
+      spoolMemory_.set( Memory::Writers, 0 );
+
+      const auto cPlace = [this, file]( uint64_t sectionOffset ) {
+         return file->logicalToPhysical( sectionHeaderLogicalStart_ + sectionOffset );
+      };
+
+      dataPhysicalOffset_ = cPlace( dataPhysicalOffset_ );
+
+      for ( auto &entry : chunkIndex_ )
+      {
+         entry.chunkPhysicalOffset = cPlace( entry.chunkPhysicalOffset );
+      }
    }
 
-   // Write one index packet.
-   // We don't have an interface to work with index packets, but one is required by the standard, so
-   // write one index packet with one entry pointing to the first data packet.
-   void e57::CompressedVectorWriterImpl::packetWriteIndex()
+   // Write one index packet with the given entries and return its physical offset.
+   uint64_t CompressedVectorWriterImpl::packetWriteIndex( uint8_t indexLevel,
+                                                          const IndexPacket::Entry *entries,
+                                                          size_t entryCount )
    {
+      E57_TRACE_ZONE( "CompressedVectorWriterImpl::packetWriteIndex" );
+
       ImageFileImplSharedPtr imf( cVector_->destImageFile_ );
 
       IndexPacket indexPacket;
 
-      indexPacket.entries[0].chunkPhysicalOffset = dataPhysicalOffset_;
+      std::copy( entries, entries + entryCount, indexPacket.entries );
 
-      const auto cPacketLength = sizeof( IndexPacketHeader ) + sizeof( IndexPacket::Entry );
+      const auto cPacketLength =
+         sizeof( IndexPacketHeader ) + entryCount * sizeof( IndexPacket::Entry );
 
-      indexPacket.header.packetLogicalLengthMinus1 = cPacketLength - 1;
-      indexPacket.header.entryCount = 1;
+      indexPacket.header.packetLogicalLengthMinus1 = static_cast<uint16_t>( cPacketLength - 1 );
+      indexPacket.header.entryCount = static_cast<uint16_t>( entryCount );
+      indexPacket.header.indexLevel = indexLevel;
+
+#if VALIDATE_BASIC
+      indexPacket.verify( static_cast<unsigned>( cPacketLength ) );
+#endif
 
       uint64_t packetLogicalOffset = imf->allocateSpace( cPacketLength, false );
-      topIndexPhysicalOffset_ = imf->file_->logicalToPhysical( packetLogicalOffset );
+      uint64_t packetPhysicalOffset = imf->file_->logicalToPhysical( packetLogicalOffset );
 
       imf->file_->seek( packetLogicalOffset );
       imf->file_->write( reinterpret_cast<const char *>( &indexPacket ), cPacketLength );
 
       indexPacketsCount_++;
+
+      return packetPhysicalOffset;
+   }
+
+   // Write the index of the chunks as a tree of index packets. Level 0 packets point to the data
+   // packets which start each chunk, and each higher level points to the packets of the level
+   // below it, until a single packet (the top of the tree) covers everything.
+   void CompressedVectorWriterImpl::indexWrite()
+   {
+      std::vector<IndexPacket::Entry> level = chunkIndex_;
+
+      // If we didn't write any records, point at the first (empty) data packet.
+      if ( level.empty() )
+      {
+         IndexPacket::Entry entry;
+         entry.chunkPhysicalOffset = dataPhysicalOffset_;
+
+         level.push_back( entry );
+      }
+
+      for ( uint8_t indexLevel = 0;; ++indexLevel )
+      {
+         // Spread the entries evenly so packets above level 0 always have at least two entries.
+         const size_t cPacketCount =
+            ( level.size() + IndexPacket::MAX_ENTRIES - 1 ) / IndexPacket::MAX_ENTRIES;
+         const size_t cEntriesPerPacket = ( level.size() + cPacketCount - 1 ) / cPacketCount;
+
+         std::vector<IndexPacket::Entry> parents;
+
+         for ( size_t first = 0; first < level.size(); first += cEntriesPerPacket )
+         {
+            const size_t cCount = std::min( cEntriesPerPacket, level.size() - first );
+
+            IndexPacket::Entry entry;
+            entry.chunkRecordNumber = level[first].chunkRecordNumber;
+            entry.chunkPhysicalOffset = packetWriteIndex( indexLevel, &level[first], cCount );
+
+            parents.push_back( entry );
+         }
+
+         if ( parents.size() == 1 )
+         {
+            topIndexPhysicalOffset_ = parents[0].chunkPhysicalOffset;
+            return;
+         }
+
+         level.swap( parents );
+      }
    }
 
    void CompressedVectorWriterImpl::flush()
@@ -696,6 +1844,23 @@ namespace e57
       }
    }
 
+   // All channels have reached the end of the current chunk, so write out everything they have
+   // and start a new chunk with the next data packet.
+   void CompressedVectorWriterImpl::chunkFinish()
+   {
+      // Chunks are a multiple of cChunkRecordAlignment records, so the encoder registers are empty
+      // here and this doesn't add any padding.
+      flush();
+
+      while ( totalOutputAvailable() > 0 )
+      {
+         packetWriteAll();
+      }
+
+      chunkStartRecord_ += chunkRecordCount_;
+      chunkStartPending_ = true;
+   }
+
    void CompressedVectorWriterImpl::checkImageFileOpen( const char *srcFileName, int srcLineNumber,
                                                         const char *srcFunctionName ) const
    {
@@ -743,7 +1908,7 @@ namespace e57
       // Don't call dump() for DataPacket, since it may contain junk when
       // debugging.  Just print a few byte values.
       os << space( indent ) << "dataPacket:" << std::endl;
-      auto p = reinterpret_cast<uint8_t *>( &dataPacket_ );
+      auto p = reinterpret_cast<uint8_t *>( dataPacket_.get() );
 
       for ( unsigned i = 0; i < 40; ++i )
       {
@@ -761,6 +1926,8 @@ namespace e57
       os << space( indent ) << "recordCount:               " << recordCount_ << std::endl;
       os << space( indent ) << "dataPacketsCount:          " << dataPacketsCount_ << std::endl;
       os << space( indent ) << "indexPacketsCount:         " << indexPacketsCount_ << std::endl;
+      os << space( indent ) << "chunkRecordCount:          " << chunkRecordCount_ << std::endl;
+      os << space( indent ) << "chunkCount:                " << chunkIndex_.size() << std::endl;
    }
 #endif
 }
@@ -27,7 +27,9 @@
  */
 
 #include "Encoder.h"
+#include "Memory.h"
 #include "Packet.h"
+#include "Parallel.h"
 
 namespace e57
 {
@@ -35,15 +37,26 @@ namespace e57
    {
    public:
       CompressedVectorWriterImpl( std::shared_ptr<CompressedVectorNodeImpl> ni,
-                                  std::vector<SourceDestBuffer> &sbufs );
+                                  std::vector<SourceDestBuffer> &sbufs,
+                                  const CompressedVectorWriterOptions &options = {} );
       ~CompressedVectorWriterImpl();
 
       void write( size_t requestedRecordCount );
       void write( std::vector<SourceDestBuffer> &sbufs, size_t requestedRecordCount );
+      void flushStaged();
       bool isOpen() const;
       std::shared_ptr<CompressedVectorNodeImpl> compressedVectorNode() const;
+      CompressedVectorWriterStatistics statistics() const;
       void close();
 
+      /// Gather the chunk statistics of the numeric fields even if they aren't saved in the file.
+      /// Must be called before any records are written.
+      void gatherStatistics();
+
+      /// Get the range of the values written so far of the numeric field @a pathName, scaled for
+      /// scaled integers. Returns false if no statistics were gathered or no records written.
+      bool fieldLimits( const ustring &pathName, double &minimum, double &maximum ) const;
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout );
 #endif
@@ -54,20 +67,46 @@ namespace e57
       void checkWriterOpen( const char *srcFileName, int srcLineNumber,
                             const char *srcFunctionName ) const;
       void setBuffers( std::vector<SourceDestBuffer> &sbufs ); //???needed?
+      void setUpStaging( size_t recordCount );
+      void stage( size_t recordCount );
+      void writeStaged();
+      void encodeRecords( size_t recordCount );
+      void setUpCodecs( const CompressedVectorWriterOptions &options );
+      void setUpPacketGroups( const std::vector<std::vector<ustring>> &fieldGroups );
+      void setUpChunkStatistics();
+      void statisticsWrite();
       size_t totalOutputAvailable() const;
+      size_t groupOutputAvailable( size_t group ) const;
       size_t currentPacketSize() const;
-      uint64_t packetWrite();
+      uint64_t recordsToFillPacket( size_t targetPacketSize ) const;
+      uint64_t packetWrite( size_t group );
+      void packetWriteAll();
       void packetWriteZeroRecords();
-      void packetWriteIndex();
+      uint64_t packetWriteIndex( uint8_t indexLevel, const IndexPacket::Entry *entries,
+                                 size_t entryCount );
+      void indexWrite();
 
       void flush();
+      void chunkFinish();
+
+      void finishSection();
+      uint64_t spoolPacket( const char *packet, size_t packetLength );
+      void placeSpooledPackets();
+
+      bool encodesInParallel() const;
+      void encodeParallel( uint64_t stopRecordIndex, size_t spaceInPacket );
 
       std::vector<SourceDestBuffer> sbufs_;
+      std::vector<size_t> bytestreamBuffers_; /// index in sbufs_ of the buffer of each bytestream
       std::shared_ptr<CompressedVectorNodeImpl> cVector_;
       NodeImplSharedPtr proto_;
 
       std::vector<std::shared_ptr<Encoder>> bytestreams_;
-      DataPacket dataPacket_;
+      std::vector<ustring> bytestreamPaths_;          /// path name of the field of each bytestream
+      std::vector<uint64_t> bytestreamByteCounts_;    /// bytes of each bytestream written so far
+      std::vector<std::vector<size_t>> packetGroups_; /// bytestreams which share data packets
+      Memory::AlignedPtr<DataPacket> dataPacket_ = Memory::makeAligned<DataPacket>();
+      Memory::Charge memory_; /// counts dataPacket_
 
       bool isOpen_;
       uint64_t sectionHeaderLogicalStart_; /// start of CompressedVector binary section
@@ -77,5 +116,36 @@ namespace e57
       uint64_t recordCount_;               /// number of records written so far
       uint64_t dataPacketsCount_;          /// number of data packets written so far
       uint64_t indexPacketsCount_;         /// number of index packets written so far
+      uint64_t dataPacketBytes_ = 0;       /// total length of the data packets written so far
+      bool fillPackets_;                   /// write data packets only when they're full
+
+      uint64_t chunkRecordCount_;                  /// number of records in each chunk
+      uint64_t chunkStartRecord_;                  /// first record of the current chunk
+      bool chunkStartPending_;                     /// next data packet written starts a chunk
+      std::vector<IndexPacket::Entry> chunkIndex_; /// start of each chunk written so far
+
+      TaskExecutor encodeExecutor_;   /// runs the encoding tasks, if set
+      unsigned encodeThreadCount_ = 1; /// otherwise the shared threads they may use at once
+
+      std::unique_ptr<PacketWriteQueue> writeQueue_; /// set when writing in the background
+
+      /// A concurrent writer keeps its data packets here until it's closed. Until then the packet
+      /// offsets are from the start of the section.
+      bool concurrent_ = false;
+      std::vector<char> spool_;
+      Memory::Charge spoolMemory_;
+
+      /// Buffers the records are copied into when staging, in the order of sbufs_, with the
+      /// storage of the numeric & string fields
+      std::vector<SourceDestBuffer> stagingBufs_;
+      std::vector<std::vector<char>> stagingBytes_;
+      std::vector<StringArena> stagingStrings_;
+      size_t stagedRecordCount_ = 0; /// records copied into the staging buffers, not yet encoded
+
+      bool saveStatistics_ = false; /// write the chunk statistics to the file when closing
+
+      /// Statistics of each bytestream if they are being gathered, null for fields of other types
+      std::vector<std::unique_ptr<ChunkStatistics<int64_t>>> integerStatistics_;
+      std::vector<std::unique_ptr<ChunkStatistics<double>>> realStatistics_;
    };
 }
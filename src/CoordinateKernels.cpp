@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <cmath>
+
+#include "CoordinateKernels.h"
+
+namespace e57
+{
+   namespace CoordinateKernels
+   {
+      namespace
+      {
+         // The coordinates of each point as they are read
+         struct Cartesian
+         {
+            static void point( double a, double b, double c, double &x, double &y, double &z )
+            {
+               x = a;
+               y = b;
+               z = c;
+            }
+         };
+
+         // sphericalRange, sphericalAzimuth & sphericalElevation as defined by the standard
+         struct Spherical
+         {
+            static void point( double range, double azimuth, double elevation, double &x,
+                               double &y, double &z )
+            {
+               const double cRadial = range * std::cos( elevation );
+
+               x = cRadial * std::cos( azimuth );
+               y = cRadial * std::sin( azimuth );
+               z = range * std::sin( elevation );
+            }
+         };
+
+         template <typename Input, typename T>
+         inline void transformPoint( T &a, T &b, T &c, const double ( &m )[3][4] )
+         {
+            double x = 0.0;
+            double y = 0.0;
+            double z = 0.0;
+
+            Input::point( a, b, c, x, y, z );
+
+            a = static_cast<T>( m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3] );
+            b = static_cast<T>( m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3] );
+            c = static_cast<T>( m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3] );
+         }
+
+         template <typename Input, typename T>
+         void transformPacked( T *__restrict a, T *__restrict b, T *__restrict c, size_t count,
+                               const double ( &m )[3][4] )
+         {
+            for ( size_t i = 0; i < count; ++i )
+            {
+               transformPoint<Input>( a[i], b[i], c[i], m );
+            }
+         }
+
+         template <typename T> T &at( T *base, size_t stride, size_t index )
+         {
+            return *reinterpret_cast<T *>( reinterpret_cast<char *>( base ) + index * stride );
+         }
+
+         template <typename Input, typename T>
+         void transformAll( T *a, size_t aStride, T *b, size_t bStride, T *c, size_t cStride,
+                            size_t count, const double ( &m )[3][4] )
+         {
+            if ( ( aStride == sizeof( T ) ) && ( bStride == sizeof( T ) ) &&
+                 ( cStride == sizeof( T ) ) )
+            {
+               transformPacked<Input>( a, b, c, count, m );
+               return;
+            }
+
+            // Interleaved points
+            for ( size_t i = 0; i < count; ++i )
+            {
+               transformPoint<Input>( at( a, aStride, i ), at( b, bStride, i ),
+                                      at( c, cStride, i ), m );
+            }
+         }
+      }
+
+      template <typename T>
+      void transform( T *x, size_t xStride, T *y, size_t yStride, T *z, size_t zStride,
+                      size_t count, const double ( &matrix )[3][4] )
+      {
+         transformAll<Cartesian>( x, xStride, y, yStride, z, zStride, count, matrix );
+      }
+
+      template <typename T>
+      void sphericalToCartesian( T *range, size_t rangeStride, T *azimuth, size_t azimuthStride,
+                                 T *elevation, size_t elevationStride, size_t count,
+                                 const double ( &matrix )[3][4] )
+      {
+         transformAll<Spherical>( range, rangeStride, azimuth, azimuthStride, elevation,
+                                  elevationStride, count, matrix );
+      }
+
+      template void transform<float>( float *x, size_t xStride, float *y, size_t yStride, float *z,
+                                      size_t zStride, size_t count,
+                                      const double ( &matrix )[3][4] );
+      template void transform<double>( double *x, size_t xStride, double *y, size_t yStride,
+                                       double *z, size_t zStride, size_t count,
+                                       const double ( &matrix )[3][4] );
+
+      template void sphericalToCartesian<float>( float *range, size_t rangeStride, float *azimuth,
+                                                 size_t azimuthStride, float *elevation,
+                                                 size_t elevationStride, size_t count,
+                                                 const double ( &matrix )[3][4] );
+      template void sphericalToCartesian<double>( double *range, size_t rangeStride,
+                                                  double *azimuth, size_t azimuthStride,
+                                                  double *elevation, size_t elevationStride,
+                                                  size_t count, const double ( &matrix )[3][4] );
+   }
+}
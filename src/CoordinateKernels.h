@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "Common.h"
+
+namespace e57
+{
+   /// Block kernels applied to the coordinates of points after they are decoded.
+   ///
+   /// The coordinates of a point are given in three buffers, each with its own stride in bytes.
+   /// When the buffers are packed arrays, the loops are simple enough for the compiler to
+   /// vectorize.
+   namespace CoordinateKernels
+   {
+      /// Apply the affine transform whose first three rows are @a matrix to @a count points, in
+      /// place. The arithmetic is done in double precision.
+      template <typename T>
+      void transform( T *x, size_t xStride, T *y, size_t yStride, T *z, size_t zStride,
+                      size_t count, const double ( &matrix )[3][4] );
+
+      /// Convert @a count points from spherical coordinates (range, azimuth & elevation, in
+      /// radians) to cartesian ones, in place, and apply the affine transform whose first three
+      /// rows are @a matrix to them.
+      template <typename T>
+      void sphericalToCartesian( T *range, size_t rangeStride, T *azimuth, size_t azimuthStride,
+                                 T *elevation, size_t elevationStride, size_t count,
+                                 const double ( &matrix )[3][4] );
+   }
+}
@@ -40,6 +40,8 @@ namespace e57
       currentBytestreamBufferIndex = 0;
       currentBytestreamBufferLength = 0;
       inputFinished = false;
+      byteCount = 0;
+      decodeNanoseconds = 0;
    }
 
    bool DecodeChannel::isOutputBlocked() const
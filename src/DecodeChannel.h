@@ -42,6 +42,8 @@ namespace e57
       size_t currentBytestreamBufferIndex;
       size_t currentBytestreamBufferLength;
       bool inputFinished;
+      uint64_t byteCount;         /// bytes of the bytestream fed to the decoder so far
+      uint64_t decodeNanoseconds; /// time spent in the decoder so far
 
       DecodeChannel( SourceDestBuffer dbuf_arg, std::shared_ptr<Decoder> decoder_arg,
                      unsigned bytestreamNumber_arg, uint64_t maxRecordCount_arg );
@@ -27,7 +27,9 @@
 
 #include <algorithm>
 #include <cstring>
+#include <limits>
 
+#include "BitPack.h"
 #include "CompressedVectorNodeImpl.h"
 #include "Decoder.h"
 #include "FloatNodeImpl.h"
@@ -39,10 +41,59 @@
 
 using namespace e57;
 
+namespace
+{
+   // The most input copied to finish a record straddling two inputs. Records of numbers are at
+   // most 64 bits, and strings are decoded a piece at a time.
+   constexpr size_t cStraddleByteCount = 16;
+
+   /// Store the values of the records kept by @a sampler among the @a count records starting with
+   /// record @a firstRecord, a block at a time, using @a store( values, count ).
+   template <typename T, typename Store>
+   void storeKept( const RecordSampler &sampler, uint64_t firstRecord, const T *values,
+                   size_t count, Store store )
+   {
+      constexpr size_t cBlockSize = 256;
+
+      T kept[cBlockSize];
+      size_t keptCount = 0;
+
+      sampler.forEachKept( firstRecord, count, [&]( size_t index ) {
+         kept[keptCount++] = values[index];
+
+         if ( keptCount == cBlockSize )
+         {
+            store( kept, keptCount );
+            keptCount = 0;
+         }
+      } );
+
+      if ( keptCount > 0 )
+      {
+         store( kept, keptCount );
+      }
+   }
+}
+
 std::shared_ptr<Decoder> Decoder::DecoderFactory( unsigned bytestreamNumber, //!!! name ok?
                                                   const CompressedVectorNodeImpl *cVector,
                                                   std::vector<SourceDestBuffer> &dbufs,
                                                   const ustring & /*codecPath*/ )
+{
+   std::shared_ptr<Decoder> decoder = FieldDecoderFactory( bytestreamNumber, cVector, dbufs );
+
+   // The LZ codec compresses the bytestream of the decoder of the field's type
+   if ( findCodec( *cVector, dbufs.at( 0 ).pathName() ) == Codec::Lz )
+   {
+      decoder = std::make_shared<LzDecoder>( bytestreamNumber, decoder );
+   }
+
+   return decoder;
+}
+
+std::shared_ptr<Decoder> Decoder::FieldDecoderFactory( unsigned bytestreamNumber,
+                                                       const CompressedVectorNodeImpl *cVector,
+                                                       std::vector<SourceDestBuffer> &dbufs )
 {
    // !!! verify single dbuf
 
@@ -83,6 +134,14 @@ std::shared_ptr<Decoder> Decoder::DecoderFactory( unsigned bytestreamNumber, //!
             return decoder;
          }
 
+         if ( findCodec( *cVector, path ) == Codec::DeltaInteger )
+         {
+            std::shared_ptr<Decoder> decoder( new DeltaIntegerDecoder(
+               false, bytestreamNumber, dbufs.at( 0 ), ini->minimum(), ini->maximum(), 1.0, 0.0,
+               maxRecordCount ) );
+            return decoder;
+         }
+
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Decoder> decoder( new BitpackIntegerDecoder<uint8_t>(
@@ -138,6 +197,14 @@ std::shared_ptr<Decoder> Decoder::DecoderFactory( unsigned bytestreamNumber, //!
             return decoder;
          }
 
+         if ( findCodec( *cVector, path ) == Codec::DeltaInteger )
+         {
+            std::shared_ptr<Decoder> decoder( new DeltaIntegerDecoder(
+               true, bytestreamNumber, dbufs.at( 0 ), sini->minimum(), sini->maximum(),
+               sini->scale(), sini->offset(), maxRecordCount ) );
+            return decoder;
+         }
+
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Decoder> decoder( new BitpackIntegerDecoder<uint8_t>(
@@ -201,8 +268,8 @@ BitpackDecoder::BitpackDecoder( unsigned bytestreamNumber, SourceDestBuffer &dbu
                                 unsigned alignmentSize, uint64_t maxRecordCount ) :
    Decoder( bytestreamNumber ), maxRecordCount_( maxRecordCount ), destBuffer_( dbuf.impl() ),
    inBuffer_( 1024 ), // !!! need to pick smarter channel buffer sizes
-   inBufferAlignmentSize_( alignmentSize ), bitsPerWord_( 8 * alignmentSize ),
-   bytesPerWord_( alignmentSize )
+   inBufferMemory_( Memory::Decoders, inBuffer_.size() ), inBufferAlignmentSize_( alignmentSize ),
+   bitsPerWord_( 8 * alignmentSize ), bytesPerWord_( alignmentSize )
 {
 }
 
@@ -216,96 +283,163 @@ void BitpackDecoder::destBufferSetNew( std::vector<SourceDestBuffer> &dbufs )
    destBuffer_ = dbufs.at( 0 ).impl();
 }
 
-size_t BitpackDecoder::inputProcess( const char *source, const size_t availableByteCount )
+template <class Derived>
+size_t BitpackDecoder::inputProcessAs( const char *source, const size_t availableByteCount )
 {
 #ifdef E57_VERBOSE
    std::cout << "BitpackDecoder::inputprocess() called, source=" << ( source ? source : "none" )
              << " availableByteCount=" << availableByteCount << std::endl;
 #endif
-   size_t bytesUnsaved = availableByteCount;
-   size_t bitsEaten = 0;
-   do
-   {
-      size_t byteCount =
-         std::min( bytesUnsaved, inBuffer_.size() - static_cast<size_t>( inBufferEndByte_ ) );
+   size_t bytesUsed = 0;
 
-      // Copy input bytes from caller, if any
-      if ( ( byteCount > 0 ) && ( source != nullptr ) )
+   // Finish the record straddling the previous input first, copying only as much of this input
+   // as it can need.
+   if ( inBufferEndByte_ > 0 )
+   {
+      const size_t oldEndBit = inBufferEndByte_ * 8;
+      const size_t byteCount =
+         ( source == nullptr )
+            ? 0
+            : std::min( { availableByteCount, cStraddleByteCount,
+                          inBuffer_.size() - inBufferEndByte_ } );
+
+      if ( byteCount > 0 )
       {
          memcpy( &inBuffer_[inBufferEndByte_], source, byteCount );
-
-         // Advance tail pointer.
          inBufferEndByte_ += byteCount;
+      }
 
-         // Update amount available from caller
-         bytesUnsaved -= byteCount;
-         source += byteCount;
+      decodeInBuffer<Derived>();
+
+      // If it stopped before the end of what was there already, keep everything for next time
+      if ( inBufferFirstBit_ < oldEndBit )
+      {
+         inBufferShiftDown();
+
+         return byteCount;
       }
-#ifdef E57_VERBOSE
+
+      // Otherwise the rest of inBuffer_ is a copy of this input, so carry on from the input itself
+      const size_t sourceBit = inBufferFirstBit_ - oldEndBit;
+
+      bytesUsed = sourceBit / 8;
+      sourceFirstBit_ = sourceBit % 8;
+
+      inBufferFirstBit_ = 0;
+      inBufferEndByte_ = 0;
+   }
+
+   if ( ( source == nullptr ) || ( bytesUsed == availableByteCount ) )
+   {
+      return bytesUsed;
+   }
+
+   source += bytesUsed;
+
+   const size_t byteCount = availableByteCount - bytesUsed;
+
+   if ( static_cast<Derived *>( this )->decodesInPlace( source ) )
+   {
+      const size_t bitsEaten = static_cast<Derived *>( this )->inputProcessAligned(
+         source, sourceFirstBit_, byteCount * 8 );
+
+      const size_t endBit = sourceFirstBit_ + bitsEaten;
+      const size_t tailByteCount = byteCount - endBit / 8;
+
+      // If all that is left is (part of) a record, save it so the caller can move on to the next
+      // input. Otherwise decoding stopped for some other reason (e.g. the destination buffer is
+      // full), and the caller passes the rest in again.
+      if ( tailByteCount <= cStraddleByteCount )
       {
-         unsigned i;
-         unsigned firstByte = inBufferFirstBit_ / 8;
-         for ( i = 0; i < byteCount && i < 20; i++ )
-         {
-            std::cout << "  inBuffer[" << firstByte + i
-                      << "]=" << (unsigned)(unsigned char)( inBuffer_[firstByte + i] ) << std::endl;
-         }
-         if ( i < byteCount )
-         {
-            std::cout << "  " << byteCount - i << "source bytes unprinted..." << std::endl;
-         }
+         memcpy( inBuffer_.data(), source + endBit / 8, tailByteCount );
+
+         inBufferFirstBit_ = ( tailByteCount > 0 ) ? endBit % 8 : 0;
+         inBufferEndByte_ = tailByteCount;
+         sourceFirstBit_ = 0;
+
+         return availableByteCount;
       }
-#endif
 
-      // ??? fix doc for new bit interface
-      // Now that we have input stored in an aligned buffer, call derived class
-      // to try to eat some Note that end of filled buffer may not be at a
-      // natural boundary. The subclass may transfer this partial word in a
-      // full word transfer, but it must be careful to only use the defined
-      // bits. inBuffer_ is a multiple of largest word size, so this full word
-      // transfer off the end will always be in defined memory.
-
-      size_t firstWord = inBufferFirstBit_ / bitsPerWord_;
-      size_t firstNaturalBit = firstWord * bitsPerWord_;
-      size_t endBit = inBufferEndByte_ * 8;
-#ifdef E57_VERBOSE
-      std::cout << "  feeding aligned decoder " << endBit - inBufferFirstBit_ << " bits."
-                << std::endl;
-#endif
-      bitsEaten =
-         inputProcessAligned( &inBuffer_[firstWord * bytesPerWord_],
-                              inBufferFirstBit_ - firstNaturalBit, endBit - firstNaturalBit );
-#ifdef E57_VERBOSE
-      std::cout << "  bitsEaten=" << bitsEaten << " firstWord=" << firstWord
-                << " firstNaturalBit=" << firstNaturalBit << " endBit=" << endBit << std::endl;
-#endif
+      sourceFirstBit_ = endBit % 8;
 
-#if VALIDATE_BASIC
-      if ( bitsEaten > endBit - inBufferFirstBit_ )
+      return bytesUsed + endBit / 8;
+   }
+
+   // Copy the input to inBuffer_ a piece at a time & decode it from there
+   size_t bytesUnsaved = byteCount;
+   size_t bitsEaten = 0;
+
+   inBufferFirstBit_ = sourceFirstBit_;
+   sourceFirstBit_ = 0;
+
+   do
+   {
+      const size_t n = std::min( bytesUnsaved, inBuffer_.size() - inBufferEndByte_ );
+
+      if ( n > 0 )
       {
-         throw E57_EXCEPTION2(
-            ErrorInternal, "bitsEaten=" + toString( bitsEaten ) + " endBit=" + toString( endBit ) +
-                              " inBufferFirstBit=" + toString( inBufferFirstBit_ ) );
+         memcpy( &inBuffer_[inBufferEndByte_], source, n );
+
+         inBufferEndByte_ += n;
+         bytesUnsaved -= n;
+         source += n;
       }
-#endif
-      inBufferFirstBit_ += bitsEaten;
 
-      // Shift uneaten data to beginning of inBuffer_, keep on natural word
-      // boundaries.
+      bitsEaten = decodeInBuffer<Derived>();
+
+      // Shift uneaten data to beginning of inBuffer_, keep on natural word boundaries.
       inBufferShiftDown();
 
-      // If the lower level processing didn't eat anything on this iteration,
-      // stop looping and tell caller how much we ate or stored.
+      // If the lower level processing didn't eat anything on this iteration, stop looping and
+      // tell caller how much we ate or stored.
    } while ( bytesUnsaved > 0 && bitsEaten > 0 );
 
    // Return the number of bytes we ate/saved.
    return ( availableByteCount - bytesUnsaved );
 }
 
-void BitpackDecoder::stateReset()
+template <class Derived> size_t BitpackDecoder::decodeInBuffer()
+{
+   // The end of the filled buffer may not be at a natural boundary. The subclass may transfer this
+   // partial word in a full word transfer, but it must be careful to only use the defined bits.
+   // inBuffer_ is a multiple of largest word size, so this full word transfer off the end will
+   // always be in defined memory.
+   const size_t firstWord = inBufferFirstBit_ / bitsPerWord_;
+   const size_t firstNaturalBit = firstWord * bitsPerWord_;
+   const size_t endBit = inBufferEndByte_ * 8;
+
+#ifdef E57_VERBOSE
+   std::cout << "  feeding aligned decoder " << endBit - inBufferFirstBit_ << " bits."
+             << std::endl;
+#endif
+   const size_t bitsEaten = static_cast<Derived *>( this )->inputProcessAligned(
+      &inBuffer_[firstWord * bytesPerWord_], inBufferFirstBit_ - firstNaturalBit,
+      endBit - firstNaturalBit );
+#ifdef E57_VERBOSE
+   std::cout << "  bitsEaten=" << bitsEaten << " firstWord=" << firstWord
+             << " firstNaturalBit=" << firstNaturalBit << " endBit=" << endBit << std::endl;
+#endif
+
+#if VALIDATE_BASIC
+   if ( bitsEaten > endBit - inBufferFirstBit_ )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "bitsEaten=" + toString( bitsEaten ) +
+                                              " endBit=" + toString( endBit ) +
+                                              " inBufferFirstBit=" + toString( inBufferFirstBit_ ) );
+   }
+#endif
+   inBufferFirstBit_ += bitsEaten;
+
+   return bitsEaten;
+}
+
+void BitpackDecoder::stateReset( uint64_t recordIndex )
 {
+   currentRecordIndex_ = recordIndex;
+
    inBufferFirstBit_ = 0;
    inBufferEndByte_ = 0;
+   sourceFirstBit_ = 0;
 }
 
 void BitpackDecoder::inBufferShiftDown()
@@ -374,6 +508,39 @@ BitpackFloatDecoder::BitpackFloatDecoder( unsigned bytestreamNumber, SourceDestB
 {
 }
 
+size_t BitpackFloatDecoder::inputProcess( const char *source, const size_t availableByteCount )
+{
+   // If nothing is waiting in inBuffer_, the whole records in source can be copied straight to a
+   // destination buffer of the same type without going through inBuffer_ or any conversion.
+   if ( ( source == nullptr ) || ( inBufferFirstBit_ != 0 ) || ( inBufferEndByte_ != 0 ) ||
+        ( sourceFirstBit_ != 0 ) || !sampler_.keepsAll() )
+   {
+      return inputProcessAs<BitpackFloatDecoder>( source, availableByteCount );
+   }
+
+   const bool isSingle = ( precision_ == PrecisionSingle );
+   const size_t typeSize = isSingle ? sizeof( float ) : sizeof( double );
+
+   size_t n = std::min( availableByteCount / typeSize,
+                        destBuffer_->capacity() - destBuffer_->nextIndex() );
+
+   // Can't process more than defined in input file
+   n = static_cast<size_t>( std::min<uint64_t>( n, maxRecordCount_ - currentRecordIndex_ ) );
+
+   if ( ( n == 0 ) || !destBuffer_->setNextRawBlock( isSingle ? Real32 : Real64, source, n ) )
+   {
+      return inputProcessAs<BitpackFloatDecoder>( source, availableByteCount );
+   }
+
+   currentRecordIndex_ += n;
+
+   // Save (or decode, if there is room) the rest as usual
+   const size_t byteCount = n * typeSize;
+
+   return byteCount + inputProcessAs<BitpackFloatDecoder>( source + byteCount,
+                                                                 availableByteCount - byteCount );
+}
+
 size_t BitpackFloatDecoder::inputProcessAligned( const char *inbuf, const size_t firstBit,
                                                  const size_t endBit )
 {
@@ -385,7 +552,9 @@ size_t BitpackFloatDecoder::inputProcessAligned( const char *inbuf, const size_t
    // Read from inbuf, decode, store in destBuffer
    // Repeat until have filled destBuffer, or completed all records
 
-   size_t n = destBuffer_->capacity() - destBuffer_->nextIndex();
+   const size_t room = destBuffer_->capacity() - destBuffer_->nextIndex();
+
+   size_t n = std::numeric_limits<size_t>::max();
 
    size_t typeSize = ( precision_ == PrecisionSingle ) ? sizeof( float ) : sizeof( double );
 
@@ -421,43 +590,59 @@ size_t BitpackFloatDecoder::inputProcessAligned( const char *inbuf, const size_t
       n = static_cast<unsigned>( maxRecordCount_ - currentRecordIndex_ );
    }
 
+   // Can't keep more records than there is room for
+   n = static_cast<size_t>( sampler_.consumable( currentRecordIndex_, n, room ) );
+
 #ifdef E57_VERBOSE
    std::cout << "  n:" << n << std::endl; //???
 #endif
 
-   if ( precision_ == PrecisionSingle )
+   if ( !sampler_.keepsAll() )
+   {
+      if ( precision_ == PrecisionSingle )
+      {
+         storeKept( sampler_, currentRecordIndex_, reinterpret_cast<const float *>( inbuf ), n,
+                    [this]( const float *values, size_t count ) {
+                       destBuffer_->setNextFloatBlock( values, count );
+                    } );
+      }
+      else
+      {
+         storeKept( sampler_, currentRecordIndex_, reinterpret_cast<const double *>( inbuf ), n,
+                    [this]( const double *values, size_t count ) {
+                       destBuffer_->setNextDoubleBlock( values, count );
+                    } );
+      }
+   }
+   else if ( precision_ == PrecisionSingle )
    {
       // Form the starting address for first data location in inBuffer
       auto inp = reinterpret_cast<const float *>( inbuf );
 
-      // Copy floats from inbuf to destBuffer_
+#ifdef E57_VERBOSE
       for ( unsigned i = 0; i < n; i++ )
       {
-         float value = *inp;
-
-#ifdef E57_VERBOSE
-         std::cout << "  got float value=" << value << std::endl;
-#endif
-         destBuffer_->setNextFloat( value );
-         inp++;
+         std::cout << "  got float value=" << inp[i] << std::endl;
       }
+#endif
+
+      // Copy floats from inbuf to destBuffer_
+      destBuffer_->setNextFloatBlock( inp, n );
    }
    else
    { // Double precision
       // Form the starting address for first data location in inBuffer
       auto inp = reinterpret_cast<const double *>( inbuf );
 
-      // Copy doubles from inbuf to destBuffer_
+#ifdef E57_VERBOSE
       for ( unsigned i = 0; i < n; i++ )
       {
-         double value = *inp;
-
-#ifdef E57_VERBOSE
-         std::cout << "  got double value=" << value << std::endl;
-#endif
-         destBuffer_->setNextDouble( value );
-         inp++;
+         std::cout << "  got double value=" << inp[i] << std::endl;
       }
+#endif
+
+      // Copy doubles from inbuf to destBuffer_
+      destBuffer_->setNextDoubleBlock( inp, n );
    }
 
    // Update counts of records processed
@@ -490,6 +675,11 @@ BitpackStringDecoder::BitpackStringDecoder( unsigned bytestreamNumber, SourceDes
 {
 }
 
+size_t BitpackStringDecoder::inputProcess( const char *source, const size_t availableByteCount )
+{
+   return inputProcessAs<BitpackStringDecoder>( source, availableByteCount );
+}
+
 size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_t firstBit,
                                                   const size_t endBit )
 {
@@ -512,9 +702,10 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
    size_t nBytesAvailable = ( endBit - firstBit ) >> 3;
    size_t nBytesRead = 0;
 
-   // Loop until we've finished all the records, or ran out of input currently
-   // available
-   while ( currentRecordIndex_ < maxRecordCount_ && nBytesRead < nBytesAvailable )
+   // Loop until we've finished all the records, ran out of input currently
+   // available, or filled the destination buffer
+   while ( currentRecordIndex_ < maxRecordCount_ && nBytesRead < nBytesAvailable &&
+           destBuffer_->nextIndex() < destBuffer_->capacity() )
    {
 #ifdef E57_VERBOSE
       std::cout << "read string loop1: readingPrefix=" << readingPrefix_
@@ -606,8 +797,18 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
             nBytesProcess = static_cast<unsigned>( nBytesNeeded );
          }
 
-         // Append to current string and update counts
-         currentString_ += ustring( inbuf, nBytesProcess );
+         // A string which is all in this input is stored straight from it. Otherwise the pieces
+         // are accumulated in currentString_. Strings which aren't kept are just skipped.
+         const bool cKeep = sampler_.keeps( currentRecordIndex_ );
+         const bool cWholeString = ( nBytesStringRead_ == 0 ) && ( nBytesProcess == nBytesNeeded );
+
+         if ( cKeep && !cWholeString )
+         {
+            currentString_.append( inbuf, nBytesProcess );
+         }
+
+         const char *stringStart = inbuf;
+
          inbuf += nBytesProcess;
          nBytesRead += nBytesProcess;
          nBytesStringRead_ += nBytesProcess;
@@ -615,8 +816,16 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
          // Check if completed reading the string contents
          if ( nBytesStringRead_ == stringLength_ )
          {
-            // Save accumulated string to dest buffer
-            destBuffer_->setNextString( currentString_ );
+            // Save string to dest buffer
+            if ( cKeep && cWholeString )
+            {
+               destBuffer_->setNextString( stringStart, nBytesProcess );
+            }
+            else if ( cKeep )
+            {
+               destBuffer_->setNextString( currentString_ );
+            }
+
             currentRecordIndex_++;
 
             // Get ready to read next prefix
@@ -635,6 +844,20 @@ size_t BitpackStringDecoder::inputProcessAligned( const char *inbuf, const size_
    return ( nBytesRead * 8 );
 }
 
+void BitpackStringDecoder::stateReset( uint64_t recordIndex )
+{
+   BitpackDecoder::stateReset( recordIndex );
+
+   // Start with the prefix of a new string
+   readingPrefix_ = true;
+   prefixLength_ = 1;
+   memset( prefixBytes_, 0, sizeof( prefixBytes_ ) );
+   nBytesPrefixRead_ = 0;
+   stringLength_ = 0;
+   currentString_ = "";
+   nBytesStringRead_ = 0;
+}
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void BitpackStringDecoder::dump( int indent, std::ostream &os )
 {
@@ -679,6 +902,14 @@ BitpackIntegerDecoder<RegisterT>::BitpackIntegerDecoder( bool isScaledInteger,
    bitsPerRecord_ = imf->bitsNeeded( minimum_, maximum_ );
    destBitMask_ =
       ( bitsPerRecord_ == 64 ) ? ~0 : static_cast<RegisterT>( 1ULL << bitsPerRecord_ ) - 1;
+
+}
+
+template <typename RegisterT>
+size_t BitpackIntegerDecoder<RegisterT>::inputProcess( const char *source,
+                                                       const size_t availableByteCount )
+{
+   return inputProcessAs<BitpackIntegerDecoder<RegisterT>>( source, availableByteCount );
 }
 
 template <typename RegisterT>
@@ -716,9 +947,7 @@ size_t BitpackIntegerDecoder<RegisterT>::inputProcessAligned( const char *inbuf,
    size_t bitCount = endBit - firstBit;
    size_t maxInputRecords = bitCount / bitsPerRecord_;
 
-   // Number of transfers is the smaller of what was requested and what is
-   // available in input.
-   size_t recordCount = std::min( destRecords, maxInputRecords );
+   size_t recordCount = maxInputRecords;
 
    // Can't process more than defined in input file
    if ( static_cast<uint64_t>( recordCount ) > maxRecordCount_ - currentRecordIndex_ )
@@ -726,104 +955,73 @@ size_t BitpackIntegerDecoder<RegisterT>::inputProcessAligned( const char *inbuf,
       recordCount = static_cast<unsigned>( maxRecordCount_ - currentRecordIndex_ );
    }
 
+   // Number of transfers is the smaller of what was requested and what is
+   // available in input.
+   recordCount =
+      static_cast<size_t>( sampler_.consumable( currentRecordIndex_, recordCount, destRecords ) );
+
 #ifdef E57_VERBOSE
    std::cout << "  recordCount=" << recordCount << std::endl;
 #endif
 
-   auto inp = reinterpret_cast<const RegisterT *>( inbuf );
-   unsigned wordPosition = 0; // The index in inbuf of the word we are currently working on.
-
-   // clang-format off
-   // For example on little endian machine:
-   // Assume: registerT=uint32_t, bitOffset=20, destBitMask=0x00007fff (for a 15 bit value).
-   // inp[wordPosition]                    LLLLLLLL LLLLXXXX XXXXXXXX XXXXXXXX   Note LSB of value is at bit20
-   // inp(wordPosition+1]                  XXXXXXXX XXXXXXXX XXXXXXXX XXXXXHHH   H=high bits of value, X=uninteresting bits
-   // low = inp[i] >> bitOffset            00000000 00000000 0000LLLL LLLLLLLL   L=low bits of value, X=uninteresting bits
-   // high = inp[i+1] << (32-bitOffset)    XXXXXXXX XXXXXXXX XHHH0000 00000000
-   // w = high | low                       XXXXXXXX XXXXXXXX XHHHLLLL LLLLLLLL
-   // destBitmask                          00000000 00000000 01111111 11111111
-   // w & mask                             00000000 00000000 0HHHLLLL LLLLLLLL
-   // clang-format on
+   // Decode a block of records at a time: unpack them all (using vector instructions if
+   // available), then store them all.
+   constexpr size_t cBlockSize = 256;
 
-   size_t bitOffset = firstBit;
+   int64_t values[cBlockSize];
 
-   for ( size_t i = 0; i < recordCount; i++ )
-   {
-      // Get lower word (contains at least the LSbit of the value),
-      RegisterT low = inp[wordPosition];
-
-#ifdef E57_VERBOSE
-      std::cout << "  bitOffset: " << bitOffset << std::endl;
-      std::cout << "  low: " << binaryString( low ) << std::endl;
-#endif
+   const size_t readableBytes = ( endBit + 7 ) / 8;
 
-      RegisterT w;
-      if ( bitOffset == 0 )
-      {
-         // The left shift (used below) is not defined if shift is >= size of
-         // word
-         w = low;
-      }
-      // Avoid reading the next word, unless it is needed
-      // If the last record finishes on the last bit of input, avoid UMR
-      else if ( bitOffset + bitsPerRecord_ <= RegisterBits )
+   // The parameter isScaledInteger_ determines which version of setNextInt64Block gets called
+   auto store = [this]( const int64_t *blockValues, size_t blockCount ) {
+      if ( isScaledInteger_ )
       {
-         w = low >> bitOffset;
+         destBuffer_->setNextInt64Block( blockValues, blockCount, scale_, offset_ );
       }
       else
       {
-         // Get upper word (may or may not contain interesting bits),
-         RegisterT high = inp[wordPosition + 1];
+         destBuffer_->setNextInt64Block( blockValues, blockCount );
+      }
+   };
 
-#ifdef E57_VERBOSE
-         std::cout << "  high:" << binaryString( high ) << std::endl;
-#endif
+   // Each record has the same number of bits, so only the records kept need unpacking
+   if ( !sampler_.keepsAll() )
+   {
+      size_t keptCount = 0;
 
-         // Shift high to just above the lower bits, shift low LSBit to bit0,
-         // OR together. Note shifts are logical (not arithmetic) because using
-         // unsigned variables.
-         w = ( high << ( RegisterBits - bitOffset ) ) | ( low >> bitOffset );
-      }
+      sampler_.forEachKept( currentRecordIndex_, recordCount, [&]( size_t index ) {
+         BitPack::unpack( inbuf, readableBytes, firstBit + index * bitsPerRecord_, bitsPerRecord_,
+                          minimum_, 1, &values[keptCount++] );
 
-#ifdef E57_VERBOSE
-      std::cout << "  w:   " << binaryString( w ) << std::endl;
-#endif
+         if ( keptCount == cBlockSize )
+         {
+            store( values, keptCount );
+            keptCount = 0;
+         }
+      } );
 
-      // Mask off uninteresting bits
-      w &= destBitMask_;
+      store( values, keptCount );
 
-      // Add minimum_ to value to get back what writer originally sent
-      int64_t value = minimum_ + static_cast<uint64_t>( w );
+      currentRecordIndex_ += recordCount;
 
-#ifdef E57_VERBOSE
-      std::cout << "  Storing value=" << value << std::endl;
-#endif
+      return ( recordCount * bitsPerRecord_ );
+   }
 
-      // The parameter isScaledInteger_ determines which version of
-      // setNextInt64 gets called
-      if ( isScaledInteger_ )
-      {
-         destBuffer_->setNextInt64( value, scale_, offset_ );
-      }
-      else
-      {
-         destBuffer_->setNextInt64( value );
-      }
+   for ( size_t done = 0; done < recordCount; )
+   {
+      const size_t blockCount = std::min( cBlockSize, recordCount - done );
 
-      // Store the result in next available position in the user's dest buffer
+      BitPack::unpack( inbuf, readableBytes, firstBit + done * bitsPerRecord_, bitsPerRecord_,
+                       minimum_, blockCount, values );
+
+      store( values, blockCount );
 
-      // Calc next bit alignment and which word it starts in
-      bitOffset += bitsPerRecord_;
-      if ( bitOffset >= 8 * sizeof( RegisterT ) )
-      {
-         bitOffset -= 8 * sizeof( RegisterT );
-         wordPosition++;
-      }
 #ifdef E57_VERBOSE
-      std::cout << "  Processed " << i + 1 << " records, wordPosition=" << wordPosition
-                << " decoder:" << std::endl;
+      std::cout << "  Processed " << done + blockCount << " records, decoder:" << std::endl;
       dump( 4 );
 #endif
+
+      done += blockCount;
    }
 
    // Update counts of records processed
@@ -884,37 +1082,183 @@ size_t ConstantIntegerDecoder::inputProcess( const char *source, const size_t av
    // availableByteCount.
 
    // Fill dest buffer unless get to maxRecordCount
-   size_t count = destBuffer_->capacity() - destBuffer_->nextIndex();
-   uint64_t remainingRecordCount = maxRecordCount_ - currentRecordIndex_;
-   if ( static_cast<uint64_t>( count ) > remainingRecordCount )
+   const size_t room = destBuffer_->capacity() - destBuffer_->nextIndex();
+   const uint64_t remainingRecordCount = maxRecordCount_ - currentRecordIndex_;
+
+   const auto count =
+      static_cast<size_t>( sampler_.consumable( currentRecordIndex_, remainingRecordCount, room ) );
+   const auto keptCount = static_cast<size_t>( sampler_.keptCount( currentRecordIndex_, count ) );
+
+   if ( isScaledInteger_ )
+   {
+      destBuffer_->fillNextInt64( minimum_, keptCount, scale_, offset_ );
+   }
+   else
    {
-      count = static_cast<unsigned>( remainingRecordCount );
+      destBuffer_->fillNextInt64( minimum_, keptCount );
    }
+   currentRecordIndex_ += count;
+   return ( count );
+}
 
-   if ( isScaledInteger_ )
+void ConstantIntegerDecoder::stateReset( uint64_t recordIndex )
+{
+   currentRecordIndex_ = recordIndex;
+}
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+void ConstantIntegerDecoder::dump( int indent, std::ostream &os )
+{
+   os << space( indent ) << "bytestreamNumber:   " << bytestreamNumber_ << std::endl;
+   os << space( indent ) << "currentRecordIndex: " << currentRecordIndex_ << std::endl;
+   os << space( indent ) << "maxRecordCount:     " << maxRecordCount_ << std::endl;
+   os << space( indent ) << "isScaledInteger:    " << isScaledInteger_ << std::endl;
+   os << space( indent ) << "minimum:            " << minimum_ << std::endl;
+   os << space( indent ) << "scale:              " << scale_ << std::endl;
+   os << space( indent ) << "offset:             " << offset_ << std::endl;
+   os << space( indent ) << "destBuffer:" << std::endl;
+   destBuffer_->dump( indent + 4, os );
+}
+#endif
+
+//================================================================
+
+DeltaIntegerDecoder::DeltaIntegerDecoder( bool isScaledInteger, unsigned bytestreamNumber,
+                                          SourceDestBuffer &dbuf, int64_t minimum, int64_t maximum,
+                                          double scale, double offset, uint64_t maxRecordCount ) :
+   Decoder( bytestreamNumber ), maxRecordCount_( maxRecordCount ), recordCount_( maxRecordCount ),
+   destBuffer_( dbuf.impl() ), isScaledInteger_( isScaledInteger ), minimum_( minimum ),
+   scale_( scale ), offset_( offset )
+{
+   ImageFileImplSharedPtr imf( dbuf.impl()->destImageFile() );
+
+   fieldBits_ = imf->bitsNeeded( minimum, maximum );
+}
+
+void DeltaIntegerDecoder::destBufferSetNew( std::vector<SourceDestBuffer> &dbufs )
+{
+   if ( dbufs.size() != 1 )
    {
-      for ( size_t i = 0; i < count; i++ )
+      throw E57_EXCEPTION2( ErrorInternal, "dbufsSize=" + toString( dbufs.size() ) );
+   }
+
+   destBuffer_ = dbufs.at( 0 ).impl();
+}
+
+void DeltaIntegerDecoder::valuesStore()
+{
+   const size_t cRoom = destBuffer_->capacity() - destBuffer_->nextIndex();
+   const uint64_t cAvailable =
+      std::min<uint64_t>( valuesEnd_ - valuesFirst_, maxRecordCount_ - currentRecordIndex_ );
+
+   const auto count =
+      static_cast<size_t>( sampler_.consumable( currentRecordIndex_, cAvailable, cRoom ) );
+
+   auto store = [this]( const int64_t *values, size_t storeCount ) {
+      if ( isScaledInteger_ )
       {
-         destBuffer_->setNextInt64( minimum_, scale_, offset_ );
+         destBuffer_->setNextInt64Block( values, storeCount, scale_, offset_ );
       }
+      else
+      {
+         destBuffer_->setNextInt64Block( values, storeCount );
+      }
+   };
+
+   if ( sampler_.keepsAll() )
+   {
+      store( &values_[valuesFirst_], count );
    }
    else
    {
-      for ( size_t i = 0; i < count; i++ )
+      storeKept( sampler_, currentRecordIndex_, &values_[valuesFirst_], count, store );
+   }
+
+   valuesFirst_ += count;
+   currentRecordIndex_ += count;
+}
+
+size_t DeltaIntegerDecoder::inputProcess( const char *source, const size_t availableByteCount )
+{
+   size_t consumed = 0;
+
+   for ( ;; )
+   {
+      if ( valuesFirst_ < valuesEnd_ )
+      {
+         valuesStore();
+
+         // Stop when the destination buffer is full or the record limit is reached
+         if ( valuesFirst_ < valuesEnd_ )
+         {
+            return consumed;
+         }
+      }
+
+      if ( currentRecordIndex_ >= maxRecordCount_ )
+      {
+         return consumed;
+      }
+
+      // Each chunk of records starts with a block, so the blocks start on multiples of their
+      // record count
+      const auto cCount = static_cast<size_t>(
+         std::min<uint64_t>( cDeltaBlockRecordCount, recordCount_ - currentRecordIndex_ ) );
+
+      if ( pending_.empty() && ( consumed == availableByteCount ) )
+      {
+         return consumed;
+      }
+
+      const auto cHeader =
+         static_cast<uint8_t>( pending_.empty() ? source[consumed] : pending_.front() );
+
+      if ( cHeader > 64 )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket,
+                               "deltaWidth=" + toString( static_cast<unsigned>( cHeader ) ) +
+                                  " currentRecordIndex=" + toString( currentRecordIndex_ ) );
+      }
+
+      const size_t cBlockSize = deltaBlockSize( cHeader, fieldBits_, cCount );
+
+      if ( pending_.empty() && ( availableByteCount - consumed >= cBlockSize ) )
+      {
+         deltaBlockDecode( source + consumed, cCount, minimum_, fieldBits_, values_ );
+         consumed += cBlockSize;
+      }
+      else
       {
-         destBuffer_->setNextInt64( minimum_ );
+         const size_t cCopied =
+            std::min( cBlockSize - pending_.size(), availableByteCount - consumed );
+
+         pending_.insert( pending_.end(), source + consumed, source + consumed + cCopied );
+         consumed += cCopied;
+
+         if ( pending_.size() < cBlockSize )
+         {
+            return consumed;
+         }
+
+         deltaBlockDecode( pending_.data(), cCount, minimum_, fieldBits_, values_ );
+         pending_.clear();
       }
+
+      valuesFirst_ = 0;
+      valuesEnd_ = cCount;
    }
-   currentRecordIndex_ += count;
-   return ( count );
 }
 
-void ConstantIntegerDecoder::stateReset()
+void DeltaIntegerDecoder::stateReset( uint64_t recordIndex )
 {
+   currentRecordIndex_ = recordIndex;
+   valuesFirst_ = 0;
+   valuesEnd_ = 0;
+   pending_.clear();
 }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
-void ConstantIntegerDecoder::dump( int indent, std::ostream &os )
+void DeltaIntegerDecoder::dump( int indent, std::ostream &os )
 {
    os << space( indent ) << "bytestreamNumber:   " << bytestreamNumber_ << std::endl;
    os << space( indent ) << "currentRecordIndex: " << currentRecordIndex_ << std::endl;
@@ -923,7 +1267,121 @@ void ConstantIntegerDecoder::dump( int indent, std::ostream &os )
    os << space( indent ) << "minimum:            " << minimum_ << std::endl;
    os << space( indent ) << "scale:              " << scale_ << std::endl;
    os << space( indent ) << "offset:             " << offset_ << std::endl;
+   os << space( indent ) << "fieldBits:          " << fieldBits_ << std::endl;
    os << space( indent ) << "destBuffer:" << std::endl;
    destBuffer_->dump( indent + 4, os );
 }
 #endif
+
+//================================================================
+
+LzDecoder::LzDecoder( unsigned bytestreamNumber, std::shared_ptr<Decoder> decoder ) :
+   Decoder( bytestreamNumber ), decoder_( std::move( decoder ) )
+{
+}
+
+void LzDecoder::destBufferSetNew( std::vector<SourceDestBuffer> &dbufs )
+{
+   decoder_->destBufferSetNew( dbufs );
+}
+
+size_t LzDecoder::inputProcess( const char *source, const size_t availableByteCount )
+{
+   size_t consumed = 0;
+
+   for ( ;; )
+   {
+      // Let decoder_ eat what is left of the block, or produce records without any input
+      if ( rawFirst_ < raw_.size() )
+      {
+         rawFirst_ += decoder_->inputProcess( &raw_[rawFirst_], raw_.size() - rawFirst_ );
+
+         // Stop when the destination buffer is full or the record limit is reached
+         if ( rawFirst_ < raw_.size() )
+         {
+            return consumed;
+         }
+      }
+      else
+      {
+         decoder_->inputProcess( nullptr, 0 );
+      }
+
+      if ( consumed == availableByteCount )
+      {
+         return consumed;
+      }
+
+      // Gather the header & then the rest of the next block
+      if ( pending_.size() < cLzBlockHeaderSize )
+      {
+         const size_t cCopied =
+            std::min( cLzBlockHeaderSize - pending_.size(), availableByteCount - consumed );
+
+         pending_.insert( pending_.end(), source + consumed, source + consumed + cCopied );
+         consumed += cCopied;
+
+         if ( pending_.size() < cLzBlockHeaderSize )
+         {
+            return consumed;
+         }
+      }
+
+      const auto *header = reinterpret_cast<const uint8_t *>( pending_.data() );
+      const size_t cRawSize = header[0] | ( static_cast<size_t>( header[1] ) << 8 );
+      const size_t cStoredSize = header[2] | ( static_cast<size_t>( header[3] ) << 8 );
+
+      if ( ( cRawSize == 0 ) || ( cRawSize > cLzBlockMaxRawSize ) || ( cStoredSize == 0 ) ||
+           ( cStoredSize > cRawSize ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket, "lzRawSize=" + toString( cRawSize ) +
+                                                    " lzStoredSize=" + toString( cStoredSize ) );
+      }
+
+      const size_t cBlockSize = cLzBlockHeaderSize + cStoredSize;
+      const size_t cBodyCopied =
+         std::min( cBlockSize - pending_.size(), availableByteCount - consumed );
+
+      pending_.insert( pending_.end(), source + consumed, source + consumed + cBodyCopied );
+      consumed += cBodyCopied;
+
+      if ( pending_.size() < cBlockSize )
+      {
+         return consumed;
+      }
+
+      raw_.resize( cRawSize );
+      rawFirst_ = 0;
+
+      if ( cStoredSize == cRawSize )
+      {
+         memcpy( raw_.data(), &pending_[cLzBlockHeaderSize], cRawSize );
+      }
+      else
+      {
+         lzDecompress( &pending_[cLzBlockHeaderSize], cStoredSize, raw_.data(), cRawSize );
+      }
+
+      pending_.clear();
+   }
+}
+
+void LzDecoder::stateReset( uint64_t recordIndex )
+{
+   decoder_->stateReset( recordIndex );
+
+   pending_.clear();
+   raw_.clear();
+   rawFirst_ = 0;
+}
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+void LzDecoder::dump( int indent, std::ostream &os )
+{
+   os << space( indent ) << "bytestreamNumber:   " << bytestreamNumber_ << std::endl;
+   os << space( indent ) << "pending:            " << pending_.size() << std::endl;
+   os << space( indent ) << "rawAvailable:       " << raw_.size() - rawFirst_ << std::endl;
+   os << space( indent ) << "decoder:" << std::endl;
+   decoder_->dump( indent + 4, os );
+}
+#endif
@@ -27,7 +27,10 @@
 
 #pragma once
 
+#include "Codecs.h"
 #include "Common.h"
+#include "Memory.h"
+#include "RecordSampler.h"
 
 namespace e57
 {
@@ -38,13 +41,31 @@ namespace e57
                                                       const CompressedVectorNodeImpl *cVector,
                                                       std::vector<SourceDestBuffer> &dbufs,
                                                       const ustring &codecPath );
+
+      /// The decoder of the type of the field of @a dbufs, without the LZ codec.
+      static std::shared_ptr<Decoder> FieldDecoderFactory( unsigned bytestreamNumber,
+                                                           const CompressedVectorNodeImpl *cVector,
+                                                           std::vector<SourceDestBuffer> &dbufs );
       Decoder() = delete;
       virtual ~Decoder() = default;
 
       virtual void destBufferSetNew( std::vector<SourceDestBuffer> &dbufs ) = 0;
       virtual uint64_t totalRecordsCompleted() = 0;
       virtual size_t inputProcess( const char *source, size_t count ) = 0;
-      virtual void stateReset() = 0;
+
+      /// Discard any buffered input and restart decoding at the beginning of a chunk whose first
+      /// record is @a recordIndex.
+      virtual void stateReset( uint64_t recordIndex ) = 0;
+
+      /// Stop decoding before record @a recordLimit, which is at most the record count of the
+      /// vector.
+      virtual void setRecordLimit( uint64_t recordLimit ) = 0;
+
+      /// Only store the records kept by @a sampler in the destination buffer.
+      virtual void setSampler( const RecordSampler &sampler )
+      {
+         sampler_ = sampler;
+      }
 
       unsigned bytestreamNumber() const
       {
@@ -59,6 +80,8 @@ namespace e57
       explicit Decoder( unsigned bytestreamNumber );
 
       unsigned int bytestreamNumber_;
+
+      RecordSampler sampler_;
    };
 
    class BitpackDecoder : public Decoder
@@ -71,10 +94,12 @@ namespace e57
          return ( currentRecordIndex_ );
       }
 
-      size_t inputProcess( const char *source, size_t availableByteCount ) override;
-      virtual size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit ) = 0;
+      void stateReset( uint64_t recordIndex ) override;
 
-      void stateReset() override;
+      void setRecordLimit( uint64_t recordLimit ) override
+      {
+         maxRecordCount_ = recordLimit;
+      }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
@@ -84,6 +109,15 @@ namespace e57
       BitpackDecoder( unsigned bytestreamNumber, SourceDestBuffer &dbuf, unsigned alignmentSize,
                       uint64_t maxRecordCount );
 
+      /// Decode the input with Derived::inputProcessAligned(), which is called directly rather
+      /// than through the vtable so it can be inlined. When Derived::decodesInPlace() allows it
+      /// the input is decoded where it is, and only the few bytes of a record straddling the end
+      /// of the input are copied to inBuffer_, to be finished with the next input.
+      template <class Derived> size_t inputProcessAs( const char *source, size_t availableByteCount );
+
+      /// Decode what is in inBuffer_ once, returning the number of bits eaten.
+      template <class Derived> size_t decodeInBuffer();
+
       void inBufferShiftDown();
 
       uint64_t currentRecordIndex_ = 0;
@@ -92,20 +126,33 @@ namespace e57
       std::shared_ptr<SourceDestBufferImpl> destBuffer_;
 
       std::vector<char> inBuffer_;
+      Memory::Charge inBufferMemory_;
       size_t inBufferFirstBit_ = 0;
       size_t inBufferEndByte_ = 0;
+
+      // When decoding in place stopped part way through a byte of the input (e.g. when the
+      // destination buffer is full), the bit of that byte to start at when it is passed in again
+      size_t sourceFirstBit_ = 0;
+
       unsigned int inBufferAlignmentSize_;
       unsigned int bitsPerWord_;
       unsigned int bytesPerWord_;
    };
 
-   class BitpackFloatDecoder : public BitpackDecoder
+   class BitpackFloatDecoder final : public BitpackDecoder
    {
    public:
       BitpackFloatDecoder( unsigned bytestreamNumber, SourceDestBuffer &dbuf,
                            FloatPrecision precision, uint64_t maxRecordCount );
 
-      size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit ) override;
+      size_t inputProcess( const char *source, size_t availableByteCount ) override;
+      size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit );
+
+      /// The values are read as floats or doubles, so they must be aligned
+      bool decodesInPlace( const char *inbuf ) const
+      {
+         return ( reinterpret_cast<uintptr_t>( inbuf ) % bytesPerWord_ ) == 0;
+      }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
@@ -115,13 +162,22 @@ namespace e57
       FloatPrecision precision_ = PrecisionSingle;
    };
 
-   class BitpackStringDecoder : public BitpackDecoder
+   class BitpackStringDecoder final : public BitpackDecoder
    {
    public:
       BitpackStringDecoder( unsigned bytestreamNumber, SourceDestBuffer &dbuf,
                             uint64_t maxRecordCount );
 
-      size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit ) override;
+      size_t inputProcess( const char *source, size_t availableByteCount ) override;
+      size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit );
+
+      /// The input is read a byte at a time
+      bool decodesInPlace( const char * ) const
+      {
+         return true;
+      }
+
+      void stateReset( uint64_t recordIndex ) override;
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
@@ -137,14 +193,21 @@ namespace e57
       uint64_t nBytesStringRead_ = 0;
    };
 
-   template <typename RegisterT> class BitpackIntegerDecoder : public BitpackDecoder
+   template <typename RegisterT> class BitpackIntegerDecoder final : public BitpackDecoder
    {
    public:
       BitpackIntegerDecoder( bool isScaledInteger, unsigned bytestreamNumber,
                              SourceDestBuffer &dbuf, int64_t minimum, int64_t maximum, double scale,
                              double offset, uint64_t maxRecordCount );
 
-      size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit ) override;
+      size_t inputProcess( const char *source, size_t availableByteCount ) override;
+      size_t inputProcessAligned( const char *inbuf, size_t firstBit, size_t endBit );
+
+      /// BitPack::unpack() reads any alignment, and never past the end of the input
+      bool decodesInPlace( const char * ) const
+      {
+         return true;
+      }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
@@ -161,7 +224,7 @@ namespace e57
       static constexpr size_t RegisterBits = sizeof( RegisterT ) * 8;
    };
 
-   class ConstantIntegerDecoder : public Decoder
+   class ConstantIntegerDecoder final : public Decoder
    {
    public:
       ConstantIntegerDecoder( bool isScaledInteger, unsigned bytestreamNumber,
@@ -175,7 +238,12 @@ namespace e57
       }
 
       size_t inputProcess( const char *source, size_t availableByteCount ) override;
-      void stateReset() override;
+      void stateReset( uint64_t recordIndex ) override;
+
+      void setRecordLimit( uint64_t recordLimit ) override
+      {
+         maxRecordCount_ = recordLimit;
+      }
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) override;
@@ -192,4 +260,98 @@ namespace e57
       double scale_;
       double offset_;
    };
+
+   /// Decoder of the delta codec extension (see Codec::DeltaInteger). The blocks are decoded a
+   /// whole block at a time, a block straddling two inputs being gathered in pending_ first.
+   class DeltaIntegerDecoder final : public Decoder
+   {
+   public:
+      DeltaIntegerDecoder( bool isScaledInteger, unsigned bytestreamNumber, SourceDestBuffer &dbuf,
+                           int64_t minimum, int64_t maximum, double scale, double offset,
+                           uint64_t maxRecordCount );
+      void destBufferSetNew( std::vector<SourceDestBuffer> &dbufs ) override;
+
+      uint64_t totalRecordsCompleted() override
+      {
+         return currentRecordIndex_;
+      }
+
+      size_t inputProcess( const char *source, size_t availableByteCount ) override;
+      void stateReset( uint64_t recordIndex ) override;
+
+      void setRecordLimit( uint64_t recordLimit ) override
+      {
+         maxRecordCount_ = recordLimit;
+      }
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+      void dump( int indent = 0, std::ostream &os = std::cout ) override;
+#endif
+
+   private:
+      /// Store the decoded values which fit in the destination buffer.
+      void valuesStore();
+
+      uint64_t currentRecordIndex_ = 0;
+      uint64_t maxRecordCount_;
+
+      // The blocks are sized by the record count of the vector, whatever the record limit
+      const uint64_t recordCount_;
+
+      std::shared_ptr<SourceDestBufferImpl> destBuffer_;
+
+      bool isScaledInteger_;
+      int64_t minimum_;
+      double scale_;
+      double offset_;
+      unsigned fieldBits_;
+
+      // The values of the last block decoded, from record currentRecordIndex_ on
+      int64_t values_[cDeltaBlockRecordCount];
+      size_t valuesFirst_ = 0;
+      size_t valuesEnd_ = 0;
+
+      std::vector<char> pending_;
+   };
+
+   /// Decoder of the LZ codec extension (see Codec::Lz). Each block is decompressed whole, a
+   /// block straddling two inputs being gathered in pending_ first, and then fed to the
+   /// bitPackCodec decoder @a decoder.
+   class LzDecoder final : public Decoder
+   {
+   public:
+      LzDecoder( unsigned bytestreamNumber, std::shared_ptr<Decoder> decoder );
+      void destBufferSetNew( std::vector<SourceDestBuffer> &dbufs ) override;
+
+      uint64_t totalRecordsCompleted() override
+      {
+         return decoder_->totalRecordsCompleted();
+      }
+
+      size_t inputProcess( const char *source, size_t availableByteCount ) override;
+      void stateReset( uint64_t recordIndex ) override;
+
+      void setRecordLimit( uint64_t recordLimit ) override
+      {
+         decoder_->setRecordLimit( recordLimit );
+      }
+
+      void setSampler( const RecordSampler &sampler ) override
+      {
+         decoder_->setSampler( sampler );
+      }
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+      void dump( int indent = 0, std::ostream &os = std::cout ) override;
+#endif
+
+   private:
+      std::shared_ptr<Decoder> decoder_;
+
+      std::vector<char> pending_;
+
+      // The decompressed block, from the first byte decoder_ hasn't eaten
+      std::vector<char> raw_;
+      size_t rawFirst_ = 0;
+   };
 }
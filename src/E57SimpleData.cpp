@@ -6,11 +6,13 @@
 // we would get nothing because of the header guards.
 // NOLINTNEXTLINE(bugprone-reserved-identifier,cert-dcl37-c)
 #define _USE_MATH_DEFINES
+#include <algorithm>
 #include <cmath>
 
 #include "E57SimpleData.h"
 
 #include "Common.h"
+#include "Memory.h"
 #include "StringFunctions.h"
 
 namespace e57
@@ -44,11 +46,24 @@ namespace e57
       elevationMaximum = HALF_PI;
    }
 
-   template <typename COORDTYPE>
-   Data3DPointsData_t<COORDTYPE>::Data3DPointsData_t( Data3D &data3D ) : _selfAllocated( true )
+   /// @private
+   /// Alignment of each of the buffers of a Data3DPointsData_t laid out in one block.
+   constexpr size_t cBufferAlignment = 64;
+
+   /// @private
+   /// Returns @a pointer rounded up to cBufferAlignment.
+   inline char *_alignBuffer( char *pointer )
    {
-      static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
+      const auto address = reinterpret_cast<uintptr_t>( pointer );
+      const uintptr_t aligned = ( address + cBufferAlignment - 1 ) & ~( cBufferAlignment - 1 );
 
+      return pointer + ( aligned - address );
+   }
+
+   /// @private
+   /// Validates a Data3D and adjusts its limits & node types for COORDTYPE.
+   template <typename COORDTYPE> void _prepareData3D( Data3D &data3D )
+   {
       _validateData3D( data3D );
 
       constexpr bool cIsFloat = std::is_same<COORDTYPE, float>::value;
@@ -79,123 +94,56 @@ namespace e57
          data3D.pointFields.angleNodeType =
             ( cIsFloat ? NumericalNodeType::Float : NumericalNodeType::Double );
       }
+   }
 
-      const auto cPointCount = data3D.pointCount;
-
-      if ( data3D.pointFields.cartesianXField )
-      {
-         cartesianX = new COORDTYPE[cPointCount];
-      }
-
-      if ( data3D.pointFields.cartesianYField )
-      {
-         cartesianY = new COORDTYPE[cPointCount];
-      }
-
-      if ( data3D.pointFields.cartesianZField )
-      {
-         cartesianZ = new COORDTYPE[cPointCount];
-      }
-
-      if ( data3D.pointFields.cartesianInvalidStateField )
-      {
-         cartesianInvalidState = new int8_t[cPointCount];
-      }
-
-      if ( data3D.pointFields.intensityField )
-      {
-         intensity = new double[cPointCount];
-      }
-
-      if ( data3D.pointFields.isIntensityInvalidField )
-      {
-         isIntensityInvalid = new int8_t[cPointCount];
-      }
-
-      if ( data3D.pointFields.colorRedField )
-      {
-         colorRed = new uint16_t[cPointCount];
-      }
-
-      if ( data3D.pointFields.colorGreenField )
-      {
-         colorGreen = new uint16_t[cPointCount];
-      }
-
-      if ( data3D.pointFields.colorBlueField )
-      {
-         colorBlue = new uint16_t[cPointCount];
-      }
-
-      if ( data3D.pointFields.isColorInvalidField )
-      {
-         isColorInvalid = new int8_t[cPointCount];
-      }
-
-      if ( data3D.pointFields.sphericalRangeField )
-      {
-         sphericalRange = new COORDTYPE[cPointCount];
-      }
+   template <typename COORDTYPE>
+   Data3DPointsData_t<COORDTYPE>::Data3DPointsData_t( Data3D &data3D ) : _selfAllocated( true )
+   {
+      static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
 
-      if ( data3D.pointFields.sphericalAzimuthField )
-      {
-         sphericalAzimuth = new COORDTYPE[cPointCount];
-      }
+      _prepareData3D<COORDTYPE>( data3D );
 
-      if ( data3D.pointFields.sphericalElevationField )
-      {
-         sphericalElevation = new COORDTYPE[cPointCount];
-      }
+      // Use one block for all the buffers instead of allocating each one separately
+      _blockSize = arenaSize( data3D );
+      _block = new char[_blockSize];
+      Memory::add( Memory::PointBuffers, _blockSize );
 
-      if ( data3D.pointFields.sphericalInvalidStateField )
-      {
-         sphericalInvalidState = new int8_t[cPointCount];
-      }
+      _layOutBuffers( data3D, _alignBuffer( static_cast<char *>( _block ) ) );
+   }
 
-      if ( data3D.pointFields.rowIndexField )
-      {
-         rowIndex = new int32_t[cPointCount];
-      }
+   template <typename COORDTYPE>
+   Data3DPointsData_t<COORDTYPE>::Data3DPointsData_t( Data3D &data3D,
+                                                      Data3DPointsAllocator &allocator ) :
+      _selfAllocated( true ), _allocator( &allocator )
+   {
+      static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
 
-      if ( data3D.pointFields.columnIndexField )
-      {
-         columnIndex = new int32_t[cPointCount];
-      }
+      _prepareData3D<COORDTYPE>( data3D );
 
-      if ( data3D.pointFields.returnIndexField )
-      {
-         returnIndex = new int8_t[cPointCount];
-      }
+      // Always allocate something so the buffers of the fields in use are never null
+      _blockSize = std::max<size_t>( _layOutBuffers( data3D, nullptr ), 1 );
+      _block = allocator.allocate( _blockSize, cBufferAlignment );
+      Memory::add( Memory::PointBuffers, _blockSize );
 
-      if ( data3D.pointFields.returnCountField )
-      {
-         returnCount = new int8_t[cPointCount];
-      }
+      _layOutBuffers( data3D, static_cast<char *>( _block ) );
+   }
 
-      if ( data3D.pointFields.timeStampField )
-      {
-         timeStamp = new double[cPointCount];
-      }
+   template <typename COORDTYPE>
+   Data3DPointsData_t<COORDTYPE>::Data3DPointsData_t( Data3D &data3D, void *arena, size_t size )
+   {
+      static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
 
-      if ( data3D.pointFields.isTimeStampInvalidField )
-      {
-         isTimeStampInvalid = new int8_t[cPointCount];
-      }
+      const size_t cRequired = arenaSize( data3D );
 
-      if ( data3D.pointFields.normalXField )
+      if ( ( arena == nullptr ) || ( size < cRequired ) )
       {
-         normalX = new float[cPointCount];
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "arenaSize=" + toString( size ) +
+                                                       " required=" + toString( cRequired ) );
       }
 
-      if ( data3D.pointFields.normalYField )
-      {
-         normalY = new float[cPointCount];
-      }
+      _prepareData3D<COORDTYPE>( data3D );
 
-      if ( data3D.pointFields.normalZField )
-      {
-         normalZ = new float[cPointCount];
-      }
+      _layOutBuffers( data3D, _alignBuffer( static_cast<char *>( arena ) ) );
    }
 
    template <typename COORDTYPE> Data3DPointsData_t<COORDTYPE>::~Data3DPointsData_t()
@@ -207,41 +155,81 @@ namespace e57
          return;
       }
 
-      delete[] cartesianX;
-      delete[] cartesianY;
-      delete[] cartesianZ;
-      delete[] cartesianInvalidState;
-
-      delete[] intensity;
-      delete[] isIntensityInvalid;
-
-      delete[] colorRed;
-      delete[] colorGreen;
-      delete[] colorBlue;
-      delete[] isColorInvalid;
-
-      delete[] sphericalRange;
-      delete[] sphericalAzimuth;
-      delete[] sphericalElevation;
-      delete[] sphericalInvalidState;
-
-      delete[] rowIndex;
-      delete[] columnIndex;
-
-      delete[] returnIndex;
-      delete[] returnCount;
-
-      delete[] timeStamp;
-      delete[] isTimeStampInvalid;
+      Memory::remove( Memory::PointBuffers, _blockSize );
 
-      delete[] normalX;
-      delete[] normalY;
-      delete[] normalZ;
+      if ( _allocator != nullptr )
+      {
+         _allocator->deallocate( _block, _blockSize );
+      }
+      else
+      {
+         delete[] static_cast<char *>( _block );
+      }
 
       // Set them all to nullptr.
       *this = Data3DPointsData_t<COORDTYPE>();
    }
 
+   template <typename COORDTYPE>
+   size_t Data3DPointsData_t<COORDTYPE>::arenaSize( const Data3D &data3D )
+   {
+      return Data3DPointsData_t<COORDTYPE>()._layOutBuffers( data3D, nullptr ) + cBufferAlignment;
+   }
+
+   template <typename COORDTYPE>
+   size_t Data3DPointsData_t<COORDTYPE>::_layOutBuffers( const Data3D &data3D, char *block )
+   {
+      const auto &fields = data3D.pointFields;
+      const size_t cPointCount = data3D.pointCount;
+
+      size_t used = 0;
+
+      // Give the buffer of a field in use the next aligned space in the block
+      auto place = [&]( bool inUse, auto *&buffer ) {
+         if ( !inUse )
+         {
+            return;
+         }
+
+         using Type = typename std::remove_reference<decltype( *buffer )>::type;
+
+         used = ( used + cBufferAlignment - 1 ) & ~( cBufferAlignment - 1 );
+
+         if ( block != nullptr )
+         {
+            buffer = reinterpret_cast<Type *>( block + used );
+         }
+
+         used += cPointCount * sizeof( Type );
+      };
+
+      place( fields.cartesianXField, cartesianX );
+      place( fields.cartesianYField, cartesianY );
+      place( fields.cartesianZField, cartesianZ );
+      place( fields.cartesianInvalidStateField, cartesianInvalidState );
+      place( fields.intensityField, intensity );
+      place( fields.isIntensityInvalidField, isIntensityInvalid );
+      place( fields.colorRedField, colorRed );
+      place( fields.colorGreenField, colorGreen );
+      place( fields.colorBlueField, colorBlue );
+      place( fields.isColorInvalidField, isColorInvalid );
+      place( fields.sphericalRangeField, sphericalRange );
+      place( fields.sphericalAzimuthField, sphericalAzimuth );
+      place( fields.sphericalElevationField, sphericalElevation );
+      place( fields.sphericalInvalidStateField, sphericalInvalidState );
+      place( fields.rowIndexField, rowIndex );
+      place( fields.columnIndexField, columnIndex );
+      place( fields.returnIndexField, returnIndex );
+      place( fields.returnCountField, returnCount );
+      place( fields.timeStampField, timeStamp );
+      place( fields.isTimeStampInvalidField, isTimeStampInvalid );
+      place( fields.normalXField, normalX );
+      place( fields.normalYField, normalY );
+      place( fields.normalZField, normalZ );
+
+      return used;
+   }
+
 #if defined( _MSC_VER )
    template struct E57_DLL Data3DPointsData_t<float>;
    template struct E57_DLL Data3DPointsData_t<double>;
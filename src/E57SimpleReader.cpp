@@ -27,7 +27,9 @@
  */
 
 #include "E57SimpleReader.h"
+#include "Common.h"
 #include "ReaderImpl.h"
+#include "StringFunctions.h"
 
 namespace e57
 {
@@ -36,6 +38,16 @@ namespace e57
    {
    }
 
+   Reader::Reader( const char *buffer, uint64_t size, const ReaderOptions &options ) :
+      impl_( new ReaderImpl( buffer, size, options ) )
+   {
+   }
+
+   Reader::Reader( std::shared_ptr<ReadSource> source, const ReaderOptions &options ) :
+      impl_( new ReaderImpl( std::move( source ), options ) )
+   {
+   }
+
    // Note that this constructor is deprecated (see header).
    Reader::Reader( const ustring &filePath ) : Reader( filePath, {} )
    {
@@ -56,6 +68,37 @@ namespace e57
       return impl_->GetE57Root( fileHeader );
    }
 
+   FileHeaders Reader::ReadHeaders( const ustring &filePath, const ReaderOptions &options )
+   {
+      // Only build the nodes of the headers which are read
+      ReaderOptions headerOptions = options;
+      headerOptions.xmlLoad = XmlLoadLazy;
+
+      ReaderImpl reader( filePath, headerOptions );
+
+      FileHeaders headers;
+
+      reader.GetE57Root( headers.root );
+
+      headers.data3D.resize( static_cast<size_t>( reader.GetData3DCount() ) );
+
+      for ( size_t i = 0; i < headers.data3D.size(); ++i )
+      {
+         reader.ReadData3D( static_cast<int64_t>( i ), headers.data3D[i] );
+      }
+
+      headers.images2D.resize( static_cast<size_t>( reader.GetImage2DCount() ) );
+
+      for ( size_t i = 0; i < headers.images2D.size(); ++i )
+      {
+         reader.ReadImage2D( static_cast<int64_t>( i ), headers.images2D[i] );
+      }
+
+      reader.Close();
+
+      return headers;
+   }
+
    int64_t Reader::GetImage2DCount() const
    {
       return impl_->GetImage2DCount();
@@ -88,6 +131,19 @@ namespace e57
       return static_cast<int64_t>( read );
    }
 
+   bool Reader::ViewImage2DData( int64_t imageIndex, Image2DProjection imageProjection,
+                                 Image2DType imageType, BlobView &view ) const
+   {
+      return impl_->ViewImage2DData( imageIndex, imageProjection, imageType, view );
+   }
+
+   std::vector<int64_t> Reader::ReadImage2DDataParallel(
+      const std::vector<Image2DReadRequest> &requests, const Image2DReadCallback &callback,
+      const ParallelReadOptions &options ) const
+   {
+      return impl_->ReadImage2DDataParallel( requests, callback, options );
+   }
+
    int64_t Reader::GetData3DCount() const
    {
       return impl_->GetData3DCount();
@@ -133,6 +189,34 @@ namespace e57
                                           pointCount );
    }
 
+   const LineGroupTable *Reader::ReadData3DGroups( int64_t dataIndex ) const
+   {
+      return impl_->ReadData3DGroups( dataIndex );
+   }
+
+   std::vector<LODNode> Reader::ReadData3DLODNodes( int64_t dataIndex, int32_t maximumLevel,
+                                                    const CartesianBounds &box ) const
+   {
+      return impl_->ReadData3DLODNodes( dataIndex, maximumLevel, box );
+   }
+
+   std::vector<QuantizedField> Reader::ReadData3DQuantizedFields( int64_t dataIndex ) const
+   {
+      return impl_->ReadData3DQuantizedFields( dataIndex );
+   }
+
+   int64_t Reader::ReadData3DLines( int64_t dataIndex, int64_t firstLine, int64_t lineCount,
+                                    const Data3DPointsFloat &image ) const
+   {
+      return impl_->ReadData3DLines( dataIndex, firstLine, lineCount, image );
+   }
+
+   int64_t Reader::ReadData3DLines( int64_t dataIndex, int64_t firstLine, int64_t lineCount,
+                                    const Data3DPointsDouble &image ) const
+   {
+      return impl_->ReadData3DLines( dataIndex, firstLine, lineCount, image );
+   }
+
    CompressedVectorReader Reader::SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
                                                          const Data3DPointsFloat &buffers ) const
    {
@@ -144,4 +228,110 @@ namespace e57
    {
       return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers );
    }
+
+   CompressedVectorReader Reader::SetUpData3DPointsData(
+      int64_t dataIndex, size_t pointCount, const Data3DPointsInterleaved &buffers ) const
+   {
+      return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers );
+   }
+
+   std::vector<uint64_t> Reader::ReadData3DPointsDataParallel(
+      const std::vector<int64_t> &dataIndices, const std::vector<Data3DPointsFloat *> &buffers,
+      const ParallelReadOptions &options ) const
+   {
+      return impl_->ReadData3DPointsDataParallel( dataIndices, buffers, options );
+   }
+
+   std::vector<uint64_t> Reader::ReadData3DPointsDataParallel(
+      const std::vector<int64_t> &dataIndices, const std::vector<Data3DPointsDouble *> &buffers,
+      const ParallelReadOptions &options ) const
+   {
+      return impl_->ReadData3DPointsDataParallel( dataIndices, buffers, options );
+   }
+
+   template <typename COORDTYPE>
+   Data3DPointsStream_t<COORDTYPE>::Data3DPointsStream_t( const Reader &reader, int64_t dataIndex,
+                                                          const Data3D &data3DHeader,
+                                                          const Data3DStreamOptions &options )
+   {
+      if ( ( options.blockPointCount == 0 ) || ( options.bufferCount == 0 ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "blockPointCount=" + toString( options.blockPointCount ) +
+                                  " bufferCount=" + toString( options.bufferCount ) );
+      }
+
+      // Each buffer set holds one block of the selected fields
+      Data3D blockHeader = data3DHeader;
+      blockHeader.pointCount = options.blockPointCount;
+
+      for ( unsigned i = 0; i < options.bufferCount; ++i )
+      {
+         buffers_.emplace_back( new Data3DPointsData_t<COORDTYPE>( blockHeader ) );
+
+         destBuffers_.push_back( reader.impl_->SetUpData3DPointsDestBuffers(
+            dataIndex, options.blockPointCount, *buffers_.back() ) );
+      }
+
+      reader_.reset( new CompressedVectorReader( reader.impl_->SetUpData3DPointsData(
+         dataIndex, options.blockPointCount, *buffers_[0] ) ) );
+
+      // The first call to next() uses the first buffer set
+      current_ = buffers_.size() - 1;
+   }
+
+   template <typename COORDTYPE> Data3DPointsStream_t<COORDTYPE>::~Data3DPointsStream_t()
+   {
+      try
+      {
+         close();
+      }
+      catch ( ... )
+      {
+         // Don't throw from the destructor
+      }
+   }
+
+   template <typename COORDTYPE> size_t Data3DPointsStream_t<COORDTYPE>::next()
+   {
+      if ( ( reader_ == nullptr ) || !reader_->isOpen() )
+      {
+         return 0;
+      }
+
+      current_ = ( current_ + 1 ) % buffers_.size();
+
+      const unsigned count = reader_->read( destBuffers_[current_] );
+
+      pointsRead_ += count;
+
+      return count;
+   }
+
+   template <typename COORDTYPE>
+   const Data3DPointsData_t<COORDTYPE> &Data3DPointsStream_t<COORDTYPE>::block() const
+   {
+      return *buffers_[current_];
+   }
+
+   template <typename COORDTYPE> uint64_t Data3DPointsStream_t<COORDTYPE>::pointsRead() const
+   {
+      return pointsRead_;
+   }
+
+   template <typename COORDTYPE> void Data3DPointsStream_t<COORDTYPE>::close()
+   {
+      if ( ( reader_ != nullptr ) && reader_->isOpen() )
+      {
+         reader_->close();
+      }
+   }
+
+#if defined( _MSC_VER )
+   template class E57_DLL Data3DPointsStream_t<float>;
+   template class E57_DLL Data3DPointsStream_t<double>;
+#else
+   template class Data3DPointsStream_t<float>;
+   template class Data3DPointsStream_t<double>;
+#endif
 } // end namespace e57
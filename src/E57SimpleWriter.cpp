@@ -30,6 +30,8 @@
 #include <limits>
 
 #include "E57SimpleWriter.h"
+#include "Common.h"
+#include "Parallel.h"
 #include "WriterImpl.h"
 
 namespace
@@ -172,9 +174,18 @@ namespace e57
    {
    }
 
+   Writer::Writer( std::shared_ptr<WriteSink> sink, const WriterOptions &options ) :
+      impl_( new WriterImpl( std::move( sink ), options ) )
+   {
+   }
+
    // Note that this constructor is deprecated (see header).
    Writer::Writer( const ustring &filePath, const ustring &coordinateMetadata ) :
-      Writer( filePath, WriterOptions{ {}, coordinateMetadata } )
+      Writer( filePath, [&coordinateMetadata] {
+         WriterOptions options;
+         options.coordinateMetadata = coordinateMetadata;
+         return options;
+      }() )
    {
    }
 
@@ -188,6 +199,13 @@ namespace e57
       return impl_->Close();
    }
 
+   std::future<bool> Writer::CloseAsync()
+   {
+      std::shared_ptr<WriterImpl> impl( impl_ );
+
+      return runAsync( [impl]() { return impl->Close(); } );
+   }
+
    int64_t Writer::WriteImage2DData( Image2D &image2DHeader, Image2DType imageType,
                                      Image2DProjection imageProjection, int64_t startPos,
                                      void *pBuffer, int64_t byteCount )
@@ -223,30 +241,30 @@ namespace e57
 
    int64_t Writer::WriteData3DData( Data3D &data3DHeader, const Data3DPointsFloat &buffers )
    {
+      impl_->QuantizeData3D<float>( data3DHeader );
+
       _fillMinMaxData( data3DHeader, buffers );
 
       const int64_t scanIndex = impl_->NewData3D( data3DHeader );
 
-      e57::CompressedVectorWriter dataWriter =
-         impl_->SetUpData3DPointsData( scanIndex, data3DHeader.pointCount, buffers );
+      impl_->WriteData3DPoints( scanIndex, data3DHeader, buffers );
 
-      dataWriter.write( data3DHeader.pointCount );
-      dataWriter.close();
+      impl_->FinishData3DPointsData( scanIndex, data3DHeader );
 
       return scanIndex;
    }
 
    int64_t Writer::WriteData3DData( Data3D &data3DHeader, const Data3DPointsDouble &buffers )
    {
+      impl_->QuantizeData3D<double>( data3DHeader );
+
       _fillMinMaxData( data3DHeader, buffers );
 
       const int64_t scanIndex = impl_->NewData3D( data3DHeader );
 
-      e57::CompressedVectorWriter dataWriter =
-         impl_->SetUpData3DPointsData( scanIndex, data3DHeader.pointCount, buffers );
+      impl_->WriteData3DPoints( scanIndex, data3DHeader, buffers );
 
-      dataWriter.write( data3DHeader.pointCount );
-      dataWriter.close();
+      impl_->FinishData3DPointsData( scanIndex, data3DHeader );
 
       return scanIndex;
    }
@@ -268,6 +286,12 @@ namespace e57
       return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers );
    }
 
+   CompressedVectorWriter Writer::SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
+                                                         const Data3DPointsInterleaved &buffers )
+   {
+      return impl_->SetUpData3DPointsData( dataIndex, pointCount, buffers );
+   }
+
    bool Writer::WriteData3DGroupsData( int64_t dataIndex, size_t groupCount,
                                        int64_t *idElementValue, int64_t *startPointIndex,
                                        int64_t *pointCount )
@@ -276,6 +300,12 @@ namespace e57
                                            pointCount );
    }
 
+   MergeReport Writer::MergeFrom( const std::vector<ustring> &inputPaths,
+                                  const MergeOptions &options )
+   {
+      return impl_->MergeFrom( inputPaths, options );
+   }
+
    ImageFile Writer::GetRawIMF()
    {
       return impl_->GetRawIMF();
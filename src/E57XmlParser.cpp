@@ -25,9 +25,11 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <cstring>
 #include <limits>
 #include <locale>
 #include <sstream>
+#include <vector>
 
 #include <xercesc/sax2/Attributes.hpp>
 #include <xercesc/sax2/XMLReaderFactory.hpp>
@@ -93,31 +95,85 @@ namespace
 #endif
    }
 
-   ustring toUString( const XMLCh *const xml_str )
+   // Append length characters of xml_str to u_str as UTF-8. The names, attributes, and numbers
+   // in E57 XML are almost always ASCII, which is copied directly instead of creating a
+   // transcoder for each string.
+   void appendUString( ustring &u_str, const XMLCh *const xml_str, size_t length )
    {
-      ustring u_str;
-      if ( ( xml_str != nullptr ) && *xml_str )
+      size_t i = 0;
+
+      while ( ( i < length ) && ( xml_str[i] < 0x80 ) )
+      {
+         ++i;
+      }
+
+      if ( i == length )
+      {
+         const size_t cStart = u_str.size();
+
+         u_str.resize( cStart + length );
+
+         for ( i = 0; i < length; ++i )
+         {
+            u_str[cStart + i] = static_cast<char>( xml_str[i] );
+         }
+
+         return;
+      }
+
+      const std::basic_string<XMLCh> cTerminated( xml_str, length );
+
+      TranscodeToStr UTF8Transcoder( cTerminated.c_str(), "UTF-8" );
+      u_str.append( reinterpret_cast<const char *>( UTF8Transcoder.str() ) );
+   }
+
+   void assignUString( ustring &u_str, const XMLCh *const xml_str )
+   {
+      u_str.clear();
+
+      if ( xml_str != nullptr )
       {
-         TranscodeToStr UTF8Transcoder( xml_str, "UTF-8" );
-         u_str = ustring( reinterpret_cast<const char *>( UTF8Transcoder.str() ) );
+         appendUString( u_str, xml_str, XMLString::stringLen( xml_str ) );
       }
+   }
+
+   ustring toUString( const XMLCh *const xml_str )
+   {
+      ustring u_str;
+      assignUString( u_str, xml_str );
       return ( u_str );
    }
 
-   ustring lookupAttribute( const Attributes &attributes, const XMLCh *attribute_name )
+   // Get the value of an attribute with a single lookup. Returns false if it isn't defined.
+   bool findAttribute( const Attributes &attributes, const XMLCh *attribute_name, ustring &value )
    {
       XMLSize_t attr_index;
       if ( !attributes.getIndex( attribute_name, attr_index ) )
+      {
+         return false;
+      }
+
+      assignUString( value, attributes.getValue( attr_index ) );
+      return true;
+   }
+
+   ustring lookupAttribute( const Attributes &attributes, const XMLCh *attribute_name )
+   {
+      ustring value;
+      if ( !findAttribute( attributes, attribute_name, value ) )
       {
          throw E57_EXCEPTION2( ErrorBadXMLFormat, "attributeName=" + toUString( attribute_name ) );
       }
-      return ( toUString( attributes.getValue( attr_index ) ) );
+      return ( value );
    }
 
-   bool isAttributeDefined( const Attributes &attributes, const XMLCh *attribute_name )
+   /// Number of logical bytes E57FileInputStream reads ahead. Xerces asks for a few KB at a time,
+   /// and each read of the file verifies the checksums of all the pages it touches.
+   constexpr size_t cXmlReadAheadSize = 256 * CheckedFile::logicalPageSize;
+
+   bool isXmlWhitespace( XMLCh c )
    {
-      XMLSize_t attr_index;
-      return ( attributes.getIndex( attribute_name, attr_index ) );
+      return ( c == chSpace ) || ( c == chHTab ) || ( c == chLF ) || ( c == chCR );
    }
 }
 
@@ -151,6 +207,10 @@ private:
    uint64_t logicalStart_;
    uint64_t logicalLength_;
    uint64_t logicalPosition_;
+
+   // Bytes read ahead, starting at logical offset bufferStart_
+   std::vector<char> buffer_;
+   uint64_t bufferStart_ = 0;
 };
 
 E57FileInputStream::E57FileInputStream( CheckedFile *cf, uint64_t logicalStart,
@@ -205,12 +265,335 @@ XMLSize_t E57FileInputStream::readBytes( XMLByte *const toFill, const XMLSize_t
 
    size_t readCount = std::min( maxToRead_size, available_size );
 
-   cf_->seek( logicalPosition_ );
-   cf_->read( reinterpret_cast<char *>( toFill ), readCount ); //??? cast ok?
+   auto *dest = reinterpret_cast<char *>( toFill ); //??? cast ok?
+
+   // Large reads go straight to the file
+   if ( readCount >= cXmlReadAheadSize )
+   {
+      cf_->readAt( logicalPosition_, dest, readCount );
+      logicalPosition_ += readCount;
+      return ( readCount );
+   }
+
+   // Refill the buffer when the position is past what it holds
+   if ( ( logicalPosition_ < bufferStart_ ) ||
+        ( logicalPosition_ >= bufferStart_ + buffer_.size() ) )
+   {
+      buffer_.resize( std::min( cXmlReadAheadSize, available_size ) );
+      bufferStart_ = logicalPosition_;
+
+      cf_->readAt( bufferStart_, buffer_.data(), buffer_.size() );
+   }
+
+   const auto bufferOffset = static_cast<size_t>( logicalPosition_ - bufferStart_ );
+   readCount = std::min( readCount, buffer_.size() - bufferOffset );
+
+   memcpy( dest, buffer_.data() + bufferOffset, readCount );
    logicalPosition_ += readCount;
    return ( readCount );
 }
 
+//=============================================================================
+// E57MemoryInputStream
+
+class E57MemoryInputStream : public BinInputStream
+{
+public:
+   explicit E57MemoryInputStream( const ustring &xml ) : xml_( xml ), position_( 0 )
+   {
+   }
+   ~E57MemoryInputStream() override = default;
+
+   E57MemoryInputStream( const E57MemoryInputStream & ) = delete;
+   E57MemoryInputStream &operator=( const E57MemoryInputStream & ) = delete;
+
+   XMLFilePos curPos() const override
+   {
+      return ( position_ );
+   }
+
+   XMLSize_t readBytes( XMLByte *const toFill, const XMLSize_t maxToRead ) override
+   {
+      const size_t readCount = std::min( maxToRead, xml_.size() - position_ );
+
+      memcpy( toFill, xml_.data() + position_, readCount );
+      position_ += readCount;
+
+      return ( readCount );
+   }
+
+   const XMLCh *getContentType() const override
+   {
+      return nullptr;
+   }
+
+private:
+   const ustring &xml_;
+   size_t position_;
+};
+
+//=============================================================================
+// E57XmlMemoryInputSource
+
+E57XmlMemoryInputSource::E57XmlMemoryInputSource( const ustring &xml ) :
+   InputSource( "E57Memory", XMLPlatformUtils::fgMemoryManager ), xml_( xml )
+{
+}
+
+BinInputStream *E57XmlMemoryInputSource::makeStream() const
+{
+   return new E57MemoryInputStream( xml_ );
+}
+
+//=============================================================================
+// findLazyXmlElements
+
+namespace
+{
+   bool isSpace( char c )
+   {
+      return ( c == ' ' ) || ( c == '\t' ) || ( c == '\n' ) || ( c == '\r' );
+   }
+
+   // Position of the '>' ending the tag starting at begin, skipping quoted attribute values
+   size_t findTagEnd( const ustring &xml, size_t begin )
+   {
+      char quote = 0;
+
+      for ( size_t i = begin + 1; i < xml.size(); ++i )
+      {
+         const char c = xml[i];
+
+         if ( quote != 0 )
+         {
+            quote = ( c == quote ) ? 0 : quote;
+         }
+         else if ( ( c == '"' ) || ( c == '\'' ) )
+         {
+            quote = c;
+         }
+         else if ( c == '>' )
+         {
+            return i;
+         }
+      }
+
+      return ustring::npos;
+   }
+
+   // Name of the element whose start tag begins at begin
+   ustring tagName( const ustring &xml, size_t begin, size_t end )
+   {
+      size_t i = begin + 1;
+
+      while ( ( i < end ) && !isSpace( xml[i] ) && ( xml[i] != '/' ) )
+      {
+         ++i;
+      }
+
+      return xml.substr( begin + 1, i - begin - 1 );
+   }
+
+   // Get the value of the attribute attributeName of the start tag xml[begin, end]
+   bool findTagAttribute( const ustring &xml, size_t begin, size_t end,
+                          const char *attributeName, ustring &value )
+   {
+      size_t i = begin + 1;
+
+      while ( ( i < end ) && !isSpace( xml[i] ) && ( xml[i] != '/' ) )
+      {
+         ++i;
+      }
+
+      while ( i < end )
+      {
+         while ( ( i < end ) && isSpace( xml[i] ) )
+         {
+            ++i;
+         }
+
+         const size_t cNameStart = i;
+
+         while ( ( i < end ) && !isSpace( xml[i] ) && ( xml[i] != '=' ) && ( xml[i] != '/' ) )
+         {
+            ++i;
+         }
+
+         const size_t cNameEnd = i;
+
+         while ( ( i < end ) && isSpace( xml[i] ) )
+         {
+            ++i;
+         }
+
+         if ( ( i >= end ) || ( xml[i] != '=' ) )
+         {
+            return false;
+         }
+
+         ++i;
+
+         while ( ( i < end ) && isSpace( xml[i] ) )
+         {
+            ++i;
+         }
+
+         if ( ( i >= end ) || ( ( xml[i] != '"' ) && ( xml[i] != '\'' ) ) )
+         {
+            return false;
+         }
+
+         const size_t cValueEnd = xml.find( xml[i], i + 1 );
+
+         if ( cValueEnd >= end )
+         {
+            return false;
+         }
+
+         if ( xml.compare( cNameStart, cNameEnd - cNameStart, attributeName ) == 0 )
+         {
+            value.assign( xml, i + 1, cValueEnd - i - 1 );
+            return true;
+         }
+
+         i = cValueEnd + 1;
+      }
+
+      return false;
+   }
+
+   // Skip a comment, CDATA section, processing instruction, or declaration starting at pos.
+   // Returns the position after it, or npos if it isn't closed.
+   size_t skipMarkup( const ustring &xml, size_t pos )
+   {
+      const char *terminator = ">";
+
+      if ( xml.compare( pos, 4, "<!--" ) == 0 )
+      {
+         terminator = "-->";
+      }
+      else if ( xml.compare( pos, 9, "<![CDATA[" ) == 0 )
+      {
+         terminator = "]]>";
+      }
+      else if ( xml.compare( pos, 2, "<?" ) == 0 )
+      {
+         terminator = "?>";
+      }
+
+      const size_t cEnd = xml.find( terminator, pos + 2 );
+
+      return ( cEnd == ustring::npos ) ? cEnd : cEnd + strlen( terminator );
+   }
+}
+
+bool e57::findLazyXmlElements( const ustring &xml, std::vector<XmlLazyElement> &elements )
+{
+   elements.clear();
+
+   size_t depth = 0;         // number of open elements
+   bool inVector = false;    // the open top-level element is a Vector
+   bool inElement = false;   // the last of elements is open
+   size_t childIndex = 0;    // index of the next child of the open top-level Vector
+   ustring vectorName;       // name of the open top-level Vector
+   ustring type;
+   ustring value;
+
+   size_t pos = xml.find( '<' );
+
+   while ( pos != ustring::npos )
+   {
+      if ( pos + 1 >= xml.size() )
+      {
+         return false;
+      }
+
+      if ( ( xml[pos + 1] == '!' ) || ( xml[pos + 1] == '?' ) )
+      {
+         pos = skipMarkup( xml, pos );
+
+         if ( pos == ustring::npos )
+         {
+            return false;
+         }
+
+         pos = xml.find( '<', pos );
+         continue;
+      }
+
+      const size_t cTagEnd = findTagEnd( xml, pos );
+
+      if ( cTagEnd == ustring::npos )
+      {
+         return false;
+      }
+
+      if ( xml[pos + 1] == '/' )
+      {
+         // End tag
+         if ( depth == 0 )
+         {
+            return false;
+         }
+
+         --depth;
+
+         if ( ( depth == 2 ) && inElement )
+         {
+            elements.back().contentLength = pos - elements.back().contentOffset;
+            inElement = false;
+         }
+         else if ( depth == 1 )
+         {
+            inVector = false;
+         }
+      }
+      else
+      {
+         const bool cEmpty = ( xml[cTagEnd - 1] == '/' );
+
+         if ( ( depth == 1 ) || ( ( depth == 2 ) && inVector ) )
+         {
+            if ( !findTagAttribute( xml, pos, cTagEnd, "type", type ) )
+            {
+               type.clear();
+            }
+
+            if ( depth == 1 )
+            {
+               // The children of homogeneous vectors are compared as they are added, so can't be
+               // left empty
+               inVector = !cEmpty && ( type == "Vector" ) &&
+                          findTagAttribute( xml, pos, cTagEnd, "allowHeterogeneousChildren",
+                                            value ) &&
+                          ( value == "1" );
+               vectorName = tagName( xml, pos, cTagEnd );
+               childIndex = 0;
+            }
+            else
+            {
+               if ( !cEmpty && ( type == "Structure" ) )
+               {
+                  elements.push_back( { vectorName, childIndex, cTagEnd + 1, 0 } );
+                  inElement = true;
+               }
+
+               ++childIndex;
+            }
+         }
+
+         if ( !cEmpty )
+         {
+            ++depth;
+         }
+      }
+
+      pos = xml.find( '<', cTagEnd + 1 );
+   }
+
+   return ( depth == 0 ) && !inElement;
+}
+
 //=============================================================================
 // E57XmlFileInputSource
 
@@ -238,6 +621,25 @@ E57XmlParser::ParseInfo::ParseInfo() :
 {
 }
 
+// Reset to the default state, keeping the capacity of childText
+void E57XmlParser::ParseInfo::reset()
+{
+   nodeType = static_cast<NodeType>( 0 );
+   minimum = 0;
+   maximum = 0;
+   scale = 0;
+   offset = 0;
+   precision = static_cast<FloatPrecision>( 0 );
+   floatMinimum = 0;
+   floatMaximum = 0;
+   fileOffset = 0;
+   length = 0;
+   allowHeterogeneousChildren = false;
+   recordCount = 0;
+   childText.clear();
+   container_ni.reset();
+}
+
 void E57XmlParser::ParseInfo::dump( int indent, std::ostream &os ) const
 {
    os << space( indent ) << "nodeType:       " << nodeType << std::endl;
@@ -267,8 +669,12 @@ void E57XmlParser::ParseInfo::dump( int indent, std::ostream &os ) const
 //=============================================================================
 // E57XmlParser
 
-E57XmlParser::E57XmlParser( ImageFileImplSharedPtr imf ) : imf_( imf ), xmlReader( nullptr )
+E57XmlParser::E57XmlParser( ImageFileImplSharedPtr imf,
+                            std::shared_ptr<StructureNodeImpl> target ) :
+   imf_( imf ), target_( target ), stackDepth_( 0 ), fieldPath_( 1 ), xmlReader( nullptr )
 {
+   // Deep enough for the standard tree & typical extensions
+   stack_.reserve( 16 );
 }
 
 E57XmlParser::~E57XmlParser()
@@ -320,6 +726,20 @@ void E57XmlParser::parse( InputSource &inputSource )
    xmlReader->parse( inputSource );
 }
 
+E57XmlParser::ParseInfo &E57XmlParser::pushParseInfo()
+{
+   if ( stackDepth_ == stack_.size() )
+   {
+      stack_.emplace_back();
+   }
+   else
+   {
+      stack_[stackDepth_].reset();
+   }
+
+   return stack_[stackDepth_++];
+}
+
 void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const localName,
                                  const XMLCh *const qName, const Attributes &attributes )
 {
@@ -342,11 +762,19 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
    }
 #endif
    // Get Type attribute
-   ustring node_type = lookupAttribute( attributes, att_type );
+   if ( !findAttribute( attributes, att_type, nodeType_ ) )
+   {
+      throw E57_EXCEPTION2( ErrorBadXMLFormat, "attributeName=" + toUString( att_type ) );
+   }
+
+   const ustring &node_type = nodeType_;
 
    //??? check to make sure not in primitive type (can only nest inside compound types).
 
-   ParseInfo pi;
+   ParseInfo &pi = pushParseInfo();
+
+   // Holds each attribute value, short enough not to allocate
+   ustring value;
 
    if ( node_type == "Integer" )
    {
@@ -356,11 +784,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
       //??? check validity of numeric strings
       pi.nodeType = TypeInteger;
 
-      if ( isAttributeDefined( attributes, att_minimum ) )
+      if ( findAttribute( attributes, att_minimum, value ) )
       {
-         ustring minimum_str = lookupAttribute( attributes, att_minimum );
-
-         pi.minimum = convertStrToLL( minimum_str );
+         pi.minimum = convertStrToLL( value );
       }
       else
       {
@@ -368,11 +794,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.minimum = INT64_MIN;
       }
 
-      if ( isAttributeDefined( attributes, att_maximum ) )
+      if ( findAttribute( attributes, att_maximum, value ) )
       {
-         ustring maximum_str = lookupAttribute( attributes, att_maximum );
-
-         pi.maximum = convertStrToLL( maximum_str );
+         pi.maximum = convertStrToLL( value );
       }
       else
       {
@@ -380,7 +804,6 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.maximum = INT64_MAX;
       }
 
-      stack_.push( pi );
    }
    else if ( node_type == "ScaledInteger" )
    {
@@ -390,11 +813,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
       pi.nodeType = TypeScaledInteger;
 
       //??? check validity of numeric strings
-      if ( isAttributeDefined( attributes, att_minimum ) )
+      if ( findAttribute( attributes, att_minimum, value ) )
       {
-         ustring minimum_str = lookupAttribute( attributes, att_minimum );
-
-         pi.minimum = convertStrToLL( minimum_str );
+         pi.minimum = convertStrToLL( value );
       }
       else
       {
@@ -402,11 +823,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.minimum = INT64_MIN;
       }
 
-      if ( isAttributeDefined( attributes, att_maximum ) )
+      if ( findAttribute( attributes, att_maximum, value ) )
       {
-         ustring maximum_str = lookupAttribute( attributes, att_maximum );
-
-         pi.maximum = convertStrToLL( maximum_str );
+         pi.maximum = convertStrToLL( value );
       }
       else
       {
@@ -414,10 +833,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.maximum = INT64_MAX;
       }
 
-      if ( isAttributeDefined( attributes, att_scale ) )
+      if ( findAttribute( attributes, att_scale, value ) )
       {
-         ustring scale_str = lookupAttribute( attributes, att_scale );
-         pi.scale = strToDouble( scale_str ); //??? use exact rounding library
+         pi.scale = strToDouble( value ); //??? use exact rounding library
       }
       else
       {
@@ -425,10 +843,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.scale = 1.0;
       }
 
-      if ( isAttributeDefined( attributes, att_offset ) )
+      if ( findAttribute( attributes, att_offset, value ) )
       {
-         ustring offset_str = lookupAttribute( attributes, att_offset );
-         pi.offset = strToDouble( offset_str ); //??? use exact rounding library
+         pi.offset = strToDouble( value ); //??? use exact rounding library
       }
       else
       {
@@ -436,7 +853,6 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.offset = 0.0;
       }
 
-      stack_.push( pi );
    }
    else if ( node_type == "Float" )
    {
@@ -445,20 +861,19 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
 #endif
       pi.nodeType = TypeFloat;
 
-      if ( isAttributeDefined( attributes, att_precision ) )
+      if ( findAttribute( attributes, att_precision, value ) )
       {
-         ustring precision_str = lookupAttribute( attributes, att_precision );
-         if ( precision_str == "single" )
+         if ( value == "single" )
          {
             pi.precision = PrecisionSingle;
          }
-         else if ( precision_str == "double" )
+         else if ( value == "double" )
          {
             pi.precision = PrecisionDouble;
          }
          else
          {
-            throw E57_EXCEPTION2( ErrorBadXMLFormat, "precisionString=" + precision_str +
+            throw E57_EXCEPTION2( ErrorBadXMLFormat, "precisionString=" + value +
                                                         " fileName=" + imf_->fileName() +
                                                         " uri=" + toUString( uri ) +
                                                         " localName=" + toUString( localName ) +
@@ -471,10 +886,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          pi.precision = PrecisionDouble;
       }
 
-      if ( isAttributeDefined( attributes, att_minimum ) )
+      if ( findAttribute( attributes, att_minimum, value ) )
       {
-         ustring minimum_str = lookupAttribute( attributes, att_minimum );
-         pi.floatMinimum = strToDouble( minimum_str ); //??? use exact rounding library
+         pi.floatMinimum = strToDouble( value ); //??? use exact rounding library
       }
       else
       {
@@ -489,10 +903,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          }
       }
 
-      if ( isAttributeDefined( attributes, att_maximum ) )
+      if ( findAttribute( attributes, att_maximum, value ) )
       {
-         ustring maximum_str = lookupAttribute( attributes, att_maximum );
-         pi.floatMaximum = strToDouble( maximum_str ); //??? use exact rounding library
+         pi.floatMaximum = strToDouble( value ); //??? use exact rounding library
       }
       else
       {
@@ -507,7 +920,6 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          }
       }
 
-      stack_.push( pi );
    }
    else if ( node_type == "String" )
    {
@@ -516,7 +928,6 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
 #endif
       pi.nodeType = TypeString;
 
-      stack_.push( pi );
    }
    else if ( node_type == "Blob" )
    {
@@ -537,7 +948,6 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
 
       pi.length = convertStrToLL( length_str );
 
-      stack_.push( pi );
    }
    else if ( node_type == "Structure" )
    {
@@ -546,8 +956,10 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
 #endif
       pi.nodeType = TypeStructure;
 
+      const bool cIsRoot = ( toUString( localName ) == "e57Root" );
+
       // Read name space decls, if e57Root element
-      if ( toUString( localName ) == "e57Root" )
+      if ( cIsRoot )
       {
          // Search attributes for namespace declarations (only allowed in E57Root structure)
          bool gotDefault = false;
@@ -587,18 +999,20 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          }
       }
 
-      // Create container now, so can hold children
-      std::shared_ptr<StructureNodeImpl> s_ni( new StructureNodeImpl( imf_ ) );
+      // Create container now, so can hold children. When parsing a fragment its top element
+      // is the target.
+      std::shared_ptr<StructureNodeImpl> s_ni( ( target_ && ( stackDepth_ == 1 ) )
+                                                  ? target_
+                                                  : std::make_shared<StructureNodeImpl>( imf_ ) );
       pi.container_ni = s_ni;
 
       // After have Structure, check again if E57Root, if so mark attached so all children will be
       // attached when added
-      if ( toUString( localName ) == "e57Root" )
+      if ( cIsRoot )
       {
          s_ni->setAttachedRecursive();
       }
 
-      stack_.push( pi );
    }
    else if ( node_type == "Vector" )
    {
@@ -607,11 +1021,9 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
 #endif
       pi.nodeType = TypeVector;
 
-      if ( isAttributeDefined( attributes, att_allowHeterogeneousChildren ) )
+      if ( findAttribute( attributes, att_allowHeterogeneousChildren, value ) )
       {
-         ustring allowHetero_str = lookupAttribute( attributes, att_allowHeterogeneousChildren );
-
-         int64_t i64 = convertStrToLL( allowHetero_str );
+         int64_t i64 = convertStrToLL( value );
 
          if ( i64 == 0 )
          {
@@ -641,7 +1053,6 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          new VectorNodeImpl( imf_, pi.allowHeterogeneousChildren ) );
       pi.container_ni = v_ni;
 
-      stack_.push( pi );
    }
    else if ( node_type == "CompressedVector" )
    {
@@ -667,7 +1078,6 @@ void E57XmlParser::startElement( const XMLCh *const uri, const XMLCh *const loca
          imf_->file_->physicalToLogical( pi.fileOffset ) ); //??? what if file_ is NULL?
       pi.container_ni = cv_ni;
 
-      stack_.push( pi );
    }
    else
    {
@@ -688,9 +1098,8 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
    std::cout << "endElement" << std::endl;
 #endif
 
-   // Pop the node that just ended
-   ParseInfo pi = stack_.top(); //??? really want to make a copy here?
-   stack_.pop();
+   // Pop the node that just ended. Its entry stays valid until the next element starts.
+   ParseInfo &pi = stack_[--stackDepth_];
 #ifdef E57_VERBOSE
    pi.dump( 4 );
 #endif
@@ -803,8 +1212,14 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
 #endif
 
    // If first node in file ended, we are all done
-   if ( stack_.empty() )
+   if ( stackDepth_ == 0 )
    {
+      // The children of a fragment were added to the target as they ended
+      if ( target_ )
+      {
+         return;
+      }
+
       // Top level should be Structure
       if ( current_ni->type() != TypeStructure )
       {
@@ -819,7 +1234,7 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
    }
 
    // Get next level up node (when entered function), which should be a container.
-   NodeImplSharedPtr parent_ni = stack_.top().container_ni;
+   NodeImplSharedPtr parent_ni = stack_[stackDepth_ - 1].container_ni;
 
    if ( !parent_ni )
    {
@@ -837,8 +1252,12 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
          std::shared_ptr<StructureNodeImpl> struct_ni =
             std::static_pointer_cast<StructureNodeImpl>( parent_ni );
 
-         // Add named child to structure
-         struct_ni->set( toUString( qName ), current_ni );
+         // Add named child to structure. The name is a single element, so check it & skip
+         // parsing it as a path.
+         assignUString( fieldPath_[0], qName );
+         imf_->checkElementNameLegal( fieldPath_[0] );
+
+         struct_ni->set( fieldPath_, 0, current_ni );
       }
       break;
       case TypeVector:
@@ -908,15 +1327,12 @@ void E57XmlParser::endElement( const XMLCh *const uri, const XMLCh *const localN
 
 void E57XmlParser::characters( const XMLCh *const chars, const XMLSize_t length )
 {
-//??? use length to make ustring
 #ifdef E57_VERBOSE
    std::cout << "characters, chars=\"" << toUString( chars ) << "\" length=" << length << std::endl;
-#else
-   E57_UNUSED( length );
 #endif
 
    // Get active element
-   ParseInfo &pi = stack_.top();
+   ParseInfo &pi = stack_[stackDepth_ - 1];
 
    // Check if child text is allowed for current E57 element type
    switch ( pi.nodeType )
@@ -927,16 +1343,21 @@ void E57XmlParser::characters( const XMLCh *const chars, const XMLSize_t length
       case TypeBlob:
       {
          // If characters aren't whitespace, have an error, else ignore
-         ustring s = toUString( chars );
-         if ( s.find_first_not_of( " \t\n\r" ) != std::string::npos )
+         for ( size_t i = 0; i < length; ++i )
          {
-            throw E57_EXCEPTION2( ErrorBadXMLFormat, "chars=" + toUString( chars ) );
+            if ( !isXmlWhitespace( chars[i] ) )
+            {
+               ustring s;
+               appendUString( s, chars, length );
+
+               throw E57_EXCEPTION2( ErrorBadXMLFormat, "chars=" + s );
+            }
          }
       }
       break;
       default:
          // Append to any previous characters
-         pi.childText += toUString( chars );
+         appendUString( pi.childText, chars, length );
    }
 }
 
@@ -27,7 +27,7 @@
 
 #pragma once
 
-#include <stack>
+#include <vector>
 
 #include <xercesc/sax/InputSource.hpp>
 #include <xercesc/sax2/DefaultHandler.hpp>
@@ -48,7 +48,10 @@ namespace e57
    class E57XmlParser : public DefaultHandler
    {
    public:
-      explicit E57XmlParser( ImageFileImplSharedPtr imf );
+      /// If @a target is set, the children of the top element are added to it instead of making
+      /// a new root for @a imf (see ImageFileImpl::parseXmlFragment()).
+      explicit E57XmlParser( ImageFileImplSharedPtr imf,
+                             std::shared_ptr<StructureNodeImpl> target = {} );
       ~E57XmlParser() override;
 
       void init();
@@ -69,6 +72,8 @@ namespace e57
 
       ImageFileImplSharedPtr imf_; /// Image file we are reading
 
+      std::shared_ptr<StructureNodeImpl> target_; /// receives the children of the top element
+
       struct ParseInfo
       {
          // All the fields need to remember while parsing the XML
@@ -94,14 +99,37 @@ namespace e57
          NodeImplSharedPtr container_ni;
 
          ParseInfo(); // default ctor
+         void reset();
          void dump( int indent = 0, std::ostream &os = std::cout ) const;
       };
 
-      std::stack<ParseInfo> stack_; /// Stores the current path in tree we are reading
+      ParseInfo &pushParseInfo();
+
+      /// Stores the current path in tree we are reading. Entries above stackDepth_ are kept to
+      /// reuse their text buffers.
+      std::vector<ParseInfo> stack_;
+      size_t stackDepth_;
+
+      ustring nodeType_;     /// reused for the type attribute of each element
+      StringList fieldPath_; /// reused to add each child to its structure
 
       SAX2XMLReader *xmlReader;
    };
 
+   /// Where the content of an element which is built on first access is in the XML section
+   struct XmlLazyElement
+   {
+      ustring vectorName;     /// name of the top-level vector holding the element
+      size_t childIndex;      /// index of the element in the vector
+      uint64_t contentOffset; /// offset of the content (after the start tag) in the XML section
+      uint64_t contentLength; /// length of the content (up to the end tag)
+   };
+
+   /// Find the non-empty Structure children of the heterogeneous Vectors which are children of
+   /// the root element of @a xml. This only scans the tags, so returns false if the XML isn't well formed enough
+   /// to be sure of them; the full parse then reports the error.
+   bool findLazyXmlElements( const ustring &xml, std::vector<XmlLazyElement> &elements );
+
    class E57XmlFileInputSource : public InputSource
    {
    public:
@@ -119,4 +147,20 @@ namespace e57
       uint64_t logicalStart_;
       uint64_t logicalLength_;
    };
+
+   class E57XmlMemoryInputSource : public InputSource
+   {
+   public:
+      /// @a xml must stay valid while this is used
+      explicit E57XmlMemoryInputSource( const ustring &xml );
+      ~E57XmlMemoryInputSource() override = default;
+
+      E57XmlMemoryInputSource( const E57XmlMemoryInputSource & ) = delete;
+      E57XmlMemoryInputSource &operator=( const E57XmlMemoryInputSource & ) = delete;
+
+      BinInputStream *makeStream() const override;
+
+   private:
+      const ustring &xml_;
+   };
 }
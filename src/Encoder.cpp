@@ -26,8 +26,12 @@
  */
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <limits>
+#include <type_traits>
 
+#include "BitPack.h"
 #include "CompressedVectorNodeImpl.h"
 #include "Encoder.h"
 #include "FloatNodeImpl.h"
@@ -44,6 +48,21 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
                                                   std::shared_ptr<CompressedVectorNodeImpl> cVector,
                                                   std::vector<SourceDestBuffer> &sbufs,
                                                   ustring & /*codecPath*/ )
+{
+   std::shared_ptr<Encoder> encoder = FieldEncoderFactory( bytestreamNumber, cVector, sbufs );
+
+   // The LZ codec compresses the bytestream of the encoder of the field's type
+   if ( findCodec( *cVector, sbufs.at( 0 ).pathName() ) == Codec::Lz )
+   {
+      encoder = std::make_shared<LzEncoder>( bytestreamNumber, encoder );
+   }
+
+   return encoder;
+}
+
+std::shared_ptr<Encoder> Encoder::FieldEncoderFactory(
+   unsigned bytestreamNumber, const std::shared_ptr<CompressedVectorNodeImpl> &cVector,
+   std::vector<SourceDestBuffer> &sbufs )
 {
    //??? For now, only handle one input
    if ( sbufs.size() != 1 )
@@ -88,6 +107,14 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
             return encoder;
          }
 
+         if ( findCodec( *cVector, path ) == Codec::DeltaInteger )
+         {
+            std::shared_ptr<Encoder> encoder(
+               new DeltaIntegerEncoder( false, bytestreamNumber, sbuf, DATA_PACKET_MAX,
+                                        ini->minimum(), ini->maximum(), 1.0, 0.0 ) );
+            return encoder;
+         }
+
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint8_t>(
@@ -143,6 +170,14 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
             return encoder;
          }
 
+         if ( findCodec( *cVector, path ) == Codec::DeltaInteger )
+         {
+            std::shared_ptr<Encoder> encoder( new DeltaIntegerEncoder(
+               true, bytestreamNumber, sbuf, DATA_PACKET_MAX, sini->minimum(), sini->maximum(),
+               sini->scale(), sini->offset() ) );
+            return encoder;
+         }
+
          if ( bitsPerRecord <= 8 )
          {
             std::shared_ptr<Encoder> encoder( new BitpackIntegerEncoder<uint8_t>(
@@ -179,8 +214,9 @@ std::shared_ptr<Encoder> Encoder::EncoderFactory( unsigned bytestreamNumber,
             std::static_pointer_cast<FloatNodeImpl>( encodeNode ); // downcast to correct type
 
          // !!! need to pick smarter channel buffer sizes, here and elsewhere
-         std::shared_ptr<Encoder> encoder( new BitpackFloatEncoder(
-            bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/, fni->precision() ) );
+         std::shared_ptr<Encoder> encoder(
+            new BitpackFloatEncoder( bytestreamNumber, sbuf, DATA_PACKET_MAX /*!!!*/,
+                                     fni->precision(), fni->minimum(), fni->maximum() ) );
          return encoder;
       }
 
@@ -215,8 +251,8 @@ void Encoder::dump( int indent, std::ostream &os ) const
 BitpackEncoder::BitpackEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
                                 unsigned outputMaxSize, unsigned alignmentSize ) :
    Encoder( bytestreamNumber ), sourceBuffer_( sbuf.impl() ), outBuffer_( outputMaxSize ),
-   outBufferFirst_( 0 ), outBufferEnd_( 0 ), outBufferAlignmentSize_( alignmentSize ),
-   currentRecordIndex_( 0 )
+   outBufferMemory_( Memory::Writers, outBuffer_.size() ), outBufferFirst_( 0 ),
+   outBufferEnd_( 0 ), outBufferAlignmentSize_( alignmentSize ), currentRecordIndex_( 0 )
 {
 }
 
@@ -306,6 +342,7 @@ void BitpackEncoder::outputSetMaxSize( unsigned byteCount )
    if ( byteCount > outBuffer_.size() )
    {
       outBuffer_.resize( byteCount );
+      outBufferMemory_.set( outBuffer_.size() );
    }
 }
 
@@ -324,6 +361,14 @@ void BitpackEncoder::outBufferShiftDown()
       return;
    }
 
+   // Leave the data where it is while there is at least as much room after it as there is before
+   // it, so the encoded bytes are only moved now and then rather than after every packet. Once
+   // the end of the buffer is reached, the room before the data is always reclaimed.
+   if ( outBufferFirst_ < outBuffer_.size() - outBufferEnd_ )
+   {
+      return;
+   }
+
    // Round newEnd up to nearest multiple of outBufferAlignmentSize_.
    size_t newEnd = outputAvailable();
    size_t remainder = newEnd % outBufferAlignmentSize_;
@@ -387,12 +432,62 @@ void BitpackEncoder::dump( int indent, std::ostream &os ) const
 
 //================
 
+namespace
+{
+   // The smallest float which isn't less than value, so a float is below value exactly when it is
+   // below the result.
+   float floatAtLeast( double value )
+   {
+      if ( value <= -FLOAT_MAX )
+      {
+         return -FLOAT_MAX;
+      }
+
+      if ( value > FLOAT_MAX )
+      {
+         return std::numeric_limits<float>::infinity();
+      }
+
+      const auto cRounded = static_cast<float>( value );
+
+      if ( cRounded < value )
+      {
+         return std::nextafter( cRounded, std::numeric_limits<float>::infinity() );
+      }
+
+      return cRounded;
+   }
+
+   // The largest float which isn't greater than value
+   float floatAtMost( double value )
+   {
+      return -floatAtLeast( -value );
+   }
+}
+
 BitpackFloatEncoder::BitpackFloatEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
-                                          unsigned outputMaxSize, FloatPrecision precision ) :
+                                          unsigned outputMaxSize, FloatPrecision precision,
+                                          double minimum, double maximum ) :
    BitpackEncoder( bytestreamNumber, sbuf, outputMaxSize,
                    ( precision == PrecisionSingle ) ? sizeof( float ) : sizeof( double ) ),
-   precision_( precision )
+   precision_( precision ), minimum_( minimum ), maximum_( maximum )
+{
+   if ( precision_ == PrecisionSingle )
+   {
+      floatMinimum_ = floatAtLeast( minimum_ );
+      floatMaximum_ = floatAtMost( maximum_ );
+
+      limitsRestrict_ = ( floatMinimum_ > -FLOAT_MAX ) || ( floatMaximum_ < FLOAT_MAX );
+   }
+   else
+   {
+      limitsRestrict_ = ( minimum_ > DOUBLE_MIN ) || ( maximum_ < DOUBLE_MAX );
+   }
+}
+
+void BitpackFloatEncoder::setCheckFloatLimits( bool check )
 {
+   rangeChecked_ = check && limitsRestrict_;
 }
 
 uint64_t BitpackFloatEncoder::processRecords( size_t recordCount )
@@ -432,14 +527,25 @@ uint64_t BitpackFloatEncoder::processRecords( size_t recordCount )
       // Form the starting address for next available location in outBuffer
       auto outp = reinterpret_cast<float *>( &outBuffer_[outBufferEnd_] );
 
-      // Copy floats from sourceBuffer_ to outBuffer_
-      for ( unsigned i = 0; i < recordCount; i++ )
+      // Copy floats from sourceBuffer_ to outBuffer_ as a block, then check them all at once.
+      // Both use vector instructions where possible, as does gathering the statistics.
+      sourceBuffer_->getNextFloatBlock( outp, recordCount );
+
+      if ( rangeChecked_ )
       {
-         outp[i] = sourceBuffer_->getNextFloat();
+         checkRange( outp, recordCount );
+      }
+
+      if ( realStatistics_ != nullptr )
+      {
+         realStatistics_->add( currentRecordIndex_, outp, recordCount );
+      }
 #ifdef E57_VERBOSE
+      for ( unsigned i = 0; i < recordCount; i++ )
+      {
          std::cout << "encoding float: " << outp[i] << std::endl;
-#endif
       }
+#endif
    }
    else
    {
@@ -448,13 +554,23 @@ uint64_t BitpackFloatEncoder::processRecords( size_t recordCount )
       auto outp = reinterpret_cast<double *>( &outBuffer_[outBufferEnd_] );
 
       // Copy doubles from sourceBuffer_ to outBuffer_
-      for ( unsigned i = 0; i < recordCount; i++ )
+      sourceBuffer_->getNextDoubleBlock( outp, recordCount );
+
+      if ( rangeChecked_ )
       {
-         outp[i] = sourceBuffer_->getNextDouble();
+         checkRange( outp, recordCount );
+      }
+
+      if ( realStatistics_ != nullptr )
+      {
+         realStatistics_->add( currentRecordIndex_, outp, recordCount );
+      }
 #ifdef E57_VERBOSE
+      for ( unsigned i = 0; i < recordCount; i++ )
+      {
          std::cout << "encoding double: " << outp[i] << std::endl;
-#endif
       }
+#endif
    }
 
    // Update end of outBuffer
@@ -466,6 +582,22 @@ uint64_t BitpackFloatEncoder::processRecords( size_t recordCount )
    return ( currentRecordIndex_ );
 }
 
+template <typename T> void BitpackFloatEncoder::checkRange( const T *values, size_t count ) const
+{
+   const bool cSingle = std::is_same<T, float>::value;
+
+   const size_t cBadIndex =
+      BitPack::findOutOfRange( values, count, static_cast<T>( cSingle ? floatMinimum_ : minimum_ ),
+                               static_cast<T>( cSingle ? floatMaximum_ : maximum_ ) );
+
+   if ( cBadIndex != count )
+   {
+      throw E57_EXCEPTION2( ErrorValueOutOfBounds, "value=" + toString( values[cBadIndex] ) +
+                                                      " minimum=" + toString( minimum_ ) +
+                                                      " maximum=" + toString( maximum_ ) );
+   }
+}
+
 bool BitpackFloatEncoder::registerFlushToOutput()
 {
    // Since have no registers in encoder, return success
@@ -582,10 +714,8 @@ uint64_t BitpackStringEncoder::processRecords( size_t recordCount )
          size_t bytesToProcess =
             std::min( currentString_.length() - currentCharPosition_, bytesFree );
 
-         for ( size_t i = 0; i < bytesToProcess; i++ )
-         {
-            *outp++ = currentString_[currentCharPosition_ + i];
-         }
+         memcpy( outp, currentString_.data() + currentCharPosition_, bytesToProcess );
+         outp += bytesToProcess;
 
          currentCharPosition_ += bytesToProcess;
          totalBytesProcessed_ += bytesToProcess;
@@ -601,7 +731,13 @@ uint64_t BitpackStringEncoder::processRecords( size_t recordCount )
       if ( !isStringActive_ && recordsProcessed < recordCount )
       {
          // Get next string from sourceBuffer
-         currentString_ = sourceBuffer_->getNextString();
+         // Copy into currentString_, reusing its memory, since the string may not all fit in
+         // this call's output
+         const char *chars = nullptr;
+         size_t length = 0;
+
+         sourceBuffer_->getNextString( chars, length );
+         currentString_.assign( chars, length );
          isStringActive_ = true;
          prefixComplete_ = false;
          currentCharPosition_ = 0;
@@ -723,104 +859,69 @@ uint64_t BitpackIntegerEncoder<RegisterT>::processRecords( size_t recordCount )
    auto outp = reinterpret_cast<RegisterT *>( &outBuffer_[outBufferEnd_] );
    unsigned outTransferred = 0;
 
-   // Copy bits from sourceBuffer_ to outBuffer_
-   for ( unsigned i = 0; i < recordCount; i++ )
+   // Copy bits from sourceBuffer_ to outBuffer_ a block at a time: fetch the values, check they
+   // are all in range, then pack them. The last two steps use vector instructions if available.
+   constexpr size_t cBlockSize = 256;
+
+   int64_t values[cBlockSize];
+
+   BitPack::PackState state;
+   state.word = register_;
+   state.bitsUsed = registerBitsUsed_;
+
+   for ( size_t done = 0; done < recordCount; )
    {
-      int64_t rawValue;
+      const size_t blockCount = std::min( cBlockSize, recordCount - done );
 
-      // The parameter isScaledInteger_ determines which version of getNextInt64 gets called
+      // The parameter isScaledInteger_ determines which version of getNextInt64Block gets called
       if ( isScaledInteger_ )
       {
-         rawValue = sourceBuffer_->getNextInt64( scale_, offset_ );
+         sourceBuffer_->getNextInt64Block( values, blockCount, scale_, offset_ );
       }
       else
       {
-         rawValue = sourceBuffer_->getNextInt64();
+         sourceBuffer_->getNextInt64Block( values, blockCount );
       }
 
-      // Enforce min/max specification on value
-      if ( rawValue < minimum_ || maximum_ < rawValue )
+      // Enforce min/max specification on values
+      const size_t badIndex = BitPack::findOutOfRange( values, blockCount, minimum_, maximum_ );
+
+      if ( badIndex != blockCount )
       {
-         throw E57_EXCEPTION2( ErrorValueOutOfBounds, "rawValue=" + toString( rawValue ) +
+         throw E57_EXCEPTION2( ErrorValueOutOfBounds, "rawValue=" + toString( values[badIndex] ) +
                                                          " minimum=" + toString( minimum_ ) +
                                                          " maximum=" + toString( maximum_ ) );
       }
 
-      auto uValue = static_cast<uint64_t>( rawValue - minimum_ );
-
-#ifdef E57_VERBOSE
-      std::cout << "encoding integer rawValue=" << binaryString( rawValue ) << " = "
-                << hexString( rawValue ) << std::endl;
-      std::cout << "                 uValue  =" << binaryString( uValue ) << " = "
-                << hexString( uValue ) << std::endl;
-#endif
-#ifdef VALIDATE_BASIC
-      // Double check that no bits outside of the mask are set
-      if ( uValue & ~static_cast<uint64_t>( sourceBitMask_ ) )
+      if ( integerStatistics_ != nullptr )
       {
-         throw E57_EXCEPTION2( ErrorInternal, "uValue=" + toString( uValue ) );
+         integerStatistics_->add( currentRecordIndex_ + done, values, blockCount );
       }
-#endif
-      // Mask off upper bits (just in case)
-      uValue &= static_cast<uint64_t>( sourceBitMask_ );
-
-      // See if uValue bits will fit in register
-      unsigned newRegisterBitsUsed = registerBitsUsed_ + bitsPerRecord_;
-#ifdef E57_VERBOSE
-      std::cout << "  registerBitsUsed=" << registerBitsUsed_
-                << "  newRegisterBitsUsed=" << newRegisterBitsUsed << std::endl;
-#endif
-      if ( newRegisterBitsUsed > 8 * sizeof( RegisterT ) )
-      {
-         // Have more than one registers worth, fill register, transfer, then fill some more
-         register_ |= static_cast<RegisterT>( uValue ) << registerBitsUsed_;
-#ifdef VALIDATE_BASIC
-         // Before transfer, double check address within bounds
-         if ( outTransferred >= transferMax )
-         {
-            throw E57_EXCEPTION2( ErrorInternal, "outTransferred=" + toString( outTransferred ) +
-                                                    " transferMax" + toString( transferMax ) );
-         }
-#endif
-         outp[outTransferred] = register_;
 
-         outTransferred++;
+      outTransferred += static_cast<unsigned>(
+         BitPack::pack( values, blockCount, minimum_, bitsPerRecord_, sizeof( RegisterT ), state,
+                        reinterpret_cast<char *>( outp + outTransferred ) ) );
 
-         register_ =
-            static_cast<RegisterT>( uValue ) >> ( 8 * sizeof( RegisterT ) - registerBitsUsed_ );
-         registerBitsUsed_ = newRegisterBitsUsed - 8 * sizeof( RegisterT );
-      }
-      else if ( newRegisterBitsUsed == 8 * sizeof( RegisterT ) )
-      {
-         // Input will exactly fill register, insert value, then transfer
-         register_ |= static_cast<RegisterT>( uValue ) << registerBitsUsed_;
 #ifdef VALIDATE_BASIC
-         // Before transfer, double check address within bounds
-         if ( outTransferred >= transferMax )
-         {
-            throw E57_EXCEPTION2( ErrorInternal, "outTransferred=" + toString( outTransferred ) +
-                                                    " transferMax" + toString( transferMax ) );
-         }
+      // Double check address within bounds
+      if ( outTransferred > transferMax )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "outTransferred=" + toString( outTransferred ) +
+                                                 " transferMax" + toString( transferMax ) );
+      }
 #endif
-         outp[outTransferred] = register_;
 
-         outTransferred++;
+      done += blockCount;
+   }
+
+   register_ = static_cast<RegisterT>( state.word );
+   registerBitsUsed_ = state.bitsUsed;
 
-         register_ = 0;
-         registerBitsUsed_ = 0;
-      }
-      else
-      {
-         // There is extra room in register, insert value, but don't do transfer yet
-         register_ |= static_cast<RegisterT>( uValue ) << registerBitsUsed_;
-         registerBitsUsed_ = newRegisterBitsUsed;
-      }
 #ifdef E57_VERBOSE
-      std::cout << "  After " << outTransferred << " transfers and " << i + 1
-                << " records, encoder:" << std::endl;
-      dump( 4 );
+   std::cout << "  After " << outTransferred << " transfers and " << recordCount
+             << " records, encoder:" << std::endl;
+   dump( 4 );
 #endif
-   }
 
    // Update tail of output buffer
    outBufferEnd_ += outTransferred * sizeof( RegisterT );
@@ -851,6 +952,12 @@ template <typename RegisterT> bool BitpackIntegerEncoder<RegisterT>::registerFlu
    // RegisterT boundary
    if ( registerBitsUsed_ > 0 )
    {
+      // The data may have been left at the end of the buffer, so make room for the register
+      if ( outBufferEnd_ >= outBuffer_.size() - sizeof( RegisterT ) )
+      {
+         outBufferShiftDown();
+      }
+
       if ( outBufferEnd_ < outBuffer_.size() - sizeof( RegisterT ) )
       {
          auto outp = reinterpret_cast<RegisterT *>( &outBuffer_[outBufferEnd_] );
@@ -893,6 +1000,293 @@ void BitpackIntegerEncoder<RegisterT>::dump( int indent, std::ostream &os ) cons
 
 //================================================================
 
+DeltaIntegerEncoder::DeltaIntegerEncoder( bool isScaledInteger, unsigned bytestreamNumber,
+                                          SourceDestBuffer &sbuf, unsigned outputMaxSize,
+                                          int64_t minimum, int64_t maximum, double scale,
+                                          double offset ) :
+   BitpackEncoder( bytestreamNumber, sbuf, outputMaxSize, 1 ), isScaledInteger_( isScaledInteger ),
+   minimum_( minimum ), maximum_( maximum ), scale_( scale ), offset_( offset )
+{
+   ImageFileImplSharedPtr imf( sbuf.impl()->destImageFile() );
+
+   fieldBits_ = imf->bitsNeeded( minimum_, maximum_ );
+   blockMaxSize_ = deltaBlockMaxSize( fieldBits_ );
+}
+
+uint64_t DeltaIntegerEncoder::processRecords( size_t recordCount )
+{
+   outBufferShiftDown();
+
+   for ( size_t done = 0; done < recordCount; )
+   {
+      // Leave the records in the source buffer unless the largest block can be written
+      if ( outBuffer_.size() - outBufferEnd_ < blockMaxSize_ )
+      {
+         break;
+      }
+
+      const size_t cCount = std::min( cDeltaBlockRecordCount - blockCount_, recordCount - done );
+      int64_t *values = &block_[blockCount_];
+
+      if ( isScaledInteger_ )
+      {
+         sourceBuffer_->getNextInt64Block( values, cCount, scale_, offset_ );
+      }
+      else
+      {
+         sourceBuffer_->getNextInt64Block( values, cCount );
+      }
+
+      const size_t badIndex = BitPack::findOutOfRange( values, cCount, minimum_, maximum_ );
+
+      if ( badIndex != cCount )
+      {
+         throw E57_EXCEPTION2( ErrorValueOutOfBounds, "rawValue=" + toString( values[badIndex] ) +
+                                                         " minimum=" + toString( minimum_ ) +
+                                                         " maximum=" + toString( maximum_ ) );
+      }
+
+      if ( integerStatistics_ != nullptr )
+      {
+         integerStatistics_->add( currentRecordIndex_, values, cCount );
+      }
+
+      blockCount_ += cCount;
+      currentRecordIndex_ += cCount;
+      done += cCount;
+
+      if ( blockCount_ == cDeltaBlockRecordCount )
+      {
+         blockWrite();
+      }
+   }
+
+   return currentRecordIndex_;
+}
+
+bool DeltaIntegerEncoder::blockWrite()
+{
+   if ( outBuffer_.size() - outBufferEnd_ < blockMaxSize_ )
+   {
+      outBufferShiftDown();
+
+      if ( outBuffer_.size() - outBufferEnd_ < blockMaxSize_ )
+      {
+         return false;
+      }
+   }
+
+   const size_t cSize =
+      deltaBlockEncode( block_, blockCount_, minimum_, fieldBits_, &outBuffer_[outBufferEnd_] );
+
+   outBufferEnd_ += cSize;
+   bytesEncoded_ += cSize;
+   recordsEncoded_ += blockCount_;
+   blockCount_ = 0;
+
+   return true;
+}
+
+bool DeltaIntegerEncoder::registerFlushToOutput()
+{
+   // Only the last block of the vector is partial: chunks are whole blocks
+   return ( blockCount_ == 0 ) || blockWrite();
+}
+
+float DeltaIntegerEncoder::bitsPerRecord()
+{
+   // The size of the blocks written so far, or the size of the raw values to start with
+   if ( recordsEncoded_ == 0 )
+   {
+      return static_cast<float>( fieldBits_ );
+   }
+
+   return static_cast<float>( bytesEncoded_ * 8 ) / static_cast<float>( recordsEncoded_ );
+}
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+void DeltaIntegerEncoder::dump( int indent, std::ostream &os ) const
+{
+   BitpackEncoder::dump( indent, os );
+   os << space( indent ) << "isScaledInteger:  " << isScaledInteger_ << std::endl;
+   os << space( indent ) << "minimum:          " << minimum_ << std::endl;
+   os << space( indent ) << "maximum:          " << maximum_ << std::endl;
+   os << space( indent ) << "scale:            " << scale_ << std::endl;
+   os << space( indent ) << "offset:           " << offset_ << std::endl;
+   os << space( indent ) << "fieldBits:        " << fieldBits_ << std::endl;
+   os << space( indent ) << "blockCount:       " << blockCount_ << std::endl;
+}
+#endif
+
+LzEncoder::LzEncoder( unsigned bytestreamNumber, std::shared_ptr<Encoder> encoder ) :
+   Encoder( bytestreamNumber ), encoder_( std::move( encoder ) ), raw_( cLzBlockMaxRawSize )
+{
+}
+
+uint64_t LzEncoder::processRecords( size_t recordCount )
+{
+   const uint64_t cEndRecord = encoder_->currentRecordIndex() + recordCount;
+
+   // Empty the output of encoder_ whenever it fills, until there is a packet of output
+   while ( outputAvailable() < DATA_PACKET_MAX )
+   {
+      const uint64_t cRecordIndex = encoder_->currentRecordIndex();
+
+      if ( cRecordIndex < cEndRecord )
+      {
+         encoder_->processRecords( static_cast<size_t>( cEndRecord - cRecordIndex ) );
+      }
+
+      blocksCompress( false );
+
+      if ( ( encoder_->currentRecordIndex() == cRecordIndex ) ||
+           ( encoder_->currentRecordIndex() == cEndRecord ) )
+      {
+         break;
+      }
+   }
+
+   return encoder_->currentRecordIndex();
+}
+
+void LzEncoder::blocksCompress( bool all )
+{
+   for ( size_t available = encoder_->outputAvailable();
+         ( available >= cLzBlockMaxRawSize ) || ( all && ( available > 0 ) );
+         available = encoder_->outputAvailable() )
+   {
+      const size_t cRawSize = std::min( available, cLzBlockMaxRawSize );
+
+      encoder_->outputRead( raw_.data(), cRawSize );
+
+      // Drop the bytes already read, so the header & worst case block fit after the rest
+      outBuffer_.erase( outBuffer_.begin(),
+                        outBuffer_.begin() + static_cast<std::ptrdiff_t>( outBufferFirst_ ) );
+      outBufferFirst_ = 0;
+
+      const size_t cStart = outBuffer_.size();
+
+      outBuffer_.resize( cStart + cLzBlockHeaderSize + lzMaxCompressedSize( cRawSize ) );
+
+      char *block = &outBuffer_[cStart];
+      size_t storedSize = lzCompress( raw_.data(), cRawSize, block + cLzBlockHeaderSize );
+
+      // Store the bytes as they are if they don't compress
+      if ( storedSize >= cRawSize )
+      {
+         storedSize = cRawSize;
+         memcpy( block + cLzBlockHeaderSize, raw_.data(), cRawSize );
+      }
+
+      block[0] = static_cast<char>( cRawSize & 0xff );
+      block[1] = static_cast<char>( cRawSize >> 8 );
+      block[2] = static_cast<char>( storedSize & 0xff );
+      block[3] = static_cast<char>( storedSize >> 8 );
+
+      outBuffer_.resize( cStart + cLzBlockHeaderSize + storedSize );
+
+      rawBytes_ += cRawSize;
+      storedBytes_ += cLzBlockHeaderSize + storedSize;
+   }
+}
+
+unsigned LzEncoder::sourceBufferNextIndex()
+{
+   return encoder_->sourceBufferNextIndex();
+}
+
+uint64_t LzEncoder::currentRecordIndex()
+{
+   return encoder_->currentRecordIndex();
+}
+
+float LzEncoder::bitsPerRecord()
+{
+   // The bits of encoder_, scaled by how well its output has compressed so far
+   const float cBits = encoder_->bitsPerRecord();
+
+   if ( rawBytes_ == 0 )
+   {
+      return cBits;
+   }
+
+   return cBits * static_cast<float>( storedBytes_ ) / static_cast<float>( rawBytes_ );
+}
+
+bool LzEncoder::registerFlushToOutput()
+{
+   // Make room for the partial word of encoder_, then compress everything
+   blocksCompress( false );
+
+   const bool cFlushed = encoder_->registerFlushToOutput();
+
+   blocksCompress( true );
+
+   return cFlushed;
+}
+
+size_t LzEncoder::outputAvailable() const
+{
+   return outBuffer_.size() - outBufferFirst_;
+}
+
+void LzEncoder::outputRead( char *dest, size_t byteCount )
+{
+   if ( byteCount > outputAvailable() )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "byteCount=" + toString( byteCount ) +
+                                              " outputAvailable=" + toString( outputAvailable() ) );
+   }
+
+   memcpy( dest, &outBuffer_[outBufferFirst_], byteCount );
+   outBufferFirst_ += byteCount;
+}
+
+void LzEncoder::outputClear()
+{
+   outBuffer_.clear();
+   outBufferFirst_ = 0;
+}
+
+void LzEncoder::sourceBufferSetNew( std::vector<SourceDestBuffer> &sbufs )
+{
+   encoder_->sourceBufferSetNew( sbufs );
+}
+
+size_t LzEncoder::outputGetMaxSize()
+{
+   return std::max<size_t>( outBuffer_.size(), DATA_PACKET_MAX );
+}
+
+void LzEncoder::outputSetMaxSize( unsigned byteCount )
+{
+   // The output grows as needed
+   E57_UNUSED( byteCount );
+}
+
+void LzEncoder::setChunkStatistics( ChunkStatistics<int64_t> *integerStatistics,
+                                    ChunkStatistics<double> *realStatistics )
+{
+   encoder_->setChunkStatistics( integerStatistics, realStatistics );
+}
+
+void LzEncoder::setCheckFloatLimits( bool check )
+{
+   encoder_->setCheckFloatLimits( check );
+}
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+void LzEncoder::dump( int indent, std::ostream &os ) const
+{
+   Encoder::dump( indent, os );
+   os << space( indent ) << "rawBytes:               " << rawBytes_ << std::endl;
+   os << space( indent ) << "storedBytes:            " << storedBytes_ << std::endl;
+   os << space( indent ) << "outputAvailable:        " << outputAvailable() << std::endl;
+   os << space( indent ) << "encoder:" << std::endl;
+   encoder_->dump( indent + 4, os );
+}
+#endif
+
 ConstantIntegerEncoder::ConstantIntegerEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
                                                 int64_t minimum ) :
    Encoder( bytestreamNumber ), sourceBuffer_( sbuf.impl() ), currentRecordIndex_( 0 ),
@@ -919,6 +1313,11 @@ uint64_t ConstantIntegerEncoder::processRecords( size_t recordCount )
       }
    }
 
+   if ( integerStatistics_ != nullptr )
+   {
+      integerStatistics_->addConstant( currentRecordIndex_, recordCount, minimum_ );
+   }
+
    // Update counts of records processed
    currentRecordIndex_ += recordCount;
 
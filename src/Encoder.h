@@ -27,7 +27,10 @@
 
 #pragma once
 
+#include "ChunkStatistics.h"
+#include "Codecs.h"
 #include "Common.h"
+#include "Memory.h"
 
 namespace e57
 {
@@ -38,6 +41,11 @@ namespace e57
          unsigned bytestreamNumber, std::shared_ptr<CompressedVectorNodeImpl> cVector,
          std::vector<SourceDestBuffer> &sbuf, ustring &codecPath );
 
+      /// The encoder of the type of the field of @a sbufs, without the LZ codec.
+      static std::shared_ptr<Encoder> FieldEncoderFactory(
+         unsigned bytestreamNumber, const std::shared_ptr<CompressedVectorNodeImpl> &cVector,
+         std::vector<SourceDestBuffer> &sbufs );
+
       virtual ~Encoder() = default;
 
       virtual uint64_t processRecords( size_t recordCount ) = 0;
@@ -59,6 +67,22 @@ namespace e57
          return bytestreamNumber_;
       }
 
+      /// Gather the minimum & maximum of the values encoded in each chunk of records. Integer
+      /// encoders use @a integerStatistics and float encoders @a realStatistics.
+      virtual void setChunkStatistics( ChunkStatistics<int64_t> *integerStatistics,
+                                       ChunkStatistics<double> *realStatistics )
+      {
+         integerStatistics_ = integerStatistics;
+         realStatistics_ = realStatistics;
+      }
+
+      /// Check the values of float fields against the limits of their FloatNode (see
+      /// CompressedVectorWriterOptions::checkFloatLimits). Other encoders ignore it.
+      virtual void setCheckFloatLimits( bool check )
+      {
+         E57_UNUSED( check );
+      }
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       virtual void dump( int indent = 0, std::ostream &os = std::cout ) const;
 #endif
@@ -67,6 +91,9 @@ namespace e57
       explicit Encoder( unsigned bytestreamNumber );
 
       unsigned bytestreamNumber_;
+
+      ChunkStatistics<int64_t> *integerStatistics_ = nullptr; /// set to gather integer statistics
+      ChunkStatistics<double> *realStatistics_ = nullptr;     /// set to gather float statistics
    };
 
    class BitpackEncoder : public Encoder
@@ -99,6 +126,7 @@ namespace e57
       std::shared_ptr<SourceDestBufferImpl> sourceBuffer_;
 
       std::vector<char> outBuffer_;
+      Memory::Charge outBufferMemory_;
       size_t outBufferFirst_;
       size_t outBufferEnd_;
       size_t outBufferAlignmentSize_;
@@ -109,11 +137,17 @@ namespace e57
    class BitpackFloatEncoder : public BitpackEncoder
    {
    public:
+      /// Once setCheckFloatLimits() is called, the values are checked against @a minimum &
+      /// @a maximum, the limits of the FloatNode, unless they admit every finite value of
+      /// @a precision.
       BitpackFloatEncoder( unsigned bytestreamNumber, SourceDestBuffer &sbuf,
-                           unsigned outputMaxSize, FloatPrecision precision );
+                           unsigned outputMaxSize, FloatPrecision precision,
+                           double minimum = DOUBLE_MIN, double maximum = DOUBLE_MAX );
 
       uint64_t processRecords( size_t recordCount ) override;
       bool registerFlushToOutput() override;
+
+      void setCheckFloatLimits( bool check ) override;
       float bitsPerRecord() override;
 
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
@@ -121,7 +155,17 @@ namespace e57
 #endif
 
    protected:
+      /// Throws ErrorValueOutOfBounds if any of the @a count values is outside the limits.
+      template <typename T> void checkRange( const T *values, size_t count ) const;
+
       FloatPrecision precision_;
+
+      bool limitsRestrict_ = false; /// the limits exclude some finite values
+      bool rangeChecked_ = false;
+      double minimum_;
+      double maximum_;
+      float floatMinimum_ = 0.0F; /// minimum_ rounded up to a float, to check floats against
+      float floatMaximum_ = 0.0F; /// maximum_ rounded down to a float
    };
 
    class BitpackStringEncoder : public BitpackEncoder
@@ -173,6 +217,91 @@ namespace e57
       RegisterT register_;
    };
 
+   /// Encoder of the delta codec extension (see Codec::DeltaInteger): the records are encoded in
+   /// blocks of cDeltaBlockRecordCount, each block being written once it is complete (or when
+   /// the encoder is flushed).
+   class DeltaIntegerEncoder : public BitpackEncoder
+   {
+   public:
+      DeltaIntegerEncoder( bool isScaledInteger, unsigned bytestreamNumber, SourceDestBuffer &sbuf,
+                           unsigned outputMaxSize, int64_t minimum, int64_t maximum, double scale,
+                           double offset );
+
+      uint64_t processRecords( size_t recordCount ) override;
+      bool registerFlushToOutput() override;
+      float bitsPerRecord() override;
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+      void dump( int indent = 0, std::ostream &os = std::cout ) const override;
+#endif
+
+   protected:
+      /// Write the records of block_, if there is room for them.
+      bool blockWrite();
+
+      bool isScaledInteger_;
+      int64_t minimum_;
+      int64_t maximum_;
+      double scale_;
+      double offset_;
+      unsigned fieldBits_;
+      size_t blockMaxSize_;
+
+      int64_t block_[cDeltaBlockRecordCount];
+      size_t blockCount_ = 0;
+
+      uint64_t bytesEncoded_ = 0;
+      uint64_t recordsEncoded_ = 0;
+   };
+
+   /// Encoder of the LZ codec extension (see Codec::Lz): the output of the bitPackCodec encoder
+   /// @a encoder is compressed in blocks of up to cLzBlockMaxRawSize bytes with lzCompress().
+   /// Each chunk of records starts with a new block, as the encoder is flushed at the end of
+   /// the chunk before.
+   class LzEncoder : public Encoder
+   {
+   public:
+      LzEncoder( unsigned bytestreamNumber, std::shared_ptr<Encoder> encoder );
+
+      uint64_t processRecords( size_t recordCount ) override;
+      unsigned sourceBufferNextIndex() override;
+      uint64_t currentRecordIndex() override;
+      float bitsPerRecord() override;
+      bool registerFlushToOutput() override;
+
+      size_t outputAvailable() const override;
+      void outputRead( char *dest, size_t byteCount ) override;
+      void outputClear() override;
+
+      void sourceBufferSetNew( std::vector<SourceDestBuffer> &sbufs ) override;
+      size_t outputGetMaxSize() override;
+      void outputSetMaxSize( unsigned byteCount ) override;
+
+      void setChunkStatistics( ChunkStatistics<int64_t> *integerStatistics,
+                               ChunkStatistics<double> *realStatistics ) override;
+      void setCheckFloatLimits( bool check ) override;
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+      void dump( int indent = 0, std::ostream &os = std::cout ) const override;
+#endif
+
+   private:
+      /// Compress the output of encoder_ into blocks, leaving less than a whole block unless
+      /// @a all is set.
+      void blocksCompress( bool all );
+
+      std::shared_ptr<Encoder> encoder_;
+
+      std::vector<char> raw_;
+
+      // Grows as needed, so flushing never has to wait for the output to be read
+      std::vector<char> outBuffer_;
+      size_t outBufferFirst_ = 0;
+
+      uint64_t rawBytes_ = 0;
+      uint64_t storedBytes_ = 0;
+   };
+
    class ConstantIntegerEncoder : public Encoder
    {
    public:
@@ -0,0 +1,712 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+
+#include "BlobNodeImpl.h"
+#include "CheckedFile.h"
+#include "CompressedVectorNodeImpl.h"
+#include "FileMerger.h"
+#include "ImageFileImpl.h"
+#include "SectionHeaders.h"
+#include "StringFunctions.h"
+#include "StringNodeImpl.h"
+#include "VectorNodeImpl.h"
+
+namespace
+{
+   using namespace e57;
+
+   // Size of the blocks the binary sections are read ahead in
+   constexpr size_t cBlockSize = 256 * CheckedFile::logicalPageSize;
+
+   // The bytes copied for a blob or compressed vector: its whole binary section for a compressed
+   // vector (whose offsets are then moved by copyTo()), only the bytes of a blob.
+   struct Section
+   {
+      uint64_t logicalStart;
+      uint64_t length;
+   };
+
+   // Call @a function with each blob & compressed vector of the tree @a node, in the order
+   // copyTree() reaches them.
+   template <typename Function>
+   void forEachBinaryNode( const NodeImplSharedPtr &node, const Function &function )
+   {
+      switch ( node->type() )
+      {
+         case TypeStructure:
+         case TypeVector:
+         {
+            auto structure = std::static_pointer_cast<StructureNodeImpl>( node );
+
+            const int64_t cChildCount = structure->childCount();
+
+            for ( int64_t i = 0; i < cChildCount; ++i )
+            {
+               forEachBinaryNode( structure->get( i ), function );
+            }
+            break;
+         }
+
+         case TypeBlob:
+         case TypeCompressedVector:
+            function( node );
+            break;
+
+         default:
+            break;
+      }
+   }
+
+   Section binarySection( const NodeImplSharedPtr &node, CheckedFile *file )
+   {
+      if ( node->type() == TypeBlob )
+      {
+         auto blob = std::static_pointer_cast<BlobNodeImpl>( node );
+
+         return { blob->sectionLogicalStart() + sizeof( BlobSectionHeader ),
+                  static_cast<uint64_t>( blob->byteCount() ) };
+      }
+
+      auto points = std::static_pointer_cast<CompressedVectorNodeImpl>( node );
+
+      const uint64_t cStart = points->getBinarySectionLogicalStart();
+
+      // copyTo() reports this
+      if ( cStart == 0 )
+      {
+         return { 0, 0 };
+      }
+
+      CompressedVectorSectionHeader header;
+      file->readAt( cStart, reinterpret_cast<char *>( &header ), sizeof( header ) );
+
+      header.verify( file->length( CheckedFile::Physical ) );
+
+      return { cStart, header.sectionLogicalLength };
+   }
+
+   // The children of the vector @a name of @a root, if it has one
+   std::vector<NodeImplSharedPtr> vectorChildren( const std::shared_ptr<StructureNodeImpl> &root,
+                                                  const ustring &name )
+   {
+      std::vector<NodeImplSharedPtr> children;
+
+      if ( !root->isDefined( name ) )
+      {
+         return children;
+      }
+
+      NodeImplSharedPtr vector = root->get( name );
+
+      if ( vector->type() != TypeVector )
+      {
+         throw E57_EXCEPTION2( ErrorBadNodeDowncast,
+                               "pathName=" + vector->pathName() +
+                                  " type=" + toString( vector->type() ) );
+      }
+
+      auto structure = std::static_pointer_cast<StructureNodeImpl>( vector );
+
+      const int64_t cChildCount = structure->childCount();
+
+      for ( int64_t i = 0; i < cChildCount; ++i )
+      {
+         children.push_back( structure->get( i ) );
+      }
+
+      return children;
+   }
+
+   // The value of the string @a name of the structure @a node, or an empty string
+   ustring childString( const NodeImplSharedPtr &node, const ustring &name )
+   {
+      if ( ( node->type() != TypeStructure ) || !node->isDefined( name ) )
+      {
+         return {};
+      }
+
+      NodeImplSharedPtr child = std::static_pointer_cast<StructureNodeImpl>( node )->get( name );
+
+      if ( child->type() != TypeString )
+      {
+         return {};
+      }
+
+      return std::static_pointer_cast<StringNodeImpl>( child )->value();
+   }
+
+   // An input file, with the blocks of its binary sections read but not yet copied
+   struct Input
+   {
+      std::unique_ptr<ImageFile> imf;
+      std::vector<NodeImplSharedPtr> scans;
+      std::vector<NodeImplSharedPtr> images;
+      std::vector<Section> sections; // in the order they are copied
+
+      std::deque<std::vector<char>> blocks;
+
+      bool opened = false;
+      bool readAll = false;
+      std::exception_ptr error;
+   };
+
+   // Opens the input files & reads their binary sections ahead of the copy, on a pool of
+   // threads. The inputs are copied one at a time in order, and each thread reads a whole input
+   // before taking the next one, so no more than one input per thread is read ahead.
+   class InputReader
+   {
+   public:
+      InputReader( const std::vector<ustring> &paths, unsigned threadCount,
+                   uint64_t readAheadBytes );
+      ~InputReader();
+
+      InputReader( const InputReader & ) = delete;
+      InputReader &operator=( const InputReader & ) = delete;
+
+      /// Wait for input @a index (the one after the last finished) to be opened.
+      Input &open( size_t index );
+
+      /// The next section of the current input
+      const Section &nextSection();
+
+      /// Read the next @a count bytes of the sections of the current input.
+      void read( char *buffer, size_t count );
+
+      /// Close the current input & move on to the next one.
+      void finish();
+
+   private:
+      void threadLoop();
+      void readInput( size_t index );
+
+      const std::vector<ustring> &paths_;
+      std::vector<Input> inputs_;
+      const uint64_t readAheadBytes_;
+      const size_t maxInputsAhead_;
+
+      std::mutex mutex_;
+      std::condition_variable roomCondition_; // a block may be read, or an input taken
+      std::condition_variable dataCondition_; // an input was opened, or a block read
+      size_t current_ = 0;                    // input being copied
+      size_t next_ = 0;                       // next input to be taken by a thread
+      uint64_t bytesAhead_ = 0;               // read & not yet copied
+      bool stopping_ = false;
+
+      // Only used by the copying thread
+      size_t sectionIndex_ = 0;
+      std::vector<char> block_;
+      size_t blockOffset_ = 0;
+
+      std::vector<std::thread> threads_;
+   };
+
+   InputReader::InputReader( const std::vector<ustring> &paths, unsigned threadCount,
+                             uint64_t readAheadBytes ) :
+      paths_( paths ), inputs_( paths.size() ), readAheadBytes_( readAheadBytes ),
+      maxInputsAhead_( std::max( threadCount, 1u ) )
+   {
+      const size_t cThreadCount = std::min<size_t>( maxInputsAhead_, paths.size() );
+
+      for ( size_t i = 0; i < cThreadCount; ++i )
+      {
+         try
+         {
+            threads_.emplace_back( &InputReader::threadLoop, this );
+         }
+         catch ( const std::system_error & )
+         {
+            // Make do with the threads we have
+            if ( threads_.empty() )
+            {
+               throw;
+            }
+            break;
+         }
+      }
+   }
+
+   InputReader::~InputReader()
+   {
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+         stopping_ = true;
+      }
+
+      roomCondition_.notify_all();
+
+      for ( auto &thread : threads_ )
+      {
+         thread.join();
+      }
+   }
+
+   Input &InputReader::open( size_t index )
+   {
+      std::unique_lock<std::mutex> lock( mutex_ );
+
+      Input &input = inputs_[index];
+
+      dataCondition_.wait( lock, [&input] { return input.opened || input.error; } );
+
+      if ( !input.opened )
+      {
+         std::rethrow_exception( input.error );
+      }
+
+      return input;
+   }
+
+   const Section &InputReader::nextSection()
+   {
+      const Input &input = inputs_[current_];
+
+      if ( sectionIndex_ >= input.sections.size() )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "sectionIndex=" + toString( sectionIndex_ ) );
+      }
+
+      return input.sections[sectionIndex_++];
+   }
+
+   void InputReader::read( char *buffer, size_t count )
+   {
+      while ( count > 0 )
+      {
+         if ( blockOffset_ == block_.size() )
+         {
+            std::unique_lock<std::mutex> lock( mutex_ );
+
+            Input &input = inputs_[current_];
+
+            dataCondition_.wait( lock, [&input] {
+               return !input.blocks.empty() || input.error || input.readAll;
+            } );
+
+            if ( input.blocks.empty() )
+            {
+               if ( input.error )
+               {
+                  std::rethrow_exception( input.error );
+               }
+
+               // Asked for more than the sections hold
+               throw E57_EXCEPTION2( ErrorInternal, "fileName=" + paths_[current_] );
+            }
+
+            block_ = std::move( input.blocks.front() );
+            input.blocks.pop_front();
+
+            bytesAhead_ -= block_.size();
+            blockOffset_ = 0;
+
+            lock.unlock();
+            roomCondition_.notify_all();
+         }
+
+         const size_t cCount = std::min( count, block_.size() - blockOffset_ );
+
+         memcpy( buffer, block_.data() + blockOffset_, cCount );
+
+         blockOffset_ += cCount;
+         buffer += cCount;
+         count -= cCount;
+      }
+   }
+
+   void InputReader::finish()
+   {
+      std::unique_ptr<ImageFile> imf;
+
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+
+         Input &input = inputs_[current_];
+
+         for ( const auto &block : input.blocks )
+         {
+            bytesAhead_ -= block.size();
+         }
+
+         imf = std::move( input.imf );
+         input = Input();
+
+         ++current_;
+      }
+
+      roomCondition_.notify_all();
+
+      sectionIndex_ = 0;
+      block_.clear();
+      blockOffset_ = 0;
+
+      imf->close();
+   }
+
+   void InputReader::threadLoop()
+   {
+      for ( ;; )
+      {
+         size_t index = 0;
+
+         {
+            std::unique_lock<std::mutex> lock( mutex_ );
+
+            roomCondition_.wait( lock, [this] {
+               return stopping_ || ( next_ >= inputs_.size() ) ||
+                      ( next_ < current_ + maxInputsAhead_ );
+            } );
+
+            if ( stopping_ || ( next_ >= inputs_.size() ) )
+            {
+               return;
+            }
+
+            index = next_++;
+         }
+
+         try
+         {
+            readInput( index );
+         }
+         catch ( ... )
+         {
+            std::lock_guard<std::mutex> lock( mutex_ );
+            inputs_[index].error = std::current_exception();
+         }
+
+         dataCondition_.notify_all();
+      }
+   }
+
+   void InputReader::readInput( size_t index )
+   {
+      std::unique_ptr<ImageFile> imf( new ImageFile( paths_[index], "r" ) );
+
+      ImageFileImplSharedPtr source = imf->impl();
+      CheckedFile *file = source->file();
+
+      std::vector<NodeImplSharedPtr> scans = vectorChildren( source->root(), "data3D" );
+      std::vector<NodeImplSharedPtr> images = vectorChildren( source->root(), "images2D" );
+      std::vector<Section> sections;
+
+      const auto cAddSection = [&sections, file]( const NodeImplSharedPtr &node ) {
+         sections.push_back( binarySection( node, file ) );
+      };
+
+      for ( const auto &node : scans )
+      {
+         forEachBinaryNode( node, cAddSection );
+      }
+
+      for ( const auto &node : images )
+      {
+         forEachBinaryNode( node, cAddSection );
+      }
+
+      Input &input = inputs_[index];
+
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+
+         input.imf = std::move( imf );
+         input.scans = std::move( scans );
+         input.images = std::move( images );
+         input.sections = sections;
+         input.opened = true;
+      }
+
+      dataCondition_.notify_all();
+
+      for ( const auto &section : sections )
+      {
+         for ( uint64_t offset = 0; offset < section.length; )
+         {
+            const auto cCount =
+               static_cast<size_t>( std::min<uint64_t>( cBlockSize, section.length - offset ) );
+
+            {
+               std::unique_lock<std::mutex> lock( mutex_ );
+
+               // The input being copied may always have a block waiting, so it can't be held up
+               // by those read ahead of it.
+               roomCondition_.wait( lock, [&] {
+                  return stopping_ || ( bytesAhead_ + cCount <= readAheadBytes_ ) ||
+                         ( ( index == current_ ) && input.blocks.empty() );
+               } );
+
+               if ( stopping_ )
+               {
+                  return;
+               }
+
+               bytesAhead_ += cCount;
+            }
+
+            std::vector<char> block( cCount );
+            file->readAt( section.logicalStart + offset, block.data(), cCount );
+
+            {
+               std::lock_guard<std::mutex> lock( mutex_ );
+               input.blocks.push_back( std::move( block ) );
+            }
+
+            dataCondition_.notify_all();
+
+            offset += cCount;
+         }
+      }
+
+      std::lock_guard<std::mutex> lock( mutex_ );
+      input.readAll = true;
+   }
+
+   ustring unusedGuid( const std::set<ustring> &usedGuids )
+   {
+      ustring guid = generateRandomGUID();
+
+      while ( usedGuids.count( guid ) != 0 )
+      {
+         guid = generateRandomGUID();
+      }
+
+      return guid;
+   }
+
+   // Record @a guid in the originalGuids of the scan @a scan
+   void addOriginalGuid( const std::shared_ptr<StructureNodeImpl> &scan, const ustring &guid,
+                         const ImageFileImplSharedPtr &dest )
+   {
+      std::shared_ptr<VectorNodeImpl> originalGuids;
+
+      if ( scan->isDefined( "originalGuids" ) )
+      {
+         NodeImplSharedPtr node = scan->get( "originalGuids" );
+
+         if ( node->type() != TypeVector )
+         {
+            return;
+         }
+
+         originalGuids = std::static_pointer_cast<VectorNodeImpl>( node );
+      }
+      else
+      {
+         originalGuids = std::make_shared<VectorNodeImpl>( dest, false );
+         scan->set( "originalGuids", originalGuids );
+      }
+
+      originalGuids->append( std::make_shared<StringNodeImpl>( dest, guid ) );
+   }
+
+   // The guids of the scans or images @a nodes
+   void addGuids( const VectorNode &nodes, std::set<ustring> &guids )
+   {
+      const int64_t cChildCount = nodes.childCount();
+
+      for ( int64_t i = 0; i < cChildCount; ++i )
+      {
+         const ustring cGuid = childString( nodes.get( i ).impl(), "guid" );
+
+         if ( !cGuid.empty() )
+         {
+            guids.insert( cGuid );
+         }
+      }
+   }
+}
+
+namespace e57
+{
+   MergeReport mergeFiles( ImageFile &imf, VectorNode &data3D, VectorNode &images2D,
+                           const std::vector<ustring> &inputPaths, const MergeOptions &options )
+   {
+      ImageFileImplSharedPtr dest = imf.impl();
+
+      // The sections are added at the end of the file, where an open writer would be adding its
+      // own
+      if ( dest->writerCount() > 0 )
+      {
+         throw E57_EXCEPTION2( ErrorTooManyWriters,
+                               "fileName=" + dest->fileName() +
+                                  " writerCount=" + toString( dest->writerCount() ) );
+      }
+
+      MergeReport report;
+
+      if ( inputPaths.empty() )
+      {
+         return report;
+      }
+
+      std::set<ustring> usedGuids;
+      addGuids( data3D, usedGuids );
+      addGuids( images2D, usedGuids );
+
+      InputReader reader( inputPaths, resolveThreadCount( options.threadCount ),
+                          options.readAheadBytes );
+
+      for ( size_t i = 0; i < inputPaths.size(); ++i )
+      {
+         const Input &input = reader.open( i );
+
+         ImageFileImplSharedPtr source = input.imf->impl();
+
+         // New guids of the scans of this input, by their old guid
+         std::unordered_map<ustring, ustring> renamedScans;
+
+         // The scan or image being copied & its guid in this file
+         NodeImplSharedPtr top;
+         ustring topGuid;
+
+         const NodeCopier cCopier = [&]( const NodeImplSharedPtr &node ) -> NodeImplSharedPtr {
+            switch ( node->type() )
+            {
+               case TypeCompressedVector:
+               {
+                  auto points = std::static_pointer_cast<CompressedVectorNodeImpl>( node );
+
+                  const Section &section = reader.nextSection();
+
+                  if ( section.logicalStart != points->getBinarySectionLogicalStart() )
+                  {
+                     throw E57_EXCEPTION2( ErrorInternal, "pathName=" + node->pathName() );
+                  }
+
+                  report.bytesCopied += section.length;
+
+                  return points->copyTo( dest, [&reader]( char *buffer, size_t count ) {
+                     reader.read( buffer, count );
+                  } );
+               }
+
+               case TypeBlob:
+               {
+                  auto blob = std::static_pointer_cast<BlobNodeImpl>( node );
+
+                  const Section &section = reader.nextSection();
+
+                  if ( section.logicalStart !=
+                       blob->sectionLogicalStart() + sizeof( BlobSectionHeader ) )
+                  {
+                     throw E57_EXCEPTION2( ErrorInternal, "pathName=" + node->pathName() );
+                  }
+
+                  auto copy = std::make_shared<BlobNodeImpl>( dest, blob->byteCount() );
+
+                  // The copy isn't attached yet, so write its bytes directly
+                  dest->finishPacketWrites();
+                  dest->file()->seek( copy->sectionLogicalStart() + sizeof( BlobSectionHeader ) );
+
+                  std::vector<char> buffer( cBlockSize );
+
+                  for ( uint64_t copied = 0; copied < section.length; )
+                  {
+                     const auto cCount = static_cast<size_t>(
+                        std::min<uint64_t>( cBlockSize, section.length - copied ) );
+
+                     reader.read( buffer.data(), cCount );
+                     dest->file()->write( buffer.data(), cCount );
+
+                     copied += cCount;
+                  }
+
+                  report.bytesCopied += section.length;
+
+                  return copy;
+               }
+
+               case TypeString:
+               {
+                  if ( node->parent() != top )
+                  {
+                     return nullptr;
+                  }
+
+                  if ( node->elementName() == "guid" )
+                  {
+                     return std::make_shared<StringNodeImpl>( dest, topGuid );
+                  }
+
+                  if ( node->elementName() == "associatedData3DGuid" )
+                  {
+                     const auto cRenamed = renamedScans.find(
+                        std::static_pointer_cast<StringNodeImpl>( node )->value() );
+
+                     if ( cRenamed != renamedScans.end() )
+                     {
+                        return std::make_shared<StringNodeImpl>( dest, cRenamed->second );
+                     }
+                  }
+
+                  return nullptr;
+               }
+
+               default:
+                  return nullptr;
+            }
+         };
+
+         // Copy a scan or image, giving it a guid not used in this file yet
+         const auto cCopy = [&]( const NodeImplSharedPtr &node ) -> NodeImplSharedPtr {
+            const ustring cOldGuid = childString( node, "guid" );
+
+            top = node;
+            topGuid = cOldGuid;
+
+            if ( options.newGuids || cOldGuid.empty() || ( usedGuids.count( cOldGuid ) != 0 ) )
+            {
+               topGuid = unusedGuid( usedGuids );
+            }
+
+            NodeImplSharedPtr copy = copyTree( node, source, dest, cCopier );
+
+            if ( ( copy->type() == TypeStructure ) && cOldGuid.empty() )
+            {
+               std::static_pointer_cast<StructureNodeImpl>( copy )->set(
+                  "guid", std::make_shared<StringNodeImpl>( dest, topGuid ) );
+            }
+
+            usedGuids.insert( topGuid );
+
+            return copy;
+         };
+
+         for ( const auto &scan : input.scans )
+         {
+            NodeImplSharedPtr copy = cCopy( scan );
+
+            const ustring cOldGuid = childString( scan, "guid" );
+
+            if ( !cOldGuid.empty() && ( topGuid != cOldGuid ) )
+            {
+               renamedScans[cOldGuid] = topGuid;
+
+               addOriginalGuid( std::static_pointer_cast<StructureNodeImpl>( copy ), cOldGuid,
+                                dest );
+            }
+
+            data3D.impl()->append( copy );
+            ++report.data3DCount;
+         }
+
+         for ( const auto &image : input.images )
+         {
+            images2D.impl()->append( cCopy( image ) );
+            ++report.images2DCount;
+         }
+
+         reader.finish();
+      }
+
+      return report;
+   }
+}
@@ -0,0 +1,14 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "Common.h"
+#include "E57SimpleWriter.h"
+
+namespace e57
+{
+   /// Copy the scans & images of the files @a inputPaths to the end of @a data3D & @a images2D of
+   /// @a imf (see Writer::MergeFrom()).
+   MergeReport mergeFiles( ImageFile &imf, VectorNode &data3D, VectorNode &images2D,
+                           const std::vector<ustring> &inputPaths, const MergeOptions &options );
+}
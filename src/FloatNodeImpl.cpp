@@ -49,6 +49,8 @@ namespace e57
             maximum_ = FLOAT_MAX;
          }
       }
+
+      memory_.set( Memory::Nodes, sizeof( *this ) );
    }
 
    // Throw an exception if the value is not within bounds.
@@ -0,0 +1,268 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <cstring>
+
+#include "HalfFloat.h"
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define E57_HALF_X86 1
+#include <immintrin.h>
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#include <intrin.h>
+#define E57_HALF_TARGET
+#else
+#define E57_HALF_TARGET __attribute__( ( target( "avx,f16c" ) ) )
+#endif
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+#define E57_HALF_ARM 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+   using FromFloatsFunc = void ( * )( const float *, size_t, uint16_t * );
+   using ToFloatsFunc = void ( * )( const uint16_t *, size_t, float * );
+
+   inline uint32_t floatBits( float value )
+   {
+      uint32_t bits;
+      memcpy( &bits, &value, sizeof( bits ) );
+      return bits;
+   }
+
+   inline float bitsFloat( uint32_t bits )
+   {
+      float value;
+      memcpy( &value, &bits, sizeof( value ) );
+      return value;
+   }
+
+   uint16_t fromFloatScalar( float value )
+   {
+      const uint32_t cBits = floatBits( value );
+      const auto cSign = static_cast<uint16_t>( ( cBits >> 16 ) & 0x8000 );
+      const uint32_t cMagnitude = cBits & 0x7FFFFFFF;
+
+      // Infinities stay infinities, and NaNs keep the top of their payload but are made quiet
+      if ( cMagnitude >= 0x7F800000 )
+      {
+         const uint32_t cNaN = ( cMagnitude > 0x7F800000 ) ? ( 0x200 | ( cMagnitude >> 13 ) ) : 0;
+
+         return static_cast<uint16_t>( cSign | 0x7C00 | ( cNaN & 0x3FF ) );
+      }
+
+      // From halfway between the largest half & 2^16 everything rounds to infinity
+      if ( cMagnitude >= 0x477FF000 )
+      {
+         return static_cast<uint16_t>( cSign | 0x7C00 );
+      }
+
+      // Below the smallest normal half: adding 0.5 leaves the subnormal half in the low bits of
+      // the float, rounded by the addition.
+      if ( cMagnitude < 0x38800000 )
+      {
+         const float cSum = bitsFloat( cMagnitude ) + 0.5f;
+
+         return static_cast<uint16_t>( cSign | ( floatBits( cSum ) - 0x3F000000 ) );
+      }
+
+      // Rebias the exponent and round the significand to nearest even
+      const uint32_t cOdd = ( cMagnitude >> 13 ) & 1;
+      const uint32_t cRounded = cMagnitude - 0x38000000 + 0xFFF + cOdd;
+
+      return static_cast<uint16_t>( cSign | ( cRounded >> 13 ) );
+   }
+
+   float toFloatScalar( uint16_t half )
+   {
+      const uint32_t cSign = static_cast<uint32_t>( half & 0x8000 ) << 16;
+      const uint32_t cExponent = ( half >> 10 ) & 0x1F;
+      const uint32_t cSignificand = half & 0x3FF;
+
+      if ( cExponent == 0x1F )
+      {
+         // NaNs are made quiet, as by the conversion instructions
+         const uint32_t cQuiet = ( cSignificand != 0 ) ? 0x400000 : 0;
+
+         return bitsFloat( cSign | 0x7F800000 | cQuiet | ( cSignificand << 13 ) );
+      }
+
+      if ( cExponent == 0 )
+      {
+         // Zero or subnormal: the significand is in units of 2^-24, which a float holds exactly
+         const float cMagnitude = static_cast<float>( cSignificand ) * 5.9604644775390625e-8f;
+
+         return bitsFloat( cSign | floatBits( cMagnitude ) );
+      }
+
+      return bitsFloat( cSign | ( ( cExponent + 112 ) << 23 ) | ( cSignificand << 13 ) );
+   }
+
+   void fromFloatsScalar( const float *in, size_t count, uint16_t *out )
+   {
+      for ( size_t i = 0; i < count; ++i )
+      {
+         out[i] = fromFloatScalar( in[i] );
+      }
+   }
+
+   void toFloatsScalar( const uint16_t *in, size_t count, float *out )
+   {
+      for ( size_t i = 0; i < count; ++i )
+      {
+         out[i] = toFloatScalar( in[i] );
+      }
+   }
+
+#if defined( E57_HALF_X86 )
+   E57_HALF_TARGET void fromFloatsF16C( const float *in, size_t count, uint16_t *out )
+   {
+      size_t i = 0;
+
+      for ( ; i + 8 <= count; i += 8 )
+      {
+         const __m128i vHalves =
+            _mm256_cvtps_ph( _mm256_loadu_ps( in + i ), _MM_FROUND_TO_NEAREST_INT );
+
+         _mm_storeu_si128( reinterpret_cast<__m128i *>( out + i ), vHalves );
+      }
+
+      fromFloatsScalar( in + i, count - i, out + i );
+   }
+
+   E57_HALF_TARGET void toFloatsF16C( const uint16_t *in, size_t count, float *out )
+   {
+      size_t i = 0;
+
+      for ( ; i + 8 <= count; i += 8 )
+      {
+         const __m128i vHalves = _mm_loadu_si128( reinterpret_cast<const __m128i *>( in + i ) );
+
+         _mm256_storeu_ps( out + i, _mm256_cvtph_ps( vHalves ) );
+      }
+
+      toFloatsScalar( in + i, count - i, out + i );
+   }
+
+   bool detectSimd()
+   {
+#if defined( _MSC_VER ) && !defined( __clang__ )
+      int info[4];
+      __cpuid( info, 1 );
+
+      // CPUID.01H:ECX.OSXSAVE[bit 27], AVX[bit 28] & F16C[bit 29]
+      const int cOsxsaveAvxF16c = ( 1 << 27 ) | ( 1 << 28 ) | ( 1 << 29 );
+
+      if ( ( info[2] & cOsxsaveAvxF16c ) != cOsxsaveAvxF16c )
+      {
+         return false;
+      }
+
+      // The OS must save the YMM registers
+      return ( _xgetbv( 0 ) & 0x6 ) == 0x6;
+#else
+      return ( __builtin_cpu_supports( "avx" ) != 0 ) &&
+             ( __builtin_cpu_supports( "f16c" ) != 0 );
+#endif
+   }
+#endif
+
+#if defined( E57_HALF_ARM )
+   // The conversions are part of ARMv8, and round to nearest even in the default mode
+   void fromFloatsNeon( const float *in, size_t count, uint16_t *out )
+   {
+      size_t i = 0;
+
+      for ( ; i + 4 <= count; i += 4 )
+      {
+         const float16x4_t vHalves = vcvt_f16_f32( vld1q_f32( in + i ) );
+
+         vst1_u16( out + i, vreinterpret_u16_f16( vHalves ) );
+      }
+
+      fromFloatsScalar( in + i, count - i, out + i );
+   }
+
+   void toFloatsNeon( const uint16_t *in, size_t count, float *out )
+   {
+      size_t i = 0;
+
+      for ( ; i + 4 <= count; i += 4 )
+      {
+         const float16x4_t vHalves = vreinterpret_f16_u16( vld1_u16( in + i ) );
+
+         vst1q_f32( out + i, vcvt_f32_f16( vHalves ) );
+      }
+
+      toFloatsScalar( in + i, count - i, out + i );
+   }
+#endif
+
+   struct Implementation
+   {
+      bool simd;
+      FromFloatsFunc fromFloats;
+      ToFloatsFunc toFloats;
+   };
+
+   const Implementation &implementation()
+   {
+      static const Implementation sImpl = []() -> Implementation {
+#if defined( E57_HALF_X86 )
+         if ( detectSimd() )
+         {
+            return { true, fromFloatsF16C, toFloatsF16C };
+         }
+
+         return { false, fromFloatsScalar, toFloatsScalar };
+#elif defined( E57_HALF_ARM )
+         return { true, fromFloatsNeon, toFloatsNeon };
+#else
+         return { false, fromFloatsScalar, toFloatsScalar };
+#endif
+      }();
+
+      return sImpl;
+   }
+}
+
+namespace e57
+{
+   namespace HalfFloat
+   {
+      bool simdSupported()
+      {
+         return implementation().simd;
+      }
+
+      uint16_t fromFloat( float value )
+      {
+         return fromFloatScalar( value );
+      }
+
+      float toFloat( uint16_t half )
+      {
+         return toFloatScalar( half );
+      }
+
+      void fromFloats( const float *in, size_t count, uint16_t *out )
+      {
+         implementation().fromFloats( in, count, out );
+      }
+
+      void toFloats( const uint16_t *in, size_t count, float *out )
+      {
+         implementation().toFloats( in, count, out );
+      }
+
+      void fromFloatsSoftware( const float *in, size_t count, uint16_t *out )
+      {
+         fromFloatsScalar( in, count, out );
+      }
+
+      void toFloatsSoftware( const uint16_t *in, size_t count, float *out )
+      {
+         toFloatsScalar( in, count, out );
+      }
+   }
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "Common.h"
+
+namespace e57
+{
+   /// Conversions between floats and IEEE 754 half precision (binary16) floats, stored as their
+   /// bits, for ::Real16 buffers.
+   ///
+   /// Floats are rounded to the nearest half (ties to even). Values too large for a half become
+   /// infinities, and NaNs stay NaNs. When the CPU supports it (F16C on x86-64, detected at
+   /// runtime, and NEON on ARMv8) the block functions use the conversion instructions. Otherwise
+   /// they fall back to portable scalar code, with identical results.
+   namespace HalfFloat
+   {
+      /// Largest finite half
+      constexpr double cMaximum = 65504.0;
+
+      /// Returns true if a vector implementation is available and will be used.
+      bool simdSupported();
+
+      /// Convert one value.
+      uint16_t fromFloat( float value );
+      float toFloat( uint16_t half );
+
+      /// Convert @a count values from @a in to @a out.
+      void fromFloats( const float *in, size_t count, uint16_t *out );
+      void toFloats( const uint16_t *in, size_t count, float *out );
+
+      /// Same as fromFloats() & toFloats(), always using the scalar implementation.
+      void fromFloatsSoftware( const float *in, size_t count, uint16_t *out );
+      void toFloatsSoftware( const uint16_t *in, size_t count, float *out );
+   }
+}
@@ -246,9 +246,14 @@ that files that meet all of the requirements for a legal ASTM E57 file format us
 ".e57". It is recommended that files that utilize the low-level E57 element data types, but do not
 have all the required element names required by ASTM E57 file format standard use the file extension
 @c "._e57".
-@param [in] mode Either "w" for writing or "r" for reading.
+@param [in] mode Either "w" for writing, "a" for appending to an existing file or "r" for reading.
 @param [in] checksumPolicy The percentage of checksums we compute and verify as an int. Clamped to
 0-100.
+@param [in] readBackend How the file is accessed in read mode (see ReadBackend). Ignored in write
+mode.
+@param [in] fileCache How the operating system's file cache is used (see FileCacheMode).
+@param [in] xmlLoad When the nodes are built from the XML section in read mode (see XmlLoadMode).
+Ignored in write mode.
 
 @par Write Mode
 In write mode, the file cannot be already open.
@@ -261,7 +266,35 @@ API operations are legal for an ImageFile opened in write mode.
 @par Read Mode
 Read mode files may be shared.
 Write API operations are not legal for an ImageFile opened in read mode (i.e. the ImageFile is
-read-only). There is no API support for appending data onto an existing E57 data file.
+read-only).
+
+With ReadBackendMemoryMapped the whole file is mapped into memory when it is opened and pages are
+served directly from the mapping instead of issuing a seek and a read per page. This lets the OS
+handle readahead and caching. The file must not be modified while it is open.
+
+@par Append Mode
+In append mode, the file given by @a fname must be an existing E57 file. Its tree is read as in read
+mode (always in full, whatever @a xmlLoad is) and may then be changed as in write mode. The existing
+binary sections stay where they are: new ones (e.g. the points of a new Data3D) are added after the
+end of the file, followed by the new XML section when the file is closed, so the cost only depends
+on what is added. The old XML section is left unused in the file. The file header is only rewritten
+at the end of ImageFile::close, so until then the file still reads as it was when opened.
+ImageFile::cancel cuts the file back to its original length.
+
+@par File Cache
+With FileCacheBypass, reads use direct I/O where the platform and file system support it (O_DIRECT
+on Linux, F_NOCACHE on macOS), and fall back to dropping pages from the cache after reading them.
+Written pages are flushed and dropped from the cache as the file grows. This keeps a bulk ingest
+from evicting everything else from the cache, at the cost of no longer benefitting from it. It has
+no effect with ReadBackendMemoryMapped or on platforms without support for it.
+
+@par XML Loading
+With XmlLoadLazy the XML section is scanned for the children of the vectors at the top level of the
+tree which allow heterogeneous children (e.g. each entry of /data3D & /images2D), and only the
+rest of the tree is built. Each child
+is built the first time it (or any of its descendants) is accessed, after which it behaves as if
+it had been read when the file was opened. Errors in the XML of a child are reported when it is
+built. The file must stay open until they are all built.
 
 @post Resulting ImageFile is in @c open state if constructor succeeds (no exception thrown).
 
@@ -283,9 +316,9 @@ read-only). There is no API support for appending data onto an existing E57 data
 @see IntegerNode, ScaledIntegerNode, FloatNode, StringNode, BlobNode, StructureNode, VectorNode,
 CompressedVectorNode, E57Exception, E57Utilities::E57Utilities
 */
-ImageFile::ImageFile( const ustring &fname, const ustring &mode,
-                      ReadChecksumPolicy checksumPolicy ) :
-   impl_( new ImageFileImpl( checksumPolicy ) )
+ImageFile::ImageFile( const ustring &fname, const ustring &mode, ReadChecksumPolicy checksumPolicy,
+                      ReadBackend readBackend, FileCacheMode fileCache, XmlLoadMode xmlLoad ) :
+   impl_( new ImageFileImpl( checksumPolicy, readBackend, fileCache, xmlLoad ) )
 {
    // Do second phase of construction, now that ImageFile object is complete.
    impl_->construct2( fname, mode );
@@ -297,6 +330,61 @@ ImageFile::ImageFile( const char *input, const uint64_t size, ReadChecksumPolicy
    impl_->construct2( input, size );
 }
 
+/*!
+@brief Open an ASTM E57 imaging data file for reading through a ReadSource.
+
+@details The file is read with positional range reads from @a source (see ReadSource), so it
+doesn't have to be a local file. The file must not change while it is open.
+
+@param [in] source Where the file is read from.
+@param [in] checksumPolicy The percentage of checksums we compute and verify as an int. Clamped to
+0-100.
+@param [in] xmlLoad When the nodes are built from the XML section (see XmlLoadMode).
+
+@post Resulting ImageFile is in @c open state if constructor succeeds (no exception thrown).
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorSeekFailed
+@throw ::ErrorReadFailed
+@throw ::ErrorBadChecksum
+@throw ::ErrorBadFileSignature
+@throw ::ErrorUnknownFileVersion
+@throw ::ErrorBadFileLength
+@throw ::ErrorXMLParser
+@throw ::ErrorBadXMLFormat
+@throw ::ErrorInternal All objects in undocumented state
+
+@see ReadSource
+*/
+ImageFile::ImageFile( std::shared_ptr<ReadSource> source, ReadChecksumPolicy checksumPolicy,
+                      XmlLoadMode xmlLoad ) :
+   impl_( new ImageFileImpl( checksumPolicy, ReadBackendFile, FileCacheNormal, xmlLoad ) )
+{
+   impl_->construct2( std::move( source ) );
+}
+
+/*!
+@brief Create an ASTM E57 imaging data file written to a WriteSink.
+
+@details The file is written with positional writes to @a sink (see WriteSink), e.g. into memory
+with a MemoryWriteSink or straight into object storage, instead of to a local file. It is otherwise
+the same as an ImageFile opened with the "w" mode. WriteSink::finish() is called once
+ImageFile::close has written the whole file, and WriteSink::discard() if it is cancelled instead.
+
+@param [in] sink Where the file is written.
+
+@post Resulting ImageFile is in @c open state if constructor succeeds (no exception thrown).
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorInternal All objects in undocumented state
+
+@see WriteSink, MemoryWriteSink
+*/
+ImageFile::ImageFile( std::shared_ptr<WriteSink> sink ) : impl_( new ImageFileImpl( ChecksumAll ) )
+{
+   impl_->construct2( std::move( sink ) );
+}
+
 /*!
 @brief Get the pre-established root StructureNode of the E57 ImageFile.
 
@@ -337,6 +425,10 @@ function be called before the ImageFile is destroyed.
 
 It is not an error if ImageFile is already closed.
 
+If the checksums of a read mode ImageFile are verified in the background (see
+setChecksumVerification()), a failure found in the background is reported once the file has been
+closed.
+
 @post ImageFile is in @c closed state.
 
 @throw ::ErrorSeekFailed
@@ -358,8 +450,10 @@ void ImageFile::close()
 
 @details
 If the ImageFile is write mode, the associated file on the disk is closed and deleted, and the
-ImageFile goes to the closed state. If the ImageFile is read mode, the behavior is same as calling
-ImageFile::close, but no exceptions are thrown. It is not an error if ImageFile is already closed.
+ImageFile goes to the closed state. If the ImageFile is append mode, the file is closed and cut back
+to the length it had when it was opened (its header and XML section have not been changed). If the
+ImageFile is read mode, the behavior is same as calling ImageFile::close, but no exceptions are
+thrown. It is not an error if ImageFile is already closed.
 
 @post ImageFile is in @c closed state.
 
@@ -464,6 +558,169 @@ int ImageFile::readerCount() const
    return impl_->readerCount();
 }
 
+/*!
+@brief Hint that about @a byteCount more bytes will be written to a write mode ImageFile.
+
+@details
+The file system is asked to allocate the space now, so the file doesn't have to grow piece by piece
+as binary sections are written. This can be faster and reduces fragmentation, for example when the
+number of points to be written is known in advance. The length of the file is not changed.
+
+This is only a hint: it does nothing on read mode files, or on file systems and platforms which
+don't support preallocation.
+
+@param [in] byteCount Number of bytes expected to be written to the file from now on.
+
+@pre This ImageFile must be open (i.e. isOpen()).
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorInternal All objects in undocumented state
+
+@see CompressedVectorNode::writer
+*/
+void ImageFile::reserveSpace( uint64_t byteCount )
+{
+   impl_->reserveSpace( byteCount );
+}
+
+/*!
+@brief Get the counts of the pages read & written, and the time spent on checksums & parsing the XML
+section, since the ImageFile was opened.
+
+@details
+The counts are kept all the time and cost little, so they can be read at any point (e.g. to export
+them to a monitoring system). Pages read by CompressedVectorReader objects on other threads (e.g.
+by Reader::ReadData3DPointsDataParallel()) are included, and this may be called while they run.
+
+Once the ImageFile is closed, this returns the counts at the time it was closed.
+
+@post No visible state is modified.
+
+@return The counts so far.
+
+@throw No E57Exceptions.
+
+@see CompressedVectorReader::statistics, CompressedVectorWriter::statistics
+*/
+ImageFileStatistics ImageFile::statistics() const
+{
+   return impl_->statistics();
+}
+
+/*!
+@brief Set when the checksums of the pages read from a read mode ImageFile are verified.
+
+@details
+With ChecksumVerifyDeferred or ChecksumVerifyDeferredUntilClose, the pages read are handed to a
+background thread to verify, so the data can be decoded while the checksums are computed. A failure
+is reported as an ErrorBadChecksum E57Exception later: by every read of the file from then on (with
+ChecksumVerifyDeferred), by finishChecksumVerification(), and by close(). The data read before it is
+reported may be corrupt.
+
+Which pages are verified still depends on the ReadChecksumPolicy the file was opened with. The XML
+section is parsed when the file is opened, so it is always verified inline. This does nothing on
+write mode files, or with ChecksumNone. It must not be called while the file is being read (e.g. by
+a CompressedVectorReader on another thread).
+
+@param [in] verification When to verify the checksums.
+
+@pre This ImageFile must be open (i.e. isOpen()).
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorBadChecksum A failure found while verifying in the background (when changing from
+a deferred mode).
+@throw ::ErrorInternal All objects in undocumented state
+
+@see finishChecksumVerification, ReaderOptions::checksumVerification
+*/
+void ImageFile::setChecksumVerification( ChecksumVerification verification )
+{
+   impl_->setChecksumVerification( verification );
+}
+
+/*!
+@brief Wait for the background verification of the checksums of the pages read so far.
+
+@details
+This does nothing unless setChecksumVerification() chose a deferred mode.
+
+@pre This ImageFile must be open (i.e. isOpen()).
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorBadChecksum The first failure found while verifying in the background.
+@throw ::ErrorInternal All objects in undocumented state
+
+@see setChecksumVerification
+*/
+void ImageFile::finishChecksumVerification()
+{
+   impl_->finishChecksumVerification();
+}
+
+/*!
+@brief Share one packet cache between all the CompressedVectorReader objects of a read mode
+ImageFile.
+
+@details
+Each CompressedVectorReader normally keeps the packets it reads in a cache of its own (see
+PacketCacheOptions), so readers of the same points on several threads each read & verify every
+packet, and hold a copy of it. With a shared cache, the packets are kept once for the whole file
+and the readers created from then on use them (unless PacketCacheOptions::useSharedCache is false),
+which suits a server with many clients reading the same scans. The cache is split into @a shardCount
+shards by packet, each with its own lock, so readers on different threads rarely wait for each
+other.
+
+The packets are kept within @a byteBudget, evicting the least recently used ones. A packet a reader
+is using stays in memory until the reader is done with it, even once evicted. Readers which are
+already open keep the cache they were created with, so this may be called at any time, and a
+@a byteBudget of 0 removes the shared cache for the readers created afterwards. The hits, misses &
+evictions are counted in statistics(). This does nothing on write mode files.
+
+@param [in] byteBudget Maximum bytes of packets to keep, or 0 for no shared cache.
+@param [in] shardCount Number of shards the cache is split into. Must be at least 1.
+
+@pre This ImageFile must be open (i.e. isOpen()).
+
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorBadAPIArgument shardCount is 0.
+@throw ::ErrorInternal All objects in undocumented state
+
+@see PacketCacheOptions, ReaderOptions::sharedPacketCacheBytes
+*/
+void ImageFile::setSharedPacketCache( uint64_t byteBudget, unsigned shardCount )
+{
+   impl_->setSharedPacketCache( byteBudget, shardCount );
+}
+
+/*!
+@brief Verify the checksums of all the pages of an E57 file, in parallel.
+
+@details
+The whole file is read in large blocks, each thread reading the next block not yet taken, and the
+checksum of every physical page is verified. The XML section isn't parsed and nothing is decoded,
+so this runs at about the speed of the storage (or of the checksums, if that is slower). Pages whose
+checksum doesn't match are reported rather than thrown as ErrorBadChecksum.
+
+Since the header isn't checked either, this also works on files which are too damaged to be opened
+as an ImageFile.
+
+@param [in] fname The file to verify (UTF-8 encoded path).
+@param [in] options The threads & reads to use.
+
+@return The bad pages found, and the time taken.
+
+@throw ::ErrorBadAPIArgument options.blockPageCount is 0.
+@throw ::ErrorOpenFailed
+@throw ::ErrorReadFailed
+@throw ::ErrorInternal All objects in undocumented state
+
+@see ImageFileStatistics, ReadChecksumPolicy
+*/
+FileVerifyReport ImageFile::verifyFile( const ustring &fname, const FileVerifyOptions &options )
+{
+   return ImageFileImpl::verifyFile( fname, options );
+}
+
 /*!
 @brief Declare the use of an E57 extension in an ImageFile being written.
 
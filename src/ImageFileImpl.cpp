@@ -25,12 +25,19 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+
 #include "ImageFileImpl.h"
 #include "ASTMVersion.h"
 #include "CheckedFile.h"
 #include "E57XmlParser.h"
+#include "Packet.h"
+#include "Parallel.h"
+#include "SharedPacketCache.h"
+#include "Statistics.h"
 #include "StringFunctions.h"
 #include "StructureNodeImpl.h"
+#include "Tracing.h"
 
 namespace e57
 {
@@ -74,9 +81,11 @@ namespace e57
    }
 #endif
 
-   ImageFileImpl::ImageFileImpl( ReadChecksumPolicy policy ) :
+   ImageFileImpl::ImageFileImpl( ReadChecksumPolicy policy, ReadBackend readBackend,
+                                 FileCacheMode fileCache, XmlLoadMode xmlLoad ) :
       isWriter_( false ), writerCount_( 0 ), readerCount_( 0 ),
-      checksumPolicy( std::max( 0, std::min( policy, 100 ) ) ), file_( nullptr ),
+      checksumPolicy( std::max( 0, std::min( policy, 100 ) ) ), readBackend_( readBackend ),
+      fileCache_( fileCache ), xmlLoad_( xmlLoad ), file_( nullptr ),
       xmlLogicalOffset_( 0 ), xmlLogicalLength_( 0 ), unusedLogicalStart_( 0 )
    {
       // First phase of construction, can't do much until have the ImageFile object. See
@@ -96,8 +105,9 @@ namespace e57
       // Get shared_ptr to this object
       ImageFileImplSharedPtr imf = shared_from_this();
 
-      // Accept "w" or "r" modes
-      isWriter_ = ( mode == "w" );
+      // Accept "w", "a" or "r" modes
+      isAppending_ = ( mode == "a" );
+      isWriter_ = ( mode == "w" ) || isAppending_;
 
       if ( !isWriter_ && ( mode != "r" ) )
       {
@@ -106,13 +116,47 @@ namespace e57
 
       file_ = nullptr;
 
+      // Appending: read the existing tree, and add new sections & the new XML after the end of the
+      // file. The existing binary sections stay where they are.
+      if ( isAppending_ )
+      {
+         try
+         {
+            file_ = new CheckedFile( fileName_, CheckedFile::Append, checksumPolicy, fileCache_ );
+
+            std::shared_ptr<StructureNodeImpl> root( new StructureNodeImpl( imf ) );
+            root_ = root;
+            root_->setAttachedRecursive();
+
+            E57FileHeader header;
+            readFileHeader( file_, header );
+
+            xmlLogicalOffset_ = file_->physicalToLogical( header.xmlPhysicalOffset );
+            xmlLogicalLength_ = header.xmlLogicalLength;
+
+            // The whole tree is written again at close, so it can't be loaded lazily
+            parseXml();
+
+            unusedLogicalStart_ = file_->length( CheckedFile::Logical );
+         }
+         catch ( ... )
+         {
+            delete file_;
+            file_ = nullptr;
+
+            throw;
+         }
+
+         return;
+      }
+
       // Writing
       if ( isWriter_ )
       {
          try
          {
             // Open file for writing, truncate if already exists.
-            file_ = new CheckedFile( fileName_, CheckedFile::Write, checksumPolicy );
+            file_ = new CheckedFile( fileName_, CheckedFile::Write, checksumPolicy, fileCache_ );
 
             std::shared_ptr<StructureNodeImpl> root( new StructureNodeImpl( imf ) );
             root_ = root;
@@ -137,7 +181,11 @@ namespace e57
       try
       {
          // Open file for reading.
-         file_ = new CheckedFile( fileName_, CheckedFile::Read, checksumPolicy );
+         const CheckedFile::Mode readMode = ( readBackend_ == ReadBackendMemoryMapped )
+                                               ? CheckedFile::ReadMemoryMapped
+                                               : CheckedFile::Read;
+
+         file_ = new CheckedFile( fileName_, readMode, checksumPolicy, fileCache_ );
 
          std::shared_ptr<StructureNodeImpl> root( new StructureNodeImpl( imf ) );
          root_ = root;
@@ -159,18 +207,13 @@ namespace e57
 
       try
       {
-         // Create parser state, attach its event handers to the SAX2 reader
-         E57XmlParser parser( imf );
-
-         parser.init();
-
-         // Create input source (XML section of E57 file turned into a stream).
-         E57XmlFileInputSource xmlSection( file_, xmlLogicalOffset_, xmlLogicalLength_ );
-
          unusedLogicalStart_ = sizeof( E57FileHeader );
 
-         // Do the parse, building up the node tree
-         parser.parse( xmlSection );
+         // If the lazy load can't be sure of the elements to leave out, parse all of it
+         if ( ( xmlLoad_ != XmlLoadLazy ) || !parseXmlLazy() )
+         {
+            parseXml();
+         }
       }
       catch ( ... )
       {
@@ -222,18 +265,102 @@ namespace e57
 
       try
       {
-         // Create parser state, attach its event handers to the SAX2 reader
-         E57XmlParser parser( imf );
+         unusedLogicalStart_ = sizeof( E57FileHeader );
+
+         parseXml();
+      }
+      catch ( ... )
+      {
+         delete file_;
+         file_ = nullptr;
+
+         throw;
+      }
+   }
+
+   void ImageFileImpl::construct2( std::shared_ptr<WriteSink> sink )
+   {
+      // Second phase of construction, now we have a well-formed ImageFile object.
+
+      if ( !sink )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "sink=nullptr" );
+      }
+
+      // Get shared_ptr to this object
+      ImageFileImplSharedPtr imf = shared_from_this();
+
+      isWriter_ = true;
+      file_ = nullptr;
+
+      try
+      {
+         file_ = new CheckedFile( std::move( sink ) );
+
+         fileName_ = file_->fileName();
+
+         std::shared_ptr<StructureNodeImpl> root( new StructureNodeImpl( imf ) );
+         root_ = root;
+         root_->setAttachedRecursive();
+
+         unusedLogicalStart_ = sizeof( E57FileHeader );
+         xmlLogicalOffset_ = 0;
+         xmlLogicalLength_ = 0;
+      }
+      catch ( ... )
+      {
+         delete file_;
+         file_ = nullptr;
+
+         throw;
+      }
+   }
+
+   void ImageFileImpl::construct2( std::shared_ptr<ReadSource> source )
+   {
+      // Second phase of construction, now we have a well-formed ImageFile object.
+
+      unusedLogicalStart_ = sizeof( E57FileHeader );
+
+      // Get shared_ptr to this object
+      ImageFileImplSharedPtr imf = shared_from_this();
+
+      isWriter_ = false;
+      file_ = nullptr;
+
+      try
+      {
+         // Open file for reading.
+         file_ = new CheckedFile( std::move( source ), checksumPolicy );
 
-         parser.init();
+         fileName_ = file_->fileName();
 
-         // Create input source (XML section of E57 file turned into a stream).
-         E57XmlFileInputSource xmlSection( file_, xmlLogicalOffset_, xmlLogicalLength_ );
+         std::shared_ptr<StructureNodeImpl> root( new StructureNodeImpl( imf ) );
+         root_ = root;
+         root_->setAttachedRecursive();
+
+         E57FileHeader header;
+         readFileHeader( file_, header );
+
+         xmlLogicalOffset_ = file_->physicalToLogical( header.xmlPhysicalOffset );
+         xmlLogicalLength_ = header.xmlLogicalLength;
+      }
+      catch ( ... )
+      {
+         delete file_;
+         file_ = nullptr;
+
+         throw;
+      }
 
+      try
+      {
          unusedLogicalStart_ = sizeof( E57FileHeader );
 
-         // Do the parse, building up the node tree
-         parser.parse( xmlSection );
+         if ( ( xmlLoad_ != XmlLoadLazy ) || !parseXmlLazy() )
+         {
+            parseXml();
+         }
       }
       catch ( ... )
       {
@@ -244,6 +371,147 @@ namespace e57
       }
    }
 
+   void ImageFileImpl::parseXml()
+   {
+      E57_TRACE_ZONE( "ImageFileImpl::parseXml" );
+
+      ScopedTimer<std::atomic<uint64_t>> timer( xmlParseNanoseconds_ );
+
+      // Create parser state, attach its event handers to the SAX2 reader
+      E57XmlParser parser( shared_from_this() );
+
+      parser.init();
+
+      // Create input source (XML section of E57 file turned into a stream).
+      E57XmlFileInputSource xmlSection( file_, xmlLogicalOffset_, xmlLogicalLength_ );
+
+      // Do the parse, building up the node tree
+      parser.parse( xmlSection );
+   }
+
+   bool ImageFileImpl::parseXmlLazy()
+   {
+      E57_TRACE_ZONE( "ImageFileImpl::parseXmlLazy" );
+
+      ScopedTimer<std::atomic<uint64_t>> timer( xmlParseNanoseconds_ );
+
+      ustring xml( static_cast<size_t>( xmlLogicalLength_ ), '\0' );
+
+      if ( !xml.empty() )
+      {
+         file_->readAt( xmlLogicalOffset_, &xml[0], xml.size() );
+      }
+
+      std::vector<XmlLazyElement> elements;
+
+      if ( !findLazyXmlElements( xml, elements ) || elements.empty() )
+      {
+         return false;
+      }
+
+      // Parse the XML without the content of the lazy elements
+      ustring reduced;
+      reduced.reserve( xml.size() );
+
+      size_t copied = 0;
+
+      for ( const auto &element : elements )
+      {
+         reduced.append( xml, copied, static_cast<size_t>( element.contentOffset ) - copied );
+         copied = static_cast<size_t>( element.contentOffset + element.contentLength );
+      }
+
+      reduced.append( xml, copied, ustring::npos );
+
+      xml.clear();
+      xml.shrink_to_fit();
+
+      E57XmlParser parser( shared_from_this() );
+
+      parser.init();
+
+      E57XmlMemoryInputSource xmlSection( reduced );
+
+      parser.parse( xmlSection );
+
+      // Those elements were parsed as empty structures
+      for ( const auto &element : elements )
+      {
+         NodeImplSharedPtr vector = root_->get( element.vectorName );
+
+         if ( vector->type() != TypeVector )
+         {
+            throw E57_EXCEPTION2( ErrorInternal, "vectorName=" + element.vectorName );
+         }
+
+         NodeImplSharedPtr child =
+            std::static_pointer_cast<StructureNodeImpl>( vector )->get( element.childIndex );
+
+         if ( child->type() != TypeStructure )
+         {
+            throw E57_EXCEPTION2( ErrorInternal, "vectorName=" + element.vectorName +
+                                                    " childIndex=" +
+                                                    toString( element.childIndex ) );
+         }
+
+         std::static_pointer_cast<StructureNodeImpl>( child )->setLazyXml(
+            xmlLogicalOffset_ + element.contentOffset, element.contentLength );
+      }
+
+      return true;
+   }
+
+   void ImageFileImpl::parseXmlFragment( uint64_t logicalOffset, uint64_t length,
+                                         std::shared_ptr<StructureNodeImpl> target )
+   {
+      E57_TRACE_ZONE( "ImageFileImpl::parseXmlFragment" );
+
+      ScopedTimer<std::atomic<uint64_t>> timer( xmlParseNanoseconds_ );
+
+      // Wrap the content in an element declaring the namespaces of the file, so the prefixed
+      // names resolve as they did in the whole XML
+      ustring xml = "<fragment type=\"Structure\"";
+
+      bool gotDefaultNamespace = false;
+
+      for ( const auto &nameSpace : nameSpaces_ )
+      {
+         if ( nameSpace.prefix.empty() )
+         {
+            gotDefaultNamespace = true;
+            xml += " xmlns=\"";
+         }
+         else
+         {
+            xml += " xmlns:" + nameSpace.prefix + "=\"";
+         }
+
+         xml += nameSpace.uri + "\"";
+      }
+
+      if ( !gotDefaultNamespace )
+      {
+         xml += ustring( " xmlns=\"" ) + VERSION_1_0_URI + "\"";
+      }
+
+      xml += ">";
+
+      const size_t cContentStart = xml.size();
+
+      xml.resize( cContentStart + static_cast<size_t>( length ) );
+      file_->readAt( logicalOffset, &xml[cContentStart], static_cast<size_t>( length ) );
+
+      xml += "</fragment>";
+
+      E57XmlParser parser( shared_from_this(), target );
+
+      parser.init();
+
+      E57XmlMemoryInputSource xmlSection( xml );
+
+      parser.parse( xmlSection );
+   }
+
    std::shared_ptr<StructureNodeImpl> ImageFileImpl::root()
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
@@ -253,23 +521,36 @@ namespace e57
 
    void ImageFileImpl::close()
    {
+      E57_TRACE_ZONE( "ImageFileImpl::close" );
+
       // If file already closed, have nothing to do
       if ( file_ == nullptr )
       {
          return;
       }
 
+      // Readers still open mustn't go on reading ahead once the file is gone
+      finishReadAhead();
+
       if ( isWriter_ )
       {
+         finishPacketWrites();
+
          // Go to end of file, note physical position
          xmlLogicalOffset_ = unusedLogicalStart_;
          file_->seek( xmlLogicalOffset_, CheckedFile::Logical );
          uint64_t xmlPhysicalOffset = file_->position( CheckedFile::Physical );
+
+         // The XML is written in many small pieces, so collect them & write whole pages
+         file_->bufferWrites( true );
+
          *file_ << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
 
          //??? need to add name space attributes to e57Root
          root_->writeXml( shared_from_this(), *file_, 0, "e57Root" );
 
+         file_->bufferWrites( false );
+
          // Pad XML section so length is multiple of 4
          while ( ( file_->position( CheckedFile::Logical ) - xmlLogicalOffset_ ) % 4 != 0 )
          {
@@ -301,8 +582,35 @@ namespace e57
          file_->close();
       }
 
+      // Report a checksum failure found in the background (see ChecksumVerification) once the
+      // file is closed
+      std::exception_ptr verifyError;
+
+      try
+      {
+         file_->finishVerification();
+      }
+      catch ( ... )
+      {
+         verifyError = std::current_exception();
+      }
+
+      saveFileStatistics();
+
+      // Free the shared packets (open readers keep theirs until they are closed)
+      {
+         std::lock_guard<std::mutex> guard( sharedPacketCacheMutex_ );
+
+         sharedPacketCache_.reset();
+      }
+
       delete file_;
       file_ = nullptr;
+
+      if ( verifyError )
+      {
+         std::rethrow_exception( verifyError );
+      }
    }
 
    void ImageFileImpl::cancel()
@@ -313,17 +621,45 @@ namespace e57
          return;
       }
 
+      finishReadAhead();
+
       // Close the file and ulink (delete) it.
       // It is legal to cancel a read file, but file isn't deleted.
+      // An appended file is cut back to what it was when opened.
       if ( isWriter_ )
       {
-         file_->unlink();
+         // The writes are thrown away, but they must not use the file once it's gone
+         try
+         {
+            finishPacketWrites();
+         }
+         catch ( ... )
+         {
+         }
+
+         if ( isAppending_ )
+         {
+            file_->discardAppended();
+         }
+         else
+         {
+            file_->unlink();
+         }
       }
       else
       {
          file_->close();
       }
 
+      saveFileStatistics();
+
+      // Free the shared packets (open readers keep theirs until they are closed)
+      {
+         std::lock_guard<std::mutex> guard( sharedPacketCacheMutex_ );
+
+         sharedPacketCache_.reset();
+      }
+
       delete file_;
       file_ = nullptr;
    }
@@ -343,6 +679,16 @@ namespace e57
       return writerCount_;
    }
 
+   int ImageFileImpl::concurrentWriterCount() const
+   {
+      return concurrentWriterCount_;
+   }
+
+   std::mutex &ImageFileImpl::concurrentWriteMutex()
+   {
+      return concurrentWriteMutex_;
+   }
+
    int ImageFileImpl::readerCount() const
    {
       return readerCount_;
@@ -377,17 +723,225 @@ namespace e57
       // zeros here.
       if ( doExtendNow )
       {
+         finishPacketWrites();
+
          file_->extend( unusedLogicalStart_ );
       }
 
       return oldLogicalStart;
    }
 
+   ImageFileStatistics ImageFileImpl::statistics() const
+   {
+      ImageFileStatistics statistics = fileStatistics_;
+
+      if ( file_ != nullptr )
+      {
+         const auto &cCounters = file_->counters();
+
+         statistics.pagesRead = cCounters.pagesRead.load( std::memory_order_relaxed );
+         statistics.pagesWritten = cCounters.pagesWritten.load( std::memory_order_relaxed );
+         statistics.checksumsVerified =
+            cCounters.checksumsVerified.load( std::memory_order_relaxed );
+         statistics.checksumSeconds =
+            nanosecondsToSeconds( cCounters.checksumNanoseconds.load( std::memory_order_relaxed ) );
+      }
+
+      statistics.xmlParseSeconds =
+         nanosecondsToSeconds( xmlParseNanoseconds_.load( std::memory_order_relaxed ) );
+
+      if ( const auto cShared = sharedPacketCache() )
+      {
+         statistics.sharedCacheHits = cShared->hitCount();
+         statistics.sharedCacheMisses = cShared->missCount();
+         statistics.sharedCacheEvictions = cShared->evictionCount();
+         statistics.sharedCacheBytes = cShared->byteCount();
+      }
+
+      return statistics;
+   }
+
+   void ImageFileImpl::saveFileStatistics()
+   {
+      fileStatistics_ = statistics();
+   }
+
+   void ImageFileImpl::reserveSpace( uint64_t byteCount )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( !isWriter_ )
+      {
+         return;
+      }
+
+      finishPacketWrites();
+
+      file_->reserve( unusedLogicalStart_ + byteCount );
+   }
+
+   void ImageFileImpl::setChecksumVerification( ChecksumVerification verification )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      file_->setChecksumVerification( verification );
+   }
+
+   void ImageFileImpl::finishChecksumVerification()
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      file_->finishVerification();
+   }
+
+   void ImageFileImpl::setSharedPacketCache( uint64_t byteBudget, unsigned shardCount )
+   {
+      checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+      if ( shardCount == 0 )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "shardCount=0 fileName=" + fileName_ );
+      }
+
+      // Packets are only read from read mode files
+      if ( isWriter_ )
+      {
+         return;
+      }
+
+      std::shared_ptr<SharedPacketCache> cache;
+
+      if ( byteBudget > 0 )
+      {
+         cache = std::make_shared<SharedPacketCache>( byteBudget, shardCount );
+      }
+
+      std::lock_guard<std::mutex> guard( sharedPacketCacheMutex_ );
+
+      sharedPacketCache_ = std::move( cache );
+   }
+
+   std::shared_ptr<SharedPacketCache> ImageFileImpl::sharedPacketCache() const
+   {
+      std::lock_guard<std::mutex> guard( sharedPacketCacheMutex_ );
+
+      return sharedPacketCache_;
+   }
+
+   FileVerifyReport ImageFileImpl::verifyFile( const ustring &fileName,
+                                               const FileVerifyOptions &options )
+   {
+      if ( options.blockPageCount == 0 )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "blockPageCount=0 fileName=" + fileName );
+      }
+
+      const auto cStart = std::chrono::steady_clock::now();
+
+      CheckedFile file( fileName, CheckedFile::Read, ChecksumPolicy::ChecksumNone,
+                        options.fileCache );
+
+      const uint64_t cLength = file.length( CheckedFile::Physical );
+
+      FileVerifyReport report;
+      report.pageCount = cLength / CheckedFile::physicalPageSize;
+      report.partialLastPage = ( cLength % CheckedFile::physicalPageSize ) != 0;
+
+      const size_t cBlockPages = options.blockPageCount;
+      const uint64_t cBlockCount = ( report.pageCount + cBlockPages - 1 ) / cBlockPages;
+      const auto cTaskCount = static_cast<size_t>(
+         std::min<uint64_t>( resolveThreadCount( options.threadCount ), cBlockCount ) );
+
+      // Each task takes the next block until there are none left, keeping its own bad pages
+      std::atomic<uint64_t> nextBlock( 0 );
+      std::vector<std::vector<uint64_t>> badPages( cTaskCount );
+      std::vector<Task> tasks;
+
+      for ( size_t t = 0; t < cTaskCount; ++t )
+      {
+         tasks.emplace_back( [&, t]() {
+            std::vector<char> buffer( cBlockPages * CheckedFile::physicalPageSize );
+
+            for ( uint64_t block = nextBlock++; block < cBlockCount; block = nextBlock++ )
+            {
+               const uint64_t cFirstPage = block * cBlockPages;
+               const auto cPageCount = static_cast<size_t>(
+                  std::min<uint64_t>( cBlockPages, report.pageCount - cFirstPage ) );
+
+               file.checkPages( cFirstPage, cPageCount, buffer.data(), badPages[t] );
+            }
+         } );
+      }
+
+      runTasks( tasks, static_cast<unsigned>( cTaskCount ), options.executor );
+
+      for ( const auto &taskBadPages : badPages )
+      {
+         report.badPages.insert( report.badPages.end(), taskBadPages.begin(),
+                                 taskBadPages.end() );
+      }
+
+      std::sort( report.badPages.begin(), report.badPages.end() );
+
+      file.close();
+
+      report.seconds =
+         std::chrono::duration<double>( std::chrono::steady_clock::now() - cStart ).count();
+
+      if ( report.seconds > 0.0 )
+      {
+         report.bytesPerSecond =
+            static_cast<double>( report.pageCount * CheckedFile::physicalPageSize ) /
+            report.seconds;
+      }
+
+      return report;
+   }
+
    CheckedFile *ImageFileImpl::file() const
    {
       return file_;
    }
 
+   void ImageFileImpl::setPacketWriteQueue( PacketWriteQueue *queue )
+   {
+      packetWriteQueue_ = queue;
+   }
+
+   void ImageFileImpl::finishPacketWrites()
+   {
+      if ( packetWriteQueue_ != nullptr )
+      {
+         packetWriteQueue_->finish();
+      }
+   }
+
+   void ImageFileImpl::addReadAheadCache( PacketReadCache *cache )
+   {
+      std::lock_guard<std::mutex> guard( readAheadCachesMutex_ );
+
+      readAheadCaches_.push_back( cache );
+   }
+
+   void ImageFileImpl::removeReadAheadCache( PacketReadCache *cache )
+   {
+      std::lock_guard<std::mutex> guard( readAheadCachesMutex_ );
+
+      auto removed = std::remove( readAheadCaches_.begin(), readAheadCaches_.end(), cache );
+
+      readAheadCaches_.erase( removed, readAheadCaches_.end() );
+   }
+
+   void ImageFileImpl::finishReadAhead()
+   {
+      std::lock_guard<std::mutex> guard( readAheadCachesMutex_ );
+
+      for ( PacketReadCache *cache : readAheadCaches_ )
+      {
+         cache->finishReadAhead();
+      }
+   }
+
    ustring ImageFileImpl::fileName() const
    {
       // don't checkImageFileOpen, since need to get fileName to report not open
@@ -662,21 +1216,42 @@ namespace e57
 #endif
    }
 
-   void ImageFileImpl::incrWriterCount()
+   void ImageFileImpl::setBlobWriterOpen( bool isOpen )
    {
+      isBlobWriterOpen_ = isOpen;
+   }
+
+   bool ImageFileImpl::isBlobWriterOpen() const
+   {
+      return isBlobWriterOpen_;
+   }
+
+   void ImageFileImpl::incrWriterCount( bool concurrent )
+   {
+      if ( concurrent )
+      {
+         concurrentWriterCount_++;
+      }
+
       writerCount_++;
    }
 
-   void ImageFileImpl::decrWriterCount()
+   void ImageFileImpl::decrWriterCount( bool concurrent )
    {
+      if ( concurrent )
+      {
+         concurrentWriterCount_--;
+      }
+
       writerCount_--;
 
 #if ( E57_VALIDATION_LEVEL == VALIDATION_DEEP )
       if ( writerCount_ < 0 )
       {
-         throw E57_EXCEPTION2( ErrorInternal, "fileName=" + fileName_ +
-                                                 " writerCount=" + toString( writerCount_ ) +
-                                                 " readerCount=" + toString( readerCount_ ) );
+         throw E57_EXCEPTION2( ErrorInternal,
+                               "fileName=" + fileName_ +
+                                  " writerCount=" + toString( writerCount_.load() ) +
+                                  " readerCount=" + toString( readerCount_.load() ) );
       }
 #endif
    }
@@ -693,9 +1268,10 @@ namespace e57
 #if ( E57_VALIDATION_LEVEL == VALIDATION_DEEP )
       if ( readerCount_ < 0 )
       {
-         throw E57_EXCEPTION2( ErrorInternal, "fileName=" + fileName_ +
-                                                 " writerCount=" + toString( writerCount_ ) +
-                                                 " readerCount=" + toString( readerCount_ ) );
+         throw E57_EXCEPTION2( ErrorInternal,
+                               "fileName=" + fileName_ +
+                                  " writerCount=" + toString( writerCount_.load() ) +
+                                  " readerCount=" + toString( readerCount_.load() ) );
       }
 #endif
    }
@@ -866,7 +1442,7 @@ namespace e57
    {
       // no checkImageFileOpen(__FILE__, __LINE__, __FUNCTION__)
       os << space( indent ) << "fileName:    " << fileName_ << std::endl;
-      os << space( indent ) << "writerCount: " << writerCount_ << std::endl;
+      os << space( indent ) << "writerCount: " << writerCount_.load() << std::endl;
       os << space( indent ) << "readerCount: " << readerCount_ << std::endl;
       os << space( indent ) << "isWriter:    " << isWriter_ << std::endl;
       for ( size_t i = 0; i < extensionsCount(); i++ )
@@ -885,7 +1461,7 @@ namespace e57
       static_assert( sizeof( E57FileHeader ) == 48, "Unexpected size of E57FileHeader" );
 
       // Fetch the file header
-      file->read( reinterpret_cast<char *>( &header ), sizeof( header ) );
+      file->readAt( 0, reinterpret_cast<char *>( &header ), sizeof( header ) );
 
 #ifdef E57_VERBOSE
       header.dump();
@@ -27,13 +27,18 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 
 #include "Common.h"
 
 namespace e57
 {
    class CheckedFile;
+   class PacketReadCache;
+   class PacketWriteQueue;
+   class SharedPacketCache;
 
    struct E57FileHeader;
    struct NameSpace;
@@ -41,10 +46,15 @@ namespace e57
    class ImageFileImpl : public std::enable_shared_from_this<ImageFileImpl>
    {
    public:
-      explicit ImageFileImpl( ReadChecksumPolicy policy );
+      explicit ImageFileImpl( ReadChecksumPolicy policy,
+                              ReadBackend readBackend = ReadBackendFile,
+                              FileCacheMode fileCache = FileCacheNormal,
+                              XmlLoadMode xmlLoad = XmlLoadFull );
 
       void construct2( const ustring &fileName, const ustring &mode );
       void construct2( const char *input, uint64_t size );
+      void construct2( std::shared_ptr<ReadSource> source );
+      void construct2( std::shared_ptr<WriteSink> sink );
 
       std::shared_ptr<StructureNodeImpl> root();
 
@@ -57,9 +67,39 @@ namespace e57
       ~ImageFileImpl();
 
       uint64_t allocateSpace( uint64_t byteCount, bool doExtendNow );
+      void reserveSpace( uint64_t byteCount );
+      ImageFileStatistics statistics() const;
+      void setChecksumVerification( ChecksumVerification verification );
+      void finishChecksumVerification();
       CheckedFile *file() const;
+
+      /// The packet cache shared by the readers of the file (nullptr if there is none). Readers
+      /// keep the one they were created with, so it may be replaced at any time.
+      void setSharedPacketCache( uint64_t byteBudget, unsigned shardCount );
+      std::shared_ptr<SharedPacketCache> sharedPacketCache() const;
+
+      /// The open CompressedVectorWriter may write its packets on a background thread. Anything
+      /// else which writes to the file must call finishPacketWrites() first.
+      void setPacketWriteQueue( PacketWriteQueue *queue );
+      void finishPacketWrites();
+
+      /// The open readers may read ahead on background threads between their reads. They add
+      /// their caches here, so the file can be closed once finishReadAhead() has stopped them.
+      void addReadAheadCache( PacketReadCache *cache );
+      void removeReadAheadCache( PacketReadCache *cache );
+      void finishReadAhead();
       ustring fileName() const;
 
+      /// An open BlobWriter adds its bytes at the end of the file, so no other space can be
+      /// allocated until it is closed.
+      void setBlobWriterOpen( bool isOpen );
+      bool isBlobWriterOpen() const;
+
+      /// Parse the XML at [logicalOffset, logicalOffset + length), the content of a Structure
+      /// element, adding the nodes to @a target.
+      void parseXmlFragment( uint64_t logicalOffset, uint64_t length,
+                             std::shared_ptr<StructureNodeImpl> target );
+
       /// Manipulate registered extensions in the file
       void extensionsAdd( const ustring &prefix, const ustring &uri );
       bool extensionsLookupPrefix( const ustring &prefix, ustring &uri ) const;
@@ -77,8 +117,13 @@ namespace e57
       void pathNameCheckWellFormed( const ustring &pathName );
       void pathNameParse( const ustring &pathName, bool &isRelative, StringList &fields );
 
-      void incrWriterCount();
-      void decrWriterCount();
+      void incrWriterCount( bool concurrent = false );
+      void decrWriterCount( bool concurrent = false );
+      int concurrentWriterCount() const;
+
+      /// Held by concurrent writers (see CompressedVectorWriterOptions::concurrent) while they add
+      /// their sections at the end of the file
+      std::mutex &concurrentWriteMutex();
       void incrReaderCount();
       void decrReaderCount();
 
@@ -89,6 +134,9 @@ namespace e57
 
       static unsigned bitsNeeded( int64_t minimum, int64_t maximum );
 
+      static FileVerifyReport verifyFile( const ustring &fileName,
+                                          const FileVerifyOptions &options );
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout ) const;
 #endif
@@ -101,18 +149,49 @@ namespace e57
 
       static void readFileHeader( CheckedFile *file, E57FileHeader &header );
 
+      void parseXml();
+      bool parseXmlLazy();
+      void saveFileStatistics();
+
       void checkImageFileOpen( const char *srcFileName, int srcLineNumber,
                                const char *srcFunctionName ) const;
 
       ustring fileName_;
       bool isWriter_;
-      int writerCount_;
-      int readerCount_;
+      bool isAppending_ = false;
+      std::atomic<int> writerCount_;
+      std::atomic<int> concurrentWriterCount_{ 0 };
+      std::mutex concurrentWriteMutex_;
+      bool isBlobWriterOpen_ = false;
+
+      // Readers may be created & destroyed from several threads
+      std::atomic<int> readerCount_;
 
       ReadChecksumPolicy checksumPolicy;
+      ReadBackend readBackend_;
+      FileCacheMode fileCache_;
+      XmlLoadMode xmlLoad_;
 
       CheckedFile *file_;
 
+      // Time spent parsing the XML, which may be read by other threads
+      std::atomic<uint64_t> xmlParseNanoseconds_{ 0 };
+
+      // The counts of the file when it was closed
+      ImageFileStatistics fileStatistics_;
+
+      // Readers on other threads take the shared packet cache while it may be replaced
+      mutable std::mutex sharedPacketCacheMutex_;
+      std::shared_ptr<SharedPacketCache> sharedPacketCache_;
+
+      // Background packet writes of the open CompressedVectorWriter, if any
+      PacketWriteQueue *packetWriteQueue_ = nullptr;
+
+      // Caches of the open readers which read ahead in the background. Readers are created &
+      // destroyed from several threads.
+      std::mutex readAheadCachesMutex_;
+      std::vector<PacketReadCache *> readAheadCaches_;
+
       // Read file attributes
       uint64_t xmlLogicalOffset_;
       uint64_t xmlLogicalLength_;
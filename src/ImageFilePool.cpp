@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: BSL-1.0
+
+/// @file ImageFilePool.cpp
+
+#include "ImageFilePoolImpl.h"
+
+using namespace e57;
+
+/*!
+@class e57::ImageFilePool
+@brief A thread-safe cache of ImageFile objects opened for reading.
+
+@details
+Opening an ImageFile reads and checks the file header and parses the whole XML section into a node
+tree, which takes a while for large files. A pool keeps the most recently used files open and hands
+out copies of the same handle to every caller asking for a file which hasn't changed on disk since
+it was opened. A file is identified by its name, the read options, and the modification time and
+size of the file, so a handle is never used after the file is replaced.
+
+The handles are shared, so they must not be closed by the callers. Any number of threads may read
+with a shared handle at once, as long as each one uses its own CompressedVectorReader objects. When
+more files are in use than the capacity of the pool, the least recently used one is dropped from the
+pool, and is closed once nothing uses it any more.
+
+@see ImageFile
+*/
+
+/*!
+@brief Create an empty pool.
+
+@param [in] capacity The number of files to keep open. With 0, every call to open() opens the file.
+*/
+ImageFilePool::ImageFilePool( size_t capacity ) :
+   impl_( std::make_shared<ImageFilePoolImpl>( capacity ) )
+{
+}
+
+/*!
+@brief Get the pool shared by the whole process.
+
+@details
+It keeps up to 16 files open.
+*/
+ImageFilePool &ImageFilePool::global()
+{
+   static ImageFilePool sPool;
+
+   return sPool;
+}
+
+/*!
+@brief Get a read-only handle to a file, opening it if it isn't in the pool.
+
+@param [in] fname The name of the file to read.
+@param [in] checksumPolicy The checksum policy to use with the file.
+@param [in] readBackend How the file's pages are read.
+
+@details
+The file is opened with ImageFile( fname, "r", checksumPolicy, readBackend ) if it isn't in the
+pool, or if it has changed on disk since it was opened.
+
+@return A handle to the file, shared with the other callers.
+
+@throw ::ErrorOpenFailed   The file doesn't exist or can't be opened.
+@throw Any of the exceptions from ImageFile::ImageFile( const ustring &, const ustring &,
+ReadChecksumPolicy, ReadBackend, FileCacheMode, XmlLoadMode ).
+*/
+ImageFile ImageFilePool::open( const ustring &fname, ReadChecksumPolicy checksumPolicy,
+                               ReadBackend readBackend )
+{
+   return impl_->open( fname, checksumPolicy, readBackend );
+}
+
+/*!
+@brief Drop all the handles to a file from the pool, e.g. before deleting it.
+
+@details
+Handles already given out stay usable.
+*/
+void ImageFilePool::remove( const ustring &fname )
+{
+   impl_->remove( fname );
+}
+
+/*!
+@brief Drop all the handles in the pool.
+
+@details
+Handles already given out stay usable.
+*/
+void ImageFilePool::clear()
+{
+   impl_->clear();
+}
+
+/*!
+@brief Get the number of files kept open by the pool.
+*/
+size_t ImageFilePool::size() const
+{
+   return impl_->size();
+}
+
+/*!
+@brief Get the number of files the pool keeps open at most.
+*/
+size_t ImageFilePool::capacity() const
+{
+   return impl_->capacity();
+}
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#if defined( _MSC_VER )
+#include <codecvt>
+#include <locale>
+#endif
+
+#include <cerrno>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "ImageFilePoolImpl.h"
+#include "StringFunctions.h"
+
+namespace e57
+{
+   ImageFilePoolImpl::ImageFilePoolImpl( size_t capacity ) : capacity_( capacity )
+   {
+   }
+
+   ImageFile ImageFilePoolImpl::open( const ustring &fileName, ReadChecksumPolicy checksumPolicy,
+                                      ReadBackend readBackend )
+   {
+      const FileStamp cStamp = fileStamp( fileName );
+      const ustring cKey = makeKey( fileName, checksumPolicy, readBackend );
+
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+
+         auto found = index_.find( cKey );
+
+         if ( found != index_.end() )
+         {
+            const Entry &entry = *found->second;
+
+            if ( ( entry.stamp == cStamp ) && entry.imageFile.isOpen() )
+            {
+               entries_.splice( entries_.begin(), entries_, found->second );
+
+               return entry.imageFile;
+            }
+
+            // The file has changed (or the handle was closed), so it has to be opened again
+            entries_.erase( found->second );
+            index_.erase( found );
+         }
+      }
+
+      // Open without holding the lock, so other files can be handed out in the meantime. The
+      // handles in use keep the whole tree, so concurrent reads don't change it.
+      ImageFile imageFile( fileName, "r", checksumPolicy, readBackend, FileCacheNormal,
+                           XmlLoadFull );
+
+      if ( capacity_ == 0 )
+      {
+         return imageFile;
+      }
+
+      std::lock_guard<std::mutex> lock( mutex_ );
+
+      // Another thread may have opened it too. Keep the newest one.
+      auto found = index_.find( cKey );
+
+      if ( found != index_.end() )
+      {
+         entries_.erase( found->second );
+         index_.erase( found );
+      }
+
+      entries_.push_front( Entry{ cKey, fileName, cStamp, imageFile } );
+      index_[cKey] = entries_.begin();
+
+      // The handles dropped stay open until the last copy in use goes away
+      while ( entries_.size() > capacity_ )
+      {
+         index_.erase( entries_.back().key );
+         entries_.pop_back();
+      }
+
+      return imageFile;
+   }
+
+   void ImageFilePoolImpl::remove( const ustring &fileName )
+   {
+      std::lock_guard<std::mutex> lock( mutex_ );
+
+      for ( auto entry = entries_.begin(); entry != entries_.end(); )
+      {
+         if ( entry->fileName == fileName )
+         {
+            index_.erase( entry->key );
+            entry = entries_.erase( entry );
+         }
+         else
+         {
+            ++entry;
+         }
+      }
+   }
+
+   void ImageFilePoolImpl::clear()
+   {
+      std::lock_guard<std::mutex> lock( mutex_ );
+
+      index_.clear();
+      entries_.clear();
+   }
+
+   size_t ImageFilePoolImpl::size() const
+   {
+      std::lock_guard<std::mutex> lock( mutex_ );
+
+      return entries_.size();
+   }
+
+   size_t ImageFilePoolImpl::capacity() const
+   {
+      return capacity_;
+   }
+
+   FileStamp ImageFilePoolImpl::fileStamp( const ustring &fileName )
+   {
+      FileStamp stamp;
+
+#if defined( _MSC_VER )
+      // Handle UTF-8 file names - Windows requires conversion to UTF-16
+      std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+      const std::wstring widePath = converter.from_bytes( fileName );
+
+      struct _stat64 info;
+      const int result = _wstat64( widePath.c_str(), &info );
+#else
+      struct stat info;
+      const int result = ::stat( fileName.c_str(), &info );
+#endif
+
+      if ( result != 0 )
+      {
+         throw E57_EXCEPTION2( ErrorOpenFailed,
+                               "errno=" + toString( errno ) + " fileName=" + fileName );
+      }
+
+      stamp.modifiedNanoseconds = static_cast<int64_t>( info.st_mtime ) * 1000000000;
+      stamp.size = static_cast<int64_t>( info.st_size );
+
+#if defined( __linux__ )
+      stamp.modifiedNanoseconds += static_cast<int64_t>( info.st_mtim.tv_nsec );
+#elif defined( __APPLE__ )
+      stamp.modifiedNanoseconds += static_cast<int64_t>( info.st_mtimespec.tv_nsec );
+#endif
+
+      return stamp;
+   }
+
+   ustring ImageFilePoolImpl::makeKey( const ustring &fileName, ReadChecksumPolicy checksumPolicy,
+                                       ReadBackend readBackend )
+   {
+      return toString( checksumPolicy ) + ":" + toString( static_cast<int>( readBackend ) ) + ":" +
+             fileName;
+   }
+}
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include "Common.h"
+
+namespace e57
+{
+   /// Identifies a version of a file on disk, so a pooled handle isn't used after the file has
+   /// been replaced.
+   struct FileStamp
+   {
+      int64_t modifiedNanoseconds = 0;
+      int64_t size = 0;
+
+      bool operator==( const FileStamp &rhs ) const
+      {
+         return ( modifiedNanoseconds == rhs.modifiedNanoseconds ) && ( size == rhs.size );
+      }
+   };
+
+   /// Keeps the most recently used read-only ImageFiles open, so they can be handed out again
+   /// without reading the header and the XML. All the members may be called from any thread.
+   class ImageFilePoolImpl
+   {
+   public:
+      explicit ImageFilePoolImpl( size_t capacity );
+
+      ImageFilePoolImpl( const ImageFilePoolImpl & ) = delete;
+      ImageFilePoolImpl &operator=( const ImageFilePoolImpl & ) = delete;
+
+      ImageFile open( const ustring &fileName, ReadChecksumPolicy checksumPolicy,
+                      ReadBackend readBackend );
+      void remove( const ustring &fileName );
+      void clear();
+      size_t size() const;
+      size_t capacity() const;
+
+      static FileStamp fileStamp( const ustring &fileName );
+
+   private:
+      struct Entry
+      {
+         ustring key;
+         ustring fileName;
+         FileStamp stamp;
+         ImageFile imageFile;
+      };
+
+      static ustring makeKey( const ustring &fileName, ReadChecksumPolicy checksumPolicy,
+                              ReadBackend readBackend );
+
+      const size_t capacity_;
+
+      mutable std::mutex mutex_;
+
+      // Most recently used first
+      std::list<Entry> entries_;
+      std::unordered_map<ustring, std::list<Entry>::iterator> index_;
+   };
+}
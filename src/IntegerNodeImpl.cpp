@@ -35,6 +35,7 @@ namespace e57
                                      int64_t minimum, int64_t maximum ) :
       NodeImpl( destImageFile ), value_( value ), minimum_( minimum ), maximum_( maximum )
    {
+      memory_.set( Memory::Nodes, sizeof( *this ) );
    }
 
    // Throw an exception if the value is not within bounds.
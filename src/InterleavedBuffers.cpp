@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Common.h"
+#include "InterleavedBuffers.h"
+#include "StringFunctions.h"
+
+namespace e57
+{
+   namespace
+   {
+      template <typename T>
+      SourceDestBuffer fieldBuffer( const ImageFile &imf, const Data3DPointsInterleaved::Field &field,
+                                    size_t count, bool doScaling, size_t stride )
+      {
+         return { imf, field.pathName, static_cast<T *>( field.first ), count, true, doScaling,
+                  stride };
+      }
+   }
+
+   std::vector<SourceDestBuffer> interleavedBuffers( const ImageFile &imf,
+                                                     const StructureNode &proto,
+                                                     const Data3DPointsInterleaved &buffers,
+                                                     size_t count )
+   {
+      std::vector<SourceDestBuffer> sdBuffers;
+      sdBuffers.reserve( buffers.fields.size() );
+
+      for ( const auto &field : buffers.fields )
+      {
+         if ( field.first == nullptr )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument, "pathName=" + field.pathName );
+         }
+
+         // Fields of extensions the file doesn't declare can't be in the prototype
+         const size_t cColon = field.pathName.find( ':' );
+
+         if ( ( cColon != ustring::npos ) &&
+              !imf.extensionsLookupPrefix( field.pathName.substr( 0, cColon ) ) )
+         {
+            continue;
+         }
+
+         if ( !proto.isDefined( field.pathName ) )
+         {
+            continue;
+         }
+
+         const bool cScaled =
+            field.scaled && ( proto.get( field.pathName ).type() == TypeScaledInteger );
+         const size_t cStride = ( field.stride != 0 ) ? field.stride : buffers.stride;
+
+         switch ( field.representation )
+         {
+            case Int8:
+               sdBuffers.push_back( fieldBuffer<int8_t>( imf, field, count, cScaled, cStride ) );
+               break;
+            case UInt8:
+               sdBuffers.push_back( fieldBuffer<uint8_t>( imf, field, count, cScaled, cStride ) );
+               break;
+            case Int16:
+               sdBuffers.push_back( fieldBuffer<int16_t>( imf, field, count, cScaled, cStride ) );
+               break;
+            case UInt16:
+               sdBuffers.push_back( fieldBuffer<uint16_t>( imf, field, count, cScaled, cStride ) );
+               break;
+            case Int32:
+               sdBuffers.push_back( fieldBuffer<int32_t>( imf, field, count, cScaled, cStride ) );
+               break;
+            case UInt32:
+               sdBuffers.push_back( fieldBuffer<uint32_t>( imf, field, count, cScaled, cStride ) );
+               break;
+            case Int64:
+               sdBuffers.push_back( fieldBuffer<int64_t>( imf, field, count, cScaled, cStride ) );
+               break;
+            case Bool:
+               sdBuffers.push_back( fieldBuffer<bool>( imf, field, count, cScaled, cStride ) );
+               break;
+            case Real16:
+               sdBuffers.push_back( fieldBuffer<Float16>( imf, field, count, cScaled, cStride ) );
+               break;
+            case Real32:
+               sdBuffers.push_back( fieldBuffer<float>( imf, field, count, cScaled, cStride ) );
+               break;
+            case Real64:
+               sdBuffers.push_back( fieldBuffer<double>( imf, field, count, cScaled, cStride ) );
+               break;
+            default:
+               throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                     "pathName=" + field.pathName + " representation=" +
+                                        toString( field.representation ) );
+         }
+      }
+
+      return sdBuffers;
+   }
+}
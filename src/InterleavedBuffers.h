@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "E57SimpleData.h"
+
+namespace e57
+{
+   /// Set up a buffer of @a count records for each field of @a buffers which is in @a proto, in
+   /// the order of the fields. Scaled integer fields are scaled.
+   std::vector<SourceDestBuffer> interleavedBuffers( const ImageFile &imf,
+                                                     const StructureNode &proto,
+                                                     const Data3DPointsInterleaved &buffers,
+                                                     size_t count );
+}
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+
+#include "LevelOfDetail.h"
+
+namespace e57
+{
+   namespace LevelOfDetail
+   {
+      namespace
+      {
+         using PointOrdering::PointKey;
+
+         // Morton key of the cell at @a level holding the point with key @a key
+         uint64_t cellAt( uint64_t key, unsigned level )
+         {
+            return key >> ( 3 * ( cMaximumLevel - level ) );
+         }
+
+         // Split the points [begin, end) of @a keys, which are all in @a cell at @a level, into
+         // the points of the node of the cell & the points of its children. The nodes are added
+         // to @a nodes with their first record being their position in @a keys.
+         void split( std::vector<PointKey> &keys, std::vector<PointKey> &scratch, size_t begin,
+                     size_t end, unsigned level, uint64_t cell, size_t nodePointCount,
+                     std::vector<Node> &nodes )
+         {
+            const size_t cCount = end - begin;
+
+            Node node;
+            node.level = level;
+            node.cell = cell;
+            node.firstRecord = begin;
+
+            if ( ( cCount <= nodePointCount ) || ( level == cMaximumLevel ) )
+            {
+               node.recordCount = cCount;
+               nodes.push_back( node );
+               return;
+            }
+
+            // Move an even sample of the points to the front of the range. The rest stay in
+            // Morton order, so the points of each child are contiguous.
+            scratch.clear();
+
+            size_t taken = 0;
+
+            for ( size_t i = 0; i < cCount; ++i )
+            {
+               if ( ( taken < nodePointCount ) && ( i == taken * cCount / nodePointCount ) )
+               {
+                  keys[begin + taken] = keys[begin + i];
+                  ++taken;
+               }
+               else
+               {
+                  scratch.push_back( keys[begin + i] );
+               }
+            }
+
+            std::copy( scratch.begin(), scratch.end(), keys.begin() + begin + taken );
+
+            node.recordCount = taken;
+            nodes.push_back( node );
+
+            for ( size_t first = begin + taken; first < end; )
+            {
+               const uint64_t cChild = cellAt( keys[first].first, level + 1 );
+               size_t last = first + 1;
+
+               while ( ( last < end ) && ( cellAt( keys[last].first, level + 1 ) == cChild ) )
+               {
+                  ++last;
+               }
+
+               split( keys, scratch, first, last, level + 1, cChild, nodePointCount, nodes );
+
+               first = last;
+            }
+         }
+      }
+
+      void nodeBounds( const Node &node, const PointOrdering::Box &box, double ( &minimum )[3],
+                       double ( &maximum )[3] )
+      {
+         constexpr double cCellCount = ( 1u << PointOrdering::cBitsPerAxis ) - 1;
+         const auto cCellsPerNode = static_cast<double>( 1u << ( cMaximumLevel - node.level ) );
+
+         for ( unsigned axis = 0; axis < 3; ++axis )
+         {
+            // The coordinates of the cell are interleaved with x in the most significant bits
+            uint32_t position = 0;
+
+            for ( unsigned bit = 0; bit < node.level; ++bit )
+            {
+               position |= static_cast<uint32_t>( ( node.cell >> ( 3 * bit + 2 - axis ) ) & 1 )
+                           << bit;
+            }
+
+            const double cCellSize = ( box.maximum[axis] - box.minimum[axis] ) / cCellCount;
+
+            minimum[axis] = box.minimum[axis] + position * cCellsPerNode * cCellSize;
+            maximum[axis] = std::min( box.maximum[axis],
+                                      box.minimum[axis] +
+                                         ( position + 1 ) * cCellsPerNode * cCellSize );
+         }
+      }
+
+      template <typename COORDTYPE>
+      std::vector<size_t> build( const Data3DPointsData_t<COORDTYPE> &buffers, size_t count,
+                                 size_t nodePointCount, PointOrdering::Box &box,
+                                 std::vector<Node> &nodes )
+      {
+         std::vector<PointKey> keys =
+            PointOrdering::sortedKeys( buffers, count, PointOrderMorton, box );
+
+         nodes.clear();
+
+         if ( keys.empty() )
+         {
+            return {};
+         }
+
+         const auto cValidEnd = static_cast<size_t>(
+            std::lower_bound( keys.begin(), keys.end(),
+                              PointKey( PointOrdering::cInvalidKey, 0 ) ) -
+            keys.begin() );
+
+         if ( cValidEnd > 0 )
+         {
+            std::vector<PointKey> scratch;
+
+            split( keys, scratch, 0, cValidEnd, 0, 0, std::max<size_t>( nodePointCount, 1 ),
+                   nodes );
+         }
+
+         // Coarse to fine, each level in Morton order
+         std::sort( nodes.begin(), nodes.end(), []( const Node &a, const Node &b ) {
+            return ( a.level != b.level ) ? ( a.level < b.level ) : ( a.cell < b.cell );
+         } );
+
+         std::vector<size_t> indices;
+         indices.reserve( count );
+
+         for ( Node &node : nodes )
+         {
+            const auto cFirst = keys.begin() + static_cast<std::ptrdiff_t>( node.firstRecord );
+
+            node.firstRecord = indices.size();
+
+            std::for_each( cFirst, cFirst + static_cast<std::ptrdiff_t>( node.recordCount ),
+                           [&indices]( const PointKey &key ) { indices.push_back( key.second ); } );
+         }
+
+         for ( size_t i = cValidEnd; i < keys.size(); ++i )
+         {
+            indices.push_back( keys[i].second );
+         }
+
+         return indices;
+      }
+
+      // Explicit template instantiation
+      template std::vector<size_t> build( const Data3DPointsData_t<float> &buffers, size_t count,
+                                          size_t nodePointCount, PointOrdering::Box &box,
+                                          std::vector<Node> &nodes );
+
+      template std::vector<size_t> build( const Data3DPointsData_t<double> &buffers, size_t count,
+                                          size_t nodePointCount, PointOrdering::Box &box,
+                                          std::vector<Node> &nodes );
+   }
+}
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "PointOrdering.h"
+
+namespace e57
+{
+   /// Level-of-detail octree of the points of a scan (see WriterOptions::lodNodePointCount)
+   namespace LevelOfDetail
+   {
+      /// URI of the extension which holds the octree of a scan
+      constexpr char cLevelOfDetailUri[] =
+         "https://github.com/asmaloney/libE57Format/E57_EXT_level_of_detail";
+
+      /// Prefix used for the extension if the file doesn't already declare one for it
+      constexpr char cLevelOfDetailPrefix[] = "libe57lod";
+
+      /// Name of the structure, in the scan, holding its octree
+      constexpr char cLevelOfDetailElement[] = "levelOfDetail";
+
+      /// Deepest level of the octree: its nodes are the cells of the point keys
+      constexpr unsigned cMaximumLevel = PointOrdering::cBitsPerAxis;
+
+      /// One node of the octree, whose points are records [firstRecord, firstRecord +
+      /// recordCount) of the scan
+      struct Node
+      {
+         unsigned level = 0;
+
+         /// Morton key of the cell of the node among the 8^level cells of its level
+         uint64_t cell = 0;
+
+         uint64_t firstRecord = 0;
+         uint64_t recordCount = 0;
+      };
+
+      /// The region of space covered by @a node & its children, in the octree of @a box.
+      void nodeBounds( const Node &node, const PointOrdering::Box &box, double ( &minimum )[3],
+                       double ( &maximum )[3] );
+
+      /// Build the octree of the first @a count points of @a buffers, with at most
+      /// @a nodePointCount points in each node above the deepest level, and return the order
+      /// to write the points in. The nodes are laid out level by level from the root, each
+      /// level in Morton order, so the coarse levels are at the start of the scan. Each node
+      /// keeps an even sample of the points in its cell which aren't in one of its ancestors.
+      /// The points with an invalid state come last and aren't in any node. @a box is set to
+      /// the box around the valid points. Returns an empty vector if @a buffers have no
+      /// coordinates.
+      template <typename COORDTYPE>
+      std::vector<size_t> build( const Data3DPointsData_t<COORDTYPE> &buffers, size_t count,
+                                 size_t nodePointCount, PointOrdering::Box &box,
+                                 std::vector<Node> &nodes );
+   }
+}
@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+
+#if defined( _WIN32 )
+#include <malloc.h>
+#elif defined( __linux__ )
+#include <sys/mman.h>
+#endif
+
+#include "Memory.h"
+
+namespace
+{
+   using namespace e57::Memory;
+
+   struct Counter
+   {
+      std::atomic<uint64_t> current{ 0 };
+      std::atomic<uint64_t> peak{ 0 };
+   };
+
+   // Constant initialized, so they may be used while other statics are constructed
+   Counter gCounters[SubsystemCount];
+   Counter gTotal;
+
+   std::atomic<uint64_t> gBudget{ 0 };
+   std::atomic<uint64_t> gBudgetReductions{ 0 };
+
+   void raisePeak( Counter &counter, uint64_t value )
+   {
+      uint64_t peak = counter.peak.load( std::memory_order_relaxed );
+
+      while ( ( value > peak ) &&
+              !counter.peak.compare_exchange_weak( peak, value, std::memory_order_relaxed ) )
+      {
+      }
+   }
+
+   Usage usageOf( const Counter &counter )
+   {
+      Usage usage;
+
+      usage.currentBytes = counter.current.load( std::memory_order_relaxed );
+      usage.peakBytes = counter.peak.load( std::memory_order_relaxed );
+
+      return usage;
+   }
+}
+
+namespace e57
+{
+   void Memory::add( Subsystem subsystem, uint64_t byteCount )
+   {
+      if ( byteCount == 0 )
+      {
+         return;
+      }
+
+      Counter &counter = gCounters[subsystem];
+
+      raisePeak( counter,
+                 counter.current.fetch_add( byteCount, std::memory_order_relaxed ) + byteCount );
+      raisePeak( gTotal, gTotal.current.fetch_add( byteCount, std::memory_order_relaxed ) +
+                            byteCount );
+   }
+
+   void Memory::remove( Subsystem subsystem, uint64_t byteCount )
+   {
+      if ( byteCount == 0 )
+      {
+         return;
+      }
+
+      gCounters[subsystem].current.fetch_sub( byteCount, std::memory_order_relaxed );
+      gTotal.current.fetch_sub( byteCount, std::memory_order_relaxed );
+   }
+
+   bool Memory::overBudget()
+   {
+      const uint64_t cBudget = gBudget.load( std::memory_order_relaxed );
+
+      return ( cBudget != 0 ) && ( gTotal.current.load( std::memory_order_relaxed ) > cBudget );
+   }
+
+   unsigned Memory::affordableCount( unsigned wanted, unsigned minimum, uint64_t itemBytes )
+   {
+      const uint64_t cBudget = gBudget.load( std::memory_order_relaxed );
+
+      if ( ( cBudget == 0 ) || ( itemBytes == 0 ) || ( wanted <= minimum ) )
+      {
+         return wanted;
+      }
+
+      const uint64_t cTotal = gTotal.current.load( std::memory_order_relaxed );
+      const uint64_t cAvailable = ( cTotal < cBudget ) ? ( cBudget - cTotal ) : 0;
+      const uint64_t cAffordable = std::max<uint64_t>( cAvailable / itemBytes, minimum );
+
+      if ( cAffordable >= wanted )
+      {
+         return wanted;
+      }
+
+      gBudgetReductions.fetch_add( 1, std::memory_order_relaxed );
+
+      return static_cast<unsigned>( cAffordable );
+   }
+
+   Memory::Statistics Memory::statistics()
+   {
+      Statistics statistics;
+
+      statistics.packetCaches = usageOf( gCounters[PacketCaches] );
+      statistics.sharedPacketCaches = usageOf( gCounters[SharedPacketCaches] );
+      statistics.decoders = usageOf( gCounters[Decoders] );
+      statistics.writers = usageOf( gCounters[Writers] );
+      statistics.nodes = usageOf( gCounters[Nodes] );
+      statistics.pointBuffers = usageOf( gCounters[PointBuffers] );
+      statistics.total = usageOf( gTotal );
+      statistics.budget = gBudget.load( std::memory_order_relaxed );
+      statistics.budgetReductions = gBudgetReductions.load( std::memory_order_relaxed );
+
+      return statistics;
+   }
+
+   void Memory::resetPeaks()
+   {
+      for ( auto &counter : gCounters )
+      {
+         counter.peak.store( counter.current.load( std::memory_order_relaxed ),
+                             std::memory_order_relaxed );
+      }
+
+      gTotal.peak.store( gTotal.current.load( std::memory_order_relaxed ),
+                         std::memory_order_relaxed );
+   }
+
+   void Memory::setBudget( uint64_t byteBudget )
+   {
+      gBudget.store( byteBudget, std::memory_order_relaxed );
+   }
+
+   void *Memory::allocateAligned( size_t byteCount )
+   {
+      size_t alignment = cCacheLineSize;
+
+      if ( byteCount >= cHugePageSize )
+      {
+         alignment = cHugePageSize;
+      }
+      else if ( byteCount >= cPageSize )
+      {
+         alignment = cPageSize;
+      }
+
+      // Never ask for 0 bytes, which may give nullptr
+      byteCount = std::max<size_t>( byteCount, 1 );
+
+#if defined( _WIN32 )
+      void *pointer = _aligned_malloc( byteCount, alignment );
+#else
+      void *pointer = nullptr;
+
+      if ( posix_memalign( &pointer, alignment, byteCount ) != 0 )
+      {
+         pointer = nullptr;
+      }
+#endif
+
+      if ( pointer == nullptr )
+      {
+         throw std::bad_alloc();
+      }
+
+#if defined( __linux__ ) && defined( MADV_HUGEPAGE )
+      if ( alignment == cHugePageSize )
+      {
+         // Only advice: if transparent huge pages are unavailable this fails & changes nothing
+         madvise( pointer, byteCount - byteCount % cHugePageSize, MADV_HUGEPAGE );
+      }
+#endif
+
+      return pointer;
+   }
+
+   void Memory::freeAligned( void *pointer ) noexcept
+   {
+#if defined( _WIN32 )
+      _aligned_free( pointer );
+#else
+      free( pointer );
+#endif
+   }
+}
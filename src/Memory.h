@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "E57Memory.h"
+
+#include "Common.h"
+
+namespace e57
+{
+   namespace Memory
+   {
+      /// The parts the memory of the library is counted by
+      enum Subsystem
+      {
+         PacketCaches,
+         SharedPacketCaches,
+         Decoders,
+         Writers,
+         Nodes,
+         PointBuffers,
+
+         SubsystemCount
+      };
+
+      /// Count @a byteCount more (or fewer) bytes in use by @a subsystem.
+      void add( Subsystem subsystem, uint64_t byteCount );
+      void remove( Subsystem subsystem, uint64_t byteCount );
+
+      /// True if there is a budget and the total is beyond it
+      bool overBudget();
+
+      /// How many of the @a wanted items of @a itemBytes each fit within the budget (all of them
+      /// if there is none), but at least @a minimum. Counts a reduction if it is less than
+      /// @a wanted.
+      unsigned affordableCount( unsigned wanted, unsigned minimum, uint64_t itemBytes );
+
+      /// Counts @a byteCount bytes of @a subsystem for as long as it lives, e.g. as a member of
+      /// the object owning the memory.
+      class Charge
+      {
+      public:
+         Charge() = default;
+
+         Charge( Subsystem subsystem, uint64_t byteCount ) :
+            subsystem_( subsystem ), byteCount_( byteCount )
+         {
+            add( subsystem_, byteCount_ );
+         }
+
+         ~Charge()
+         {
+            remove( subsystem_, byteCount_ );
+         }
+
+         Charge( Charge &&other ) noexcept :
+            subsystem_( other.subsystem_ ), byteCount_( other.byteCount_ )
+         {
+            other.byteCount_ = 0;
+         }
+
+         Charge &operator=( Charge &&other ) noexcept
+         {
+            if ( this != &other )
+            {
+               remove( subsystem_, byteCount_ );
+
+               subsystem_ = other.subsystem_;
+               byteCount_ = other.byteCount_;
+               other.byteCount_ = 0;
+            }
+
+            return *this;
+         }
+
+         Charge( const Charge & ) = delete;
+         Charge &operator=( const Charge & ) = delete;
+
+         /// Count @a byteCount bytes of @a subsystem instead.
+         void set( Subsystem subsystem, uint64_t byteCount )
+         {
+            if ( ( subsystem == subsystem_ ) && ( byteCount == byteCount_ ) )
+            {
+               return;
+            }
+
+            add( subsystem, byteCount );
+            remove( subsystem_, byteCount_ );
+
+            subsystem_ = subsystem;
+            byteCount_ = byteCount;
+         }
+
+         /// Count @a byteCount bytes instead, e.g. once a buffer has grown.
+         void set( uint64_t byteCount )
+         {
+            set( subsystem_, byteCount );
+         }
+
+      private:
+         Subsystem subsystem_ = PacketCaches;
+         uint64_t byteCount_ = 0;
+      };
+
+      /// Alignment of every aligned allocation, so vector loads never straddle cache lines
+      constexpr size_t cCacheLineSize = 64;
+
+      /// Alignment of the aligned allocations of at least a page, so they suit direct I/O
+      constexpr size_t cPageSize = 4096;
+
+      /// Alignment of the aligned allocations of at least a huge page, which (on Linux) are also
+      /// marked to be backed by transparent huge pages where the system allows it
+      constexpr size_t cHugePageSize = 2 * 1024 * 1024;
+
+      /// Allocate @a byteCount uninitialized bytes aligned to cCacheLineSize, cPageSize or
+      /// cHugePageSize depending on their size. Throws std::bad_alloc if that fails.
+      void *allocateAligned( size_t byteCount );
+
+      /// Free memory from allocateAligned(). Does nothing for nullptr.
+      void freeAligned( void *pointer ) noexcept;
+
+      /// Allocator for containers of packet & page buffers, using allocateAligned()
+      template <typename T> class AlignedAllocator
+      {
+      public:
+         using value_type = T;
+
+         AlignedAllocator() = default;
+
+         template <typename U> AlignedAllocator( const AlignedAllocator<U> & ) noexcept
+         {
+         }
+
+         T *allocate( size_t count )
+         {
+            if ( count > std::numeric_limits<size_t>::max() / sizeof( T ) )
+            {
+               throw std::bad_alloc();
+            }
+
+            return static_cast<T *>( allocateAligned( count * sizeof( T ) ) );
+         }
+
+         void deallocate( T *pointer, size_t ) noexcept
+         {
+            freeAligned( pointer );
+         }
+
+         template <typename U> bool operator==( const AlignedAllocator<U> & ) const noexcept
+         {
+            return true;
+         }
+
+         template <typename U> bool operator!=( const AlignedAllocator<U> & ) const noexcept
+         {
+            return false;
+         }
+      };
+
+      template <typename T> using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+      /// Deleter of the objects made by makeAligned()
+      template <typename T> struct AlignedDelete
+      {
+         void operator()( T *pointer ) const noexcept
+         {
+            if ( pointer != nullptr )
+            {
+               pointer->~T();
+               freeAligned( pointer );
+            }
+         }
+      };
+
+      template <typename T> using AlignedPtr = std::unique_ptr<T, AlignedDelete<T>>;
+
+      /// Make a T in memory from allocateAligned(), e.g. a DataPacket whose payload is read from
+      /// or written to the file.
+      template <typename T> AlignedPtr<T> makeAligned()
+      {
+         void *storage = allocateAligned( sizeof( T ) );
+
+         try
+         {
+            return AlignedPtr<T>( new ( storage ) T() );
+         }
+         catch ( ... )
+         {
+            freeAligned( storage );
+            throw;
+         }
+      }
+   }
+}
@@ -28,6 +28,7 @@
 #pragma once
 
 #include "Common.h"
+#include "Memory.h"
 
 namespace e57
 {
@@ -96,11 +97,20 @@ namespace e57
          return {};
       }
 
+      /// Find the descendant at the relative path fields[level], fields[level + 1], ...
+      virtual NodeImplSharedPtr lookup( const StringList & /*fields*/, unsigned /*level*/ )
+      {
+         return {};
+      }
+
       NodeImplSharedPtr getRoot();
 
       ImageFileImplWeakPtr destImageFile_;
       NodeImplWeakPtr parent_;
       ustring elementName_;
       bool isAttached_;
+
+      /// Counts the node, set by the constructor of each type
+      Memory::Charge memory_;
    };
 }
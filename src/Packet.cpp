@@ -25,11 +25,19 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
 
 #include "CheckedFile.h"
 #include "Packet.h"
+#include "SharedPacketCache.h"
 #include "StringFunctions.h"
+#include "Tracing.h"
 
 using namespace e57;
 
@@ -47,183 +55,1014 @@ struct EmptyPacketHeader
 #endif
 };
 
+namespace
+{
+   /// Verify the packet of @a packetLength bytes in @a buffer, and for a data packet fill in
+   /// where each bytestream starts & where the last one ends.
+   void verifyPacket( char *buffer, unsigned packetLength,
+                      std::vector<unsigned> &bytestreamOffsets )
+   {
+      bytestreamOffsets.clear();
+
+      const auto header = reinterpret_cast<const EmptyPacketHeader *>( buffer );
+
+      // Be paranoid about packetLength before verify
+      if ( ( packetLength > DATA_PACKET_MAX ) ||
+           ( packetLength != static_cast<unsigned>( header->packetLogicalLengthMinus1 ) + 1 ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket, "packetLength=" + toString( packetLength ) );
+      }
+
+      // Verify that packet is good.
+      switch ( header->packetType )
+      {
+         case DATA_PACKET:
+         {
+            auto dpkt = reinterpret_cast<DataPacket *>( buffer );
+
+            dpkt->verify( packetLength );
+
+            // verify() checked that the bytestreams fit in the packet
+            const unsigned bytestreamCount = dpkt->header.bytestreamCount;
+            const auto bsbLength = reinterpret_cast<const uint16_t *>( &dpkt->payload[0] );
+
+            bytestreamOffsets.resize( bytestreamCount + 1 );
+            bytestreamOffsets[0] = sizeof( DataPacketHeader ) + 2 * bytestreamCount;
+
+            for ( unsigned i = 0; i < bytestreamCount; ++i )
+            {
+               bytestreamOffsets[i + 1] = bytestreamOffsets[i] + bsbLength[i];
+            }
+#ifdef E57_VERBOSE
+            std::cout << "  data packet:" << std::endl;
+            dpkt->dump( 4 ); //???
+#endif
+         }
+         break;
+         case INDEX_PACKET:
+         {
+            auto ipkt = reinterpret_cast<IndexPacket *>( buffer );
+
+            ipkt->verify( packetLength );
+#ifdef E57_VERBOSE
+            std::cout << "  index packet:" << std::endl;
+            ipkt->dump( 4 ); //???
+#endif
+         }
+         break;
+         case EMPTY_PACKET:
+         {
+            auto hp = reinterpret_cast<EmptyPacketHeader *>( buffer );
+
+            hp->verify( packetLength );
+#ifdef E57_VERBOSE
+            std::cout << "  empty packet:" << std::endl;
+            hp->dump( 4 ); //???
+#endif
+         }
+         break;
+         default:
+            throw E57_EXCEPTION2( ErrorInternal, "packetType=" + toString( header->packetType ) );
+      }
+   }
+
+   /// Start of bytestream @a bytestreamNumber of the data packet in @a buffer, and its length in
+   /// @a byteCount.
+   const char *bytestreamIn( const char *buffer, const std::vector<unsigned> &offsets,
+                             unsigned bytestreamNumber, unsigned &byteCount )
+   {
+      // Also catches packets other than data packets, which have no offsets
+      if ( bytestreamNumber + 1 >= offsets.size() )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "bytestreamNumber=" + toString( bytestreamNumber ) +
+                                                 " offsetCount=" + toString( offsets.size() ) );
+      }
+
+      byteCount = offsets[bytestreamNumber + 1] - offsets[bytestreamNumber];
+
+      return buffer + offsets[bytestreamNumber];
+   }
+
+   /// A packet of @a packetLength bytes to read into, with room for a data packet header.
+   std::shared_ptr<SharedPacket> newSharedPacket( uint64_t logicalOffset, unsigned packetLength )
+   {
+      auto packet = std::make_shared<SharedPacket>();
+
+      packet->logicalOffset = logicalOffset;
+      packet->buffer.resize( std::max<size_t>( packetLength, sizeof( DataPacketHeader ) ) );
+      packet->memory = Memory::Charge( Memory::SharedPacketCaches,
+                                       sizeof( SharedPacket ) + packet->buffer.size() );
+
+      return packet;
+   }
+}
+
+//=============================================================================
+// PacketPrefetcher
+
+namespace e57
+{
+   /// Reads the file ahead on a background thread, as consecutive spans of up to a given length,
+   /// keeping several of them in flight. The spans are kept until they are taken or dropped, so
+   /// reading carries on between the calls which use them.
+   class PacketPrefetcher
+   {
+   public:
+      /// Don't have more than this many spans read or being read ahead at once.
+      static constexpr size_t cMaxSpans = 4;
+
+      explicit PacketPrefetcher( CheckedFile *cFile ) : cFile_( cFile )
+      {
+         thread_ = std::thread( &PacketPrefetcher::run, this );
+      }
+
+      ~PacketPrefetcher()
+      {
+         {
+            std::lock_guard<std::mutex> guard( mutex_ );
+            stop_ = true;
+         }
+
+         changed_.notify_all();
+         thread_.join();
+      }
+
+      PacketPrefetcher( const PacketPrefetcher & ) = delete;
+      PacketPrefetcher &operator=( const PacketPrefetcher & ) = delete;
+
+      /// Make sure the spans after @a logicalOffset, up to @a limit, are being read, in spans of
+      /// @a spanLength bytes. The spans already there are kept if they lead up to @a logicalOffset,
+      /// and dropped otherwise.
+      void readAhead( uint64_t logicalOffset, size_t spanLength, uint64_t limit )
+      {
+         {
+            std::lock_guard<std::mutex> guard( mutex_ );
+
+            const bool cContinues = !spans_.empty() && ( spans_.front().offset <= logicalOffset ) &&
+                                    ( logicalOffset <= spans_.back().end() );
+
+            dropBefore( cContinues ? logicalOffset : UINT64_MAX );
+
+            uint64_t next = spans_.empty() ? logicalOffset : spans_.back().end();
+
+            while ( ( spans_.size() < cMaxSpans ) && ( next < limit ) )
+            {
+               Span span;
+               span.offset = next;
+               span.length = static_cast<size_t>( std::min<uint64_t>( spanLength, limit - next ) );
+
+               next += span.length;
+
+               spans_.push_back( std::move( span ) );
+            }
+         }
+
+         changed_.notify_all();
+      }
+
+      /// If the spans cover the @a length bytes at @a logicalOffset, wait for them and copy the
+      /// bytes into @a buffer. The spans before them are dropped. Returns false if the bytes aren't
+      /// there or couldn't be read.
+      bool take( uint64_t logicalOffset, size_t length, Memory::AlignedVector<char> &buffer )
+      {
+         std::unique_lock<std::mutex> guard( mutex_ );
+
+         dropBefore( logicalOffset );
+
+         const uint64_t cEnd = logicalOffset + length;
+
+         if ( spans_.empty() || ( spans_.front().offset > logicalOffset ) ||
+              ( spans_.back().end() < cEnd ) )
+         {
+            return false;
+         }
+
+         // The spans are consecutive, so those from the first one on cover the bytes
+         auto isRead = [this, cEnd] {
+            for ( const auto &span : spans_ )
+            {
+               if ( span.offset >= cEnd )
+               {
+                  break;
+               }
+
+               if ( ( span.state == Requested ) || ( span.state == Reading ) )
+               {
+                  return false;
+               }
+            }
+
+            return true;
+         };
+
+         if ( !isRead() )
+         {
+            ++waitCount_;
+            changed_.wait( guard, isRead );
+         }
+
+         for ( const auto &span : spans_ )
+         {
+            if ( span.offset >= cEnd )
+            {
+               break;
+            }
+
+            if ( span.state == Failed )
+            {
+               return false;
+            }
+         }
+
+         // The spans are kept, since the next bytes wanted usually start in the last of them
+         buffer.resize( length );
+
+         for ( const auto &span : spans_ )
+         {
+            if ( span.offset >= cEnd )
+            {
+               break;
+            }
+
+            const uint64_t cFrom = std::max( span.offset, logicalOffset );
+            const uint64_t cTo = std::min( span.end(), cEnd );
+
+            std::memcpy( &buffer[static_cast<size_t>( cFrom - logicalOffset )],
+                         &span.buffer[static_cast<size_t>( cFrom - span.offset )],
+                         static_cast<size_t>( cTo - cFrom ) );
+         }
+
+         return true;
+      }
+
+      /// Wait for the reads in progress to finish (keeping their data), and drop those not yet
+      /// started, so the file isn't used once this returns.
+      void finish()
+      {
+         std::unique_lock<std::mutex> guard( mutex_ );
+
+         spans_.erase( std::remove_if( spans_.begin(), spans_.end(),
+                                       []( const Span &span ) { return span.state == Requested; } ),
+                       spans_.end() );
+
+         if ( reading_ )
+         {
+            ++waitCount_;
+            changed_.wait( guard, [this] { return !reading_; } );
+         }
+      }
+
+      /// Times take() or finish() had to wait for the thread
+      uint64_t waitCount()
+      {
+         std::lock_guard<std::mutex> guard( mutex_ );
+
+         return waitCount_;
+      }
+
+   private:
+      enum State
+      {
+         Requested,
+         Reading,
+         Done,
+         Failed
+      };
+
+      struct Span
+      {
+         uint64_t offset = 0;
+         size_t length = 0;
+         State state = Requested;
+         Memory::AlignedVector<char> buffer;
+
+         uint64_t end() const
+         {
+            return offset + length;
+         }
+      };
+
+      /// Drop the spans which end at or before @a logicalOffset. One being read is finished by the
+      /// thread, which then throws its data away.
+      void dropBefore( uint64_t logicalOffset )
+      {
+         while ( !spans_.empty() && ( spans_.front().end() <= logicalOffset ) )
+         {
+            if ( spans_.front().state == Reading )
+            {
+               dropped_ = true;
+            }
+
+            spans_.pop_front();
+         }
+      }
+
+      void run()
+      {
+         std::unique_lock<std::mutex> guard( mutex_ );
+
+         while ( true )
+         {
+            auto next = spans_.end();
+
+            changed_.wait( guard, [this, &next] {
+               next = std::find_if( spans_.begin(), spans_.end(), []( const Span &span ) {
+                  return span.state == Requested;
+               } );
+
+               return stop_ || ( next != spans_.end() );
+            } );
+
+            if ( stop_ )
+            {
+               return;
+            }
+
+            next->state = Reading;
+            reading_ = true;
+            dropped_ = false;
+
+            const uint64_t offset = next->offset;
+            const size_t length = next->length;
+
+            Memory::AlignedVector<char> buffer;
+            buffer.swap( next->buffer );
+
+            guard.unlock();
+
+            bool succeeded = true;
+
+            try
+            {
+               buffer.resize( length );
+               cFile_->readAt( offset, buffer.data(), length );
+            }
+            catch ( ... )
+            {
+               // The packets will be read (and any error reported) when they are wanted.
+               succeeded = false;
+            }
+
+            guard.lock();
+
+            reading_ = false;
+
+            // Only one span is read at a time, so unless it was dropped it's the one Reading
+            if ( !dropped_ )
+            {
+               auto isReading = []( const Span &other ) { return other.state == Reading; };
+               auto span = std::find_if( spans_.begin(), spans_.end(), isReading );
+
+               span->buffer.swap( buffer );
+               span->state = succeeded ? Done : Failed;
+            }
+
+            changed_.notify_all();
+         }
+      }
+
+      CheckedFile *cFile_ = nullptr;
+
+      std::mutex mutex_;
+      std::condition_variable changed_;
+      std::thread thread_;
+
+      bool stop_ = false;
+      std::deque<Span> spans_; /// consecutive, in the order they are read
+      bool reading_ = false;   /// the thread is reading a span (which may have been dropped)
+      bool dropped_ = false;   /// the span being read was dropped
+      uint64_t waitCount_ = 0;
+   };
+}
+
 //=============================================================================
 // PacketReadCache
 
-PacketReadCache::PacketReadCache( CheckedFile *cFile, unsigned packetCount ) :
-   cFile_( cFile ), entries_( packetCount )
-{
-   if ( packetCount == 0 )
+PacketReadCache::PacketReadCache( CheckedFile *cFile, const PacketCacheOptions &options,
+                                  std::shared_ptr<SharedPacketCache> shared ) :
+   cFile_( cFile ), policy_( options.policy ), readAheadCount_( options.readAheadCount ),
+   shared_( std::move( shared ) ), projectedRead_( options.projectedRead )
+{
+   if ( options.packetCount == 0 )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "packetCount=" + toString( options.packetCount ) );
+   }
+
+   // With a shared cache, our own entries are only used for projected reads
+   if ( !shared_ || projectedRead_ )
+   {
+      entries_.resize( Memory::affordableCount( options.packetCount, 1, sizeof( CacheEntry ) ) );
+      entriesMemory_ =
+         Memory::Charge( Memory::PacketCaches, entries_.size() * sizeof( CacheEntry ) );
+   }
+
+   // Don't let read-ahead push out more than half of the cache.
+   const unsigned cPacketCount = entries_.empty() ? options.packetCount
+                                                  : static_cast<unsigned>( entries_.size() );
+
+   readAheadCount_ = std::min( readAheadCount_, cPacketCount / 2 );
+
+   if ( options.backgroundReadAhead )
+   {
+      try
+      {
+         prefetcher_.reset( new PacketPrefetcher( cFile_ ) );
+      }
+      catch ( const std::system_error & )
+      {
+         // Couldn't start the thread, so just read in the foreground
+      }
+   }
+}
+
+PacketReadCache::~PacketReadCache() = default;
+
+void PacketReadCache::finishReadAhead()
+{
+   if ( prefetcher_ )
+   {
+      prefetcher_->finish();
+   }
+}
+
+void PacketReadCache::setBytestreamFilter( const std::vector<bool> &needed )
+{
+   if ( projectedRead_ )
+   {
+      neededBytestreams_ = needed;
+   }
+}
+
+void PacketReadCache::setReadAheadLimit( uint64_t logicalOffset )
+{
+   readAheadLimit_ = logicalOffset;
+}
+
+std::unique_ptr<PacketLock> PacketReadCache::lock( uint64_t packetLogicalOffset, char *&pkt )
+{
+#ifdef E57_VERBOSE
+   std::cout << "PacketReadCache::lock() called, packetLogicalOffset=" << packetLogicalOffset
+             << std::endl;
+#endif
+
+   // Offset can't be 0
+   if ( packetLogicalOffset == 0 )
+   {
+      throw E57_EXCEPTION2( ErrorInternal,
+                            "packetLogicalOffset=" + toString( packetLogicalOffset ) );
+   }
+
+   // Projected reads only load part of each packet, so those can't be shared
+   if ( shared_ && neededBytestreams_.empty() )
+   {
+      return lockShared( packetLogicalOffset, pkt );
+   }
+
+   unsigned entryIndex = findEntry( packetLogicalOffset );
+
+   if ( entryIndex < entries_.size() )
+   {
+      // Found a match, so don't have to read anything
+#ifdef E57_VERBOSE
+      std::cout << "  Found matching cache entry, index=" << entryIndex << std::endl;
+#endif
+      // Mark entry with current useCount (keeps track of age of entry).
+      entries_[entryIndex].lastUsed_ = ++useCount_;
+
+      ++hitCount_;
+   }
+   else
+   {
+      // Get here if didn't find a match already in cache.
+      entryIndex = replaceableEntry();
+
+      ++missCount_;
+
+      if ( !neededBytestreams_.empty() )
+      {
+         readPacketProjected( entryIndex, packetLogicalOffset );
+      }
+      else if ( ( readAheadCount_ > 0 ) || prefetcher_ )
+      {
+         readPacketWithReadAhead( entryIndex, packetLogicalOffset );
+      }
+      else
+      {
+         readPacket( entryIndex, packetLogicalOffset );
+      }
+   }
+
+   auto &entry = entries_[entryIndex];
+
+   // Publish buffer address to caller
+   pkt = entry.buffer_;
+
+   // Create lock so we are sure that we will be unlocked when use is finished.
+   std::unique_ptr<PacketLock> plock( new PacketLock( this, entryIndex ) );
+
+   // Increment entry's lock just before return
+   ++entry.lockCount_;
+
+   return plock;
+}
+
+void PacketReadCache::unlock( unsigned cacheIndex )
+{
+#ifdef E57_VERBOSE
+   std::cout << "PacketReadCache::unlock() called, cacheIndex=" << cacheIndex << std::endl;
+#endif
+
+   if ( ( cacheIndex >= entries_.size() ) || ( entries_[cacheIndex].lockCount_ == 0 ) )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "cacheIndex=" + toString( cacheIndex ) );
+   }
+
+   --entries_[cacheIndex].lockCount_;
+}
+
+const char *PacketReadCache::bytestream( unsigned cacheIndex, unsigned bytestreamNumber,
+                                         unsigned &byteCount ) const
+{
+   const auto &entry = entries_[cacheIndex];
+
+   return bytestreamIn( entry.buffer_, entry.bytestreamOffsets_, bytestreamNumber, byteCount );
+}
+
+unsigned PacketReadCache::findEntry( uint64_t packetLogicalOffset ) const
+{
+   // Linear scan for matching packet offset in cache
+   for ( unsigned i = 0; i < entries_.size(); ++i )
+   {
+      if ( packetLogicalOffset == entries_[i].logicalOffset_ )
+      {
+         return i;
+      }
+   }
+
+   return static_cast<unsigned>( entries_.size() );
+}
+
+unsigned PacketReadCache::replaceableEntry() const
+{
+   // Empty entries have both lastUsed_ and logicalOffset_ of 0, so they are used first.
+   unsigned found = static_cast<unsigned>( entries_.size() );
+
+   for ( unsigned i = 0; i < entries_.size(); ++i )
+   {
+      const auto &entry = entries_[i];
+
+      // Locked entries are in use and can't be replaced
+      if ( entry.lockCount_ > 0 )
+      {
+         continue;
+      }
+
+      if ( found == entries_.size() )
+      {
+         found = i;
+         continue;
+      }
+
+      const auto &foundEntry = entries_[found];
+
+      const bool isBetter = ( policy_ == PacketCacheLowestOffset )
+                               ? ( entry.logicalOffset_ < foundEntry.logicalOffset_ )
+                               : ( entry.lastUsed_ < foundEntry.lastUsed_ );
+
+      if ( isBetter )
+      {
+         found = i;
+      }
+   }
+
+   if ( found == entries_.size() )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "all cache entries locked; packetCount=" +
+                                              toString( entries_.size() ) );
+   }
+
+#ifdef E57_VERBOSE
+   std::cout << "  Replacing entry=" << found << " lastUsed=" << entries_[found].lastUsed_
+             << std::endl;
+#endif
+
+   return found;
+}
+
+void PacketReadCache::readPacket( unsigned entryIndex, uint64_t packetLogicalOffset )
+{
+   E57_TRACE_ZONE( "PacketReadCache::readPacket" );
+
+#ifdef E57_VERBOSE
+   std::cout << "PacketReadCache::readPacket() called, entryIndex=" << entryIndex
+             << " packetLogicalOffset=" << packetLogicalOffset << std::endl;
+#endif
+
+   // Read header of packet first to get length.  Use EmptyPacketHeader since  it has the fields
+   // common to all packets.
+   EmptyPacketHeader header;
+
+   cFile_->readAt( packetLogicalOffset, reinterpret_cast<char *>( &header ), sizeof( header ) );
+
+   // Can't verify packet header here, because it is not really an EmptyPacketHeader.
+   unsigned packetLength = header.packetLogicalLengthMinus1 + 1;
+
+   // Be paranoid about packetLength before read
+   if ( packetLength > DATA_PACKET_MAX )
+   {
+      throw E57_EXCEPTION2( ErrorBadCVPacket, "packetLength=" + toString( packetLength ) );
+   }
+
+   auto &entry = entries_.at( entryIndex );
+
+   // Now read in whole packet into preallocated buffer_.
+   cFile_->readAt( packetLogicalOffset, entry.buffer_, packetLength );
+
+   loadPacket( entryIndex, packetLogicalOffset, nullptr, packetLength );
+}
+
+void PacketReadCache::readPacketProjected( unsigned entryIndex, uint64_t packetLogicalOffset )
+{
+   E57_TRACE_ZONE( "PacketReadCache::readPacketProjected" );
+
+   auto &entry = entries_.at( entryIndex );
+   char *buffer = entry.buffer_;
+
+   // Read the header common to all packets to get the length & type
+   cFile_->readAt( packetLogicalOffset, buffer, sizeof( EmptyPacketHeader ) );
+
+   const auto header = reinterpret_cast<const EmptyPacketHeader *>( buffer );
+   const unsigned packetLength = header->packetLogicalLengthMinus1 + 1;
+
+   if ( packetLength > DATA_PACKET_MAX )
+   {
+      throw E57_EXCEPTION2( ErrorBadCVPacket, "packetLength=" + toString( packetLength ) );
+   }
+
+   if ( ( header->packetType != DATA_PACKET ) || ( packetLength < sizeof( DataPacketHeader ) ) )
+   {
+      cFile_->readAt( packetLogicalOffset, buffer, packetLength );
+      loadPacket( entryIndex, packetLogicalOffset, nullptr, packetLength );
+      return;
+   }
+
+   // Read the rest of the data packet header, then the lengths of the bytestream buffers
+   cFile_->readAt( packetLogicalOffset + sizeof( EmptyPacketHeader ),
+                   buffer + sizeof( EmptyPacketHeader ),
+                   sizeof( DataPacketHeader ) - sizeof( EmptyPacketHeader ) );
+
+   const auto dpkt = reinterpret_cast<const DataPacket *>( buffer );
+   const unsigned bytestreamCount = dpkt->header.bytestreamCount;
+   const unsigned streamsStart = sizeof( DataPacketHeader ) + 2 * bytestreamCount;
+
+   if ( streamsStart > packetLength )
+   {
+      throw E57_EXCEPTION2( ErrorBadCVPacket, "bytestreamCount=" + toString( bytestreamCount ) +
+                                                 " packetLength=" + toString( packetLength ) );
+   }
+
+   cFile_->readAt( packetLogicalOffset + sizeof( DataPacketHeader ),
+                   buffer + sizeof( DataPacketHeader ), 2 * bytestreamCount );
+
+   unsigned bytesRead = streamsStart;
+
+   // Read the needed buffers, joining neighbours into one read
+   unsigned rangeStart = streamsStart;
+   unsigned rangeEnd = streamsStart;
+
+   auto readRange = [&]() {
+      if ( rangeEnd > rangeStart )
+      {
+         cFile_->readAt( packetLogicalOffset + rangeStart, buffer + rangeStart,
+                         rangeEnd - rangeStart );
+
+         bytesRead += rangeEnd - rangeStart;
+      }
+   };
+
+   auto bsbLength = reinterpret_cast<const uint16_t *>( &dpkt->payload[0] );
+   unsigned position = streamsStart;
+
+   for ( unsigned i = 0; i < bytestreamCount; ++i )
    {
-      throw E57_EXCEPTION2( ErrorInternal, "packetCount=" + toString( packetCount ) );
+      const unsigned length = bsbLength[i];
+
+      if ( ( i < neededBytestreams_.size() ) && neededBytestreams_[i] && ( length > 0 ) )
+      {
+         if ( position != rangeEnd )
+         {
+            readRange();
+            rangeStart = position;
+         }
+
+         rangeEnd = position + length;
+      }
+
+      position += length;
+
+      if ( position > packetLength )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket, "position=" + toString( position ) +
+                                                    " packetLength=" + toString( packetLength ) );
+      }
+   }
+
+   // The padding after the buffers is verified, so read it too
+   if ( position != rangeEnd )
+   {
+      readRange();
+      rangeStart = position;
    }
+
+   rangeEnd = packetLength;
+   readRange();
+
+   skippedByteCount_ += packetLength - bytesRead;
+
+   loadPacket( entryIndex, packetLogicalOffset, nullptr, packetLength );
 }
 
-std::unique_ptr<PacketLock> PacketReadCache::lock( uint64_t packetLogicalOffset, char *&pkt )
+void PacketReadCache::readPacketWithReadAhead( unsigned entryIndex, uint64_t packetLogicalOffset )
 {
-#ifdef E57_VERBOSE
-   std::cout << "PacketReadCache::lock() called, packetLogicalOffset=" << packetLogicalOffset
-             << std::endl;
-#endif
+   E57_TRACE_ZONE( "PacketReadCache::readPacketWithReadAhead" );
+
+   const size_t spanLength = readSpan( packetLogicalOffset );
 
-   // Only allow one locked packet at a time.
-   if ( lockCount_ > 0 )
+   uint64_t spanOffset = 0;
+   unsigned packetLength = ( spanLength > 0 ) ? spanPacketLength( spanLength, spanOffset ) : 0;
+
+   if ( packetLength == 0 )
    {
-      throw E57_EXCEPTION2( ErrorInternal, "lockCount=" + toString( lockCount_ ) );
+      readPacket( entryIndex, packetLogicalOffset );
+      return;
    }
 
-   // Offset can't be 0
-   if ( packetLogicalOffset == 0 )
+   loadPacket( entryIndex, packetLogicalOffset, readAheadBuffer_.data(), packetLength );
+
+   // Keep the requested packet while we load the ones following it.
+   ++entries_[entryIndex].lockCount_;
+
+   try
    {
-      throw E57_EXCEPTION2( ErrorInternal,
-                            "packetLogicalOffset=" + toString( packetLogicalOffset ) );
+      for ( unsigned i = 0; i < readAheadCount_; ++i )
+      {
+         const unsigned nextLength = spanPacketLength( spanLength, spanOffset + packetLength );
+
+         if ( nextLength == 0 )
+         {
+            break;
+         }
+
+         spanOffset += packetLength;
+         packetLength = nextLength;
+
+         const uint64_t nextLogicalOffset = packetLogicalOffset + spanOffset;
+
+         if ( findEntry( nextLogicalOffset ) < entries_.size() )
+         {
+            continue;
+         }
+
+         const unsigned nextEntry = replaceableEntry();
+
+         try
+         {
+            loadPacket( nextEntry, nextLogicalOffset, &readAheadBuffer_[spanOffset],
+                        packetLength );
+         }
+         catch ( const E57Exception & )
+         {
+            // Report a bad packet when it is actually wanted.
+            entries_[nextEntry].logicalOffset_ = 0;
+            entries_[nextEntry].lastUsed_ = 0;
+            break;
+         }
+      }
+   }
+   catch ( ... )
+   {
+      --entries_[entryIndex].lockCount_;
+      throw;
    }
 
-   // Linear scan for matching packet offset in cache
-   for ( unsigned i = 0; i < entries_.size(); ++i )
+   --entries_[entryIndex].lockCount_;
+
+   // Reading forwards, the next miss will be the packet after the last one we loaded, so start
+   // reading that span now.
+   startNextSpan( packetLogicalOffset + spanOffset + packetLength );
+}
+
+std::unique_ptr<PacketLock> PacketReadCache::lockShared( uint64_t packetLogicalOffset, char *&pkt )
+{
+   std::shared_ptr<const SharedPacket> packet = shared_->find( packetLogicalOffset );
+
+   if ( packet )
+   {
+      ++hitCount_;
+   }
+   else
    {
-      auto &entry = entries_[i];
+      ++missCount_;
 
-      if ( packetLogicalOffset == entry.logicalOffset_ )
-      {
-         // Found a match, so don't have to read anything
-#ifdef E57_VERBOSE
-         std::cout << "  Found matching cache entry, index=" << i << std::endl;
-#endif
-         // Mark entry with current useCount (keeps track of age of entry).
-         entry.lastUsed_ = ++useCount_;
+      packet = readShared( packetLogicalOffset );
+   }
 
-         // Publish buffer address to caller
-         pkt = entry.buffer_;
+   // The readers don't change the packets they lock
+   pkt = const_cast<char *>( packet->buffer.data() );
+
+   return std::unique_ptr<PacketLock>( new PacketLock( std::move( packet ) ) );
+}
+
+std::shared_ptr<const SharedPacket> PacketReadCache::readShared( uint64_t packetLogicalOffset )
+{
+   E57_TRACE_ZONE( "PacketReadCache::readShared" );
+
+   const bool cReadAhead = ( readAheadCount_ > 0 ) || prefetcher_;
+   const size_t spanLength = cReadAhead ? readSpan( packetLogicalOffset ) : 0;
+
+   uint64_t spanOffset = 0;
+   unsigned packetLength = ( spanLength > 0 ) ? spanPacketLength( spanLength, spanOffset ) : 0;
+
+   if ( packetLength == 0 )
+   {
+      // Read the header common to all packets to get the length, then the whole packet
+      EmptyPacketHeader header;
 
-         // Create lock so we are sure that we will be unlocked when use is finished.
-         std::unique_ptr<PacketLock> plock( new PacketLock( this, i ) );
+      cFile_->readAt( packetLogicalOffset, reinterpret_cast<char *>( &header ), sizeof( header ) );
 
-         // Increment cache lock just before return
-         ++lockCount_;
+      packetLength = header.packetLogicalLengthMinus1 + 1;
 
-         return plock;
+      if ( packetLength > DATA_PACKET_MAX )
+      {
+         throw E57_EXCEPTION2( ErrorBadCVPacket, "packetLength=" + toString( packetLength ) );
       }
+
+      auto packet = newSharedPacket( packetLogicalOffset, packetLength );
+
+      cFile_->readAt( packetLogicalOffset, packet->buffer.data(), packetLength );
+      verifyPacket( packet->buffer.data(), packetLength, packet->bytestreamOffsets );
+
+      return shared_->insert( std::move( packet ) );
    }
-   // Get here if didn't find a match already in cache.
 
-   // Find least recently used (LRU) packet buffer
-   unsigned oldestEntry = 0;
-   unsigned oldestUsed = entries_.at( 0 ).lastUsed_;
+   auto packet = newSharedPacket( packetLogicalOffset, packetLength );
 
-   for ( unsigned i = 0; i < entries_.size(); ++i )
+   std::memcpy( packet->buffer.data(), readAheadBuffer_.data(), packetLength );
+   verifyPacket( packet->buffer.data(), packetLength, packet->bytestreamOffsets );
+
+   std::shared_ptr<const SharedPacket> requested = shared_->insert( std::move( packet ) );
+
+   // Share the packets following it too, unless another reader already has
+   for ( unsigned i = 0; i < readAheadCount_; ++i )
    {
-      const auto &entry = entries_[i];
+      const unsigned nextLength = spanPacketLength( spanLength, spanOffset + packetLength );
 
-      if ( entry.lastUsed_ < oldestUsed )
+      if ( nextLength == 0 )
       {
-         oldestEntry = i;
-         oldestUsed = entry.lastUsed_;
+         break;
       }
-   }
-#ifdef E57_VERBOSE
-   std::cout << "  Oldest entry=" << oldestEntry << " lastUsed=" << oldestUsed << std::endl;
-#endif
 
-   readPacket( oldestEntry, packetLogicalOffset );
+      spanOffset += packetLength;
+      packetLength = nextLength;
 
-   // Publish buffer address to caller
-   pkt = entries_[oldestEntry].buffer_;
+      const uint64_t nextLogicalOffset = packetLogicalOffset + spanOffset;
 
-   // Create lock so we are sure we will be unlocked when use is finished.
-   std::unique_ptr<PacketLock> plock( new PacketLock( this, oldestEntry ) );
+      if ( shared_->contains( nextLogicalOffset ) )
+      {
+         continue;
+      }
 
-   // Increment cache lock just before return
-   ++lockCount_;
+      auto next = newSharedPacket( nextLogicalOffset, packetLength );
 
-   return plock;
+      std::memcpy( next->buffer.data(), &readAheadBuffer_[spanOffset], packetLength );
+
+      try
+      {
+         verifyPacket( next->buffer.data(), packetLength, next->bytestreamOffsets );
+      }
+      catch ( const E57Exception & )
+      {
+         // Report a bad packet when it is actually wanted.
+         break;
+      }
+
+      shared_->insert( std::move( next ) );
+   }
+
+   startNextSpan( packetLogicalOffset + spanOffset + packetLength );
+
+   return requested;
 }
 
-void PacketReadCache::unlock( unsigned cacheIndex )
+size_t PacketReadCache::spanLengthAt( uint64_t logicalOffset ) const
 {
-   //??? why lockedEntry not used?
-#ifdef E57_VERBOSE
-   std::cout << "PacketReadCache::unlock() called, cacheIndex=" << cacheIndex << std::endl;
-#else
-   E57_UNUSED( cacheIndex );
-#endif
-
-   if ( lockCount_ != 1 )
+   if ( readAheadLimit_ <= logicalOffset )
    {
-      throw E57_EXCEPTION2( ErrorInternal, "lockCount=" + toString( lockCount_ ) );
+      return 0;
    }
 
-   --lockCount_;
+   return static_cast<size_t>(
+      std::min<uint64_t>( maxSpanLength(), readAheadLimit_ - logicalOffset ) );
 }
 
-void PacketReadCache::readPacket( unsigned oldestEntry, uint64_t packetLogicalOffset )
+size_t PacketReadCache::maxSpanLength() const
 {
-#ifdef E57_VERBOSE
-   std::cout << "PacketReadCache::readPacket() called, oldestEntry=" << oldestEntry
-             << " packetLogicalOffset=" << packetLogicalOffset << std::endl;
-#endif
-
-   // Read header of packet first to get length.  Use EmptyPacketHeader since  it has the fields
-   // common to all packets.
-   EmptyPacketHeader header;
+   // Read as many packets as we might use in one go. Packets are at most DATA_PACKET_MAX long, so
+   // this always includes the requested one.
+   return static_cast<size_t>( readAheadCount_ + 1 ) * DATA_PACKET_MAX;
+}
 
-   cFile_->seek( packetLogicalOffset, CheckedFile::Logical );
-   cFile_->read( reinterpret_cast<char *>( &header ), sizeof( header ) );
+uint64_t PacketReadCache::readAheadWaitCount() const
+{
+   return prefetcher_ ? prefetcher_->waitCount() : 0;
+}
 
-   // Can't verify packet header here, because it is not really an EmptyPacketHeader.
-   unsigned packetLength = header.packetLogicalLengthMinus1 + 1;
+size_t PacketReadCache::readSpan( uint64_t packetLogicalOffset )
+{
+   const size_t spanLength = spanLengthAt( packetLogicalOffset );
 
-   // Be paranoid about packetLength before read
-   if ( packetLength > DATA_PACKET_MAX )
+   if ( spanLength < sizeof( EmptyPacketHeader ) )
    {
-      throw E57_EXCEPTION2( ErrorBadCVPacket, "packetLength=" + toString( packetLength ) );
+      return 0;
    }
 
-   auto &entry = entries_.at( oldestEntry );
-
-   // Now read in whole packet into preallocated buffer_.  Note buffer is
-   cFile_->seek( packetLogicalOffset, CheckedFile::Logical );
-   cFile_->read( entry.buffer_, packetLength );
+   ++readAheadSpanCount_;
 
-   // Verify that packet is good.
-   switch ( header.packetType )
+   // Use the background read if it was for this span.
+   if ( prefetcher_ && prefetcher_->take( packetLogicalOffset, spanLength, readAheadBuffer_ ) )
    {
-      case DATA_PACKET:
-      {
-         auto dpkt = reinterpret_cast<DataPacket *>( entry.buffer_ );
+      ++prefetchedSpanCount_;
+   }
+   else
+   {
+      readAheadBuffer_.resize( spanLength );
 
-         dpkt->verify( packetLength );
-#ifdef E57_VERBOSE
-         std::cout << "  data packet:" << std::endl;
-         dpkt->dump( 4 ); //???
-#endif
-      }
-      break;
-      case INDEX_PACKET:
+      try
       {
-         auto ipkt = reinterpret_cast<IndexPacket *>( entry.buffer_ );
-
-         ipkt->verify( packetLength );
-#ifdef E57_VERBOSE
-         std::cout << "  index packet:" << std::endl;
-         ipkt->dump( 4 ); //???
-#endif
+         cFile_->readAt( packetLogicalOffset, readAheadBuffer_.data(), spanLength );
       }
-      break;
-      case EMPTY_PACKET:
+      catch ( const E57Exception & )
       {
-         auto hp = reinterpret_cast<EmptyPacketHeader *>( entry.buffer_ );
+         // Something after the requested packet may be bad (or past the end of the file), which
+         // shouldn't stop us reading the requested one.
+         return 0;
+      }
+   }
 
-         hp->verify( packetLength );
-#ifdef E57_VERBOSE
-         std::cout << "  empty packet:" << std::endl;
-         hp->dump( 4 ); //???
-#endif
+   // Each span read in the background has a buffer of the same size
+   readAheadMemory_.set( Memory::PacketCaches,
+                         readAheadBuffer_.capacity() *
+                            ( prefetcher_ ? 1 + PacketPrefetcher::cMaxSpans : 1 ) );
+
+   return spanLength;
+}
+
+unsigned PacketReadCache::spanPacketLength( size_t spanLength, uint64_t spanOffset ) const
+{
+   if ( spanOffset + sizeof( EmptyPacketHeader ) > spanLength )
+   {
+      return 0;
+   }
+
+   const auto header = reinterpret_cast<const EmptyPacketHeader *>( &readAheadBuffer_[spanOffset] );
+   const unsigned packetLength = header->packetLogicalLengthMinus1 + 1;
+
+   // Incomplete packets are read on their own when they are wanted.
+   return ( spanOffset + packetLength <= spanLength ) ? packetLength : 0;
+}
+
+void PacketReadCache::startNextSpan( uint64_t logicalOffset )
+{
+   if ( prefetcher_ )
+   {
+      const size_t spanLength = spanLengthAt( logicalOffset );
+
+      if ( spanLength >= sizeof( EmptyPacketHeader ) )
+      {
+         prefetcher_->readAhead( logicalOffset, maxSpanLength(), readAheadLimit_ );
       }
-      break;
-      default:
-         throw E57_EXCEPTION2( ErrorInternal, "packetType=" + toString( header.packetType ) );
    }
+}
+
+void PacketReadCache::loadPacket( unsigned entryIndex, uint64_t packetLogicalOffset,
+                                  const char *source, unsigned packetLength )
+{
+   auto &entry = entries_.at( entryIndex );
+
+   if ( entry.logicalOffset_ != 0 )
+   {
+      ++evictionCount_;
+   }
+
+   // Mark the entry empty until the packet is known to be good.
+   entry.logicalOffset_ = 0;
+
+   if ( source != nullptr )
+   {
+      std::memcpy( entry.buffer_, source, packetLength );
+   }
+
+   verifyPacket( entry.buffer_, packetLength, entry.bytestreamOffsets_ );
 
    entry.logicalOffset_ = packetLogicalOffset;
 
@@ -235,7 +1074,6 @@ void PacketReadCache::readPacket( unsigned oldestEntry, uint64_t packetLogicalOf
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
 void PacketReadCache::dump( int indent, std::ostream &os )
 {
-   os << space( indent ) << "lockCount: " << lockCount_ << std::endl;
    os << space( indent ) << "useCount:  " << useCount_ << std::endl;
    os << space( indent ) << "entries:" << std::endl;
    for ( unsigned i = 0; i < entries_.size(); i++ )
@@ -243,6 +1081,7 @@ void PacketReadCache::dump( int indent, std::ostream &os )
       os << space( indent ) << "entry[" << i << "]:" << std::endl;
       os << space( indent + 4 ) << "logicalOffset:  " << entries_[i].logicalOffset_ << std::endl;
       os << space( indent + 4 ) << "lastUsed:        " << entries_[i].lastUsed_ << std::endl;
+      os << space( indent + 4 ) << "lockCount:       " << entries_[i].lockCount_ << std::endl;
       if ( entries_[i].logicalOffset_ != 0 )
       {
          os << space( indent + 4 ) << "packet:" << std::endl;
@@ -288,11 +1127,33 @@ PacketLock::PacketLock( PacketReadCache *cache, unsigned cacheIndex ) :
 #endif
 }
 
+PacketLock::PacketLock( std::shared_ptr<const SharedPacket> packet ) :
+   shared_( std::move( packet ) )
+{
+}
+
+const char *PacketLock::bytestream( unsigned bytestreamNumber, unsigned &byteCount ) const
+{
+   if ( shared_ )
+   {
+      return bytestreamIn( shared_->buffer.data(), shared_->bytestreamOffsets, bytestreamNumber,
+                           byteCount );
+   }
+
+   return cache_->bytestream( cacheIndex_, bytestreamNumber, byteCount );
+}
+
 PacketLock::~PacketLock()
 {
 #ifdef E57_VERBOSE
    std::cout << "~PacketLock() called" << std::endl;
 #endif
+   // A packet of a shared cache is released with shared_
+   if ( cache_ == nullptr )
+   {
+      return;
+   }
+
    try
    {
       // Note cache must live longer than lock, this is reasonable assumption.
@@ -525,6 +1386,153 @@ void DataPacket::dump( int indent, std::ostream &os ) const
 }
 #endif
 
+//=============================================================================
+// PacketWriteQueue
+
+PacketWriteQueue::PacketWriteQueue( CheckedFile *cFile, unsigned packetCount ) : cFile_( cFile )
+{
+   if ( packetCount == 0 )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "packetCount=" + toString( packetCount ) );
+   }
+
+   packetCount = Memory::affordableCount( packetCount, 1, sizeof( DataPacket ) );
+
+   for ( unsigned i = 0; i < packetCount; ++i )
+   {
+      free_.push_back( Memory::makeAligned<DataPacket>() );
+   }
+
+   packetsMemory_ = Memory::Charge( Memory::Writers, packetCount * sizeof( DataPacket ) );
+
+   thread_ = std::thread( &PacketWriteQueue::run, this );
+}
+
+PacketWriteQueue::~PacketWriteQueue()
+{
+   {
+      std::lock_guard<std::mutex> guard( mutex_ );
+      stop_ = true;
+   }
+
+   changed_.notify_all();
+   thread_.join();
+}
+
+DataPacket &PacketWriteQueue::nextPacket()
+{
+   std::unique_lock<std::mutex> guard( mutex_ );
+
+   if ( !filling_ )
+   {
+      changed_.wait( guard, [this] { return error_ || !free_.empty(); } );
+
+      rethrowError();
+
+      filling_ = std::move( free_.back() );
+      free_.pop_back();
+   }
+
+   return *filling_;
+}
+
+void PacketWriteQueue::push( uint64_t logicalOffset, unsigned packetLength )
+{
+   {
+      std::lock_guard<std::mutex> guard( mutex_ );
+
+      rethrowError();
+
+      if ( !filling_ )
+      {
+         throw E57_EXCEPTION2( ErrorInternal, "logicalOffset=" + toString( logicalOffset ) );
+      }
+
+      Entry entry;
+      entry.packet = std::move( filling_ );
+      entry.logicalOffset = logicalOffset;
+      entry.packetLength = packetLength;
+
+      queued_.push_back( std::move( entry ) );
+   }
+
+   changed_.notify_all();
+}
+
+void PacketWriteQueue::finish()
+{
+   std::unique_lock<std::mutex> guard( mutex_ );
+
+   changed_.wait( guard, [this] { return error_ || ( queued_.empty() && !writing_ ); } );
+
+   rethrowError();
+}
+
+// Must be called with mutex_ locked.
+void PacketWriteQueue::rethrowError()
+{
+   if ( error_ )
+   {
+      std::rethrow_exception( error_ );
+   }
+}
+
+void PacketWriteQueue::run()
+{
+   std::unique_lock<std::mutex> guard( mutex_ );
+
+   while ( true )
+   {
+      changed_.wait( guard, [this] { return stop_ || !queued_.empty(); } );
+
+      if ( stop_ )
+      {
+         return;
+      }
+
+      Entry entry = std::move( queued_.front() );
+      queued_.pop_front();
+
+      writing_ = true;
+
+      guard.unlock();
+
+      std::exception_ptr error;
+
+      try
+      {
+         cFile_->seek( entry.logicalOffset );
+         cFile_->write( reinterpret_cast<const char *>( entry.packet.get() ),
+                        entry.packetLength );
+      }
+      catch ( ... )
+      {
+         error = std::current_exception();
+      }
+
+      guard.lock();
+
+      writing_ = false;
+      free_.push_back( std::move( entry.packet ) );
+
+      // After a failed write the rest of the packets are dropped, and the error is reported to
+      // the writer the next time it uses the queue.
+      if ( error && !error_ )
+      {
+         error_ = error;
+
+         for ( auto &queued : queued_ )
+         {
+            free_.push_back( std::move( queued.packet ) );
+         }
+
+         queued_.clear();
+      }
+
+      changed_.notify_all();
+   }
+}
+
 //=============================================================================
 // IndexPacket
 IndexPacket::IndexPacket()
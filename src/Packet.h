@@ -27,15 +27,26 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include "Common.h"
+#include "Memory.h"
 
 namespace e57
 {
    class CheckedFile;
    class PacketLock;
+   class PacketPrefetcher;
+   class SharedPacketCache;
+
+   struct SharedPacket;
 
    // Packet types (in a compressed vector section)
    enum
@@ -45,13 +56,89 @@ namespace e57
       EMPTY_PACKET,
    };
 
+   // Data packet flags (bitfield)
+   enum
+   {
+      // The decoders are restarted at the beginning of this packet: every bytestream starts with
+      // the first record of a chunk.
+      DATA_PACKET_FLAG_COMPRESSOR_RESTART = 1,
+   };
+
    // Maximum size of CompressedVector binary data packet
    constexpr int DATA_PACKET_MAX = ( 64 * 1024 );
 
+   // Where a chunk of a CompressedVector starts. Decoding may begin at any chunk, so they are the
+   // units for random access and for decoding in parallel.
+   struct ChunkIndexEntry
+   {
+      uint64_t recordNumber = 0;        /// first record in the chunk
+      uint64_t packetLogicalOffset = 0; /// data packet the chunk starts in
+   };
+
    class PacketReadCache
    {
    public:
-      PacketReadCache( CheckedFile *cFile, unsigned packetCount );
+      /// If @a shared is set, whole packets are kept there rather than in this cache (see
+      /// ImageFile::setSharedPacketCache()). Projected reads still use this cache.
+      PacketReadCache( CheckedFile *cFile, const PacketCacheOptions &options,
+                       std::shared_ptr<SharedPacketCache> shared = nullptr );
+      ~PacketReadCache();
+
+      /// Don't read ahead past @a logicalOffset (e.g. the end of the binary section).
+      void setReadAheadLimit( uint64_t logicalOffset );
+
+      /// Wait for any background read-ahead to finish, so the file isn't used once this returns.
+      /// Otherwise it carries on between the calls of the reader, until this is called.
+      void finishReadAhead();
+
+      /// The cache reads ahead on a thread of its own (see PacketCacheOptions::backgroundReadAhead)
+      bool readsAheadInBackground() const
+      {
+         return prefetcher_ != nullptr;
+      }
+
+      /// Only read the bytestreams whose entry in @a needed is true from data packets (if the
+      /// cache was created with PacketCacheOptions::projectedRead). Empty means all of them.
+      void setBytestreamFilter( const std::vector<bool> &needed );
+
+      /// Bytes of data packets which weren't read because of the bytestream filter
+      uint64_t skippedByteCount() const
+      {
+         return skippedByteCount_;
+      }
+
+      /// Calls to lock() which found the packet in the cache
+      uint64_t hitCount() const
+      {
+         return hitCount_;
+      }
+
+      /// Calls to lock() which had to read the packet
+      uint64_t missCount() const
+      {
+         return missCount_;
+      }
+
+      /// Packets replaced by others (the evictions of a shared cache are counted there)
+      uint64_t evictionCount() const
+      {
+         return evictionCount_;
+      }
+
+      /// Spans of packets read ahead, in the foreground or the background
+      uint64_t readAheadSpanCount() const
+      {
+         return readAheadSpanCount_;
+      }
+
+      /// Spans of packets which had already been read (or were being read) in the background
+      uint64_t prefetchedSpanCount() const
+      {
+         return prefetchedSpanCount_;
+      }
+
+      /// Times the reader had to wait for the background read-ahead
+      uint64_t readAheadWaitCount() const;
 
       std::unique_ptr<PacketLock> lock( uint64_t packetLogicalOffset,
                                         char *&pkt ); //??? pkt could be const
@@ -66,20 +153,74 @@ namespace e57
       // Only PacketLock can unlock the cache
       void unlock( unsigned cacheIndex );
 
-      void readPacket( unsigned oldestEntry, uint64_t packetLogicalOffset );
+      const char *bytestream( unsigned cacheIndex, unsigned bytestreamNumber,
+                              unsigned &byteCount ) const;
+
+      unsigned findEntry( uint64_t packetLogicalOffset ) const;
+      unsigned replaceableEntry() const;
 
+      void readPacket( unsigned entryIndex, uint64_t packetLogicalOffset );
+      void readPacketProjected( unsigned entryIndex, uint64_t packetLogicalOffset );
+      void readPacketWithReadAhead( unsigned entryIndex, uint64_t packetLogicalOffset );
+      void loadPacket( unsigned entryIndex, uint64_t packetLogicalOffset, const char *source,
+                       unsigned packetLength );
+
+      std::unique_ptr<PacketLock> lockShared( uint64_t packetLogicalOffset, char *&pkt );
+      std::shared_ptr<const SharedPacket> readShared( uint64_t packetLogicalOffset );
+
+      /// Length of the span of packets to read ahead from @a logicalOffset
+      size_t spanLengthAt( uint64_t logicalOffset ) const;
+      size_t maxSpanLength() const;
+
+      /// Read the span of packets from @a packetLogicalOffset into readAheadBuffer_ (or take it
+      /// from the background read), and return its length. Returns 0 if the packet has to be
+      /// read on its own.
+      size_t readSpan( uint64_t packetLogicalOffset );
+
+      /// Length of the packet at @a spanOffset in readAheadBuffer_, or 0 if it isn't all there.
+      unsigned spanPacketLength( size_t spanLength, uint64_t spanOffset ) const;
+
+      /// Have the spans from @a logicalOffset on read in the background, if there are any.
+      void startNextSpan( uint64_t logicalOffset );
+
+      /// The entries are in one aligned allocation, and each buffer_ starts on a cache line.
       struct CacheEntry
       {
+         alignas( Memory::cCacheLineSize ) char buffer_[DATA_PACKET_MAX]; // No need to init
          uint64_t logicalOffset_ = 0;
-         char buffer_[DATA_PACKET_MAX]; // No need to init since it's a data buffer
          unsigned lastUsed_ = 0;
+         unsigned lockCount_ = 0;
+
+         /// For a data packet, where each bytestream starts in buffer_, and where the last one
+         /// ends. Made & checked against the packet length when the packet is loaded.
+         std::vector<unsigned> bytestreamOffsets_;
       };
 
-      unsigned lockCount_ = 0;
       unsigned useCount_ = 0;
       CheckedFile *cFile_ = nullptr;
 
-      std::vector<CacheEntry> entries_;
+      PacketCachePolicy policy_;
+      unsigned readAheadCount_;
+      uint64_t readAheadLimit_ = 0;
+      Memory::AlignedVector<char> readAheadBuffer_;
+      Memory::Charge readAheadMemory_;
+
+      std::unique_ptr<PacketPrefetcher> prefetcher_; /// only set for background read-ahead
+
+      std::shared_ptr<SharedPacketCache> shared_; /// only set when sharing the file's cache
+
+      bool projectedRead_ = false;
+      std::vector<bool> neededBytestreams_; /// empty if all of them are read
+      uint64_t skippedByteCount_ = 0;
+
+      uint64_t hitCount_ = 0;
+      uint64_t missCount_ = 0;
+      uint64_t evictionCount_ = 0;
+      uint64_t readAheadSpanCount_ = 0;
+      uint64_t prefetchedSpanCount_ = 0;
+
+      Memory::AlignedVector<CacheEntry> entries_;
+      Memory::Charge entriesMemory_;
    };
 
    class PacketLock
@@ -90,14 +231,23 @@ namespace e57
       PacketLock( const PacketLock &plock ) = delete;
       PacketLock &operator=( const PacketLock &plock ) = delete;
 
+      /// Start of bytestream @a bytestreamNumber of the locked data packet, and its length in
+      /// @a byteCount. This is a lookup of the table made when the packet was loaded, rather than
+      /// DataPacket::getBytestream() which adds up the lengths of the ones before it.
+      const char *bytestream( unsigned bytestreamNumber, unsigned &byteCount ) const;
+
    protected:
       friend class PacketReadCache;
 
       /// Only PacketReadCache can construct
       PacketLock( PacketReadCache *cache, unsigned cacheIndex );
+      explicit PacketLock( std::shared_ptr<const SharedPacket> packet );
 
       PacketReadCache *cache_ = nullptr;
       unsigned int cacheIndex_ = 0;
+
+      /// Set instead of cache_ for a packet of a shared cache, which it keeps in memory
+      std::shared_ptr<const SharedPacket> shared_;
    };
 
    class DataPacketHeader
@@ -148,6 +298,58 @@ namespace e57
       uint8_t payload[PayloadSize]; // No need to init since it's a data buffer
    };
 
+   /// Writes data packets to the file on a background thread, so that writing one packet overlaps
+   /// encoding the next. The packet buffers are reused.
+   class PacketWriteQueue
+   {
+   public:
+      /// Up to @a packetCount packets (at least 1) may be waiting to be written.
+      PacketWriteQueue( CheckedFile *cFile, unsigned packetCount );
+
+      /// Stops the thread. Packets which haven't been written yet are dropped.
+      ~PacketWriteQueue();
+
+      PacketWriteQueue( const PacketWriteQueue & ) = delete;
+      PacketWriteQueue &operator=( const PacketWriteQueue & ) = delete;
+
+      /// Returns a free packet to fill in, waiting for one to be written if there are none.
+      /// Rethrows the error of a failed write.
+      DataPacket &nextPacket();
+
+      /// Queue the first @a packetLength bytes of the packet returned by nextPacket() to be written
+      /// at @a logicalOffset. Rethrows the error of a failed write.
+      void push( uint64_t logicalOffset, unsigned packetLength );
+
+      /// Wait for all the queued packets to be written. Rethrows the error of a failed write.
+      void finish();
+
+   private:
+      struct Entry
+      {
+         Memory::AlignedPtr<DataPacket> packet;
+         uint64_t logicalOffset = 0;
+         unsigned packetLength = 0;
+      };
+
+      void run();
+      void rethrowError();
+
+      CheckedFile *cFile_ = nullptr;
+
+      std::mutex mutex_;
+      std::condition_variable changed_;
+      std::thread thread_;
+
+      std::vector<Memory::AlignedPtr<DataPacket>> free_;
+      Memory::Charge packetsMemory_;
+      std::deque<Entry> queued_;
+      Memory::AlignedPtr<DataPacket> filling_; /// returned by nextPacket(), not queued yet
+
+      bool writing_ = false; /// the thread is writing the packet it took from queued_
+      bool stop_ = false;
+      std::exception_ptr error_;
+   };
+
    class IndexPacketHeader
    {
    public:
@@ -0,0 +1,470 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <system_error>
+#include <thread>
+
+#include "Parallel.h"
+
+namespace e57
+{
+   namespace
+   {
+      std::mutex gDefaultExecutorMutex;
+      TaskExecutor gDefaultExecutor;
+   }
+
+   unsigned resolveThreadCount( unsigned threadCount )
+   {
+      if ( threadCount == 0 )
+      {
+         threadCount = std::max( 1u, std::thread::hardware_concurrency() );
+      }
+
+      return threadCount;
+   }
+
+   void setDefaultTaskExecutor( TaskExecutor executor )
+   {
+      std::lock_guard<std::mutex> lock( gDefaultExecutorMutex );
+
+      gDefaultExecutor = std::move( executor );
+   }
+
+   void runTasks( const std::vector<Task> &tasks, unsigned threadCount,
+                  const TaskExecutor &executor )
+   {
+      if ( tasks.empty() )
+      {
+         return;
+      }
+
+      TaskExecutor defaultExecutor;
+
+      if ( !executor )
+      {
+         std::lock_guard<std::mutex> lock( gDefaultExecutorMutex );
+
+         defaultExecutor = gDefaultExecutor;
+      }
+
+      const TaskExecutor &cExecutor = executor ? executor : defaultExecutor;
+
+      if ( !cExecutor )
+      {
+         Scheduler::shared().run( tasks, threadCount );
+         return;
+      }
+
+      // Capture exceptions per task so the executor doesn't see them.
+      std::vector<std::exception_ptr> errors( tasks.size() );
+      std::vector<Task> wrapped;
+
+      wrapped.reserve( tasks.size() );
+
+      for ( size_t i = 0; i < tasks.size(); ++i )
+      {
+         wrapped.emplace_back( [&tasks, &errors, i]() {
+            try
+            {
+               tasks[i]();
+            }
+            catch ( ... )
+            {
+               errors[i] = std::current_exception();
+            }
+         } );
+      }
+
+      cExecutor( wrapped );
+
+      for ( const auto &error : errors )
+      {
+         if ( error )
+         {
+            std::rethrow_exception( error );
+         }
+      }
+   }
+
+   void runInBackground( Task task )
+   {
+      BackgroundThreads::shared().post( std::move( task ) );
+   }
+
+   void runAsync( Task function, AsyncCompletion completion )
+   {
+      if ( !completion )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "completion=empty" );
+      }
+
+      runInBackground( [function = std::move( function ),
+                        completion = std::move( completion )]() mutable {
+         std::exception_ptr error;
+
+         try
+         {
+            function();
+         }
+         catch ( ... )
+         {
+            error = std::current_exception();
+         }
+
+         // Release what the function holds before the completion can see it's done
+         function = nullptr;
+
+         completion( error );
+      } );
+   }
+
+   struct Scheduler::Batch
+   {
+      const std::vector<Task> *tasks = nullptr;
+      std::vector<std::exception_ptr> errors;
+      std::atomic<size_t> next{ 0 };
+
+      std::mutex mutex;
+      std::condition_variable finishedCondition;
+      size_t pendingJobs = 0; // queued or running, guarded by mutex
+   };
+
+   namespace
+   {
+      // The scheduler & queue of the current thread, if it is one of a scheduler's
+      thread_local const Scheduler *tScheduler = nullptr;
+      thread_local size_t tQueueIndex = 0;
+   }
+
+   Scheduler &Scheduler::shared()
+   {
+      // Never destroyed, so its threads aren't joined while the process exits or the library is
+      // unloaded (which deadlocks on some platforms)
+      static auto *scheduler = new Scheduler( 0 );
+
+      return *scheduler;
+   }
+
+   Scheduler::Scheduler( unsigned threadCount )
+   {
+      const unsigned workerCount = resolveThreadCount( threadCount ) - 1;
+
+      queues_.reserve( workerCount );
+      threads_.reserve( workerCount );
+
+      for ( unsigned i = 0; i < workerCount; ++i )
+      {
+         queues_.emplace_back( new Queue );
+      }
+
+      for ( unsigned i = 0; i < workerCount; ++i )
+      {
+         try
+         {
+            threads_.emplace_back( &Scheduler::workerLoop, this, i );
+         }
+         catch ( const std::system_error & )
+         {
+            // Couldn't start another thread - make do with the ones we have
+            break;
+         }
+      }
+
+      queues_.resize( threads_.size() );
+   }
+
+   Scheduler::~Scheduler()
+   {
+      {
+         std::lock_guard<std::mutex> lock( wakeMutex_ );
+         stopping_ = true;
+      }
+
+      wakeCondition_.notify_all();
+
+      for ( auto &thread : threads_ )
+      {
+         thread.join();
+      }
+   }
+
+   void Scheduler::run( const std::vector<Task> &tasks, unsigned maxThreads )
+   {
+      if ( tasks.empty() )
+      {
+         return;
+      }
+
+      if ( maxThreads == 0 )
+      {
+         maxThreads = threadCount();
+      }
+
+      Batch batch;
+      batch.tasks = &tasks;
+      batch.errors.assign( tasks.size(), nullptr );
+
+      // The calling thread is one of them
+      const size_t cJobCount = std::min<size_t>( { maxThreads, threadCount(), tasks.size() } ) - 1;
+
+      const bool cOwnThread = ( tScheduler == this );
+      const size_t cSelf = cOwnThread ? tQueueIndex : queues_.size();
+
+      if ( cJobCount > 0 )
+      {
+         batch.pendingJobs = cJobCount;
+
+         // A task's batch goes to its own queue, to be taken by idle threads from there. Other
+         // batches are spread over the queues.
+         const size_t cFirst = cOwnThread ? cSelf : nextQueue_.fetch_add( cJobCount );
+
+         for ( size_t i = 0; i < cJobCount; ++i )
+         {
+            Job job;
+            job.batch = &batch;
+
+            push( cOwnThread ? cSelf : ( cFirst + i ) % queues_.size(), std::move( job ) );
+         }
+
+         {
+            std::lock_guard<std::mutex> lock( wakeMutex_ );
+            queuedCount_ += cJobCount;
+         }
+
+         wakeCondition_.notify_all();
+      }
+
+      runBatch( batch );
+
+      // Help with the queued jobs until those of this batch have finished. If there are none
+      // left to take, ours have all been taken by threads which will finish them.
+      while ( true )
+      {
+         {
+            std::lock_guard<std::mutex> lock( batch.mutex );
+
+            if ( batch.pendingJobs == 0 )
+            {
+               break;
+            }
+         }
+
+         if ( !runJob( cSelf ) )
+         {
+            std::unique_lock<std::mutex> lock( batch.mutex );
+
+            batch.finishedCondition.wait( lock, [&batch]() { return batch.pendingJobs == 0; } );
+            break;
+         }
+      }
+
+      for ( const auto &error : batch.errors )
+      {
+         if ( error )
+         {
+            std::rethrow_exception( error );
+         }
+      }
+   }
+
+   void Scheduler::push( size_t queueIndex, Job job )
+   {
+      Queue &queue = *queues_[queueIndex];
+
+      std::lock_guard<std::mutex> lock( queue.mutex );
+      queue.jobs.push_back( std::move( job ) );
+   }
+
+   void Scheduler::workerLoop( size_t index )
+   {
+      tScheduler = this;
+      tQueueIndex = index;
+
+      while ( true )
+      {
+         if ( runJob( index ) )
+         {
+            continue;
+         }
+
+         std::unique_lock<std::mutex> lock( wakeMutex_ );
+
+         wakeCondition_.wait( lock, [this]() { return stopping_ || ( queuedCount_ > 0 ); } );
+
+         if ( stopping_ )
+         {
+            return;
+         }
+      }
+   }
+
+   bool Scheduler::runJob( size_t self )
+   {
+      const size_t cQueueCount = queues_.size();
+
+      Job job;
+      bool found = false;
+
+      if ( self < cQueueCount )
+      {
+         Queue &queue = *queues_[self];
+
+         std::lock_guard<std::mutex> lock( queue.mutex );
+
+         if ( !queue.jobs.empty() )
+         {
+            job = std::move( queue.jobs.back() );
+            queue.jobs.pop_back();
+            --queuedCount_;
+            found = true;
+         }
+      }
+
+      // Steal the oldest job of another thread, starting with the next one
+      for ( size_t i = 1; !found && ( i <= cQueueCount ); ++i )
+      {
+         Queue &queue = *queues_[( self + i ) % cQueueCount];
+
+         std::lock_guard<std::mutex> lock( queue.mutex );
+
+         if ( !queue.jobs.empty() )
+         {
+            job = std::move( queue.jobs.front() );
+            queue.jobs.pop_front();
+            --queuedCount_;
+            found = true;
+         }
+      }
+
+      if ( !found )
+      {
+         return false;
+      }
+
+      Batch &batch = *job.batch;
+
+      runBatch( batch );
+
+      // The batch may be gone as soon as the lock is released
+      std::lock_guard<std::mutex> lock( batch.mutex );
+
+      if ( --batch.pendingJobs == 0 )
+      {
+         batch.finishedCondition.notify_all();
+      }
+
+      return true;
+   }
+
+   void Scheduler::runBatch( Batch &batch )
+   {
+      const std::vector<Task> &tasks = *batch.tasks;
+
+      for ( size_t i = batch.next++; i < tasks.size(); i = batch.next++ )
+      {
+         try
+         {
+            tasks[i]();
+         }
+         catch ( ... )
+         {
+            batch.errors[i] = std::current_exception();
+         }
+      }
+   }
+
+   BackgroundThreads &BackgroundThreads::shared()
+   {
+      // Never destroyed, for the same reason as Scheduler::shared()
+      static auto *threads = new BackgroundThreads( cSharedThreadCount );
+
+      return *threads;
+   }
+
+   BackgroundThreads::BackgroundThreads( unsigned maxThreads ) :
+      maxThreads_( std::max( maxThreads, 1u ) )
+   {
+   }
+
+   BackgroundThreads::~BackgroundThreads()
+   {
+      {
+         std::lock_guard<std::mutex> lock( mutex_ );
+         stopping_ = true;
+      }
+
+      wakeCondition_.notify_all();
+
+      for ( auto &thread : threads_ )
+      {
+         thread.join();
+      }
+   }
+
+   void BackgroundThreads::post( Task task )
+   {
+      std::unique_lock<std::mutex> lock( mutex_ );
+
+      tasks_.push_back( std::move( task ) );
+
+      // Start another thread if all those there are are busy
+      if ( ( idleCount_ < tasks_.size() ) && ( threads_.size() < maxThreads_ ) )
+      {
+         try
+         {
+            threads_.emplace_back( &BackgroundThreads::threadLoop, this );
+         }
+         catch ( const std::system_error & )
+         {
+            // The threads there are will get to it, but without any the task would never run
+            if ( threads_.empty() )
+            {
+               tasks_.pop_back();
+               throw;
+            }
+         }
+      }
+
+      lock.unlock();
+
+      wakeCondition_.notify_one();
+   }
+
+   void BackgroundThreads::threadLoop()
+   {
+      std::unique_lock<std::mutex> lock( mutex_ );
+
+      while ( true )
+      {
+         ++idleCount_;
+         wakeCondition_.wait( lock, [this]() { return stopping_ || !tasks_.empty(); } );
+         --idleCount_;
+
+         if ( tasks_.empty() )
+         {
+            return; // stopping, with nothing left to run
+         }
+
+         Task task = std::move( tasks_.front() );
+         tasks_.pop_front();
+
+         lock.unlock();
+
+         try
+         {
+            task();
+         }
+         catch ( ... )
+         {
+         }
+
+         // Free what the task holds before waiting for the next one
+         task = nullptr;
+
+         lock.lock();
+      }
+   }
+}
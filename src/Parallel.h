@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Common.h"
+
+namespace e57
+{
+   using Task = std::function<void()>;
+
+   /// Returns @a threadCount, or std::thread::hardware_concurrency() if it is 0.
+   unsigned resolveThreadCount( unsigned threadCount );
+
+   /// Run all @a tasks and return once they have all finished.
+   ///
+   /// If @a executor is set, the tasks are handed to it, or else to the one set with
+   /// setDefaultTaskExecutor(). Otherwise they are run by the shared Scheduler on up to
+   /// @a threadCount threads (0 means all of them), one of which is the calling thread.
+   ///
+   /// If any tasks throw, the exception from the first of them (in the order given) is rethrown
+   /// after all the tasks have finished.
+   void runTasks( const std::vector<Task> &tasks, unsigned threadCount,
+                  const TaskExecutor &executor = {} );
+
+   /// Run @a task on the shared BackgroundThreads & return straight away. The task is never run
+   /// on the calling thread.
+   void runInBackground( Task task );
+
+   /// Calls a function, destroys it (and so what it captured), then sets the promise. Done in
+   /// that order so nothing the function holds outlives the caller seeing its result.
+   template <typename Result> struct AsyncCall
+   {
+      template <typename Function>
+      static void run( std::unique_ptr<Function> function, std::promise<Result> &promise )
+      {
+         try
+         {
+            Result result = ( *function )();
+            function.reset();
+            promise.set_value( std::move( result ) );
+         }
+         catch ( ... )
+         {
+            function.reset();
+            promise.set_exception( std::current_exception() );
+         }
+      }
+   };
+
+   template <> struct AsyncCall<void>
+   {
+      template <typename Function>
+      static void run( std::unique_ptr<Function> function, std::promise<void> &promise )
+      {
+         try
+         {
+            ( *function )();
+            function.reset();
+            promise.set_value();
+         }
+         catch ( ... )
+         {
+            function.reset();
+            promise.set_exception( std::current_exception() );
+         }
+      }
+   };
+
+   /// Run @a function in the background. The future holds its result, or the exception it threw.
+   /// @a function is destroyed before the future is ready.
+   template <typename Function>
+   auto runAsync( Function function ) -> std::future<decltype( function() )>
+   {
+      using Result = decltype( function() );
+
+      struct State
+      {
+         std::unique_ptr<Function> function;
+         std::promise<Result> promise;
+      };
+
+      auto state = std::make_shared<State>();
+      state->function.reset( new Function( std::move( function ) ) );
+
+      auto future = state->promise.get_future();
+
+      runInBackground(
+         [state]() { AsyncCall<Result>::run( std::move( state->function ), state->promise ); } );
+
+      return future;
+   }
+
+   /// Run @a function in the background, then @a completion with the exception it threw (or
+   /// nullptr). @a function is destroyed before @a completion is called. Throws
+   /// ErrorBadAPIArgument if there is no @a completion.
+   void runAsync( Task function, AsyncCompletion completion );
+
+   /// The threads shared by all the parallel work of the library, so several readers & writers
+   /// in one process don't each start their own.
+   ///
+   /// Each thread has its own queue. A batch is spread over the queues, with the tasks pushed by
+   /// a task going to the queue of its own thread; a thread with nothing left takes the oldest
+   /// job of the others. The thread which runs a batch works on it (and on any other queued jobs)
+   /// until the batch is finished, so tasks may run batches of their own.
+   class Scheduler
+   {
+   public:
+      /// The scheduler used by runTasks(), with std::thread::hardware_concurrency() - 1 threads,
+      /// started the first time it is used.
+      static Scheduler &shared();
+
+      /// Start @a threadCount - 1 threads (0 means std::thread::hardware_concurrency()). The
+      /// threads which call run() make up the last one.
+      explicit Scheduler( unsigned threadCount );
+      ~Scheduler();
+
+      Scheduler( const Scheduler & ) = delete;
+      Scheduler &operator=( const Scheduler & ) = delete;
+
+      /// Number of threads which may run tasks at once, including the calling thread.
+      unsigned threadCount() const
+      {
+         return static_cast<unsigned>( threads_.size() + 1 );
+      }
+
+      /// Run all @a tasks on up to @a maxThreads threads (0 means threadCount()), including the
+      /// calling thread, and return once they have all finished. Exceptions are handled the same
+      /// way as runTasks(). May be called from several threads at once.
+      void run( const std::vector<Task> &tasks, unsigned maxThreads = 0 );
+
+   private:
+      /// Tasks being run by one call of run()
+      struct Batch;
+
+      /// Runs tasks of its batch until there are none left
+      struct Job
+      {
+         Batch *batch = nullptr;
+      };
+
+      /// The thread of the queue takes its jobs from the back, the others from the front.
+      struct Queue
+      {
+         std::mutex mutex;
+         std::deque<Job> jobs;
+      };
+
+      void push( size_t queueIndex, Job job );
+
+      void workerLoop( size_t index );
+
+      /// Take a job from the queue of thread @a self (if it has one) or another one & run it.
+      /// Returns false if there were none.
+      bool runJob( size_t self );
+
+      static void runBatch( Batch &batch );
+
+      std::vector<std::unique_ptr<Queue>> queues_; // one per thread
+      std::vector<std::thread> threads_;
+      std::atomic<size_t> nextQueue_{ 0 };
+
+      // Guards waking the threads; queuedCount_ is only raised with it held
+      std::mutex wakeMutex_;
+      std::condition_variable wakeCondition_;
+      std::atomic<size_t> queuedCount_{ 0 };
+      bool stopping_ = false;
+   };
+
+   /// The threads which run the asynchronous operations (see runInBackground()). They are kept
+   /// apart from the Scheduler, since the operations block on I/O and would hold up its parallel
+   /// decoding & encoding.
+   ///
+   /// The tasks are run in the order they are posted, on up to a fixed number of threads which are
+   /// started as they are needed. A task is never run by the thread which posts it, even if there
+   /// is only one thread.
+   class BackgroundThreads
+   {
+   public:
+      /// The threads used by runInBackground(), up to cSharedThreadCount of them.
+      static BackgroundThreads &shared();
+
+      static constexpr unsigned cSharedThreadCount = 8;
+
+      /// Run the tasks on up to @a maxThreads threads (at least 1).
+      explicit BackgroundThreads( unsigned maxThreads );
+
+      /// Waits for the tasks already posted to finish.
+      ~BackgroundThreads();
+
+      BackgroundThreads( const BackgroundThreads & ) = delete;
+      BackgroundThreads &operator=( const BackgroundThreads & ) = delete;
+
+      unsigned maxThreads() const
+      {
+         return maxThreads_;
+      }
+
+      /// Queue @a task to run on one of the threads & return straight away. The task shouldn't
+      /// throw; if it does the exception is dropped. Throws std::system_error if no thread could be
+      /// started to run it.
+      void post( Task task );
+
+   private:
+      void threadLoop();
+
+      const unsigned maxThreads_;
+
+      std::mutex mutex_;
+      std::condition_variable wakeCondition_;
+      std::deque<Task> tasks_;
+      std::vector<std::thread> threads_;
+      unsigned idleCount_ = 0; /// threads waiting for a task
+      bool stopping_ = false;
+   };
+}
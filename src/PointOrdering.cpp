@@ -0,0 +1,238 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "PointOrdering.h"
+
+namespace e57
+{
+   namespace PointOrdering
+   {
+      namespace
+      {
+         constexpr uint32_t cCellMaximum = ( 1u << cBitsPerAxis ) - 1;
+
+         // Interleave the bits of the three coordinates, the most significant bit of @a a first
+         uint64_t interleave( uint32_t a, uint32_t b, uint32_t c )
+         {
+            uint64_t key = 0;
+
+            for ( unsigned bit = cBitsPerAxis; bit-- > 0; )
+            {
+               key = ( key << 3 ) | ( static_cast<uint64_t>( ( a >> bit ) & 1 ) << 2 ) |
+                     ( static_cast<uint64_t>( ( b >> bit ) & 1 ) << 1 ) |
+                     static_cast<uint64_t>( ( c >> bit ) & 1 );
+            }
+
+            return key;
+         }
+
+         // The coordinates of point @a i, converted to cartesian ones for spherical points. Returns
+         // false if the point has an invalid state or a NaN coordinate.
+         template <typename COORDTYPE>
+         bool coordinates( const Data3DPointsData_t<COORDTYPE> &buffers, bool cartesian,
+                           size_t i, double ( &point )[3] )
+         {
+            if ( cartesian )
+            {
+               if ( ( buffers.cartesianInvalidState != nullptr ) &&
+                    ( buffers.cartesianInvalidState[i] != 0 ) )
+               {
+                  return false;
+               }
+
+               point[0] = buffers.cartesianX[i];
+               point[1] = buffers.cartesianY[i];
+               point[2] = buffers.cartesianZ[i];
+            }
+            else
+            {
+               if ( ( buffers.sphericalInvalidState != nullptr ) &&
+                    ( buffers.sphericalInvalidState[i] != 0 ) )
+               {
+                  return false;
+               }
+
+               const double cRange = buffers.sphericalRange[i];
+               const double cAzimuth = buffers.sphericalAzimuth[i];
+               const double cElevation = buffers.sphericalElevation[i];
+               const double cRadial = cRange * std::cos( cElevation );
+
+               point[0] = cRadial * std::cos( cAzimuth );
+               point[1] = cRadial * std::sin( cAzimuth );
+               point[2] = cRange * std::sin( cElevation );
+            }
+
+            return !std::isnan( point[0] ) && !std::isnan( point[1] ) && !std::isnan( point[2] );
+         }
+
+         uint32_t cell( double value, double minimum, double maximum )
+         {
+            if ( !( maximum > minimum ) )
+            {
+               return 0;
+            }
+
+            const double cCell = ( value - minimum ) / ( maximum - minimum ) * cCellMaximum;
+
+            return static_cast<uint32_t>( std::min( std::max( cCell, 0.0 ),
+                                                    static_cast<double>( cCellMaximum ) ) );
+         }
+      }
+
+      uint64_t mortonKey( uint32_t x, uint32_t y, uint32_t z )
+      {
+         return interleave( x, y, z );
+      }
+
+      // Skilling's transform of the axes to the "transposed" Hilbert index, whose bits are then
+      // interleaved (J. Skilling, "Programming the Hilbert curve", AIP Conf. Proc. 707, 2004).
+      uint64_t hilbertKey( uint32_t x, uint32_t y, uint32_t z )
+      {
+         uint32_t axes[3] = { x, y, z };
+
+         // Inverse undo
+         for ( uint32_t q = 1u << ( cBitsPerAxis - 1 ); q > 1; q >>= 1 )
+         {
+            const uint32_t cMask = q - 1;
+
+            for ( uint32_t &axis : axes )
+            {
+               if ( ( axis & q ) != 0 )
+               {
+                  axes[0] ^= cMask;
+               }
+               else
+               {
+                  const uint32_t cSwap = ( axes[0] ^ axis ) & cMask;
+
+                  axes[0] ^= cSwap;
+                  axis ^= cSwap;
+               }
+            }
+         }
+
+         // Gray encode
+         axes[1] ^= axes[0];
+         axes[2] ^= axes[1];
+
+         uint32_t flip = 0;
+
+         for ( uint32_t q = 1u << ( cBitsPerAxis - 1 ); q > 1; q >>= 1 )
+         {
+            if ( ( axes[2] & q ) != 0 )
+            {
+               flip ^= q - 1;
+            }
+         }
+
+         return interleave( axes[0] ^ flip, axes[1] ^ flip, axes[2] ^ flip );
+      }
+
+      const char *curveName( PointOrder order )
+      {
+         return ( order == PointOrderHilbert ) ? "hilbert" : "morton";
+      }
+
+      template <typename COORDTYPE>
+      std::vector<PointKey> sortedKeys( const Data3DPointsData_t<COORDTYPE> &buffers, size_t count,
+                                        PointOrder order, Box &box )
+      {
+         const bool cCartesian = ( buffers.cartesianX != nullptr ) &&
+                                 ( buffers.cartesianY != nullptr ) &&
+                                 ( buffers.cartesianZ != nullptr );
+         const bool cSpherical = ( buffers.sphericalRange != nullptr ) &&
+                                 ( buffers.sphericalAzimuth != nullptr ) &&
+                                 ( buffers.sphericalElevation != nullptr );
+
+         if ( !cCartesian && !cSpherical )
+         {
+            return {};
+         }
+
+         box = Box();
+
+         for ( int axis = 0; axis < 3; ++axis )
+         {
+            box.minimum[axis] = std::numeric_limits<double>::max();
+            box.maximum[axis] = std::numeric_limits<double>::lowest();
+         }
+
+         double point[3];
+
+         for ( size_t i = 0; i < count; ++i )
+         {
+            if ( coordinates( buffers, cCartesian, i, point ) )
+            {
+               for ( int axis = 0; axis < 3; ++axis )
+               {
+                  box.minimum[axis] = std::min( box.minimum[axis], point[axis] );
+                  box.maximum[axis] = std::max( box.maximum[axis], point[axis] );
+               }
+            }
+         }
+
+         // Keys of valid points use 63 bits, so the invalid ones sort after all of them. Ties are
+         // broken by the index, which keeps their original order.
+         std::vector<PointKey> keys( count );
+
+         for ( size_t i = 0; i < count; ++i )
+         {
+            uint64_t key = cInvalidKey;
+
+            if ( coordinates( buffers, cCartesian, i, point ) )
+            {
+               const uint32_t cX = cell( point[0], box.minimum[0], box.maximum[0] );
+               const uint32_t cY = cell( point[1], box.minimum[1], box.maximum[1] );
+               const uint32_t cZ = cell( point[2], box.minimum[2], box.maximum[2] );
+
+               key = ( order == PointOrderHilbert ) ? hilbertKey( cX, cY, cZ )
+                                                    : mortonKey( cX, cY, cZ );
+            }
+
+            keys[i] = { key, i };
+         }
+
+         std::sort( keys.begin(), keys.end() );
+
+         // No valid points
+         if ( box.minimum[0] > box.maximum[0] )
+         {
+            box = Box();
+         }
+
+         return keys;
+      }
+
+      template <typename COORDTYPE>
+      std::vector<size_t> sort( const Data3DPointsData_t<COORDTYPE> &buffers, size_t count,
+                                PointOrder order, Box &box )
+      {
+         const std::vector<PointKey> cKeys = sortedKeys( buffers, count, order, box );
+
+         std::vector<size_t> indices( cKeys.size() );
+
+         for ( size_t i = 0; i < cKeys.size(); ++i )
+         {
+            indices[i] = cKeys[i].second;
+         }
+
+         return indices;
+      }
+
+      // Explicit template instantiation
+      template std::vector<PointKey> sortedKeys( const Data3DPointsData_t<float> &buffers,
+                                                 size_t count, PointOrder order, Box &box );
+
+      template std::vector<PointKey> sortedKeys( const Data3DPointsData_t<double> &buffers,
+                                                 size_t count, PointOrder order, Box &box );
+
+      template std::vector<size_t> sort( const Data3DPointsData_t<float> &buffers, size_t count,
+                                         PointOrder order, Box &box );
+
+      template std::vector<size_t> sort( const Data3DPointsData_t<double> &buffers, size_t count,
+                                         PointOrder order, Box &box );
+   }
+}
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <limits>
+
+#include "Common.h"
+#include "E57SimpleData.h"
+#include "E57SimpleWriter.h"
+
+namespace e57
+{
+   /// Sorting of the points of a scan along a space-filling curve (see WriterOptions::pointOrder)
+   namespace PointOrdering
+   {
+      /// URI of the extension which records the order of the points of a scan
+      constexpr char cPointOrderUri[] =
+         "https://github.com/asmaloney/libE57Format/E57_EXT_point_order";
+
+      /// Prefix used for the extension if the file doesn't already declare one for it
+      constexpr char cPointOrderPrefix[] = "libe57po";
+
+      /// Name of the structure, in the scan, describing the order of its points
+      constexpr char cPointOrderElement[] = "pointOrder";
+
+      /// Number of bits of each coordinate in the key of a point
+      constexpr unsigned cBitsPerAxis = 21;
+
+      /// Key of the points with an invalid state or no coordinates, after those of all the others
+      constexpr uint64_t cInvalidKey = std::numeric_limits<uint64_t>::max();
+
+      /// Key of a point along the curve & index of the point in its buffers
+      using PointKey = std::pair<uint64_t, size_t>;
+
+      /// Box the coordinates are fitted to before they are quantized to cBitsPerAxis bits
+      struct Box
+      {
+         double minimum[3] = { 0.0, 0.0, 0.0 };
+         double maximum[3] = { 0.0, 0.0, 0.0 };
+      };
+
+      /// Position of the cell @a x, @a y, @a z along a Morton curve
+      uint64_t mortonKey( uint32_t x, uint32_t y, uint32_t z );
+
+      /// Position of the cell @a x, @a y, @a z along a Hilbert curve
+      uint64_t hilbertKey( uint32_t x, uint32_t y, uint32_t z );
+
+      /// Name of @a order in the extension
+      const char *curveName( PointOrder order );
+
+      /// Keys of the first @a count points of @a buffers along the curve of @a order, sorted (the
+      /// ties by index). @a box is set to the box around the valid points. Returns an empty
+      /// vector if @a buffers have no coordinates.
+      template <typename COORDTYPE>
+      std::vector<PointKey> sortedKeys( const Data3DPointsData_t<COORDTYPE> &buffers, size_t count,
+                                        PointOrder order, Box &box );
+
+      /// Indices of the first @a count points of @a buffers in @a order. Points with an invalid
+      /// state or no coordinates come last, in their original order. @a box is set to the box
+      /// around the valid points. Returns an empty vector if @a buffers have no coordinates.
+      template <typename COORDTYPE>
+      std::vector<size_t> sort( const Data3DPointsData_t<COORDTYPE> &buffers, size_t count,
+                                PointOrder order, Box &box );
+   }
+}
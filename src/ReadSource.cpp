@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: BSL-1.0
+
+/// @file ReadSource.cpp
+
+#include "Common.h"
+
+using namespace e57;
+
+/*!
+@class e57::ReadSource
+@brief Interface for reading an E57 file from somewhere other than a local file.
+
+@details
+Implement this to open an ImageFile (or a Reader) from object storage with HTTP range requests, or
+from any other store which can read a range of bytes at a given offset. The file is never read
+sequentially: every read is a positional range read, and the small reads of the pages of the file
+go through a cache of large blocks (see blockSize() and blockCount()), so opening a file and reading
+one scan only fetches the blocks holding its header, XML section and data.
+
+Reads may come from several threads at once (e.g. with Reader::ReadData3DParallel), so readAt()
+must be thread-safe. The source is shared by the ImageFile, which keeps it until it is closed.
+
+@see ImageFile::ImageFile(std::shared_ptr<ReadSource>, ReadChecksumPolicy, XmlLoadMode)
+*/
+
+ReadSource::~ReadSource() = default;
+
+/*!
+@fn uint64_t ReadSource::size()
+@brief Get the size of the file in bytes.
+
+@details This is called once when the file is opened.
+*/
+
+/*!
+@fn void ReadSource::readAt( uint64_t offset, char *buffer, size_t count )
+@brief Read @a count bytes starting at byte @a offset of the file into @a buffer.
+
+@details All of the bytes must be read, or an exception thrown. Exceptions other than E57Exception
+are reported as ::ErrorReadFailed. This may be called from several threads at once.
+*/
+
+/*!
+@brief Get the name of the file for the error messages, e.g. its URL.
+*/
+ustring ReadSource::name() const
+{
+   return "<ReadSource>";
+}
+
+/*!
+@brief Get the size in bytes of the blocks the file is read in.
+
+@details Reads smaller than a block fetch the whole block(s) holding them, and the most recently
+used blocks are kept, so a high latency source should use large blocks. Larger reads go straight
+to the source. With 0 every read goes straight to the source.
+
+The default is 1 MB.
+*/
+size_t ReadSource::blockSize() const
+{
+   return 1 << 20;
+}
+
+/*!
+@brief Get the number of the most recently used blocks kept (see blockSize()).
+
+@details The default is 16.
+*/
+size_t ReadSource::blockCount() const
+{
+   return 16;
+}
@@ -26,62 +26,86 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
-#include "ReaderImpl.h"
+#include <algorithm>
+#include <exception>
+#include <numeric>
+
 #include "Common.h"
+#include "BlobNodeImpl.h"
+#include "CoordinateKernels.h"
+#include "InterleavedBuffers.h"
+#include "LevelOfDetail.h"
+#include "Parallel.h"
+#include "ReaderImpl.h"
 #include "StringFunctions.h"
 
 namespace e57
 {
    /*!
-   @brief Reads the data out of a given image node
+   @brief Gets the path of the blob holding one image of an Image2D
 
-   @param [in] image 1 of 3 projects or the visual
+   @param [in] image the Image2D
+   @param [in] imageProjection identifies the projection desired.
    @param [in] imageType identifies the image format desired.
-   @param [out] pBuffer pointer the buffer
-   @param [out] start position in the block to start reading
-   @param [out] count size of desired chunk or buffer size
 
-   @return number of bytes read
+   @return the path relative to @a image, or an empty string if the image isn't there
    */
-   size_t _readImage2DNode( const StructureNode &image, Image2DType imageType, uint8_t *pBuffer,
-                            int64_t start, size_t count )
+   ustring _image2DBlobPath( const StructureNode &image, Image2DProjection imageProjection,
+                             Image2DType imageType )
    {
-      size_t transferred = 0;
+      const char *representationName = nullptr;
+
+      switch ( imageProjection )
+      {
+         case ProjectionNone:
+            return {};
+
+         case ProjectionVisual:
+            representationName = "visualReferenceRepresentation";
+            break;
+
+         case ProjectionPinhole:
+            representationName = "pinholeRepresentation";
+            break;
+
+         case ProjectionSpherical:
+            representationName = "sphericalRepresentation";
+            break;
+
+         case ProjectionCylindrical:
+            representationName = "cylindricalRepresentation";
+            break;
+      }
+
+      const char *blobName = nullptr;
 
       switch ( imageType )
       {
          case ImageNone:
-            return 0;
+            return {};
 
          case ImageJPEG:
-            if ( image.isDefined( "jpegImage" ) )
-            {
-               BlobNode jpegImage( image.get( "jpegImage" ) );
-               jpegImage.read( pBuffer, start, count );
-               transferred = count;
-            }
+            blobName = "jpegImage";
             break;
 
          case ImagePNG:
-            if ( image.isDefined( "pngImage" ) )
-            {
-               BlobNode pngImage( image.get( "pngImage" ) );
-               pngImage.read( pBuffer, start, count );
-               transferred = count;
-            }
+            blobName = "pngImage";
             break;
 
          case ImageMaskPNG:
-            if ( image.isDefined( "imageMask" ) )
-            {
-               BlobNode imageMask( image.get( "imageMask" ) );
-               imageMask.read( pBuffer, start, count );
-               transferred = count;
-            }
+            blobName = "imageMask";
             break;
       }
 
-      return transferred;
+      if ( ( representationName == nullptr ) || ( blobName == nullptr ) ||
+           !image.isDefined( representationName ) )
+      {
+         return {};
+      }
+
+      const ustring cPath = ustring( representationName ) + "/" + blobName;
+
+      return image.isDefined( cPath ) ? cPath : ustring();
    }
 
    /*!
@@ -188,18 +212,125 @@ namespace e57
       }
    }
 
+   /*!
+   @brief Reads the pose of a scan or image, if it has one
+
+   @param [in] node the Data3D or Image2D
+   @param [out] pose the pose, left alone if @a node has none
+   */
+   static void _readPose( const StructureNode &node, RigidBodyTransform &pose )
+   {
+      if ( !node.isDefined( "pose" ) )
+      {
+         return;
+      }
+
+      const StructureNode poseNode( node.get( "pose" ) );
+
+      if ( poseNode.isDefined( "rotation" ) )
+      {
+         const StructureNode rotation( poseNode.get( "rotation" ) );
+
+         pose.rotation.w = FloatNode( rotation.get( "w" ) ).value();
+         pose.rotation.x = FloatNode( rotation.get( "x" ) ).value();
+         pose.rotation.y = FloatNode( rotation.get( "y" ) ).value();
+         pose.rotation.z = FloatNode( rotation.get( "z" ) ).value();
+      }
+
+      if ( poseNode.isDefined( "translation" ) )
+      {
+         const StructureNode translation( poseNode.get( "translation" ) );
+
+         pose.translation.x = FloatNode( translation.get( "x" ) ).value();
+         pose.translation.y = FloatNode( translation.get( "y" ) ).value();
+         pose.translation.z = FloatNode( translation.get( "z" ) ).value();
+      }
+   }
+
+   /*!
+   @brief Gets the affine transform which applies a pose to points
+
+   @param [in] pose the pose
+   @param [out] transform the transform, with the default cartesian field names
+   */
+   static void _poseTransform( const RigidBodyTransform &pose, CoordinateTransform &transform )
+   {
+      const double w = pose.rotation.w;
+      const double x = pose.rotation.x;
+      const double y = pose.rotation.y;
+      const double z = pose.rotation.z;
+
+      // Normalize the quaternion as part of the conversion
+      const double norm = w * w + x * x + y * y + z * z;
+      const double s = ( norm > 0.0 ) ? 2.0 / norm : 0.0;
+
+      double( &m )[3][4] = transform.matrix;
+
+      m[0][0] = 1.0 - s * ( y * y + z * z );
+      m[0][1] = s * ( x * y - z * w );
+      m[0][2] = s * ( x * z + y * w );
+      m[0][3] = pose.translation.x;
+
+      m[1][0] = s * ( x * y + z * w );
+      m[1][1] = 1.0 - s * ( x * x + z * z );
+      m[1][2] = s * ( y * z - x * w );
+      m[1][3] = pose.translation.y;
+
+      m[2][0] = s * ( x * z - y * w );
+      m[2][1] = s * ( y * z + x * w );
+      m[2][2] = 1.0 - s * ( x * x + y * y );
+      m[2][3] = pose.translation.z;
+   }
+
    ReaderImpl::ReaderImpl( const ustring &filePath, const ReaderOptions &options ) :
-      imf_( filePath, "r", options.checksumPolicy ), root_( imf_.root() ),
+      ReaderImpl( ImageFile( filePath, "r", options.checksumPolicy, options.readBackend,
+                             options.fileCache, options.xmlLoad ),
+                  options )
+   {
+   }
+
+   ReaderImpl::ReaderImpl( const char *buffer, uint64_t size, const ReaderOptions &options ) :
+      ReaderImpl( ImageFile( buffer, size, options.checksumPolicy ), options )
+   {
+   }
+
+   ReaderImpl::ReaderImpl( std::shared_ptr<ReadSource> source, const ReaderOptions &options ) :
+      ReaderImpl( ImageFile( std::move( source ), options.checksumPolicy, options.xmlLoad ),
+                  options )
+   {
+   }
+
+   ReaderImpl::ReaderImpl( const ImageFile &imf, const ReaderOptions &options ) :
+      imf_( imf ), root_( imf_.root() ),
       data3D_( root_.isDefined( "/data3D" ) ? root_.get( "/data3D" ) : VectorNode( imf_ ) ),
-      images2D_( root_.isDefined( "/images2D" ) ? root_.get( "/images2D" ) : VectorNode( imf_ ) )
+      images2D_( root_.isDefined( "/images2D" ) ? root_.get( "/images2D" ) : VectorNode( imf_ ) ),
+      packetCacheOptions_( options.packetCache ), applyPose_( options.applyPose ),
+      sphericalToCartesian_( options.sphericalToCartesian ),
+      trustedInput_( options.trustedInput ), validPointsOnly_( options.validPointsOnly )
    {
+      if ( options.checksumVerification != ChecksumVerifyInline )
+      {
+         imf_.setChecksumVerification( options.checksumVerification );
+      }
+
+      if ( options.sharedPacketCacheBytes > 0 )
+      {
+         imf_.setSharedPacketCache( options.sharedPacketCacheBytes );
+      }
    }
 
    ReaderImpl::~ReaderImpl()
    {
       if ( IsOpen() )
       {
-         Close();
+         // A deferred checksum failure can't be reported from here
+         try
+         {
+            Close();
+         }
+         catch ( ... )
+         {
+         }
       }
    }
 
@@ -332,28 +463,7 @@ namespace e57
       }
 
       // Get pose structure for scan.
-      if ( image.isDefined( "pose" ) )
-      {
-         const StructureNode pose( image.get( "pose" ) );
-
-         if ( pose.isDefined( "rotation" ) )
-         {
-            const StructureNode rotation( pose.get( "rotation" ) );
-
-            image2DHeader.pose.rotation.w = FloatNode( rotation.get( "w" ) ).value();
-            image2DHeader.pose.rotation.x = FloatNode( rotation.get( "x" ) ).value();
-            image2DHeader.pose.rotation.y = FloatNode( rotation.get( "y" ) ).value();
-            image2DHeader.pose.rotation.z = FloatNode( rotation.get( "z" ) ).value();
-         }
-         if ( pose.isDefined( "translation" ) )
-         {
-            const StructureNode translation( pose.get( "translation" ) );
-
-            image2DHeader.pose.translation.x = FloatNode( translation.get( "x" ) ).value();
-            image2DHeader.pose.translation.y = FloatNode( translation.get( "y" ) ).value();
-            image2DHeader.pose.translation.z = FloatNode( translation.get( "z" ) ).value();
-         }
-      }
+      _readPose( image, image2DHeader.pose );
 
       if ( image.isDefined( "visualReferenceRepresentation" ) )
       {
@@ -562,55 +672,118 @@ namespace e57
       }
 
       const StructureNode image( images2D_.get( imageIndex ) );
+      const ustring cPath = _image2DBlobPath( image, imageProjection, imageType );
 
-      switch ( imageProjection )
+      if ( cPath.empty() )
       {
-         case ProjectionNone:
-            return 0;
+         return 0;
+      }
 
-         case ProjectionVisual:
-            if ( image.isDefined( "visualReferenceRepresentation" ) )
-            {
-               const StructureNode visualReferenceRepresentation(
-                  image.get( "visualReferenceRepresentation" ) );
+      BlobNode blob( image.get( cPath ) );
+      blob.read( pBuffer, start, count );
 
-               return _readImage2DNode( visualReferenceRepresentation, imageType, pBuffer, start,
-                                        count );
-            }
-            break;
+      return count;
+   }
 
-         case ProjectionPinhole:
-            if ( image.isDefined( "pinholeRepresentation" ) )
-            {
-               const StructureNode pinholeRepresentation( image.get( "pinholeRepresentation" ) );
+   bool ReaderImpl::ViewImage2DData( int64_t imageIndex, Image2DProjection imageProjection,
+                                     Image2DType imageType, BlobView &view ) const
+   {
+      if ( !IsOpen() || ( imageIndex < 0 ) || ( imageIndex >= images2D_.childCount() ) )
+      {
+         return false;
+      }
 
-               return _readImage2DNode( pinholeRepresentation, imageType, pBuffer, start, count );
-            }
-            break;
+      const StructureNode image( images2D_.get( imageIndex ) );
+      const ustring cPath = _image2DBlobPath( image, imageProjection, imageType );
 
-         case ProjectionSpherical:
-            if ( image.isDefined( "sphericalRepresentation" ) )
-            {
-               const StructureNode sphericalRepresentation(
-                  image.get( "sphericalRepresentation" ) );
+      if ( cPath.empty() )
+      {
+         return false;
+      }
 
-               return _readImage2DNode( sphericalRepresentation, imageType, pBuffer, start, count );
-            }
-            break;
+      const BlobNode blob( image.get( cPath ) );
+      view = blob.view( 0, static_cast<size_t>( blob.byteCount() ) );
 
-         case ProjectionCylindrical:
-            if ( image.isDefined( "cylindricalRepresentation" ) )
+      return true;
+   }
+
+   std::vector<int64_t> ReaderImpl::ReadImage2DDataParallel(
+      const std::vector<Image2DReadRequest> &requests, const Image2DReadCallback &callback,
+      const ParallelReadOptions &options ) const
+   {
+      // Find the blobs here. This touches the node tree which isn't thread safe.
+      std::vector<std::shared_ptr<BlobNodeImpl>> blobs( requests.size() );
+
+      for ( size_t i = 0; i < requests.size(); ++i )
+      {
+         const Image2DReadRequest &request = requests[i];
+
+         if ( ( request.imageIndex < 0 ) || ( request.imageIndex >= images2D_.childCount() ) ||
+              ( ( request.buffer == nullptr ) && !callback ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                                  "imageIndex=" + toString( request.imageIndex ) );
+         }
+
+         const StructureNode image( images2D_.get( request.imageIndex ) );
+         const ustring cPath =
+            _image2DBlobPath( image, request.imageProjection, request.imageType );
+
+         if ( !cPath.empty() )
+         {
+            blobs[i] = BlobNode( image.get( cPath ) ).impl();
+         }
+      }
+
+      // Read in file order so the reads are as sequential as possible
+      std::vector<size_t> order( requests.size() );
+      std::iota( order.begin(), order.end(), size_t( 0 ) );
+
+      std::stable_sort( order.begin(), order.end(), [&blobs]( size_t a, size_t b ) {
+         const uint64_t cStartA = blobs[a] ? blobs[a]->sectionLogicalStart() : 0;
+         const uint64_t cStartB = blobs[b] ? blobs[b]->sectionLogicalStart() : 0;
+
+         return cStartA < cStartB;
+      } );
+
+      // Blobs only use positional reads on the file, so they can be read concurrently
+      std::vector<int64_t> counts( requests.size(), 0 );
+      std::vector<Task> tasks;
+
+      tasks.reserve( requests.size() );
+
+      for ( const size_t i : order )
+      {
+         if ( !blobs[i] )
+         {
+            continue;
+         }
+
+         tasks.emplace_back( [&requests, &callback, &blobs, &counts, i]() {
+            BlobNodeImpl &blob = *blobs[i];
+
+            const auto cByteCount = static_cast<size_t>( blob.byteCount() );
+
+            if ( requests[i].buffer != nullptr )
+            {
+               blob.read( requests[i].buffer, 0, cByteCount );
+            }
+            else
             {
-               const StructureNode cylindricalRepresentation(
-                  image.get( "cylindricalRepresentation" ) );
+               std::vector<uint8_t> buffer( cByteCount );
+
+               blob.read( buffer.data(), 0, cByteCount );
 
-               return _readImage2DNode( cylindricalRepresentation, imageType, pBuffer, start,
-                                        count );
+               callback( i, buffer.data(), cByteCount );
             }
-            break;
+
+            counts[i] = static_cast<int64_t>( cByteCount );
+         } );
       }
 
-      return 0;
+      runTasks( tasks, options.threadCount, options.executor );
+
+      return counts;
    }
 
    bool ReaderImpl::ReadData3D( int64_t dataIndex, Data3D &data3DHeader ) const
@@ -849,29 +1022,7 @@ namespace e57
       }
 
       // Get pose structure from scan.
-      if ( scan.isDefined( "pose" ) )
-      {
-         const StructureNode pose( scan.get( "pose" ) );
-
-         if ( pose.isDefined( "rotation" ) )
-         {
-            const StructureNode rotation( pose.get( "rotation" ) );
-
-            data3DHeader.pose.rotation.w = FloatNode( rotation.get( "w" ) ).value();
-            data3DHeader.pose.rotation.x = FloatNode( rotation.get( "x" ) ).value();
-            data3DHeader.pose.rotation.y = FloatNode( rotation.get( "y" ) ).value();
-            data3DHeader.pose.rotation.z = FloatNode( rotation.get( "z" ) ).value();
-         }
-
-         if ( pose.isDefined( "translation" ) )
-         {
-            const StructureNode translation( pose.get( "translation" ) );
-
-            data3DHeader.pose.translation.x = FloatNode( translation.get( "x" ) ).value();
-            data3DHeader.pose.translation.y = FloatNode( translation.get( "y" ) ).value();
-            data3DHeader.pose.translation.z = FloatNode( translation.get( "z" ) ).value();
-         }
-      }
+      _readPose( scan, data3DHeader.pose );
 
       // Get start/stop acquisition times from scan.
       if ( scan.isDefined( "acquisitionStart" ) )
@@ -1035,6 +1186,14 @@ namespace e57
       data3DHeader.pointFields.sphericalInvalidStateField =
          proto.isDefined( "sphericalInvalidState" );
 
+      // The spherical coordinates are read into cartesian buffers
+      if ( SphericalAsCartesian( proto ) )
+      {
+         data3DHeader.pointFields.cartesianXField = true;
+         data3DHeader.pointFields.cartesianYField = true;
+         data3DHeader.pointFields.cartesianZField = true;
+      }
+
       data3DHeader.pointFields.angleMinimum = 0.0;
       data3DHeader.pointFields.angleMaximum = 0.0;
 
@@ -1500,103 +1659,553 @@ namespace e57
                                           int64_t *idElementValue, int64_t *startPointIndex,
                                           int64_t *pointCount ) const
    {
-      if ( ( dataIndex < 0 ) || ( dataIndex >= data3D_.childCount() ) )
+      const LineGroupTable *groups = ReadData3DGroups( dataIndex );
+
+      if ( groups == nullptr )
       {
          return false;
       }
 
-      const StructureNode scan( data3D_.get( dataIndex ) );
+      // Copy the fields the groups have into the buffers given, up to groupCount of each
+      const auto copyField = [groupCount]( const std::vector<int64_t> &field, int64_t *buffer ) {
+         if ( buffer != nullptr )
+         {
+            std::copy_n( field.begin(), std::min( groupCount, field.size() ), buffer );
+         }
+      };
+
+      copyField( groups->idElementValue, idElementValue );
+      copyField( groups->startPointIndex, startPointIndex );
+      copyField( groups->pointCount, pointCount );
 
-      if ( !scan.isDefined( "pointGroupingSchemes" ) )
+      return true;
+   }
+
+   const LineGroupTable *ReaderImpl::ReadData3DGroups( int64_t dataIndex ) const
+   {
+      // The tables stay where they are as the map grows, so they can be used without the lock
+      std::lock_guard<std::mutex> lock( lineGroupsMutex_ );
+
+      auto found = lineGroups_.find( dataIndex );
+
+      if ( found != lineGroups_.end() )
       {
-         return false;
+         return &found->second;
+      }
+
+      if ( ( dataIndex < 0 ) || ( dataIndex >= data3D_.childCount() ) )
+      {
+         return nullptr;
       }
 
-      const StructureNode pointGroupingSchemes( scan.get( "pointGroupingSchemes" ) );
+      const StructureNode scan( data3D_.get( dataIndex ) );
 
-      if ( !pointGroupingSchemes.isDefined( "groupingByLine" ) )
+      if ( !scan.isDefined( "pointGroupingSchemes/groupingByLine/groups" ) )
       {
-         return false;
+         return nullptr;
       }
 
-      const StructureNode groupingByLine( pointGroupingSchemes.get( "groupingByLine" ) );
-      const StringNode idElementName( groupingByLine.get( "idElementName" ) );
-      CompressedVectorNode groups( groupingByLine.get( "groups" ) );
+      CompressedVectorNode groups( scan.get( "pointGroupingSchemes/groupingByLine/groups" ) );
       const StructureNode lineGroupRecord( groups.prototype() );
-      const int64_t protoCount = lineGroupRecord.childCount();
-      std::vector<SourceDestBuffer> groupSDBuffers;
+      const auto cGroupCount = static_cast<size_t>( groups.childCount() );
 
-      for ( int64_t protoIndex = 0; protoIndex < protoCount; protoIndex++ )
-      {
-         const ustring name = lineGroupRecord.get( protoIndex ).elementName();
+      LineGroupTable table;
+      std::vector<SourceDestBuffer> groupSDBuffers;
 
-         if ( ( name == "idElementValue" ) && lineGroupRecord.isDefined( "idElementValue" ) &&
-              ( idElementValue != nullptr ) )
+      const auto addField = [&]( const char *name, std::vector<int64_t> &field ) {
+         if ( lineGroupRecord.isDefined( name ) )
          {
-            groupSDBuffers.emplace_back( imf_, "idElementValue", idElementValue, groupCount, true );
+            field.resize( cGroupCount );
+            groupSDBuffers.emplace_back( imf_, name, field.data(), cGroupCount, true );
          }
+      };
 
-         if ( ( name == "startPointIndex" ) && lineGroupRecord.isDefined( "startPointIndex" ) &&
-              ( startPointIndex != nullptr ) )
-         {
-            groupSDBuffers.emplace_back( imf_, "startPointIndex", startPointIndex, groupCount,
-                                         true );
-         }
+      addField( "idElementValue", table.idElementValue );
+      addField( "startPointIndex", table.startPointIndex );
+      addField( "pointCount", table.pointCount );
 
-         if ( ( name == "pointCount" ) && lineGroupRecord.isDefined( "pointCount" ) &&
-              ( pointCount != nullptr ) )
-         {
-            groupSDBuffers.emplace_back( imf_, "pointCount", pointCount, groupCount, true );
-         }
+      if ( !groupSDBuffers.empty() && ( cGroupCount > 0 ) )
+      {
+         CompressedVectorReader reader = groups.reader( groupSDBuffers, packetCacheOptions_ );
+
+         reader.setTrustedRanges( trustedInput_ );
+         reader.read();
+         reader.close();
+      }
+
+      return &lineGroups_.emplace( dataIndex, std::move( table ) ).first->second;
+   }
+
+   std::vector<LODNode> ReaderImpl::ReadData3DLODNodes( int64_t dataIndex, int32_t maximumLevel,
+                                                        const CartesianBounds &box ) const
+   {
+      ustring prefix;
+
+      if ( ( dataIndex < 0 ) || ( dataIndex >= data3D_.childCount() ) ||
+           !imf_.extensionsLookupUri( LevelOfDetail::cLevelOfDetailUri, prefix ) )
+      {
+         return {};
+      }
+
+      const StructureNode scan( data3D_.get( dataIndex ) );
+      const ustring cNodesPath =
+         prefix + ":" + LevelOfDetail::cLevelOfDetailElement + "/nodes";
+
+      if ( !scan.isDefined( cNodesPath ) )
+      {
+         return {};
+      }
+
+      CompressedVectorNode nodesVector( scan.get( cNodesPath ) );
+      const auto cNodeCount = static_cast<size_t>( nodesVector.childCount() );
+
+      if ( cNodeCount == 0 )
+      {
+         return {};
+      }
+
+      std::vector<int32_t> level( cNodeCount );
+      std::vector<double> bounds[6];
+      std::vector<int64_t> firstPoint( cNodeCount );
+      std::vector<int64_t> pointCount( cNodeCount );
+
+      const char *cBoundsNames[6] = { "xMinimum", "xMaximum", "yMinimum",
+                                      "yMaximum", "zMinimum", "zMaximum" };
+
+      std::vector<SourceDestBuffer> destBuffers;
+
+      destBuffers.emplace_back( imf_, "level", level.data(), cNodeCount, true );
+
+      for ( int i = 0; i < 6; ++i )
+      {
+         bounds[i].resize( cNodeCount );
+         destBuffers.emplace_back( imf_, cBoundsNames[i], bounds[i].data(), cNodeCount, true );
       }
 
-      CompressedVectorReader reader = groups.reader( groupSDBuffers );
+      destBuffers.emplace_back( imf_, "firstPoint", firstPoint.data(), cNodeCount, true );
+      destBuffers.emplace_back( imf_, "pointCount", pointCount.data(), cNodeCount, true );
+
+      CompressedVectorReader reader = nodesVector.reader( destBuffers, packetCacheOptions_ );
+
+      reader.setTrustedRanges( trustedInput_ );
 
       reader.read();
       reader.close();
 
-      return true;
+      std::vector<LODNode> nodes;
+
+      for ( size_t i = 0; i < cNodeCount; ++i )
+      {
+         LODNode node;
+
+         node.level = level[i];
+         node.bounds.xMinimum = bounds[0][i];
+         node.bounds.xMaximum = bounds[1][i];
+         node.bounds.yMinimum = bounds[2][i];
+         node.bounds.yMaximum = bounds[3][i];
+         node.bounds.zMinimum = bounds[4][i];
+         node.bounds.zMaximum = bounds[5][i];
+         node.firstPoint = firstPoint[i];
+         node.pointCount = pointCount[i];
+
+         const bool cIntersects =
+            ( node.bounds.xMinimum <= box.xMaximum ) && ( box.xMinimum <= node.bounds.xMaximum ) &&
+            ( node.bounds.yMinimum <= box.yMaximum ) && ( box.yMinimum <= node.bounds.yMaximum ) &&
+            ( node.bounds.zMinimum <= box.zMaximum ) && ( box.zMinimum <= node.bounds.zMaximum );
+
+         if ( ( node.level <= maximumLevel ) && cIntersects )
+         {
+            nodes.push_back( node );
+         }
+      }
+
+      return nodes;
    }
 
-   template <typename COORDTYPE>
-   CompressedVectorReader ReaderImpl::SetUpData3DPointsData(
-      int64_t dataIndex, size_t count, const Data3DPointsData_t<COORDTYPE> &buffers ) const
+   std::vector<QuantizedField> ReaderImpl::ReadData3DQuantizedFields( int64_t dataIndex ) const
    {
-      static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
+      if ( ( dataIndex < 0 ) || ( dataIndex >= data3D_.childCount() ) )
+      {
+         return {};
+      }
 
       const StructureNode scan( data3D_.get( dataIndex ) );
-      CompressedVectorNode points( scan.get( "points" ) );
+      const CompressedVectorNode points( scan.get( "points" ) );
       const StructureNode proto( points.prototype() );
-      const int64_t protoCount = proto.childCount();
-      std::vector<SourceDestBuffer> destBuffers;
 
-      for ( int64_t protoIndex = 0; protoIndex < protoCount; protoIndex++ )
-      {
-         const ustring name = proto.get( protoIndex ).elementName();
-         const NodeType type = proto.get( protoIndex ).type();
-         const bool scaled = ( type == TypeScaledInteger );
+      // The narrowest type whose range holds [minimum, maximum]
+      auto narrowest = []( int64_t minimum, int64_t maximum ) {
+         if ( minimum >= 0 )
+         {
+            if ( maximum <= UINT8_MAX )
+            {
+               return UInt8;
+            }
 
-         // E57_EXT_surface_normals
-         ustring norExtUri;
-         const bool haveNormalsExt = imf_.extensionsLookupPrefix( "nor", norExtUri );
+            if ( maximum <= UINT16_MAX )
+            {
+               return UInt16;
+            }
 
-         if ( ( name == "cartesianX" ) && proto.isDefined( "cartesianX" ) &&
-              ( buffers.cartesianX != nullptr ) )
-         {
-            destBuffers.emplace_back( imf_, "cartesianX", buffers.cartesianX, count, true, scaled );
+            return ( maximum <= UINT32_MAX ) ? UInt32 : Int64;
          }
-         else if ( ( name == "cartesianY" ) && proto.isDefined( "cartesianY" ) &&
-                   ( buffers.cartesianY != nullptr ) )
+
+         if ( ( minimum >= INT8_MIN ) && ( maximum <= INT8_MAX ) )
          {
-            destBuffers.emplace_back( imf_, "cartesianY", buffers.cartesianY, count, true, scaled );
+            return Int8;
          }
-         else if ( ( name == "cartesianZ" ) && proto.isDefined( "cartesianZ" ) &&
-                   ( buffers.cartesianZ != nullptr ) )
+
+         if ( ( minimum >= INT16_MIN ) && ( maximum <= INT16_MAX ) )
          {
-            destBuffers.emplace_back( imf_, "cartesianZ", buffers.cartesianZ, count, true, scaled );
+            return Int16;
          }
-         else if ( ( name == "cartesianInvalidState" ) &&
-                   proto.isDefined( "cartesianInvalidState" ) &&
+
+         return ( ( minimum >= INT32_MIN ) && ( maximum <= INT32_MAX ) ) ? Int32 : Int64;
+      };
+
+      std::vector<QuantizedField> fields;
+
+      for ( int64_t i = 0; i < proto.childCount(); ++i )
+      {
+         const Node cChild( proto.get( i ) );
+
+         if ( cChild.type() != TypeScaledInteger )
+         {
+            continue;
+         }
+
+         const ScaledIntegerNode cField( cChild );
+
+         QuantizedField field;
+         field.pathName = cChild.elementName();
+         field.representation = narrowest( cField.minimum(), cField.maximum() );
+         field.minimum = cField.minimum();
+         field.maximum = cField.maximum();
+         field.scale = cField.scale();
+         field.offset = cField.offset();
+
+         fields.push_back( field );
+      }
+
+      return fields;
+   }
+
+   /// Call @a function with each buffer of @a target and the matching buffer of @a source.
+   template <typename COORDTYPE, typename Function>
+   void _forEachPointBuffer( Data3DPointsData_t<COORDTYPE> &target,
+                             const Data3DPointsData_t<COORDTYPE> &source, Function function )
+   {
+      function( target.cartesianX, source.cartesianX );
+      function( target.cartesianY, source.cartesianY );
+      function( target.cartesianZ, source.cartesianZ );
+      function( target.cartesianInvalidState, source.cartesianInvalidState );
+      function( target.intensity, source.intensity );
+      function( target.isIntensityInvalid, source.isIntensityInvalid );
+      function( target.colorRed, source.colorRed );
+      function( target.colorGreen, source.colorGreen );
+      function( target.colorBlue, source.colorBlue );
+      function( target.isColorInvalid, source.isColorInvalid );
+      function( target.sphericalRange, source.sphericalRange );
+      function( target.sphericalAzimuth, source.sphericalAzimuth );
+      function( target.sphericalElevation, source.sphericalElevation );
+      function( target.sphericalInvalidState, source.sphericalInvalidState );
+      function( target.rowIndex, source.rowIndex );
+      function( target.columnIndex, source.columnIndex );
+      function( target.returnIndex, source.returnIndex );
+      function( target.returnCount, source.returnCount );
+      function( target.timeStamp, source.timeStamp );
+      function( target.isTimeStampInvalid, source.isTimeStampInvalid );
+      function( target.normalX, source.normalX );
+      function( target.normalY, source.normalY );
+      function( target.normalZ, source.normalZ );
+   }
+
+   template <typename COORDTYPE>
+   int64_t ReaderImpl::ReadData3DLines( int64_t dataIndex, int64_t firstLine, int64_t lineCount,
+                                        const Data3DPointsData_t<COORDTYPE> &image ) const
+   {
+      int64_t rows = 0;
+      int64_t columns = 0;
+      int64_t pointsSize = 0;
+      int64_t groupsSize = 0;
+      int64_t countSize = 0;
+      bool byColumn = false;
+
+      if ( !GetData3DSizes( dataIndex, rows, columns, pointsSize, groupsSize, countSize,
+                            byColumn ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "dataIndex=" + toString( dataIndex ) );
+      }
+
+      const int64_t cLineLength = byColumn ? rows : columns;
+
+      if ( ( groupsSize == 0 ) || ( cLineLength <= 0 ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "dataIndex=" + toString( dataIndex ) + " is not a grid of lines" );
+      }
+
+      if ( ( firstLine < 0 ) || ( lineCount < 0 ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument, "firstLine=" + toString( firstLine ) +
+                                                       " lineCount=" + toString( lineCount ) );
+      }
+
+      const StructureNode scan( data3D_.get( dataIndex ) );
+      const StructureNode indexBounds( scan.get( "indexBounds" ) );
+      const StructureNode lineGroupRecord(
+         CompressedVectorNode( scan.get( "pointGroupingSchemes/groupingByLine/groups" ) )
+            .prototype() );
+
+      if ( !lineGroupRecord.isDefined( "startPointIndex" ) ||
+           !lineGroupRecord.isDefined( "pointCount" ) )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "dataIndex=" + toString( dataIndex ) + " has no group extents" );
+      }
+
+      const int64_t cPositionMinimum =
+         IntegerNode( indexBounds.get( byColumn ? "rowMinimum" : "columnMinimum" ) ).value();
+
+      const LineGroupTable &groups = *ReadData3DGroups( dataIndex );
+      const std::vector<int64_t> &startPointIndex = groups.startPointIndex;
+      const std::vector<int64_t> &pointCount = groups.pointCount;
+      const auto cGroupCount = startPointIndex.size();
+
+      // Each read covers one line. Complete lines are read straight into the image. Any others
+      // are read into line buffers, then each point is moved to its position.
+      const auto cLength = static_cast<size_t>( cLineLength );
+
+      std::vector<int32_t> positions( cLength );
+
+      Data3DPointsData_t<COORDTYPE> direct;
+      Data3DPointsData_t<COORDTYPE> lineBuffers;
+      std::vector<std::vector<char>> lineStorage;
+
+      int32_t *Data3DPointsData_t<COORDTYPE>::*positionField =
+         byColumn ? &Data3DPointsData_t<COORDTYPE>::rowIndex
+                  : &Data3DPointsData_t<COORDTYPE>::columnIndex;
+
+      const auto cBindLine = [&]( int64_t line ) {
+         const size_t cOffset = static_cast<size_t>( line - firstLine ) * cLength;
+
+         _forEachPointBuffer( direct, image, [cOffset]( auto *&target, auto *source ) {
+            target = ( source == nullptr ) ? nullptr : source + cOffset;
+         } );
+
+         if ( direct.*positionField == nullptr )
+         {
+            direct.*positionField = positions.data();
+         }
+      };
+
+      _forEachPointBuffer( lineBuffers, image, [&]( auto *&target, auto *source ) {
+         if ( source != nullptr )
+         {
+            lineStorage.emplace_back( cLength * sizeof( *source ) );
+            target = reinterpret_cast<decltype( source )>( lineStorage.back().data() );
+         }
+      } );
+
+      lineBuffers.*positionField = positions.data();
+
+      CompressedVectorReader directReader =
+         SetUpData3DPointsData( dataIndex, cLength, lineBuffers );
+      CompressedVectorReader lineReader = SetUpData3DPointsData( dataIndex, cLength, lineBuffers );
+
+      int64_t stored = 0;
+
+      for ( size_t group = 0; group < cGroupCount; ++group )
+      {
+         // Without an idElementValue the groups are numbered in order
+         const int64_t cLine = groups.idElementValue.empty()
+                                  ? static_cast<int64_t>( group )
+                                  : groups.idElementValue[group];
+         const int64_t cStart = startPointIndex[group];
+
+         if ( ( cLine < firstLine ) || ( cLine - firstLine >= lineCount ) || ( cStart < 0 ) ||
+              ( cStart >= pointsSize ) )
+         {
+            continue;
+         }
+
+         const int64_t cCount = std::min( pointCount[group], pointsSize - cStart );
+
+         if ( cCount <= 0 )
+         {
+            continue;
+         }
+
+         // When invalid points are dropped they would leave the rest of a complete line in the
+         // wrong cells, so only the points which are read go to the image
+         if ( ( cCount == cLineLength ) && !validPointsOnly_ )
+         {
+            // Seeking decodes the records skipped into the current buffers, so bind the line
+            // before going to its first point
+            cBindLine( cLine );
+
+            std::vector<SourceDestBuffer> lineDestBuffers =
+               SetUpData3DPointsDestBuffers( dataIndex, cLength, direct );
+
+            directReader.rebind( lineDestBuffers );
+            directReader.setRecordRange( cStart, cCount );
+
+            const unsigned cRead = directReader.read();
+
+            const int32_t *linePositions = direct.*positionField;
+            bool inOrder = ( cRead == cLength );
+
+            for ( size_t i = 0; inOrder && ( i < cLength ); ++i )
+            {
+               inOrder = ( linePositions[i] - cPositionMinimum == static_cast<int64_t>( i ) );
+            }
+
+            if ( inOrder )
+            {
+               stored += cCount;
+               continue;
+            }
+         }
+
+         // Read the group a line's worth at a time, as it may hold several returns per position
+         const size_t cLineOffset = static_cast<size_t>( cLine - firstLine ) * cLength;
+
+         lineReader.setRecordRange( cStart, cCount );
+
+         while ( const unsigned cRead = lineReader.read() )
+         {
+            for ( size_t i = 0; i < cRead; ++i )
+            {
+               const int64_t cPosition = positions[i] - cPositionMinimum;
+
+               if ( ( cPosition < 0 ) || ( cPosition >= cLineLength ) )
+               {
+                  continue;
+               }
+
+               const size_t cCell = cLineOffset + static_cast<size_t>( cPosition );
+
+               _forEachPointBuffer( lineBuffers, image, [cCell, i]( auto *&from, auto *to ) {
+                  if ( to != nullptr )
+                  {
+                     to[cCell] = from[i];
+                  }
+               } );
+
+               ++stored;
+            }
+         }
+      }
+
+      directReader.close();
+      lineReader.close();
+
+      return stored;
+   }
+
+   template <typename COORDTYPE>
+   CompressedVectorReader ReaderImpl::SetUpData3DPointsData(
+      int64_t dataIndex, size_t count, const Data3DPointsData_t<COORDTYPE> &buffers ) const
+   {
+      const StructureNode scan( data3D_.get( dataIndex ) );
+      CompressedVectorNode points( scan.get( "points" ) );
+
+      std::vector<SourceDestBuffer> destBuffers =
+         SetUpData3DPointsDestBuffers( dataIndex, count, buffers );
+
+      CompressedVectorReader reader = points.reader( destBuffers, packetCacheOptions_ );
+
+      reader.setTrustedRanges( trustedInput_ );
+
+      const bool cSphericalInput =
+         SphericalAsCartesian( StructureNode( points.prototype() ), buffers );
+
+      ApplyData3DFilter( destBuffers, reader );
+      ApplyData3DTransform( dataIndex, cSphericalInput, destBuffers, reader );
+
+      return reader;
+   }
+
+   CompressedVectorReader ReaderImpl::SetUpData3DPointsData(
+      int64_t dataIndex, size_t count, const Data3DPointsInterleaved &buffers ) const
+   {
+      const StructureNode scan( data3D_.get( dataIndex ) );
+      CompressedVectorNode points( scan.get( "points" ) );
+      const StructureNode proto( points.prototype() );
+
+      const std::vector<SourceDestBuffer> destBuffers =
+         interleavedBuffers( imf_, proto, buffers, count );
+
+      CompressedVectorReader reader = points.reader( destBuffers, packetCacheOptions_ );
+
+      reader.setTrustedRanges( trustedInput_ );
+
+      ApplyData3DNormalization( dataIndex, proto, buffers, reader );
+      ApplyData3DFilter( destBuffers, reader );
+      ApplyData3DTransform( dataIndex, false, destBuffers, reader );
+
+      return reader;
+   }
+
+   template <typename COORDTYPE>
+   std::vector<SourceDestBuffer> ReaderImpl::SetUpData3DPointsDestBuffers(
+      int64_t dataIndex, size_t count, const Data3DPointsData_t<COORDTYPE> &buffers ) const
+   {
+      static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
+
+      const StructureNode scan( data3D_.get( dataIndex ) );
+      const CompressedVectorNode points( scan.get( "points" ) );
+      const StructureNode proto( points.prototype() );
+      const int64_t protoCount = proto.childCount();
+      std::vector<SourceDestBuffer> destBuffers;
+
+      // Read the spherical coordinates into the cartesian buffers, where they are converted
+      const bool cSphericalAsCartesian = SphericalAsCartesian( proto, buffers );
+
+      for ( int64_t protoIndex = 0; protoIndex < protoCount; protoIndex++ )
+      {
+         const ustring name = proto.get( protoIndex ).elementName();
+         const NodeType type = proto.get( protoIndex ).type();
+         const bool scaled = ( type == TypeScaledInteger );
+
+         // E57_EXT_surface_normals
+         ustring norExtUri;
+         const bool haveNormalsExt = imf_.extensionsLookupPrefix( "nor", norExtUri );
+
+         if ( cSphericalAsCartesian && ( ( name == "sphericalRange" ) ||
+                                         ( name == "sphericalAzimuth" ) ||
+                                         ( name == "sphericalElevation" ) ) )
+         {
+            COORDTYPE *coordinates = buffers.cartesianZ;
+
+            if ( name == "sphericalRange" )
+            {
+               coordinates = buffers.cartesianX;
+            }
+            else if ( name == "sphericalAzimuth" )
+            {
+               coordinates = buffers.cartesianY;
+            }
+
+            destBuffers.emplace_back( imf_, name, coordinates, count, true, scaled );
+         }
+         else if ( ( name == "cartesianX" ) && proto.isDefined( "cartesianX" ) &&
+              ( buffers.cartesianX != nullptr ) )
+         {
+            destBuffers.emplace_back( imf_, "cartesianX", buffers.cartesianX, count, true, scaled );
+         }
+         else if ( ( name == "cartesianY" ) && proto.isDefined( "cartesianY" ) &&
+                   ( buffers.cartesianY != nullptr ) )
+         {
+            destBuffers.emplace_back( imf_, "cartesianY", buffers.cartesianY, count, true, scaled );
+         }
+         else if ( ( name == "cartesianZ" ) && proto.isDefined( "cartesianZ" ) &&
+                   ( buffers.cartesianZ != nullptr ) )
+         {
+            destBuffers.emplace_back( imf_, "cartesianZ", buffers.cartesianZ, count, true, scaled );
+         }
+         else if ( ( name == "cartesianInvalidState" ) &&
+                   proto.isDefined( "cartesianInvalidState" ) &&
                    ( buffers.cartesianInvalidState != nullptr ) )
          {
             destBuffers.emplace_back( imf_, "cartesianInvalidState", buffers.cartesianInvalidState,
@@ -1706,9 +2315,7 @@ namespace e57
          }
       }
 
-      CompressedVectorReader reader = points.reader( destBuffers );
-
-      return reader;
+      return destBuffers;
    }
 
    int64_t ReaderImpl::GetData3DCount() const
@@ -1716,6 +2323,330 @@ namespace e57
       return data3D_.childCount();
    }
 
+   template <typename COORDTYPE>
+   std::vector<uint64_t> ReaderImpl::ReadData3DPointsDataParallel(
+      const std::vector<int64_t> &dataIndices,
+      const std::vector<Data3DPointsData_t<COORDTYPE> *> &buffers,
+      const ParallelReadOptions &options ) const
+   {
+      if ( dataIndices.size() != buffers.size() )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "dataIndicesSize=" + toString( dataIndices.size() ) +
+                                  " buffersSize=" + toString( buffers.size() ) );
+      }
+
+      for ( size_t i = 0; i < dataIndices.size(); ++i )
+      {
+         const int64_t dataIndex = dataIndices[i];
+
+         if ( ( dataIndex < 0 ) || ( dataIndex >= data3D_.childCount() ) ||
+              ( buffers[i] == nullptr ) )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument, "dataIndex=" + toString( dataIndex ) );
+         }
+      }
+
+      // If there aren't enough blocks to keep all the threads busy, read them one after the other
+      // and split each one into chunks which are decoded in parallel. The chunks are decoded in
+      // place, so this isn't done when the invalid points are dropped.
+      if ( !validPointsOnly_ && ( dataIndices.size() < resolveThreadCount( options.threadCount ) ) )
+      {
+         std::vector<uint64_t> counts( dataIndices.size(), 0 );
+         std::exception_ptr firstError;
+
+         for ( size_t i = 0; i < dataIndices.size(); ++i )
+         {
+            try
+            {
+               const StructureNode scan( data3D_.get( dataIndices[i] ) );
+               CompressedVectorNode points( scan.get( "points" ) );
+
+               const auto pointCount = static_cast<size_t>( points.childCount() );
+
+               counts[i] = points.readParallel(
+                  SetUpData3DPointsDestBuffers( dataIndices[i], pointCount, *buffers[i] ),
+                  options.threadCount, options.executor );
+
+               // The chunks are decoded by separate readers, so transform the coordinates
+               // afterwards
+               const Data3DPointsData_t<COORDTYPE> &data = *buffers[i];
+               constexpr size_t cStride = sizeof( COORDTYPE );
+
+               CoordinateTransform transform;
+               const bool cPose = Data3DPoseTransform( dataIndices[i], transform );
+
+               if ( SphericalAsCartesian( StructureNode( points.prototype() ), data ) )
+               {
+                  CoordinateKernels::sphericalToCartesian(
+                     data.cartesianX, cStride, data.cartesianY, cStride, data.cartesianZ, cStride,
+                     static_cast<size_t>( counts[i] ), transform.matrix );
+               }
+               else if ( cPose && ( data.cartesianX != nullptr ) &&
+                         ( data.cartesianY != nullptr ) && ( data.cartesianZ != nullptr ) )
+               {
+                  CoordinateKernels::transform( data.cartesianX, cStride, data.cartesianY,
+                                                cStride, data.cartesianZ, cStride,
+                                                static_cast<size_t>( counts[i] ),
+                                                transform.matrix );
+               }
+            }
+            catch ( ... )
+            {
+               if ( !firstError )
+               {
+                  firstError = std::current_exception();
+               }
+            }
+         }
+
+         if ( firstError )
+         {
+            std::rethrow_exception( firstError );
+         }
+
+         return counts;
+      }
+
+      // Set up the readers here. This touches the node tree which isn't thread safe.
+      std::vector<CompressedVectorReader> readers;
+      readers.reserve( dataIndices.size() );
+
+      for ( size_t i = 0; i < dataIndices.size(); ++i )
+      {
+         const StructureNode scan( data3D_.get( dataIndices[i] ) );
+         const CompressedVectorNode points( scan.get( "points" ) );
+
+         const auto pointCount = static_cast<size_t>( points.childCount() );
+
+         readers.push_back( SetUpData3DPointsData( dataIndices[i], pointCount, *buffers[i] ) );
+      }
+
+      // Each reader has its own packet cache and uses positional reads on the file, so they can be
+      // drained concurrently.
+      std::vector<uint64_t> counts( readers.size(), 0 );
+      std::vector<Task> tasks;
+
+      tasks.reserve( readers.size() );
+
+      for ( size_t i = 0; i < readers.size(); ++i )
+      {
+         tasks.emplace_back( [&readers, &counts, i]() {
+            auto &reader = readers[i];
+
+            counts[i] = reader.read();
+
+            reader.close();
+         } );
+      }
+
+      runTasks( tasks, options.threadCount, options.executor );
+
+      return counts;
+   }
+
+   bool ReaderImpl::Data3DPoseTransform( int64_t dataIndex, CoordinateTransform &transform ) const
+   {
+      if ( !applyPose_ )
+      {
+         return false;
+      }
+
+      const StructureNode scan( data3D_.get( dataIndex ) );
+
+      // No pose means the identity, so there's nothing to do
+      if ( !scan.isDefined( "pose" ) )
+      {
+         return false;
+      }
+
+      RigidBodyTransform pose;
+
+      _readPose( scan, pose );
+      _poseTransform( pose, transform );
+
+      return true;
+   }
+
+   bool ReaderImpl::SphericalAsCartesian( const StructureNode &proto ) const
+   {
+      return sphericalToCartesian_ && !proto.isDefined( "cartesianX" ) &&
+             !proto.isDefined( "cartesianY" ) && !proto.isDefined( "cartesianZ" ) &&
+             proto.isDefined( "sphericalRange" ) && proto.isDefined( "sphericalAzimuth" ) &&
+             proto.isDefined( "sphericalElevation" );
+   }
+
+   template <typename COORDTYPE>
+   bool ReaderImpl::SphericalAsCartesian( const StructureNode &proto,
+                                          const Data3DPointsData_t<COORDTYPE> &buffers ) const
+   {
+      return ( buffers.cartesianX != nullptr ) && ( buffers.cartesianY != nullptr ) &&
+             ( buffers.cartesianZ != nullptr ) && SphericalAsCartesian( proto );
+   }
+
+   void ReaderImpl::ApplyData3DFilter( const std::vector<SourceDestBuffer> &destBuffers,
+                                       CompressedVectorReader &reader ) const
+   {
+      if ( !validPointsOnly_ )
+      {
+         return;
+      }
+
+      const char *cInvalidStateFields[] = { "cartesianInvalidState", "sphericalInvalidState",
+                                            "isIntensityInvalid", "isColorInvalid",
+                                            "isTimeStampInvalid" };
+
+      RecordFilter filter;
+
+      for ( const auto &buffer : destBuffers )
+      {
+         const ustring cName = buffer.pathName();
+
+         for ( const char *field : cInvalidStateFields )
+         {
+            if ( cName == field )
+            {
+               filter.invalidStateFields.push_back( cName );
+            }
+         }
+      }
+
+      if ( !filter.invalidStateFields.empty() )
+      {
+         reader.setRecordFilter( filter );
+      }
+   }
+
+   void ReaderImpl::ApplyData3DNormalization( int64_t dataIndex, const StructureNode &proto,
+                                              const Data3DPointsInterleaved &buffers,
+                                              CompressedVectorReader &reader ) const
+   {
+      std::vector<FieldNormalization> normalizations;
+      Data3D header;
+      bool headerRead = false;
+
+      for ( const auto &field : buffers.fields )
+      {
+         if ( !field.normalized )
+         {
+            continue;
+         }
+
+         // The limits come from the header of the scan
+         if ( !headerRead )
+         {
+            ReadData3D( dataIndex, header );
+            headerRead = true;
+         }
+
+         FieldNormalization normalization;
+
+         normalization.pathName = field.pathName;
+
+         if ( field.pathName == "intensity" )
+         {
+            normalization.minimum = header.intensityLimits.intensityMinimum;
+            normalization.maximum = header.intensityLimits.intensityMaximum;
+         }
+         else if ( field.pathName == "colorRed" )
+         {
+            normalization.minimum = header.colorLimits.colorRedMinimum;
+            normalization.maximum = header.colorLimits.colorRedMaximum;
+         }
+         else if ( field.pathName == "colorGreen" )
+         {
+            normalization.minimum = header.colorLimits.colorGreenMinimum;
+            normalization.maximum = header.colorLimits.colorGreenMaximum;
+         }
+         else if ( field.pathName == "colorBlue" )
+         {
+            normalization.minimum = header.colorLimits.colorBlueMinimum;
+            normalization.maximum = header.colorLimits.colorBlueMaximum;
+         }
+         else if ( ( field.pathName == "nor:normalX" ) || ( field.pathName == "nor:normalY" ) ||
+                   ( field.pathName == "nor:normalZ" ) )
+         {
+            // Unit vectors (E57_EXT_surface_normals)
+            normalization.minimum = -1.0;
+            normalization.maximum = 1.0;
+         }
+         else
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument, "pathName=" + field.pathName );
+         }
+
+         // Fields which aren't in the scan aren't read
+         if ( proto.isDefined( field.pathName ) )
+         {
+            normalizations.push_back( normalization );
+         }
+      }
+
+      if ( !normalizations.empty() )
+      {
+         reader.setNormalization( normalizations );
+      }
+   }
+
+   void ReaderImpl::ApplyData3DTransform( int64_t dataIndex, bool sphericalInput,
+                                          const std::vector<SourceDestBuffer> &destBuffers,
+                                          CompressedVectorReader &reader ) const
+   {
+      CoordinateTransform transform;
+
+      const bool cPose = Data3DPoseTransform( dataIndex, transform );
+
+      if ( sphericalInput )
+      {
+         transform.xPathName = "sphericalRange";
+         transform.yPathName = "sphericalAzimuth";
+         transform.zPathName = "sphericalElevation";
+         transform.sphericalInput = true;
+
+         reader.setCoordinateTransform( transform );
+         return;
+      }
+
+      if ( !cPose )
+      {
+         return;
+      }
+
+      // Only cartesian coordinates can be transformed, and only if all three are read into
+      // floating point buffers of the same type
+      size_t found = 0;
+      size_t foundReal32 = 0;
+
+      for ( const auto &buffer : destBuffers )
+      {
+         const ustring name = buffer.pathName();
+
+         if ( ( name == transform.xPathName ) || ( name == transform.yPathName ) ||
+              ( name == transform.zPathName ) )
+         {
+            switch ( buffer.memoryRepresentation() )
+            {
+               case Real32:
+                  ++foundReal32;
+                  ++found;
+                  break;
+
+               case Real64:
+                  ++found;
+                  break;
+
+               default:
+                  break;
+            }
+         }
+      }
+
+      if ( ( found == 3 ) && ( ( foundReal32 == 0 ) || ( foundReal32 == 3 ) ) )
+      {
+         reader.setCoordinateTransform( transform );
+      }
+   }
+
    StructureNode ReaderImpl::GetRawE57Root() const
    {
       return root_;
@@ -1737,10 +2668,34 @@ namespace e57
    }
 
    // Explicit template instantiation
+   template int64_t ReaderImpl::ReadData3DLines( int64_t dataIndex, int64_t firstLine,
+                                                 int64_t lineCount,
+                                                 const Data3DPointsData_t<float> &image ) const;
+
+   template int64_t ReaderImpl::ReadData3DLines( int64_t dataIndex, int64_t firstLine,
+                                                 int64_t lineCount,
+                                                 const Data3DPointsData_t<double> &image ) const;
+
    template CompressedVectorReader ReaderImpl::SetUpData3DPointsData(
       int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<float> &buffers ) const;
 
    template CompressedVectorReader ReaderImpl::SetUpData3DPointsData(
       int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<double> &buffers ) const;
 
+   template std::vector<SourceDestBuffer> ReaderImpl::SetUpData3DPointsDestBuffers(
+      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<float> &buffers ) const;
+
+   template std::vector<SourceDestBuffer> ReaderImpl::SetUpData3DPointsDestBuffers(
+      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<double> &buffers ) const;
+
+   template std::vector<uint64_t> ReaderImpl::ReadData3DPointsDataParallel(
+      const std::vector<int64_t> &dataIndices,
+      const std::vector<Data3DPointsData_t<float> *> &buffers,
+      const ParallelReadOptions &options ) const;
+
+   template std::vector<uint64_t> ReaderImpl::ReadData3DPointsDataParallel(
+      const std::vector<int64_t> &dataIndices,
+      const std::vector<Data3DPointsData_t<double> *> &buffers,
+      const ParallelReadOptions &options ) const;
+
 } // end namespace e57
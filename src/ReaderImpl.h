@@ -28,6 +28,9 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
+
 #include "E57SimpleData.h"
 #include "E57SimpleReader.h"
 
@@ -37,6 +40,8 @@ namespace e57
    {
    public:
       ReaderImpl( const ustring &filePath, const ReaderOptions &options );
+      ReaderImpl( const char *buffer, uint64_t size, const ReaderOptions &options );
+      ReaderImpl( std::shared_ptr<ReadSource> source, const ReaderOptions &options );
       ~ReaderImpl();
 
       // disallow copying a ReaderImpl
@@ -64,6 +69,13 @@ namespace e57
                               Image2DType imageType, uint8_t *pBuffer, int64_t start,
                               size_t count ) const;
 
+      bool ViewImage2DData( int64_t imageIndex, Image2DProjection imageProjection,
+                            Image2DType imageType, BlobView &view ) const;
+
+      std::vector<int64_t> ReadImage2DDataParallel( const std::vector<Image2DReadRequest> &requests,
+                                                    const Image2DReadCallback &callback,
+                                                    const ParallelReadOptions &options ) const;
+
       int64_t GetData3DCount() const;
 
       bool ReadData3D( int64_t dataIndex, Data3D &data3DHeader ) const;
@@ -75,10 +87,34 @@ namespace e57
       bool ReadData3DGroupsData( int64_t dataIndex, size_t groupCount, int64_t *idElementValue,
                                  int64_t *startPointIndex, int64_t *pointCount ) const;
 
+      const LineGroupTable *ReadData3DGroups( int64_t dataIndex ) const;
+
+      std::vector<LODNode> ReadData3DLODNodes( int64_t dataIndex, int32_t maximumLevel,
+                                               const CartesianBounds &box ) const;
+
+      std::vector<QuantizedField> ReadData3DQuantizedFields( int64_t dataIndex ) const;
+
+      template <typename COORDTYPE>
+      int64_t ReadData3DLines( int64_t dataIndex, int64_t firstLine, int64_t lineCount,
+                               const Data3DPointsData_t<COORDTYPE> &image ) const;
+
       template <typename COORDTYPE>
       CompressedVectorReader SetUpData3DPointsData(
          int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<COORDTYPE> &buffers ) const;
 
+      CompressedVectorReader SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
+                                                    const Data3DPointsInterleaved &buffers ) const;
+
+      template <typename COORDTYPE>
+      std::vector<SourceDestBuffer> SetUpData3DPointsDestBuffers(
+         int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<COORDTYPE> &buffers ) const;
+
+      template <typename COORDTYPE>
+      std::vector<uint64_t> ReadData3DPointsDataParallel(
+         const std::vector<int64_t> &dataIndices,
+         const std::vector<Data3DPointsData_t<COORDTYPE> *> &buffers,
+         const ParallelReadOptions &options ) const;
+
       StructureNode GetRawE57Root() const;
 
       VectorNode GetRawData3D() const;
@@ -88,11 +124,43 @@ namespace e57
       ImageFile GetRawIMF() const;
 
    private:
+      ReaderImpl( const ImageFile &imf, const ReaderOptions &options );
+
+      bool Data3DPoseTransform( int64_t dataIndex, CoordinateTransform &transform ) const;
+
+      bool SphericalAsCartesian( const StructureNode &proto ) const;
+
+      template <typename COORDTYPE>
+      bool SphericalAsCartesian( const StructureNode &proto,
+                                 const Data3DPointsData_t<COORDTYPE> &buffers ) const;
+
+      void ApplyData3DFilter( const std::vector<SourceDestBuffer> &destBuffers,
+                              CompressedVectorReader &reader ) const;
+
+      void ApplyData3DNormalization( int64_t dataIndex, const StructureNode &proto,
+                                     const Data3DPointsInterleaved &buffers,
+                                     CompressedVectorReader &reader ) const;
+
+      void ApplyData3DTransform( int64_t dataIndex, bool sphericalInput,
+                                 const std::vector<SourceDestBuffer> &destBuffers,
+                                 CompressedVectorReader &reader ) const;
+
       ImageFile imf_;
       StructureNode root_;
 
       VectorNode data3D_;
 
       VectorNode images2D_;
+
+      PacketCacheOptions packetCacheOptions_;
+
+      bool applyPose_;
+      bool sphericalToCartesian_;
+      bool trustedInput_;
+      bool validPointsOnly_;
+
+      // Group tables decoded so far, by data index
+      mutable std::mutex lineGroupsMutex_;
+      mutable std::map<int64_t, LineGroupTable> lineGroups_;
    }; // end Reader class
 } // end namespace e57
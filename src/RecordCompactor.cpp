@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+
+#include "RecordCompactor.h"
+#include "ScaledIntegerNodeImpl.h"
+#include "SourceDestBufferImpl.h"
+#include "StringFunctions.h"
+
+namespace e57
+{
+   RecordCompactor::RecordCompactor( const RecordFilter &filter ) : filter_( filter )
+   {
+   }
+
+   void RecordCompactor::bind( const NodeImplSharedPtr &proto,
+                               const std::vector<SourceDestBuffer> &dbufs )
+   {
+      // The records are tested once they are in the buffers, so the fields must be read as they
+      // are (not normalized)
+      auto findBuffer = [&dbufs]( const ustring &pathName ) {
+         const auto cFound =
+            std::find_if( dbufs.begin(), dbufs.end(), [&pathName]( const SourceDestBuffer &dbuf ) {
+               return dbuf.pathName() == pathName;
+            } );
+
+         if ( ( cFound == dbufs.end() ) || ( cFound->memoryRepresentation() == UString ) ||
+              cFound->impl()->normalizes() )
+         {
+            throw E57_EXCEPTION2( ErrorBadAPIArgument, "pathName=" + pathName );
+         }
+
+         return static_cast<size_t>( cFound - dbufs.begin() );
+      };
+
+      std::vector<size_t> buffers;
+
+      for ( const auto &pathName : filter_.invalidStateFields )
+      {
+         buffers.push_back( findBuffer( pathName ) );
+      }
+
+      std::vector<RangeTest> tests;
+
+      for ( const auto &range : filter_.ranges )
+      {
+         RangeTest test;
+
+         test.buffer = findBuffer( range.pathName );
+         test.minimum = range.minimum;
+         test.maximum = range.maximum;
+
+         // Raw integers are tested against the raw limits of the range
+         NodeImplSharedPtr field = proto->get( range.pathName );
+
+         if ( ( field->type() == TypeScaledInteger ) && !dbufs[test.buffer].doScaling() )
+         {
+            auto scaled = std::static_pointer_cast<ScaledIntegerNodeImpl>( field );
+
+            test.minimum = ( range.minimum - scaled->offset() ) / scaled->scale();
+            test.maximum = ( range.maximum - scaled->offset() ) / scaled->scale();
+
+            // A negative scale reverses the order
+            if ( test.minimum > test.maximum )
+            {
+               std::swap( test.minimum, test.maximum );
+            }
+         }
+
+         tests.push_back( test );
+      }
+
+      invalidStateBuffers_ = std::move( buffers );
+      rangeTests_ = std::move( tests );
+   }
+
+   size_t RecordCompactor::compact( const std::vector<SourceDestBuffer> &dbufs, size_t first,
+                                    size_t end )
+   {
+      constexpr size_t cBlockSize = 256;
+
+      double values[cBlockSize];
+      bool keep[cBlockSize];
+
+      kept_.clear();
+
+      // Test a block of records at a time, one field after the other
+      for ( size_t block = first; block < end; block += cBlockSize )
+      {
+         const size_t cCount = std::min( cBlockSize, end - block );
+
+         std::fill( keep, keep + cCount, true );
+
+         for ( const size_t cIndex : invalidStateBuffers_ )
+         {
+            dbufs[cIndex].impl()->getElementsAsDouble( block, cCount, values );
+
+            for ( size_t i = 0; i < cCount; ++i )
+            {
+               keep[i] = keep[i] && ( values[i] == 0.0 );
+            }
+         }
+
+         for ( const auto &test : rangeTests_ )
+         {
+            dbufs[test.buffer].impl()->getElementsAsDouble( block, cCount, values );
+
+            const double cMinimum = test.minimum;
+            const double cMaximum = test.maximum;
+
+            for ( size_t i = 0; i < cCount; ++i )
+            {
+               keep[i] = keep[i] && ( values[i] >= cMinimum ) && ( values[i] <= cMaximum );
+            }
+         }
+
+         for ( size_t i = 0; i < cCount; ++i )
+         {
+            if ( keep[i] )
+            {
+               kept_.push_back( static_cast<uint32_t>( block - first + i ) );
+            }
+         }
+      }
+
+      if ( kept_.size() == end - first )
+      {
+         return end;
+      }
+
+      for ( const auto &dbuf : dbufs )
+      {
+         dbuf.impl()->keepElements( first, kept_.data(), kept_.size() );
+      }
+
+      return first + kept_.size();
+   }
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "Common.h"
+
+namespace e57
+{
+   /// Drops the records which don't pass a RecordFilter from the buffers of a reader after they
+   /// are decoded, moving the records kept down over them so the buffers only hold those.
+   class RecordCompactor
+   {
+   public:
+      /// Keep every record
+      RecordCompactor() = default;
+
+      explicit RecordCompactor( const RecordFilter &filter );
+
+      bool keepsAll() const
+      {
+         return filter_.invalidStateFields.empty() && filter_.ranges.empty();
+      }
+
+      const RecordFilter &filter() const
+      {
+         return filter_;
+      }
+
+      /// Find the buffers of the fields of the filter in @a dbufs, the buffers of the reader of
+      /// records with the prototype @a proto.
+      void bind( const NodeImplSharedPtr &proto, const std::vector<SourceDestBuffer> &dbufs );
+
+      /// Drop the records from @a first to @a end of @a dbufs which don't pass the filter. The
+      /// records before @a first have already been kept. Returns the number of records kept in
+      /// all, which is where the next records are stored.
+      size_t compact( const std::vector<SourceDestBuffer> &dbufs, size_t first, size_t end );
+
+   private:
+      /// A range of filter_.ranges, in the units of the values in its buffer
+      struct RangeTest
+      {
+         size_t buffer = 0; ///< index in the buffers
+         double minimum = 0.0;
+         double maximum = 0.0;
+      };
+
+      RecordFilter filter_;
+
+      /// Index in the buffers of each of filter_.invalidStateFields
+      std::vector<size_t> invalidStateBuffers_;
+
+      std::vector<RangeTest> rangeTests_;
+
+      /// Records kept by compact(), from its first record
+      std::vector<uint32_t> kept_;
+   };
+}
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+
+#include "Common.h"
+
+namespace e57
+{
+   /// Decides which records of a compressed vector a reader returns (see RecordSampling). Whether
+   /// a record is kept only depends on its number, so every decoder of a reader keeps the same
+   /// records without sharing any state.
+   class RecordSampler
+   {
+   public:
+      /// Keep every record
+      RecordSampler() = default;
+
+      explicit RecordSampler( const RecordSampling &sampling ) :
+         step_( sampling.step ), seed_( sampling.seed )
+      {
+         if ( sampling.rate < 1.0 )
+         {
+            random_ = true;
+            threshold_ = ( sampling.rate <= 0.0 )
+                            ? 0
+                            : static_cast<uint64_t>( sampling.rate * 18446744073709551616.0 );
+         }
+      }
+
+      bool keepsAll() const
+      {
+         return ( step_ == 1 ) && !random_;
+      }
+
+      bool keeps( uint64_t record ) const
+      {
+         return ( ( record % step_ ) == 0 ) && ( !random_ || chosen( record ) );
+      }
+
+      /// Number of the first record kept from @a record, or @a end if there isn't one before it.
+      uint64_t nextKept( uint64_t record, uint64_t end ) const
+      {
+         const uint64_t cRemainder = record % step_;
+
+         if ( cRemainder != 0 )
+         {
+            // Don't wrap around near the largest record numbers
+            if ( record > end - std::min( end, step_ - cRemainder ) )
+            {
+               return end;
+            }
+
+            record += step_ - cRemainder;
+         }
+
+         while ( ( record < end ) && random_ && !chosen( record ) )
+         {
+            record = ( end - record > step_ ) ? record + step_ : end;
+         }
+
+         return std::min( record, end );
+      }
+
+      /// Number of the @a available records starting with record @a first which can be consumed
+      /// while keeping at most @a room of them. This stops just before the first kept record which
+      /// doesn't fit.
+      uint64_t consumable( uint64_t first, uint64_t available, uint64_t room ) const
+      {
+         if ( keepsAll() )
+         {
+            return std::min( available, room );
+         }
+
+         const uint64_t cEnd = first + available;
+         uint64_t record = first;
+
+         for ( uint64_t kept = 0;; ++kept )
+         {
+            record = nextKept( record, cEnd );
+
+            if ( ( record == cEnd ) || ( kept == room ) )
+            {
+               return record - first;
+            }
+
+            ++record;
+         }
+      }
+
+      /// Number of records kept among the @a count records starting with record @a first.
+      uint64_t keptCount( uint64_t first, uint64_t count ) const
+      {
+         if ( keepsAll() )
+         {
+            return count;
+         }
+
+         const uint64_t cEnd = first + count;
+         uint64_t kept = 0;
+
+         for ( uint64_t record = nextKept( first, cEnd ); record < cEnd;
+               record = nextKept( record + 1, cEnd ) )
+         {
+            ++kept;
+         }
+
+         return kept;
+      }
+
+      /// Call @a function with the index (from @a first) of each record kept among the @a count
+      /// records starting with record @a first.
+      template <typename Function>
+      void forEachKept( uint64_t first, uint64_t count, Function function ) const
+      {
+         const uint64_t cEnd = first + count;
+
+         for ( uint64_t record = nextKept( first, cEnd ); record < cEnd;
+               record = nextKept( record + 1, cEnd ) )
+         {
+            function( static_cast<size_t>( record - first ) );
+         }
+      }
+
+   private:
+      // Mix the bits of the record number (the SplitMix64 finalizer), so neighbouring records are
+      // chosen independently.
+      bool chosen( uint64_t record ) const
+      {
+         uint64_t z = record + seed_ + 0x9e3779b97f4a7c15ULL;
+
+         z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+         z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+         z ^= z >> 31;
+
+         return z < threshold_;
+      }
+
+      uint64_t step_ = 1;
+      uint64_t seed_ = 0;
+
+      bool random_ = false;
+      uint64_t threshold_ = std::numeric_limits<uint64_t>::max();
+   };
+}
@@ -39,6 +39,7 @@ namespace e57
       NodeImpl( destImageFile ), value_( rawValue ), minimum_( minimum ), maximum_( maximum ),
       scale_( scale ), offset_( offset )
    {
+      memory_.set( Memory::Nodes, sizeof( *this ) );
    }
 
    ScaledIntegerNodeImpl::ScaledIntegerNodeImpl( ImageFileImplWeakPtr destImageFile,
@@ -51,6 +52,7 @@ namespace e57
       maximum_( static_cast<int64_t>( std::floor( ( scaledMaximum - offset ) / scale + .5 ) ) ),
       scale_( scale ), offset_( offset )
    {
+      memory_.set( Memory::Nodes, sizeof( *this ) );
    }
 
    // Throw an exception if the value is not within bounds.
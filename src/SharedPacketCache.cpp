@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include "SharedPacketCache.h"
+#include "StringFunctions.h"
+
+using namespace e57;
+
+SharedPacketCache::SharedPacketCache( uint64_t byteBudget, unsigned shardCount ) :
+   shardCount_( shardCount )
+{
+   if ( ( byteBudget == 0 ) || ( shardCount == 0 ) )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "byteBudget=" + toString( byteBudget ) +
+                                                    " shardCount=" + toString( shardCount ) );
+   }
+
+   shardBudget_ = byteBudget / shardCount;
+   shards_.reset( new Shard[shardCount] );
+}
+
+std::shared_ptr<const SharedPacket> SharedPacketCache::find( uint64_t logicalOffset )
+{
+   Shard &shard = shardFor( logicalOffset );
+
+   std::lock_guard<std::mutex> guard( shard.mutex );
+
+   const auto cFound = shard.index.find( logicalOffset );
+
+   if ( cFound == shard.index.end() )
+   {
+      missCount_.fetch_add( 1, std::memory_order_relaxed );
+      return nullptr;
+   }
+
+   hitCount_.fetch_add( 1, std::memory_order_relaxed );
+
+   // Move it to the front of the list
+   shard.packets.splice( shard.packets.begin(), shard.packets, cFound->second );
+
+   return *cFound->second;
+}
+
+bool SharedPacketCache::contains( uint64_t logicalOffset ) const
+{
+   const Shard &shard = shardFor( logicalOffset );
+
+   std::lock_guard<std::mutex> guard( shard.mutex );
+
+   return shard.index.count( logicalOffset ) != 0;
+}
+
+std::shared_ptr<const SharedPacket> SharedPacketCache::insert(
+   std::shared_ptr<const SharedPacket> packet )
+{
+   const uint64_t cLogicalOffset = packet->logicalOffset;
+   Shard &shard = shardFor( cLogicalOffset );
+
+   std::lock_guard<std::mutex> guard( shard.mutex );
+
+   const auto cFound = shard.index.find( cLogicalOffset );
+
+   if ( cFound != shard.index.end() )
+   {
+      shard.packets.splice( shard.packets.begin(), shard.packets, cFound->second );
+
+      return *cFound->second;
+   }
+
+   shard.packets.push_front( packet );
+   shard.index.emplace( cLogicalOffset, shard.packets.begin() );
+   shard.byteCount += packetBytes( *packet );
+
+   // Always keep the packet just added, even if it is larger than the budget of the shard
+   while ( ( ( shard.byteCount > shardBudget_ ) || Memory::overBudget() ) &&
+           ( shard.packets.size() > 1 ) )
+   {
+      const auto &cOldest = shard.packets.back();
+
+      shard.byteCount -= packetBytes( *cOldest );
+      shard.index.erase( cOldest->logicalOffset );
+      shard.packets.pop_back();
+
+      evictionCount_.fetch_add( 1, std::memory_order_relaxed );
+   }
+
+   return packet;
+}
+
+uint64_t SharedPacketCache::byteCount() const
+{
+   uint64_t count = 0;
+
+   for ( unsigned i = 0; i < shardCount_; ++i )
+   {
+      std::lock_guard<std::mutex> guard( shards_[i].mutex );
+
+      count += shards_[i].byteCount;
+   }
+
+   return count;
+}
+
+SharedPacketCache::Shard &SharedPacketCache::shardFor( uint64_t logicalOffset ) const
+{
+   // Packets next to each other are read together, so spread them over the shards
+   const uint64_t cHash = ( logicalOffset * 0x9E3779B97F4A7C15ull ) >> 32;
+
+   return shards_[cHash % shardCount_];
+}
+
+uint64_t SharedPacketCache::packetBytes( const SharedPacket &packet )
+{
+   return sizeof( SharedPacket ) + packet.buffer.capacity() +
+          packet.bytestreamOffsets.capacity() * sizeof( unsigned );
+}
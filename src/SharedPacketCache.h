@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Common.h"
+#include "Memory.h"
+
+namespace e57
+{
+   /// A verified packet of the file, shared by the readers which use it.
+   struct SharedPacket
+   {
+      uint64_t logicalOffset = 0;
+
+      /// The packet, at least as long as a data packet header so its type & length can always be
+      /// read through a DataPacket
+      Memory::AlignedVector<char> buffer;
+
+      /// For a data packet, where each bytestream starts in buffer, and where the last one ends
+      std::vector<unsigned> bytestreamOffsets;
+
+      /// Counts the packet while it is in memory, in the cache or locked by a reader
+      Memory::Charge memory;
+   };
+
+   /// Packets shared by all the CompressedVectorReaders of an ImageFile (see
+   /// ImageFile::setSharedPacketCache()), so readers which overlap read each packet once.
+   ///
+   /// The packets are spread over shards by their offset, each with its own lock and least
+   /// recently used list, so readers on different threads rarely wait for each other. Each shard
+   /// keeps its packets within its part of the byte budget. The packets are reference counted: one
+   /// evicted while a reader still has it locked stays in memory until that reader unlocks it, but
+   /// no longer counts against the budget.
+   class SharedPacketCache
+   {
+   public:
+      SharedPacketCache( uint64_t byteBudget, unsigned shardCount );
+
+      SharedPacketCache( const SharedPacketCache & ) = delete;
+      SharedPacketCache &operator=( const SharedPacketCache & ) = delete;
+
+      /// The packet at @a logicalOffset, or nullptr if it isn't in the cache. Counts a hit or a
+      /// miss.
+      std::shared_ptr<const SharedPacket> find( uint64_t logicalOffset );
+
+      /// True if the packet at @a logicalOffset is in the cache. Counts nothing.
+      bool contains( uint64_t logicalOffset ) const;
+
+      /// Add @a packet, evicting the least recently used packets of its shard to stay within the
+      /// budget (and within the memory budget of the library, see Memory::setBudget()). If another
+      /// reader added the same packet first, that one is kept and returned.
+      std::shared_ptr<const SharedPacket> insert( std::shared_ptr<const SharedPacket> packet );
+
+      /// Bytes of the packets in the cache
+      uint64_t byteCount() const;
+
+      uint64_t hitCount() const
+      {
+         return hitCount_.load( std::memory_order_relaxed );
+      }
+
+      uint64_t missCount() const
+      {
+         return missCount_.load( std::memory_order_relaxed );
+      }
+
+      uint64_t evictionCount() const
+      {
+         return evictionCount_.load( std::memory_order_relaxed );
+      }
+
+   private:
+      using PacketList = std::list<std::shared_ptr<const SharedPacket>>;
+
+      struct Shard
+      {
+         mutable std::mutex mutex;
+
+         /// Most recently used first
+         PacketList packets;
+         std::unordered_map<uint64_t, PacketList::iterator> index;
+
+         uint64_t byteCount = 0;
+      };
+
+      Shard &shardFor( uint64_t logicalOffset ) const;
+
+      static uint64_t packetBytes( const SharedPacket &packet );
+
+      uint64_t shardBudget_ = 0;
+      std::unique_ptr<Shard[]> shards_;
+      unsigned shardCount_ = 0;
+
+      std::atomic<uint64_t> hitCount_{ 0 };
+      std::atomic<uint64_t> missCount_{ 0 };
+      std::atomic<uint64_t> evictionCount_{ 0 };
+   };
+}
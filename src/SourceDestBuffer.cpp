@@ -48,6 +48,7 @@ void SourceDestBuffer::checkInvariant( bool /*doRecurse*/ ) const
 
          case Int16:
          case UInt16:
+         case Real16:
             return 2;
 
          case Int32:
@@ -87,10 +88,11 @@ the connection to the CompressedVectorNode field (i.e. the field's path name in
 
 The type of buffer element may be an assortment of built-in C++ memory types. There are all
 combinations of signed/unsigned and 8/16/32/64 bit integers (except unsigned 64bit integer, which is
-not supported in the ASTM standard), bool, float, double, as well as a vector of variable length
-unicode strings. The compiler selects the appropriate constructor automatically based on the type of
-the buffer array. However, the API user is responsible for reporting the correct length and stride
-options (otherwise unspecified behavior can occur).
+not supported in the ASTM standard), bool, float, double, half precision float (e57::Float16), as
+well as a vector of variable length unicode strings. The compiler selects the appropriate
+constructor automatically based on the type of the buffer array. However, the API user is
+responsible for reporting the correct length and stride options (otherwise unspecified behavior can
+occur).
 
 The connection of the SourceDestBuffer to a CompressedVectorNode field is established by specifying
 the pathName. There are several options to this connection: doConversion and doScaling, which are
@@ -258,6 +260,16 @@ SourceDestBuffer::SourceDestBuffer( const ImageFile &destImageFile, const ustrin
    impl_->setTypeInfo<double>( b, stride );
 }
 
+/// @overload
+SourceDestBuffer::SourceDestBuffer( const ImageFile &destImageFile, const ustring &pathName,
+                                    Float16 *b, const size_t capacity, bool doConversion,
+                                    bool doScaling, size_t stride ) :
+   impl_( new SourceDestBufferImpl( destImageFile.impl(), pathName, capacity, doConversion,
+                                    doScaling ) )
+{
+   impl_->setTypeInfo<Float16>( b, stride );
+}
+
 /*!
 @brief Designate vector of strings to transfer data to/from a CompressedVector as a block.
 
@@ -302,6 +314,49 @@ SourceDestBuffer::SourceDestBuffer( const ImageFile &destImageFile, const ustrin
 {
 }
 
+/*!
+@brief Designate a StringArena to transfer strings to/from a CompressedVector as a block.
+
+@param [in] destImageFile The ImageFile where the new node will eventually be stored.
+@param [in] pathName The pathname of the field in CompressedVectorNode that will transfer data
+to/from.
+@param [in] b The caller created arena of strings to transfer from/to.
+@param [in] capacity The maximum number of strings transferred in one block.
+
+@details
+This overloaded form of the SourceDestBuffer constructor is like the one taking a vector<ustring>,
+but the strings are stored one after another in @a b instead of in a string each, so no memory is
+allocated for each string.
+
+When writing, the first @a capacity strings of @a b are the source. When reading, @a b is cleared
+when the first string of a block is stored, and the strings read are appended to it, so after a read
+@a b->size() is the number of records read. The memory allocated by @a b is reused from one block to
+the next. The API user is responsible for ensuring that the lifetime of @a b exceeds the time that
+it is used in transfers.
+
+@pre capacity must be > 0.
+@pre The @a destImageFile must be open (i.e. destImageFile.isOpen() must be true).
+
+@throw ::ErrorBadAPIArgument
+@throw ::ErrorBadPathName
+@throw ::ErrorBadBuffer
+@throw ::ErrorImageFileNotOpen
+@throw ::ErrorInternal All objects in undocumented state
+
+@see SourceDestBuffer(const ImageFile&, const ustring&, std::vector<ustring>*)
+*/
+SourceDestBuffer::SourceDestBuffer( const ImageFile &destImageFile, const ustring &pathName,
+                                    StringArena *b, size_t capacity ) :
+   impl_( new SourceDestBufferImpl( destImageFile.impl(), pathName, b, capacity ) )
+{
+}
+
+/// @cond documentNonPublic The following isn't part of the API, and isn't documented.
+SourceDestBuffer::SourceDestBuffer( std::shared_ptr<SourceDestBufferImpl> ni ) : impl_( ni )
+{
+}
+/// @endcond
+
 /*!
 @brief Get path name in prototype that this SourceDestBuffer will transfer data to/from.
 
@@ -380,8 +435,9 @@ size_t SourceDestBuffer::capacity() const
 The API user must explicitly request conversion between basic representation groups in memory and on
 the disk. The four basic representation groups are: integer, boolean, floating point, and string.
 There is no distinction between integer and boolean groups on the disk (they both use IntegerNode).
-A explicit request for conversion between single and double precision floating point representations
-is not required.
+A explicit request for conversion between half, single and double precision floating point
+representations is not required. Values are rounded to the nearest half precision float, and values
+too large for one are an error (::ErrorValueNotRepresentable).
 
 The most useful conversion is between integer and floating point representation groups. Conversion
 from integer to floating point representations cannot result in an overflow, and is usually
@@ -25,14 +25,397 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <limits>
 
+#include "BitPack.h"
+#include "HalfFloat.h"
 #include "ImageFileImpl.h"
 #include "SourceDestBufferImpl.h"
 #include "StringFunctions.h"
 
 using namespace e57;
 
+namespace
+{
+   /// Integers in this range convert to double exactly in BitPack::scale()
+   constexpr int64_t cBitPackScaleLimit = int64_t( 1 ) << 51;
+
+   /// Number of values converted at a time by the block functions which need temporary storage
+   constexpr size_t cConversionBlockSize = 256;
+
+   template <typename T> inline T &elementAt( char *base, size_t stride, size_t index )
+   {
+      return *reinterpret_cast<T *>( base + index * stride );
+   }
+
+   /// Elements of a buffer with any stride
+   template <typename T> struct StridedElements
+   {
+      char *base;
+      size_t stride;
+
+      T &operator[]( size_t index ) const
+      {
+         return elementAt<T>( base, stride, index );
+      }
+   };
+
+   /// Elements of a tightly packed buffer (stride == sizeof( T )). Loops using this are plain
+   /// array loops which compilers can vectorize.
+   template <typename T> struct PackedElements
+   {
+      T *base;
+
+      T &operator[]( size_t index ) const
+      {
+         return base[index];
+      }
+   };
+
+   /// Call @a func with the elements starting at @a base, using PackedElements if the buffer is
+   /// tightly packed and StridedElements otherwise.
+   template <typename T, typename Func> auto withElements( char *base, size_t stride, Func func )
+   {
+      if ( stride == sizeof( T ) )
+      {
+         return func( PackedElements<T>{ reinterpret_cast<T *>( base ) } );
+      }
+
+      return func( StridedElements<T>{ base, stride } );
+   }
+
+   /// Copy the element at @a base to the @a count elements following it.
+   template <typename T> void repeatElement( char *base, size_t stride, size_t count )
+   {
+      const T cValue = elementAt<T>( base, stride, 0 );
+
+      withElements<T>( base + stride, stride, [=]( auto elements ) {
+         for ( size_t i = 0; i < count; ++i )
+         {
+            elements[i] = cValue;
+         }
+      } );
+   }
+
+   /// Move the elements at the increasing @a indices (from @a base, each at least its position in
+   /// @a indices) to the @a count elements starting at @a base.
+   template <typename T>
+   void moveElements( char *base, size_t stride, const uint32_t *indices, size_t count )
+   {
+      withElements<T>( base, stride, [=]( auto elements ) {
+         for ( size_t i = 0; i < count; ++i )
+         {
+            elements[i] = elements[indices[i]];
+         }
+      } );
+   }
+
+   /// Store @a count values converted to T without any checks.
+   template <typename T, typename V>
+   void storeConverted( char *base, size_t stride, const V *values, size_t count )
+   {
+      if ( std::is_same<T, V>::value && ( stride == sizeof( T ) ) )
+      {
+         memcpy( base, values, count * sizeof( T ) );
+         return;
+      }
+
+      withElements<T>( base, stride, [=]( auto elements ) {
+         for ( size_t i = 0; i < count; ++i )
+         {
+            elements[i] = static_cast<T>( values[i] );
+         }
+      } );
+   }
+
+   /// Load @a count elements of type T converted to V without any checks.
+   template <typename T, typename V>
+   void loadConverted( char *base, size_t stride, V *values, size_t count )
+   {
+      if ( std::is_same<T, V>::value && ( stride == sizeof( T ) ) )
+      {
+         memcpy( values, base, count * sizeof( T ) );
+         return;
+      }
+
+      withElements<T>( base, stride, [=]( auto elements ) {
+         for ( size_t i = 0; i < count; ++i )
+         {
+            values[i] = static_cast<V>( elements[i] );
+         }
+      } );
+   }
+
+   /// Store values which must be within the range of integer type T, stopping at the first one
+   /// which isn't. Returns the number stored. Without @a checked, the values are known to be in
+   /// range and are all stored.
+   template <typename T, typename V>
+   size_t storeInRange( char *base, size_t stride, const V *values, size_t count, bool checked )
+   {
+      if ( !checked )
+      {
+         storeConverted<T>( base, stride, values, count );
+         return count;
+      }
+
+      const auto cMin = static_cast<V>( std::numeric_limits<T>::min() );
+      const auto cMax = static_cast<V>( std::numeric_limits<T>::max() );
+
+      return withElements<T>( base, stride, [=]( auto elements ) {
+         for ( size_t i = 0; i < count; ++i )
+         {
+            if ( values[i] < cMin || cMax < values[i] )
+            {
+               return i;
+            }
+
+            elements[i] = static_cast<T>( values[i] );
+         }
+
+         return count;
+      } );
+   }
+
+   /// Store x*scale+offset rounded to the nearest integer for values which must be within the
+   /// range of integer type T, stopping at the first one which isn't. Returns the number stored.
+   /// Without @a checked, the values are known to be in range and are all stored.
+   template <typename T>
+   size_t storeScaledInRange( char *base, size_t stride, const int64_t *values, size_t count,
+                              double scale, double offset, bool checked, double &badValue )
+   {
+      if ( !checked )
+      {
+         withElements<T>( base, stride, [=]( auto elements ) {
+            for ( size_t i = 0; i < count; ++i )
+            {
+               elements[i] = static_cast<T>( floor( values[i] * scale + offset + 0.5 ) );
+            }
+         } );
+
+         return count;
+      }
+
+      const auto cMin = static_cast<double>( std::numeric_limits<T>::min() );
+      const auto cMax = static_cast<double>( std::numeric_limits<T>::max() );
+
+      return withElements<T>( base, stride, [=, &badValue]( auto elements ) {
+         for ( size_t i = 0; i < count; ++i )
+         {
+            const double scaledValue = floor( values[i] * scale + offset + 0.5 );
+
+            if ( scaledValue < cMin || cMax < scaledValue )
+            {
+               badValue = scaledValue;
+               return i;
+            }
+
+            elements[i] = static_cast<T>( scaledValue );
+         }
+
+         return count;
+      } );
+   }
+
+   /// Store x*scale+offset mapped from @a minimum - @a minimum + 1 / @a factor to 0 - 1 for
+   /// floating point T, to 0 - the largest value of T for unsigned integer T, or to -largest -
+   /// largest for signed integer T (as the signed normalized integers of GPUs), rounded to the
+   /// nearest integer. Values outside the limits (and NaNs) are clamped.
+   template <typename T, typename V>
+   void storeNormalized( char *base, size_t stride, const V *values, size_t count, double scale,
+                         double offset, double minimum, double factor )
+   {
+      constexpr bool cIntegral = std::is_integral<T>::value;
+      constexpr bool cSigned = cIntegral && std::is_signed<T>::value;
+
+      const double cTop = cIntegral ? static_cast<double>( std::numeric_limits<T>::max() ) : 1.0;
+      const double cBottom = cSigned ? -cTop : 0.0;
+      const double cRange = cTop - cBottom;
+
+      // Fold the scaling & the normalization into one multiply-add per value
+      const double cScale = scale * factor * cRange;
+      const double cOffset = ( offset - minimum ) * factor * cRange + cBottom;
+
+      withElements<T>( base, stride, [=]( auto elements ) {
+         for ( size_t i = 0; i < count; ++i )
+         {
+            const double cValue = std::min( static_cast<double>( values[i] ) * cScale + cOffset,
+                                            cTop );
+
+            // In this order a NaN becomes the bottom of the range
+            const double cClamped = std::max( cBottom, cValue );
+
+            if ( cSigned )
+            {
+               elements[i] = static_cast<T>( floor( cClamped + 0.5 ) );
+            }
+            else
+            {
+               elements[i] = static_cast<T>( cClamped + ( cIntegral ? 0.5 : 0.0 ) );
+            }
+         }
+      } );
+   }
+
+   /// Store @a value rounded to a half precision float at @a p
+   inline void storeHalf( char *p, float value )
+   {
+      *reinterpret_cast<uint16_t *>( p ) = HalfFloat::fromFloat( value );
+   }
+
+   /// Load the half precision float at @a p
+   inline float loadHalf( const char *p )
+   {
+      return HalfFloat::toFloat( *reinterpret_cast<const uint16_t *>( p ) );
+   }
+
+   /// Store @a count values as half precision floats, converted a block at a time through floats,
+   /// stopping at the first one too large for a half. Returns the number stored. Without
+   /// @a checked, the values are known to be in range and are all stored.
+   template <typename V>
+   size_t storeHalves( char *base, size_t stride, const V *values, size_t count, bool checked )
+   {
+      float floats[cConversionBlockSize];
+      uint16_t halves[cConversionBlockSize];
+
+      for ( size_t first = 0; first < count; first += cConversionBlockSize )
+      {
+         const size_t cBlockCount = std::min( cConversionBlockSize, count - first );
+         size_t blockDone = cBlockCount;
+
+         for ( size_t i = 0; i < cBlockCount; ++i )
+         {
+            const auto cValue = static_cast<double>( values[first + i] );
+
+            if ( checked && ( cValue < -HalfFloat::cMaximum || HalfFloat::cMaximum < cValue ) )
+            {
+               blockDone = i;
+               break;
+            }
+
+            floats[i] = static_cast<float>( cValue );
+         }
+
+         HalfFloat::fromFloats( floats, blockDone, halves );
+         storeConverted<uint16_t>( base + first * stride, stride, halves, blockDone );
+
+         if ( blockDone != cBlockCount )
+         {
+            return first + blockDone;
+         }
+      }
+
+      return count;
+   }
+
+   /// Load @a count half precision floats converted to V, a block at a time through floats.
+   template <typename V> void loadHalves( char *base, size_t stride, V *values, size_t count )
+   {
+      uint16_t halves[cConversionBlockSize];
+      float floats[cConversionBlockSize];
+
+      for ( size_t first = 0; first < count; first += cConversionBlockSize )
+      {
+         const size_t cBlockCount = std::min( cConversionBlockSize, count - first );
+
+         loadConverted<uint16_t>( base + first * stride, stride, halves, cBlockCount );
+         HalfFloat::toFloats( halves, cBlockCount, floats );
+
+         for ( size_t i = 0; i < cBlockCount; ++i )
+         {
+            values[first + i] = static_cast<V>( floats[i] );
+         }
+      }
+   }
+
+   /// Store the half precision floats of storeNormalized()
+   template <typename V>
+   void storeNormalizedHalf( char *base, size_t stride, const V *values, size_t count,
+                             double scale, double offset, double minimum, double factor )
+   {
+      float floats[cConversionBlockSize];
+      uint16_t halves[cConversionBlockSize];
+
+      for ( size_t first = 0; first < count; first += cConversionBlockSize )
+      {
+         const size_t cBlockCount = std::min( cConversionBlockSize, count - first );
+
+         storeNormalized<float>( reinterpret_cast<char *>( floats ), sizeof( float ),
+                                 values + first, cBlockCount, scale, offset, minimum, factor );
+         HalfFloat::fromFloats( floats, cBlockCount, halves );
+         storeConverted<uint16_t>( base + first * stride, stride, halves, cBlockCount );
+      }
+   }
+
+   /// Load (x-offset)/scale rounded to the nearest integer, stopping at the first one which isn't
+   /// representable in an int64_t. Returns the number loaded.
+   template <typename T>
+   size_t loadScaled( char *base, size_t stride, int64_t *values, size_t count, double scale,
+                      double offset, double &badValue )
+   {
+      return withElements<T>( base, stride, [=, &badValue]( auto elements ) {
+         for ( size_t i = 0; i < count; ++i )
+         {
+            const double doubleRawValue =
+               floor( ( static_cast<double>( elements[i] ) - offset ) / scale + 0.5 );
+
+            if ( doubleRawValue < INT64_MIN ||
+                 ( doubleRawValue > static_cast<double>( INT64_MAX ) ) )
+            {
+               badValue = doubleRawValue;
+               return i;
+            }
+
+            values[i] = static_cast<int64_t>( doubleRawValue );
+         }
+
+         return count;
+      } );
+   }
+
+   /// loadScaled() for half precision floats, converted a block at a time through floats.
+   size_t loadScaledHalves( char *base, size_t stride, int64_t *values, size_t count,
+                            double scale, double offset, double &badValue )
+   {
+      float floats[cConversionBlockSize];
+
+      for ( size_t first = 0; first < count; first += cConversionBlockSize )
+      {
+         const size_t cBlockCount = std::min( cConversionBlockSize, count - first );
+
+         loadHalves( base + first * stride, stride, floats, cBlockCount );
+
+         const size_t cBlockDone =
+            loadScaled<float>( reinterpret_cast<char *>( floats ), sizeof( float ),
+                               values + first, cBlockCount, scale, offset, badValue );
+
+         if ( cBlockDone != cBlockCount )
+         {
+            return first + cBlockDone;
+         }
+      }
+
+      return count;
+   }
+
+   /// Returns the index of the first of @a count values which is too large for a float, or
+   /// @a count if they all fit.
+   template <typename V> size_t findFloatOutOfRange( const V *values, size_t count )
+   {
+      for ( size_t i = 0; i < count; ++i )
+      {
+         if ( values[i] < DOUBLE_MIN || DOUBLE_MAX < values[i] )
+         {
+            return i;
+         }
+      }
+
+      return count;
+   }
+}
+
 SourceDestBufferImpl::SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile,
                                             const ustring &pathName, const size_t capacity,
                                             bool doConversion, bool doScaling ) :
@@ -43,7 +426,8 @@ SourceDestBufferImpl::SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile,
 
 template <typename T> void SourceDestBufferImpl::setTypeInfo( T *base, size_t stride )
 {
-   static_assert( std::is_integral<T>::value || std::is_floating_point<T>::value,
+   static_assert( std::is_integral<T>::value || std::is_floating_point<T>::value ||
+                     std::is_same<T, Float16>::value,
                   "Integral or floating point required." );
 
    base_ = reinterpret_cast<char *>( base );
@@ -91,6 +475,10 @@ template <typename T> void SourceDestBufferImpl::setTypeInfo( T *base, size_t st
    {
       memoryRepresentation_ = Real64;
    }
+   else if ( std::is_same<T, Float16>::value )
+   {
+      memoryRepresentation_ = Real16;
+   }
 
    checkState_();
 }
@@ -105,6 +493,7 @@ template void SourceDestBufferImpl::setTypeInfo<int64_t>( int64_t *base, size_t
 template void SourceDestBufferImpl::setTypeInfo<bool>( bool *base, size_t stride );
 template void SourceDestBufferImpl::setTypeInfo<float>( float *base, size_t stride );
 template void SourceDestBufferImpl::setTypeInfo<double>( double *base, size_t stride );
+template void SourceDestBufferImpl::setTypeInfo<Float16>( Float16 *base, size_t stride );
 
 SourceDestBufferImpl::SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile,
                                             const ustring &pathName, std::vector<ustring> *b ) :
@@ -128,6 +517,118 @@ SourceDestBufferImpl::SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile,
    /// stored in it.
 }
 
+SourceDestBufferImpl::SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile,
+                                            const ustring &pathName, StringArena *b,
+                                            size_t capacity ) :
+   destImageFile_( destImageFile ), pathName_( pathName ), memoryRepresentation_( UString ),
+   capacity_( capacity ), arena_( b )
+{
+   /// don't checkImageFileOpen, checkState_ will do it
+
+   if ( b == nullptr )
+   {
+      throw E57_EXCEPTION2( ErrorBadBuffer, "sdbuf.pathName=" + pathName );
+   }
+
+   if ( capacity == 0 )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "sdbuf.pathName=" + pathName );
+   }
+
+   checkState_();
+}
+
+void SourceDestBufferImpl::setNormalization( double minimum, double maximum )
+{
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+      case UInt8:
+      case Int16:
+      case UInt16:
+      case Int32:
+      case UInt32:
+      case Real16:
+      case Real32:
+      case Real64:
+         break;
+      default:
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "pathName=" + pathName_ + " memoryRepresentation=" +
+                                  toString( memoryRepresentation_ ) );
+   }
+
+   if ( !std::isfinite( minimum ) || !std::isfinite( maximum ) || !( minimum < maximum ) ||
+        !std::isfinite( 1.0 / ( maximum - minimum ) ) )
+   {
+      throw E57_EXCEPTION2( ErrorBadAPIArgument, "pathName=" + pathName_ +
+                                                    " minimum=" + toString( minimum ) +
+                                                    " maximum=" + toString( maximum ) );
+   }
+
+   normalizeMinimum_ = minimum;
+   normalizeScale_ = 1.0 / ( maximum - minimum );
+}
+
+void SourceDestBufferImpl::clearNormalization()
+{
+   normalizeMinimum_ = 0.0;
+   normalizeScale_ = 0.0;
+}
+
+template <typename T>
+void SourceDestBufferImpl::setNextNormalizedBlock_( const T *values, size_t count, double scale,
+                                                    double offset )
+{
+   checkBlockRoom_( count );
+
+   char *p = &base_[nextIndex_ * stride_];
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         storeNormalized<int8_t>( p, stride_, values, count, scale, offset, normalizeMinimum_,
+                                  normalizeScale_ );
+         break;
+      case UInt8:
+         storeNormalized<uint8_t>( p, stride_, values, count, scale, offset, normalizeMinimum_,
+                                   normalizeScale_ );
+         break;
+      case Int16:
+         storeNormalized<int16_t>( p, stride_, values, count, scale, offset, normalizeMinimum_,
+                                   normalizeScale_ );
+         break;
+      case UInt16:
+         storeNormalized<uint16_t>( p, stride_, values, count, scale, offset, normalizeMinimum_,
+                                    normalizeScale_ );
+         break;
+      case Int32:
+         storeNormalized<int32_t>( p, stride_, values, count, scale, offset, normalizeMinimum_,
+                                   normalizeScale_ );
+         break;
+      case UInt32:
+         storeNormalized<uint32_t>( p, stride_, values, count, scale, offset, normalizeMinimum_,
+                                    normalizeScale_ );
+         break;
+      case Real16:
+         storeNormalizedHalf( p, stride_, values, count, scale, offset, normalizeMinimum_,
+                              normalizeScale_ );
+         break;
+      case Real32:
+         storeNormalized<float>( p, stride_, values, count, scale, offset, normalizeMinimum_,
+                                 normalizeScale_ );
+         break;
+      case Real64:
+         storeNormalized<double>( p, stride_, values, count, scale, offset, normalizeMinimum_,
+                                  normalizeScale_ );
+         break;
+      default:
+         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
 template <typename T> void SourceDestBufferImpl::_setNextReal( T inValue )
 {
    static_assert( std::is_same<T, double>::value || std::is_same<T, float>::value,
@@ -135,6 +636,12 @@ template <typename T> void SourceDestBufferImpl::_setNextReal( T inValue )
 
    /// don't checkImageFileOpen
 
+   if ( normalizes() )
+   {
+      setNextNormalizedBlock_( &inValue, 1, 1.0, 0.0 );
+      return;
+   }
+
    /// Verify have room
    if ( nextIndex_ >= capacity_ )
    {
@@ -266,6 +773,14 @@ template <typename T> void SourceDestBufferImpl::_setNextReal( T inValue )
 #endif
          }
          break;
+      case Real16:
+         if ( inValue < -HalfFloat::cMaximum || HalfFloat::cMaximum < inValue )
+         {
+            throw E57_EXCEPTION2( ErrorValueNotRepresentable,
+                                  "pathName=" + pathName_ + " value=" + toString( inValue ) );
+         }
+         storeHalf( p, static_cast<float>( inValue ) );
+         break;
       case Real64:
          //??? does this count as a conversion?
          *reinterpret_cast<double *>( p ) = static_cast<double>( inValue );
@@ -307,7 +822,7 @@ void SourceDestBufferImpl::checkState_() const
    }
    else
    {
-      if ( ustrings_ == nullptr )
+      if ( ( ustrings_ == nullptr ) && ( arena_ == nullptr ) )
       {
          throw E57_EXCEPTION2( ErrorBadBuffer, "pathName=" + pathName_ );
       }
@@ -367,6 +882,13 @@ int64_t SourceDestBufferImpl::getNextInt64()
          //??? fault if get special value: NaN, NegInf...
          value = static_cast<int64_t>( *reinterpret_cast<float *>( p ) );
          break;
+      case Real16:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         value = static_cast<int64_t>( loadHalf( p ) );
+         break;
       case Real64:
          if ( !doConversion_ )
          {
@@ -474,21 +996,31 @@ int64_t SourceDestBufferImpl::getNextInt64( double scale, double offset )
          /// floating point until sure is in bounds
          doubleRawValue = floor( ( *reinterpret_cast<float *>( p ) - offset ) / scale + 0.5 );
          break;
-      case Real64:
+      case Real16:
          if ( !doConversion_ )
          {
             throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
          }
-         //??? fault if get special value: NaN, NegInf...
 
          /// Calc (x-offset)/scale rounded to nearest integer, but keep in
          /// floating point until sure is in bounds
-         doubleRawValue = floor( ( *reinterpret_cast<double *>( p ) - offset ) / scale + 0.5 );
+         doubleRawValue = floor( ( loadHalf( p ) - offset ) / scale + 0.5 );
          break;
-      case UString:
-         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
-      default:
-         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+      case Real64:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         //??? fault if get special value: NaN, NegInf...
+
+         /// Calc (x-offset)/scale rounded to nearest integer, but keep in
+         /// floating point until sure is in bounds
+         doubleRawValue = floor( ( *reinterpret_cast<double *>( p ) - offset ) / scale + 0.5 );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+      default:
+         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
    }
 
    /// Make sure that value is representable in an int64_t
@@ -581,6 +1113,9 @@ float SourceDestBufferImpl::getNextFloat()
       case Real32:
          value = *reinterpret_cast<float *>( p );
          break;
+      case Real16:
+         value = loadHalf( p );
+         break;
       case Real64:
       {
          /// Check that exponent of user's value is not too large for single
@@ -681,6 +1216,9 @@ double SourceDestBufferImpl::getNextDouble()
       case Real32:
          value = static_cast<double>( *reinterpret_cast<float *>( p ) );
          break;
+      case Real16:
+         value = static_cast<double>( loadHalf( p ) );
+         break;
       case Real64:
          value = *reinterpret_cast<double *>( p );
          break;
@@ -697,26 +1235,63 @@ ustring SourceDestBufferImpl::getNextString()
 {
    /// don't checkImageFileOpen
 
-   /// Check have correct type buffer
+   const char *chars = nullptr;
+   size_t length = 0;
+
+   getNextString( chars, length );
+
+   return ustring( chars, length );
+}
+
+void SourceDestBufferImpl::getNextString( const char *&chars, size_t &length )
+{
+   /// don't checkImageFileOpen
+
    if ( memoryRepresentation_ != UString )
    {
       throw E57_EXCEPTION2( ErrorExpectingUString, "pathName=" + pathName_ );
    }
 
-   /// Verify index is within bounds
    if ( nextIndex_ >= capacity_ )
    {
       throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
    }
 
-   /// Get ustring from vector
-   return ( ( *ustrings_ )[nextIndex_++] );
+   if ( arena_ == nullptr )
+   {
+      const ustring &value = ( *ustrings_ )[nextIndex_++];
+
+      chars = value.data();
+      length = value.length();
+      return;
+   }
+
+   // Check the caller's offsets so a bad one can't read outside the arena
+   if ( ( nextIndex_ >= arena_->size() ) ||
+        ( arena_->offsets[nextIndex_ + 1] > arena_->bytes.size() ) ||
+        ( arena_->offsets[nextIndex_] > arena_->offsets[nextIndex_ + 1] ) )
+   {
+      throw E57_EXCEPTION2( ErrorBadBuffer,
+                            "pathName=" + pathName_ + " index=" + toString( nextIndex_ ) +
+                               " arenaSize=" + toString( arena_->size() ) );
+   }
+
+   chars = arena_->data( nextIndex_ );
+   length = arena_->length( nextIndex_ );
+
+   nextIndex_++;
 }
 
 void SourceDestBufferImpl::setNextInt64( int64_t value )
 {
    /// don't checkImageFileOpen
 
+   if ( normalizes() )
+   {
+      setNextNormalizedBlock_( &value, 1, 1.0, 0.0 );
+      return;
+   }
+
    /// Verify have room
    if ( nextIndex_ >= capacity_ )
    {
@@ -791,6 +1366,19 @@ void SourceDestBufferImpl::setNextInt64( int64_t value )
          //??? very large integers may lose some lowest bits here. error?
          *reinterpret_cast<float *>( p ) = static_cast<float>( value );
          break;
+      case Real16:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         if ( static_cast<double>( value ) < -HalfFloat::cMaximum ||
+              HalfFloat::cMaximum < static_cast<double>( value ) )
+         {
+            throw E57_EXCEPTION2( ErrorValueNotRepresentable,
+                                  "pathName=" + pathName_ + " value=" + toString( value ) );
+         }
+         storeHalf( p, static_cast<float>( value ) );
+         break;
       case Real64:
          if ( !doConversion_ )
          {
@@ -812,6 +1400,13 @@ void SourceDestBufferImpl::setNextInt64( int64_t value, double scale, double off
    /// Apply a scale and offset to numbers from file before putting in user's
    /// buffer.
 
+   /// Normalized values are always scaled, the limits being scaled values.
+   if ( normalizes() )
+   {
+      setNextNormalizedBlock_( &value, 1, scale, offset );
+      return;
+   }
+
    /// Incorporating the scale is optional (requested by user when constructing
    /// the sdbuf). If the user did not request scaling, then we send raw values
    /// to user's buffer.
@@ -834,7 +1429,8 @@ void SourceDestBufferImpl::setNextInt64( int64_t value, double scale, double off
 
    /// Calc x*scale+offset
    double scaledValue;
-   if ( memoryRepresentation_ == Real32 || memoryRepresentation_ == Real64 )
+   if ( memoryRepresentation_ == Real16 || memoryRepresentation_ == Real32 ||
+        memoryRepresentation_ == Real64 )
    {
       /// Value will be stored in some floating point rep in user's buffer, so
       /// keep full resolution here.
@@ -925,6 +1521,19 @@ void SourceDestBufferImpl::setNextInt64( int64_t value, double scale, double off
          }
          *reinterpret_cast<float *>( p ) = static_cast<float>( scaledValue );
          break;
+      case Real16:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         if ( scaledValue < -HalfFloat::cMaximum || HalfFloat::cMaximum < scaledValue )
+         {
+            throw E57_EXCEPTION2( ErrorScaledValueNotRepresentable,
+                                  "pathName=" + pathName_ +
+                                     " scaledValue=" + toString( scaledValue ) );
+         }
+         storeHalf( p, static_cast<float>( scaledValue ) );
+         break;
       case Real64:
          if ( !doConversion_ )
          {
@@ -950,6 +1559,11 @@ void SourceDestBufferImpl::setNextDouble( double value )
 }
 
 void SourceDestBufferImpl::setNextString( const ustring &value )
+{
+   setNextString( value.data(), value.length() );
+}
+
+void SourceDestBufferImpl::setNextString( const char *chars, size_t length )
 {
    /// don't checkImageFileOpen
 
@@ -964,87 +1578,963 @@ void SourceDestBufferImpl::setNextString( const ustring &value )
       throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
    }
 
-   /// Assign to already initialized element in vector
-   ( *ustrings_ )[nextIndex_] = value;
+   if ( arena_ != nullptr )
+   {
+      // A new block of strings replaces the previous one
+      if ( nextIndex_ == 0 )
+      {
+         arena_->clear();
+      }
+
+      arena_->append( chars, length );
+   }
+   else
+   {
+      /// Assign to already initialized element in vector, reusing its memory
+      ( *ustrings_ )[nextIndex_].assign( chars, length );
+   }
+
    nextIndex_++;
 }
 
-void SourceDestBufferImpl::checkCompatible(
-   const std::shared_ptr<SourceDestBufferImpl> &newBuf ) const
+void SourceDestBufferImpl::checkBlockRoom_( size_t count ) const
 {
-   if ( pathName_ != newBuf->pathName() )
+   if ( count > capacity_ - nextIndex_ )
    {
-      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
-                            "pathName=" + pathName_ + " newPathName=" + newBuf->pathName() );
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ + " count=" + toString( count ) +
+                                              " nextIndex=" + toString( nextIndex_ ) );
    }
-   if ( memoryRepresentation_ != newBuf->memoryRepresentation() )
+}
+
+void SourceDestBufferImpl::getNextInt64Block( int64_t *values, size_t count )
+{
+   /// don't checkImageFileOpen
+
+   checkBlockRoom_( count );
+
+   char *p = &base_[nextIndex_ * stride_];
+
+   switch ( memoryRepresentation_ )
    {
-      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
-                            "memoryRepresentation=" + toString( memoryRepresentation_ ) +
-                               " newMemoryType=" + toString( newBuf->memoryRepresentation() ) );
+      case Int8:
+         loadConverted<int8_t>( p, stride_, values, count );
+         break;
+      case UInt8:
+         loadConverted<uint8_t>( p, stride_, values, count );
+         break;
+      case Int16:
+         loadConverted<int16_t>( p, stride_, values, count );
+         break;
+      case UInt16:
+         loadConverted<uint16_t>( p, stride_, values, count );
+         break;
+      case Int32:
+         loadConverted<int32_t>( p, stride_, values, count );
+         break;
+      case UInt32:
+         loadConverted<uint32_t>( p, stride_, values, count );
+         break;
+      case Int64:
+         loadConverted<int64_t>( p, stride_, values, count );
+         break;
+      case Bool:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         /// Convert bool to 0/1
+         loadConverted<bool>( p, stride_, values, count );
+         break;
+      case Real32:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         loadConverted<float>( p, stride_, values, count );
+         break;
+      case Real16:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         loadHalves( p, stride_, values, count );
+         break;
+      case Real64:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         loadConverted<double>( p, stride_, values, count );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+      default:
+         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
    }
-   if ( capacity_ != newBuf->capacity() )
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
+void SourceDestBufferImpl::getNextInt64Block( int64_t *values, size_t count, double scale,
+                                              double offset )
+{
+   /// don't checkImageFileOpen
+
+   if ( !doScaling_ )
    {
-      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
-                            "capacity=" + toString( capacity_ ) +
-                               " newCapacity=" + toString( newBuf->capacity() ) );
+      getNextInt64Block( values, count );
+      return;
    }
-   if ( doConversion_ != newBuf->doConversion() )
+
+   /// Double check non-zero scale.  Going to divide by it below.
+   if ( scale == 0 )
    {
-      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
-                            "doConversion=" + toString( doConversion_ ) +
-                               "newDoConversion=" + toString( newBuf->doConversion() ) );
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
    }
-   if ( stride_ != newBuf->stride() )
+
+   checkBlockRoom_( count );
+
+   char *p = &base_[nextIndex_ * stride_];
+
+   size_t done = 0;
+   double badValue = 0.0;
+
+   switch ( memoryRepresentation_ )
    {
-      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
-                            "stride=" + toString( stride_ ) +
-                               " newStride=" + toString( newBuf->stride() ) );
+      case Int8:
+         done = loadScaled<int8_t>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case UInt8:
+         done = loadScaled<uint8_t>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case Int16:
+         done = loadScaled<int16_t>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case UInt16:
+         done = loadScaled<uint16_t>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case Int32:
+         done = loadScaled<int32_t>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case UInt32:
+         done = loadScaled<uint32_t>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case Int64:
+         done = loadScaled<int64_t>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case Bool:
+         done = loadScaled<bool>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case Real32:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         done = loadScaled<float>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case Real16:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         done = loadScaledHalves( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case Real64:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         done = loadScaled<double>( p, stride_, values, count, scale, offset, badValue );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+      default:
+         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( done );
+
+   if ( done != count )
+   {
+      throw E57_EXCEPTION2( ErrorScaledValueNotRepresentable,
+                            "pathName=" + pathName_ + " value=" + toString( badValue ) );
    }
 }
 
-#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
-void SourceDestBufferImpl::dump( int indent, std::ostream &os )
+template <typename T> void SourceDestBufferImpl::_getNextRealBlock( T *values, size_t count )
 {
+   static_assert( std::is_same<T, double>::value || std::is_same<T, float>::value,
+                  "_getNextRealBlock() requires float or double type" );
+
    /// don't checkImageFileOpen
 
-   os << space( indent ) << "pathName:             " << pathName_ << std::endl;
-   os << space( indent ) << "memoryRepresentation: ";
+   checkBlockRoom_( count );
+
+   char *p = &base_[nextIndex_ * stride_];
+
    switch ( memoryRepresentation_ )
    {
       case Int8:
-         os << "int8_t" << std::endl;
+      case UInt8:
+      case Int16:
+      case UInt16:
+      case Int32:
+      case UInt32:
+      case Int64:
+      case Bool:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         break;
+      default:
+         break;
+   }
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         loadConverted<int8_t>( p, stride_, values, count );
          break;
       case UInt8:
-         os << "uint8_t" << std::endl;
+         loadConverted<uint8_t>( p, stride_, values, count );
          break;
       case Int16:
-         os << "int16_t" << std::endl;
+         loadConverted<int16_t>( p, stride_, values, count );
          break;
       case UInt16:
-         os << "uint16_t" << std::endl;
+         loadConverted<uint16_t>( p, stride_, values, count );
          break;
       case Int32:
-         os << "int32_t" << std::endl;
+         loadConverted<int32_t>( p, stride_, values, count );
          break;
       case UInt32:
-         os << "uint32_t" << std::endl;
+         loadConverted<uint32_t>( p, stride_, values, count );
          break;
       case Int64:
-         os << "int64_t" << std::endl;
+         loadConverted<int64_t>( p, stride_, values, count );
          break;
       case Bool:
-         os << "bool" << std::endl;
+         /// Convert bool to 0/1
+         loadConverted<bool>( p, stride_, values, count );
          break;
       case Real32:
-         os << "float" << std::endl;
+         loadConverted<float>( p, stride_, values, count );
+         break;
+      case Real16:
+         loadHalves( p, stride_, values, count );
          break;
       case Real64:
-         os << "double" << std::endl;
+         if ( std::is_same<T, float>::value )
+         {
+            /// Check that exponent of user's value is not too large for single
+            /// precision number in file.
+            for ( size_t i = 0; i < count; ++i )
+            {
+               const double d = elementAt<double>( p, stride_, i );
+
+               if ( d < DOUBLE_MIN || DOUBLE_MAX < d )
+               {
+                  nextIndex_ += static_cast<unsigned>( i );
+
+                  throw E57_EXCEPTION2( ErrorReal64TooLarge,
+                                        "pathName=" + pathName_ + " value=" + toString( d ) );
+               }
+
+               values[i] = static_cast<T>( d );
+            }
+         }
+         else
+         {
+            loadConverted<double>( p, stride_, values, count );
+         }
          break;
       case UString:
-         os << "ustring" << std::endl;
-         break;
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+      default:
+         throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
+void SourceDestBufferImpl::getNextFloatBlock( float *values, size_t count )
+{
+   _getNextRealBlock( values, count );
+}
+
+void SourceDestBufferImpl::getNextDoubleBlock( double *values, size_t count )
+{
+   _getNextRealBlock( values, count );
+}
+
+void SourceDestBufferImpl::setNextInt64Block( const int64_t *values, size_t count )
+{
+   /// don't checkImageFileOpen
+
+   if ( normalizes() )
+   {
+      setNextNormalizedBlock_( values, count, 1.0, 0.0 );
+      return;
+   }
+
+   checkBlockRoom_( count );
+
+   char *p = &base_[nextIndex_ * stride_];
+
+   size_t done = count;
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         done = storeInRange<int8_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case UInt8:
+         done = storeInRange<uint8_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case Int16:
+         done = storeInRange<int16_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case UInt16:
+         done = storeInRange<uint16_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case Int32:
+         done = storeInRange<int32_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case UInt32:
+         done = storeInRange<uint32_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case Int64:
+         storeConverted<int64_t>( p, stride_, values, count );
+         break;
+      case Bool:
+         for ( size_t i = 0; i < count; ++i )
+         {
+            elementAt<bool>( p, stride_, i ) = ( values[i] ? false : true );
+         }
+         break;
+      case Real32:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         //??? very large integers may lose some lowest bits here. error?
+         storeConverted<float>( p, stride_, values, count );
+         break;
+      case Real16:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         done = storeHalves( p, stride_, values, count, rangeChecks_ );
+         break;
+      case Real64:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         storeConverted<double>( p, stride_, values, count );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( done );
+
+   if ( done != count )
+   {
+      throw E57_EXCEPTION2( ErrorValueNotRepresentable,
+                            "pathName=" + pathName_ + " value=" + toString( values[done] ) );
+   }
+}
+
+void SourceDestBufferImpl::setNextInt64Block( const int64_t *values, size_t count, double scale,
+                                              double offset )
+{
+   /// don't checkImageFileOpen
+
+   if ( normalizes() )
+   {
+      setNextNormalizedBlock_( values, count, scale, offset );
+      return;
+   }
+
+   if ( !doScaling_ )
+   {
+      setNextInt64Block( values, count );
+      return;
+   }
+
+   checkBlockRoom_( count );
+
+   char *p = &base_[nextIndex_ * stride_];
+
+   size_t done = count;
+   double badValue = 0.0;
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         done = storeScaledInRange<int8_t>( p, stride_, values, count, scale, offset,
+                                            rangeChecks_, badValue );
+         break;
+      case UInt8:
+         done = storeScaledInRange<uint8_t>( p, stride_, values, count, scale, offset,
+                                             rangeChecks_, badValue );
+         break;
+      case Int16:
+         done = storeScaledInRange<int16_t>( p, stride_, values, count, scale, offset,
+                                             rangeChecks_, badValue );
+         break;
+      case UInt16:
+         done = storeScaledInRange<uint16_t>( p, stride_, values, count, scale, offset,
+                                              rangeChecks_, badValue );
+         break;
+      case Int32:
+         done = storeScaledInRange<int32_t>( p, stride_, values, count, scale, offset,
+                                             rangeChecks_, badValue );
+         break;
+      case UInt32:
+         done = storeScaledInRange<uint32_t>( p, stride_, values, count, scale, offset,
+                                              rangeChecks_, badValue );
+         break;
+      case Int64:
+         for ( size_t i = 0; i < count; ++i )
+         {
+            elementAt<int64_t>( p, stride_, i ) =
+               static_cast<int64_t>( floor( values[i] * scale + offset + 0.5 ) );
+         }
+         break;
+      case Bool:
+         for ( size_t i = 0; i < count; ++i )
+         {
+            const double scaledValue = floor( values[i] * scale + offset + 0.5 );
+
+            elementAt<bool>( p, stride_, i ) = ( scaledValue ? false : true );
+         }
+         break;
+      case Real16:
+      case Real32:
+      case Real64:
+      {
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+
+         /// Value will be stored in some floating point rep in user's buffer, so keep full
+         /// resolution. Scale a block at a time into temporary storage, using the vector
+         /// implementation when the values are in the range it handles exactly.
+         const bool useBitPack = BitPack::findOutOfRange( values, count, -cBitPackScaleLimit,
+                                                          cBitPackScaleLimit - 1 ) == count;
+
+         double scaledValues[cConversionBlockSize];
+
+         for ( size_t first = 0; first < count; first += cConversionBlockSize )
+         {
+            const size_t blockCount = std::min( cConversionBlockSize, count - first );
+
+            if ( useBitPack )
+            {
+               BitPack::scale( values + first, blockCount, scale, offset, scaledValues );
+            }
+            else
+            {
+               for ( size_t i = 0; i < blockCount; ++i )
+               {
+                  scaledValues[i] = values[first + i] * scale + offset;
+               }
+            }
+
+            char *blockBase = p + first * stride_;
+
+            if ( memoryRepresentation_ == Real64 )
+            {
+               storeConverted<double>( blockBase, stride_, scaledValues, blockCount );
+               continue;
+            }
+
+            if ( memoryRepresentation_ == Real16 )
+            {
+               const size_t blockDone =
+                  storeHalves( blockBase, stride_, scaledValues, blockCount, rangeChecks_ );
+
+               if ( blockDone != blockCount )
+               {
+                  done = first + blockDone;
+                  badValue = scaledValues[blockDone];
+                  break;
+               }
+               continue;
+            }
+
+            /// Check that exponent of result is not too big for single precision float
+            const size_t blockDone =
+               rangeChecks_ ? findFloatOutOfRange( scaledValues, blockCount ) : blockCount;
+
+            storeConverted<float>( blockBase, stride_, scaledValues, blockDone );
+
+            if ( blockDone != blockCount )
+            {
+               done = first + blockDone;
+               badValue = scaledValues[blockDone];
+               break;
+            }
+         }
+         break;
+      }
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( done );
+
+   if ( done != count )
+   {
+      throw E57_EXCEPTION2( ErrorScaledValueNotRepresentable,
+                            "pathName=" + pathName_ + " scaledValue=" + toString( badValue ) );
+   }
+}
+
+template <typename T>
+void SourceDestBufferImpl::_setNextRealBlock( const T *values, size_t count )
+{
+   static_assert( std::is_same<T, double>::value || std::is_same<T, float>::value,
+                  "_setNextRealBlock() requires float or double type" );
+
+   /// don't checkImageFileOpen
+
+   if ( normalizes() )
+   {
+      setNextNormalizedBlock_( values, count, 1.0, 0.0 );
+      return;
+   }
+
+   checkBlockRoom_( count );
+
+   char *p = &base_[nextIndex_ * stride_];
+
+   size_t done = count;
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+      case UInt8:
+      case Int16:
+      case UInt16:
+      case Int32:
+      case UInt32:
+      case Int64:
+      case Bool:
+         if ( !doConversion_ )
+         {
+            throw E57_EXCEPTION2( ErrorConversionRequired, "pathName=" + pathName_ );
+         }
+         break;
+      default:
+         break;
+   }
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         //??? fault if get special value: NaN, NegInf...  (all other ints below too)
+         done = storeInRange<int8_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case UInt8:
+         done = storeInRange<uint8_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case Int16:
+         done = storeInRange<int16_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case UInt16:
+         done = storeInRange<uint16_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case Int32:
+         done = storeInRange<int32_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case UInt32:
+         done = storeInRange<uint32_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case Int64:
+         done = storeInRange<int64_t>( p, stride_, values, count, rangeChecks_ );
+         break;
+      case Bool:
+         for ( size_t i = 0; i < count; ++i )
+         {
+            elementAt<bool>( p, stride_, i ) = ( values[i] ? false : true );
+         }
+         break;
+      case Real32:
+         if ( std::is_same<T, double>::value && rangeChecks_ )
+         {
+            /// Check for really large exponents that can't fit in a single precision
+            done = findFloatOutOfRange( values, count );
+         }
+         storeConverted<float>( p, stride_, values, done );
+         break;
+      case Real16:
+         done = storeHalves( p, stride_, values, count, rangeChecks_ );
+         break;
+      case Real64:
+         storeConverted<double>( p, stride_, values, count );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( done );
+
+   if ( done != count )
+   {
+      throw E57_EXCEPTION2( ErrorValueNotRepresentable,
+                            "pathName=" + pathName_ + " value=" + toString( values[done] ) );
+   }
+}
+
+void SourceDestBufferImpl::setNextFloatBlock( const float *values, size_t count )
+{
+   _setNextRealBlock( values, count );
+}
+
+void SourceDestBufferImpl::setNextDoubleBlock( const double *values, size_t count )
+{
+   _setNextRealBlock( values, count );
+}
+
+void SourceDestBufferImpl::fillNextInt64( int64_t value, size_t count )
+{
+   /// don't checkImageFileOpen
+
+   if ( count == 0 )
+   {
+      return;
+   }
+
+   checkBlockRoom_( count );
+
+   // Store the first one as usual so it's converted & checked, then repeat it
+   setNextInt64( value );
+   repeatLast_( count - 1 );
+}
+
+void SourceDestBufferImpl::fillNextInt64( int64_t value, size_t count, double scale,
+                                          double offset )
+{
+   /// don't checkImageFileOpen
+
+   if ( count == 0 )
+   {
+      return;
+   }
+
+   checkBlockRoom_( count );
+
+   setNextInt64( value, scale, offset );
+   repeatLast_( count - 1 );
+}
+
+void SourceDestBufferImpl::repeatLast_( size_t count )
+{
+   char *p = &base_[( nextIndex_ - 1 ) * stride_];
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         repeatElement<int8_t>( p, stride_, count );
+         break;
+      case UInt8:
+         repeatElement<uint8_t>( p, stride_, count );
+         break;
+      case Int16:
+         repeatElement<int16_t>( p, stride_, count );
+         break;
+      case UInt16:
+         repeatElement<uint16_t>( p, stride_, count );
+         break;
+      case Int32:
+         repeatElement<int32_t>( p, stride_, count );
+         break;
+      case UInt32:
+         repeatElement<uint32_t>( p, stride_, count );
+         break;
+      case Int64:
+         repeatElement<int64_t>( p, stride_, count );
+         break;
+      case Bool:
+         repeatElement<bool>( p, stride_, count );
+         break;
+      case Real32:
+         repeatElement<float>( p, stride_, count );
+         break;
+      case Real16:
+         repeatElement<uint16_t>( p, stride_, count );
+         break;
+      case Real64:
+         repeatElement<double>( p, stride_, count );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+
+   nextIndex_ += static_cast<unsigned>( count );
+}
+
+void SourceDestBufferImpl::getElementsAsDouble( size_t first, size_t count, double *values ) const
+{
+   if ( ( first > nextIndex_ ) || ( count > nextIndex_ - first ) )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ + " first=" + toString( first ) +
+                                              " count=" + toString( count ) +
+                                              " nextIndex=" + toString( nextIndex_ ) );
+   }
+
+   char *p = &base_[first * stride_];
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         loadConverted<int8_t>( p, stride_, values, count );
+         break;
+      case UInt8:
+         loadConverted<uint8_t>( p, stride_, values, count );
+         break;
+      case Int16:
+         loadConverted<int16_t>( p, stride_, values, count );
+         break;
+      case UInt16:
+         loadConverted<uint16_t>( p, stride_, values, count );
+         break;
+      case Int32:
+         loadConverted<int32_t>( p, stride_, values, count );
+         break;
+      case UInt32:
+         loadConverted<uint32_t>( p, stride_, values, count );
+         break;
+      case Int64:
+         loadConverted<int64_t>( p, stride_, values, count );
+         break;
+      case Bool:
+         loadConverted<bool>( p, stride_, values, count );
+         break;
+      case Real32:
+         loadConverted<float>( p, stride_, values, count );
+         break;
+      case Real16:
+         loadHalves( p, stride_, values, count );
+         break;
+      case Real64:
+         loadConverted<double>( p, stride_, values, count );
+         break;
+      case UString:
+         throw E57_EXCEPTION2( ErrorExpectingNumeric, "pathName=" + pathName_ );
+   }
+}
+
+void SourceDestBufferImpl::keepElements( size_t first, const uint32_t *indices, size_t count )
+{
+   if ( ( first > nextIndex_ ) || ( count > nextIndex_ - first ) )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ + " first=" + toString( first ) +
+                                              " count=" + toString( count ) +
+                                              " nextIndex=" + toString( nextIndex_ ) );
+   }
+
+   char *p = ( base_ != nullptr ) ? &base_[first * stride_] : nullptr;
+
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         moveElements<int8_t>( p, stride_, indices, count );
+         break;
+      case UInt8:
+         moveElements<uint8_t>( p, stride_, indices, count );
+         break;
+      case Int16:
+         moveElements<int16_t>( p, stride_, indices, count );
+         break;
+      case UInt16:
+         moveElements<uint16_t>( p, stride_, indices, count );
+         break;
+      case Int32:
+         moveElements<int32_t>( p, stride_, indices, count );
+         break;
+      case UInt32:
+         moveElements<uint32_t>( p, stride_, indices, count );
+         break;
+      case Int64:
+         moveElements<int64_t>( p, stride_, indices, count );
+         break;
+      case Bool:
+         moveElements<bool>( p, stride_, indices, count );
+         break;
+      case Real32:
+         moveElements<float>( p, stride_, indices, count );
+         break;
+      case Real16:
+         moveElements<uint16_t>( p, stride_, indices, count );
+         break;
+      case Real64:
+         moveElements<double>( p, stride_, indices, count );
+         break;
+      case UString:
+         // The characters of arena strings are only appended, so they can't be moved
+         if ( ustrings_ == nullptr )
+         {
+            throw E57_EXCEPTION2( ErrorNotImplemented, "pathName=" + pathName_ );
+         }
+
+         for ( size_t i = 0; i < count; ++i )
+         {
+            if ( indices[i] != i )
+            {
+               ( *ustrings_ )[first + i] = std::move( ( *ustrings_ )[first + indices[i]] );
+            }
+         }
+         break;
+   }
+
+   nextIndex_ = static_cast<unsigned>( first + count );
+}
+
+bool SourceDestBufferImpl::setNextRawBlock( MemoryRepresentation type, const char *bytes,
+                                            size_t count )
+{
+   /// don't checkImageFileOpen
+
+   size_t elementSize = 0;
+
+   switch ( type )
+   {
+      case Real32:
+         elementSize = sizeof( float );
+         break;
+      case Real64:
+         elementSize = sizeof( double );
+         break;
+      default:
+         return false;
+   }
+
+   if ( ( memoryRepresentation_ != type ) || ( stride_ != elementSize ) || normalizes() )
+   {
+      return false;
+   }
+
+   checkBlockRoom_( count );
+
+   memcpy( &base_[nextIndex_ * stride_], bytes, count * elementSize );
+
+   nextIndex_ += static_cast<unsigned>( count );
+
+   return true;
+}
+
+void SourceDestBufferImpl::checkCompatible(
+   const std::shared_ptr<SourceDestBufferImpl> &newBuf ) const
+{
+   if ( pathName_ != newBuf->pathName() )
+   {
+      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
+                            "pathName=" + pathName_ + " newPathName=" + newBuf->pathName() );
+   }
+   if ( memoryRepresentation_ != newBuf->memoryRepresentation() )
+   {
+      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
+                            "memoryRepresentation=" + toString( memoryRepresentation_ ) +
+                               " newMemoryType=" + toString( newBuf->memoryRepresentation() ) );
+   }
+   if ( capacity_ != newBuf->capacity() )
+   {
+      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
+                            "capacity=" + toString( capacity_ ) +
+                               " newCapacity=" + toString( newBuf->capacity() ) );
+   }
+   if ( doConversion_ != newBuf->doConversion() )
+   {
+      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
+                            "doConversion=" + toString( doConversion_ ) +
+                               "newDoConversion=" + toString( newBuf->doConversion() ) );
+   }
+   if ( stride_ != newBuf->stride() )
+   {
+      throw E57_EXCEPTION2( ErrorBuffersNotCompatible,
+                            "stride=" + toString( stride_ ) +
+                               " newStride=" + toString( newBuf->stride() ) );
+   }
+}
+
+std::shared_ptr<SourceDestBufferImpl> SourceDestBufferImpl::slice( size_t first,
+                                                                   size_t count ) const
+{
+   // Strings are written by index into the caller's list, so their slices must start at 0.
+   if ( ( memoryRepresentation_ == UString ) && ( first != 0 ) )
+   {
+      throw E57_EXCEPTION2( ErrorInternal,
+                            "pathName=" + pathName_ + " first=" + toString( first ) );
+   }
+
+   if ( ( first > capacity_ ) || ( count > capacity_ - first ) )
+   {
+      throw E57_EXCEPTION2( ErrorInternal, "pathName=" + pathName_ + " first=" + toString( first ) +
+                                              " count=" + toString( count ) +
+                                              " capacity=" + toString( capacity_ ) );
+   }
+
+   std::shared_ptr<SourceDestBufferImpl> sliced( new SourceDestBufferImpl( *this ) );
+
+   sliced->base_ += first * stride_;
+   sliced->capacity_ = count;
+   sliced->nextIndex_ = 0;
+
+   return sliced;
+}
+
+#ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
+void SourceDestBufferImpl::dump( int indent, std::ostream &os )
+{
+   /// don't checkImageFileOpen
+
+   os << space( indent ) << "pathName:             " << pathName_ << std::endl;
+   os << space( indent ) << "memoryRepresentation: ";
+   switch ( memoryRepresentation_ )
+   {
+      case Int8:
+         os << "int8_t" << std::endl;
+         break;
+      case UInt8:
+         os << "uint8_t" << std::endl;
+         break;
+      case Int16:
+         os << "int16_t" << std::endl;
+         break;
+      case UInt16:
+         os << "uint16_t" << std::endl;
+         break;
+      case Int32:
+         os << "int32_t" << std::endl;
+         break;
+      case UInt32:
+         os << "uint32_t" << std::endl;
+         break;
+      case Int64:
+         os << "int64_t" << std::endl;
+         break;
+      case Bool:
+         os << "bool" << std::endl;
+         break;
+      case Real32:
+         os << "float" << std::endl;
+         break;
+      case Real64:
+         os << "double" << std::endl;
+         break;
+      case Real16:
+         os << "Float16" << std::endl;
+         break;
+      case UString:
+         os << "ustring" << std::endl;
+         break;
       default:
          os << "<unknown>" << std::endl;
          break;
@@ -1053,6 +2543,8 @@ void SourceDestBufferImpl::dump( int indent, std::ostream &os )
       << std::endl;
    os << space( indent ) << "ustrings:             " << static_cast<const void *>( ustrings_ )
       << std::endl;
+   os << space( indent ) << "arena:                " << static_cast<const void *>( arena_ )
+      << std::endl;
    os << space( indent ) << "capacity:             " << capacity_ << std::endl;
    os << space( indent ) << "doConversion:         " << doConversion_ << std::endl;
    os << space( indent ) << "doScaling:            " << doScaling_ << std::endl;
@@ -43,6 +43,8 @@ namespace e57
 
       SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile, const ustring &pathName,
                             StringList *b );
+      SourceDestBufferImpl( ImageFileImplWeakPtr destImageFile, const ustring &pathName,
+                            StringArena *b, size_t capacity );
 
       ImageFileImplWeakPtr destImageFile() const
       {
@@ -69,6 +71,11 @@ namespace e57
          return ustrings_;
       }
 
+      StringArena *arena() const
+      {
+         return arena_;
+      }
+
       bool doConversion() const
       {
          return doConversion_;
@@ -84,6 +91,33 @@ namespace e57
          return stride_;
       }
 
+      /// Whether the block functions storing values check that they fit the buffer's type. The
+      /// checks can only be turned off when every value is known to fit (see
+      /// CompressedVectorReader::setTrustedRanges()).
+      bool rangeChecks() const
+      {
+         return rangeChecks_;
+      }
+
+      void setRangeChecks( bool enabled )
+      {
+         rangeChecks_ = enabled;
+      }
+
+      /// Whether the values stored are normalized (see setNormalization())
+      bool normalizes() const
+      {
+         return normalizeScale_ != 0.0;
+      }
+
+      /// Store the values from @a minimum to @a maximum (scaled values for scaled integers) as 0
+      /// to 1 in floating point buffers, as 0 to the largest value of the type in unsigned integer
+      /// buffers, and as minus to plus the largest value in signed integer buffers. Values outside
+      /// the limits are clamped to them. Throws ::ErrorBadAPIArgument if the limits aren't a
+      /// finite range or the buffer holds 64 bit integers, bools or strings.
+      void setNormalization( double minimum, double maximum );
+      void clearNormalization();
+
       size_t capacity() const
       {
          return capacity_;
@@ -110,14 +144,66 @@ namespace e57
       void setNextDouble( double value );
       void setNextString( const ustring &value );
 
+      /// String versions which don't create a ustring. getNextString() sets @a chars to the
+      /// characters of the string in the buffer, which stay valid until the buffer is changed.
+      void getNextString( const char *&chars, size_t &length );
+      void setNextString( const char *chars, size_t length );
+
+      /// Block versions of the functions above. Each transfers @a count values, with the same
+      /// results and errors as calling the single value function @a count times. The buffer type
+      /// and space are checked once per block instead of once per value.
+      void getNextInt64Block( int64_t *values, size_t count );
+      void getNextInt64Block( int64_t *values, size_t count, double scale, double offset );
+      void getNextFloatBlock( float *values, size_t count );
+      void getNextDoubleBlock( double *values, size_t count );
+      void setNextInt64Block( const int64_t *values, size_t count );
+      void setNextInt64Block( const int64_t *values, size_t count, double scale, double offset );
+      void setNextFloatBlock( const float *values, size_t count );
+      void setNextDoubleBlock( const double *values, size_t count );
+
+      /// Set the next @a count elements to @a value, with the same results and errors as calling
+      /// setNextInt64() @a count times. The value is converted & checked only once.
+      void fillNextInt64( int64_t value, size_t count );
+      void fillNextInt64( int64_t value, size_t count, double scale, double offset );
+
+      /// If this is a tightly packed buffer of @a type, copy @a count elements of that type
+      /// straight from @a bytes (which needn't be aligned) and return true. Otherwise return false
+      /// without changing anything.
+      bool setNextRawBlock( MemoryRepresentation type, const char *bytes, size_t count );
+
+      /// Copy the @a count elements stored from element @a first to @a values, converted to double
+      /// but not scaled.
+      void getElementsAsDouble( size_t first, size_t count, double *values ) const;
+
+      /// Keep the @a count elements at the increasing @a indices (relative to element @a first)
+      /// of those stored, moving them down to element @a first, and store the next values after
+      /// them.
+      void keepElements( size_t first, const uint32_t *indices, size_t count );
+
       void checkCompatible( const std::shared_ptr<SourceDestBufferImpl> &newBuf ) const;
 
+      /// Return a buffer which refers to @a count elements of this one, starting at element
+      /// @a first. String buffers can only be sliced from their first element.
+      std::shared_ptr<SourceDestBufferImpl> slice( size_t first, size_t count ) const;
+
 #ifdef E57_ENABLE_DIAGNOSTIC_OUTPUT
       void dump( int indent = 0, std::ostream &os = std::cout );
 #endif
 
    private:
       template <typename T> void _setNextReal( T inValue );
+      template <typename T> void _getNextRealBlock( T *values, size_t count );
+      template <typename T> void _setNextRealBlock( const T *values, size_t count );
+
+      /// Store values * scale + offset normalized (see setNormalization())
+      template <typename T>
+      void setNextNormalizedBlock_( const T *values, size_t count, double scale, double offset );
+
+      /// Copy the element before nextIndex_ to the next @a count elements
+      void repeatLast_( size_t count );
+
+      /// Throws if there aren't @a count elements left after nextIndex_
+      void checkBlockRoom_( size_t count ) const;
 
       /// Common routine to check that constructor arguments were ok, throws if not
       void checkState_() const;
@@ -145,11 +231,21 @@ namespace e57
       /// Distance between each element (different from size_ if elements not contiguous)
       size_t stride_ = 0;
 
+      /// Check that stored values fit the type of the elements (see setRangeChecks())
+      bool rangeChecks_ = true;
+
+      /// Value stored as 0, and factor mapping the limits to 0 - 1 (0 if not normalized)
+      double normalizeMinimum_ = 0.0;
+      double normalizeScale_ = 0.0;
+
       /// Number of elements that have been set (dest buffer) or read (source buffer) since
       /// rewind().
       unsigned nextIndex_ = 0;
 
       /// Optional array of ustrings (used if memoryRepresentation_ == ::UString)
       StringList *ustrings_ = nullptr;
+
+      /// Optional arena of strings (used instead of ustrings_ if it isn't null)
+      StringArena *arena_ = nullptr;
    };
 }
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+#include "Common.h"
+
+namespace e57
+{
+   /// Adds the time between its construction & destruction to a count of nanoseconds. @a T is
+   /// uint64_t, or std::atomic<uint64_t> for counts which may be read by other threads.
+   template <typename T> class ScopedTimer
+   {
+   public:
+      explicit ScopedTimer( T &nanoseconds ) :
+         nanoseconds_( nanoseconds ), start_( std::chrono::steady_clock::now() )
+      {
+      }
+
+      ~ScopedTimer()
+      {
+         const auto cElapsed = std::chrono::steady_clock::now() - start_;
+
+         add( nanoseconds_, static_cast<uint64_t>(
+                               std::chrono::duration_cast<std::chrono::nanoseconds>( cElapsed )
+                                  .count() ) );
+      }
+
+      ScopedTimer( const ScopedTimer & ) = delete;
+      ScopedTimer &operator=( const ScopedTimer & ) = delete;
+
+   private:
+      static void add( uint64_t &count, uint64_t value )
+      {
+         count += value;
+      }
+
+      static void add( std::atomic<uint64_t> &count, uint64_t value )
+      {
+         count.fetch_add( value, std::memory_order_relaxed );
+      }
+
+      T &nanoseconds_;
+      std::chrono::steady_clock::time_point start_;
+   };
+
+   /// Convert a count of nanoseconds to seconds
+   inline double nanosecondsToSeconds( uint64_t nanoseconds )
+   {
+      return static_cast<double>( nanoseconds ) * 1.0e-9;
+   }
+}
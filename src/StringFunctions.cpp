@@ -1,36 +1,38 @@
 #include "StringFunctions.h"
 
 #include <cassert>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <locale>
 
 namespace e57
 {
-   template <class FTYPE> std::string floatingPointToStr( FTYPE value, int precision )
+   namespace
    {
-      static_assert( std::is_floating_point<FTYPE>::value, "Floating point type required." );
-
-      std::stringstream ss;
-      ss.imbue( std::locale::classic() );
-
-      ss << std::scientific << std::setprecision( precision ) << value;
-
-      // Try to remove trailing zeroes and decimal point
+      // Remove trailing zeroes and decimal point from a number in scientific notation, and the
+      // exponent if it is zero
       // e.g. 1.23456000000000000e+005  ==> 1.23456e+005
       // e.g. 2.00000000000000000e+005  ==> 2e+005
+      std::string trimScientific( const std::string &s )
+      {
+         // Split into mantissa and exponent
+         // e.g. 1.23456000000000000e+005  ==> "1.23456000000000000" + "e+005"
+         auto index = s.find_last_of( 'e' );
+         assert( index != std::string::npos ); // should not be possible
 
-      std::string s = ss.str();
-
-      // Split into mantissa and exponent
-      // e.g. 1.23456000000000000e+005  ==> "1.23456000000000000" + "e+005"
-      auto index = s.find_last_of( 'e' );
-      assert( index != std::string::npos ); // should not be possible
+         std::string mantissa = s.substr( 0, index );
+         const std::string exponent = s.substr( index );
 
-      std::string mantissa = s.substr( 0, index );
-      const std::string exponent = s.substr( index );
+         // Double check that we understand the formatting
+         if ( exponent[0] != 'e' )
+         {
+            return s;
+         }
 
-      // Double check that we understand the formatting
-      if ( exponent[0] == 'e' )
-      {
          // Trim trailing zeros from mantissa
          while ( mantissa.back() == '0' )
          {
@@ -47,20 +49,91 @@ namespace e57
          // Check if can drop exponent.
          if ( ( exponent == "e+00" ) || ( exponent == "e+000" ) )
          {
-            s = mantissa;
+            return mantissa;
          }
-         else
+
+         return mantissa + exponent;
+      }
+
+      // Format with snprintf() using @a digits significant digits & check it reads back as the
+      // same value. Both use the C locale, whatever its decimal point is.
+      bool formatRoundTrip( double value, int digits, char *buffer, size_t size )
+      {
+         snprintf( buffer, size, "%.*e", digits - 1, value );
+
+         return strtod( buffer, nullptr ) == value;
+      }
+
+      bool formatRoundTrip( float value, int digits, char *buffer, size_t size )
+      {
+         snprintf( buffer, size, "%.*e", digits - 1, static_cast<double>( value ) );
+
+         return strtof( buffer, nullptr ) == value;
+      }
+   }
+
+   template <class FTYPE> std::string floatingPointToStr( FTYPE value, int precision )
+   {
+      static_assert( std::is_floating_point<FTYPE>::value, "Floating point type required." );
+
+      std::stringstream ss;
+      ss.imbue( std::locale::classic() );
+
+      ss << std::scientific << std::setprecision( precision ) << value;
+
+      return trimScientific( ss.str() );
+   }
+
+   template <class FTYPE> std::string floatingPointToShortestStr( FTYPE value )
+   {
+      static_assert( std::is_floating_point<FTYPE>::value, "Floating point type required." );
+
+      if ( std::isnan( value ) )
+      {
+         return "nan";
+      }
+
+      if ( std::isinf( value ) )
+      {
+         return ( value < 0 ) ? "-inf" : "inf";
+      }
+
+      // Any number with up to digits10 significant digits is read back exactly, so if rounding
+      // to that many doesn't give the value back, try one more digit. max_digits10 always works.
+      char buffer[32];
+
+      int digits = std::numeric_limits<FTYPE>::digits10;
+
+      while ( !formatRoundTrip( value, digits, buffer, sizeof( buffer ) ) &&
+              ( digits < std::numeric_limits<FTYPE>::max_digits10 ) )
+      {
+         ++digits;
+      }
+
+      std::string s( buffer );
+
+      // Always use '.' whatever the C locale's decimal point is
+      const char *decimalPoint = localeconv()->decimal_point;
+
+      if ( ( decimalPoint != nullptr ) && ( strcmp( decimalPoint, "." ) != 0 ) )
+      {
+         const auto index = s.find( decimalPoint );
+
+         if ( index != std::string::npos )
          {
-            s = mantissa + exponent;
+            s.replace( index, strlen( decimalPoint ), "." );
          }
       }
 
-      return s;
+      return trimScientific( s );
    }
 
    template std::string floatingPointToStr<float>( float value, int precision );
    template std::string floatingPointToStr<double>( double value, int precision );
 
+   template std::string floatingPointToShortestStr<float>( float value );
+   template std::string floatingPointToShortestStr<double>( double value );
+
    double strToDouble( const std::string &inStr )
    {
       std::istringstream iss{ inStr };
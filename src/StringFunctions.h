@@ -200,6 +200,13 @@ namespace e57
    extern template std::string floatingPointToStr<float>( float value, int precision );
    extern template std::string floatingPointToStr<double>( double value, int precision );
 
+   /// @brief Convert a floating point number to the shortest string which reads back as the same
+   /// value, cleaned up like floatingPointToStr().
+   template <class FTYPE> std::string floatingPointToShortestStr( FTYPE value );
+
+   extern template std::string floatingPointToShortestStr<float>( float value );
+   extern template std::string floatingPointToShortestStr<double>( double value );
+
    /// Parse a double according the the classic ("C") locale.
    /// @return The parsed double or 0.0 on error.
    double strToDouble( const std::string &inStr );
@@ -35,6 +35,8 @@ namespace e57
       NodeImpl( destImageFile ), value_( value )
    {
       // don't checkImageFileOpen, NodeImpl() will do it
+
+      memory_.set( Memory::Nodes, sizeof( *this ) );
    }
 
    bool StringNodeImpl::isTypeEquivalent( NodeImplSharedPtr ni )
@@ -34,10 +34,18 @@
 
 using namespace e57;
 
+namespace
+{
+   // Structures with fewer children than this are searched instead of indexed by name
+   constexpr size_t cIndexedChildCount = 8;
+}
+
 StructureNodeImpl::StructureNodeImpl( ImageFileImplWeakPtr destImageFile ) :
    NodeImpl( destImageFile )
 {
    checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+   memory_.set( Memory::Nodes, sizeof( *this ) );
 }
 
 NodeType StructureNodeImpl::type() const
@@ -60,6 +68,9 @@ bool StructureNodeImpl::isTypeEquivalent( NodeImplSharedPtr ni )
    // Downcast to shared_ptr<StructureNodeImpl>
    std::shared_ptr<StructureNodeImpl> si( std::static_pointer_cast<StructureNodeImpl>( ni ) );
 
+   materialize();
+   si->materialize();
+
    // Same number of children?
    if ( childCount() != si->childCount() )
    {
@@ -81,11 +92,13 @@ bool StructureNodeImpl::isTypeEquivalent( NodeImplSharedPtr ni )
       else
       {
          // Children in different order, so lookup by name and check if equal to our child
-         if ( !si->isDefined( myChildsFieldName ) )
+         const size_t cIndex = si->childIndex( myChildsFieldName );
+
+         if ( cIndex == si->children_.size() )
          {
             return ( false );
          }
-         if ( !children_.at( i )->isTypeEquivalent( si->lookup( myChildsFieldName ) ) )
+         if ( !children_.at( i )->isTypeEquivalent( si->children_[cIndex] ) )
          {
             return ( false );
          }
@@ -119,12 +132,17 @@ int64_t StructureNodeImpl::childCount() const
 {
    checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
+   const_cast<StructureNodeImpl *>( this )->materialize();
+
    return children_.size();
 }
 
 NodeImplSharedPtr StructureNodeImpl::get( int64_t index )
 {
    checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+   materialize();
+
    if ( index < 0 || index >= static_cast<int64_t>( children_.size() ) )
    { // %%% Possible truncation on platforms where size_t = uint64
       throw E57_EXCEPTION2( ErrorChildIndexOutOfBounds,
@@ -150,64 +168,99 @@ NodeImplSharedPtr StructureNodeImpl::get( const ustring &pathName )
 NodeImplSharedPtr StructureNodeImpl::lookup( const ustring &pathName )
 {
    // don't checkImageFileOpen
-   //??? use lookup(fields, level) instead, for speed.
    bool isRelative;
-   std::vector<ustring> fields;
+   StringList fields;
    ImageFileImplSharedPtr imf( destImageFile_ );
    imf->pathNameParse( pathName, isRelative, fields ); // throws if bad pathName
 
-   if ( isRelative || isRoot() )
+   if ( fields.empty() )
    {
-      if ( fields.empty() )
-      {
-         if ( isRelative )
-         {
-            return {}; // empty pointer
-         }
-
-         NodeImplSharedPtr root( getRoot() );
-         return ( root );
-      }
-
-      // Find child with elementName that matches first field in path
-      unsigned i;
-      for ( i = 0; i < children_.size(); i++ )
-      {
-         if ( fields.at( 0 ) == children_.at( i )->elementName() )
-         {
-            break;
-         }
-      }
-      if ( i == children_.size() )
+      if ( isRelative )
       {
          return {}; // empty pointer
       }
 
-      if ( fields.size() == 1 )
-      {
-         return ( children_.at( i ) );
-      }
-
-      //??? use level here rather than unparse
-      // Remove first field in path
-      fields.erase( fields.begin() );
+      NodeImplSharedPtr root( getRoot() );
+      return ( root );
+   }
 
-      // Call lookup on child object with remaining fields in path name
-      return children_.at( i )->lookup( imf->pathNameUnparse( true, fields ) );
+   if ( isRelative || isRoot() )
+   {
+      return lookup( fields, 0 );
    }
 
    // Absolute pathname and we aren't at the root
-   // Find root of the tree
-   NodeImplSharedPtr root( getRoot() );
+   return getRoot()->lookup( fields, 0 );
+}
+
+NodeImplSharedPtr StructureNodeImpl::lookup( const StringList &fields, unsigned level )
+{
+   // don't checkImageFileOpen
+   materialize();
+
+   // Find child with elementName that matches the field at this level
+   const size_t cIndex = childIndex( fields[level] );
+
+   if ( cIndex == children_.size() )
+   {
+      return {}; // empty pointer
+   }
+
+   if ( level == fields.size() - 1 )
+   {
+      return ( children_[cIndex] );
+   }
+
+   // Call lookup on child object with remaining fields in path name
+   return children_[cIndex]->lookup( fields, level + 1 );
+}
+
+size_t StructureNodeImpl::childIndex( const ustring &elementName ) const
+{
+   if ( !childIndices_.empty() )
+   {
+      const auto cFound = childIndices_.find( elementName );
+
+      return ( cFound == childIndices_.end() ) ? children_.size() : cFound->second;
+   }
+
+   size_t i = 0;
 
-   // Call lookup on root
-   return ( root->lookup( pathName ) );
+   while ( ( i < children_.size() ) && ( children_[i]->elementName_ != elementName ) )
+   {
+      ++i;
+   }
+
+   return i;
+}
+
+void StructureNodeImpl::addChild( NodeImplSharedPtr ni, const ustring &elementName )
+{
+   ni->setParent( shared_from_this(), elementName );
+   children_.push_back( ni );
+
+   // Index the children once there are enough of them
+   if ( !childIndices_.empty() )
+   {
+      childIndices_.emplace( elementName, children_.size() - 1 );
+   }
+   else if ( children_.size() == cIndexedChildCount )
+   {
+      childIndices_.reserve( 2 * cIndexedChildCount );
+
+      for ( size_t i = 0; i < children_.size(); ++i )
+      {
+         childIndices_.emplace( children_[i]->elementName_, i );
+      }
+   }
 }
 
 void StructureNodeImpl::set( int64_t index64, NodeImplSharedPtr ni )
 {
    checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
 
+   materialize();
+
    auto index = static_cast<unsigned>( index64 );
 
    // Allow index == current number of elements, interpret as append
@@ -236,8 +289,7 @@ void StructureNodeImpl::set( int64_t index64, NodeImplSharedPtr ni )
    }
 
    // Field name is string version of index value, e.g. "14"
-   std::stringstream elementName;
-   elementName << index;
+   const ustring elementName = std::to_string( index );
 
    // If this struct is type constrained, can't add new child
    if ( isTypeConstrained() )
@@ -245,8 +297,7 @@ void StructureNodeImpl::set( int64_t index64, NodeImplSharedPtr ni )
       throw E57_EXCEPTION2( ErrorHomogeneousViolation, "this->pathName=" + this->pathName() );
    }
 
-   ni->setParent( shared_from_this(), elementName.str() );
-   children_.push_back( ni );
+   addChild( ni, elementName );
 }
 
 void StructureNodeImpl::set( const ustring &pathName, NodeImplSharedPtr ni, bool autoPathCreate )
@@ -296,29 +347,30 @@ void StructureNodeImpl::set( const std::vector<ustring> &fields, unsigned level,
    // index, else throw
    // bad_path
 
+   materialize();
+
    // Check if trying to set the root node "/", which is illegal
    if ( level == 0 && fields.empty() )
    {
       throw E57_EXCEPTION2( ErrorSetTwice, "this->pathName=" + this->pathName() + " element=/" );
    }
 
-   // Serial search for matching field name, if find match, have error since can't set twice
-   for ( auto &child : children_ )
+   // Search for matching field name, if find match, have error since can't set twice
+   const size_t cIndex = childIndex( fields.at( level ) );
+
+   if ( cIndex != children_.size() )
    {
-      if ( fields.at( level ) == child->elementName() )
+      if ( level == fields.size() - 1 )
       {
-         if ( level == fields.size() - 1 )
-         {
-            // Enforce "set once" policy, don't allow reset
-            throw E57_EXCEPTION2( ErrorSetTwice, "this->pathName=" + this->pathName() +
-                                                    " element=" + fields[level] );
-         }
+         // Enforce "set once" policy, don't allow reset
+         throw E57_EXCEPTION2( ErrorSetTwice, "this->pathName=" + this->pathName() +
+                                                 " element=" + fields[level] );
+      }
 
-         // Recurse on child
-         child->set( fields, level + 1, ni );
+      // Recurse on child
+      children_[cIndex]->set( fields, level + 1, ni );
 
-         return;
-      }
+      return;
    }
    // Didn't find matching field name, so have a new child.
 
@@ -332,8 +384,7 @@ void StructureNodeImpl::set( const std::vector<ustring> &fields, unsigned level,
    if ( level == fields.size() - 1 )
    {
       // At bottom, so append node at end of children
-      ni->setParent( shared_from_this(), fields.at( level ) );
-      children_.push_back( ni );
+      addChild( ni, fields.at( level ) );
    }
    else
    {
@@ -370,6 +421,8 @@ void StructureNodeImpl::checkLeavesInSet( const StringSet &pathNames, NodeImplSh
 {
    // don't checkImageFileOpen
 
+   materialize();
+
    // Not a leaf node, so check all our children
    for ( auto &child : children_ )
    {
@@ -393,6 +446,8 @@ void StructureNodeImpl::writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, i
       fieldName = elementName_;
    }
 
+   materialize();
+
    cf << space( indent ) << "<" << fieldName << " type=\"Structure\"";
 
    const int numSpaces = indent + static_cast<int>( fieldName.length() ) + 2;
@@ -454,6 +509,8 @@ void StructureNodeImpl::writeXml( ImageFileImplSharedPtr imf, CheckedFile &cf, i
 void StructureNodeImpl::dump( int indent, std::ostream &os ) const
 {
    // don't checkImageFileOpen
+   const_cast<StructureNodeImpl *>( this )->materialize();
+
    os << space( indent ) << "type:        Structure" << " (" << type() << ")" << std::endl;
    NodeImpl::dump( indent, os );
    for ( unsigned i = 0; i < children_.size(); i++ )
@@ -463,3 +520,22 @@ void StructureNodeImpl::dump( int indent, std::ostream &os ) const
    }
 }
 #endif
+
+void StructureNodeImpl::setLazyXml( uint64_t logicalOffset, uint64_t length )
+{
+   isLazy_ = true;
+   lazyXmlOffset_ = logicalOffset;
+   lazyXmlLength_ = length;
+}
+
+void StructureNodeImpl::materializeXml()
+{
+   checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
+
+   // Clear first, since adding the children calls back into here
+   isLazy_ = false;
+
+   ImageFileImplSharedPtr imf( destImageFile_ );
+   imf->parseXmlFragment( lazyXmlOffset_, lazyXmlLength_,
+                          std::static_pointer_cast<StructureNodeImpl>( shared_from_this() ) );
+}
@@ -27,6 +27,8 @@
 
 #pragma once
 
+#include <unordered_map>
+
 #include "NodeImpl.h"
 
 namespace e57
@@ -64,11 +66,40 @@ namespace e57
       void dump( int indent = 0, std::ostream &os = std::cout ) const override;
 #endif
 
+      /// Build the children from the XML at [logicalOffset, logicalOffset + length) of the file
+      /// the first time they are needed (see XmlLoadLazy).
+      void setLazyXml( uint64_t logicalOffset, uint64_t length );
+
    protected:
       friend class CompressedVectorReaderImpl;
 
       NodeImplSharedPtr lookup( const ustring &pathName ) override;
+      NodeImplSharedPtr lookup( const StringList &fields, unsigned level ) override;
+
+      /// Index of the child named @a elementName, or children_.size() if there isn't one
+      size_t childIndex( const ustring &elementName ) const;
+
+      /// Make sure the children have been built
+      void materialize()
+      {
+         if ( isLazy_ )
+         {
+            materializeXml();
+         }
+      }
 
       std::vector<NodeImplSharedPtr> children_;
+
+   private:
+      void materializeXml();
+
+      void addChild( NodeImplSharedPtr ni, const ustring &elementName );
+
+      bool isLazy_ = false;
+      uint64_t lazyXmlOffset_ = 0;
+      uint64_t lazyXmlLength_ = 0;
+
+      /// Index of each child by name, once there are enough of them that searching is slower
+      std::unordered_map<ustring, size_t> childIndices_;
    };
 }
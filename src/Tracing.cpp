@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include "Tracing.h"
+
+namespace e57
+{
+#ifdef E57_ENABLE_TRACING
+   Tracing::Callbacks Tracing::gCallbacks;
+
+   bool Tracing::available()
+   {
+      return true;
+   }
+
+   void Tracing::setCallbacks( const Callbacks &callbacks )
+   {
+      gCallbacks = callbacks;
+   }
+#else
+   bool Tracing::available()
+   {
+      return false;
+   }
+
+   void Tracing::setCallbacks( const Callbacks & /*callbacks*/ )
+   {
+   }
+#endif
+}
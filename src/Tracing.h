@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include "E57Tracing.h"
+
+namespace e57
+{
+#ifdef E57_ENABLE_TRACING
+   namespace Tracing
+   {
+      /// The callbacks set by setCallbacks()
+      extern Callbacks gCallbacks;
+   }
+
+   /// Calls the tracing callbacks at its construction & destruction.
+   class TraceZone
+   {
+   public:
+      explicit TraceZone( const char *zoneName ) :
+         end_( Tracing::gCallbacks.end ), userData_( Tracing::gCallbacks.userData )
+      {
+         if ( Tracing::gCallbacks.begin != nullptr )
+         {
+            zone_ = Tracing::gCallbacks.begin( zoneName, userData_ );
+         }
+      }
+
+      ~TraceZone()
+      {
+         if ( end_ != nullptr )
+         {
+            end_( zone_, userData_ );
+         }
+      }
+
+      TraceZone( const TraceZone & ) = delete;
+      TraceZone &operator=( const TraceZone & ) = delete;
+
+   private:
+      Tracing::ZoneEnd end_;
+      void *userData_;
+      void *zone_ = nullptr;
+   };
+
+#define E57_TRACE_CONCAT_( a, b ) a##b
+#define E57_TRACE_CONCAT( a, b ) E57_TRACE_CONCAT_( a, b )
+
+/// Trace the rest of the current scope as a zone called @a zoneName (a string literal).
+#define E57_TRACE_ZONE( zoneName )                                                                 \
+   ::e57::TraceZone E57_TRACE_CONCAT( e57TraceZone, __LINE__ )( zoneName )
+#else
+#define E57_TRACE_ZONE( zoneName )
+#endif
+}
@@ -35,6 +35,8 @@ namespace e57
       StructureNodeImpl( destImageFile ), allowHeteroChildren_( allowHeteroChildren )
    {
       // don't checkImageFileOpen, StructNodeImpl() will do it
+
+      memory_.set( Memory::Nodes, sizeof( *this ) );
    }
 
    bool VectorNodeImpl::isTypeEquivalent( NodeImplSharedPtr ni )
@@ -83,16 +85,14 @@ namespace e57
    void VectorNodeImpl::set( int64_t index64, NodeImplSharedPtr ni )
    {
       checkImageFileOpen( __FILE__, __LINE__, static_cast<const char *>( __FUNCTION__ ) );
-      if ( !allowHeteroChildren_ )
+      if ( !allowHeteroChildren_ && !children_.empty() )
       {
-         // New node type must match all existing children
-         for ( auto &child : children_ )
+         // New node type must match all existing children. They all match each other, so
+         // checking the first is enough (and keeps appending linear).
+         if ( !children_.front()->isTypeEquivalent( ni ) )
          {
-            if ( !child->isTypeEquivalent( ni ) )
-            {
-               throw E57_EXCEPTION2( ErrorHomogeneousViolation,
-                                     "this->pathName=" + this->pathName() );
-            }
+            throw E57_EXCEPTION2( ErrorHomogeneousViolation,
+                                  "this->pathName=" + this->pathName() );
          }
       }
 
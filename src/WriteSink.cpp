@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: BSL-1.0
+
+/// @file WriteSink.cpp
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common.h"
+#include "StringFunctions.h"
+
+using namespace e57;
+
+/*!
+@class e57::WriteSink
+@brief Interface for writing an E57 file somewhere other than a local file.
+
+@details
+Implement this to write an ImageFile (or a Writer) straight into object storage, a database or any
+other store, without writing a local file first. The file is written with positional writes: most
+of it in order, but the file header at the start is written again when the file is closed, and the
+pages only partly written are read back (see readAt()) to add the rest of them. MemoryWriteSink
+keeps the whole file in memory.
+
+The writes come from one thread at a time, though not always the same one (e.g. with
+CompressedVectorWriterOptions::backgroundWrite). The sink is shared by the ImageFile, which keeps
+it until it is closed.
+
+@see ImageFile::ImageFile(std::shared_ptr<WriteSink>), MemoryWriteSink
+*/
+
+WriteSink::~WriteSink() = default;
+
+/*!
+@fn void WriteSink::writeAt( uint64_t offset, const char *buffer, size_t count )
+@brief Write the @a count bytes of @a buffer at byte @a offset of the file.
+
+@details The file grows to hold them if they are past its end. All of the bytes must be written, or
+an exception thrown. Exceptions other than E57Exception are reported as ::ErrorWriteFailed.
+*/
+
+/*!
+@fn void WriteSink::readAt( uint64_t offset, char *buffer, size_t count )
+@brief Read back @a count bytes starting at byte @a offset of the file into @a buffer.
+
+@details Only bytes which have already been written are read back. All of the bytes must be read, or
+an exception thrown. Exceptions other than E57Exception are reported as ::ErrorReadFailed.
+*/
+
+/*!
+@brief Get the name of the file for the error messages, e.g. its URL.
+*/
+ustring WriteSink::name() const
+{
+   return "<WriteSink>";
+}
+
+/*!
+@brief Make room for a file of @a size bytes.
+
+@details This is only a hint (see ImageFile::reserveSpace()). The default does nothing.
+*/
+void WriteSink::reserve( uint64_t /*size*/ )
+{
+}
+
+/*!
+@brief Called once the whole file has been written, when the ImageFile is closed.
+
+@details Use it to complete the file, e.g. by finishing an upload. Exceptions other than
+E57Exception are reported as ::ErrorWriteFailed. The default does nothing.
+*/
+void WriteSink::finish()
+{
+}
+
+/*!
+@brief Called instead of finish() when the file is abandoned (see ImageFile::cancel()).
+
+@details Use it to throw away what was written, e.g. by aborting an upload. It must not throw. The
+default does nothing.
+*/
+void WriteSink::discard()
+{
+}
+
+/*!
+@class e57::MemoryWriteSink
+@brief A WriteSink which keeps the file in a growable memory buffer.
+
+@details Once the ImageFile (or Writer) is closed, data() is the complete file, which may be read
+with ImageFile::ImageFile(const char *, uint64_t, ReadChecksumPolicy), uploaded, etc.
+*/
+
+void MemoryWriteSink::writeAt( uint64_t offset, const char *buffer, size_t count )
+{
+   const uint64_t cEnd = offset + count;
+
+   if ( cEnd > data_.size() )
+   {
+      // Grow geometrically, as the file is mostly written in order
+      if ( cEnd > data_.capacity() )
+      {
+         data_.reserve( static_cast<size_t>( std::max<uint64_t>( cEnd, data_.capacity() * 2 ) ) );
+      }
+
+      data_.resize( static_cast<size_t>( cEnd ) );
+   }
+
+   memcpy( data_.data() + offset, buffer, count );
+}
+
+void MemoryWriteSink::readAt( uint64_t offset, char *buffer, size_t count )
+{
+   if ( offset + count > data_.size() )
+   {
+      throw E57_EXCEPTION2( ErrorReadFailed, "fileName=" + name() + " offset=" +
+                                                toString( offset ) + " count=" + toString( count ) +
+                                                " size=" + toString( data_.size() ) );
+   }
+
+   memcpy( buffer, data_.data() + offset, count );
+}
+
+ustring MemoryWriteSink::name() const
+{
+   return "<MemoryWriteSink>";
+}
+
+void MemoryWriteSink::reserve( uint64_t size )
+{
+   data_.reserve( static_cast<size_t>( size ) );
+}
+
+/*!
+@brief Get the bytes written so far: the whole file once it's closed.
+*/
+const std::vector<char> &MemoryWriteSink::data() const
+{
+   return data_;
+}
+
+/*!
+@brief Take the bytes written so far, leaving the sink empty.
+
+@details Use this once the file is closed to keep the file without copying it.
+*/
+std::vector<char> MemoryWriteSink::takeData()
+{
+   std::vector<char> data;
+   data.swap( data_ );
+
+   return data;
+}
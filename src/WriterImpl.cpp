@@ -26,12 +26,17 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
 
-#include "WriterImpl.h"
-
+// Common.h must come first for the access to the writers' implementation
 #include "Common.h"
+#include "CompressedVectorWriterImpl.h"
 #include "E57Version.h"
+#include "FileMerger.h"
+#include "InterleavedBuffers.h"
+#include "PointOrdering.h"
+#include "WriterImpl.h"
 
 namespace
 {
@@ -71,6 +76,36 @@ namespace
                .append( std::to_string( static_cast<int>( inNodeType ) ) );
       }
    }
+
+   /// Call @a function with each buffer of @a from & the matching one of @a to.
+   template <typename COORDTYPE, typename Function>
+   void _forEachPointBuffer( const e57::Data3DPointsData_t<COORDTYPE> &from,
+                             e57::Data3DPointsData_t<COORDTYPE> &to, Function function )
+   {
+      function( from.cartesianX, to.cartesianX );
+      function( from.cartesianY, to.cartesianY );
+      function( from.cartesianZ, to.cartesianZ );
+      function( from.cartesianInvalidState, to.cartesianInvalidState );
+      function( from.intensity, to.intensity );
+      function( from.isIntensityInvalid, to.isIntensityInvalid );
+      function( from.colorRed, to.colorRed );
+      function( from.colorGreen, to.colorGreen );
+      function( from.colorBlue, to.colorBlue );
+      function( from.isColorInvalid, to.isColorInvalid );
+      function( from.sphericalRange, to.sphericalRange );
+      function( from.sphericalAzimuth, to.sphericalAzimuth );
+      function( from.sphericalElevation, to.sphericalElevation );
+      function( from.sphericalInvalidState, to.sphericalInvalidState );
+      function( from.rowIndex, to.rowIndex );
+      function( from.columnIndex, to.columnIndex );
+      function( from.returnIndex, to.returnIndex );
+      function( from.returnCount, to.returnCount );
+      function( from.timeStamp, to.timeStamp );
+      function( from.isTimeStampInvalid, to.isTimeStampInvalid );
+      function( from.normalX, to.normalX );
+      function( from.normalY, to.normalY );
+      function( from.normalZ, to.normalZ );
+   }
 }
 
 namespace e57
@@ -125,9 +160,62 @@ namespace e57
       return transferred;
    }
 
+   // A sink always holds a new file
+   static std::shared_ptr<WriteSink> newFileSink( std::shared_ptr<WriteSink> sink,
+                                                  const WriterOptions &options )
+   {
+      if ( options.append )
+      {
+         throw E57_EXCEPTION2( ErrorBadAPIArgument,
+                               "append=true sink=" + ( sink ? sink->name() : "nullptr" ) );
+      }
+
+      return sink;
+   }
+
    WriterImpl::WriterImpl( const ustring &filePath, const WriterOptions &options ) :
-      imf_( filePath, "w" ), root_( imf_.root() ), data3D_( imf_, true ), images2D_( imf_, true )
+      WriterImpl( ImageFile( filePath, options.append ? "a" : "w", ChecksumAll, ReadBackendFile,
+                             options.fileCache ),
+                  options )
+   {
+   }
+
+   WriterImpl::WriterImpl( std::shared_ptr<WriteSink> sink, const WriterOptions &options ) :
+      WriterImpl( ImageFile( newFileSink( std::move( sink ), options ) ), options )
+   {
+   }
+
+   WriterImpl::WriterImpl( const ImageFile &imf, const WriterOptions &options ) :
+      imf_( imf ), root_( imf_.root() ), data3D_( imf_, true ), images2D_( imf_, true ),
+      compressedVectorWriterOptions_( options.compressedVectorWriter ),
+      computeBounds_( options.computeBounds ), pointOrder_( options.pointOrder ),
+      lodNodePointCount_( options.lodNodePointCount ), pointPrecision_( options.pointPrecision ),
+      anglePrecision_( options.anglePrecision )
    {
+      // Keep the per-file properties of an existing file, and add to its scans & images
+      if ( options.append )
+      {
+         if ( root_.isDefined( "data3D" ) )
+         {
+            data3D_ = VectorNode( root_.get( "data3D" ) );
+         }
+         else
+         {
+            root_.set( "data3D", data3D_ );
+         }
+
+         if ( root_.isDefined( "images2D" ) )
+         {
+            images2D_ = VectorNode( root_.get( "images2D" ) );
+         }
+         else
+         {
+            root_.set( "images2D", images2D_ );
+         }
+
+         return;
+      }
+
       // We are using the E57 v1.0 data format standard field names.
       // The standard field names are used without an extension prefix (in the default namespace).
       // We explicitly register it for completeness (the reference implementation would do it for
@@ -193,6 +281,20 @@ namespace e57
          return false;
       }
 
+      // Save the bounds of the scans whose points were written with NewData3D() &
+      // SetUpData3DPointsData(). Writers which weren't closed are closed here.
+      for ( auto &pending : boundsWriters_ )
+      {
+         if ( pending.second.isOpen() )
+         {
+            pending.second.close();
+         }
+
+         saveBounds( pending.first, pending.second, nullptr );
+      }
+
+      boundsWriters_.clear();
+
       imf_.close();
       return true;
    }
@@ -1157,7 +1259,8 @@ namespace e57
 
    template <typename COORDTYPE>
    CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
-      int64_t dataIndex, size_t count, const Data3DPointsData_t<COORDTYPE> &buffers )
+      int64_t dataIndex, size_t count, const Data3DPointsData_t<COORDTYPE> &buffers,
+      uint64_t expectedPointCount, bool chunkStatistics )
    {
       static_assert( std::is_floating_point<COORDTYPE>::value, "Floating point type required." );
 
@@ -1294,18 +1397,432 @@ namespace e57
          }
       }
 
+      return pointsWriter( dataIndex, points, sourceBuffers, expectedPointCount, chunkStatistics );
+   }
+
+   CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
+      int64_t dataIndex, size_t count, const Data3DPointsInterleaved &buffers )
+   {
+      const StructureNode scan( data3D_.get( dataIndex ) );
+      CompressedVectorNode points( scan.get( "points" ) );
+      const StructureNode proto( points.prototype() );
+
+      std::vector<SourceDestBuffer> sourceBuffers =
+         interleavedBuffers( imf_, proto, buffers, count );
+
+      return pointsWriter( dataIndex, points, sourceBuffers, 0, false );
+   }
+
+   CompressedVectorWriter WriterImpl::pointsWriter( int64_t dataIndex,
+                                                    CompressedVectorNode &points,
+                                                    std::vector<SourceDestBuffer> &sourceBuffers,
+                                                    uint64_t expectedPointCount,
+                                                    bool chunkStatistics )
+   {
+      CompressedVectorWriterOptions writerOptions = compressedVectorWriterOptions_;
+
+      writerOptions.chunkStatistics = writerOptions.chunkStatistics || chunkStatistics;
+
+      if ( expectedPointCount > 0 )
+      {
+         writerOptions.expectedRecordCount = expectedPointCount;
+      }
+
       // create the writer, all buffers must be setup before this call
-      CompressedVectorWriter writer = points.writer( sourceBuffers );
+      CompressedVectorWriter writer = points.writer( sourceBuffers, writerOptions );
+
+      if ( computeBounds_ )
+      {
+         writer.impl()->gatherStatistics();
+
+         boundsWriters_.emplace_back( dataIndex, writer );
+      }
 
       return writer;
    }
 
+   void WriterImpl::FinishData3DPointsData( int64_t dataIndex, Data3D &data3DHeader )
+   {
+      auto pending =
+         std::find_if( boundsWriters_.begin(), boundsWriters_.end(),
+                       [dataIndex]( const std::pair<int64_t, CompressedVectorWriter> &entry ) {
+                          return entry.first == dataIndex;
+                       } );
+
+      if ( pending == boundsWriters_.end() )
+      {
+         return;
+      }
+
+      saveBounds( dataIndex, pending->second, &data3DHeader );
+
+      boundsWriters_.erase( pending );
+   }
+
+   // Add the cartesianBounds & sphericalBounds to the scan from the ranges of the values written,
+   // unless they were already given.
+   void WriterImpl::saveBounds( int64_t dataIndex, const CompressedVectorWriter &writer,
+                                Data3D *data3DHeader )
+   {
+      const auto cWriter = writer.impl();
+
+      // The ranges include the values of points with an invalid state too
+      double minimum[3];
+      double maximum[3];
+
+      const auto limits = [&]( const char *x, const char *y, const char *z ) {
+         return cWriter->fieldLimits( x, minimum[0], maximum[0] ) &&
+                cWriter->fieldLimits( y, minimum[1], maximum[1] ) &&
+                cWriter->fieldLimits( z, minimum[2], maximum[2] );
+      };
+
+      StructureNode scan( data3D_.get( dataIndex ) );
+
+      if ( !scan.isDefined( "cartesianBounds" ) &&
+           limits( "cartesianX", "cartesianY", "cartesianZ" ) )
+      {
+         StructureNode bbox( imf_ );
+
+         bbox.set( "xMinimum", FloatNode( imf_, minimum[0] ) );
+         bbox.set( "xMaximum", FloatNode( imf_, maximum[0] ) );
+         bbox.set( "yMinimum", FloatNode( imf_, minimum[1] ) );
+         bbox.set( "yMaximum", FloatNode( imf_, maximum[1] ) );
+         bbox.set( "zMinimum", FloatNode( imf_, minimum[2] ) );
+         bbox.set( "zMaximum", FloatNode( imf_, maximum[2] ) );
+
+         scan.set( "cartesianBounds", bbox );
+
+         if ( data3DHeader != nullptr )
+         {
+            CartesianBounds &bounds = data3DHeader->cartesianBounds;
+
+            bounds.xMinimum = minimum[0];
+            bounds.xMaximum = maximum[0];
+            bounds.yMinimum = minimum[1];
+            bounds.yMaximum = maximum[1];
+            bounds.zMinimum = minimum[2];
+            bounds.zMaximum = maximum[2];
+         }
+
+      }
+
+      if ( !scan.isDefined( "sphericalBounds" ) &&
+           limits( "sphericalRange", "sphericalElevation", "sphericalAzimuth" ) )
+      {
+         StructureNode sbox( imf_ );
+
+         sbox.set( "rangeMinimum", FloatNode( imf_, minimum[0] ) );
+         sbox.set( "rangeMaximum", FloatNode( imf_, maximum[0] ) );
+         sbox.set( "elevationMinimum", FloatNode( imf_, minimum[1] ) );
+         sbox.set( "elevationMaximum", FloatNode( imf_, maximum[1] ) );
+         sbox.set( "azimuthStart", FloatNode( imf_, minimum[2] ) );
+         sbox.set( "azimuthEnd", FloatNode( imf_, maximum[2] ) );
+
+         scan.set( "sphericalBounds", sbox );
+
+         if ( data3DHeader != nullptr )
+         {
+            SphericalBounds &bounds = data3DHeader->sphericalBounds;
+
+            bounds.rangeMinimum = minimum[0];
+            bounds.rangeMaximum = maximum[0];
+            bounds.elevationMinimum = minimum[1];
+            bounds.elevationMaximum = maximum[1];
+            bounds.azimuthStart = minimum[2];
+            bounds.azimuthEnd = maximum[2];
+         }
+
+      }
+   }
+
+   template <typename COORDTYPE>
+   void WriterImpl::WriteData3DPoints( int64_t dataIndex, const Data3D &data3DHeader,
+                                       const Data3DPointsData_t<COORDTYPE> &buffers )
+   {
+      const auto cPointCount = static_cast<size_t>( data3DHeader.pointCount );
+
+      PointOrdering::Box box;
+      std::vector<LevelOfDetail::Node> nodes;
+      std::vector<size_t> order;
+
+      if ( ( lodNodePointCount_ > 0 ) && ( cPointCount > 0 ) )
+      {
+         order = LevelOfDetail::build( buffers, cPointCount, lodNodePointCount_, box, nodes );
+      }
+      else if ( ( pointOrder_ != PointOrderAcquisition ) && ( cPointCount > 0 ) )
+      {
+         order = PointOrdering::sort( buffers, cPointCount, pointOrder_, box );
+      }
+
+      if ( order.empty() )
+      {
+         // The whole scan is written at once, so the writer knows how many points to expect
+         CompressedVectorWriter writer =
+            SetUpData3DPointsData( dataIndex, cPointCount, buffers, cPointCount );
+
+         writer.write( cPointCount );
+         writer.close();
+
+         return;
+      }
+
+      // Gather the sorted points into buffers of a block of points at a time, so only the order
+      // & one block are needed on top of the caller's buffers.
+      constexpr size_t cBlockSize = 64 * 1024;
+
+      const size_t cBlockCount = std::min( cPointCount, cBlockSize );
+
+      Data3DPointsData_t<COORDTYPE> block;
+      std::vector<std::shared_ptr<void>> storage;
+
+      _forEachPointBuffer( buffers, block, [&]( const auto *from, auto *&to ) {
+         using Value = typename std::remove_const<
+            typename std::remove_pointer<decltype( from )>::type>::type;
+
+         if ( from != nullptr )
+         {
+            to = new Value[cBlockCount];
+
+            storage.emplace_back( to, std::default_delete<Value[]>() );
+         }
+      } );
+
+      CompressedVectorWriter writer =
+         SetUpData3DPointsData( dataIndex, cBlockCount, block, cPointCount, true );
+
+      for ( size_t first = 0; first < cPointCount; first += cBlockCount )
+      {
+         const size_t cCount = std::min( cBlockCount, cPointCount - first );
+
+         _forEachPointBuffer( buffers, block, [&]( const auto *from, auto *&to ) {
+            if ( from != nullptr )
+            {
+               for ( size_t i = 0; i < cCount; ++i )
+               {
+                  to[i] = from[order[first + i]];
+               }
+            }
+         } );
+
+         writer.write( cCount );
+      }
+
+      writer.close();
+
+      if ( lodNodePointCount_ > 0 )
+      {
+         saveLevelOfDetail( dataIndex, box, nodes );
+      }
+      else
+      {
+         savePointOrder( dataIndex, box.minimum, box.maximum );
+      }
+   }
+
+   // Record the curve in an extension structure in the scan:
+   //
+   //    <prefix>:pointOrder/curve                     "morton" or "hilbert"
+   //    <prefix>:pointOrder/bitsPerAxis               bits of each coordinate in the keys
+   //    <prefix>:pointOrder/bounds/{x,y,z}{Minimum,Maximum}
+   //
+   // The coordinates are quantized to bitsPerAxis bits over the bounds before their bits are
+   // interleaved (x most significant), and the points with an invalid state come last.
+   void WriterImpl::savePointOrder( int64_t dataIndex, const double ( &minimum )[3],
+                                    const double ( &maximum )[3] )
+   {
+      ustring prefix;
+
+      if ( !imf_.extensionsLookupUri( PointOrdering::cPointOrderUri, prefix ) )
+      {
+         prefix = PointOrdering::cPointOrderPrefix;
+
+         ustring uri;
+
+         // Don't use the prefix if the file uses it for something else
+         if ( imf_.extensionsLookupPrefix( prefix, uri ) )
+         {
+            return;
+         }
+
+         imf_.extensionsAdd( prefix, PointOrdering::cPointOrderUri );
+      }
+
+      StructureNode scan( data3D_.get( dataIndex ) );
+      StructureNode pointOrder( imf_ );
+      StructureNode bounds( imf_ );
+
+      pointOrder.set( "curve", StringNode( imf_, PointOrdering::curveName( pointOrder_ ) ) );
+      pointOrder.set( "bitsPerAxis", IntegerNode( imf_, PointOrdering::cBitsPerAxis ) );
+
+      bounds.set( "xMinimum", FloatNode( imf_, minimum[0] ) );
+      bounds.set( "xMaximum", FloatNode( imf_, maximum[0] ) );
+      bounds.set( "yMinimum", FloatNode( imf_, minimum[1] ) );
+      bounds.set( "yMaximum", FloatNode( imf_, maximum[1] ) );
+      bounds.set( "zMinimum", FloatNode( imf_, minimum[2] ) );
+      bounds.set( "zMaximum", FloatNode( imf_, maximum[2] ) );
+
+      pointOrder.set( "bounds", bounds );
+
+      scan.set( prefix + ":" + PointOrdering::cPointOrderElement, pointOrder );
+   }
+
+   // Save the octree in an extension structure in the scan:
+   //
+   //    <prefix>:levelOfDetail/nodePointCount   most points in a node above the deepest level
+   //    <prefix>:levelOfDetail/nodes            compressed vector of the nodes
+   //
+   // Each node record has the level of the node (0 for the root), the bounds of its cell
+   // (xMinimum ... zMaximum) and the range of its points (firstPoint & pointCount). The nodes
+   // are ordered by level, then by the Morton order of their cells.
+   void WriterImpl::saveLevelOfDetail( int64_t dataIndex, const PointOrdering::Box &box,
+                                       const std::vector<LevelOfDetail::Node> &nodes )
+   {
+      ustring prefix;
+
+      if ( !imf_.extensionsLookupUri( LevelOfDetail::cLevelOfDetailUri, prefix ) )
+      {
+         prefix = LevelOfDetail::cLevelOfDetailPrefix;
+
+         ustring uri;
+
+         // Don't use the prefix if the file uses it for something else
+         if ( imf_.extensionsLookupPrefix( prefix, uri ) )
+         {
+            return;
+         }
+
+         imf_.extensionsAdd( prefix, LevelOfDetail::cLevelOfDetailUri );
+      }
+
+      StructureNode scan( data3D_.get( dataIndex ) );
+      const int64_t cPointCount = CompressedVectorNode( scan.get( "points" ) ).childCount();
+
+      StructureNode levelOfDetail( imf_ );
+      levelOfDetail.set( "nodePointCount", IntegerNode( imf_, lodNodePointCount_ ) );
+
+      StructureNode proto( imf_ );
+      proto.set( "level", IntegerNode( imf_, 0, 0, LevelOfDetail::cMaximumLevel ) );
+      proto.set( "xMinimum", FloatNode( imf_ ) );
+      proto.set( "xMaximum", FloatNode( imf_ ) );
+      proto.set( "yMinimum", FloatNode( imf_ ) );
+      proto.set( "yMaximum", FloatNode( imf_ ) );
+      proto.set( "zMinimum", FloatNode( imf_ ) );
+      proto.set( "zMaximum", FloatNode( imf_ ) );
+      proto.set( "firstPoint", IntegerNode( imf_, 0, 0, cPointCount ) );
+      proto.set( "pointCount", IntegerNode( imf_, 0, 0, cPointCount ) );
+
+      CompressedVectorNode nodesVector( imf_, proto, VectorNode( imf_, true ) );
+      levelOfDetail.set( "nodes", nodesVector );
+
+      // The compressed vector must be in the tree before its writer is created
+      scan.set( prefix + ":" + LevelOfDetail::cLevelOfDetailElement, levelOfDetail );
+
+      const size_t cNodeCount = nodes.size();
+
+      if ( cNodeCount == 0 )
+      {
+         return;
+      }
+
+      std::vector<int32_t> level( cNodeCount );
+      std::vector<double> bounds[6];
+      std::vector<int64_t> firstPoint( cNodeCount );
+      std::vector<int64_t> pointCount( cNodeCount );
+
+      for ( auto &field : bounds )
+      {
+         field.resize( cNodeCount );
+      }
+
+      for ( size_t i = 0; i < cNodeCount; ++i )
+      {
+         double minimum[3];
+         double maximum[3];
+
+         LevelOfDetail::nodeBounds( nodes[i], box, minimum, maximum );
+
+         level[i] = static_cast<int32_t>( nodes[i].level );
+         firstPoint[i] = static_cast<int64_t>( nodes[i].firstRecord );
+         pointCount[i] = static_cast<int64_t>( nodes[i].recordCount );
+
+         for ( int axis = 0; axis < 3; ++axis )
+         {
+            bounds[2 * axis][i] = minimum[axis];
+            bounds[2 * axis + 1][i] = maximum[axis];
+         }
+      }
+
+      const char *cBoundsNames[6] = { "xMinimum", "xMaximum", "yMinimum",
+                                      "yMaximum", "zMinimum", "zMaximum" };
+
+      std::vector<SourceDestBuffer> sourceBuffers;
+
+      sourceBuffers.emplace_back( imf_, "level", level.data(), cNodeCount, true );
+
+      for ( int i = 0; i < 6; ++i )
+      {
+         sourceBuffers.emplace_back( imf_, cBoundsNames[i], bounds[i].data(), cNodeCount, true );
+      }
+
+      sourceBuffers.emplace_back( imf_, "firstPoint", firstPoint.data(), cNodeCount, true );
+      sourceBuffers.emplace_back( imf_, "pointCount", pointCount.data(), cNodeCount, true );
+
+      CompressedVectorWriter writer = nodesVector.writer( sourceBuffers );
+
+      writer.write( cNodeCount );
+      writer.close();
+   }
+
    // Explicit template instantiation
    template CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
-      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<float> &buffers );
+      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<float> &buffers,
+      uint64_t expectedPointCount, bool chunkStatistics );
 
    template CompressedVectorWriter WriterImpl::SetUpData3DPointsData(
-      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<double> &buffers );
+      int64_t dataIndex, size_t pointCount, const Data3DPointsData_t<double> &buffers,
+      uint64_t expectedPointCount, bool chunkStatistics );
+
+   template <typename COORDTYPE> void WriterImpl::QuantizeData3D( Data3D &data3DHeader ) const
+   {
+      // The limits Writer::WriteData3DData() replaces with those of the points
+      constexpr double cLowest = std::numeric_limits<COORDTYPE>::lowest();
+      constexpr double cMax = std::numeric_limits<COORDTYPE>::max();
+
+      PointStandardizedFieldsAvailable &pointFields = data3DHeader.pointFields;
+
+      // Without points there are no limits to compute
+      if ( data3DHeader.pointCount <= 0 )
+      {
+         return;
+      }
+
+      if ( ( pointPrecision_ > 0.0 ) &&
+           ( pointFields.pointRangeNodeType != NumericalNodeType::ScaledInteger ) )
+      {
+         pointFields.pointRangeNodeType = NumericalNodeType::ScaledInteger;
+         pointFields.pointRangeScale = pointPrecision_;
+         pointFields.pointRangeMinimum = cLowest;
+         pointFields.pointRangeMaximum = cMax;
+      }
+
+      if ( ( anglePrecision_ > 0.0 ) &&
+           ( pointFields.angleNodeType != NumericalNodeType::ScaledInteger ) )
+      {
+         pointFields.angleNodeType = NumericalNodeType::ScaledInteger;
+         pointFields.angleScale = anglePrecision_;
+         pointFields.angleMinimum = cLowest;
+         pointFields.angleMaximum = cMax;
+      }
+   }
+
+   template void WriterImpl::QuantizeData3D<float>( Data3D &data3DHeader ) const;
+   template void WriterImpl::QuantizeData3D<double>( Data3D &data3DHeader ) const;
+
+   template void WriterImpl::WriteData3DPoints( int64_t dataIndex, const Data3D &data3DHeader,
+                                                const Data3DPointsData_t<float> &buffers );
+
+   template void WriterImpl::WriteData3DPoints( int64_t dataIndex, const Data3D &data3DHeader,
+                                                const Data3DPointsData_t<double> &buffers );
 
    // This function writes out the group data
    bool WriterImpl::WriteData3DGroupsData( int64_t dataIndex, size_t groupCount,
@@ -1345,13 +1862,22 @@ namespace e57
       groupSDBuffers.emplace_back( imf_, "startPointIndex", startPointIndex, groupCount, true );
       groupSDBuffers.emplace_back( imf_, "pointCount", pointCount, groupCount, true );
 
-      CompressedVectorWriter writer = groups.writer( groupSDBuffers );
+      CompressedVectorWriterOptions writerOptions = compressedVectorWriterOptions_;
+      writerOptions.expectedRecordCount = groupCount;
+
+      CompressedVectorWriter writer = groups.writer( groupSDBuffers, writerOptions );
       writer.write( groupCount );
       writer.close();
 
       return true;
    }
 
+   MergeReport WriterImpl::MergeFrom( const std::vector<ustring> &inputPaths,
+                                      const MergeOptions &options )
+   {
+      return mergeFiles( imf_, data3D_, images2D_, inputPaths, options );
+   }
+
    StructureNode WriterImpl::GetRawE57Root()
    {
       return root_;
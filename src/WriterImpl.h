@@ -30,6 +30,7 @@
 
 #include "E57SimpleData.h"
 #include "E57SimpleWriter.h"
+#include "LevelOfDetail.h"
 
 namespace e57
 {
@@ -37,6 +38,7 @@ namespace e57
    {
    public:
       WriterImpl( const ustring &filePath, const WriterOptions &options );
+      WriterImpl( std::shared_ptr<WriteSink> sink, const WriterOptions &options );
       ~WriterImpl();
 
       // disallow copying a WriterImpl
@@ -59,11 +61,33 @@ namespace e57
 
       template <typename COORDTYPE>
       CompressedVectorWriter SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
-                                                    const Data3DPointsData_t<COORDTYPE> &buffers );
+                                                    const Data3DPointsData_t<COORDTYPE> &buffers,
+                                                    uint64_t expectedPointCount = 0,
+                                                    bool chunkStatistics = false );
+
+      CompressedVectorWriter SetUpData3DPointsData( int64_t dataIndex, size_t pointCount,
+                                                    const Data3DPointsInterleaved &buffers );
+
+      /// Write all the points of scan @a dataIndex from @a buffers, in the order given by
+      /// WriterOptions::pointOrder.
+      template <typename COORDTYPE>
+      void WriteData3DPoints( int64_t dataIndex, const Data3D &data3DHeader,
+                              const Data3DPointsData_t<COORDTYPE> &buffers );
+
+      /// Change the point range & angle fields of @a data3DHeader to ScaledIntegers with the
+      /// precisions of the WriterOptions, if they are set, and clear their limits so they are
+      /// computed from the points.
+      template <typename COORDTYPE> void QuantizeData3D( Data3D &data3DHeader ) const;
+
+      /// Save the bounds computed while writing the points of scan @a dataIndex (see
+      /// WriterOptions::computeBounds) & copy them to @a data3DHeader. The writer must be closed.
+      void FinishData3DPointsData( int64_t dataIndex, Data3D &data3DHeader );
 
       bool WriteData3DGroupsData( int64_t dataIndex, size_t groupCount, int64_t *idElementValue,
                                   int64_t *startPointIndex, int64_t *pointCount );
 
+      MergeReport MergeFrom( const std::vector<ustring> &inputPaths, const MergeOptions &options );
+
       StructureNode GetRawE57Root();
 
       VectorNode GetRawData3D();
@@ -73,11 +97,42 @@ namespace e57
       ImageFile GetRawIMF();
 
    private:
+      WriterImpl( const ImageFile &imf, const WriterOptions &options );
+
       ImageFile imf_;
       StructureNode root_;
 
       VectorNode data3D_;
 
       VectorNode images2D_;
+
+      CompressedVectorWriterOptions compressedVectorWriterOptions_;
+
+      /// Point writers whose bounds still need to be saved, by scan index
+      bool computeBounds_;
+      std::vector<std::pair<int64_t, CompressedVectorWriter>> boundsWriters_;
+
+      PointOrder pointOrder_;
+      uint32_t lodNodePointCount_;
+
+      double pointPrecision_;
+      double anglePrecision_;
+
+      /// Create the writer of the points of scan @a dataIndex from @a sourceBuffers
+      CompressedVectorWriter pointsWriter( int64_t dataIndex, CompressedVectorNode &points,
+                                           std::vector<SourceDestBuffer> &sourceBuffers,
+                                           uint64_t expectedPointCount, bool chunkStatistics );
+
+      void saveBounds( int64_t dataIndex, const CompressedVectorWriter &writer,
+                       Data3D *data3DHeader );
+
+      /// Record the curve the points of scan @a dataIndex are sorted along & the box it was
+      /// fitted to.
+      void savePointOrder( int64_t dataIndex, const double ( &minimum )[3],
+                           const double ( &maximum )[3] );
+
+      /// Save the octree @a nodes of scan @a dataIndex, built in @a box.
+      void saveLevelOfDetail( int64_t dataIndex, const PointOrdering::Box &box,
+                              const std::vector<LevelOfDetail::Node> &nodes );
    }; // end Writer class
 } // end namespace e57
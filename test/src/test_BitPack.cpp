@@ -0,0 +1,312 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "BitPack.h"
+
+namespace
+{
+   // Read one field a bit at a time
+   int64_t referenceField( const std::vector<char> &buffer, size_t firstBit, unsigned bits,
+                           int64_t minimum )
+   {
+      uint64_t field = 0;
+
+      for ( unsigned i = 0; i < bits; ++i )
+      {
+         const size_t bit = firstBit + i;
+         const uint64_t value = ( static_cast<uint8_t>( buffer[bit / 8] ) >> ( bit % 8 ) ) & 1;
+
+         field |= value << i;
+      }
+
+      return static_cast<int64_t>( static_cast<uint64_t>( minimum ) + field );
+   }
+}
+
+TEST( BitPack, UnpackMatchesReference )
+{
+   std::mt19937_64 generator( 42 );
+
+   constexpr size_t cCount = 301; // not a multiple of the vector width
+
+   for ( unsigned bits = 1; bits <= 64; ++bits )
+   {
+      for ( size_t firstBit = 0; firstBit < 8; firstBit += 3 )
+      {
+         // Size the buffer exactly so reading past the end would be caught by sanitizers
+         const size_t byteCount = ( firstBit + cCount * bits + 7 ) / 8;
+
+         std::vector<char> buffer( byteCount );
+
+         for ( auto &c : buffer )
+         {
+            c = static_cast<char>( generator() );
+         }
+
+         const int64_t minimum = static_cast<int64_t>( generator() ) >> ( 64 - bits );
+
+         std::vector<int64_t> values( cCount );
+         std::vector<int64_t> valuesSoftware( cCount );
+
+         e57::BitPack::unpack( buffer.data(), byteCount, firstBit, bits, minimum, cCount,
+                               values.data() );
+         e57::BitPack::unpackSoftware( buffer.data(), byteCount, firstBit, bits, minimum, cCount,
+                                       valuesSoftware.data() );
+
+         for ( size_t i = 0; i < cCount; ++i )
+         {
+            const int64_t expected = referenceField( buffer, firstBit + i * bits, bits, minimum );
+
+            ASSERT_EQ( values[i], expected ) << "bits=" << bits << " firstBit=" << firstBit
+                                             << " i=" << i;
+            ASSERT_EQ( valuesSoftware[i], expected ) << "bits=" << bits
+                                                     << " firstBit=" << firstBit << " i=" << i;
+         }
+      }
+   }
+}
+
+TEST( BitPack, ScaleMatchesScalar )
+{
+   std::mt19937_64 generator( 7 );
+
+   constexpr int64_t cLimit = int64_t( 1 ) << 51;
+   constexpr size_t cCount = 1003;
+
+   std::vector<int64_t> values( cCount );
+
+   for ( auto &value : values )
+   {
+      value = static_cast<int64_t>( generator() % ( 2 * cLimit ) ) - cLimit;
+   }
+
+   // Include the ends of the range
+   values[0] = -cLimit;
+   values[1] = cLimit - 1;
+   values[2] = 0;
+   values[3] = -1;
+
+   const double cScale = 0.001;
+   const double cOffset = -123.456;
+
+   std::vector<double> results( cCount );
+
+   e57::BitPack::scale( values.data(), cCount, cScale, cOffset, results.data() );
+
+   for ( size_t i = 0; i < cCount; ++i )
+   {
+      const double expected = static_cast<double>( values[i] ) * cScale + cOffset;
+
+      ASSERT_EQ( results[i], expected ) << "value=" << values[i];
+   }
+}
+
+TEST( BitPack, FindOutOfRange )
+{
+   std::vector<int64_t> values( 103, 5 );
+
+   EXPECT_EQ( e57::BitPack::findOutOfRange( values.data(), values.size(), 0, 10 ), 103u );
+
+   values[101] = 11;
+   values[57] = -1;
+
+   EXPECT_EQ( e57::BitPack::findOutOfRange( values.data(), values.size(), 0, 10 ), 57u );
+   EXPECT_EQ( e57::BitPack::findOutOfRange( values.data(), 57, 0, 10 ), 57u );
+   EXPECT_EQ( e57::BitPack::findOutOfRange( values.data() + 58, 45, 0, 10 ), 43u );
+}
+
+TEST( BitPack, FindOutOfRangeReal )
+{
+   std::vector<double> doubles( 103, 0.5 );
+   std::vector<float> floats( 103, 0.5F );
+
+   // NaNs & the limits themselves are in range
+   doubles[3] = std::nan( "" );
+   doubles[4] = 1.0;
+   floats[5] = std::nanf( "" );
+   floats[6] = 0.0F;
+
+   EXPECT_EQ( e57::BitPack::findOutOfRange( doubles.data(), doubles.size(), 0.0, 1.0 ), 103u );
+   EXPECT_EQ( e57::BitPack::findOutOfRange( floats.data(), floats.size(), 0.0F, 1.0F ), 103u );
+
+   doubles[101] = 1.0000000001;
+   doubles[57] = -std::numeric_limits<double>::infinity();
+   floats[97] = -0.0001F;
+
+   EXPECT_EQ( e57::BitPack::findOutOfRange( doubles.data(), doubles.size(), 0.0, 1.0 ), 57u );
+   EXPECT_EQ( e57::BitPack::findOutOfRangeSoftware( doubles.data(), doubles.size(), 0.0, 1.0 ),
+              57u );
+   EXPECT_EQ( e57::BitPack::findOutOfRange( doubles.data() + 58, 45, 0.0, 1.0 ), 43u );
+   EXPECT_EQ( e57::BitPack::findOutOfRange( floats.data(), floats.size(), 0.0F, 1.0F ), 97u );
+   EXPECT_EQ( e57::BitPack::findOutOfRange( floats.data(), 97, 0.0F, 1.0F ), 97u );
+}
+
+TEST( BitPack, MinMax )
+{
+   std::mt19937_64 generator( 99 );
+
+   constexpr size_t cCount = 1003;
+
+   std::vector<int64_t> integers( cCount );
+   std::vector<double> doubles( cCount );
+   std::vector<float> floats( cCount );
+
+   for ( size_t i = 0; i < cCount; ++i )
+   {
+      integers[i] = static_cast<int64_t>( generator() );
+      doubles[i] = static_cast<double>( integers[i] ) * 1.0e-9;
+      floats[i] = static_cast<float>( doubles[i] );
+   }
+
+   // NaNs are skipped wherever they are
+   doubles[0] = std::nan( "" );
+   doubles[517] = std::nan( "" );
+   floats[cCount - 1] = std::nanf( "" );
+
+   for ( size_t count = 0; count <= 9; ++count )
+   {
+      SCOPED_TRACE( count );
+
+      int64_t integerMinimum = std::numeric_limits<int64_t>::max();
+      int64_t integerMaximum = std::numeric_limits<int64_t>::lowest();
+
+      e57::BitPack::minMax( integers.data() + 1, count, integerMinimum, integerMaximum );
+
+      if ( count == 0 )
+      {
+         EXPECT_EQ( integerMinimum, std::numeric_limits<int64_t>::max() );
+         EXPECT_EQ( integerMaximum, std::numeric_limits<int64_t>::lowest() );
+      }
+      else
+      {
+         EXPECT_EQ( integerMinimum,
+                    *std::min_element( integers.begin() + 1, integers.begin() + 1 + count ) );
+         EXPECT_EQ( integerMaximum,
+                    *std::max_element( integers.begin() + 1, integers.begin() + 1 + count ) );
+      }
+   }
+
+   double minimum = std::numeric_limits<double>::max();
+   double maximum = std::numeric_limits<double>::lowest();
+   double minimumSoftware = minimum;
+   double maximumSoftware = maximum;
+
+   e57::BitPack::minMax( doubles.data(), cCount, minimum, maximum );
+   e57::BitPack::minMaxSoftware( doubles.data(), cCount, minimumSoftware, maximumSoftware );
+
+   EXPECT_EQ( minimum, minimumSoftware );
+   EXPECT_EQ( maximum, maximumSoftware );
+
+   double expectedMinimum = std::numeric_limits<double>::max();
+   double expectedMaximum = std::numeric_limits<double>::lowest();
+
+   for ( const double value : doubles )
+   {
+      if ( !std::isnan( value ) )
+      {
+         expectedMinimum = std::min( expectedMinimum, value );
+         expectedMaximum = std::max( expectedMaximum, value );
+      }
+   }
+
+   EXPECT_EQ( minimum, expectedMinimum );
+   EXPECT_EQ( maximum, expectedMaximum );
+
+   float floatMinimum = std::numeric_limits<float>::max();
+   float floatMaximum = std::numeric_limits<float>::lowest();
+
+   e57::BitPack::minMax( floats.data(), cCount, floatMinimum, floatMaximum );
+
+   EXPECT_EQ( floatMinimum, *std::min_element( floats.begin(), floats.end() - 1 ) );
+   EXPECT_EQ( floatMaximum, *std::max_element( floats.begin(), floats.end() - 1 ) );
+
+   // The values extend the range passed in
+   minimum = -1.0e300;
+   maximum = 1.0e300;
+
+   e57::BitPack::minMax( doubles.data(), cCount, minimum, maximum );
+
+   EXPECT_EQ( minimum, -1.0e300 );
+   EXPECT_EQ( maximum, 1.0e300 );
+}
+
+TEST( BitPack, PackMatchesUnpack )
+{
+   std::mt19937_64 generator( 1234 );
+
+   constexpr size_t cCount = 301;
+
+   for ( unsigned wordBytes = 1; wordBytes <= 8; wordBytes *= 2 )
+   {
+      for ( unsigned bits = 1; bits <= wordBytes * 8; ++bits )
+      {
+         const int64_t minimum = static_cast<int64_t>( generator() ) >> ( 64 - bits );
+
+         std::vector<int64_t> values( cCount );
+
+         for ( auto &value : values )
+         {
+            const uint64_t field = ( bits == 64 ) ? generator() : ( generator() >> ( 64 - bits ) );
+
+            value = static_cast<int64_t>( static_cast<uint64_t>( minimum ) + field );
+         }
+
+         // Pack in two calls, starting with some bits already in the state, as the encoder does
+         const size_t cSplit = 150;
+
+         const size_t firstBit = ( bits == 1 ) ? 0 : 3;
+
+         e57::BitPack::PackState state;
+         state.word = ( firstBit == 0 ) ? 0 : 0x5;
+         state.bitsUsed = static_cast<unsigned>( firstBit );
+
+         std::vector<char> packed( ( 3 + cCount * bits ) / 8 + 16 );
+         std::vector<char> packedSoftware( packed.size() );
+
+         e57::BitPack::PackState stateSoftware = state;
+
+         size_t words = e57::BitPack::pack( values.data(), cSplit, minimum, bits, wordBytes, state,
+                                            packed.data() );
+         words += e57::BitPack::pack( values.data() + cSplit, cCount - cSplit, minimum, bits,
+                                      wordBytes, state, packed.data() + words * wordBytes );
+
+         size_t wordsSoftware =
+            e57::BitPack::packSoftware( values.data(), cSplit, minimum, bits, wordBytes,
+                                        stateSoftware, packedSoftware.data() );
+         wordsSoftware += e57::BitPack::packSoftware(
+            values.data() + cSplit, cCount - cSplit, minimum, bits, wordBytes, stateSoftware,
+            packedSoftware.data() + wordsSoftware * wordBytes );
+
+         ASSERT_EQ( words, wordsSoftware );
+         ASSERT_EQ( state.word, stateSoftware.word );
+         ASSERT_EQ( state.bitsUsed, stateSoftware.bitsUsed );
+         ASSERT_LT( state.bitsUsed, wordBytes * 8 );
+
+         ASSERT_EQ( words * wordBytes * 8 + state.bitsUsed, firstBit + cCount * bits );
+
+         // Flush the remaining bits like the encoder does and read everything back
+         memcpy( packed.data() + words * wordBytes, &state.word, wordBytes );
+
+         std::vector<int64_t> unpacked( cCount );
+
+         e57::BitPack::unpackSoftware( packed.data(), ( words + 1 ) * wordBytes, firstBit, bits,
+                                       minimum, cCount, unpacked.data() );
+
+         for ( size_t i = 0; i < cCount; ++i )
+         {
+            ASSERT_EQ( unpacked[i], values[i] ) << "wordBytes=" << wordBytes << " bits=" << bits
+                                                << " i=" << i;
+         }
+
+         ASSERT_EQ( memcmp( packed.data(), packedSoftware.data(), words * wordBytes ), 0 );
+      }
+   }
+}
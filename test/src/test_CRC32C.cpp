@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "CRC32C.h"
+
+#include "RandomNum.h"
+
+TEST( CRC32C, CheckValue )
+{
+   // Standard check value for CRC-32C (iSCSI)
+   const char cInput[] = "123456789";
+
+   EXPECT_EQ( e57::CRC32C::calculate( cInput, 9 ), 0xE3069283u );
+   EXPECT_EQ( e57::CRC32C::calculateSoftware( cInput, 9 ), 0xE3069283u );
+}
+
+TEST( CRC32C, BlocksMatchSingle )
+{
+   // Use 1024-byte pages with 1020 bytes of data like CheckedFile, and a count which isn't a
+   // multiple of the number of interleaved streams.
+   constexpr size_t cStride = 1024;
+   constexpr size_t cSize = 1020;
+   constexpr size_t cCount = 7;
+
+   std::vector<char> buffer( cStride * cCount );
+
+   for ( auto &c : buffer )
+   {
+      c = static_cast<char>( Random::num() * 255.0f );
+   }
+
+   std::vector<uint32_t> results( cCount );
+
+   e57::CRC32C::calculateBlocks( buffer.data(), cCount, cStride, cSize, results.data() );
+
+   for ( size_t i = 0; i < cCount; ++i )
+   {
+      const char *block = buffer.data() + i * cStride;
+
+      EXPECT_EQ( results[i], e57::CRC32C::calculateSoftware( block, cSize ) );
+      EXPECT_EQ( results[i], e57::CRC32C::calculate( block, cSize ) );
+   }
+}
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "HalfFloat.h"
+
+#include "RandomNum.h"
+
+namespace
+{
+   uint32_t floatBits( float value )
+   {
+      uint32_t bits;
+      memcpy( &bits, &value, sizeof( bits ) );
+      return bits;
+   }
+}
+
+TEST( HalfFloat, KnownValues )
+{
+   using namespace e57::HalfFloat;
+
+   EXPECT_EQ( fromFloat( 0.0f ), 0x0000 );
+   EXPECT_EQ( fromFloat( -0.0f ), 0x8000 );
+   EXPECT_EQ( fromFloat( 1.0f ), 0x3C00 );
+   EXPECT_EQ( fromFloat( -2.0f ), 0xC000 );
+   EXPECT_EQ( fromFloat( 65504.0f ), 0x7BFF );
+
+   // Ties round to even, and from halfway past the largest half to infinity
+   EXPECT_EQ( fromFloat( 2049.0f ), 0x6800 );
+   EXPECT_EQ( fromFloat( 2051.0f ), 0x6802 );
+   EXPECT_EQ( fromFloat( 65519.0f ), 0x7BFF );
+   EXPECT_EQ( fromFloat( 65520.0f ), 0x7C00 );
+   EXPECT_EQ( fromFloat( -std::numeric_limits<float>::infinity() ), 0xFC00 );
+
+   // Smallest subnormal, and what rounds to it or to zero
+   EXPECT_EQ( fromFloat( 5.9604644775390625e-8f ), 0x0001 );
+   EXPECT_EQ( fromFloat( 4.0e-8f ), 0x0001 );
+   EXPECT_EQ( fromFloat( 2.9802322387695312e-8f ), 0x0000 );
+
+   EXPECT_EQ( ( fromFloat( std::numeric_limits<float>::quiet_NaN() ) & 0x7FFF ) > 0x7C00, true );
+
+   EXPECT_EQ( toFloat( 0x3C00 ), 1.0f );
+   EXPECT_EQ( toFloat( 0x7BFF ), 65504.0f );
+   EXPECT_EQ( toFloat( 0x0001 ), 5.9604644775390625e-8f );
+   EXPECT_EQ( toFloat( 0xFC00 ), -std::numeric_limits<float>::infinity() );
+   EXPECT_TRUE( std::isnan( toFloat( 0x7E00 ) ) );
+}
+
+TEST( HalfFloat, AllHalvesRoundTrip )
+{
+   using namespace e57::HalfFloat;
+
+   std::vector<uint16_t> halves( 65536 );
+
+   for ( size_t i = 0; i < halves.size(); ++i )
+   {
+      halves[i] = static_cast<uint16_t>( i );
+   }
+
+   std::vector<float> floats( halves.size() );
+   std::vector<float> floatsSoftware( halves.size() );
+
+   toFloats( halves.data(), halves.size(), floats.data() );
+   toFloatsSoftware( halves.data(), halves.size(), floatsSoftware.data() );
+
+   std::vector<uint16_t> back( halves.size() );
+   std::vector<uint16_t> backSoftware( halves.size() );
+
+   fromFloats( floats.data(), floats.size(), back.data() );
+   fromFloatsSoftware( floats.data(), floats.size(), backSoftware.data() );
+
+   for ( size_t i = 0; i < halves.size(); ++i )
+   {
+      ASSERT_EQ( floatBits( floats[i] ), floatBits( floatsSoftware[i] ) ) << "half=" << i;
+      ASSERT_EQ( floatBits( floats[i] ), floatBits( toFloat( halves[i] ) ) ) << "half=" << i;
+      ASSERT_EQ( back[i], backSoftware[i] ) << "half=" << i;
+
+      // Signalling NaNs are made quiet
+      const bool cNaN = ( ( halves[i] & 0x7C00 ) == 0x7C00 ) && ( ( halves[i] & 0x3FF ) != 0 );
+
+      ASSERT_EQ( back[i], cNaN ? ( halves[i] | 0x200 ) : halves[i] ) << "half=" << i;
+   }
+}
+
+TEST( HalfFloat, SimdMatchesSoftware )
+{
+   using namespace e57::HalfFloat;
+
+   // A count which isn't a multiple of the vector width, with values around the whole range of
+   // halves, including subnormals & values which overflow
+   constexpr size_t cCount = 100003;
+
+   std::vector<float> floats( cCount );
+
+   for ( auto &value : floats )
+   {
+      const float cExponent = Random::num() * 44.0f - 28.0f;
+
+      value = std::ldexp( Random::num() + 1.0f, static_cast<int>( cExponent ) );
+
+      if ( Random::num() < 0.5f )
+      {
+         value = -value;
+      }
+   }
+
+   std::vector<uint16_t> halves( cCount );
+   std::vector<uint16_t> halvesSoftware( cCount );
+
+   fromFloats( floats.data(), cCount, halves.data() );
+   fromFloatsSoftware( floats.data(), cCount, halvesSoftware.data() );
+
+   for ( size_t i = 0; i < cCount; ++i )
+   {
+      ASSERT_EQ( halves[i], halvesSoftware[i] ) << "value=" << floats[i];
+      ASSERT_EQ( halves[i], fromFloat( floats[i] ) ) << "value=" << floats[i];
+   }
+}
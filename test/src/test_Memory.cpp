@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <cstdint>
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+#include "Memory.h"
+#include "Packet.h"
+
+namespace
+{
+   bool isAligned( const void *pointer, size_t alignment )
+   {
+      return ( reinterpret_cast<uintptr_t>( pointer ) % alignment ) == 0;
+   }
+}
+
+TEST( AlignedMemory, AlignmentBySize )
+{
+   const size_t cSizes[] = { 0, 1, 63, 64, 100, 4095, 4096, 65536, 2 * 1024 * 1024 + 1 };
+
+   for ( const size_t cSize : cSizes )
+   {
+      void *pointer = e57::Memory::allocateAligned( cSize );
+
+      ASSERT_NE( pointer, nullptr );
+
+      EXPECT_TRUE( isAligned( pointer, e57::Memory::cCacheLineSize ) ) << "size " << cSize;
+
+      if ( cSize >= e57::Memory::cPageSize )
+      {
+         EXPECT_TRUE( isAligned( pointer, e57::Memory::cPageSize ) ) << "size " << cSize;
+      }
+
+      if ( cSize >= e57::Memory::cHugePageSize )
+      {
+         EXPECT_TRUE( isAligned( pointer, e57::Memory::cHugePageSize ) ) << "size " << cSize;
+      }
+
+      // The memory is usable to its end
+      std::memset( pointer, 0xA5, cSize );
+
+      e57::Memory::freeAligned( pointer );
+   }
+
+   e57::Memory::freeAligned( nullptr );
+}
+
+TEST( AlignedMemory, Containers )
+{
+   e57::Memory::AlignedVector<char> buffer( 3 * e57::DATA_PACKET_MAX );
+
+   EXPECT_TRUE( isAligned( buffer.data(), e57::Memory::cPageSize ) );
+
+   buffer.resize( 10 );
+   buffer.shrink_to_fit();
+
+   EXPECT_TRUE( isAligned( buffer.data(), e57::Memory::cCacheLineSize ) );
+
+   const auto cPacket = e57::Memory::makeAligned<e57::DataPacket>();
+
+   EXPECT_TRUE( isAligned( cPacket.get(), e57::Memory::cPageSize ) );
+   EXPECT_EQ( cPacket->header.packetType, e57::DATA_PACKET );
+}
@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "Parallel.h"
+
+TEST( Scheduler, RunsAllTasks )
+{
+   e57::Scheduler scheduler( 4 );
+
+   EXPECT_EQ( scheduler.threadCount(), 4u );
+
+   std::vector<int> done( 1000, 0 );
+   std::vector<e57::Task> tasks;
+
+   for ( size_t i = 0; i < done.size(); ++i )
+   {
+      tasks.emplace_back( [&done, i]() { ++done[i]; } );
+   }
+
+   scheduler.run( tasks );
+
+   for ( const int count : done )
+   {
+      EXPECT_EQ( count, 1 );
+   }
+}
+
+TEST( Scheduler, MaxThreads )
+{
+   e57::Scheduler scheduler( 4 );
+
+   std::mutex mutex;
+   std::set<std::thread::id> threads;
+   std::vector<e57::Task> tasks;
+
+   for ( int i = 0; i < 100; ++i )
+   {
+      tasks.emplace_back( [&]() {
+         std::lock_guard<std::mutex> lock( mutex );
+         threads.insert( std::this_thread::get_id() );
+      } );
+   }
+
+   scheduler.run( tasks, 1 );
+
+   ASSERT_EQ( threads.size(), 1u );
+   EXPECT_EQ( *threads.begin(), std::this_thread::get_id() );
+}
+
+TEST( Scheduler, NestedAndConcurrentBatches )
+{
+   e57::Scheduler scheduler( 3 );
+
+   std::atomic<int> count( 0 );
+
+   const auto cBatch = [&]() {
+      std::vector<e57::Task> outer;
+
+      for ( int i = 0; i < 8; ++i )
+      {
+         outer.emplace_back( [&]() {
+            std::vector<e57::Task> inner( 16, [&count]() { ++count; } );
+
+            scheduler.run( inner );
+         } );
+      }
+
+      scheduler.run( outer );
+   };
+
+   std::thread other( cBatch );
+
+   cBatch();
+   other.join();
+
+   EXPECT_EQ( count, 2 * 8 * 16 );
+}
+
+TEST( Scheduler, RethrowsFirstError )
+{
+   e57::Scheduler scheduler( 2 );
+
+   std::atomic<int> count( 0 );
+   std::vector<e57::Task> tasks;
+
+   for ( int i = 0; i < 10; ++i )
+   {
+      tasks.emplace_back( [&count, i]() {
+         ++count;
+
+         if ( ( i == 3 ) || ( i == 7 ) )
+         {
+            throw std::runtime_error( std::to_string( i ) );
+         }
+      } );
+   }
+
+   try
+   {
+      scheduler.run( tasks );
+      FAIL() << "Expected an exception";
+   }
+   catch ( const std::runtime_error &err )
+   {
+      EXPECT_STREQ( err.what(), "3" );
+   }
+
+   // The others still ran
+   EXPECT_EQ( count, 10 );
+}
+
+TEST( Scheduler, DefaultTaskExecutor )
+{
+   int executorCalls = 0;
+
+   e57::setDefaultTaskExecutor( [&executorCalls]( const std::vector<e57::Task> &tasks ) {
+      ++executorCalls;
+
+      for ( const auto &task : tasks )
+      {
+         task();
+      }
+   } );
+
+   std::atomic<int> count( 0 );
+   const std::vector<e57::Task> cTasks( 5, [&count]() { ++count; } );
+
+   e57::runTasks( cTasks, 4 );
+
+   e57::setDefaultTaskExecutor( {} );
+
+   e57::runTasks( cTasks, 4 );
+
+   EXPECT_EQ( executorCalls, 1 );
+   EXPECT_EQ( count, 10 );
+}
+
+TEST( BackgroundThreads, Post )
+{
+   e57::BackgroundThreads threads( 2 );
+
+   std::mutex mutex;
+   std::condition_variable condition;
+   int count = 0;
+
+   for ( int i = 0; i < 10; ++i )
+   {
+      threads.post( [&]() {
+         {
+            std::lock_guard<std::mutex> lock( mutex );
+            ++count;
+         }
+
+         condition.notify_one();
+      } );
+   }
+
+   // A posted task which throws doesn't stop the others
+   threads.post( []() { throw std::runtime_error( "dropped" ); } );
+
+   std::unique_lock<std::mutex> lock( mutex );
+   condition.wait( lock, [&count]() { return count == 10; } );
+}
+
+TEST( BackgroundThreads, NeverInline )
+{
+   // Even with a single thread the task runs on it, after post() has returned
+   e57::BackgroundThreads threads( 1 );
+
+   std::promise<void> returned;
+   std::shared_future<void> returnedFuture = returned.get_future().share();
+
+   std::promise<std::thread::id> ran;
+   std::future<std::thread::id> ranFuture = ran.get_future();
+   bool ranAfterReturn = false;
+
+   threads.post( [&]() {
+      // Time out rather than hang if the task were run inline
+      ranAfterReturn =
+         returnedFuture.wait_for( std::chrono::seconds( 10 ) ) == std::future_status::ready;
+      ran.set_value( std::this_thread::get_id() );
+   } );
+
+   returned.set_value();
+
+   const std::thread::id taskThread = ranFuture.get();
+
+   EXPECT_TRUE( ranAfterReturn );
+   EXPECT_NE( taskThread, std::this_thread::get_id() );
+}
+
+TEST( BackgroundThreads, AsyncCompletion )
+{
+   // Completions of the async operations run on a background thread, not the caller's
+   std::promise<void> returned;
+   std::shared_future<void> returnedFuture = returned.get_future().share();
+
+   std::promise<std::thread::id> completed;
+   std::future<std::thread::id> completedFuture = completed.get_future();
+   bool completedAfterReturn = false;
+
+   e57::runAsync( []() {},
+                  [&]( std::exception_ptr error ) {
+                     EXPECT_FALSE( error );
+                     completedAfterReturn = returnedFuture.wait_for( std::chrono::seconds( 10 ) ) ==
+                                            std::future_status::ready;
+                     completed.set_value( std::this_thread::get_id() );
+                  } );
+
+   returned.set_value();
+
+   const std::thread::id completionThread = completedFuture.get();
+
+   EXPECT_TRUE( completedAfterReturn );
+   EXPECT_NE( completionThread, std::this_thread::get_id() );
+}
+
+namespace
+{
+   /// Takes a while to be destroyed, so a result seen before it is gone shows up
+   struct SlowToDestroy
+   {
+      explicit SlowToDestroy( std::atomic<bool> &destroyed ) : destroyed_( destroyed )
+      {
+      }
+
+      ~SlowToDestroy()
+      {
+         std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+         destroyed_ = true;
+      }
+
+      std::atomic<bool> &destroyed_;
+   };
+}
+
+TEST( BackgroundThreads, AsyncReleasesFunction )
+{
+   // What the function captured is gone by the time the future is ready
+   std::atomic<bool> destroyed{ false };
+
+   {
+      auto held = std::make_shared<SlowToDestroy>( destroyed );
+      std::weak_ptr<SlowToDestroy> weak( held );
+
+      std::future<int> future = e57::runAsync( [held = std::move( held )]() { return 42; } );
+
+      EXPECT_EQ( future.get(), 42 );
+      EXPECT_TRUE( destroyed );
+      EXPECT_EQ( weak.use_count(), 0 );
+   }
+
+   // ...and by the time the completion is called
+   destroyed = false;
+
+   {
+      auto held = std::make_shared<SlowToDestroy>( destroyed );
+
+      std::promise<bool> completed;
+      std::future<bool> completedFuture = completed.get_future();
+
+      e57::runAsync( [held = std::move( held )]() {},
+                     [&]( std::exception_ptr ) { completed.set_value( destroyed ); } );
+
+      EXPECT_TRUE( completedFuture.get() );
+   }
+}
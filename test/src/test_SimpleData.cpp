@@ -1,6 +1,8 @@
 // libE57Format testing Copyright © 2022 Andy Maloney <asmaloney@gmail.com>
 // SPDX-License-Identifier: BSL-1.0
 
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "E57SimpleData.h"
@@ -93,6 +95,128 @@ TEST( SimpleDataHeader, HeaderMinMaxDouble )
    EXPECT_EQ( dataHeader.pointFields.timeMaximum, e57::DOUBLE_MAX );
 }
 
+namespace
+{
+   // Counts the blocks handed out
+   class CountingAllocator : public e57::Data3DPointsAllocator
+   {
+   public:
+      void *allocate( size_t size, size_t alignment ) override
+      {
+         ++allocations;
+         lastSize = size;
+
+         storage.emplace_back( size + alignment );
+
+         const auto address = reinterpret_cast<uintptr_t>( storage.back().data() );
+         return storage.back().data() + ( alignment - address % alignment ) % alignment;
+      }
+
+      void deallocate( void *, size_t size ) override
+      {
+         ++deallocations;
+         EXPECT_EQ( size, lastSize );
+      }
+
+      int allocations = 0;
+      int deallocations = 0;
+      size_t lastSize = 0;
+
+      std::vector<std::vector<char>> storage;
+   };
+
+   e57::Data3D arenaHeader()
+   {
+      e57::Data3D dataHeader;
+
+      dataHeader.pointCount = 1001;
+      dataHeader.pointFields.cartesianXField = true;
+      dataHeader.pointFields.cartesianYField = true;
+      dataHeader.pointFields.cartesianZField = true;
+      dataHeader.pointFields.cartesianInvalidStateField = true;
+      dataHeader.pointFields.colorRedField = true;
+      dataHeader.pointFields.intensityField = true;
+
+      return dataHeader;
+   }
+
+   // The buffers of the fields in use must be aligned, not overlap, and hold pointCount values
+   template <typename T> void checkBuffers( const e57::Data3DPointsData_t<T> &pointsData )
+   {
+      EXPECT_EQ( reinterpret_cast<uintptr_t>( pointsData.cartesianX ) % 64, 0u );
+      EXPECT_EQ( reinterpret_cast<uintptr_t>( pointsData.colorRed ) % 64, 0u );
+
+      EXPECT_GE( reinterpret_cast<const char *>( pointsData.cartesianY ),
+                 reinterpret_cast<const char *>( pointsData.cartesianX + 1001 ) );
+      EXPECT_GE( reinterpret_cast<const char *>( pointsData.colorRed ),
+                 reinterpret_cast<const char *>( pointsData.cartesianInvalidState + 1001 ) );
+
+      EXPECT_EQ( pointsData.sphericalRange, nullptr );
+      EXPECT_EQ( pointsData.normalX, nullptr );
+
+      // Fill them all so sanitizers catch any overruns
+      for ( size_t i = 0; i < 1001; ++i )
+      {
+         pointsData.cartesianX[i] = pointsData.cartesianY[i] = pointsData.cartesianZ[i] = T( 1 );
+         pointsData.cartesianInvalidState[i] = 0;
+         pointsData.colorRed[i] = 255;
+         pointsData.intensity[i] = 0.5;
+      }
+   }
+}
+
+TEST( SimpleDataHeader, OneBlockBuffers )
+{
+   e57::Data3D dataHeader = arenaHeader();
+
+   e57::Data3DPointsDouble pointsData( dataHeader );
+
+   checkBuffers( pointsData );
+}
+
+TEST( SimpleDataHeader, AllocatorBuffers )
+{
+   CountingAllocator allocator;
+
+   {
+      e57::Data3D dataHeader = arenaHeader();
+
+      e57::Data3DPointsFloat pointsData( dataHeader, allocator );
+
+      EXPECT_EQ( allocator.allocations, 1 );
+      EXPECT_EQ( dataHeader.pointFields.pointRangeMaximum, e57::FLOAT_MAX );
+
+      checkBuffers( pointsData );
+   }
+
+   EXPECT_EQ( allocator.deallocations, 1 );
+}
+
+TEST( SimpleDataHeader, ArenaBuffers )
+{
+   e57::Data3D dataHeader = arenaHeader();
+
+   const size_t cSize = e57::Data3DPointsDouble::arenaSize( dataHeader );
+
+   // 4 doubles & a byte per point, plus alignment
+   EXPECT_GE( cSize, 1001u * ( 4 * sizeof( double ) + sizeof( uint16_t ) + 1 ) );
+
+   // Reuse the same (deliberately misaligned) arena for several scans
+   std::vector<char> arena( cSize + 1 );
+
+   for ( int scan = 0; scan < 3; ++scan )
+   {
+      e57::Data3DPointsDouble pointsData( dataHeader, arena.data() + 1, cSize );
+
+      EXPECT_GE( reinterpret_cast<char *>( pointsData.cartesianX ), arena.data() + 1 );
+
+      checkBuffers( pointsData );
+   }
+
+   E57_ASSERT_THROW( e57::Data3DPointsDouble( dataHeader, arena.data(), cSize - 1 ) );
+   E57_ASSERT_THROW( e57::Data3DPointsDouble( dataHeader, nullptr, cSize ) );
+}
+
 // Checks that the Data3D header and the the cartesianX FloatNode data are the same when read,
 // written, and read again. https://github.com/asmaloney/libE57Format/issues/126
 TEST( SimpleData, ReadWrite )
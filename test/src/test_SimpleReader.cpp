@@ -1,29 +1,4522 @@
 // libE57Format testing Copyright © 2022 Andy Maloney <asmaloney@gmail.com>
 // SPDX-License-Identifier: BSL-1.0
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
 #include "gtest/gtest.h"
 
-#include "E57SimpleReader.h"
+#include "E57Memory.h"
+#include "E57SimpleReader.h"
+#include "E57SimpleWriter.h"
+#include "E57Tracing.h"
+
+#include "Helpers.h"
+#include "TestData.h"
+
+namespace
+{
+   void CheckFileHeader( const e57::E57Root &fileHeader )
+   {
+      // These are invariant.
+      // See ASTM Standard Table 12.
+
+      EXPECT_EQ( fileHeader.formatName, "ASTM E57 3D Imaging Data File" );
+      EXPECT_EQ( fileHeader.versionMajor, 1 );
+      EXPECT_EQ( fileHeader.versionMinor, 0 );
+   }
+}
+
+TEST( SimpleReader, PathError )
+{
+   E57_ASSERT_THROW( e57::Reader( "./no-path/empty.e57", {} ) );
+}
+
+TEST( SimpleReader, MemoryMapped )
+{
+   constexpr int64_t cNumPoints = 1025;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Memory Mapped File GUID";
+
+      e57::Writer writer( "./MemoryMapped.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Memory Mapped Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         auto floati = static_cast<float>( i );
+         pointsData.cartesianX[i] = floati;
+         pointsData.cartesianY[i] = floati * 2.0f;
+         pointsData.cartesianZ[i] = floati * 3.0f;
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::ReaderOptions options;
+   options.readBackend = e57::ReadBackendMemoryMapped;
+
+   e57::Reader *reader = nullptr;
+
+   E57_ASSERT_NO_THROW( reader = new e57::Reader( "./MemoryMapped.e57", options ) );
+
+   ASSERT_TRUE( reader->IsOpen() );
+   ASSERT_EQ( reader->GetData3DCount(), 1 );
+
+   e57::E57Root fileHeader;
+   ASSERT_TRUE( reader->GetE57Root( fileHeader ) );
+
+   CheckFileHeader( fileHeader );
+   EXPECT_EQ( fileHeader.guid, "Memory Mapped File GUID" );
+
+   e57::Data3D data3DHeader;
+   ASSERT_TRUE( reader->ReadData3D( 0, data3DHeader ) );
+
+   ASSERT_EQ( data3DHeader.pointCount, cNumPoints );
+
+   e57::Data3DPointsFloat pointsData( data3DHeader );
+
+   auto vectorReader = reader->SetUpData3DPointsData( 0, cNumPoints, pointsData );
+
+   const uint64_t cNumRead = vectorReader.read();
+
+   vectorReader.close();
+
+   ASSERT_EQ( cNumRead, cNumPoints );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      auto floati = static_cast<float>( i );
+      EXPECT_EQ( pointsData.cartesianX[i], floati );
+      EXPECT_EQ( pointsData.cartesianY[i], floati * 2.0f );
+      EXPECT_EQ( pointsData.cartesianZ[i], floati * 3.0f );
+   }
+
+   delete reader;
+}
+
+TEST( SimpleReader, ReadData3DParallel )
+{
+   constexpr int cNumScans = 5;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Parallel Read File GUID";
+
+      e57::Writer writer( "./ParallelRead.e57", options );
+
+      for ( int scan = 0; scan < cNumScans; ++scan )
+      {
+         e57::Data3D header;
+         header.guid = "Parallel Read Scan Header GUID " + std::to_string( scan );
+         header.pointCount = 1000 * ( scan + 1 );
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+
+         e57::Data3DPointsDouble pointsData( header );
+
+         for ( int64_t i = 0; i < header.pointCount; ++i )
+         {
+            pointsData.cartesianX[i] = static_cast<double>( i );
+            pointsData.cartesianY[i] = static_cast<double>( scan );
+            pointsData.cartesianZ[i] = static_cast<double>( -i );
+         }
+
+         E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+      }
+   }
+
+   e57::Reader reader( "./ParallelRead.e57", {} );
+
+   ASSERT_EQ( reader.GetData3DCount(), cNumScans );
+
+   std::vector<int64_t> indices;
+   std::vector<e57::Data3D> headers( cNumScans );
+   std::vector<std::unique_ptr<e57::Data3DPointsDouble>> points;
+   std::vector<e57::Data3DPointsDouble *> buffers;
+
+   for ( int scan = 0; scan < cNumScans; ++scan )
+   {
+      ASSERT_TRUE( reader.ReadData3D( scan, headers[scan] ) );
+
+      indices.push_back( scan );
+      points.emplace_back( new e57::Data3DPointsDouble( headers[scan] ) );
+      buffers.push_back( points.back().get() );
+   }
+
+   auto checkPoints = [&]( const std::vector<uint64_t> &counts ) {
+      ASSERT_EQ( counts.size(), static_cast<size_t>( cNumScans ) );
+
+      for ( int scan = 0; scan < cNumScans; ++scan )
+      {
+         ASSERT_EQ( counts[scan], static_cast<uint64_t>( headers[scan].pointCount ) );
+
+         for ( int64_t i = 0; i < headers[scan].pointCount; ++i )
+         {
+            ASSERT_EQ( buffers[scan]->cartesianX[i], static_cast<double>( i ) );
+            ASSERT_EQ( buffers[scan]->cartesianY[i], static_cast<double>( scan ) );
+            ASSERT_EQ( buffers[scan]->cartesianZ[i], static_cast<double>( -i ) );
+         }
+      }
+   };
+
+   e57::ParallelReadOptions options;
+   options.threadCount = 3;
+
+   std::vector<uint64_t> counts;
+
+   E57_ASSERT_NO_THROW( counts = reader.ReadData3DPointsDataParallel( indices, buffers, options ) );
+   checkPoints( counts );
+
+   // Use a caller-supplied executor
+   size_t tasksRun = 0;
+
+   options.executor = [&tasksRun]( const std::vector<std::function<void()>> &tasks ) {
+      for ( const auto &task : tasks )
+      {
+         task();
+         ++tasksRun;
+      }
+   };
+
+   E57_ASSERT_NO_THROW( counts = reader.ReadData3DPointsDataParallel( indices, buffers, options ) );
+   checkPoints( counts );
+   EXPECT_EQ( tasksRun, static_cast<size_t>( cNumScans ) );
+
+   // Invalid index
+   E57_ASSERT_THROW( reader.ReadData3DPointsDataParallel( { cNumScans }, { buffers[0] } ) );
+}
+
+TEST( SimpleReader, ReadData3DParallelChunks )
+{
+   // Large enough that the writer splits the scan into several indexed chunks
+   constexpr int64_t cNumPoints = 250000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Parallel Chunk Read File GUID";
+
+      e57::Writer writer( "./ParallelReadChunks.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Parallel Chunk Read Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.intensityField = true;
+      header.pointFields.colorRedField = true;
+
+      header.intensityLimits.intensityMinimum = 0.0;
+      header.intensityLimits.intensityMaximum = 1.0;
+      header.colorLimits.colorRedMaximum = 255;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( i ) * 0.5;
+         pointsData.cartesianZ[i] = static_cast<double>( -i );
+         pointsData.intensity[i] = static_cast<double>( i % 2 );
+         pointsData.colorRed[i] = static_cast<uint16_t>( i % 256 );
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::Reader reader( "./ParallelReadChunks.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+   ASSERT_EQ( header.pointCount, cNumPoints );
+
+   e57::Data3DPointsDouble points( header );
+
+   auto checkPoints = [&]( const e57::Data3DPointsDouble &data, uint64_t count ) {
+      ASSERT_EQ( count, static_cast<uint64_t>( cNumPoints ) );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_EQ( data.cartesianX[i], static_cast<double>( i ) );
+         ASSERT_EQ( data.cartesianY[i], static_cast<double>( i ) * 0.5 );
+         ASSERT_EQ( data.cartesianZ[i], static_cast<double>( -i ) );
+         ASSERT_EQ( data.intensity[i], static_cast<double>( i % 2 ) );
+         ASSERT_EQ( data.colorRed[i], static_cast<uint16_t>( i % 256 ) );
+      }
+   };
+
+   e57::ParallelReadOptions options;
+   options.threadCount = 4;
+
+   std::vector<uint64_t> counts;
+
+   E57_ASSERT_NO_THROW( counts = reader.ReadData3DPointsDataParallel( { 0 }, { &points },
+                                                                     options ) );
+   ASSERT_EQ( counts.size(), 1u );
+   checkPoints( points, counts[0] );
+
+   // The scan should be split into one task per thread
+   size_t tasksRun = 0;
+
+   options.executor = [&tasksRun]( const std::vector<std::function<void()>> &tasks ) {
+      for ( const auto &task : tasks )
+      {
+         task();
+         ++tasksRun;
+      }
+   };
+
+   e57::Data3DPointsDouble pointsSerial( header );
+
+   E57_ASSERT_NO_THROW( counts = reader.ReadData3DPointsDataParallel( { 0 }, { &pointsSerial },
+                                                                     options ) );
+   checkPoints( pointsSerial, counts[0] );
+   EXPECT_EQ( tasksRun, 4u );
+
+   // The chunked file must still read sequentially
+   e57::Data3DPointsDouble sequential( header );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, sequential );
+
+   uint64_t total = 0;
+   unsigned read = 0;
+
+   while ( ( read = vectorReader.read() ) > 0 )
+   {
+      total += read;
+   }
+
+   vectorReader.close();
+
+   ASSERT_EQ( total, static_cast<uint64_t>( cNumPoints ) );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_EQ( sequential.cartesianX[i], points.cartesianX[i] );
+      ASSERT_EQ( sequential.colorRed[i], points.colorRed[i] );
+   }
+}
+
+TEST( SimpleReader, Seek )
+{
+   // Large enough that the writer splits the scan into several indexed chunks
+   constexpr int64_t cNumPoints = 200000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Seek File GUID";
+
+      e57::Writer writer( "./Seek.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Seek Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.colorRedField = true;
+
+      header.colorLimits.colorRedMaximum = 255;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( i ) * 0.25;
+         pointsData.cartesianZ[i] = static_cast<double>( -i );
+         pointsData.colorRed[i] = static_cast<uint16_t>( i % 256 );
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::Reader reader( "./Seek.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   constexpr size_t cBufferSize = 1000;
+
+   e57::Data3DPointsDouble points( header );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cBufferSize, points );
+
+   auto checkReadFrom = [&]( int64_t recordNumber ) {
+      E57_ASSERT_NO_THROW( vectorReader.seek( recordNumber ) );
+
+      const auto cExpected =
+         static_cast<unsigned>( std::min<int64_t>( cBufferSize, cNumPoints - recordNumber ) );
+
+      ASSERT_EQ( vectorReader.read(), cExpected );
+
+      for ( unsigned i = 0; i < cExpected; ++i )
+      {
+         const int64_t cRecord = recordNumber + i;
+
+         ASSERT_EQ( points.cartesianX[i], static_cast<double>( cRecord ) );
+         ASSERT_EQ( points.cartesianY[i], static_cast<double>( cRecord ) * 0.25 );
+         ASSERT_EQ( points.cartesianZ[i], static_cast<double>( -cRecord ) );
+         ASSERT_EQ( points.colorRed[i], static_cast<uint16_t>( cRecord % 256 ) );
+      }
+   };
+
+   checkReadFrom( 150001 ); // forward into a later chunk
+   checkReadFrom( 151500 ); // forward within the same chunk
+   checkReadFrom( 77 );     // backward
+   checkReadFrom( 0 );
+   checkReadFrom( cNumPoints - 10 );
+
+   // Seeking to the end is allowed, and there is nothing more to read
+   E57_ASSERT_NO_THROW( vectorReader.seek( cNumPoints ) );
+   EXPECT_EQ( vectorReader.read(), 0u );
+
+   checkReadFrom( 99999 );
+
+   E57_ASSERT_THROW( vectorReader.seek( cNumPoints + 1 ) );
+
+   vectorReader.close();
+}
+
+TEST( SimpleReader, ReadData3DGroups )
+{
+   constexpr int64_t cRows = 4;
+   constexpr int64_t cColumns = 500;
+
+   e57::Data3D header;
+   header.guid = "Read Groups Scan Header GUID";
+   header.pointCount = cRows * cColumns;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointGroupingSchemes.groupingByLine.idElementName = "columnIndex";
+   header.pointGroupingSchemes.groupingByLine.groupsSize = cColumns;
+   header.pointGroupingSchemes.groupingByLine.pointCountSize = cRows;
+
+   std::vector<int64_t> idElementValue( cColumns );
+   std::vector<int64_t> startPointIndex( cColumns );
+   std::vector<int64_t> pointCount( cColumns, cRows );
+
+   for ( int64_t column = 0; column < cColumns; ++column )
+   {
+      idElementValue[column] = cColumns - 1 - column;
+      startPointIndex[column] = column * cRows;
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Read Groups File GUID";
+
+      e57::Writer writer( "./ReadData3DGroups.e57", options );
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      const int64_t cDataIndex = writer.WriteData3DData( header, pointsData );
+
+      ASSERT_TRUE( writer.WriteData3DGroupsData( cDataIndex, idElementValue.size(),
+                                                 idElementValue.data(), startPointIndex.data(),
+                                                 pointCount.data() ) );
+
+      e57::Data3D ungroupedHeader;
+      ungroupedHeader.guid = "Read Groups Ungrouped Scan Header GUID";
+      ungroupedHeader.pointCount = 1;
+      ungroupedHeader.pointFields.cartesianXField = true;
+      ungroupedHeader.pointFields.cartesianYField = true;
+      ungroupedHeader.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsFloat ungroupedData( ungroupedHeader );
+
+      writer.WriteData3DData( ungroupedHeader, ungroupedData );
+   }
+
+   e57::Reader reader( "./ReadData3DGroups.e57", {} );
+
+   // Every thread gets the same table, decoded once
+   std::vector<const e57::LineGroupTable *> tables( 4 );
+   std::vector<std::thread> threads;
+
+   for ( auto &table : tables )
+   {
+      threads.emplace_back( [&reader, &table]() { table = reader.ReadData3DGroups( 0 ); } );
+   }
+
+   for ( auto &thread : threads )
+   {
+      thread.join();
+   }
+
+   const e57::LineGroupTable *groups = tables[0];
+
+   ASSERT_NE( groups, nullptr );
+
+   for ( const auto *table : tables )
+   {
+      EXPECT_EQ( table, groups );
+   }
+
+   EXPECT_EQ( groups->idElementValue, idElementValue );
+   EXPECT_EQ( groups->startPointIndex, startPointIndex );
+   EXPECT_EQ( groups->pointCount, pointCount );
+
+   // The buffer API copies from the same table, up to the size given
+   std::vector<int64_t> readStartPointIndex( 10, -1 );
+   std::vector<int64_t> readPointCount( cColumns + 5, -1 );
+
+   ASSERT_TRUE( reader.ReadData3DGroupsData( 0, readStartPointIndex.size(), nullptr,
+                                             readStartPointIndex.data(), nullptr ) );
+   ASSERT_TRUE( reader.ReadData3DGroupsData( 0, readPointCount.size(), nullptr, nullptr,
+                                             readPointCount.data() ) );
+
+   EXPECT_TRUE( std::equal( readStartPointIndex.begin(), readStartPointIndex.end(),
+                            startPointIndex.begin() ) );
+   EXPECT_TRUE( std::equal( pointCount.begin(), pointCount.end(), readPointCount.begin() ) );
+   EXPECT_EQ( readPointCount.back(), -1 );
+
+   EXPECT_EQ( reader.ReadData3DGroups( 1 ), nullptr );
+   EXPECT_EQ( reader.ReadData3DGroups( 2 ), nullptr );
+   EXPECT_FALSE( reader.ReadData3DGroupsData( 1, 1, nullptr, readStartPointIndex.data(),
+                                              nullptr ) );
+}
+
+TEST( SimpleReader, ReadData3DLines )
+{
+   // A grid of columns with rows 10-39, some of them partial or in reverse order, & one empty
+   constexpr int64_t cColumns = 40;
+   constexpr int64_t cRowMinimum = 10;
+   constexpr int64_t cRows = 30;
+
+   const auto cHasPoint = []( int64_t column, int64_t row ) {
+      return ( column != 20 ) && ( ( column % 5 != 3 ) || ( row % 3 != 0 ) );
+   };
+
+   const auto cValue = []( int64_t column, int64_t row ) {
+      return static_cast<double>( column * 1000 + row );
+   };
+
+   std::vector<int64_t> columnIndices;
+   std::vector<int64_t> rowIndices;
+   std::vector<int64_t> startPointIndex;
+   std::vector<int64_t> pointCount;
+   std::vector<int64_t> idElementValue;
+
+   for ( int64_t column = 0; column < cColumns; ++column )
+   {
+      idElementValue.push_back( column );
+      startPointIndex.push_back( static_cast<int64_t>( columnIndices.size() ) );
+
+      for ( int64_t i = 0; i < cRows; ++i )
+      {
+         const int64_t row = ( column == 7 ) ? cRowMinimum + cRows - 1 - i : cRowMinimum + i;
+
+         if ( cHasPoint( column, row ) )
+         {
+            columnIndices.push_back( column );
+            rowIndices.push_back( row );
+         }
+      }
+
+      pointCount.push_back( static_cast<int64_t>( columnIndices.size() ) -
+                            startPointIndex.back() );
+   }
+
+   // The empty column's group can't start past the last point
+   startPointIndex[20] = startPointIndex[19];
+
+   const auto cNumPoints = static_cast<int64_t>( columnIndices.size() );
+
+   e57::Data3D header;
+   header.guid = "Read Lines Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.rowIndexField = true;
+   header.pointFields.rowIndexMaximum = cRowMinimum + cRows - 1;
+   header.pointFields.columnIndexField = true;
+   header.pointFields.columnIndexMaximum = cColumns - 1;
+   header.indexBounds.rowMinimum = cRowMinimum;
+   header.indexBounds.rowMaximum = cRowMinimum + cRows - 1;
+   header.indexBounds.columnMinimum = 0;
+   header.indexBounds.columnMaximum = cColumns - 1;
+   header.pointGroupingSchemes.groupingByLine.idElementName = "columnIndex";
+   header.pointGroupingSchemes.groupingByLine.groupsSize = cColumns;
+   header.pointGroupingSchemes.groupingByLine.pointCountSize = cRows;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Read Lines File GUID";
+
+      e57::Writer writer( "./ReadData3DLines.e57", options );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( columnIndices[i] );
+         pointsData.cartesianY[i] = static_cast<double>( rowIndices[i] );
+         pointsData.cartesianZ[i] = cValue( columnIndices[i], rowIndices[i] );
+         pointsData.rowIndex[i] = static_cast<int32_t>( rowIndices[i] );
+         pointsData.columnIndex[i] = static_cast<int32_t>( columnIndices[i] );
+      }
+
+      const int64_t cDataIndex = writer.WriteData3DData( header, pointsData );
+
+      ASSERT_TRUE( writer.WriteData3DGroupsData( cDataIndex, idElementValue.size(),
+                                                 idElementValue.data(), startPointIndex.data(),
+                                                 pointCount.data() ) );
+
+      // A scan without any lines
+      e57::Data3D ungroupedHeader;
+      ungroupedHeader.guid = "Read Lines Ungrouped Scan Header GUID";
+      ungroupedHeader.pointCount = 1;
+      ungroupedHeader.pointFields.cartesianXField = true;
+      ungroupedHeader.pointFields.cartesianYField = true;
+      ungroupedHeader.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsDouble ungroupedData( ungroupedHeader );
+
+      writer.WriteData3DData( ungroupedHeader, ungroupedData );
+   }
+
+   e57::Reader reader( "./ReadData3DLines.e57", {} );
+
+   // Read columns 5-14 (including the reversed & partial ones) into an image with all the fields
+   constexpr int64_t cFirstLine = 5;
+   constexpr int64_t cLineCount = 10;
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+   readHeader.pointCount = cLineCount * cRows;
+
+   e57::Data3DPointsDouble image( readHeader );
+
+   std::fill( image.cartesianZ, image.cartesianZ + readHeader.pointCount, -1.0 );
+
+   int64_t expectedCount = 0;
+
+   for ( int64_t column = cFirstLine; column < cFirstLine + cLineCount; ++column )
+   {
+      for ( int64_t row = cRowMinimum; row < cRowMinimum + cRows; ++row )
+      {
+         expectedCount += cHasPoint( column, row ) ? 1 : 0;
+      }
+   }
+
+   EXPECT_EQ( reader.ReadData3DLines( 0, cFirstLine, cLineCount, image ), expectedCount );
+
+   for ( int64_t line = 0; line < cLineCount; ++line )
+   {
+      for ( int64_t position = 0; position < cRows; ++position )
+      {
+         const int64_t column = cFirstLine + line;
+         const int64_t row = cRowMinimum + position;
+         const auto cCell = static_cast<size_t>( line * cRows + position );
+
+         if ( cHasPoint( column, row ) )
+         {
+            ASSERT_EQ( image.cartesianZ[cCell], cValue( column, row ) ) << column << " " << row;
+            ASSERT_EQ( image.rowIndex[cCell], row );
+            ASSERT_EQ( image.columnIndex[cCell], column );
+         }
+         else
+         {
+            ASSERT_EQ( image.cartesianZ[cCell], -1.0 ) << column << " " << row;
+         }
+      }
+   }
+
+   // Read all the columns into a float image without the index fields, starting past the empty
+   // one and going past the last column
+   std::vector<float> z( static_cast<size_t>( 20 * cRows ), -1.0f );
+
+   e57::Data3DPointsFloat zImage;
+   zImage.cartesianZ = z.data();
+
+   int64_t remainingCount = 0;
+
+   for ( int64_t column = 21; column < cColumns; ++column )
+   {
+      for ( int64_t row = cRowMinimum; row < cRowMinimum + cRows; ++row )
+      {
+         remainingCount += cHasPoint( column, row ) ? 1 : 0;
+      }
+   }
+
+   EXPECT_EQ( reader.ReadData3DLines( 0, 21, 20, zImage ), remainingCount );
+
+   EXPECT_EQ( z[0], static_cast<float>( cValue( 21, cRowMinimum ) ) );
+   EXPECT_EQ( z[static_cast<size_t>( 2 * cRows + 2 )], -1.0f ); // column 23, row 12
+   EXPECT_EQ( z[static_cast<size_t>( 19 * cRows )], -1.0f );    // past the last column
+
+   EXPECT_EQ( reader.ReadData3DLines( 0, 0, 0, zImage ), 0 );
+
+   try
+   {
+      reader.ReadData3DLines( 1, 0, 1, zImage );
+      FAIL() << "Expected ErrorBadAPIArgument";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorBadAPIArgument );
+   }
+}
+
+TEST( SimpleReader, ReadData3DLinesValidPointsOnly )
+{
+   // A full grid of columns, with a point of every few having no return
+   constexpr int64_t cColumns = 200;
+   constexpr int64_t cRows = 500;
+   constexpr int64_t cNumPoints = cColumns * cRows;
+
+   const auto cIsValid = []( int64_t column, int64_t row ) { return ( column + row ) % 4 != 0; };
+
+   e57::Data3D header;
+   header.guid = "Read Lines Valid Points Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.cartesianInvalidStateField = true;
+   header.pointFields.rowIndexField = true;
+   header.pointFields.rowIndexMaximum = cRows - 1;
+   header.pointFields.columnIndexField = true;
+   header.pointFields.columnIndexMaximum = cColumns - 1;
+   header.indexBounds.rowMaximum = cRows - 1;
+   header.indexBounds.columnMaximum = cColumns - 1;
+   header.pointGroupingSchemes.groupingByLine.idElementName = "columnIndex";
+   header.pointGroupingSchemes.groupingByLine.groupsSize = cColumns;
+   header.pointGroupingSchemes.groupingByLine.pointCountSize = cRows;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Read Lines Valid Points File GUID";
+
+      e57::Writer writer( "./ReadData3DLinesValidPointsOnly.e57", options );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      std::vector<int64_t> idElementValue;
+      std::vector<int64_t> startPointIndex;
+      std::vector<int64_t> pointCount;
+
+      for ( int64_t column = 0; column < cColumns; ++column )
+      {
+         idElementValue.push_back( column );
+         startPointIndex.push_back( column * cRows );
+         pointCount.push_back( cRows );
+
+         for ( int64_t row = 0; row < cRows; ++row )
+         {
+            const int64_t i = column * cRows + row;
+
+            pointsData.cartesianX[i] = static_cast<double>( column );
+            pointsData.cartesianY[i] = static_cast<double>( row );
+            pointsData.cartesianZ[i] = static_cast<double>( i );
+            pointsData.cartesianInvalidState[i] = cIsValid( column, row ) ? 0 : 2;
+            pointsData.rowIndex[i] = static_cast<int32_t>( row );
+            pointsData.columnIndex[i] = static_cast<int32_t>( column );
+         }
+      }
+
+      const int64_t cDataIndex = writer.WriteData3DData( header, pointsData );
+
+      ASSERT_TRUE( writer.WriteData3DGroupsData( cDataIndex, idElementValue.size(),
+                                                 idElementValue.data(), startPointIndex.data(),
+                                                 pointCount.data() ) );
+   }
+
+   e57::ReaderOptions options;
+   options.validPointsOnly = true;
+
+   e57::Reader reader( "./ReadData3DLinesValidPointsOnly.e57", options );
+
+   // Lines far into the scan, so reaching them skips many records
+   constexpr int64_t cFirstLine = 150;
+   constexpr int64_t cLineCount = 20;
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+   readHeader.pointCount = cLineCount * cRows;
+
+   e57::Data3DPointsDouble image( readHeader );
+
+   std::fill( image.cartesianZ, image.cartesianZ + readHeader.pointCount, -1.0 );
+
+   int64_t expectedCount = 0;
+
+   for ( int64_t column = cFirstLine; column < cFirstLine + cLineCount; ++column )
+   {
+      for ( int64_t row = 0; row < cRows; ++row )
+      {
+         expectedCount += cIsValid( column, row ) ? 1 : 0;
+      }
+   }
+
+   EXPECT_EQ( reader.ReadData3DLines( 0, cFirstLine, cLineCount, image ), expectedCount );
+
+   // The points with no return are left out
+   for ( int64_t line = 0; line < cLineCount; ++line )
+   {
+      for ( int64_t row = 0; row < cRows; ++row )
+      {
+         const int64_t column = cFirstLine + line;
+         const auto cCell = static_cast<size_t>( line * cRows + row );
+
+         ASSERT_EQ( image.cartesianZ[cCell],
+                    cIsValid( column, row ) ? static_cast<double>( column * cRows + row ) : -1.0 )
+            << column << " " << row;
+      }
+   }
+}
+
+TEST( SimpleReader, ReadFromBuffer )
+{
+   constexpr int64_t cNumPoints = 5000;
+
+   e57::Data3D header;
+   header.guid = "Read From Buffer Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Read From Buffer File GUID";
+
+      e57::Writer writer( "./ReadFromBuffer.e57", options );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( i ) * 2.0;
+         pointsData.cartesianZ[i] = static_cast<double>( i ) * 3.0;
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   }
+
+   // Load the whole file, as if it had been downloaded
+   std::ifstream file( "./ReadFromBuffer.e57", std::ios::binary );
+   const std::vector<char> contents( ( std::istreambuf_iterator<char>( file ) ),
+                                     std::istreambuf_iterator<char>() );
+
+   ASSERT_FALSE( contents.empty() );
+
+   e57::Reader reader( contents.data(), contents.size(), {} );
+
+   ASSERT_TRUE( reader.IsOpen() );
+   ASSERT_EQ( reader.GetData3DCount(), 1 );
+
+   e57::E57Root fileHeader;
+   ASSERT_TRUE( reader.GetE57Root( fileHeader ) );
+   EXPECT_EQ( fileHeader.guid, "Read From Buffer File GUID" );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+   ASSERT_EQ( readHeader.pointCount, cNumPoints );
+
+   e57::Data3DPointsDouble points( readHeader );
+
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, points );
+
+   EXPECT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+   vectorReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_EQ( points.cartesianX[i], static_cast<double>( i ) );
+      ASSERT_EQ( points.cartesianZ[i], static_cast<double>( i ) * 3.0 );
+   }
+
+   // A truncated buffer is rejected
+   try
+   {
+      e57::Reader truncated( contents.data(), contents.size() / 2, {} );
+      FAIL() << "Expected an E57Exception";
+   }
+   catch ( e57::E57Exception & )
+   {
+   }
+}
+
+TEST( SimpleReader, ReadFromSource )
+{
+   // Serves a file loaded into memory with range reads, like an object store would
+   class CountingSource : public e57::ReadSource
+   {
+   public:
+      explicit CountingSource( std::vector<char> contents ) : contents_( std::move( contents ) )
+      {
+      }
+
+      uint64_t size() override
+      {
+         return contents_.size();
+      }
+
+      void readAt( uint64_t offset, char *buffer, size_t count ) override
+      {
+         if ( offset + count > contents_.size() )
+         {
+            throw std::runtime_error( "read past the end" );
+         }
+
+         std::copy_n( contents_.data() + offset, count, buffer );
+
+         ++requests;
+      }
+
+      e57::ustring name() const override
+      {
+         return "memory://ReadFromSource.e57";
+      }
+
+      size_t blockSize() const override
+      {
+         return 256 * 1024;
+      }
+
+      std::atomic<int> requests{ 0 };
+
+   private:
+      const std::vector<char> contents_;
+   };
+
+   constexpr int64_t cNumPoints = 200000;
+
+   e57::Data3D header;
+   header.guid = "Read From Source Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Read From Source File GUID";
+
+      e57::Writer writer( "./ReadFromSource.e57", options );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( i ) * 2.0;
+         pointsData.cartesianZ[i] = static_cast<double>( i ) * 3.0;
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   }
+
+   std::ifstream file( "./ReadFromSource.e57", std::ios::binary );
+   std::vector<char> contents( ( std::istreambuf_iterator<char>( file ) ),
+                               std::istreambuf_iterator<char>() );
+
+   const size_t cFileSize = contents.size();
+
+   ASSERT_GT( cFileSize, 1024u * 1024u );
+
+   auto source = std::make_shared<CountingSource>( std::move( contents ) );
+
+   {
+      e57::Reader reader( source, {} );
+
+      ASSERT_TRUE( reader.IsOpen() );
+      ASSERT_EQ( reader.GetData3DCount(), 1 );
+
+      e57::Data3D readHeader;
+      ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+      ASSERT_EQ( readHeader.pointCount, cNumPoints );
+
+      e57::Data3DPointsDouble points( readHeader );
+
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, points );
+
+      EXPECT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+      vectorReader.close();
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_EQ( points.cartesianX[i], static_cast<double>( i ) );
+         ASSERT_EQ( points.cartesianZ[i], static_cast<double>( i ) * 3.0 );
+      }
+   }
+
+   // The small page reads were served from a few large blocks
+   const auto cBlockCount = static_cast<int>( ( cFileSize + 256 * 1024 - 1 ) / ( 256 * 1024 ) );
+
+   EXPECT_GT( source->requests, 0 );
+   EXPECT_LE( source->requests, 2 * cBlockCount );
+
+   // Errors of the source are reported as read errors
+   class FailingSource : public e57::ReadSource
+   {
+   public:
+      uint64_t size() override
+      {
+         return 100 * 1024;
+      }
+
+      void readAt( uint64_t, char *, size_t ) override
+      {
+         throw std::runtime_error( "connection reset" );
+      }
+   };
+
+   try
+   {
+      e57::Reader failing( std::make_shared<FailingSource>(), {} );
+      FAIL() << "Expected ErrorReadFailed";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorReadFailed );
+   }
+}
+
+TEST( SimpleReader, OddBitWidths )
+{
+   // Fields of widths which aren't a multiple of 8 bits straddle bytes & packets, so the decoders
+   // stop part way through a byte, both at the end of a packet and when the buffers are full.
+   constexpr int64_t cNumRecords = 60000;
+
+   const auto valueA = []( int64_t i ) { return ( i * 7919 ) % 8191; };      // 13 bits
+   const auto valueB = []( int64_t i ) { return ( i % 7 ) - 3; };            // 3 bits
+   const auto valueC = []( int64_t i ) { return ( i * 104729 ) % 1000003; }; // 20 bits
+
+   {
+      e57::ImageFile imf( "./OddBitWidths.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "a", e57::IntegerNode( imf, 0, 0, 8190 ) );
+      proto.set( "b", e57::IntegerNode( imf, 0, -3, 3 ) );
+      proto.set( "c", e57::ScaledIntegerNode( imf, 0, 0, 1000002, 0.001, 0.0 ) );
+      proto.set( "label", e57::StringNode( imf ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode records( imf, proto, codecs );
+      imf.root().set( "records", records );
+
+      std::vector<int32_t> a( cNumRecords );
+      std::vector<int8_t> b( cNumRecords );
+      std::vector<int32_t> c( cNumRecords );
+      std::vector<std::string> labels( cNumRecords );
+
+      for ( int64_t i = 0; i < cNumRecords; ++i )
+      {
+         a[i] = static_cast<int32_t>( valueA( i ) );
+         b[i] = static_cast<int8_t>( valueB( i ) );
+         c[i] = static_cast<int32_t>( valueC( i ) );
+         labels[i] = std::string( static_cast<size_t>( i % 5 ), 'y' );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "a", a.data(), a.size(), true );
+      sbufs.emplace_back( imf, "b", b.data(), b.size(), true );
+      sbufs.emplace_back( imf, "c", c.data(), c.size(), true, false );
+      sbufs.emplace_back( imf, "label", &labels );
+
+      e57::CompressedVectorWriter writer = records.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./OddBitWidths.e57", "r" );
+   e57::CompressedVectorNode records( imf.root().get( "records" ) );
+
+   for ( const size_t cBufferSize : { size_t( 1 ), size_t( 37 ), size_t( 4096 ) } )
+   {
+      SCOPED_TRACE( cBufferSize );
+
+      std::vector<int64_t> a( cBufferSize );
+      std::vector<int64_t> b( cBufferSize );
+      std::vector<double> c( cBufferSize );
+      std::vector<std::string> labels( cBufferSize );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "a", a.data(), cBufferSize, true );
+      dbufs.emplace_back( imf, "b", b.data(), cBufferSize, true );
+      dbufs.emplace_back( imf, "c", c.data(), cBufferSize, true, true );
+      dbufs.emplace_back( imf, "label", &labels );
+
+      e57::CompressedVectorReader reader = records.reader( dbufs );
+
+      int64_t record = 0;
+
+      while ( const unsigned count = reader.read() )
+      {
+         for ( unsigned i = 0; i < count; ++i, ++record )
+         {
+            ASSERT_EQ( a[i], valueA( record ) ) << "record=" << record;
+            ASSERT_EQ( b[i], valueB( record ) ) << "record=" << record;
+            ASSERT_DOUBLE_EQ( c[i], static_cast<double>( valueC( record ) ) * 0.001 )
+               << "record=" << record;
+            ASSERT_EQ( labels[i].size(), static_cast<size_t>( record % 5 ) ) << "record=" << record;
+         }
+      }
+
+      EXPECT_EQ( record, cNumRecords );
+
+      reader.close();
+   }
+
+   imf.close();
+}
+
+TEST( SimpleReader, ImageFilePool )
+{
+   constexpr int64_t cNumRecords = 20000;
+
+   const auto writeFile = []( const std::string &fileName, int64_t recordCount ) {
+      e57::ImageFile imf( fileName, "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "index", e57::IntegerNode( imf, 0, 0, cNumRecords ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode records( imf, proto, codecs );
+      imf.root().set( "records", records );
+
+      std::vector<int64_t> indices( static_cast<size_t>( recordCount ) );
+      std::iota( indices.begin(), indices.end(), int64_t( 0 ) );
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "index", indices.data(), indices.size(), true );
+
+      e57::CompressedVectorWriter writer = records.writer( sbufs );
+      writer.write( indices.size() );
+      writer.close();
+
+      imf.close();
+   };
+
+   writeFile( "./ImageFilePool1.e57", cNumRecords );
+   writeFile( "./ImageFilePool2.e57", 10 );
+   writeFile( "./ImageFilePool3.e57", 10 );
+
+   e57::ImageFilePool pool( 2 );
+
+   EXPECT_EQ( pool.capacity(), 2u );
+
+   const e57::ImageFile first = pool.open( "./ImageFilePool1.e57" );
+
+   // Every thread gets the same handle & reads with its own reader
+   constexpr size_t cThreadCount = 4;
+
+   std::vector<bool> sameHandle( cThreadCount, false );
+   std::vector<int64_t> sums( cThreadCount, 0 );
+   std::vector<std::thread> threads;
+
+   for ( size_t t = 0; t < cThreadCount; ++t )
+   {
+      threads.emplace_back( [&, t]() {
+         e57::ImageFile imf = pool.open( "./ImageFilePool1.e57" );
+
+         sameHandle[t] = ( imf == first );
+
+         e57::CompressedVectorNode records( imf.root().get( "records" ) );
+
+         std::vector<int64_t> indices( 1000 );
+         std::vector<e57::SourceDestBuffer> dbufs;
+         dbufs.emplace_back( imf, "index", indices.data(), indices.size(), true );
+
+         e57::CompressedVectorReader reader = records.reader( dbufs );
+
+         while ( const unsigned cRead = reader.read() )
+         {
+            sums[t] = std::accumulate( indices.begin(), indices.begin() + cRead, sums[t] );
+         }
+
+         reader.close();
+      } );
+   }
+
+   for ( auto &thread : threads )
+   {
+      thread.join();
+   }
+
+   for ( size_t t = 0; t < cThreadCount; ++t )
+   {
+      EXPECT_TRUE( sameHandle[t] );
+      EXPECT_EQ( sums[t], cNumRecords * ( cNumRecords - 1 ) / 2 );
+   }
+
+   EXPECT_EQ( pool.size(), 1u );
+
+   // Other read options get their own handle
+   EXPECT_NE( pool.open( "./ImageFilePool1.e57", e57::ChecksumNone ), first );
+   EXPECT_EQ( pool.size(), 2u );
+
+   // The least recently used handle is dropped, but stays open while in use
+   EXPECT_EQ( pool.open( "./ImageFilePool1.e57" ), first );
+
+   const e57::ImageFile second = pool.open( "./ImageFilePool2.e57" );
+   const e57::ImageFile third = pool.open( "./ImageFilePool3.e57" );
+
+   EXPECT_EQ( pool.size(), 2u );
+   EXPECT_EQ( pool.open( "./ImageFilePool2.e57" ), second );
+   EXPECT_NE( pool.open( "./ImageFilePool1.e57" ), first );
+   EXPECT_TRUE( first.isOpen() );
+
+   // A file which changed on disk is opened again
+   writeFile( "./ImageFilePool3.e57", 20 );
+
+   const e57::ImageFile rewritten = pool.open( "./ImageFilePool3.e57" );
+
+   EXPECT_NE( rewritten, third );
+   EXPECT_EQ( e57::CompressedVectorNode( rewritten.root().get( "records" ) ).childCount(), 20 );
+
+   pool.remove( "./ImageFilePool3.e57" );
+   EXPECT_EQ( pool.size(), 1u );
+
+   pool.clear();
+   EXPECT_EQ( pool.size(), 0u );
+   EXPECT_TRUE( first.isOpen() );
+
+   try
+   {
+      pool.open( "./ImageFilePoolMissing.e57" );
+      FAIL() << "Expected ErrorOpenFailed";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorOpenFailed );
+   }
+
+   // Without any capacity nothing is kept
+   e57::ImageFilePool noPool( 0 );
+
+   EXPECT_NE( noPool.open( "./ImageFilePool2.e57" ), noPool.open( "./ImageFilePool2.e57" ) );
+   EXPECT_EQ( noPool.size(), 0u );
+
+   EXPECT_EQ( &e57::ImageFilePool::global(), &e57::ImageFilePool::global() );
+}
+
+TEST( SimpleReader, ReusedReader )
+{
+   // Large enough for several indexed chunks
+   constexpr int64_t cNumRecords = 300000;
+
+   {
+      e57::ImageFile imf( "./ReusedReader.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "index", e57::IntegerNode( imf, 0, 0, cNumRecords - 1 ) );
+      proto.set( "value", e57::FloatNode( imf, 0.0, e57::PrecisionDouble ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode records( imf, proto, codecs );
+      imf.root().set( "records", records );
+
+      std::vector<int64_t> indices( cNumRecords );
+      std::vector<double> values( cNumRecords );
+
+      for ( int64_t i = 0; i < cNumRecords; ++i )
+      {
+         indices[i] = i;
+         values[i] = static_cast<double>( i ) * 0.5;
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "index", indices.data(), indices.size(), true );
+      sbufs.emplace_back( imf, "value", values.data(), values.size() );
+
+      e57::CompressedVectorWriter writer = records.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./ReusedReader.e57", "r" );
+   e57::CompressedVectorNode records( imf.root().get( "records" ) );
+
+   std::vector<int64_t> indices( 16 );
+   std::vector<double> values( 16 );
+
+   std::vector<e57::SourceDestBuffer> dbufs;
+   dbufs.emplace_back( imf, "index", indices.data(), indices.size(), true );
+   dbufs.emplace_back( imf, "value", values.data(), values.size() );
+
+   e57::CompressedVectorReader reader = records.reader( dbufs );
+
+   // Read ranges of various sizes, going back & forth, with buffers sized for each one
+   struct Range
+   {
+      int64_t first;
+      int64_t count;
+   };
+
+   const Range cRanges[] = { { 0, 10 },       { 250000, 1000 }, { 1000, 70000 }, { 5, 1 },
+                             { 299990, 10 },  { 12345, 0 },     { 0, cNumRecords } };
+
+   for ( const auto &range : cRanges )
+   {
+      SCOPED_TRACE( range.first );
+
+      const auto cCapacity = static_cast<size_t>( std::max<int64_t>( 1, range.count / 3 ) );
+
+      std::vector<int32_t> rangeIndices( cCapacity );
+      std::vector<float> rangeValues( cCapacity );
+
+      std::vector<e57::SourceDestBuffer> rangeBuffers;
+      rangeBuffers.emplace_back( imf, "index", rangeIndices.data(), cCapacity, true );
+      rangeBuffers.emplace_back( imf, "value", rangeValues.data(), cCapacity, true );
+
+      reader.rebind( rangeBuffers );
+      reader.setRecordRange( range.first, range.count );
+
+      int64_t next = range.first;
+
+      while ( const unsigned cRead = reader.read() )
+      {
+         for ( unsigned i = 0; i < cRead; ++i, ++next )
+         {
+            ASSERT_EQ( rangeIndices[i], next );
+            ASSERT_EQ( rangeValues[i], static_cast<float>( next ) * 0.5f );
+         }
+      }
+
+      EXPECT_EQ( next, range.first + range.count );
+   }
+
+   // Back to the original buffers, with a seek inside the range
+   reader.rebind( dbufs );
+   reader.setRecordRange( 100, 100 );
+   reader.seek( 190 );
+
+   EXPECT_EQ( reader.read(), 10u );
+   EXPECT_EQ( indices[0], 190 );
+   EXPECT_EQ( values[9], 199 * 0.5 );
+   EXPECT_EQ( reader.read(), 0u );
+
+   // The end of the range is as far as seek() goes
+   reader.seek( 200 );
+   EXPECT_EQ( reader.read(), 0u );
+
+   try
+   {
+      reader.seek( 201 );
+      FAIL() << "Expected ErrorBadAPIArgument";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorBadAPIArgument );
+   }
+
+   try
+   {
+      reader.setRecordRange( cNumRecords - 5, 6 );
+      FAIL() << "Expected ErrorBadAPIArgument";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorBadAPIArgument );
+   }
+
+   // The fields can't change
+   std::vector<e57::SourceDestBuffer> otherFields;
+   otherFields.emplace_back( imf, "value", values.data(), values.size() );
+   otherFields.emplace_back( imf, "index", indices.data(), indices.size(), true );
+
+   try
+   {
+      reader.rebind( otherFields );
+      FAIL() << "Expected ErrorBuffersNotCompatible";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorBuffersNotCompatible );
+   }
+
+   reader.close();
+   imf.close();
+}
+
+TEST( SimpleReader, SampledRead )
+{
+   // Large enough that the writer splits the scan into several indexed chunks
+   constexpr int64_t cNumPoints = 200000;
+
+   e57::Data3D header;
+   header.guid = "Sampled Read Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.colorRedField = true;
+   header.pointFields.intensityField = true;
+   header.pointFields.intensityNodeType = e57::NumericalNodeType::ScaledInteger;
+   header.pointFields.intensityScale = 0.001;
+   header.intensityLimits.intensityMaximum = 10.0;
+   header.colorLimits.colorRedMaximum = 255;
+
+   // A field with one value, which has a constant decoder
+   header.pointFields.returnCountField = true;
+   header.pointFields.returnMaximum = 0;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Sampled Read File GUID";
+
+      e57::Writer writer( "./SampledRead.e57", options );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( i ) * 0.25;
+         pointsData.cartesianZ[i] = static_cast<double>( -i );
+         pointsData.colorRed[i] = static_cast<uint16_t>( i % 256 );
+         pointsData.intensity[i] = static_cast<double>( i % 10000 ) * 0.001;
+         pointsData.returnCount[i] = 0;
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   }
+
+   e57::Reader reader( "./SampledRead.e57", {} );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+   constexpr size_t cBufferSize = 37;
+
+   e57::Data3DPointsDouble points( readHeader );
+
+   // Read a sample with buffers of cBufferSize and check each record is one of the kept ones
+   uint64_t packetCacheMisses = 0;
+
+   auto readSample = [&]( const e57::RecordSampling &sampling, int64_t firstRecord,
+                          std::vector<int64_t> &records ) {
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cBufferSize, points );
+
+      vectorReader.setSampling( sampling );
+      vectorReader.seek( firstRecord );
+
+      while ( const unsigned cCount = vectorReader.read() )
+      {
+         for ( unsigned i = 0; i < cCount; ++i )
+         {
+            const auto cRecord = static_cast<int64_t>( points.cartesianX[i] );
+
+            ASSERT_EQ( points.cartesianY[i], static_cast<double>( cRecord ) * 0.25 );
+            ASSERT_EQ( points.cartesianZ[i], static_cast<double>( -cRecord ) );
+            ASSERT_EQ( points.colorRed[i], static_cast<uint16_t>( cRecord % 256 ) );
+            ASSERT_NEAR( points.intensity[i], static_cast<double>( cRecord % 10000 ) * 0.001,
+                         1.0e-9 );
+            ASSERT_EQ( points.returnCount[i], 0 );
+
+            records.push_back( cRecord );
+         }
+      }
+
+      packetCacheMisses = vectorReader.statistics().packetCacheMisses;
+
+      vectorReader.close();
+   };
+
+   std::vector<int64_t> all;
+   readSample( {}, 0, all );
+
+   const uint64_t cAllMisses = packetCacheMisses;
+
+   ASSERT_EQ( all.size(), static_cast<size_t>( cNumPoints ) );
+
+   for ( const int64_t step : { 7, 100, 50000 } )
+   {
+      SCOPED_TRACE( step );
+
+      e57::RecordSampling sampling;
+      sampling.step = static_cast<uint64_t>( step );
+
+      std::vector<int64_t> records;
+      readSample( sampling, 0, records );
+
+      const uint64_t cMisses = packetCacheMisses;
+
+      ASSERT_EQ( records.size(), static_cast<size_t>( ( cNumPoints + step - 1 ) / step ) );
+
+      for ( size_t i = 0; i < records.size(); ++i )
+      {
+         ASSERT_EQ( records[i], static_cast<int64_t>( i ) * step );
+      }
+
+      // A sparse sample skips the chunks without any of its records
+      if ( step == 50000 )
+      {
+         EXPECT_LT( cMisses, cAllMisses );
+      }
+
+      // Seeking keeps the same records
+      records.clear();
+      readSample( sampling, 120001, records );
+
+      ASSERT_FALSE( records.empty() );
+      EXPECT_EQ( records[0], ( 120001 + step - 1 ) / step * step );
+   }
+
+   // A random sample is the same every time, and about the size asked for
+   e57::RecordSampling sampling;
+   sampling.rate = 0.1;
+   sampling.seed = 42;
+
+   std::vector<int64_t> first;
+   std::vector<int64_t> second;
+
+   readSample( sampling, 0, first );
+   readSample( sampling, 0, second );
+
+   EXPECT_EQ( first, second );
+   EXPECT_GT( first.size(), static_cast<size_t>( cNumPoints / 12 ) );
+   EXPECT_LT( first.size(), static_cast<size_t>( cNumPoints / 8 ) );
+   EXPECT_TRUE( std::is_sorted( first.begin(), first.end() ) );
+
+   // Nothing is kept
+   sampling.rate = 0.0;
+
+   std::vector<int64_t> none;
+   readSample( sampling, 0, none );
+
+   EXPECT_TRUE( none.empty() );
+
+   // Bad samplings
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cBufferSize, points );
+
+   sampling.step = 0;
+   sampling.rate = 1.0;
+   E57_ASSERT_THROW( vectorReader.setSampling( sampling ) );
+
+   sampling.step = 1;
+   sampling.rate = 1.5;
+   E57_ASSERT_THROW( vectorReader.setSampling( sampling ) );
+
+   vectorReader.close();
+
+   // String fields
+   constexpr size_t cNumRecords = 5000;
+
+   {
+      e57::ImageFile imf( "./SampledReadStrings.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "label", e57::StringNode( imf ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode labels( imf, proto, codecs );
+      imf.root().set( "labels", labels );
+
+      std::vector<std::string> values( cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         values[i] = ( ( i % 97 ) == 0 ) ? std::string( 300, 'x' ) : "label " + std::to_string( i );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "label", &values );
+
+      e57::CompressedVectorWriter writer = labels.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./SampledReadStrings.e57", "r" );
+   e57::CompressedVectorNode labels( imf.root().get( "labels" ) );
+
+   std::vector<std::string> values( 100 );
+
+   std::vector<e57::SourceDestBuffer> dbufs;
+   dbufs.emplace_back( imf, "label", &values );
+
+   e57::CompressedVectorReader labelReader = labels.reader( dbufs );
+
+   sampling.step = 97;
+   sampling.rate = 1.0;
+   labelReader.setSampling( sampling );
+
+   ASSERT_EQ( labelReader.read(), static_cast<unsigned>( ( cNumRecords + 96 ) / 97 ) );
+
+   for ( size_t i = 0; i < ( cNumRecords + 96 ) / 97; ++i )
+   {
+      ASSERT_EQ( values[i], std::string( 300, 'x' ) );
+   }
+
+   labelReader.close();
+   imf.close();
+}
+
+TEST( SimpleReader, PacketCacheOptions )
+{
+   constexpr int64_t cNumPoints = 100000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Packet Cache File GUID";
+
+      e57::Writer writer( "./PacketCache.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Packet Cache Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.colorRedField = true;
+
+      header.colorLimits.colorRedMaximum = 255;
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<float>( i );
+         pointsData.cartesianY[i] = static_cast<float>( -i );
+         pointsData.cartesianZ[i] = static_cast<float>( i % 1000 );
+         pointsData.colorRed[i] = static_cast<uint16_t>( i % 256 );
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   auto readWith = [&]( const e57::PacketCacheOptions &cacheOptions ) {
+      e57::ReaderOptions options;
+      options.packetCache = cacheOptions;
+
+      e57::Reader reader( "./PacketCache.e57", options );
+
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+      // A small buffer so the reader goes back to the cache many times
+      constexpr size_t cBufferSize = 777;
+
+      e57::Data3DPointsFloat points( header );
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cBufferSize, points );
+
+      int64_t index = 0;
+      unsigned read = 0;
+
+      while ( ( read = vectorReader.read() ) > 0 )
+      {
+         for ( unsigned i = 0; i < read; ++i, ++index )
+         {
+            ASSERT_EQ( points.cartesianX[i], static_cast<float>( index ) );
+            ASSERT_EQ( points.cartesianY[i], static_cast<float>( -index ) );
+            ASSERT_EQ( points.cartesianZ[i], static_cast<float>( index % 1000 ) );
+            ASSERT_EQ( points.colorRed[i], static_cast<uint16_t>( index % 256 ) );
+         }
+      }
+
+      vectorReader.close();
+
+      EXPECT_EQ( index, cNumPoints );
+   };
+
+   e57::PacketCacheOptions cacheOptions;
+
+   readWith( cacheOptions );
+
+   // Smallest cache, no read-ahead
+   cacheOptions.packetCount = 1;
+   cacheOptions.readAheadCount = 0;
+   readWith( cacheOptions );
+
+   // Read-ahead limited by a small cache
+   cacheOptions.packetCount = 2;
+   cacheOptions.readAheadCount = 8;
+   readWith( cacheOptions );
+
+   cacheOptions.packetCount = 64;
+   cacheOptions.policy = e57::PacketCacheLowestOffset;
+   cacheOptions.readAheadCount = 16;
+   readWith( cacheOptions );
+
+   // Read the following spans on a background thread
+   cacheOptions.backgroundReadAhead = true;
+   readWith( cacheOptions );
+
+   cacheOptions.packetCount = 1;
+   cacheOptions.policy = e57::PacketCacheLeastRecentlyUsed;
+   cacheOptions.readAheadCount = 0;
+   readWith( cacheOptions );
+
+   cacheOptions.packetCount = 0;
+
+   e57::ReaderOptions options;
+   options.packetCache = cacheOptions;
+
+   e57::Reader reader( "./PacketCache.e57", options );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   e57::Data3DPointsFloat points( header );
+
+   E57_ASSERT_THROW( reader.SetUpData3DPointsData( 0, cNumPoints, points ) );
+}
+
+TEST( SimpleReader, BackgroundReadAheadBetweenReads )
+{
+   constexpr int64_t cNumPoints = 100000;
+
+   {
+      e57::Writer writer( "./BackgroundReadAhead.e57", e57::WriterOptions() );
+
+      e57::Data3D header;
+      header.guid = "Background Read-Ahead Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( -i );
+         pointsData.cartesianZ[i] = static_cast<double>( i % 1000 );
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::ReaderOptions options;
+   options.packetCache.readAheadCount = 2;
+   options.packetCache.backgroundReadAhead = true;
+
+   e57::Reader reader( "./BackgroundReadAhead.e57", options );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   // Far fewer points at a time than a span holds, with some work between the reads, so the
+   // following spans are read while the caller is busy
+   constexpr size_t cBufferSize = 500;
+
+   e57::Data3DPointsDouble points( header );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cBufferSize, points );
+
+   int64_t index = 0;
+   unsigned read = 0;
+
+   while ( ( read = vectorReader.read() ) > 0 )
+   {
+      for ( unsigned i = 0; i < read; ++i, ++index )
+      {
+         ASSERT_EQ( points.cartesianX[i], static_cast<double>( index ) );
+         ASSERT_EQ( points.cartesianZ[i], static_cast<double>( index % 1000 ) );
+      }
+
+      std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+   }
+
+   EXPECT_EQ( index, cNumPoints );
+
+   const e57::CompressedVectorReaderStatistics statistics = vectorReader.statistics();
+
+   // Only the first span has to be read when it's wanted, and the others were read while the
+   // caller was busy (allowing for a loaded machine)
+   EXPECT_GT( statistics.readAheadSpans, 4u );
+   EXPECT_EQ( statistics.prefetchedSpans + 1, statistics.readAheadSpans );
+   EXPECT_LE( statistics.readAheadWaits, statistics.readAheadSpans / 4 );
+
+   // The reader can still be closed with spans in flight, and so can the file
+   auto earlyReader = reader.SetUpData3DPointsData( 0, cBufferSize, points );
+
+   EXPECT_EQ( earlyReader.read(), cBufferSize );
+
+   EXPECT_TRUE( reader.Close() );
+}
+
+TEST( SimpleReader, SharedPacketCache )
+{
+   constexpr int64_t cNumPoints = 100000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Shared Packet Cache File GUID";
+
+      e57::Writer writer( "./SharedPacketCache.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Shared Packet Cache Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<float>( i );
+         pointsData.cartesianY[i] = static_cast<float>( -i );
+         pointsData.cartesianZ[i] = static_cast<float>( i % 1000 );
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   // Small buffers so the readers go back to the cache many times
+   constexpr size_t cBufferSize = 777;
+
+   struct Points
+   {
+      explicit Points( e57::Reader &reader ) :
+         x( cBufferSize ), y( cBufferSize ), z( cBufferSize ),
+         buffers{ { reader.GetRawIMF(), "cartesianX", x.data(), cBufferSize, true },
+                  { reader.GetRawIMF(), "cartesianY", y.data(), cBufferSize, true },
+                  { reader.GetRawIMF(), "cartesianZ", z.data(), cBufferSize, true } }
+      {
+      }
+
+      // True if all the points were read
+      bool readAll( e57::CompressedVectorReader &vectorReader )
+      {
+         int64_t index = 0;
+         unsigned read = 0;
+         bool matches = true;
+
+         while ( ( read = vectorReader.read() ) > 0 )
+         {
+            for ( unsigned i = 0; i < read; ++i, ++index )
+            {
+               matches = matches && ( x[i] == static_cast<float>( index ) ) &&
+                         ( y[i] == static_cast<float>( -index ) ) &&
+                         ( z[i] == static_cast<float>( index % 1000 ) );
+            }
+         }
+
+         return matches && ( index == cNumPoints );
+      }
+
+      std::vector<float> x;
+      std::vector<float> y;
+      std::vector<float> z;
+      std::vector<e57::SourceDestBuffer> buffers;
+   };
+
+   e57::ReaderOptions options;
+   options.sharedPacketCacheBytes = 16 * 1024 * 1024;
+
+   e57::Reader reader( "./SharedPacketCache.e57", options );
+
+   e57::CompressedVectorNode pointsNode(
+      reader.GetRawIMF().root().get( "/data3D/0/points" ) );
+   const e57::PacketCacheOptions cCacheOptions;
+
+   // Once one reader has read the points, the others find all the packets in the shared cache
+   {
+      Points points( reader );
+      e57::CompressedVectorReader vectorReader =
+         pointsNode.reader( points.buffers, cCacheOptions );
+
+      ASSERT_TRUE( points.readAll( vectorReader ) );
+      EXPECT_GT( vectorReader.statistics().packetCacheMisses, 0u );
+      vectorReader.close();
+   }
+
+   {
+      Points points( reader );
+      e57::CompressedVectorReader vectorReader =
+         pointsNode.reader( points.buffers, cCacheOptions );
+
+      ASSERT_TRUE( points.readAll( vectorReader ) );
+      EXPECT_GT( vectorReader.statistics().packetCacheHits, 0u );
+      EXPECT_EQ( vectorReader.statistics().packetCacheMisses, 0u );
+      vectorReader.close();
+   }
+
+   // Unless they use their own
+   {
+      e57::PacketCacheOptions ownCache;
+      ownCache.useSharedCache = false;
+
+      Points points( reader );
+      e57::CompressedVectorReader vectorReader = pointsNode.reader( points.buffers, ownCache );
+
+      ASSERT_TRUE( points.readAll( vectorReader ) );
+      EXPECT_GT( vectorReader.statistics().packetCacheMisses, 0u );
+      vectorReader.close();
+   }
+
+   e57::ImageFileStatistics statistics = reader.GetRawIMF().statistics();
+
+   EXPECT_GT( statistics.sharedCacheHits, 0u );
+   EXPECT_GT( statistics.sharedCacheMisses, 0u );
+   EXPECT_EQ( statistics.sharedCacheEvictions, 0u );
+   EXPECT_GT( statistics.sharedCacheBytes, 0u );
+   EXPECT_LE( statistics.sharedCacheBytes, options.sharedPacketCacheBytes );
+
+   // Readers on several threads at once, with background read-ahead, in a cache too small for
+   // the scan
+   constexpr uint64_t cSmallBudget = 256 * 1024;
+
+   reader.GetRawIMF().setSharedPacketCache( cSmallBudget, 2 );
+
+   e57::PacketCacheOptions backgroundCache;
+   backgroundCache.backgroundReadAhead = true;
+
+   std::vector<std::unique_ptr<Points>> threadPoints;
+   std::vector<e57::CompressedVectorReader> vectorReaders;
+
+   for ( int i = 0; i < 4; ++i )
+   {
+      threadPoints.emplace_back( new Points( reader ) );
+      vectorReaders.push_back( pointsNode.reader( threadPoints.back()->buffers,
+                                                   ( i % 2 == 0 ) ? cCacheOptions
+                                                                  : backgroundCache ) );
+   }
+
+   std::vector<int> results( vectorReaders.size(), 0 );
+   std::vector<std::thread> threads;
+
+   for ( size_t i = 0; i < vectorReaders.size(); ++i )
+   {
+      threads.emplace_back( [&, i]() {
+         results[i] = threadPoints[i]->readAll( vectorReaders[i] ) ? 1 : 0;
+      } );
+   }
+
+   for ( auto &thread : threads )
+   {
+      thread.join();
+   }
+
+   for ( size_t i = 0; i < vectorReaders.size(); ++i )
+   {
+      EXPECT_EQ( results[i], 1 ) << "reader=" << i;
+      vectorReaders[i].close();
+   }
+
+   statistics = reader.GetRawIMF().statistics();
+
+   EXPECT_GT( statistics.sharedCacheEvictions, 0u );
+   EXPECT_LE( statistics.sharedCacheBytes, cSmallBudget );
+
+   try
+   {
+      reader.GetRawIMF().setSharedPacketCache( cSmallBudget, 0 );
+
+      FAIL() << "Expected ErrorBadAPIArgument";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorBadAPIArgument );
+   }
+
+   // The counts are kept once the file is closed
+   reader.Close();
+
+   EXPECT_EQ( reader.GetRawIMF().statistics().sharedCacheEvictions,
+              statistics.sharedCacheEvictions );
+}
+
+TEST( SimpleReader, ProjectedRead )
+{
+   constexpr int64_t cNumPoints = 100000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Projected Read File GUID";
+
+      e57::Writer writer( "./ProjectedRead.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Projected Read Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.intensityField = true;
+      header.pointFields.colorRedField = true;
+      header.pointFields.colorGreenField = true;
+      header.pointFields.colorBlueField = true;
+
+      header.intensityLimits.intensityMaximum = 1.0;
+      header.colorLimits.colorRedMaximum = 255;
+      header.colorLimits.colorGreenMaximum = 255;
+      header.colorLimits.colorBlueMaximum = 255;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( -i );
+         pointsData.cartesianZ[i] = static_cast<double>( i % 1000 );
+         pointsData.intensity[i] = static_cast<double>( i % 2 );
+         pointsData.colorRed[i] = static_cast<uint16_t>( i % 256 );
+         pointsData.colorGreen[i] = static_cast<uint16_t>( ( i / 3 ) % 256 );
+         pointsData.colorBlue[i] = static_cast<uint16_t>( ( i / 7 ) % 256 );
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   // Read the fields enabled in header and return the bytes skipped
+   auto readWith = [&]( const e57::PacketCacheOptions &cacheOptions, const e57::Data3D &header ) {
+      e57::ReaderOptions options;
+      options.packetCache = cacheOptions;
+
+      e57::Reader reader( "./ProjectedRead.e57", options );
+
+      e57::Data3D blockHeader = header;
+      blockHeader.pointCount = 1000;
+
+      e57::Data3DPointsDouble points( blockHeader );
+      auto vectorReader = reader.SetUpData3DPointsData( 0, 1000, points );
+
+      int64_t index = 0;
+      unsigned read = 0;
+
+      while ( ( read = vectorReader.read() ) > 0 )
+      {
+         for ( unsigned i = 0; i < read; ++i, ++index )
+         {
+            if ( points.cartesianX != nullptr )
+            {
+               EXPECT_EQ( points.cartesianX[i], static_cast<double>( index ) );
+               EXPECT_EQ( points.cartesianY[i], static_cast<double>( -index ) );
+            }
+
+            if ( points.cartesianZ != nullptr )
+            {
+               EXPECT_EQ( points.cartesianZ[i], static_cast<double>( index % 1000 ) );
+            }
+
+            if ( points.colorRed != nullptr )
+            {
+               EXPECT_EQ( points.colorRed[i], static_cast<uint16_t>( index % 256 ) );
+            }
+
+            if ( points.colorBlue != nullptr )
+            {
+               EXPECT_EQ( points.colorBlue[i], static_cast<uint16_t>( ( index / 7 ) % 256 ) );
+            }
+         }
+      }
+
+      EXPECT_EQ( index, cNumPoints );
+
+      vectorReader.close();
+
+      // Still available once closed
+      return vectorReader.skippedByteCount();
+   };
+
+   e57::Reader reader( "./ProjectedRead.e57", {} );
+
+   e57::Data3D all;
+   ASSERT_TRUE( reader.ReadData3D( 0, all ) );
+
+   e57::Data3D xyz = all;
+   xyz.pointFields.intensityField = false;
+   xyz.pointFields.colorRedField = false;
+   xyz.pointFields.colorGreenField = false;
+   xyz.pointFields.colorBlueField = false;
+
+   // Bytestreams which aren't next to each other
+   e57::Data3D zAndBlue = xyz;
+   zAndBlue.pointFields.cartesianXField = false;
+   zAndBlue.pointFields.cartesianYField = false;
+   zAndBlue.pointFields.colorBlueField = true;
+
+   e57::Data3D red = zAndBlue;
+   red.pointFields.cartesianZField = false;
+   red.pointFields.colorBlueField = false;
+   red.pointFields.colorRedField = true;
+
+   e57::PacketCacheOptions cacheOptions;
+
+   // Off by default
+   EXPECT_EQ( readWith( cacheOptions, xyz ), 0u );
+
+   cacheOptions.projectedRead = true;
+
+   EXPECT_EQ( readWith( cacheOptions, all ), 0u );
+
+   const uint64_t cXyzSkipped = readWith( cacheOptions, xyz );
+   const uint64_t cRedSkipped = readWith( cacheOptions, red );
+
+   EXPECT_GT( cXyzSkipped, 0u );
+   EXPECT_GT( cRedSkipped, cXyzSkipped );
+   EXPECT_GT( readWith( cacheOptions, zAndBlue ), cXyzSkipped );
+
+   // Packets are read again when they drop out of a small cache, skipping the same bytes again
+   cacheOptions.packetCount = 1;
+   EXPECT_GE( readWith( cacheOptions, red ), cRedSkipped );
+}
+
+TEST( SimpleReader, GroupedPacketRead )
+{
+   constexpr int64_t cNumPoints = 100000;
+
+   e57::WriterOptions options;
+   options.guid = "Grouped Packet File GUID";
+
+   // Intensity isn't in a group, so it goes in a third group of its own
+   options.compressedVectorWriter.packetFieldGroups = {
+      { "cartesianX", "cartesianY", "cartesianZ" },
+      { "colorRed", "colorGreen", "colorBlue", "nothingCalledThis" } };
+
+   e57::Data3D header;
+   header.guid = "Grouped Packet Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.intensityField = true;
+   header.pointFields.colorRedField = true;
+   header.pointFields.colorGreenField = true;
+   header.pointFields.colorBlueField = true;
+
+   header.intensityLimits.intensityMaximum = 1.0;
+   header.colorLimits.colorRedMaximum = 255;
+   header.colorLimits.colorGreenMaximum = 255;
+   header.colorLimits.colorBlueMaximum = 255;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      pointsData.cartesianX[i] = static_cast<double>( i );
+      pointsData.cartesianY[i] = static_cast<double>( -i );
+      pointsData.cartesianZ[i] = static_cast<double>( i % 1000 );
+      pointsData.intensity[i] = static_cast<double>( i % 2 );
+      pointsData.colorRed[i] = static_cast<uint16_t>( i % 256 );
+      pointsData.colorGreen[i] = static_cast<uint16_t>( ( i / 3 ) % 256 );
+      pointsData.colorBlue[i] = static_cast<uint16_t>( ( i / 7 ) % 256 );
+   }
+
+   {
+      e57::Writer writer( "./GroupedPacketRead.e57", options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   // Read the fields enabled in fields and return the bytes skipped
+   auto readWith = [&]( bool projectedRead, const e57::Data3D &fields ) {
+      e57::ReaderOptions readerOptions;
+      readerOptions.packetCache.projectedRead = projectedRead;
+
+      e57::Reader reader( "./GroupedPacketRead.e57", readerOptions );
+
+      e57::Data3D blockHeader = fields;
+      blockHeader.pointCount = 1000;
+
+      e57::Data3DPointsDouble points( blockHeader );
+      auto vectorReader = reader.SetUpData3DPointsData( 0, 1000, points );
+
+      int64_t index = 0;
+      unsigned read = 0;
+
+      while ( ( read = vectorReader.read() ) > 0 )
+      {
+         for ( unsigned i = 0; i < read; ++i, ++index )
+         {
+            if ( points.cartesianX != nullptr )
+            {
+               EXPECT_EQ( points.cartesianX[i], pointsData.cartesianX[index] );
+               EXPECT_EQ( points.cartesianY[i], pointsData.cartesianY[index] );
+               EXPECT_EQ( points.cartesianZ[i], pointsData.cartesianZ[index] );
+            }
+
+            if ( points.intensity != nullptr )
+            {
+               EXPECT_EQ( points.intensity[i], pointsData.intensity[index] );
+            }
+
+            if ( points.colorRed != nullptr )
+            {
+               EXPECT_EQ( points.colorRed[i], pointsData.colorRed[index] );
+               EXPECT_EQ( points.colorGreen[i], pointsData.colorGreen[index] );
+               EXPECT_EQ( points.colorBlue[i], pointsData.colorBlue[index] );
+            }
+         }
+      }
+
+      EXPECT_EQ( index, cNumPoints );
+
+      vectorReader.close();
+
+      return vectorReader.skippedByteCount();
+   };
+
+   e57::Data3D all;
+
+   {
+      e57::Reader reader( "./GroupedPacketRead.e57", {} );
+      ASSERT_TRUE( reader.ReadData3D( 0, all ) );
+   }
+
+   EXPECT_EQ( readWith( false, all ), 0u );
+   EXPECT_EQ( readWith( true, all ), 0u );
+
+   e57::Data3D colour = all;
+   colour.pointFields.cartesianXField = false;
+   colour.pointFields.cartesianYField = false;
+   colour.pointFields.cartesianZField = false;
+   colour.pointFields.intensityField = false;
+
+   // All the geometry is skipped (3 doubles per point) when only reading the colours
+   EXPECT_GE( readWith( true, colour ), static_cast<uint64_t>( cNumPoints * 3 * 8 ) );
+
+   e57::Data3D xyz = all;
+   xyz.pointFields.intensityField = false;
+   xyz.pointFields.colorRedField = false;
+   xyz.pointFields.colorGreenField = false;
+   xyz.pointFields.colorBlueField = false;
+
+   EXPECT_GT( readWith( true, xyz ), 0u );
+
+   // A field can't be in two groups
+   options.compressedVectorWriter.packetFieldGroups = { { "cartesianX" },
+                                                        { "cartesianY", "cartesianX" } };
+
+   e57::Writer writer( "./GroupedPacketRead.e57", options );
+
+   E57_ASSERT_THROW( writer.WriteData3DData( header, pointsData ) );
+}
+
+TEST( SimpleReader, ChunkStatistics )
+{
+   constexpr int64_t cNumPoints = 500000;
+
+   auto writeFile = [&]( const char *fileName, bool chunkStatistics ) {
+      e57::WriterOptions options;
+      options.guid = "Chunk Statistics File GUID";
+      options.compressedVectorWriter.chunkStatistics = chunkStatistics;
+
+      e57::Writer writer( fileName, options );
+
+      e57::Data3D header;
+      header.guid = "Chunk Statistics Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.intensityField = true;
+
+      // Scaled integer coordinates & float intensities
+      header.pointFields.pointRangeScale = 0.001;
+      header.pointFields.pointRangeMinimum = -1000.0;
+      header.pointFields.pointRangeMaximum = 1000.0;
+      header.intensityLimits.intensityMaximum = 1.0;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i ) * 0.001;
+         pointsData.cartesianY[i] = 0.5;
+         pointsData.cartesianZ[i] = static_cast<double>( i % 100 ) * 0.01;
+         pointsData.intensity[i] = static_cast<double>( i ) / cNumPoints;
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   };
+
+   writeFile( "./ChunkStatistics.e57", true );
+   writeFile( "./ChunkStatisticsNone.e57", false );
+
+   e57::Reader reader( "./ChunkStatistics.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   constexpr int64_t cBlockSize = 1000;
+
+   e57::Data3D blockHeader = header;
+   blockHeader.pointCount = cBlockSize;
+
+   e57::Data3DPointsDouble points( blockHeader );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cBlockSize, points );
+
+   // A small box: x is the record number / 1000
+   const std::vector<e57::FieldValueRange> cBox = { { "cartesianX", 123.4, 123.5 },
+                                                    { "cartesianZ", 0.0, 0.2 } };
+
+   const auto cRanges = vectorReader.matchingRecordRanges( cBox );
+
+   ASSERT_EQ( cRanges.size(), 1u );
+   EXPECT_LE( cRanges[0].firstRecord, 123400u );
+   EXPECT_GE( cRanges[0].firstRecord + cRanges[0].recordCount, 123501u );
+   EXPECT_LT( cRanges[0].recordCount, static_cast<uint64_t>( cNumPoints / 4 ) );
+
+   // Read the matching records & check them against the box
+   int64_t inBox = 0;
+
+   for ( const auto &range : cRanges )
+   {
+      vectorReader.seek( static_cast<int64_t>( range.firstRecord ) );
+
+      uint64_t remaining = range.recordCount;
+      uint64_t index = range.firstRecord;
+
+      while ( remaining > 0 )
+      {
+         const unsigned cRead = vectorReader.read();
+         ASSERT_GT( cRead, 0u );
+
+         const auto cCount = static_cast<unsigned>( std::min<uint64_t>( cRead, remaining ) );
+
+         for ( unsigned i = 0; i < cCount; ++i, ++index )
+         {
+            EXPECT_NEAR( points.cartesianX[i], static_cast<double>( index ) * 0.001, 0.0005 );
+
+            if ( ( points.cartesianX[i] >= 123.4 ) && ( points.cartesianX[i] <= 123.5 ) &&
+                 ( points.cartesianZ[i] <= 0.2 ) )
+            {
+               ++inBox;
+            }
+         }
+
+         remaining -= cCount;
+      }
+   }
+
+   // 101 values of x, with z <= 0.2 for 21 in every 100 records
+   EXPECT_GE( inBox, 21 );
+
+   // Float fields, and ranges which only just match or don't match at all
+   const auto cTwoEnds = vectorReader.matchingRecordRanges(
+      { { "intensity", 0.0, 0.01 }, { "cartesianY", 0.5, 0.5 } } );
+
+   ASSERT_EQ( cTwoEnds.size(), 1u );
+   EXPECT_EQ( cTwoEnds[0].firstRecord, 0u );
+
+   EXPECT_TRUE( vectorReader.matchingRecordRanges( { { "cartesianY", 0.6, 1.0 } } ).empty() );
+   EXPECT_TRUE( vectorReader.matchingRecordRanges( { { "intensity", 2.0, 3.0 } } ).empty() );
+
+   const auto cAll = vectorReader.matchingRecordRanges( {} );
+
+   ASSERT_EQ( cAll.size(), 1u );
+   EXPECT_EQ( cAll[0].firstRecord, 0u );
+   EXPECT_EQ( cAll[0].recordCount, static_cast<uint64_t>( cNumPoints ) );
+
+   try
+   {
+      vectorReader.matchingRecordRanges( { { "nothingCalledThis", 0.0, 1.0 } } );
+      FAIL() << "Expected ErrorPathUndefined";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorPathUndefined );
+   }
+
+   vectorReader.close();
+
+   // Without statistics, nothing is skipped
+   e57::Reader readerNone( "./ChunkStatisticsNone.e57", {} );
+
+   e57::Data3DPointsDouble pointsNone( blockHeader );
+   auto vectorReaderNone = readerNone.SetUpData3DPointsData( 0, cBlockSize, pointsNone );
+
+   const auto cRangesNone = vectorReaderNone.matchingRecordRanges( cBox );
+
+   ASSERT_EQ( cRangesNone.size(), 1u );
+   EXPECT_EQ( cRangesNone[0].firstRecord, 0u );
+   EXPECT_EQ( cRangesNone[0].recordCount, static_cast<uint64_t>( cNumPoints ) );
+
+   vectorReaderNone.close();
+}
+
+// Time opening a file with a large XML section (about 10k nodes), as when indexing many files
+TEST( SimpleReader, OpenManyNodes )
+{
+   constexpr int64_t cImageCount = 625;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Open Many Nodes File GUID";
+
+      e57::Writer writer( "./OpenManyNodes.e57", options );
+
+      for ( int64_t i = 0; i < cImageCount; ++i )
+      {
+         e57::Image2D header;
+         header.name = "Image " + std::to_string( i );
+         header.description = "Image with a pose & no representation";
+         header.sensorVendor = "Vendor";
+         header.sensorModel = "Model";
+         header.pose.translation.x = static_cast<double>( i ) * 0.5;
+         header.pose.translation.y = -1.25;
+         header.pose.translation.z = 3.0;
+
+         writer.NewImage2D( header );
+      }
+   }
+
+   const auto cStart = std::chrono::steady_clock::now();
+
+   e57::Reader reader( "./OpenManyNodes.e57", {} );
+
+   const auto cOpenTime = std::chrono::steady_clock::now() - cStart;
+
+   RecordProperty(
+      "openMicroseconds",
+      static_cast<int>(
+         std::chrono::duration_cast<std::chrono::microseconds>( cOpenTime ).count() ) );
+
+   ASSERT_EQ( reader.GetImage2DCount(), cImageCount );
+
+   for ( const int64_t cIndex : { int64_t( 0 ), cImageCount / 2, cImageCount - 1 } )
+   {
+      e57::Image2D header;
+      ASSERT_TRUE( reader.ReadImage2D( cIndex, header ) );
+
+      EXPECT_EQ( header.name, "Image " + std::to_string( cIndex ) );
+      EXPECT_EQ( header.sensorModel, "Model" );
+      EXPECT_EQ( header.pose.translation.x, static_cast<double>( cIndex ) * 0.5 );
+      EXPECT_EQ( header.pose.translation.y, -1.25 );
+   }
+}
+
+TEST( SimpleReader, LazyXmlLoad )
+{
+   constexpr int64_t cNumPoints = 1000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Lazy XML File GUID";
+
+      e57::Writer writer( "./LazyXmlLoad.e57", options );
+
+      for ( int scan = 0; scan < 3; ++scan )
+      {
+         e57::Data3D header;
+         header.guid = "Lazy XML Scan " + std::to_string( scan );
+         header.name = "Scan <" + std::to_string( scan ) + "> & more";
+         header.pointCount = cNumPoints;
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+
+         e57::Data3DPointsDouble pointsData( header );
+
+         for ( int64_t i = 0; i < cNumPoints; ++i )
+         {
+            pointsData.cartesianX[i] = static_cast<double>( i + scan );
+            pointsData.cartesianY[i] = 0.5 * static_cast<double>( i );
+            pointsData.cartesianZ[i] = -static_cast<double>( scan );
+         }
+
+         E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+      }
+
+      e57::Image2D image;
+      image.name = "Image";
+      image.sensorModel = "Model";
+
+      writer.NewImage2D( image );
+   }
+
+   e57::ReaderOptions options;
+   options.xmlLoad = e57::XmlLoadLazy;
+
+   e57::Reader lazyReader( "./LazyXmlLoad.e57", options );
+   e57::Reader fullReader( "./LazyXmlLoad.e57", {} );
+
+   ASSERT_EQ( lazyReader.GetData3DCount(), 3 );
+   ASSERT_EQ( lazyReader.GetImage2DCount(), 1 );
+
+   // Read the scans out of order
+   for ( const int64_t cScan : { 2, 0, 1 } )
+   {
+      e57::Data3D lazyHeader;
+      e57::Data3D fullHeader;
+
+      ASSERT_TRUE( lazyReader.ReadData3D( cScan, lazyHeader ) );
+      ASSERT_TRUE( fullReader.ReadData3D( cScan, fullHeader ) );
+
+      EXPECT_EQ( lazyHeader.guid, fullHeader.guid );
+      EXPECT_EQ( lazyHeader.name, fullHeader.name );
+      EXPECT_EQ( lazyHeader.pointCount, cNumPoints );
+
+      e57::Data3DPointsDouble pointsData( lazyHeader );
+
+      auto vectorReader = lazyReader.SetUpData3DPointsData( cScan, cNumPoints, pointsData );
+
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+      vectorReader.close();
+
+      EXPECT_EQ( pointsData.cartesianX[cNumPoints - 1],
+                 static_cast<double>( cNumPoints - 1 + cScan ) );
+      EXPECT_EQ( pointsData.cartesianZ[0], -static_cast<double>( cScan ) );
+   }
+
+   e57::Image2D image;
+   ASSERT_TRUE( lazyReader.ReadImage2D( 0, image ) );
+
+   EXPECT_EQ( image.name, "Image" );
+   EXPECT_EQ( image.sensorModel, "Model" );
+
+   // The lazily built tree is the same as the whole one
+   e57::ImageFile lazyFile( "./LazyXmlLoad.e57", "r", e57::ChecksumAll, e57::ReadBackendFile,
+                            e57::FileCacheNormal, e57::XmlLoadLazy );
+   e57::ImageFile fullFile( "./LazyXmlLoad.e57", "r" );
+
+   for ( const char *cPath : { "/data3D/1", "/data3D/2", "/images2D/0" } )
+   {
+      SCOPED_TRACE( cPath );
+
+      e57::StructureNode lazyNode( lazyFile.root().get( cPath ) );
+      e57::StructureNode fullNode( fullFile.root().get( cPath ) );
+
+      ASSERT_EQ( lazyNode.childCount(), fullNode.childCount() );
+
+      for ( int64_t i = 0; i < lazyNode.childCount(); ++i )
+      {
+         EXPECT_EQ( lazyNode.get( i ).elementName(), fullNode.get( i ).elementName() );
+         EXPECT_EQ( lazyNode.get( i ).type(), fullNode.get( i ).type() );
+      }
+   }
+
+   EXPECT_EQ( e57::StringNode( lazyFile.root().get( "/data3D/1/guid" ) ).value(),
+              "Lazy XML Scan 1" );
+   EXPECT_EQ( e57::StringNode( lazyFile.root().get( "/data3D/2/name" ) ).value(),
+              "Scan <2> & more" );
+}
+
+TEST( SimpleReader, ReadHeaders )
+{
+   {
+      e57::WriterOptions options;
+      options.guid = "Read Headers File GUID";
+
+      e57::Writer writer( "./ReadHeaders.e57", options );
+
+      for ( int scan = 0; scan < 3; ++scan )
+      {
+         e57::Data3D header;
+         header.guid = "Read Headers Scan " + std::to_string( scan );
+         header.pointCount = 10 * ( scan + 1 );
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+         header.pose.translation.x = static_cast<double>( scan );
+
+         e57::Data3DPointsFloat pointsData( header );
+
+         E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+      }
+
+      e57::Image2D image;
+      image.name = "Image";
+      image.sensorModel = "Model";
+
+      writer.NewImage2D( image );
+   }
+
+   const e57::FileHeaders cHeaders = e57::Reader::ReadHeaders( "./ReadHeaders.e57", {} );
+
+   EXPECT_EQ( cHeaders.root.guid, "Read Headers File GUID" );
+
+   ASSERT_EQ( cHeaders.data3D.size(), 3u );
+   ASSERT_EQ( cHeaders.images2D.size(), 1u );
+
+   e57::Reader reader( "./ReadHeaders.e57", {} );
+
+   for ( size_t i = 0; i < cHeaders.data3D.size(); ++i )
+   {
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( static_cast<int64_t>( i ), header ) );
+
+      EXPECT_EQ( cHeaders.data3D[i].guid, header.guid );
+      EXPECT_EQ( cHeaders.data3D[i].name, header.name );
+      EXPECT_EQ( cHeaders.data3D[i].pointCount, header.pointCount );
+      EXPECT_EQ( cHeaders.data3D[i].pose, header.pose );
+      EXPECT_EQ( cHeaders.data3D[i].pointFields.pointRangeMaximum,
+                 header.pointFields.pointRangeMaximum );
+   }
+
+   EXPECT_EQ( cHeaders.images2D[0].sensorModel, "Model" );
+}
+
+TEST( SimpleReader, ViewImage2DData )
+{
+   constexpr int64_t cImageSize = 5000; // spans several pages
+
+   std::vector<uint8_t> imageData( cImageSize );
+
+   for ( int64_t i = 0; i < cImageSize; ++i )
+   {
+      imageData[i] = static_cast<uint8_t>( i * 7 + i / 251 );
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "View Image File GUID";
+
+      e57::Writer writer( "./ViewImage2DData.e57", options );
+
+      e57::Image2D header;
+      header.guid = "View Image GUID";
+      header.visualReferenceRepresentation.imageWidth = 10;
+      header.visualReferenceRepresentation.imageHeight = 10;
+      header.visualReferenceRepresentation.pngImageSize = cImageSize;
+
+      writer.WriteImage2DData( header, e57::ImagePNG, e57::ProjectionVisual, 0,
+                               imageData.data(), cImageSize );
+   }
+
+   for ( const auto cBackend : { e57::ReadBackendFile, e57::ReadBackendMemoryMapped } )
+   {
+      SCOPED_TRACE( cBackend );
+
+      e57::ReaderOptions options;
+      options.readBackend = cBackend;
+
+      e57::Reader reader( "./ViewImage2DData.e57", options );
+
+      e57::BlobView view;
+
+      EXPECT_FALSE( reader.ViewImage2DData( 0, e57::ProjectionVisual, e57::ImageJPEG, view ) );
+      ASSERT_TRUE( reader.ViewImage2DData( 0, e57::ProjectionVisual, e57::ImagePNG, view ) );
+
+      ASSERT_EQ( view.byteCount(), cImageSize );
+
+      // Mapped pages are used in place, one segment per page
+      if ( cBackend == e57::ReadBackendMemoryMapped )
+      {
+         EXPECT_GT( view.segmentCount(), 4u );
+      }
+      else
+      {
+         EXPECT_EQ( view.segmentCount(), 1u );
+      }
+
+      std::vector<uint8_t> viewed;
+
+      for ( size_t i = 0; i < view.segmentCount(); ++i )
+      {
+         const uint8_t *data = view.segmentData( i );
+
+         viewed.insert( viewed.end(), data, data + view.segmentSize( i ) );
+      }
+
+      EXPECT_EQ( viewed, imageData );
+
+      reader.Close();
+
+      E57_ASSERT_THROW( view.segmentData( 0 ) );
+   }
+}
+
+TEST( SimpleReader, ReadImage2DDataParallel )
+{
+   constexpr int64_t cImageCount = 6;
+
+   std::vector<std::vector<uint8_t>> images( cImageCount );
+
+   for ( int64_t i = 0; i < cImageCount; ++i )
+   {
+      images[i].resize( static_cast<size_t>( 700 + 1500 * i ) );
+
+      for ( size_t j = 0; j < images[i].size(); ++j )
+      {
+         images[i][j] = static_cast<uint8_t>( j + 31 * i );
+      }
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Parallel Images File GUID";
+
+      e57::Writer writer( "./ReadImage2DDataParallel.e57", options );
+
+      for ( int64_t i = 0; i < cImageCount; ++i )
+      {
+         const auto cSize = static_cast<int64_t>( images[i].size() );
+
+         e57::Image2D header;
+         header.guid = "Parallel Image " + std::to_string( i );
+         header.pinholeRepresentation.imageWidth = 10;
+         header.pinholeRepresentation.imageHeight = 10;
+         header.pinholeRepresentation.jpegImageSize = cSize;
+         header.pinholeRepresentation.focalLength = 0.01;
+         header.pinholeRepresentation.pixelWidth = 0.001;
+         header.pinholeRepresentation.pixelHeight = 0.001;
+
+         writer.WriteImage2DData( header, e57::ImageJPEG, e57::ProjectionPinhole, 0,
+                                  images[i].data(), cSize );
+      }
+   }
+
+   e57::Reader reader( "./ReadImage2DDataParallel.e57", {} );
+
+   // Ask for them out of order, half into buffers & half through the callback
+   std::vector<std::vector<uint8_t>> buffers( cImageCount );
+   std::vector<e57::Image2DReadRequest> requests;
+
+   for ( const int64_t cIndex : { 4, 1, 5, 0, 3, 2 } )
+   {
+      e57::Image2DReadRequest request;
+      request.imageIndex = cIndex;
+      request.imageProjection = e57::ProjectionPinhole;
+
+      if ( cIndex % 2 == 0 )
+      {
+         buffers[cIndex].resize( images[cIndex].size() );
+         request.buffer = buffers[cIndex].data();
+      }
+
+      requests.push_back( request );
+   }
+
+   // Not in the file
+   e57::Image2DReadRequest missing;
+   missing.imageIndex = 0;
+   missing.imageProjection = e57::ProjectionSpherical;
+   requests.push_back( missing );
+
+   std::mutex mutex;
+   std::vector<std::vector<uint8_t>> received( requests.size() );
+
+   e57::ParallelReadOptions options;
+   options.threadCount = 3;
+
+   const auto cCounts = reader.ReadImage2DDataParallel(
+      requests,
+      [&]( size_t requestIndex, const uint8_t *data, size_t byteCount ) {
+         std::lock_guard<std::mutex> lock( mutex );
+
+         received[requestIndex].assign( data, data + byteCount );
+      },
+      options );
+
+   ASSERT_EQ( cCounts.size(), requests.size() );
+   EXPECT_EQ( cCounts.back(), 0 );
+
+   for ( size_t i = 0; i + 1 < requests.size(); ++i )
+   {
+      const int64_t cIndex = requests[i].imageIndex;
+
+      EXPECT_EQ( cCounts[i], static_cast<int64_t>( images[cIndex].size() ) );
+
+      if ( requests[i].buffer != nullptr )
+      {
+         EXPECT_EQ( buffers[cIndex], images[cIndex] );
+      }
+      else
+      {
+         EXPECT_EQ( received[i], images[cIndex] );
+      }
+   }
+}
+
+TEST( SimpleReader, Statistics )
+{
+   constexpr int64_t cNumPoints = 20000;
+
+   e57::CompressedVectorWriterStatistics writerStatistics;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Statistics File GUID";
+
+      e57::Writer writer( "./Statistics.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Statistics Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      const int64_t cScanIndex = writer.NewData3D( header );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( -i );
+         pointsData.cartesianZ[i] = static_cast<double>( i % 100 );
+      }
+
+      auto vectorWriter =
+         writer.SetUpData3DPointsData( cScanIndex, static_cast<size_t>( cNumPoints ), pointsData );
+
+      vectorWriter.write( static_cast<size_t>( cNumPoints ) );
+      vectorWriter.close();
+
+      // Still available once closed
+      writerStatistics = vectorWriter.statistics();
+
+      EXPECT_GT( writerStatistics.dataPacketCount, 0u );
+      EXPECT_GT( writerStatistics.indexPacketCount, 0u );
+      ASSERT_EQ( writerStatistics.bytestreams.size(), 3u );
+      EXPECT_EQ( writerStatistics.bytestreams[0].pathName, "cartesianX" );
+      EXPECT_EQ( writerStatistics.bytestreams[2].pathName, "cartesianZ" );
+
+      for ( const auto &bytestream : writerStatistics.bytestreams )
+      {
+         // Floats aren't compressed
+         EXPECT_EQ( bytestream.byteCount, static_cast<uint64_t>( cNumPoints ) * 4 );
+      }
+
+      EXPECT_GT( writer.GetRawIMF().statistics().pagesWritten, 0u );
+   }
+
+   e57::ReaderOptions options;
+   options.checksumPolicy = e57::ChecksumAll;
+
+   e57::Reader reader( "./Statistics.e57", options );
+
+   const e57::ImageFileStatistics cOpened = reader.GetRawIMF().statistics();
+
+   EXPECT_GT( cOpened.pagesRead, 0u );
+   EXPECT_EQ( cOpened.pagesWritten, 0u );
+   EXPECT_GT( cOpened.checksumsVerified, 0u );
+   EXPECT_GT( cOpened.xmlParseSeconds, 0.0 );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   // Read only some of the fields
+   header.pointFields.cartesianYField = false;
+
+   e57::Data3DPointsDouble points( header );
+   auto vectorReader =
+      reader.SetUpData3DPointsData( 0, static_cast<size_t>( cNumPoints ), points );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+   vectorReader.close();
+
+   const auto cReaderStatistics = vectorReader.statistics();
+
+   EXPECT_GT( cReaderStatistics.packetCacheMisses, 0u );
+   ASSERT_EQ( cReaderStatistics.bytestreams.size(), 2u );
+
+   for ( const auto &bytestream : cReaderStatistics.bytestreams )
+   {
+      EXPECT_EQ( bytestream.byteCount, writerStatistics.bytestreams[0].byteCount );
+      EXPECT_GT( bytestream.decodeSeconds, 0.0 );
+   }
+
+   EXPECT_EQ( cReaderStatistics.bytestreams[1].pathName, "cartesianZ" );
+
+   const e57::ImageFileStatistics cRead = reader.GetRawIMF().statistics();
+
+   EXPECT_GT( cRead.pagesRead, cOpened.pagesRead );
+   EXPECT_GT( cRead.checksumsVerified, cOpened.checksumsVerified );
+   EXPECT_GT( cRead.checksumSeconds, 0.0 );
+
+   // Reading the same data again verifies no more pages, and no page is verified twice
+   e57::Data3DPointsDouble pointsAgain( header );
+   auto vectorReaderAgain =
+      reader.SetUpData3DPointsData( 0, static_cast<size_t>( cNumPoints ), pointsAgain );
+
+   ASSERT_EQ( vectorReaderAgain.read(), static_cast<unsigned>( cNumPoints ) );
+
+   vectorReaderAgain.close();
+
+   const e57::ImageFileStatistics cReadAgain = reader.GetRawIMF().statistics();
+
+   EXPECT_GT( cReadAgain.pagesRead, cRead.pagesRead );
+   EXPECT_EQ( cReadAgain.checksumsVerified, cRead.checksumsVerified );
+
+   std::ifstream file( "./Statistics.e57", std::ios::binary | std::ios::ate );
+   const auto cFilePages = static_cast<uint64_t>( file.tellg() ) / 1024;
+
+   EXPECT_LE( cReadAgain.checksumsVerified, cFilePages );
+}
+
+TEST( SimpleReader, DeferredChecksums )
+{
+   constexpr int64_t cNumPoints = 20000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "DeferredChecksums File GUID";
+
+      e57::Writer writer( "./DeferredChecksums.e57", options );
+
+      e57::Data3D header;
+      header.guid = "DeferredChecksums Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      const int64_t cScanIndex = writer.NewData3D( header );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( -i );
+         pointsData.cartesianZ[i] = static_cast<double>( i % 100 );
+      }
+
+      auto vectorWriter =
+         writer.SetUpData3DPointsData( cScanIndex, static_cast<size_t>( cNumPoints ), pointsData );
+
+      vectorWriter.write( static_cast<size_t>( cNumPoints ) );
+      vectorWriter.close();
+   }
+
+   // Read all the points with the given verification, counting the checksum failures reported
+   // while reading & when closing
+   auto readAll = []( e57::ChecksumVerification verification, int &readFailures,
+                      int &closeFailures ) {
+      readFailures = 0;
+      closeFailures = 0;
+
+      e57::ReaderOptions options;
+      options.checksumVerification = verification;
+
+      e57::Reader reader( "./DeferredChecksums.e57", options );
+
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+      e57::Data3DPointsDouble points( header );
+      auto vectorReader = reader.SetUpData3DPointsData( 0, 1000, points );
+
+      try
+      {
+         while ( vectorReader.read() > 0 )
+         {
+         }
+      }
+      catch ( e57::E57Exception &err )
+      {
+         ASSERT_EQ( err.errorCode(), e57::ErrorBadChecksum );
+         ++readFailures;
+      }
+
+      vectorReader.close();
+
+      try
+      {
+         reader.Close();
+      }
+      catch ( e57::E57Exception &err )
+      {
+         ASSERT_EQ( err.errorCode(), e57::ErrorBadChecksum );
+         ++closeFailures;
+      }
+
+      EXPECT_FALSE( reader.IsOpen() );
+   };
+
+   int readFailures = 0;
+   int closeFailures = 0;
+
+   readAll( e57::ChecksumVerifyDeferred, readFailures, closeFailures );
+
+   EXPECT_EQ( readFailures + closeFailures, 0 );
+
+   // Corrupt a page in the middle of the points
+   {
+      std::fstream file( "./DeferredChecksums.e57",
+                         std::ios::binary | std::ios::in | std::ios::out );
+
+      file.seekp( 100 * 1024 + 10 );
+      file.put( 'X' );
+   }
+
+   readAll( e57::ChecksumVerifyInline, readFailures, closeFailures );
+
+   EXPECT_EQ( readFailures, 1 );
+   EXPECT_EQ( closeFailures, 0 );
+
+   readAll( e57::ChecksumVerifyDeferredUntilClose, readFailures, closeFailures );
+
+   EXPECT_EQ( readFailures, 0 );
+   EXPECT_EQ( closeFailures, 1 );
+
+   // Reported by a later read (unless the bad page was among the last ones read), and always when
+   // closing the file
+   readAll( e57::ChecksumVerifyDeferred, readFailures, closeFailures );
+
+   EXPECT_LE( readFailures, 1 );
+   EXPECT_EQ( closeFailures, 1 );
+}
+
+TEST( SimpleReader, VerifyFile )
+{
+   constexpr int64_t cNumPoints = 20000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "VerifyFile File GUID";
+
+      e57::Writer writer( "./VerifyFile.e57", options );
+
+      e57::Data3D header;
+      header.guid = "VerifyFile Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      const int64_t cScanIndex = writer.NewData3D( header );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = static_cast<double>( -i );
+         pointsData.cartesianZ[i] = static_cast<double>( i % 100 );
+      }
+
+      auto vectorWriter =
+         writer.SetUpData3DPointsData( cScanIndex, static_cast<size_t>( cNumPoints ), pointsData );
+
+      vectorWriter.write( static_cast<size_t>( cNumPoints ) );
+      vectorWriter.close();
+   }
+
+   uint64_t fileLength = 0;
+
+   {
+      std::ifstream file( "./VerifyFile.e57", std::ios::binary | std::ios::ate );
+      fileLength = static_cast<uint64_t>( file.tellg() );
+   }
+
+   e57::FileVerifyOptions options;
+   options.threadCount = 3;
+   options.blockPageCount = 7; // not a multiple of the page count
+
+   const auto cGood = e57::ImageFile::verifyFile( "./VerifyFile.e57", options );
+
+   EXPECT_EQ( cGood.pageCount, fileLength / 1024 );
+   EXPECT_TRUE( cGood.badPages.empty() );
+   EXPECT_FALSE( cGood.partialLastPage );
+   EXPECT_GT( cGood.bytesPerSecond, 0.0 );
+
+   // Corrupt two pages, one of them the last
+   {
+      std::fstream file( "./VerifyFile.e57", std::ios::binary | std::ios::in | std::ios::out );
+
+      file.seekp( 100 * 1024 + 10 );
+      file.put( 'X' );
+
+      file.seekp( static_cast<std::streamoff>( fileLength - 100 ) );
+      file.put( 'X' );
+   }
+
+   const auto cBad = e57::ImageFile::verifyFile( "./VerifyFile.e57", options );
+
+   const std::vector<uint64_t> cExpected = { 100, fileLength / 1024 - 1 };
+
+   EXPECT_EQ( cBad.badPages, cExpected );
+
+   // The same using an executor which runs the tasks one after another
+   options.executor = []( const std::vector<std::function<void()>> &tasks ) {
+      for ( const auto &task : tasks )
+      {
+         task();
+      }
+   };
+
+   EXPECT_EQ( e57::ImageFile::verifyFile( "./VerifyFile.e57", options ).badPages, cExpected );
+
+   try
+   {
+      e57::ImageFile::verifyFile( "./NoSuchFile.e57" );
+      FAIL() << "Expected ErrorOpenFailed";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorOpenFailed );
+   }
+}
+
+TEST( SimpleReader, TracingZones )
+{
+   if ( !e57::Tracing::available() )
+   {
+      GTEST_SKIP() << "Library built without E57_ENABLE_TRACING";
+   }
+
+   struct Zones
+   {
+      std::mutex mutex;
+      std::set<std::string> names;
+      int open = 0;
+   };
+
+   Zones zones;
+
+   e57::Tracing::Callbacks callbacks;
+   callbacks.userData = &zones;
+
+   callbacks.begin = []( const char *zoneName, void *userData ) -> void * {
+      auto *zonesPtr = static_cast<Zones *>( userData );
+
+      std::lock_guard<std::mutex> lock( zonesPtr->mutex );
+
+      zonesPtr->names.insert( zoneName );
+      ++zonesPtr->open;
+
+      return const_cast<char *>( zoneName );
+   };
+
+   callbacks.end = []( void *zone, void *userData ) {
+      auto *zonesPtr = static_cast<Zones *>( userData );
+
+      std::lock_guard<std::mutex> lock( zonesPtr->mutex );
+
+      EXPECT_TRUE( zonesPtr->names.count( static_cast<const char *>( zone ) ) == 1 );
+      --zonesPtr->open;
+   };
+
+   e57::Tracing::setCallbacks( callbacks );
+
+   constexpr int64_t cNumPoints = 1000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Tracing File GUID";
+
+      e57::Writer writer( "./TracingZones.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Tracing Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<float>( i );
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   }
+
+   {
+      e57::Reader reader( "./TracingZones.e57", {} );
+
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+      e57::Data3DPointsFloat points( header );
+      auto vectorReader =
+         reader.SetUpData3DPointsData( 0, static_cast<size_t>( cNumPoints ), points );
+
+      EXPECT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+      vectorReader.close();
+   }
+
+   e57::Tracing::setCallbacks();
+
+   EXPECT_EQ( zones.open, 0 );
+
+   for ( const char *name :
+         { "CheckedFile::readAt", "CheckedFile::write", "PacketReadCache::readPacketWithReadAhead",
+           "CompressedVectorReaderImpl::feedPacketToDecoders",
+           "CompressedVectorWriterImpl::packetWrite", "CompressedVectorWriterImpl::packetWriteIndex",
+           "ImageFileImpl::close" } )
+   {
+      EXPECT_EQ( zones.names.count( name ), 1u ) << name;
+   }
+
+   EXPECT_EQ( zones.names.count( "ImageFileImpl::parseXml" ) +
+                 zones.names.count( "ImageFileImpl::parseXmlLazy" ),
+              1u );
+}
+
+TEST( SimpleReader, AsyncReadAndClose )
+{
+   constexpr int64_t cNumPoints = 5000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Async File GUID";
+
+      e57::Writer writer( "./AsyncReadAndClose.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Async Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<float>( i );
+      }
+
+      writer.WriteData3DData( header, pointsData );
+
+      auto closed = writer.CloseAsync();
+
+      EXPECT_TRUE( closed.get() );
+      EXPECT_FALSE( writer.IsOpen() );
+   }
+
+   e57::Reader reader( "./AsyncReadAndClose.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   // Read in two blocks, the first with a future & the second with a completion
+   constexpr size_t cBlockSize = 3000;
+
+   e57::Data3DPointsFloat points( header );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cBlockSize, points );
+
+   EXPECT_EQ( vectorReader.readAsync().get(), cBlockSize );
+   EXPECT_EQ( points.cartesianX[cBlockSize - 1], static_cast<float>( cBlockSize - 1 ) );
+
+   std::promise<unsigned> done;
+
+   vectorReader.readAsync( [&done]( unsigned recordCount, std::exception_ptr error ) {
+      if ( error )
+      {
+         done.set_exception( error );
+      }
+      else
+      {
+         done.set_value( recordCount );
+      }
+   } );
+
+   EXPECT_EQ( done.get_future().get(), cNumPoints - cBlockSize );
+   EXPECT_EQ( points.cartesianX[cNumPoints - cBlockSize - 1],
+              static_cast<float>( cNumPoints - 1 ) );
+
+   vectorReader.close();
+
+   // Errors are passed on by the future
+   auto failed = vectorReader.readAsync();
+
+   try
+   {
+      failed.get();
+      FAIL() << "Expected ErrorReaderNotOpen";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorReaderNotOpen );
+   }
+}
+
+TEST( SimpleReader, MemoryStatistics )
+{
+   constexpr int64_t cNumPoints = 10000;
+
+   const e57::Memory::Statistics cBefore = e57::Memory::statistics();
+
+   e57::Memory::resetPeaks();
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Memory Statistics File GUID";
+
+      e57::Writer writer( "./MemoryStatistics.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Memory Statistics Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      EXPECT_GE( e57::Memory::statistics().pointBuffers.currentBytes,
+                 cBefore.pointBuffers.currentBytes + 3 * cNumPoints * sizeof( float ) );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<float>( i );
+      }
+
+      writer.WriteData3DData( header, pointsData );
+
+      EXPECT_GT( e57::Memory::statistics().nodes.currentBytes, cBefore.nodes.currentBytes );
+   }
+
+   auto stats = e57::Memory::statistics();
+
+   EXPECT_GT( stats.writers.peakBytes, 0u );
+   EXPECT_GT( stats.pointBuffers.peakBytes, 0u );
+   EXPECT_GE( stats.total.peakBytes, stats.writers.peakBytes + stats.pointBuffers.peakBytes );
+   EXPECT_EQ( stats.total.currentBytes, cBefore.total.currentBytes );
+
+   const auto readAll = [&]() {
+      e57::Reader reader( "./MemoryStatistics.e57", {} );
+
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+      e57::Data3DPointsFloat points( header );
+      auto vectorReader =
+         reader.SetUpData3DPointsData( 0, static_cast<size_t>( cNumPoints ), points );
+
+      const auto cOpen = e57::Memory::statistics();
+
+      EXPECT_GT( cOpen.packetCaches.currentBytes, cBefore.packetCaches.currentBytes );
+      EXPECT_GT( cOpen.decoders.currentBytes, cBefore.decoders.currentBytes );
+
+      EXPECT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+      EXPECT_EQ( points.cartesianX[cNumPoints - 1], static_cast<float>( cNumPoints - 1 ) );
+
+      vectorReader.close();
+   };
+
+   readAll();
+
+   EXPECT_EQ( e57::Memory::statistics().total.currentBytes, cBefore.total.currentBytes );
+
+   e57::Memory::resetPeaks();
+
+   stats = e57::Memory::statistics();
+
+   EXPECT_EQ( stats.total.peakBytes, stats.total.currentBytes );
+
+   // A budget much too small shrinks the caches, but reading still works
+   e57::Memory::setBudget( 1 );
+
+   EXPECT_EQ( e57::Memory::statistics().budget, 1u );
+
+   readAll();
+
+   EXPECT_GT( e57::Memory::statistics().budgetReductions, stats.budgetReductions );
+
+   e57::Memory::setBudget( 0 );
+}
+
+TEST( SimpleReader, ApplyPose )
+{
+   constexpr int64_t cNumPoints = 5000;
+
+   e57::Data3D header;
+   header.guid = "Apply Pose Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+
+   // Rotate a quarter turn about Z, then translate
+   header.pose.rotation.w = std::sqrt( 0.5 );
+   header.pose.rotation.z = std::sqrt( 0.5 );
+   header.pose.translation.x = 10.0;
+   header.pose.translation.y = 20.0;
+   header.pose.translation.z = 30.0;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Apply Pose File GUID";
+
+      e57::Writer writer( "./ApplyPose.e57", options );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i ) * 0.01;
+         pointsData.cartesianY[i] = -static_cast<double>( i % 100 );
+         pointsData.cartesianZ[i] = 0.5;
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   }
+
+   auto checkPoint = []( int64_t i, double x, double y, double z ) {
+      ASSERT_NEAR( x, static_cast<double>( i % 100 ) + 10.0, 1.0e-9 ) << "i=" << i;
+      ASSERT_NEAR( y, static_cast<double>( i ) * 0.01 + 20.0, 1.0e-9 ) << "i=" << i;
+      ASSERT_NEAR( z, 30.5, 1.0e-9 ) << "i=" << i;
+   };
+
+   e57::ReaderOptions options;
+   options.applyPose = true;
+
+   e57::Reader reader( "./ApplyPose.e57", options );
+
+   {
+      e57::Data3DPointsDouble pointsData( header );
+
+      auto vectorReader = reader.SetUpData3DPointsData( 0, 777, pointsData );
+
+      int64_t first = 0;
+
+      while ( const auto cCount = vectorReader.read() )
+      {
+         for ( int64_t i = 0; i < static_cast<int64_t>( cCount ); ++i )
+         {
+            checkPoint( first + i, pointsData.cartesianX[i], pointsData.cartesianY[i],
+                        pointsData.cartesianZ[i] );
+         }
+
+         first += cCount;
+      }
+
+      EXPECT_EQ( first, cNumPoints );
+
+      vectorReader.close();
+   }
+
+   {
+      struct Point
+      {
+         float xyz[3];
+      };
+
+      std::vector<Point> points( cNumPoints );
+
+      e57::Data3DPointsInterleaved buffers( sizeof( Point ) );
+      buffers.add( "cartesianX", &points[0].xyz[0] )
+         .add( "cartesianY", &points[0].xyz[1] )
+         .add( "cartesianZ", &points[0].xyz[2] );
+
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, buffers );
+
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+      vectorReader.close();
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         const auto &point = points[i];
+
+         ASSERT_NEAR( point.xyz[0], static_cast<double>( i % 100 ) + 10.0, 1.0e-4 );
+         ASSERT_NEAR( point.xyz[1], static_cast<double>( i ) * 0.01 + 20.0, 1.0e-4 );
+         ASSERT_NEAR( point.xyz[2], 30.5, 1.0e-4 );
+      }
+   }
+
+   // Both parallel paths: one scan split into chunks, and several scans read concurrently
+   for ( const unsigned threadCount : { 4u, 1u } )
+   {
+      SCOPED_TRACE( threadCount );
+
+      e57::Data3DPointsDouble first( header );
+      e57::Data3DPointsDouble second( header );
+
+      e57::ParallelReadOptions parallelOptions;
+      parallelOptions.threadCount = threadCount;
+
+      std::vector<int64_t> indices = { 0 };
+      std::vector<e57::Data3DPointsDouble *> buffers = { &first };
+
+      if ( threadCount == 1 )
+      {
+         indices.push_back( 0 );
+         buffers.push_back( &second );
+      }
+
+      const auto counts = reader.ReadData3DPointsDataParallel( indices, buffers, parallelOptions );
+
+      for ( size_t b = 0; b < buffers.size(); ++b )
+      {
+         ASSERT_EQ( counts[b], static_cast<uint64_t>( cNumPoints ) );
+
+         for ( int64_t i = 0; i < cNumPoints; ++i )
+         {
+            checkPoint( i, buffers[b]->cartesianX[i], buffers[b]->cartesianY[i],
+                        buffers[b]->cartesianZ[i] );
+         }
+      }
+   }
+
+   // Without the option, the points are as written
+   {
+      e57::Reader plainReader( "./ApplyPose.e57", {} );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      auto vectorReader = plainReader.SetUpData3DPointsData( 0, cNumPoints, pointsData );
+      vectorReader.read();
+      vectorReader.close();
+
+      EXPECT_EQ( pointsData.cartesianX[123], 1.23 );
+      EXPECT_EQ( pointsData.cartesianY[123], -23.0 );
+      EXPECT_EQ( pointsData.cartesianZ[123], 0.5 );
+   }
+
+   // Errors from the low level API
+   e57::ImageFile imf = reader.GetRawIMF();
+   e57::CompressedVectorNode points(
+      e57::StructureNode( reader.GetRawData3D().get( 0 ) ).get( "points" ) );
+
+   std::vector<double> x( 10 );
+   std::vector<double> y( 10 );
+   std::vector<int64_t> z( 10 );
+
+   {
+      std::vector<e57::SourceDestBuffer> destBuffers = {
+         { imf, "cartesianX", x.data(), x.size() },
+         { imf, "cartesianY", y.data(), y.size() },
+         { imf, "cartesianZ", z.data(), z.size(), true },
+      };
+
+      auto vectorReader = points.reader( destBuffers );
+
+      try
+      {
+         vectorReader.setCoordinateTransform( {} );
+         FAIL() << "Expected ErrorBadAPIArgument";
+      }
+      catch ( e57::E57Exception &err )
+      {
+         EXPECT_EQ( err.errorCode(), e57::ErrorBadAPIArgument );
+      }
+
+      vectorReader.close();
+   }
+
+   {
+      std::vector<e57::SourceDestBuffer> destBuffers = {
+         { imf, "cartesianX", x.data(), x.size() },
+         { imf, "cartesianY", y.data(), y.size() },
+      };
+
+      auto vectorReader = points.reader( destBuffers );
+
+      try
+      {
+         vectorReader.setCoordinateTransform( {} );
+         FAIL() << "Expected ErrorNoBufferForElement";
+      }
+      catch ( e57::E57Exception &err )
+      {
+         EXPECT_EQ( err.errorCode(), e57::ErrorNoBufferForElement );
+      }
+
+      vectorReader.close();
+   }
+}
+
+TEST( SimpleReader, SphericalToCartesian )
+{
+   constexpr int64_t cNumPoints = 3000;
+
+   e57::Data3D header;
+   header.guid = "Spherical To Cartesian Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.sphericalRangeField = true;
+   header.pointFields.sphericalAzimuthField = true;
+   header.pointFields.sphericalElevationField = true;
+   header.pose.translation.z = 2.0;
+
+   std::vector<double> range( cNumPoints );
+   std::vector<double> azimuth( cNumPoints );
+   std::vector<double> elevation( cNumPoints );
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Spherical To Cartesian File GUID";
+
+      e57::Writer writer( "./SphericalToCartesian.e57", options );
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         range[i] = 1.0 + static_cast<double>( i % 50 );
+         azimuth[i] = -3.0 + static_cast<double>( i ) * 0.002;
+         elevation[i] = -1.5 + static_cast<double>( i % 300 ) * 0.01;
+
+         pointsData.sphericalRange[i] = range[i];
+         pointsData.sphericalAzimuth[i] = azimuth[i];
+         pointsData.sphericalElevation[i] = elevation[i];
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   }
+
+   auto checkPoints = [&]( const e57::Data3DPointsDouble &pointsData, double zOffset ) {
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         const double cRadial = range[i] * std::cos( elevation[i] );
+
+         ASSERT_NEAR( pointsData.cartesianX[i], cRadial * std::cos( azimuth[i] ), 1.0e-9 );
+         ASSERT_NEAR( pointsData.cartesianY[i], cRadial * std::sin( azimuth[i] ), 1.0e-9 );
+         ASSERT_NEAR( pointsData.cartesianZ[i], range[i] * std::sin( elevation[i] ) + zOffset,
+                      1.0e-9 );
+      }
+   };
+
+   // Without the pose
+   {
+      e57::ReaderOptions options;
+      options.sphericalToCartesian = true;
+
+      e57::Reader reader( "./SphericalToCartesian.e57", options );
+
+      e57::Data3D readHeader;
+      ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+      EXPECT_TRUE( readHeader.pointFields.cartesianXField );
+      EXPECT_TRUE( readHeader.pointFields.cartesianYField );
+      EXPECT_TRUE( readHeader.pointFields.cartesianZField );
+      EXPECT_TRUE( readHeader.pointFields.sphericalRangeField );
+
+      e57::Data3DPointsDouble pointsData( readHeader );
+
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, pointsData );
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+      vectorReader.close();
+
+      checkPoints( pointsData, 0.0 );
+   }
+
+   // Combined with the pose, in both read paths
+   e57::ReaderOptions options;
+   options.sphericalToCartesian = true;
+   options.applyPose = true;
+
+   e57::Reader reader( "./SphericalToCartesian.e57", options );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+   {
+      e57::Data3DPointsDouble pointsData( readHeader );
+
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, pointsData );
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+      vectorReader.close();
+
+      checkPoints( pointsData, 2.0 );
+   }
+
+   {
+      e57::Data3DPointsDouble pointsData( readHeader );
+
+      e57::ParallelReadOptions parallelOptions;
+      parallelOptions.threadCount = 4;
+
+      const auto counts =
+         reader.ReadData3DPointsDataParallel( { 0 }, { &pointsData }, parallelOptions );
+
+      ASSERT_EQ( counts[0], static_cast<uint64_t>( cNumPoints ) );
+
+      checkPoints( pointsData, 2.0 );
+   }
+
+   // Without the option, the cartesian fields aren't reported
+   e57::Reader plainReader( "./SphericalToCartesian.e57", {} );
+
+   ASSERT_TRUE( plainReader.ReadData3D( 0, readHeader ) );
+
+   EXPECT_FALSE( readHeader.pointFields.cartesianXField );
+}
+
+TEST( SimpleReader, Data3DPointsStream )
+{
+   constexpr int64_t cNumPoints = 100003; // not a multiple of the block size
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Stream File GUID";
+
+      e57::Writer writer( "./Stream.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Stream Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.colorRedField = true;
+
+      header.colorLimits.colorRedMaximum = 255;
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<float>( i );
+         pointsData.cartesianY[i] = static_cast<float>( i % 100 );
+         pointsData.cartesianZ[i] = static_cast<float>( -i );
+         pointsData.colorRed[i] = static_cast<uint16_t>( i % 256 );
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::Reader reader( "./Stream.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   // Only read the coordinates
+   header.pointFields.colorRedField = false;
+
+   e57::Data3DStreamOptions options;
+   options.blockPointCount = 4096;
+   options.bufferCount = 2;
+
+   e57::Data3DPointsStreamFloat stream( reader, 0, header, options );
+
+   EXPECT_EQ( stream.block().colorRed, nullptr );
+
+   const e57::Data3DPointsFloat *previous = nullptr;
+   int64_t first = 0;
+
+   while ( const size_t count = stream.next() )
+   {
+      const auto &block = stream.block();
+
+      ASSERT_EQ( count, static_cast<size_t>( std::min<int64_t>( 4096, cNumPoints - first ) ) );
+
+      // The buffer sets alternate
+      ASSERT_NE( &block, previous );
+      previous = &block;
+
+      for ( size_t i = 0; i < count; ++i )
+      {
+         const int64_t cRecord = first + static_cast<int64_t>( i );
+
+         ASSERT_EQ( block.cartesianX[i], static_cast<float>( cRecord ) );
+         ASSERT_EQ( block.cartesianY[i], static_cast<float>( cRecord % 100 ) );
+         ASSERT_EQ( block.cartesianZ[i], static_cast<float>( -cRecord ) );
+      }
+
+      first += static_cast<int64_t>( count );
+   }
+
+   EXPECT_EQ( first, cNumPoints );
+   EXPECT_EQ( stream.pointsRead(), static_cast<uint64_t>( cNumPoints ) );
+
+   // Reading past the end and closing twice are harmless
+   EXPECT_EQ( stream.next(), 0u );
+
+   stream.close();
+   stream.close();
+   EXPECT_EQ( stream.next(), 0u );
+
+   // Streams can be moved
+   options.blockPointCount = cNumPoints;
+   options.bufferCount = 1;
+
+   e57::Data3DPointsStreamDouble doubleStream( reader, 0, header, options );
+   e57::Data3DPointsStreamDouble moved( std::move( doubleStream ) );
+
+   EXPECT_EQ( moved.next(), static_cast<size_t>( cNumPoints ) );
+   EXPECT_EQ( moved.block().cartesianX[cNumPoints - 1], static_cast<double>( cNumPoints - 1 ) );
+   EXPECT_EQ( moved.next(), 0u );
+
+   options.blockPointCount = 0;
+   E57_ASSERT_THROW( e57::Data3DPointsStreamFloat( reader, 0, header, options ) );
+
+   options.blockPointCount = 10;
+   options.bufferCount = 0;
+   E57_ASSERT_THROW( e57::Data3DPointsStreamFloat( reader, 0, header, options ) );
+
+   options.bufferCount = 1;
+   E57_ASSERT_THROW( e57::Data3DPointsStreamFloat( reader, 1, header, options ) );
+}
+
+TEST( SimpleReader, QuantizedFields )
+{
+   constexpr int64_t cNumPoints = 5000;
+
+   e57::Data3D header;
+   header.guid = "Quantized Fields Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+   header.pointFields.pointRangeScale = 0.001;
+   header.pointFields.pointRangeMinimum = -30.0;
+   header.pointFields.pointRangeMaximum = 30.0;
+   header.pointFields.timeStampField = true;
+   header.pointFields.timeNodeType = e57::NumericalNodeType::ScaledInteger;
+   header.pointFields.timeScale = 0.01;
+   header.pointFields.timeMinimum = 0.0;
+   header.pointFields.timeMaximum = 100.0;
+   header.pointFields.intensityField = true;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      pointsData.cartesianX[i] = static_cast<double>( i % 60000 ) * 0.001 - 30.0;
+      pointsData.cartesianY[i] = static_cast<double>( i ) * 0.002;
+      pointsData.cartesianZ[i] = -1.5;
+      pointsData.timeStamp[i] = static_cast<double>( i ) * 0.01;
+      pointsData.intensity[i] = static_cast<double>( i % 10 ) * 0.1;
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Quantized Fields File GUID";
+
+      e57::Writer writer( "./QuantizedFields.e57", options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::Reader reader( "./QuantizedFields.e57", {} );
+
+   // The float intensity isn't quantized
+   const std::vector<e57::QuantizedField> cFields = reader.ReadData3DQuantizedFields( 0 );
+
+   ASSERT_EQ( cFields.size(), 4u );
+   EXPECT_EQ( cFields[0].pathName, "cartesianX" );
+   EXPECT_EQ( cFields[0].representation, e57::Int16 );
+   EXPECT_EQ( cFields[0].minimum, -30000 );
+   EXPECT_EQ( cFields[0].maximum, 30000 );
+   EXPECT_EQ( cFields[0].scale, 0.001 );
+   EXPECT_EQ( cFields[3].pathName, "timeStamp" );
+   EXPECT_EQ( cFields[3].representation, e57::UInt16 );
 
-#include "Helpers.h"
-#include "TestData.h"
+   EXPECT_TRUE( reader.ReadData3DQuantizedFields( 1 ).empty() );
 
-namespace
+   // The raw integers, each field in an array of its own
+   std::vector<int16_t> x( cNumPoints );
+   std::vector<int16_t> y( cNumPoints );
+   std::vector<int16_t> z( cNumPoints );
+   std::vector<uint16_t> time( cNumPoints );
+   std::vector<float> intensity( cNumPoints );
+
+   e57::Data3DPointsInterleaved buffers( sizeof( float ) );
+   buffers.addRaw( "cartesianX", x.data(), sizeof( int16_t ) )
+      .addRaw( "cartesianY", y.data(), sizeof( int16_t ) )
+      .addRaw( "cartesianZ", z.data(), sizeof( int16_t ) )
+      .addRaw( "timeStamp", time.data(), sizeof( uint16_t ) )
+      .addRaw( "intensity", intensity.data() );
+
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, buffers );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+   vectorReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_NEAR( x[i] * cFields[0].scale + cFields[0].offset, pointsData.cartesianX[i], 1.0e-9 );
+      ASSERT_NEAR( y[i] * cFields[1].scale + cFields[1].offset, pointsData.cartesianY[i], 1.0e-9 );
+      ASSERT_EQ( z[i], -1500 );
+      ASSERT_NEAR( time[i] * cFields[3].scale + cFields[3].offset, pointsData.timeStamp[i],
+                   1.0e-9 );
+
+      // Fields which aren't ScaledIntegers are read as usual
+      ASSERT_NEAR( intensity[i], static_cast<double>( i % 10 ) * 0.1, 1.0e-6 );
+   }
+}
+
+TEST( SimpleReader, TrustedInput )
 {
-   void CheckFileHeader( const e57::E57Root &fileHeader )
+   constexpr int64_t cNumPoints = 10000;
+
+   e57::Data3D header;
+   header.guid = "Trusted Input Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+   header.pointFields.pointRangeScale = 0.001;
+   header.pointFields.pointRangeMinimum = -30.0;
+   header.pointFields.pointRangeMaximum = 30.0;
+   header.pointFields.intensityField = true;
+   header.pointFields.intensityNodeType = e57::NumericalNodeType::Integer;
+   header.intensityLimits.intensityMinimum = 0.0;
+   header.intensityLimits.intensityMaximum = 4095.0;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
    {
-      // These are invariant.
-      // See ASTM Standard Table 12.
+      pointsData.cartesianX[i] = static_cast<double>( i ) * 0.003 - 30.0;
+      pointsData.cartesianY[i] = static_cast<double>( i % 1000 ) * 0.001;
+      pointsData.cartesianZ[i] = -static_cast<double>( i % 77 ) * 0.01;
+      pointsData.intensity[i] = static_cast<double>( i % 4096 );
+   }
 
-      EXPECT_EQ( fileHeader.formatName, "ASTM E57 3D Imaging Data File" );
-      EXPECT_EQ( fileHeader.versionMajor, 1 );
-      EXPECT_EQ( fileHeader.versionMinor, 0 );
+   {
+      e57::WriterOptions options;
+      options.guid = "Trusted Input File GUID";
+
+      e57::Writer writer( "./TrustedInput.e57", options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::ReaderOptions options;
+   options.trustedInput = true;
+
+   e57::Reader reader( "./TrustedInput.e57", options );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+   // Floats & doubles hold every value, so none of them is checked
+   e57::Data3DPointsFloat floatData( readHeader );
+   auto floatReader = reader.SetUpData3DPointsData( 0, cNumPoints, floatData );
+
+   ASSERT_EQ( floatReader.read(), static_cast<unsigned>( cNumPoints ) );
+   floatReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_FLOAT_EQ( floatData.cartesianX[i], static_cast<float>( pointsData.cartesianX[i] ) );
+      ASSERT_FLOAT_EQ( floatData.cartesianZ[i], static_cast<float>( pointsData.cartesianZ[i] ) );
+      ASSERT_EQ( floatData.intensity[i], static_cast<float>( i % 4096 ) );
+   }
+
+   // 0 to 4095 fits a uint16_t, so the intensities are read as they are
+   std::vector<uint16_t> intensities( cNumPoints );
+
+   e57::Data3DPointsInterleaved wideBuffers( sizeof( uint16_t ) );
+   wideBuffers.add( "intensity", intensities.data() );
+
+   auto wideReader = reader.SetUpData3DPointsData( 0, cNumPoints, wideBuffers );
+
+   ASSERT_EQ( wideReader.read(), static_cast<unsigned>( cNumPoints ) );
+   wideReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_EQ( intensities[i], i % 4096 );
+   }
+
+   // It doesn't fit a uint8_t, so those values are still checked
+   std::vector<uint8_t> narrowIntensities( cNumPoints );
+
+   e57::Data3DPointsInterleaved narrowBuffers( sizeof( uint8_t ) );
+   narrowBuffers.add( "intensity", narrowIntensities.data() );
+
+   auto narrowReader = reader.SetUpData3DPointsData( 0, cNumPoints, narrowBuffers );
+
+   try
+   {
+      narrowReader.read();
+      FAIL() << "Expected ErrorValueNotRepresentable";
    }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorValueNotRepresentable );
+   }
+
+   narrowReader.close();
 }
 
-TEST( SimpleReader, PathError )
+TEST( SimpleReader, ValidPointsOnly )
 {
-   E57_ASSERT_THROW( e57::Reader( "./no-path/empty.e57", {} ) );
+   constexpr int64_t cNumPoints = 30000;
+
+   e57::Data3D header;
+   header.guid = "Valid Points Only Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.cartesianInvalidStateField = true;
+   header.pointFields.intensityField = true;
+   header.pointFields.isIntensityInvalidField = true;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   // About a third of the points have no return, and some others no intensity
+   auto isValid = []( int64_t i ) { return ( i % 3 != 0 ) && ( i % 7 != 0 ); };
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      pointsData.cartesianX[i] = static_cast<double>( i );
+      pointsData.cartesianY[i] = static_cast<double>( i ) * 0.5;
+      pointsData.cartesianZ[i] = -static_cast<double>( i );
+      pointsData.cartesianInvalidState[i] = ( i % 3 == 0 ) ? 2 : 0;
+      pointsData.intensity[i] = static_cast<double>( i % 10 ) * 0.1;
+      pointsData.isIntensityInvalid[i] = ( i % 7 == 0 ) ? 1 : 0;
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Valid Points Only File GUID";
+
+      e57::Writer writer( "./ValidPointsOnly.e57", options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   int64_t validCount = 0;
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      validCount += isValid( i ) ? 1 : 0;
+   }
+
+   e57::ReaderOptions options;
+   options.validPointsOnly = true;
+
+   e57::Reader reader( "./ValidPointsOnly.e57", options );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+   // Read in small blocks, so the space of the points dropped is filled from the next packets
+   constexpr size_t cBlockSize = 1000;
+
+   readHeader.pointCount = cBlockSize;
+
+   e57::Data3DPointsDouble readData( readHeader );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cBlockSize, readData );
+
+   int64_t expected = 0;
+   int64_t readCount = 0;
+
+   while ( const unsigned cRead = vectorReader.read() )
+   {
+      // Each block is full but the last one
+      if ( readCount + static_cast<int64_t>( cBlockSize ) <= validCount )
+      {
+         ASSERT_EQ( cRead, cBlockSize );
+      }
+
+      for ( unsigned i = 0; i < cRead; ++i )
+      {
+         while ( !isValid( expected ) )
+         {
+            ++expected;
+         }
+
+         ASSERT_EQ( readData.cartesianX[i], static_cast<double>( expected ) );
+         ASSERT_EQ( readData.cartesianY[i], static_cast<double>( expected ) * 0.5 );
+         ASSERT_EQ( readData.cartesianInvalidState[i], 0 );
+         ASSERT_EQ( readData.isIntensityInvalid[i], 0 );
+
+         ++expected;
+      }
+
+      readCount += cRead;
+   }
+
+   vectorReader.close();
+
+   EXPECT_EQ( readCount, validCount );
+
+   // The core API has the same filter
+   e57::Reader allReader( "./ValidPointsOnly.e57", {} );
+
+   const e57::StructureNode cScan( allReader.GetRawData3D().get( 0 ) );
+   e57::CompressedVectorNode points( cScan.get( "points" ) );
+
+   std::vector<int8_t> invalidStates( cNumPoints );
+
+   std::vector<e57::SourceDestBuffer> buffers;
+   buffers.emplace_back( allReader.GetRawIMF(), "cartesianInvalidState", invalidStates.data(),
+                         cNumPoints, true );
+
+   auto coreReader = points.reader( buffers );
+
+   e57::RecordFilter filter;
+   filter.invalidStateFields.push_back( "cartesianInvalidState" );
+
+   coreReader.setRecordFilter( filter );
+
+   EXPECT_EQ( coreReader.read(), static_cast<unsigned>( cNumPoints - cNumPoints / 3 ) );
+
+   // Fields which aren't read can't be tested
+   filter.invalidStateFields.push_back( "isIntensityInvalid" );
+
+   E57_ASSERT_THROW( coreReader.setRecordFilter( filter ) );
+
+   coreReader.close();
+}
+
+TEST( SimpleReader, RecordFilterSeek )
+{
+   constexpr int64_t cNumPoints = 100000;
+
+   e57::Data3D header;
+   header.guid = "Record Filter Seek Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.cartesianInvalidStateField = true;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   auto isValid = []( int64_t i ) { return i % 3 != 0; };
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      pointsData.cartesianX[i] = static_cast<double>( i ) * 0.001;
+      pointsData.cartesianY[i] = 0.0;
+      pointsData.cartesianZ[i] = 0.0;
+      pointsData.cartesianInvalidState[i] = isValid( i ) ? 0 : 2;
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Record Filter Seek File GUID";
+      options.compressedVectorWriter.chunkStatistics = true;
+      options.compressedVectorWriter.indexPacketInterval = 1;
+
+      e57::Writer writer( "./RecordFilterSeek.e57", options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::Reader reader( "./RecordFilterSeek.e57", {} );
+
+   const e57::StructureNode cScan( reader.GetRawData3D().get( 0 ) );
+   e57::CompressedVectorNode points( cScan.get( "points" ) );
+
+   // Small buffers, so the records skipped by a seek take several batches
+   constexpr size_t cBlockSize = 256;
+
+   std::vector<double> x( cBlockSize );
+   std::vector<int8_t> invalidStates( cBlockSize );
+
+   std::vector<e57::SourceDestBuffer> buffers;
+   buffers.emplace_back( reader.GetRawIMF(), "cartesianX", x.data(), cBlockSize, true );
+   buffers.emplace_back( reader.GetRawIMF(), "cartesianInvalidState", invalidStates.data(),
+                         cBlockSize, true );
+
+   // Reads the next block & checks it holds the records the filter passes from @a first on
+   auto expectRecords = [&]( e57::CompressedVectorReader &vectorReader, int64_t first,
+                             int64_t end, const std::function<bool( int64_t )> &passes ) {
+      const unsigned cRead = vectorReader.read();
+
+      int64_t expected = first;
+
+      for ( unsigned i = 0; i < cRead; ++i )
+      {
+         while ( !passes( expected ) )
+         {
+            ++expected;
+         }
+
+         ASSERT_LT( expected, end );
+         ASSERT_NEAR( x[i], pointsData.cartesianX[expected], 1.0e-9 );
+         ASSERT_EQ( invalidStates[i], 0 );
+
+         ++expected;
+      }
+
+      ASSERT_GT( cRead, 0u );
+   };
+
+   // Records dropped by the filter while skipping to the record sought are still skipped
+   {
+      auto vectorReader = points.reader( buffers );
+
+      e57::RecordFilter filter;
+      filter.invalidStateFields.push_back( "cartesianInvalidState" );
+
+      vectorReader.setRecordFilter( filter );
+
+      vectorReader.seek( 1000 );
+      expectRecords( vectorReader, 1000, cNumPoints, isValid );
+
+      vectorReader.seek( 54321 );
+      expectRecords( vectorReader, 54321, cNumPoints, isValid );
+
+      vectorReader.setRecordRange( 70001, 2000 );
+      expectRecords( vectorReader, 70001, 72001, isValid );
+
+      vectorReader.close();
+   }
+
+   // With ranges & chunk statistics the filter jumps over chunks, but not while seeking
+   {
+      auto vectorReader = points.reader( buffers );
+
+      e57::RecordFilter filter;
+      filter.invalidStateFields.push_back( "cartesianInvalidState" );
+      filter.ranges = { { "cartesianX", 50.0, 60.0 } };
+
+      auto passes = [&]( int64_t i ) {
+         return isValid( i ) && ( pointsData.cartesianX[i] >= 50.0 ) &&
+                ( pointsData.cartesianX[i] <= 60.0 );
+      };
+
+      vectorReader.setRecordFilter( filter );
+
+      vectorReader.seek( 55000 );
+      expectRecords( vectorReader, 55000, cNumPoints, passes );
+
+      vectorReader.setRecordRange( 52000, 30000 );
+      expectRecords( vectorReader, 52000, 82000, passes );
+
+      vectorReader.close();
+   }
+}
+
+TEST( SimpleReader, RecordFilterRanges )
+{
+   constexpr int64_t cNumPoints = 200000;
+
+   e57::Data3D header;
+   header.guid = "Record Filter Ranges Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+   header.pointFields.pointRangeScale = 0.001;
+   header.pointFields.pointRangeMinimum = -1000.0;
+   header.pointFields.pointRangeMaximum = 1000.0;
+   header.pointFields.intensityField = true;
+   header.intensityLimits.intensityMaximum = 1.0;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      pointsData.cartesianX[i] = static_cast<double>( i ) * 0.001;
+      pointsData.cartesianY[i] = -0.5;
+      pointsData.cartesianZ[i] = static_cast<double>( i % 100 ) * 0.01;
+      pointsData.intensity[i] = static_cast<double>( i % 10 ) * 0.1;
+   }
+
+   auto writeFile = [&]( const char *fileName, bool chunkStatistics ) {
+      e57::WriterOptions options;
+      options.guid = "Record Filter Ranges File GUID";
+      options.compressedVectorWriter.chunkStatistics = chunkStatistics;
+      options.compressedVectorWriter.indexPacketInterval = 1;
+
+      e57::Writer writer( fileName, options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   };
+
+   writeFile( "./RecordFilterRanges.e57", true );
+   writeFile( "./RecordFilterRangesNone.e57", false );
+
+   // x from 50 to 60 m, with an intensity up to 0.5
+   e57::RecordFilter filter;
+   filter.ranges = { { "cartesianX", 50.0, 60.0 }, { "intensity", -1.0, 0.5 } };
+
+   auto passes = [&pointsData]( int64_t i ) {
+      return ( pointsData.cartesianX[i] >= 50.0 ) && ( pointsData.cartesianX[i] <= 60.0 ) &&
+             ( pointsData.intensity[i] <= 0.5 );
+   };
+
+   auto readFiltered = [&]( const char *fileName, uint64_t &packetsRead ) {
+      e57::Reader reader( fileName, {} );
+
+      e57::Data3D readHeader;
+      ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+      constexpr size_t cBlockSize = 1000;
+
+      readHeader.pointCount = cBlockSize;
+
+      e57::Data3DPointsDouble readData( readHeader );
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cBlockSize, readData );
+
+      vectorReader.setRecordFilter( filter );
+
+      int64_t expected = 0;
+
+      while ( const unsigned cRead = vectorReader.read() )
+      {
+         for ( unsigned i = 0; i < cRead; ++i )
+         {
+            while ( !passes( expected ) )
+            {
+               ++expected;
+            }
+
+            ASSERT_NEAR( readData.cartesianX[i], pointsData.cartesianX[expected], 1.0e-9 );
+            ASSERT_FLOAT_EQ( static_cast<float>( readData.intensity[i] ),
+                             static_cast<float>( pointsData.intensity[expected] ) );
+
+            ++expected;
+         }
+      }
+
+      for ( ; expected < cNumPoints; ++expected )
+      {
+         ASSERT_FALSE( passes( expected ) );
+      }
+
+      packetsRead = vectorReader.statistics().packetCacheMisses;
+
+      vectorReader.close();
+   };
+
+   uint64_t packetsRead = 0;
+   uint64_t allPacketsRead = 0;
+
+   readFiltered( "./RecordFilterRanges.e57", packetsRead );
+   readFiltered( "./RecordFilterRangesNone.e57", allPacketsRead );
+
+   // With the statistics, only the chunks near 50 to 60 m are read
+   EXPECT_LT( packetsRead * 4, allPacketsRead );
+
+   // The raw integers of a scaled integer field are tested against the scaled limits
+   e57::Reader reader( "./RecordFilterRanges.e57", {} );
+
+   const e57::StructureNode cScan( reader.GetRawData3D().get( 0 ) );
+   e57::CompressedVectorNode points( cScan.get( "points" ) );
+
+   std::vector<int32_t> rawX( cNumPoints );
+
+   std::vector<e57::SourceDestBuffer> buffers;
+   buffers.emplace_back( reader.GetRawIMF(), "cartesianX", rawX.data(), cNumPoints, true, false );
+
+   auto rawReader = points.reader( buffers );
+
+   e57::RecordFilter rawFilter;
+   rawFilter.ranges = { { "cartesianX", 10.0, 10.5 } };
+
+   rawReader.setRecordFilter( rawFilter );
+
+   ASSERT_EQ( rawReader.read(), 501u );
+   EXPECT_EQ( rawX[0], 10000 );
+   EXPECT_EQ( rawX[500], 10500 );
+
+   // The fields of the ranges must be read
+   rawFilter.ranges.push_back( { "intensity", 0.0, 0.5 } );
+
+   E57_ASSERT_THROW( rawReader.setRecordFilter( rawFilter ) );
+
+   rawReader.close();
+}
+
+TEST( SimpleReader, NormalizedIntensityColour )
+{
+   constexpr int64_t cNumPoints = 5000;
+
+   e57::Data3D header;
+   header.guid = "Normalized Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.intensityField = true;
+   header.pointFields.intensityNodeType = e57::NumericalNodeType::ScaledInteger;
+   header.pointFields.intensityScale = 0.5;
+   header.intensityLimits.intensityMinimum = 0.0;
+   header.intensityLimits.intensityMaximum = 2047.5;
+   header.pointFields.colorRedField = true;
+   header.pointFields.colorGreenField = true;
+   header.pointFields.colorBlueField = true;
+   header.colorLimits.colorRedMaximum = 255.0;
+   header.colorLimits.colorGreenMaximum = 255.0;
+   header.colorLimits.colorBlueMaximum = 1023.0;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      pointsData.cartesianX[i] = static_cast<double>( i );
+      pointsData.cartesianY[i] = 0.0;
+      pointsData.cartesianZ[i] = 0.0;
+      pointsData.intensity[i] = static_cast<double>( i % 4096 ) * 0.5;
+      pointsData.colorRed[i] = static_cast<uint16_t>( i % 256 );
+      pointsData.colorGreen[i] = static_cast<uint16_t>( 255 - i % 256 );
+      pointsData.colorBlue[i] = static_cast<uint16_t>( i % 1024 );
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Normalized File GUID";
+
+      e57::Writer writer( "./NormalizedIntensityColour.e57", options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   struct Point
+   {
+      float x;
+      float intensity;
+      uint8_t rgba[4];
+   };
+
+   e57::Reader reader( "./NormalizedIntensityColour.e57", {} );
+
+   std::vector<Point> points( cNumPoints, Point{ 0.0f, 0.0f, { 0, 0, 0, 0xAB } } );
+
+   e57::Data3DPointsInterleaved buffers( sizeof( Point ) );
+   buffers.add( "cartesianX", &points[0].x )
+      .addNormalized( "intensity", &points[0].intensity )
+      .addNormalizedColor( points[0].rgba );
+
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, buffers );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+   vectorReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      const Point &cPoint = points[static_cast<size_t>( i )];
+      const auto cBlue = static_cast<uint8_t>( floor( ( i % 1024 ) * 255.0 / 1023.0 + 0.5 ) );
+
+      ASSERT_EQ( cPoint.x, static_cast<float>( i ) );
+      ASSERT_FLOAT_EQ( cPoint.intensity, static_cast<float>( ( i % 4096 ) / 4095.0 ) );
+      ASSERT_EQ( cPoint.rgba[0], i % 256 );
+      ASSERT_EQ( cPoint.rgba[1], 255 - i % 256 );
+      ASSERT_EQ( cPoint.rgba[2], cBlue );
+      ASSERT_EQ( cPoint.rgba[3], 0xAB );
+   }
+
+   // Full range of a uint16_t, in an array of its own
+   std::vector<float> x( cNumPoints );
+   std::vector<uint16_t> intensity( cNumPoints );
+
+   e57::Data3DPointsInterleaved arrays( sizeof( float ) );
+   arrays.add( "cartesianX", x.data() )
+      .addNormalized( "intensity", intensity.data(), sizeof( uint16_t ) );
+
+   vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, arrays );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+   vectorReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      const auto cExpected =
+         static_cast<uint16_t>( floor( ( i % 4096 ) * 65535.0 / 4095.0 + 0.5 ) );
+
+      ASSERT_EQ( intensity[static_cast<size_t>( i )], cExpected );
+   }
+
+   // Only intensities & colours have limits to normalize with
+   e57::Data3DPointsInterleaved coordinates( sizeof( float ) );
+   coordinates.addNormalized( "cartesianX", x.data() );
+
+   try
+   {
+      reader.SetUpData3DPointsData( 0, cNumPoints, coordinates );
+
+      FAIL() << "Expected ErrorBadAPIArgument";
+   }
+   catch ( const e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorBadAPIArgument );
+   }
+}
+
+TEST( SimpleReader, HalfFloatSignedNormals )
+{
+   constexpr int64_t cNumPoints = 3000;
+
+   e57::Data3D header;
+   header.guid = "Half Float Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.intensityField = true;
+   header.intensityLimits.intensityMaximum = 1.0;
+   header.pointFields.normalXField = true;
+   header.pointFields.normalYField = true;
+   header.pointFields.normalZField = true;
+
+   e57::Data3DPointsFloat pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      const float cAngle = static_cast<float>( i ) * 0.01f;
+
+      pointsData.cartesianX[i] = static_cast<float>( i ) * 0.25f;
+      pointsData.cartesianY[i] = -static_cast<float>( i );
+      pointsData.cartesianZ[i] = 0.0f;
+      pointsData.intensity[i] = static_cast<float>( i % 100 ) / 100.0f;
+      pointsData.normalX[i] = std::cos( cAngle );
+      pointsData.normalY[i] = std::sin( cAngle );
+      pointsData.normalZ[i] = ( i % 2 == 0 ) ? -1.0f : 1.0f;
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Half Float File GUID";
+
+      e57::Writer writer( "./HalfFloatSignedNormals.e57", options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   // Half precision coordinates & intensities, and normals as signed normalized shorts
+   struct Point
+   {
+      e57::Float16 xyz[3];
+      e57::Float16 intensity;
+      int16_t normal[3];
+   };
+
+   e57::Reader reader( "./HalfFloatSignedNormals.e57", {} );
+
+   std::vector<Point> points( cNumPoints );
+
+   e57::Data3DPointsInterleaved buffers( sizeof( Point ) );
+   buffers.add( "cartesianX", &points[0].xyz[0] )
+      .add( "cartesianY", &points[0].xyz[1] )
+      .add( "cartesianZ", &points[0].xyz[2] )
+      .add( "intensity", &points[0].intensity )
+      .addNormalized( "nor:normalX", &points[0].normal[0] )
+      .addNormalized( "nor:normalY", &points[0].normal[1] )
+      .addNormalized( "nor:normalZ", &points[0].normal[2] );
+
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, buffers );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+   vectorReader.close();
+
+   const auto cSnorm = []( float value ) {
+      return static_cast<int16_t>( floor( static_cast<double>( value ) * 32767.0 + 0.5 ) );
+   };
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      const Point &cPoint = points[static_cast<size_t>( i )];
+
+      ASSERT_EQ( cPoint.normal[0], cSnorm( pointsData.normalX[i] ) );
+      ASSERT_EQ( cPoint.normal[1], cSnorm( pointsData.normalY[i] ) );
+      ASSERT_EQ( cPoint.normal[2], ( i % 2 == 0 ) ? -32767 : 32767 );
+   }
+
+   // 1.0, -2.0, 0.0, 0.5, and 2049 rounded to even (2048)
+   EXPECT_EQ( points[4].xyz[0].bits, 0x3C00 );
+   EXPECT_EQ( points[2].xyz[1].bits, 0xC000 );
+   EXPECT_EQ( points[2].xyz[2].bits, 0x0000 );
+   EXPECT_EQ( points[50].intensity.bits, 0x3800 );
+   EXPECT_EQ( points[2049].xyz[1].bits, 0xE800 );
 }
 
 TEST( SimpleReaderData, Empty )
@@ -160,6 +4653,14 @@ TEST( SimpleReaderData, BadCRC )
    E57_ASSERT_THROW( e57::Reader( TestData::Path() + "/self/bad-crc.e57", {} ) );
 }
 
+TEST( SimpleReaderData, BadCRCMemoryMapped )
+{
+   e57::ReaderOptions options;
+   options.readBackend = e57::ReadBackendMemoryMapped;
+
+   E57_ASSERT_THROW( e57::Reader( TestData::Path() + "/self/bad-crc.e57", options ) );
+}
+
 TEST( SimpleReaderData, DoNotCheckCRC )
 {
    E57_ASSERT_NO_THROW(
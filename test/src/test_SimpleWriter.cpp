@@ -1,11 +1,25 @@
 // libE57Format testing Copyright © 2022 Andy Maloney <asmaloney@gmail.com>
 // SPDX-License-Identifier: BSL-1.0
 
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <exception>
 #include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
+// Included first for access to the implementations
+#include "Codecs.h"
+#include "CompressedVectorNodeImpl.h"
+#include "PointOrdering.h"
+
+#include "E57SimpleReader.h"
 #include "E57SimpleWriter.h"
 
 #include "Helpers.h"
@@ -665,6 +679,2811 @@ TEST( SimpleWriter, MinMaxIssuesSphericalDouble )
    EXPECT_NE( header.intensityLimits.intensityMaximum, 0.0 );
 }
 
+TEST( SimpleWriter, ParallelEncode )
+{
+   constexpr int64_t cNumPoints = 200000;
+
+   auto writeWith = [&]( const char *fileName,
+                         const e57::CompressedVectorWriterOptions &writerOptions ) {
+      e57::WriterOptions options;
+      options.guid = "Parallel Encode File GUID";
+      options.compressedVectorWriter = writerOptions;
+
+      e57::Writer writer( fileName, options );
+
+      e57::Data3D header;
+      header.guid = "Parallel Encode Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+      header.pointFields.pointRangeScale = 0.001;
+      header.pointFields.pointRangeMinimum = -1000.0;
+      header.pointFields.pointRangeMaximum = 1000.0;
+      header.pointFields.intensityField = true;
+      header.pointFields.colorRedField = true;
+      header.pointFields.colorGreenField = true;
+
+      header.intensityLimits.intensityMaximum = 1.0;
+      header.colorLimits.colorRedMaximum = 255;
+      header.colorLimits.colorGreenMaximum = 255;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i % 10000 ) * 0.01;
+         pointsData.cartesianY[i] = -static_cast<double>( i % 777 ) * 0.1;
+         pointsData.cartesianZ[i] = static_cast<double>( i % 3 );
+         pointsData.intensity[i] = static_cast<float>( i % 100 ) / 100.0f;
+         pointsData.colorRed[i] = static_cast<uint16_t>( i % 256 );
+         pointsData.colorGreen[i] = static_cast<uint16_t>( ( i / 256 ) % 256 );
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   };
+
+   auto readPoints = []( const char *fileName ) {
+      e57::Reader reader( fileName, {} );
+
+      e57::Data3D header;
+      reader.ReadData3D( 0, header );
+
+      auto points = std::make_unique<e57::Data3DPointsDouble>( header );
+
+      auto vectorReader =
+         reader.SetUpData3DPointsData( 0, static_cast<size_t>( header.pointCount ), *points );
+
+      EXPECT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+      vectorReader.close();
+
+      return points;
+   };
+
+   e57::CompressedVectorWriterOptions writerOptions;
+
+   E57_ASSERT_NO_THROW( writeWith( "./ParallelEncodeSerial.e57", writerOptions ) );
+
+   writerOptions.encodeThreadCount = 4;
+   E57_ASSERT_NO_THROW( writeWith( "./ParallelEncodeThreads.e57", writerOptions ) );
+
+   // Use a caller-supplied executor which runs each task on its own thread
+   size_t tasksRun = 0;
+
+   writerOptions.encodeThreadCount = 1;
+   writerOptions.encodeExecutor = [&tasksRun]( const std::vector<std::function<void()>> &tasks ) {
+      std::vector<std::thread> threads;
+
+      for ( const auto &task : tasks )
+      {
+         threads.emplace_back( task );
+      }
+
+      for ( auto &thread : threads )
+      {
+         thread.join();
+      }
+
+      tasksRun += tasks.size();
+   };
+
+   E57_ASSERT_NO_THROW( writeWith( "./ParallelEncodeExecutor.e57", writerOptions ) );
+   EXPECT_GT( tasksRun, 0u );
+
+   // The packets may be split differently, but the points must be the same
+   const auto serial = readPoints( "./ParallelEncodeSerial.e57" );
+
+   for ( const char *fileName : { "./ParallelEncodeThreads.e57", "./ParallelEncodeExecutor.e57" } )
+   {
+      const auto parallel = readPoints( fileName );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_EQ( parallel->cartesianX[i], serial->cartesianX[i] ) << fileName << " i=" << i;
+         ASSERT_EQ( parallel->cartesianY[i], serial->cartesianY[i] ) << fileName << " i=" << i;
+         ASSERT_EQ( parallel->cartesianZ[i], serial->cartesianZ[i] ) << fileName << " i=" << i;
+         ASSERT_EQ( parallel->intensity[i], serial->intensity[i] ) << fileName << " i=" << i;
+         ASSERT_EQ( parallel->colorRed[i], serial->colorRed[i] ) << fileName << " i=" << i;
+         ASSERT_EQ( parallel->colorGreen[i], serial->colorGreen[i] ) << fileName << " i=" << i;
+      }
+   }
+}
+
+TEST( SimpleWriter, BackgroundWrite )
+{
+   constexpr int64_t cNumPoints = 100000;
+   constexpr size_t cBatchSize = 10000;
+   constexpr int64_t cImageSize = 5000;
+
+   std::vector<char> image( cImageSize );
+
+   for ( size_t i = 0; i < image.size(); ++i )
+   {
+      image[i] = static_cast<char>( i * 7 );
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Background Write File GUID";
+      options.compressedVectorWriter.backgroundWrite = true;
+      options.compressedVectorWriter.writeQueuePacketCount = 2;
+
+      e57::Writer writer( "./BackgroundWrite.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Background Write Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      // The image's blob is allocated before the scan, but written while it's being written
+      e57::Image2D imageHeader;
+      imageHeader.guid = "Background Write Image GUID";
+      imageHeader.visualReferenceRepresentation.imageWidth = 100;
+      imageHeader.visualReferenceRepresentation.imageHeight = 50;
+      imageHeader.visualReferenceRepresentation.jpegImageSize = cImageSize;
+
+      const int64_t cImageIndex = writer.NewImage2D( imageHeader );
+
+      const int64_t cScanIndex = writer.NewData3D( header );
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      auto vectorWriter = writer.SetUpData3DPointsData( cScanIndex, cBatchSize, pointsData );
+
+      for ( int64_t start = 0; start < cNumPoints; start += cBatchSize )
+      {
+         for ( size_t i = 0; i < cBatchSize; ++i )
+         {
+            const auto index = static_cast<float>( start + static_cast<int64_t>( i ) );
+
+            pointsData.cartesianX[i] = index;
+            pointsData.cartesianY[i] = -index;
+            pointsData.cartesianZ[i] = index * 0.5f;
+         }
+
+         vectorWriter.write( cBatchSize );
+
+         // Write to the blob while data packets may still be waiting to be written
+         if ( start == 3 * cBatchSize )
+         {
+            writer.WriteImage2DData( cImageIndex, e57::ImageJPEG, e57::ProjectionVisual,
+                                     image.data(), 0, cImageSize );
+         }
+      }
+
+      vectorWriter.close();
+   }
+
+   e57::Reader reader( "./BackgroundWrite.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+   ASSERT_EQ( header.pointCount, cNumPoints );
+
+   e57::Data3DPointsFloat points( header );
+   auto vectorReader =
+      reader.SetUpData3DPointsData( 0, static_cast<size_t>( cNumPoints ), points );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+   vectorReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_EQ( points.cartesianX[i], static_cast<float>( i ) );
+      ASSERT_EQ( points.cartesianY[i], -static_cast<float>( i ) );
+      ASSERT_EQ( points.cartesianZ[i], static_cast<float>( i ) * 0.5f );
+   }
+
+   std::vector<char> imageRead( cImageSize );
+
+   EXPECT_EQ( reader.ReadImage2DData( 0, e57::ProjectionVisual, e57::ImageJPEG, imageRead.data(),
+                                      0, cImageSize ),
+              cImageSize );
+   EXPECT_EQ( imageRead, image );
+
+   // The queue must have room for at least one packet
+   e57::WriterOptions options;
+   options.compressedVectorWriter.backgroundWrite = true;
+   options.compressedVectorWriter.writeQueuePacketCount = 0;
+
+   e57::Writer writer( "./BackgroundWriteInvalid.e57", options );
+
+   e57::Data3D badHeader;
+   badHeader.pointCount = 1;
+   badHeader.pointFields.cartesianXField = true;
+   badHeader.pointFields.cartesianYField = true;
+   badHeader.pointFields.cartesianZField = true;
+
+   e57::Data3DPointsFloat badPoints( badHeader );
+
+   E57_ASSERT_THROW( writer.WriteData3DData( badHeader, badPoints ) );
+}
+
+TEST( SimpleWriter, ReserveSpaceAndUnwrittenBlob )
+{
+   constexpr int64_t cNumPoints = 20000;
+   constexpr int64_t cImageSize = 3000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Reserve Space File GUID";
+
+      e57::Writer writer( "./ReserveSpace.e57", options );
+
+      // Only a hint, so it must not change what's written
+      E57_ASSERT_NO_THROW( writer.GetRawIMF().reserveSpace( 1024 * 1024 ) );
+
+      // The image's blob is allocated but never written, so it must read back as zeros
+      e57::Image2D imageHeader;
+      imageHeader.guid = "Reserve Space Image GUID";
+      imageHeader.visualReferenceRepresentation.imageWidth = 60;
+      imageHeader.visualReferenceRepresentation.imageHeight = 50;
+      imageHeader.visualReferenceRepresentation.jpegImageSize = cImageSize;
+
+      E57_ASSERT_NO_THROW( writer.NewImage2D( imageHeader ) );
+
+      e57::Data3D header;
+      header.guid = "Reserve Space Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsFloat pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<float>( i );
+         pointsData.cartesianY[i] = static_cast<float>( i % 100 );
+         pointsData.cartesianZ[i] = 1.0f;
+      }
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::Reader reader( "./ReserveSpace.e57", {} );
+
+   std::vector<char> imageRead( cImageSize, 1 );
+
+   EXPECT_EQ( reader.ReadImage2DData( 0, e57::ProjectionVisual, e57::ImageJPEG, imageRead.data(),
+                                      0, cImageSize ),
+              cImageSize );
+   EXPECT_EQ( imageRead, std::vector<char>( cImageSize, 0 ) );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   e57::Data3DPointsFloat points( header );
+   auto vectorReader =
+      reader.SetUpData3DPointsData( 0, static_cast<size_t>( cNumPoints ), points );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+   vectorReader.close();
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_EQ( points.cartesianX[i], static_cast<float>( i ) );
+      ASSERT_EQ( points.cartesianY[i], static_cast<float>( i % 100 ) );
+   }
+}
+
+TEST( SimpleWriter, ExpectedRecordCountHint )
+{
+   constexpr int64_t cNumPoints = 300000;
+
+   // The hint is wrong in both directions, which must not change what's written
+   for ( const uint64_t cHint : { uint64_t( 1000 ), uint64_t( 1000000 ) } )
+   {
+      {
+         e57::WriterOptions options;
+         options.guid = "Expected Record Count File GUID";
+         options.compressedVectorWriter.expectedRecordCount = cHint;
+
+         e57::Writer writer( "./ExpectedRecordCount.e57", options );
+
+         e57::Data3D header;
+         header.guid = "Expected Record Count Scan Header GUID";
+         header.pointCount = cNumPoints;
+         header.pointFields.cartesianXField = true;
+         header.pointFields.cartesianYField = true;
+         header.pointFields.cartesianZField = true;
+
+         const int64_t cScanIndex = writer.NewData3D( header );
+
+         e57::Data3DPointsFloat pointsData( header );
+
+         for ( int64_t i = 0; i < cNumPoints; ++i )
+         {
+            pointsData.cartesianX[i] = static_cast<float>( i );
+            pointsData.cartesianY[i] = static_cast<float>( i % 1000 );
+            pointsData.cartesianZ[i] = -1.0f;
+         }
+
+         auto vectorWriter = writer.SetUpData3DPointsData(
+            cScanIndex, static_cast<size_t>( cNumPoints ), pointsData );
+
+         vectorWriter.write( static_cast<size_t>( cNumPoints ) );
+         vectorWriter.close();
+      }
+
+      e57::Reader reader( "./ExpectedRecordCount.e57", {} );
+
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+      ASSERT_EQ( header.pointCount, cNumPoints );
+
+      e57::Data3DPointsFloat points( header );
+
+      std::vector<uint64_t> counts;
+
+      E57_ASSERT_NO_THROW( counts = reader.ReadData3DPointsDataParallel( { 0 }, { &points } ) );
+      ASSERT_EQ( counts.size(), 1u );
+      ASSERT_EQ( counts[0], static_cast<uint64_t>( cNumPoints ) );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_EQ( points.cartesianX[i], static_cast<float>( i ) ) << "hint=" << cHint;
+         ASSERT_EQ( points.cartesianY[i], static_cast<float>( i % 1000 ) ) << "hint=" << cHint;
+      }
+   }
+}
+
+TEST( SimpleWriter, FileCacheBypass )
+{
+   // Large enough for the writer to flush & drop several windows of pages
+   constexpr int64_t cNumPoints = 1000000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "File Cache Bypass File GUID";
+      options.fileCache = e57::FileCacheBypass;
+
+      e57::Writer writer( "./FileCacheBypass.e57", options );
+
+      e57::Data3D header;
+      header.guid = "File Cache Bypass Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i ) * 0.5;
+         pointsData.cartesianY[i] = static_cast<double>( i % 4099 );
+         pointsData.cartesianZ[i] = -static_cast<double>( i );
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   }
+
+   // Read it back both through the cache & bypassing it, sequentially & in parallel
+   for ( const auto cFileCache : { e57::FileCacheNormal, e57::FileCacheBypass } )
+   {
+      e57::ReaderOptions options;
+      options.fileCache = cFileCache;
+
+      e57::Reader reader( "./FileCacheBypass.e57", options );
+
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+      ASSERT_EQ( header.pointCount, cNumPoints );
+
+      e57::Data3DPointsDouble points( header );
+
+      auto vectorReader =
+         reader.SetUpData3DPointsData( 0, static_cast<size_t>( cNumPoints ), points );
+
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+      vectorReader.close();
+
+      e57::Data3DPointsDouble parallelPoints( header );
+
+      std::vector<uint64_t> counts;
+
+      E57_ASSERT_NO_THROW( counts = reader.ReadData3DPointsDataParallel( { 0 },
+                                                                         { &parallelPoints } ) );
+      ASSERT_EQ( counts.size(), 1u );
+      ASSERT_EQ( counts[0], static_cast<uint64_t>( cNumPoints ) );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_EQ( points.cartesianX[i], static_cast<double>( i ) * 0.5 ) << "i=" << i;
+         ASSERT_EQ( points.cartesianY[i], static_cast<double>( i % 4099 ) ) << "i=" << i;
+         ASSERT_EQ( points.cartesianZ[i], -static_cast<double>( i ) ) << "i=" << i;
+
+         ASSERT_EQ( parallelPoints.cartesianX[i], points.cartesianX[i] ) << "i=" << i;
+         ASSERT_EQ( parallelPoints.cartesianZ[i], points.cartesianZ[i] ) << "i=" << i;
+      }
+   }
+}
+
+TEST( SimpleWriter, ComputeBounds )
+{
+   constexpr int64_t cNumPoints = 5000;
+   constexpr double cScale = 0.001;
+
+   e57::Data3D cartesianHeader;
+   e57::Data3D sphericalHeader;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Compute Bounds File GUID";
+      options.computeBounds = true;
+
+      e57::Writer writer( "./ComputeBounds.e57", options );
+
+      // Scaled integer cartesian points written in one call
+      cartesianHeader.guid = "Compute Bounds Cartesian Scan Header GUID";
+      cartesianHeader.pointCount = cNumPoints;
+      cartesianHeader.pointFields.cartesianXField = true;
+      cartesianHeader.pointFields.cartesianYField = true;
+      cartesianHeader.pointFields.cartesianZField = true;
+      cartesianHeader.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+      cartesianHeader.pointFields.pointRangeScale = cScale;
+
+      e57::Data3DPointsDouble cartesianPoints( cartesianHeader );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         cartesianPoints.cartesianX[i] = static_cast<double>( i ) * 0.01 - 7.5;
+         cartesianPoints.cartesianY[i] = static_cast<double>( i % 101 );
+         cartesianPoints.cartesianZ[i] = -static_cast<double>( cNumPoints - i ) * 0.002;
+      }
+
+      writer.WriteData3DData( cartesianHeader, cartesianPoints );
+
+      // Float spherical points written through a point writer, saved when the file is closed
+      sphericalHeader.guid = "Compute Bounds Spherical Scan Header GUID";
+      sphericalHeader.pointCount = cNumPoints;
+      sphericalHeader.pointFields.sphericalRangeField = true;
+      sphericalHeader.pointFields.sphericalElevationField = true;
+      sphericalHeader.pointFields.sphericalAzimuthField = true;
+
+      const int64_t cScanIndex = writer.NewData3D( sphericalHeader );
+
+      e57::Data3DPointsFloat sphericalPoints( sphericalHeader );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         sphericalPoints.sphericalRange[i] = 1.0f + static_cast<float>( i % 977 ) * 0.25f;
+         sphericalPoints.sphericalElevation[i] = static_cast<float>( i ) * 0.0001f - 0.2f;
+         sphericalPoints.sphericalAzimuth[i] = static_cast<float>( i ) * -0.0002f;
+      }
+
+      auto pointWriter = writer.SetUpData3DPointsData( cScanIndex, cNumPoints, sphericalPoints );
+
+      pointWriter.write( cNumPoints );
+      pointWriter.close();
+   }
+
+   // The header of the scan written in one call has its bounds filled in
+   EXPECT_NEAR( cartesianHeader.cartesianBounds.xMinimum, -7.5, cScale );
+   EXPECT_NEAR( cartesianHeader.cartesianBounds.xMaximum, 42.49, cScale );
+   EXPECT_NEAR( cartesianHeader.cartesianBounds.yMinimum, 0.0, cScale );
+   EXPECT_NEAR( cartesianHeader.cartesianBounds.yMaximum, 100.0, cScale );
+   EXPECT_NEAR( cartesianHeader.cartesianBounds.zMinimum, -10.0, cScale );
+   EXPECT_NEAR( cartesianHeader.cartesianBounds.zMaximum, -0.002, cScale );
+
+   e57::Reader reader( "./ComputeBounds.e57", {} );
+
+   e57::Data3D header;
+
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+   EXPECT_EQ( header.cartesianBounds, cartesianHeader.cartesianBounds );
+
+   ASSERT_TRUE( reader.ReadData3D( 1, header ) );
+   EXPECT_EQ( header.sphericalBounds.rangeMinimum, 1.0 );
+   EXPECT_EQ( header.sphericalBounds.rangeMaximum, 1.0 + 976 * 0.25 );
+   EXPECT_FLOAT_EQ( header.sphericalBounds.elevationMinimum, -0.2f );
+   EXPECT_FLOAT_EQ( header.sphericalBounds.elevationMaximum, 4999 * 0.0001f - 0.2f );
+   EXPECT_FLOAT_EQ( header.sphericalBounds.azimuthStart, 4999 * -0.0002f );
+   EXPECT_EQ( header.sphericalBounds.azimuthEnd, 0.0 );
+
+   // No cartesian fields, so no cartesianBounds
+   EXPECT_EQ( header.cartesianBounds, e57::CartesianBounds{} );
+}
+
+TEST( SimpleWriter, ManyChildrenLookup )
+{
+   constexpr int cChildCount = 50;
+
+   {
+      e57::ImageFile imf( "./ManyChildren.e57", "w" );
+
+      e57::StructureNode items( imf );
+      imf.root().set( "items", items );
+
+      for ( int i = 0; i < cChildCount; ++i )
+      {
+         e57::StructureNode item( imf );
+         item.set( "value", e57::IntegerNode( imf, i, 0, cChildCount ) );
+
+         items.set( "item" + std::to_string( i ), item );
+      }
+
+      // Children are still found by name & can't be set twice once they are indexed
+      EXPECT_TRUE( items.isDefined( "item0" ) );
+      EXPECT_TRUE( items.isDefined( "/items/item49/value" ) );
+      EXPECT_FALSE( items.isDefined( "item50" ) );
+
+      EXPECT_THROW( items.set( "item7", e57::IntegerNode( imf ) ), e57::E57Exception );
+
+      e57::VectorNode vector( imf, true );
+      imf.root().set( "vector", vector );
+
+      for ( int i = 0; i < cChildCount; ++i )
+      {
+         vector.append( e57::IntegerNode( imf, i, 0, cChildCount ) );
+      }
+
+      EXPECT_EQ( e57::IntegerNode( vector.get( "/vector/31" ) ).value(), 31 );
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./ManyChildren.e57", "r" );
+
+   e57::StructureNode items( imf.root().get( "items" ) );
+
+   ASSERT_EQ( items.childCount(), cChildCount );
+
+   for ( int i = 0; i < cChildCount; ++i )
+   {
+      const e57::ustring cName = "item" + std::to_string( i );
+
+      EXPECT_EQ( items.get( i ).elementName(), cName );
+      EXPECT_EQ( e57::IntegerNode( items.get( cName + "/value" ) ).value(), i );
+   }
+
+   EXPECT_FALSE( imf.root().isDefined( "/vector/50" ) );
+   EXPECT_EQ( e57::IntegerNode( imf.root().get( "/vector/49" ) ).value(), 49 );
+
+   imf.close();
+}
+
+TEST( SimpleWriter, BlobWriterStreaming )
+{
+   // Several staging batches, not a multiple of a page
+   constexpr size_t cByteCount = 200000 + 3;
+
+   std::vector<uint8_t> bytes( cByteCount );
+
+   for ( size_t i = 0; i < cByteCount; ++i )
+   {
+      bytes[i] = static_cast<uint8_t>( ( i * 7 ) ^ ( i >> 9 ) );
+   }
+
+   {
+      e57::ImageFile imf( "./BlobWriterStreaming.e57", "w" );
+
+      e57::BlobWriter writer( imf );
+
+      EXPECT_EQ( imf.writerCount(), 1 );
+      EXPECT_THROW( e57::BlobNode( imf, 10 ), e57::E57Exception );
+      EXPECT_THROW( e57::BlobWriter{ imf }, e57::E57Exception );
+
+      // Mix copied bytes with bytes produced in place, in uneven chunks
+      size_t written = 0;
+      size_t chunk = 1;
+
+      while ( written < cByteCount )
+      {
+         if ( ( chunk % 2 ) == 0 )
+         {
+            const size_t cCount = std::min( chunk * 37, cByteCount - written );
+
+            writer.write( bytes.data() + written, cCount );
+            written += cCount;
+         }
+         else
+         {
+            size_t capacity = 0;
+            uint8_t *buffer = writer.buffer( capacity );
+
+            ASSERT_GT( capacity, 0u );
+
+            const size_t cCount = std::min( { chunk * 101, capacity, cByteCount - written } );
+
+            std::copy_n( bytes.data() + written, cCount, buffer );
+            writer.commit( cCount );
+            written += cCount;
+         }
+
+         ++chunk;
+
+         EXPECT_EQ( writer.byteCount(), static_cast<int64_t>( written ) );
+      }
+
+      e57::BlobNode blob = writer.close();
+
+      EXPECT_FALSE( writer.isOpen() );
+      EXPECT_EQ( imf.writerCount(), 0 );
+      EXPECT_EQ( blob.byteCount(), static_cast<int64_t>( cByteCount ) );
+      EXPECT_THROW( writer.write( bytes.data(), 1 ), e57::E57Exception );
+
+      imf.root().set( "streamed", blob );
+
+      // Blobs can be added after the streamed one
+      e57::BlobNode after( imf, 5 );
+      imf.root().set( "after", after );
+      after.write( bytes.data(), 0, 5 );
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./BlobWriterStreaming.e57", "r" );
+
+   e57::BlobNode blob( imf.root().get( "streamed" ) );
+
+   ASSERT_EQ( blob.byteCount(), static_cast<int64_t>( cByteCount ) );
+
+   std::vector<uint8_t> readBytes( cByteCount );
+   blob.read( readBytes.data(), 0, cByteCount );
+
+   EXPECT_EQ( readBytes, bytes );
+
+   e57::BlobNode after( imf.root().get( "after" ) );
+
+   std::array<uint8_t, 5> afterBytes{};
+   after.read( afterBytes.data(), 0, afterBytes.size() );
+
+   EXPECT_TRUE( std::equal( afterBytes.begin(), afterBytes.end(), bytes.begin() ) );
+
+   imf.close();
+}
+
+TEST( SimpleWriter, StringArena )
+{
+   constexpr size_t cNumRecords = 5000;
+
+   // Mix short & long strings so some are split over packets
+   e57::StringArena labels;
+
+   for ( size_t i = 0; i < cNumRecords; ++i )
+   {
+      const std::string cLabel =
+         ( ( i % 97 ) == 0 ) ? std::string( 300 + i % 50, static_cast<char>( 'a' + i % 26 ) )
+                             : "label " + std::to_string( i % 13 );
+
+      labels.append( cLabel.data(), cLabel.size() );
+   }
+
+   ASSERT_EQ( labels.size(), cNumRecords );
+
+   {
+      e57::ImageFile imf( "./StringArena.e57", "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "label", e57::StringNode( imf ) );
+      proto.set( "index", e57::IntegerNode( imf, 0, 0, static_cast<int64_t>( cNumRecords ) ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode points( imf, proto, codecs );
+      imf.root().set( "points", points );
+
+      std::vector<int64_t> indices( cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         indices[i] = static_cast<int64_t>( i );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "label", &labels, cNumRecords );
+      sbufs.emplace_back( imf, "index", indices.data(), cNumRecords, true );
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./StringArena.e57", "r" );
+   e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+   // Read in blocks into an arena, which is refilled for each block
+   constexpr size_t cBlockSize = 1024;
+
+   e57::StringArena readLabels;
+
+   std::vector<e57::SourceDestBuffer> dbufs;
+   dbufs.emplace_back( imf, "label", &readLabels, cBlockSize );
+
+   e57::CompressedVectorReader reader = points.reader( dbufs );
+
+   size_t total = 0;
+   unsigned count = 0;
+
+   while ( ( count = reader.read() ) > 0 )
+   {
+      ASSERT_EQ( readLabels.size(), count );
+
+      for ( size_t i = 0; i < count; ++i )
+      {
+         ASSERT_EQ( readLabels.at( i ), labels.at( total + i ) ) << "record " << total + i;
+      }
+
+      total += count;
+   }
+
+   reader.close();
+
+   EXPECT_EQ( total, cNumRecords );
+
+   // A list of strings gets the same values
+   std::vector<std::string> list( cNumRecords );
+
+   std::vector<e57::SourceDestBuffer> listBufs;
+   listBufs.emplace_back( imf, "label", &list );
+
+   e57::CompressedVectorReader listReader = points.reader( listBufs );
+   EXPECT_EQ( listReader.read(), cNumRecords );
+   listReader.close();
+
+   for ( size_t i = 0; i < cNumRecords; ++i )
+   {
+      ASSERT_EQ( list[i], labels.at( i ) );
+   }
+
+   e57::StringArena *noArena = nullptr;
+
+   EXPECT_THROW( e57::SourceDestBuffer( imf, "label", noArena, 1 ), e57::E57Exception );
+   EXPECT_THROW( e57::SourceDestBuffer( imf, "label", &readLabels, 0 ), e57::E57Exception );
+
+   imf.close();
+
+   // Offsets past the end of the arena are rejected
+   e57::ImageFile badFile( "./StringArena.e57", "w" );
+
+   e57::StructureNode proto( badFile );
+   proto.set( "label", e57::StringNode( badFile ) );
+
+   e57::VectorNode codecs( badFile, true );
+   e57::CompressedVectorNode badPoints( badFile, proto, codecs );
+   badFile.root().set( "points", badPoints );
+
+   e57::StringArena bad;
+   bad.offsets = { 0, 10 };
+
+   std::vector<e57::SourceDestBuffer> badBufs;
+   badBufs.emplace_back( badFile, "label", &bad, 1 );
+
+   {
+      e57::CompressedVectorWriter badWriter = badPoints.writer( badBufs );
+
+      try
+      {
+         badWriter.write( 1 );
+         FAIL() << "Expected ErrorBadBuffer";
+      }
+      catch ( e57::E57Exception &err )
+      {
+         EXPECT_EQ( err.errorCode(), e57::ErrorBadBuffer );
+      }
+   }
+
+   badFile.cancel();
+}
+
+TEST( SimpleWriter, FillPackets )
+{
+   constexpr int64_t cNumPoints = 200000;
+
+   // Write the scan and return the writer's statistics
+   auto writeScan = [&]( bool fillPackets, const std::vector<std::vector<e57::ustring>> &groups ) {
+      e57::WriterOptions options;
+      options.guid = "Fill Packets File GUID";
+      options.compressedVectorWriter.fillPackets = fillPackets;
+      options.compressedVectorWriter.packetFieldGroups = groups;
+
+      e57::Writer writer( "./FillPackets.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Fill Packets Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.intensityField = true;
+      header.intensityLimits.intensityMinimum = 0.0;
+      header.intensityLimits.intensityMaximum = 4095.0;
+      header.pointFields.intensityScale = 1.0;
+      header.pointFields.colorRedField = true;
+      header.colorLimits.colorRedMaximum = 255;
+
+      const int64_t cScanIndex = writer.NewData3D( header );
+
+      constexpr size_t cBatchSize = 7919;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      auto vectorWriter = writer.SetUpData3DPointsData( cScanIndex, cBatchSize, pointsData );
+
+      for ( int64_t start = 0; start < cNumPoints; start += cBatchSize )
+      {
+         const auto cCount =
+            static_cast<size_t>( std::min<int64_t>( cBatchSize, cNumPoints - start ) );
+
+         for ( size_t i = 0; i < cCount; ++i )
+         {
+            const auto cIndex = start + static_cast<int64_t>( i );
+
+            pointsData.cartesianX[i] = static_cast<double>( cIndex );
+            pointsData.cartesianY[i] = static_cast<double>( -cIndex );
+            pointsData.cartesianZ[i] = static_cast<double>( cIndex % 1000 );
+            pointsData.intensity[i] = static_cast<double>( cIndex % 4096 );
+            pointsData.colorRed[i] = static_cast<uint16_t>( cIndex % 256 );
+         }
+
+         vectorWriter.write( cCount );
+      }
+
+      vectorWriter.close();
+
+      return vectorWriter.statistics();
+   };
+
+   auto checkScan = [&]() {
+      e57::Reader reader( "./FillPackets.e57", {} );
+
+      e57::Data3D header;
+      ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+      ASSERT_EQ( header.pointCount, cNumPoints );
+
+      e57::Data3DPointsDouble points( header );
+      auto vectorReader =
+         reader.SetUpData3DPointsData( 0, static_cast<size_t>( cNumPoints ), points );
+
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+      vectorReader.close();
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_EQ( points.cartesianX[i], static_cast<double>( i ) );
+         ASSERT_EQ( points.cartesianY[i], static_cast<double>( -i ) );
+         ASSERT_EQ( points.cartesianZ[i], static_cast<double>( i % 1000 ) );
+         ASSERT_EQ( points.intensity[i], static_cast<double>( i % 4096 ) );
+         ASSERT_EQ( points.colorRed[i], static_cast<uint16_t>( i % 256 ) );
+      }
+   };
+
+   const auto cDefault = writeScan( false, {} );
+   checkScan();
+
+   const auto cFilled = writeScan( true, {} );
+   checkScan();
+
+   EXPECT_GT( cFilled.dataPacketFill, cDefault.dataPacketFill );
+   EXPECT_GT( cFilled.dataPacketFill, 0.95 );
+   EXPECT_LT( cFilled.dataPacketCount, cDefault.dataPacketCount );
+   EXPECT_EQ( cFilled.dataPacketByteCount / cFilled.dataPacketCount,
+              static_cast<uint64_t>( cFilled.dataPacketFill * 65536 ) );
+
+   // Each group fills its own packets
+   const auto cGrouped = writeScan( true, { { "cartesianX", "cartesianY", "cartesianZ" } } );
+   checkScan();
+
+   EXPECT_GT( cGrouped.dataPacketFill, 0.9 );
+}
+
+TEST( SimpleWriter, StagedWrites )
+{
+   constexpr size_t cNumRecords = 50000;
+   constexpr size_t cBatchSize = 997;
+
+   struct Record
+   {
+      double x;
+      int32_t index;
+   };
+
+   const auto label = []( size_t i ) { return "label " + std::to_string( i % 31 ); };
+
+   // Write small batches, alternating between two sets of buffers, with & without staging
+   for ( const size_t cStagingRecordCount : { size_t( 0 ), size_t( 4096 ) } )
+   {
+      SCOPED_TRACE( cStagingRecordCount );
+
+      {
+         e57::ImageFile imf( "./StagedWrites.e57", "w" );
+
+         e57::StructureNode proto( imf );
+         proto.set( "x", e57::FloatNode( imf ) );
+         proto.set( "index", e57::IntegerNode( imf, 0, 0, static_cast<int64_t>( cNumRecords ) ) );
+         proto.set( "label", e57::StringNode( imf ) );
+
+         e57::VectorNode codecs( imf, true );
+         e57::CompressedVectorNode points( imf, proto, codecs );
+         imf.root().set( "points", points );
+
+         std::vector<Record> records[2] = { std::vector<Record>( cBatchSize ),
+                                            std::vector<Record>( cBatchSize ) };
+         e57::StringArena labels[2];
+         std::vector<e57::SourceDestBuffer> sbufs[2];
+
+         for ( size_t set = 0; set < 2; ++set )
+         {
+            sbufs[set].emplace_back( imf, "x", &records[set][0].x, cBatchSize, false, false,
+                                     sizeof( Record ) );
+            sbufs[set].emplace_back( imf, "index", &records[set][0].index, cBatchSize, true,
+                                     false, sizeof( Record ) );
+            sbufs[set].emplace_back( imf, "label", &labels[set], cBatchSize );
+         }
+
+         e57::CompressedVectorWriterOptions options;
+         options.stagingRecordCount = cStagingRecordCount;
+
+         e57::CompressedVectorWriter writer = points.writer( sbufs[0], options );
+
+         size_t batch = 0;
+
+         for ( size_t start = 0; start < cNumRecords; start += cBatchSize, ++batch )
+         {
+            const size_t cSet = batch % 2;
+            const size_t cCount = std::min( cBatchSize, cNumRecords - start );
+
+            labels[cSet].clear();
+
+            for ( size_t i = 0; i < cCount; ++i )
+            {
+               records[cSet][i].x = static_cast<double>( start + i ) * 0.5;
+               records[cSet][i].index = static_cast<int32_t>( start + i );
+
+               const std::string cLabel = label( start + i );
+               labels[cSet].append( cLabel.data(), cLabel.size() );
+            }
+
+            if ( cSet == 0 )
+            {
+               writer.write( sbufs[0], cCount );
+            }
+            else
+            {
+               writer.write( sbufs[1], cCount );
+            }
+
+            if ( batch == 10 )
+            {
+               writer.flush();
+            }
+         }
+
+         writer.close();
+
+         imf.close();
+      }
+
+      e57::ImageFile imf( "./StagedWrites.e57", "r" );
+      e57::CompressedVectorNode points( imf.root().get( "points" ) );
+
+      ASSERT_EQ( points.childCount(), static_cast<int64_t>( cNumRecords ) );
+
+      std::vector<double> x( cNumRecords );
+      std::vector<int64_t> index( cNumRecords );
+      std::vector<std::string> labels( cNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "x", x.data(), cNumRecords );
+      dbufs.emplace_back( imf, "index", index.data(), cNumRecords );
+      dbufs.emplace_back( imf, "label", &labels );
+
+      e57::CompressedVectorReader reader = points.reader( dbufs );
+      ASSERT_EQ( reader.read(), cNumRecords );
+      reader.close();
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         ASSERT_EQ( x[i], static_cast<double>( i ) * 0.5 ) << "record " << i;
+         ASSERT_EQ( index[i], static_cast<int64_t>( i ) ) << "record " << i;
+         ASSERT_EQ( labels[i], label( i ) ) << "record " << i;
+      }
+
+      imf.close();
+   }
+
+   // A bad value is reported when the staged records are encoded
+   e57::ImageFile badFile( "./StagedWrites.e57", "w" );
+
+   e57::StructureNode proto( badFile );
+   proto.set( "index", e57::IntegerNode( badFile, 0, 0, 10 ) );
+
+   e57::VectorNode codecs( badFile, true );
+   e57::CompressedVectorNode badPoints( badFile, proto, codecs );
+   badFile.root().set( "points", badPoints );
+
+   std::vector<int64_t> indices( 20, 5 );
+   indices[13] = 11;
+
+   std::vector<e57::SourceDestBuffer> sbufs;
+   sbufs.emplace_back( badFile, "index", indices.data(), indices.size() );
+
+   e57::CompressedVectorWriterOptions options;
+   options.stagingRecordCount = 100;
+
+   {
+      e57::CompressedVectorWriter writer = badPoints.writer( sbufs, options );
+
+      EXPECT_NO_THROW( writer.write( indices.size() ) );
+
+      try
+      {
+         writer.flush();
+         FAIL() << "Expected ErrorValueOutOfBounds";
+      }
+      catch ( e57::E57Exception &err )
+      {
+         EXPECT_EQ( err.errorCode(), e57::ErrorValueOutOfBounds );
+      }
+   }
+
+   badFile.cancel();
+}
+
+TEST( SimpleWriter, FloatLimits )
+{
+   constexpr size_t cNumRecords = 1000;
+
+   // Single precision limits which aren't floats themselves
+   const double cMinimum = 0.1;
+   const double cMaximum = 0.7;
+
+   std::vector<float> singles( cNumRecords );
+   std::vector<double> doubles( cNumRecords );
+
+   for ( size_t i = 0; i < cNumRecords; ++i )
+   {
+      singles[i] = static_cast<float>( cMinimum + ( cMaximum - cMinimum ) * i / cNumRecords );
+      doubles[i] = -1.0 + 2.0 * static_cast<double>( i ) / cNumRecords;
+   }
+
+   // The limits rounded to floats are in range, as are NaNs
+   singles[0] = static_cast<float>( cMinimum );
+   singles[1] = std::nanf( "" );
+   doubles[2] = std::nan( "" );
+
+   auto write = [&]( const char *path, bool checkFloatLimits ) {
+      e57::ImageFile imf( path, "w" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "single", e57::FloatNode( imf, 0.5, e57::PrecisionSingle, cMinimum, cMaximum ) );
+      proto.set( "double", e57::FloatNode( imf, 0.0, e57::PrecisionDouble, -1.0, 1.0 ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode points( imf, proto, codecs );
+      imf.root().set( "points", points );
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "single", singles.data(), cNumRecords );
+      sbufs.emplace_back( imf, "double", doubles.data(), cNumRecords );
+
+      std::exception_ptr error;
+
+      e57::CompressedVectorWriterOptions options;
+      options.checkFloatLimits = checkFloatLimits;
+
+      {
+         e57::CompressedVectorWriter writer = points.writer( sbufs, options );
+
+         try
+         {
+            writer.write( cNumRecords );
+            writer.close();
+         }
+         catch ( ... )
+         {
+            error = std::current_exception();
+         }
+      }
+
+      if ( error )
+      {
+         imf.cancel();
+         std::rethrow_exception( error );
+      }
+
+      imf.close();
+   };
+
+   E57_ASSERT_NO_THROW( write( "./FloatLimits.e57", true ) );
+
+   singles[777] = std::nextafter( static_cast<float>( cMaximum ), 1.0F );
+
+   // Unless asked, values outside the limits are written as they are
+   E57_ASSERT_NO_THROW( write( "./FloatLimits.e57", false ) );
+
+   try
+   {
+      write( "./FloatLimits.e57", true );
+      FAIL() << "Expected ErrorValueOutOfBounds";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorValueOutOfBounds );
+   }
+
+   singles[777] = static_cast<float>( cMaximum );
+   doubles[555] = -1.0000001;
+
+   try
+   {
+      write( "./FloatLimits.e57", true );
+      FAIL() << "Expected ErrorValueOutOfBounds";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorValueOutOfBounds );
+   }
+}
+
+TEST( SimpleWriter, CopyCompressedVector )
+{
+   constexpr size_t cNumRecords = 400000;
+
+   const auto xValue = []( size_t i ) { return static_cast<double>( i ) * 0.25 - 1000.0; };
+
+   {
+      e57::ImageFile imf( "./CopySource.e57", "w" );
+      imf.extensionsAdd( "ext", "http://www.example.com/CopyExtension" );
+
+      e57::StructureNode proto( imf );
+      proto.set( "x", e57::FloatNode( imf ) );
+      proto.set( "index", e57::IntegerNode( imf, 0, 0, static_cast<int64_t>( cNumRecords ) ) );
+      proto.set( "ext:flag", e57::IntegerNode( imf, 0, 0, 3 ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode points( imf, proto, codecs );
+      imf.root().set( "points", points );
+
+      std::vector<double> x( cNumRecords );
+      std::vector<int64_t> index( cNumRecords );
+      std::vector<int8_t> flag( cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         x[i] = xValue( i );
+         index[i] = static_cast<int64_t>( i );
+         flag[i] = static_cast<int8_t>( i % 4 );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "x", x.data(), cNumRecords );
+      sbufs.emplace_back( imf, "index", index.data(), cNumRecords );
+      sbufs.emplace_back( imf, "ext:flag", flag.data(), cNumRecords, true );
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs );
+      writer.write( cNumRecords );
+      writer.close();
+
+      imf.close();
+   }
+
+   {
+      e57::ImageFile source( "./CopySource.e57", "r" );
+      e57::CompressedVectorNode points( source.root().get( "points" ) );
+
+      e57::ImageFile dest( "./CopyDest.e57", "w" );
+
+      // Move the copies to an offset with a different place in the pages
+      e57::BlobNode blob( dest, 3001 );
+      dest.root().set( "blob", blob );
+
+      std::vector<uint8_t> bytes( 3001, 7 );
+      blob.write( bytes.data(), 0, bytes.size() );
+
+      dest.root().set( "first", points.copyTo( dest ) );
+      dest.root().set( "second", points.copyTo( dest ) );
+
+      // The copies can't go into a read-only file
+      try
+      {
+         points.copyTo( source );
+         FAIL() << "Expected ErrorFileReadOnly";
+      }
+      catch ( e57::E57Exception &err )
+      {
+         EXPECT_EQ( err.errorCode(), e57::ErrorFileReadOnly );
+      }
+
+      dest.close();
+   }
+
+   e57::ImageFile source( "./CopySource.e57", "r" );
+   const auto cSourceChunks =
+      e57::CompressedVectorNode( source.root().get( "points" ) ).impl()->readChunkIndex();
+
+   ASSERT_GT( cSourceChunks.size(), 1u );
+
+   e57::ImageFile imf( "./CopyDest.e57", "r" );
+
+   e57::ustring uri;
+   EXPECT_TRUE( imf.extensionsLookupPrefix( "ext", uri ) );
+   EXPECT_EQ( uri, "http://www.example.com/CopyExtension" );
+
+   for ( const char *name : { "first", "second" } )
+   {
+      SCOPED_TRACE( name );
+
+      e57::CompressedVectorNode points( imf.root().get( name ) );
+
+      ASSERT_EQ( points.childCount(), static_cast<int64_t>( cNumRecords ) );
+
+      e57::StructureNode proto( points.prototype() );
+      ASSERT_TRUE( proto.isDefined( "ext:flag" ) );
+      EXPECT_EQ( e57::IntegerNode( proto.get( "ext:flag" ) ).maximum(), 3 );
+
+      // The index was moved with the packets
+      const auto cChunks = points.impl()->readChunkIndex();
+
+      ASSERT_EQ( cChunks.size(), cSourceChunks.size() );
+
+      for ( size_t i = 1; i < cChunks.size(); ++i )
+      {
+         EXPECT_EQ( cChunks[i].recordNumber, cSourceChunks[i].recordNumber );
+      }
+
+      std::vector<double> x( cNumRecords );
+      std::vector<int64_t> index( cNumRecords );
+      std::vector<int64_t> flag( cNumRecords );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "x", x.data(), cNumRecords );
+      dbufs.emplace_back( imf, "index", index.data(), cNumRecords );
+      dbufs.emplace_back( imf, "ext:flag", flag.data(), cNumRecords );
+
+      // Reading with several threads starts at the chunks in the index
+      ASSERT_EQ( points.readParallel( dbufs, 4 ), cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         ASSERT_EQ( x[i], xValue( i ) ) << "record " << i;
+         ASSERT_EQ( index[i], static_cast<int64_t>( i ) ) << "record " << i;
+         ASSERT_EQ( flag[i], static_cast<int64_t>( i % 4 ) ) << "record " << i;
+      }
+   }
+
+   imf.close();
+   source.close();
+}
+
+TEST( SimpleWriter, AppendScan )
+{
+   constexpr int64_t cNumPoints = 30000;
+
+   const auto writeScan = []( e57::Writer &writer, const char *guid, double offset ) {
+      e57::Data3D header;
+      header.guid = guid;
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = offset + static_cast<double>( i );
+         pointsData.cartesianY[i] = offset - static_cast<double>( i );
+         pointsData.cartesianZ[i] = offset;
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   };
+
+   const auto readFile = []( const char *path ) {
+      std::ifstream stream( path, std::ios::binary );
+      return std::vector<char>( std::istreambuf_iterator<char>( stream ),
+                                std::istreambuf_iterator<char>() );
+   };
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Append File GUID";
+
+      e57::Writer writer( "./AppendScan.e57", options );
+      writeScan( writer, "Append Scan 0", 0.0 );
+   }
+
+   const std::vector<char> cOriginal = readFile( "./AppendScan.e57" );
+
+   // Cancelling leaves the file as it was
+   {
+      e57::ImageFile imf( "./AppendScan.e57", "a" );
+
+      EXPECT_TRUE( imf.isWritable() );
+
+      e57::BlobNode blob( imf, 5000 );
+      imf.root().set( "blob", blob );
+
+      std::vector<uint8_t> bytes( 5000, 1 );
+      blob.write( bytes.data(), 0, bytes.size() );
+
+      imf.cancel();
+   }
+
+   EXPECT_EQ( readFile( "./AppendScan.e57" ), cOriginal );
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Ignored GUID";
+      options.append = true;
+
+      e57::Writer writer( "./AppendScan.e57", options );
+
+      writeScan( writer, "Append Scan 1", 1000.0 );
+   }
+
+   // Only the header page was rewritten
+   const std::vector<char> cAppended = readFile( "./AppendScan.e57" );
+
+   ASSERT_GT( cAppended.size(), cOriginal.size() );
+   EXPECT_TRUE( std::equal( cOriginal.begin() + 1024, cOriginal.end(), cAppended.begin() + 1024 ) );
+
+   e57::Reader reader( "./AppendScan.e57", {} );
+
+   e57::E57Root fileHeader;
+   reader.GetE57Root( fileHeader );
+
+   EXPECT_EQ( fileHeader.guid, "Append File GUID" );
+   ASSERT_EQ( reader.GetData3DCount(), 2 );
+
+   for ( int64_t scan = 0; scan < 2; ++scan )
+   {
+      e57::Data3D header;
+      reader.ReadData3D( scan, header );
+
+      EXPECT_EQ( header.guid, "Append Scan " + std::to_string( scan ) );
+      ASSERT_EQ( header.pointCount, cNumPoints );
+
+      e57::Data3DPointsDouble pointsData( header );
+      auto vectorReader = reader.SetUpData3DPointsData( scan, cNumPoints, pointsData );
+
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+      vectorReader.close();
+
+      const double cOffset = scan * 1000.0;
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_EQ( pointsData.cartesianX[i], cOffset + static_cast<double>( i ) );
+         ASSERT_EQ( pointsData.cartesianY[i], cOffset - static_cast<double>( i ) );
+         ASSERT_EQ( pointsData.cartesianZ[i], cOffset );
+      }
+   }
+}
+
+TEST( SimpleWriter, ConcurrentWriters )
+{
+   const std::array<size_t, 3> cNumRecords = { { 300000, 1, 150001 } };
+
+   const auto xValue = []( size_t scan, size_t i ) {
+      return static_cast<double>( i ) * 0.5 + static_cast<double>( scan ) * 1.0e6;
+   };
+
+   {
+      e57::ImageFile imf( "./ConcurrentWriters.e57", "w" );
+
+      std::vector<e57::CompressedVectorNode> nodes;
+
+      for ( size_t scan = 0; scan < cNumRecords.size(); ++scan )
+      {
+         e57::StructureNode proto( imf );
+         proto.set( "x", e57::FloatNode( imf ) );
+         proto.set( "index", e57::IntegerNode( imf, 0, 0, 1000000 ) );
+
+         e57::VectorNode codecs( imf, true );
+         nodes.emplace_back( imf, proto, codecs );
+         imf.root().set( "points" + std::to_string( scan ), nodes.back() );
+      }
+
+      std::vector<std::vector<double>> x( cNumRecords.size() );
+      std::vector<std::vector<int32_t>> index( cNumRecords.size() );
+      std::vector<e57::CompressedVectorWriter> writers;
+
+      // Each writer is fed in small blocks, so the threads interleave
+      constexpr size_t cBlockSize = 7919;
+
+      std::vector<std::vector<double>> xBlocks( cNumRecords.size(),
+                                                std::vector<double>( cBlockSize ) );
+      std::vector<std::vector<int32_t>> indexBlocks( cNumRecords.size(),
+                                                     std::vector<int32_t>( cBlockSize ) );
+
+      e57::CompressedVectorWriterOptions options;
+      options.concurrent = true;
+
+      for ( size_t scan = 0; scan < cNumRecords.size(); ++scan )
+      {
+         for ( size_t i = 0; i < cNumRecords[scan]; ++i )
+         {
+            x[scan].push_back( xValue( scan, i ) );
+            index[scan].push_back( static_cast<int32_t>( i ) );
+         }
+
+         std::vector<e57::SourceDestBuffer> sbufs;
+         sbufs.emplace_back( imf, "x", xBlocks[scan].data(), cBlockSize );
+         sbufs.emplace_back( imf, "index", indexBlocks[scan].data(), cBlockSize );
+
+         writers.push_back( nodes[scan].writer( sbufs, options ) );
+      }
+
+      EXPECT_EQ( imf.writerCount(), 3 );
+
+      // Other writers & blobs have to wait for the concurrent writers
+      {
+         e57::StructureNode proto( imf );
+         proto.set( "x", e57::FloatNode( imf ) );
+
+         e57::VectorNode codecs( imf, true );
+         e57::CompressedVectorNode other( imf, proto, codecs );
+         imf.root().set( "other", other );
+
+         std::vector<e57::SourceDestBuffer> sbufs;
+         sbufs.emplace_back( imf, "x", x[0].data(), 1 );
+
+         try
+         {
+            other.writer( sbufs );
+            FAIL() << "Expected ErrorTooManyWriters";
+         }
+         catch ( e57::E57Exception &err )
+         {
+            EXPECT_EQ( err.errorCode(), e57::ErrorTooManyWriters );
+         }
+
+         try
+         {
+            e57::BlobNode blob( imf, 10 );
+            FAIL() << "Expected ErrorTooManyWriters";
+         }
+         catch ( e57::E57Exception &err )
+         {
+            EXPECT_EQ( err.errorCode(), e57::ErrorTooManyWriters );
+         }
+      }
+
+      // Write & close each scan on its own thread
+      std::vector<std::thread> threads;
+
+      for ( size_t scan = 0; scan < cNumRecords.size(); ++scan )
+      {
+         threads.emplace_back( [&, scan]() {
+            for ( size_t written = 0; written < cNumRecords[scan]; )
+            {
+               const size_t cCount = std::min( cBlockSize, cNumRecords[scan] - written );
+
+               std::copy_n( x[scan].begin() + written, cCount, xBlocks[scan].begin() );
+               std::copy_n( index[scan].begin() + written, cCount, indexBlocks[scan].begin() );
+
+               writers[scan].write( cCount );
+               written += cCount;
+            }
+
+            writers[scan].close();
+         } );
+      }
+
+      for ( auto &thread : threads )
+      {
+         thread.join();
+      }
+
+      EXPECT_EQ( imf.writerCount(), 0 );
+
+      // Once they're closed, a blob can be added again
+      e57::BlobNode blob( imf, 10 );
+      imf.root().set( "blob", blob );
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./ConcurrentWriters.e57", "r" );
+
+   for ( size_t scan = 0; scan < cNumRecords.size(); ++scan )
+   {
+      SCOPED_TRACE( scan );
+
+      e57::CompressedVectorNode points( imf.root().get( "points" + std::to_string( scan ) ) );
+
+      ASSERT_EQ( points.childCount(), static_cast<int64_t>( cNumRecords[scan] ) );
+
+      if ( cNumRecords[scan] > 1 )
+      {
+         EXPECT_GT( points.impl()->readChunkIndex().size(), 1u );
+      }
+
+      std::vector<double> x( cNumRecords[scan] );
+      std::vector<int32_t> index( cNumRecords[scan] );
+
+      std::vector<e57::SourceDestBuffer> dbufs;
+      dbufs.emplace_back( imf, "x", x.data(), x.size() );
+      dbufs.emplace_back( imf, "index", index.data(), index.size() );
+
+      ASSERT_EQ( points.readParallel( dbufs, 4 ), cNumRecords[scan] );
+
+      for ( size_t i = 0; i < cNumRecords[scan]; ++i )
+      {
+         ASSERT_EQ( x[i], xValue( scan, i ) );
+         ASSERT_EQ( index[i], static_cast<int32_t>( i ) );
+      }
+   }
+}
+
+TEST( SimpleWriter, MergeFiles )
+{
+   constexpr int64_t cNumPoints = 150000;
+
+   const auto writeScan = []( e57::Writer &writer, const char *guid, double offset ) {
+      e57::Data3D header;
+      header.guid = guid;
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = offset + static_cast<double>( i );
+         pointsData.cartesianY[i] = offset - static_cast<double>( i );
+         pointsData.cartesianZ[i] = offset;
+      }
+
+      writer.WriteData3DData( header, pointsData );
+   };
+
+   const auto writeImage = []( e57::Writer &writer, const char *guid, const char *scanGuid,
+                               std::vector<uint8_t> &bytes ) {
+      e57::Image2D header;
+      header.guid = guid;
+      header.associatedData3DGuid = scanGuid;
+      header.pinholeRepresentation.imageWidth = 10;
+      header.pinholeRepresentation.imageHeight = 10;
+      header.pinholeRepresentation.jpegImageSize = static_cast<int64_t>( bytes.size() );
+      header.pinholeRepresentation.focalLength = 0.01;
+      header.pinholeRepresentation.pixelWidth = 0.001;
+      header.pinholeRepresentation.pixelHeight = 0.001;
+
+      writer.WriteImage2DData( header, e57::ImageJPEG, e57::ProjectionPinhole, 0, bytes.data(),
+                               static_cast<int64_t>( bytes.size() ) );
+   };
+
+   std::vector<uint8_t> image0( 300001 );
+   std::vector<uint8_t> image1( 999 );
+
+   for ( size_t i = 0; i < image0.size(); ++i )
+   {
+      image0[i] = static_cast<uint8_t>( i * 7 );
+   }
+
+   for ( size_t i = 0; i < image1.size(); ++i )
+   {
+      image1[i] = static_cast<uint8_t>( i * 3 );
+   }
+
+   {
+      e57::Writer writer( "./MergeInput0.e57", e57::WriterOptions() );
+      writeScan( writer, "Merge Scan A", 0.0 );
+      writeScan( writer, "Merge Scan B", 1.0e6 );
+      writeImage( writer, "Merge Image 0", "Merge Scan B", image0 );
+   }
+
+   // The second input uses the guid of a scan of the first
+   {
+      e57::Writer writer( "./MergeInput1.e57", e57::WriterOptions() );
+      writeScan( writer, "Merge Scan A", 2.0e6 );
+      writeImage( writer, "Merge Image 1", "Merge Scan A", image1 );
+   }
+
+   {
+      e57::Writer writer( "./MergeInput2.e57", e57::WriterOptions() );
+      writeScan( writer, "Merge Scan C", 3.0e6 );
+   }
+
+   const std::vector<e57::ustring> cInputs = { "./MergeInput0.e57", "./MergeInput1.e57",
+                                              "./MergeInput2.e57" };
+
+   // Read ahead less than a block, so the threads have to wait for the copy
+   e57::MergeOptions mergeOptions;
+   mergeOptions.threadCount = 2;
+   mergeOptions.readAheadBytes = 1000;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Merged File GUID";
+
+      e57::Writer writer( "./MergeFiles.e57", options );
+
+      const e57::MergeReport cReport = writer.MergeFrom( cInputs, mergeOptions );
+
+      EXPECT_EQ( cReport.data3DCount, 4 );
+      EXPECT_EQ( cReport.images2DCount, 2 );
+      EXPECT_GT( cReport.bytesCopied, static_cast<uint64_t>( 4 * cNumPoints * 3 * 8 ) );
+
+      // A missing input is reported
+      try
+      {
+         writer.MergeFrom( { "./MergeMissing.e57" } );
+         FAIL() << "Expected ErrorOpenFailed";
+      }
+      catch ( e57::E57Exception &err )
+      {
+         EXPECT_EQ( err.errorCode(), e57::ErrorOpenFailed );
+      }
+   }
+
+   e57::Reader reader( "./MergeFiles.e57", {} );
+
+   e57::E57Root fileHeader;
+   reader.GetE57Root( fileHeader );
+
+   EXPECT_EQ( fileHeader.guid, "Merged File GUID" );
+   ASSERT_EQ( reader.GetData3DCount(), 4 );
+   ASSERT_EQ( reader.GetImage2DCount(), 2 );
+
+   std::vector<e57::Data3D> scans( 4 );
+
+   for ( int64_t scan = 0; scan < 4; ++scan )
+   {
+      SCOPED_TRACE( scan );
+
+      ASSERT_TRUE( reader.ReadData3D( scan, scans[scan] ) );
+      ASSERT_EQ( scans[scan].pointCount, cNumPoints );
+
+      e57::Data3DPointsDouble pointsData( scans[scan] );
+
+      auto vectorReader = reader.SetUpData3DPointsData( scan, cNumPoints, pointsData );
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+      vectorReader.close();
+
+      const double cOffset = static_cast<double>( scan ) * 1.0e6;
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         ASSERT_EQ( pointsData.cartesianX[i], cOffset + static_cast<double>( i ) );
+         ASSERT_EQ( pointsData.cartesianY[i], cOffset - static_cast<double>( i ) );
+      }
+   }
+
+   // The repeated guid was replaced, keeping the old one in originalGuids
+   EXPECT_EQ( scans[0].guid, "Merge Scan A" );
+   EXPECT_EQ( scans[1].guid, "Merge Scan B" );
+   EXPECT_NE( scans[2].guid, "Merge Scan A" );
+   ASSERT_EQ( scans[2].originalGuids.size(), 1u );
+   EXPECT_EQ( scans[2].originalGuids[0], "Merge Scan A" );
+   EXPECT_EQ( scans[3].guid, "Merge Scan C" );
+
+   e57::Image2D images[2];
+   ASSERT_TRUE( reader.ReadImage2D( 0, images[0] ) );
+   ASSERT_TRUE( reader.ReadImage2D( 1, images[1] ) );
+
+   EXPECT_EQ( images[0].guid, "Merge Image 0" );
+   EXPECT_EQ( images[0].associatedData3DGuid, "Merge Scan B" );
+   EXPECT_EQ( images[1].guid, "Merge Image 1" );
+   EXPECT_EQ( images[1].associatedData3DGuid, scans[2].guid );
+
+   std::vector<uint8_t> read0( image0.size() );
+   std::vector<uint8_t> read1( image1.size() );
+
+   EXPECT_EQ( reader.ReadImage2DData( 0, e57::ProjectionPinhole, e57::ImageJPEG, read0.data(), 0,
+                                      static_cast<int64_t>( read0.size() ) ),
+              static_cast<int64_t>( read0.size() ) );
+   EXPECT_EQ( reader.ReadImage2DData( 1, e57::ProjectionPinhole, e57::ImageJPEG, read1.data(), 0,
+                                      static_cast<int64_t>( read1.size() ) ),
+              static_cast<int64_t>( read1.size() ) );
+
+   EXPECT_EQ( read0, image0 );
+   EXPECT_EQ( read1, image1 );
+}
+
+TEST( SimpleWriter, IndexPacketInterval )
+{
+   constexpr size_t cNumRecords = 400000;
+
+   const auto writeNode = [&]( e57::ImageFile &imf, const char *name, unsigned interval ) {
+      e57::StructureNode proto( imf );
+      proto.set( "x", e57::FloatNode( imf ) );
+      proto.set( "index", e57::IntegerNode( imf, 0, 0, static_cast<int64_t>( cNumRecords ) ) );
+
+      e57::VectorNode codecs( imf, true );
+      e57::CompressedVectorNode points( imf, proto, codecs );
+      imf.root().set( name, points );
+
+      std::vector<double> x( cNumRecords );
+      std::vector<int64_t> index( cNumRecords );
+
+      for ( size_t i = 0; i < cNumRecords; ++i )
+      {
+         x[i] = static_cast<double>( i ) * 0.5;
+         index[i] = static_cast<int64_t>( i );
+      }
+
+      std::vector<e57::SourceDestBuffer> sbufs;
+      sbufs.emplace_back( imf, "x", x.data(), cNumRecords );
+      sbufs.emplace_back( imf, "index", index.data(), cNumRecords );
+
+      e57::CompressedVectorWriterOptions options;
+      options.indexPacketInterval = interval;
+
+      e57::CompressedVectorWriter writer = points.writer( sbufs, options );
+      writer.write( cNumRecords );
+      writer.close();
+   };
+
+   {
+      e57::ImageFile imf( "./IndexPacketInterval.e57", "w" );
+
+      writeNode( imf, "coarse", 0 );
+      writeNode( imf, "fine", 1 );
+
+      imf.close();
+   }
+
+   e57::ImageFile imf( "./IndexPacketInterval.e57", "r" );
+
+   const auto cCoarse = e57::CompressedVectorNode( imf.root().get( "coarse" ) ).readIndex();
+
+   e57::CompressedVectorNode fine( imf.root().get( "fine" ) );
+   const auto cFine = fine.readIndex();
+
+   // About 4 MB of records, in chunks of about 1 MB or 64 KB
+   EXPECT_GE( cCoarse.size(), 2u );
+   EXPECT_LE( cCoarse.size(), 8u );
+   EXPECT_GE( cFine.size(), 40u );
+
+   uint64_t nextRecord = 0;
+
+   for ( const auto &chunk : cFine )
+   {
+      ASSERT_EQ( chunk.firstRecord, nextRecord );
+      ASSERT_GT( chunk.recordCount, 0u );
+
+      nextRecord += chunk.recordCount;
+   }
+
+   EXPECT_EQ( nextRecord, cNumRecords );
+
+   // Reading can start at each chunk
+   std::vector<int64_t> index( 1 );
+   std::vector<e57::SourceDestBuffer> dbufs;
+   dbufs.emplace_back( imf, "index", index.data(), 1 );
+
+   e57::CompressedVectorReader reader = fine.reader( dbufs );
+
+   for ( size_t i = 0; i < cFine.size(); i += 7 )
+   {
+      reader.seek( static_cast<int64_t>( cFine[i].firstRecord ) );
+
+      ASSERT_EQ( reader.read(), 1u );
+      ASSERT_EQ( index[0], static_cast<int64_t>( cFine[i].firstRecord ) );
+   }
+
+   reader.close();
+}
+
+// Consecutive positions along the Hilbert curve are neighbouring cells, and the first 8^3
+// positions fill the first 8x8x8 block.
+TEST( SimpleWriter, HilbertKeys )
+{
+   std::vector<std::pair<uint64_t, std::array<int, 3>>> cells;
+
+   for ( int x = 0; x < 8; ++x )
+   {
+      for ( int y = 0; y < 8; ++y )
+      {
+         for ( int z = 0; z < 8; ++z )
+         {
+            const uint64_t cKey = e57::PointOrdering::hilbertKey( x, y, z );
+
+            cells.push_back( { cKey, { x, y, z } } );
+         }
+      }
+   }
+
+   std::sort( cells.begin(), cells.end() );
+
+   for ( size_t i = 0; i < cells.size(); ++i )
+   {
+      ASSERT_EQ( cells[i].first, i );
+
+      if ( i > 0 )
+      {
+         int distance = 0;
+
+         for ( int axis = 0; axis < 3; ++axis )
+         {
+            distance += std::abs( cells[i].second[axis] - cells[i - 1].second[axis] );
+         }
+
+         EXPECT_EQ( distance, 1 );
+      }
+   }
+
+   EXPECT_EQ( e57::PointOrdering::mortonKey( 1, 0, 0 ), 4u );
+   EXPECT_EQ( e57::PointOrdering::mortonKey( 0, 1, 1 ), 3u );
+   EXPECT_EQ( e57::PointOrdering::mortonKey( 2, 0, 0 ), 32u );
+}
+
+TEST( SimpleWriter, PointOrder )
+{
+   constexpr int64_t cNumPoints = 200000;
+   constexpr int64_t cInvalidStep = 97;
+
+   e57::WriterOptions options;
+   options.guid = "Point Order File GUID";
+   options.pointOrder = e57::PointOrderHilbert;
+
+   // Chunks of one data packet, so the chunk statistics are fine enough to find a small box
+   options.compressedVectorWriter.indexPacketInterval = 1;
+
+   e57::Data3D header;
+   header.guid = "Point Order Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.cartesianInvalidStateField = true;
+   header.pointFields.timeStampField = true;
+   header.pointFields.timeMaximum = static_cast<double>( cNumPoints );
+   header.pointFields.pointRangeScale = 0.001;
+   header.pointFields.pointRangeMinimum = -100.0;
+   header.pointFields.pointRangeMaximum = 100.0;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   Random::seed( 42 );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      // Scattered over a 100 m cube, with the time stamp identifying the point
+      pointsData.cartesianX[i] = std::round( Random::num() * 100000.0 ) * 0.001;
+      pointsData.cartesianY[i] = std::round( Random::num() * 100000.0 ) * 0.001;
+      pointsData.cartesianZ[i] = std::round( Random::num() * 100000.0 ) * 0.001;
+      pointsData.cartesianInvalidState[i] = ( i % cInvalidStep == 0 ) ? 2 : 0;
+      pointsData.timeStamp[i] = static_cast<double>( i );
+   }
+
+   {
+      e57::Writer writer( "./PointOrder.e57", options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::Reader reader( "./PointOrder.e57", {} );
+
+   // The curve is recorded in the scan
+   const e57::StructureNode cScan( reader.GetRawData3D().get( 0 ) );
+   ASSERT_TRUE( cScan.isDefined( "libe57po:pointOrder/curve" ) );
+   EXPECT_EQ( e57::StringNode( cScan.get( "libe57po:pointOrder/curve" ) ).value(), "hilbert" );
+   EXPECT_EQ( e57::FloatNode( cScan.get( "libe57po:pointOrder/bounds/xMaximum" ) ).value(),
+              100.0 );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+   ASSERT_EQ( readHeader.pointCount, cNumPoints );
+
+   e57::Data3DPointsDouble readData( readHeader );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, readData );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+   // Every point is written once, with its own values, and the invalid ones come last in their
+   // original order
+   std::vector<bool> seen( cNumPoints, false );
+   constexpr int64_t cInvalidCount = ( cNumPoints + cInvalidStep - 1 ) / cInvalidStep;
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      const auto cIndex = static_cast<int64_t>( readData.timeStamp[i] );
+
+      ASSERT_LT( cIndex, cNumPoints );
+      ASSERT_FALSE( seen[cIndex] );
+      seen[cIndex] = true;
+
+      EXPECT_NEAR( readData.cartesianX[i], pointsData.cartesianX[cIndex], 0.0005 );
+      EXPECT_NEAR( readData.cartesianZ[i], pointsData.cartesianZ[cIndex], 0.0005 );
+
+      if ( i >= cNumPoints - cInvalidCount )
+      {
+         EXPECT_EQ( cIndex, ( i - ( cNumPoints - cInvalidCount ) ) * cInvalidStep );
+      }
+      else
+      {
+         EXPECT_EQ( readData.cartesianInvalidState[i], 0 );
+      }
+   }
+
+   // A small box only matches a few of the chunks
+   const auto cRanges = vectorReader.matchingRecordRanges(
+      { { "cartesianX", 10.0, 12.0 }, { "cartesianY", 40.0, 42.0 }, { "cartesianZ", 0.0, 2.0 } } );
+
+   uint64_t matching = 0;
+
+   for ( const auto &range : cRanges )
+   {
+      matching += range.recordCount;
+   }
+
+   EXPECT_GT( matching, 0u );
+   EXPECT_LT( matching, static_cast<uint64_t>( cNumPoints / 4 ) );
+
+   vectorReader.close();
+}
+
+TEST( SimpleWriter, LevelOfDetail )
+{
+   constexpr int64_t cNumPoints = 100000;
+   constexpr uint32_t cNodePointCount = 1000;
+
+   e57::WriterOptions options;
+   options.guid = "Level Of Detail File GUID";
+   options.lodNodePointCount = cNodePointCount;
+
+   e57::Data3D header;
+   header.guid = "Level Of Detail Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.cartesianInvalidStateField = true;
+
+   e57::Data3DPointsFloat pointsData( header );
+
+   Random::seed( 7 );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      pointsData.cartesianX[i] = Random::num() * 10.0f;
+      pointsData.cartesianY[i] = Random::num() * 20.0f;
+      pointsData.cartesianZ[i] = Random::num() * 5.0f;
+      pointsData.cartesianInvalidState[i] = ( i % 100 == 0 ) ? 2 : 0;
+   }
+
+   {
+      e57::Writer writer( "./LevelOfDetail.e57", options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   }
+
+   e57::Reader reader( "./LevelOfDetail.e57", {} );
+
+   // Standard readers see every point
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+   ASSERT_EQ( readHeader.pointCount, cNumPoints );
+
+   e57::Data3DPointsFloat readData( readHeader );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, readData );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+   vectorReader.close();
+
+   const std::vector<e57::LODNode> cNodes =
+      reader.ReadData3DLODNodes( 0, std::numeric_limits<int32_t>::max() );
+
+   ASSERT_GT( cNodes.size(), 1u );
+   EXPECT_EQ( cNodes[0].level, 0 );
+   EXPECT_EQ( cNodes[0].pointCount, cNodePointCount );
+
+   // The nodes hold all the valid points, coarse levels first, and each point is in the bounds
+   // of its node
+   int64_t nextPoint = 0;
+   int32_t level = 0;
+
+   for ( const auto &node : cNodes )
+   {
+      EXPECT_EQ( node.firstPoint, nextPoint );
+      EXPECT_GE( node.level, level );
+      EXPECT_LE( node.pointCount, cNodePointCount );
+
+      level = node.level;
+      nextPoint += node.pointCount;
+
+      for ( int64_t i = node.firstPoint; i < node.firstPoint + node.pointCount; ++i )
+      {
+         ASSERT_EQ( readData.cartesianInvalidState[i], 0 );
+         EXPECT_GE( readData.cartesianX[i], node.bounds.xMinimum );
+         EXPECT_LE( readData.cartesianX[i], node.bounds.xMaximum );
+         EXPECT_GE( readData.cartesianY[i], node.bounds.yMinimum );
+         EXPECT_LE( readData.cartesianY[i], node.bounds.yMaximum );
+         EXPECT_GE( readData.cartesianZ[i], node.bounds.zMinimum );
+         EXPECT_LE( readData.cartesianZ[i], node.bounds.zMaximum );
+      }
+   }
+
+   EXPECT_EQ( nextPoint, cNumPoints - cNumPoints / 100 );
+
+   // Coarse levels in part of the scan
+   e57::CartesianBounds box;
+   box.xMinimum = 1.0;
+   box.xMaximum = 2.0;
+   box.yMinimum = 1.0;
+   box.yMaximum = 2.0;
+   box.zMinimum = 1.0;
+   box.zMaximum = 2.0;
+
+   const std::vector<e57::LODNode> cCoarse = reader.ReadData3DLODNodes( 0, 2, box );
+
+   ASSERT_FALSE( cCoarse.empty() );
+   EXPECT_LT( cCoarse.size(), cNodes.size() );
+
+   for ( const auto &node : cCoarse )
+   {
+      EXPECT_LE( node.level, 2 );
+      EXPECT_LE( node.bounds.xMinimum, box.xMaximum );
+      EXPECT_GE( node.bounds.xMaximum, box.xMinimum );
+   }
+
+   // A scan without an octree
+   EXPECT_TRUE( reader.ReadData3DLODNodes( 1, 10 ).empty() );
+}
+
+TEST( SimpleWriter, DeltaCodec )
+{
+   constexpr int64_t cNumPoints = 150000;
+
+   e57::Data3D header;
+   header.guid = "Delta Codec Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+   header.pointFields.pointRangeScale = 0.001;
+   header.pointFields.pointRangeMinimum = -1000.0;
+   header.pointFields.pointRangeMaximum = 1000.0;
+   header.pointFields.intensityField = true;
+   header.pointFields.intensityNodeType = e57::NumericalNodeType::Integer;
+   header.intensityLimits.intensityMinimum = 0.0;
+   header.intensityLimits.intensityMaximum = 4095.0;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      // A slowly varying profile, like a scan in acquisition order
+      const double cAngle = static_cast<double>( i ) * 0.001;
+
+      pointsData.cartesianX[i] = std::round( 500.0 * std::cos( cAngle ) * 1000.0 ) * 0.001;
+      pointsData.cartesianY[i] = std::round( 500.0 * std::sin( cAngle ) * 1000.0 ) * 0.001;
+      pointsData.cartesianZ[i] = static_cast<double>( ( i / 1000 ) % 100 ) - 50.0;
+      pointsData.intensity[i] = static_cast<double>( ( i * 7 ) % 4096 );
+   }
+
+   auto write = [&]( const char *fileName, const std::vector<e57::ustring> &deltaCodecFields ) {
+      e57::WriterOptions options;
+      options.guid = "Delta Codec File GUID";
+      options.compressedVectorWriter.deltaCodecFields = deltaCodecFields;
+
+      e57::Writer writer( fileName, options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   };
+
+   write( "./DeltaCodecBitPack.e57", {} );
+   write( "./DeltaCodec.e57", { "cartesianX", "cartesianY", "cartesianZ", "intensity" } );
+
+   // The coordinates change little from one point to the next, so their deltas are much smaller
+   auto fileSize = []( const char *fileName ) {
+      std::ifstream file( fileName, std::ios::binary | std::ios::ate );
+      return static_cast<int64_t>( file.tellg() );
+   };
+
+   EXPECT_LT( fileSize( "./DeltaCodec.e57" ), fileSize( "./DeltaCodecBitPack.e57" ) * 3 / 4 );
+
+   e57::Reader reader( "./DeltaCodec.e57", {} );
+
+   // The codec of each field is recorded in the codecs
+   const e57::StructureNode cScan( reader.GetRawData3D().get( 0 ) );
+   const e57::CompressedVectorNode cPoints( cScan.get( "points" ) );
+   const e57::VectorNode cCodecs( cPoints.codecs() );
+
+   ASSERT_EQ( cCodecs.childCount(), 4 );
+   EXPECT_EQ( e57::StringNode( cCodecs.get( "0/inputs/0" ) ).value(), "cartesianX" );
+   EXPECT_TRUE( cCodecs.isDefined( "0/libe57codec:deltaIntegerCodec" ) );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+   e57::Data3DPointsDouble readData( readHeader );
+
+   auto checkPoint = [&]( int64_t readIndex, int64_t pointIndex ) {
+      ASSERT_EQ( readData.cartesianX[readIndex], pointsData.cartesianX[pointIndex] );
+      ASSERT_EQ( readData.cartesianY[readIndex], pointsData.cartesianY[pointIndex] );
+      ASSERT_EQ( readData.cartesianZ[readIndex], pointsData.cartesianZ[pointIndex] );
+      ASSERT_EQ( readData.intensity[readIndex], pointsData.intensity[pointIndex] );
+   };
+
+   {
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, readData );
+
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         checkPoint( i, i );
+      }
+   }
+
+   // Seeking restarts at the block of the chunk holding the record, and sampling skips values
+   // within the blocks
+   {
+      constexpr int64_t cFirst = 100003;
+      constexpr int64_t cStep = 7;
+
+      auto vectorReader = reader.SetUpData3DPointsData( 0, 1000, readData );
+
+      e57::RecordSampling sampling;
+      sampling.step = cStep;
+      vectorReader.setSampling( sampling );
+      vectorReader.seek( cFirst );
+
+      int64_t record = cFirst + ( cStep - cFirst % cStep ) % cStep;
+
+      while ( const unsigned cCount = vectorReader.read() )
+      {
+         for ( unsigned i = 0; i < cCount; ++i, record += cStep )
+         {
+            checkPoint( i, record );
+         }
+      }
+
+      EXPECT_GE( record, cNumPoints );
+   }
+}
+
+TEST( SimpleWriter, LzCompress )
+{
+   Random::seed( 7 );
+
+   // Repetitive bytes shrink, random ones only grow by the bound, and both round-trip
+   std::vector<char> repetitive( 20000 );
+   std::vector<char> random( 20000 );
+
+   for ( size_t i = 0; i < repetitive.size(); ++i )
+   {
+      repetitive[i] = static_cast<char>( ( i / 3 ) % 17 );
+      random[i] = static_cast<char>( Random::num() * 256.0 );
+   }
+
+   for ( const auto *bytes : { &repetitive, &random } )
+   {
+      std::vector<char> compressed( e57::lzMaxCompressedSize( bytes->size() ) );
+      const size_t cSize = e57::lzCompress( bytes->data(), bytes->size(), compressed.data() );
+
+      ASSERT_LE( cSize, compressed.size() );
+
+      std::vector<char> decompressed( bytes->size() );
+      e57::lzDecompress( compressed.data(), cSize, decompressed.data(), decompressed.size() );
+
+      EXPECT_EQ( decompressed, *bytes );
+
+      // Truncated input is reported rather than overrunning the output
+      E57_ASSERT_THROW( e57::lzDecompress( compressed.data(), cSize / 2, decompressed.data(),
+                                           decompressed.size() ) );
+   }
+
+   std::vector<char> compressed( e57::lzMaxCompressedSize( repetitive.size() ) );
+   EXPECT_LT( e57::lzCompress( repetitive.data(), repetitive.size(), compressed.data() ), 1000u );
+}
+
+TEST( SimpleWriter, LzCodec )
+{
+   constexpr int64_t cNumPoints = 120000;
+
+   e57::Data3D header;
+   header.guid = "LZ Codec Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.cartesianInvalidStateField = true;
+   header.pointFields.colorRedField = true;
+   header.pointFields.colorGreenField = true;
+   header.pointFields.colorBlueField = true;
+   header.colorLimits.colorRedMaximum = 255;
+   header.colorLimits.colorGreenMaximum = 255;
+   header.colorLimits.colorBlueMaximum = 255;
+   header.pointFields.intensityField = true;
+   header.pointFields.intensityNodeType = e57::NumericalNodeType::Integer;
+   header.intensityLimits.intensityMinimum = 0.0;
+   header.intensityLimits.intensityMaximum = 4095.0;
+
+   e57::Data3DPointsFloat pointsData( header );
+
+   Random::seed( 11 );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      pointsData.cartesianX[i] = static_cast<float>( Random::num() * 10.0 );
+      pointsData.cartesianY[i] = static_cast<float>( i );
+      pointsData.cartesianZ[i] = static_cast<float>( i % 100 );
+      pointsData.cartesianInvalidState[i] = ( i % 1000 == 0 ) ? 1 : 0;
+
+      // Patches of colour & intensity, as in a scan of a building
+      pointsData.colorRed[i] = static_cast<uint16_t>( ( i / 500 ) % 256 );
+      pointsData.colorGreen[i] = static_cast<uint16_t>( ( i / 300 ) % 200 );
+      pointsData.colorBlue[i] = 128;
+      pointsData.intensity[i] = static_cast<float>( ( i / 50 ) % 4096 );
+   }
+
+   auto write = [&]( const char *fileName, const std::vector<e57::ustring> &lzCodecFields ) {
+      e57::WriterOptions options;
+      options.guid = "LZ Codec File GUID";
+      options.compressedVectorWriter.lzCodecFields = lzCodecFields;
+
+      // Chunks of one data packet, so the blocks have to restart often
+      options.compressedVectorWriter.indexPacketInterval = 1;
+
+      e57::Writer writer( fileName, options );
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( header, pointsData ) );
+   };
+
+   write( "./LzCodecBitPack.e57", {} );
+   write( "./LzCodec.e57", { "cartesianY", "cartesianZ", "cartesianInvalidState", "colorRed",
+                             "colorGreen", "colorBlue", "intensity" } );
+
+   auto fileSize = []( const char *fileName ) {
+      std::ifstream file( fileName, std::ios::binary | std::ios::ate );
+      return static_cast<int64_t>( file.tellg() );
+   };
+
+   EXPECT_LT( fileSize( "./LzCodec.e57" ), fileSize( "./LzCodecBitPack.e57" ) * 3 / 4 );
+
+   e57::Reader reader( "./LzCodec.e57", {} );
+
+   const e57::StructureNode cScan( reader.GetRawData3D().get( 0 ) );
+   const e57::CompressedVectorNode cPoints( cScan.get( "points" ) );
+   const e57::VectorNode cCodecs( cPoints.codecs() );
+
+   ASSERT_EQ( cCodecs.childCount(), 7 );
+   EXPECT_TRUE( cCodecs.isDefined( "0/libe57codec:lzCodec" ) );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+   e57::Data3DPointsFloat readData( readHeader );
+
+   auto checkPoint = [&]( int64_t readIndex, int64_t pointIndex ) {
+      ASSERT_EQ( readData.cartesianX[readIndex], pointsData.cartesianX[pointIndex] );
+      ASSERT_EQ( readData.cartesianY[readIndex], pointsData.cartesianY[pointIndex] );
+      ASSERT_EQ( readData.cartesianZ[readIndex], pointsData.cartesianZ[pointIndex] );
+      ASSERT_EQ( readData.cartesianInvalidState[readIndex],
+                 pointsData.cartesianInvalidState[pointIndex] );
+      ASSERT_EQ( readData.colorRed[readIndex], pointsData.colorRed[pointIndex] );
+      ASSERT_EQ( readData.colorGreen[readIndex], pointsData.colorGreen[pointIndex] );
+      ASSERT_EQ( readData.colorBlue[readIndex], pointsData.colorBlue[pointIndex] );
+      ASSERT_EQ( readData.intensity[readIndex], pointsData.intensity[pointIndex] );
+   };
+
+   // Small buffers, so the blocks are decoded a piece at a time
+   {
+      constexpr int64_t cBufferSize = 777;
+
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cBufferSize, readData );
+      int64_t record = 0;
+
+      while ( const unsigned cCount = vectorReader.read() )
+      {
+         for ( unsigned i = 0; i < cCount; ++i, ++record )
+         {
+            checkPoint( i, record );
+         }
+      }
+
+      EXPECT_EQ( record, cNumPoints );
+   }
+
+   // Each chunk starts with a block, so seeking and reading chunks in parallel work
+   {
+      constexpr int64_t cFirst = 65432;
+
+      auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, readData );
+
+      vectorReader.seek( cFirst );
+      ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints - cFirst ) );
+
+      for ( int64_t i = 0; i < cNumPoints - cFirst; ++i )
+      {
+         checkPoint( i, cFirst + i );
+      }
+   }
+
+   {
+      e57::ParallelReadOptions parallelOptions;
+      parallelOptions.threadCount = 4;
+
+      const auto cCounts = reader.ReadData3DPointsDataParallel( { 0 }, { &readData },
+                                                                parallelOptions );
+
+      ASSERT_EQ( cCounts.at( 0 ), static_cast<uint64_t>( cNumPoints ) );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         checkPoint( i, i );
+      }
+   }
+}
+
+TEST( SimpleWriter, Quantization )
+{
+   constexpr int64_t cNumPoints = 50000;
+   constexpr double cPrecision = 0.0001;
+
+   e57::Data3D header;
+   header.guid = "Quantization Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.pointRangeNodeType = e57::NumericalNodeType::Double;
+
+   e57::Data3DPointsDouble pointsData( header );
+
+   Random::seed( 3 );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      pointsData.cartesianX[i] = Random::num() * 200.0 - 100.0;
+      pointsData.cartesianY[i] = Random::num() * 50.0;
+      pointsData.cartesianZ[i] = Random::num() * 10.0 - 2.0;
+   }
+
+   auto write = [&]( const char *fileName, double precision, e57::Data3D &data3DHeader ) {
+      e57::WriterOptions options;
+      options.guid = "Quantization File GUID";
+      options.pointPrecision = precision;
+
+      e57::Writer writer( fileName, options );
+
+      data3DHeader = header;
+
+      E57_ASSERT_NO_THROW( writer.WriteData3DData( data3DHeader, pointsData ) );
+   };
+
+   e57::Data3D unquantized;
+   e57::Data3D written;
+
+   write( "./QuantizationDouble.e57", 0.0, unquantized );
+   write( "./Quantization.e57", cPrecision, written );
+
+   // The header tells what was used
+   EXPECT_EQ( written.pointFields.pointRangeNodeType, e57::NumericalNodeType::ScaledInteger );
+   EXPECT_EQ( written.pointFields.pointRangeScale, cPrecision );
+   EXPECT_GE( written.pointFields.pointRangeMinimum, -100.0 );
+   EXPECT_LE( written.pointFields.pointRangeMaximum, 100.0 );
+
+   // 200 m at 0.1 mm takes 21 bits instead of 64
+   auto fileSize = []( const char *fileName ) {
+      std::ifstream file( fileName, std::ios::binary | std::ios::ate );
+      return static_cast<int64_t>( file.tellg() );
+   };
+
+   EXPECT_LT( fileSize( "./Quantization.e57" ), fileSize( "./QuantizationDouble.e57" ) * 2 / 5 );
+
+   e57::Reader reader( "./Quantization.e57", {} );
+
+   const e57::StructureNode cScan( reader.GetRawData3D().get( 0 ) );
+   const e57::CompressedVectorNode cPoints( cScan.get( "points" ) );
+   const e57::ScaledIntegerNode cX( e57::StructureNode( cPoints.prototype() ).get( "cartesianX" ) );
+
+   EXPECT_EQ( cX.scale(), cPrecision );
+   EXPECT_LE( cX.maximum() - cX.minimum(), int64_t( 2000000 ) );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+   EXPECT_EQ( readHeader.pointFields.pointRangeNodeType, e57::NumericalNodeType::ScaledInteger );
+
+   e57::Data3DPointsDouble readData( readHeader );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, readData );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+
+   for ( int64_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_NEAR( readData.cartesianX[i], pointsData.cartesianX[i], cPrecision * 0.5001 );
+      ASSERT_NEAR( readData.cartesianY[i], pointsData.cartesianY[i], cPrecision * 0.5001 );
+      ASSERT_NEAR( readData.cartesianZ[i], pointsData.cartesianZ[i], cPrecision * 0.5001 );
+   }
+}
+
+TEST( SimpleWriter, RawScaledIntegers )
+{
+   constexpr size_t cNumPoints = 20000;
+   constexpr double cScale = 0.0005;
+
+   // Coordinates already in ticks of the scale, as a scanner produces them
+   struct TickPoint
+   {
+      int32_t xyz[3];
+      uint16_t intensity;
+   };
+
+   std::vector<TickPoint> tickPoints( cNumPoints );
+
+   for ( size_t i = 0; i < cNumPoints; ++i )
+   {
+      auto &point = tickPoints[i];
+
+      point.xyz[0] = static_cast<int32_t>( i ) * 10 - 100000;
+      point.xyz[1] = -static_cast<int32_t>( i % 4000 );
+      point.xyz[2] = 200000;
+      point.intensity = static_cast<uint16_t>( i % 4096 );
+   }
+
+   e57::Data3D header;
+   header.guid = "Raw Scaled Integers Scan Header GUID";
+   header.pointCount = cNumPoints;
+   header.pointFields.cartesianXField = true;
+   header.pointFields.cartesianYField = true;
+   header.pointFields.cartesianZField = true;
+   header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+   header.pointFields.pointRangeScale = cScale;
+   header.pointFields.pointRangeMinimum = -100.0;
+   header.pointFields.pointRangeMaximum = 100.0;
+   header.pointFields.intensityField = true;
+   header.pointFields.intensityNodeType = e57::NumericalNodeType::Integer;
+   header.intensityLimits.intensityMaximum = 4095.0;
+
+   e57::Data3DPointsInterleaved buffers( sizeof( TickPoint ) );
+   buffers.addRaw( "cartesianX", &tickPoints[0].xyz[0] )
+      .addRaw( "cartesianY", &tickPoints[0].xyz[1] )
+      .addRaw( "cartesianZ", &tickPoints[0].xyz[2] )
+      .addRaw( "intensity", &tickPoints[0].intensity );
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Raw Scaled Integers File GUID";
+
+      e57::Writer writer( "./RawScaledIntegers.e57", options );
+
+      const int64_t cScanIndex = writer.NewData3D( header );
+
+      auto vectorWriter = writer.SetUpData3DPointsData( cScanIndex, cNumPoints, buffers );
+      E57_ASSERT_NO_THROW( vectorWriter.write( cNumPoints ) );
+      vectorWriter.close();
+   }
+
+   e57::Reader reader( "./RawScaledIntegers.e57", {} );
+
+   e57::Data3D readHeader;
+   ASSERT_TRUE( reader.ReadData3D( 0, readHeader ) );
+
+   e57::Data3DPointsDouble readData( readHeader );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, readData );
+
+   ASSERT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+   vectorReader.close();
+
+   for ( size_t i = 0; i < cNumPoints; ++i )
+   {
+      ASSERT_NEAR( readData.cartesianX[i], tickPoints[i].xyz[0] * cScale, 1.0e-9 );
+      ASSERT_NEAR( readData.cartesianY[i], tickPoints[i].xyz[1] * cScale, 1.0e-9 );
+      ASSERT_NEAR( readData.cartesianZ[i], 100.0, 1.0e-9 );
+      ASSERT_EQ( readData.intensity[i], static_cast<double>( i % 4096 ) );
+   }
+
+   // The ticks are still checked against the limits of the fields
+   tickPoints[cNumPoints / 2].xyz[2] = 200001;
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Raw Scaled Integers File GUID";
+
+      e57::Writer writer( "./RawScaledIntegers.e57", options );
+
+      const int64_t cScanIndex = writer.NewData3D( header );
+
+      auto vectorWriter = writer.SetUpData3DPointsData( cScanIndex, cNumPoints, buffers );
+
+      try
+      {
+         vectorWriter.write( cNumPoints );
+         FAIL() << "Expected ErrorValueOutOfBounds";
+      }
+      catch ( e57::E57Exception &err )
+      {
+         EXPECT_EQ( err.errorCode(), e57::ErrorValueOutOfBounds );
+      }
+   }
+}
+
+TEST( SimpleWriter, InterleavedPoints )
+{
+   constexpr size_t cNumPoints = 20000;
+
+   struct WritePoint
+   {
+      double x, y, z;
+      float intensity;
+      uint8_t rgb[3];
+   };
+
+   std::vector<WritePoint> writePoints( cNumPoints );
+
+   for ( size_t i = 0; i < cNumPoints; ++i )
+   {
+      auto &point = writePoints[i];
+
+      point.x = static_cast<double>( i ) * 0.001;
+      point.y = -static_cast<double>( i ) * 0.002;
+      point.z = static_cast<double>( i % 100 );
+      point.intensity = static_cast<float>( i % 256 ) / 256.0f;
+      point.rgb[0] = static_cast<uint8_t>( i );
+      point.rgb[1] = static_cast<uint8_t>( i / 3 );
+      point.rgb[2] = static_cast<uint8_t>( i / 7 );
+   }
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Interleaved Points File GUID";
+
+      e57::Writer writer( "./InterleavedPoints.e57", options );
+
+      e57::Data3D header;
+      header.guid = "Interleaved Points Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+      header.pointFields.pointRangeNodeType = e57::NumericalNodeType::ScaledInteger;
+      header.pointFields.pointRangeScale = 0.001;
+      header.pointFields.pointRangeMinimum = -100.0;
+      header.pointFields.pointRangeMaximum = 100.0;
+      header.pointFields.intensityField = true;
+      header.intensityLimits.intensityMaximum = 1.0;
+      header.pointFields.colorRedField = true;
+      header.pointFields.colorGreenField = true;
+      header.pointFields.colorBlueField = true;
+      header.colorLimits.colorRedMaximum = 255;
+      header.colorLimits.colorGreenMaximum = 255;
+      header.colorLimits.colorBlueMaximum = 255;
+
+      const int64_t cScanIndex = writer.NewData3D( header );
+
+      e57::Data3DPointsInterleaved buffers( sizeof( WritePoint ) );
+      buffers.add( "cartesianX", &writePoints[0].x )
+         .add( "cartesianY", &writePoints[0].y )
+         .add( "cartesianZ", &writePoints[0].z )
+         .add( "intensity", &writePoints[0].intensity )
+         .add( "colorRed", &writePoints[0].rgb[0] )
+         .add( "colorGreen", &writePoints[0].rgb[1] )
+         .add( "colorBlue", &writePoints[0].rgb[2] );
+
+      auto vectorWriter = writer.SetUpData3DPointsData( cScanIndex, cNumPoints, buffers );
+      vectorWriter.write( cNumPoints );
+      vectorWriter.close();
+   }
+
+   e57::Reader reader( "./InterleavedPoints.e57", {} );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+
+   // Read into a different layout, with a field which isn't in the scan
+   struct ReadPoint
+   {
+      float xyz[3];
+      uint16_t rgb[3];
+      double timeStamp;
+      float intensity;
+   };
+
+   std::vector<ReadPoint> readPoints( cNumPoints );
+
+   for ( auto &point : readPoints )
+   {
+      point.timeStamp = -1.0;
+   }
+
+   e57::Data3DPointsInterleaved buffers( sizeof( ReadPoint ) );
+   buffers.add( "cartesianX", &readPoints[0].xyz[0] )
+      .add( "cartesianY", &readPoints[0].xyz[1] )
+      .add( "cartesianZ", &readPoints[0].xyz[2] )
+      .add( "colorRed", &readPoints[0].rgb[0] )
+      .add( "colorGreen", &readPoints[0].rgb[1] )
+      .add( "colorBlue", &readPoints[0].rgb[2] )
+      .add( "timeStamp", &readPoints[0].timeStamp )
+      .add( "intensity", &readPoints[0].intensity );
+
+   auto vectorReader = reader.SetUpData3DPointsData( 0, cNumPoints, buffers );
+   ASSERT_EQ( vectorReader.read(), cNumPoints );
+   vectorReader.close();
+
+   // The separate buffers get the same values
+   e57::Data3DPointsFloat points( header );
+
+   auto pointsReader = reader.SetUpData3DPointsData( 0, cNumPoints, points );
+   ASSERT_EQ( pointsReader.read(), cNumPoints );
+   pointsReader.close();
+
+   for ( size_t i = 0; i < cNumPoints; ++i )
+   {
+      const auto &point = readPoints[i];
+
+      ASSERT_EQ( point.xyz[0], points.cartesianX[i] ) << "point " << i;
+      ASSERT_EQ( point.xyz[1], points.cartesianY[i] ) << "point " << i;
+      ASSERT_EQ( point.xyz[2], points.cartesianZ[i] ) << "point " << i;
+      ASSERT_EQ( point.intensity, points.intensity[i] ) << "point " << i;
+      ASSERT_EQ( point.rgb[0], points.colorRed[i] ) << "point " << i;
+      ASSERT_EQ( point.rgb[1], points.colorGreen[i] ) << "point " << i;
+      ASSERT_EQ( point.rgb[2], points.colorBlue[i] ) << "point " << i;
+      ASSERT_EQ( point.timeStamp, -1.0 );
+
+      ASSERT_NEAR( point.xyz[0], writePoints[i].x, 0.0006 ) << "point " << i;
+      ASSERT_NEAR( point.xyz[1], writePoints[i].y, 0.0006 ) << "point " << i;
+      ASSERT_EQ( point.rgb[1], writePoints[i].rgb[1] ) << "point " << i;
+   }
+}
+
+TEST( SimpleWriter, MemoryWriteSink )
+{
+   constexpr int64_t cNumPoints = 20000;
+
+   auto sink = std::make_shared<e57::MemoryWriteSink>();
+
+   {
+      e57::WriterOptions options;
+      options.guid = "Memory Sink File GUID";
+
+      e57::Writer writer( sink, options );
+
+      e57::Data3D header;
+      header.guid = "Memory Sink Scan Header GUID";
+      header.pointCount = cNumPoints;
+      header.pointFields.cartesianXField = true;
+      header.pointFields.cartesianYField = true;
+      header.pointFields.cartesianZField = true;
+
+      e57::Data3DPointsDouble pointsData( header );
+
+      for ( int64_t i = 0; i < cNumPoints; ++i )
+      {
+         pointsData.cartesianX[i] = static_cast<double>( i );
+         pointsData.cartesianY[i] = -static_cast<double>( i );
+      }
+
+      writer.WriteData3DData( header, pointsData );
+
+      EXPECT_TRUE( writer.Close() );
+   }
+
+   // A whole number of pages
+   const std::vector<char> cFile = sink->takeData();
+
+   ASSERT_GT( cFile.size(), 0u );
+   EXPECT_EQ( cFile.size() % 1024, 0u );
+   EXPECT_TRUE( sink->data().empty() );
+
+   e57::Reader reader( cFile.data(), cFile.size(), {} );
+
+   e57::E57Root fileHeader;
+   ASSERT_TRUE( reader.GetE57Root( fileHeader ) );
+   EXPECT_EQ( fileHeader.guid, "Memory Sink File GUID" );
+
+   e57::Data3D header;
+   ASSERT_TRUE( reader.ReadData3D( 0, header ) );
+   ASSERT_EQ( header.pointCount, cNumPoints );
+
+   e57::Data3DPointsDouble points( header );
+   auto vectorReader = reader.SetUpData3DPointsData( 0, static_cast<size_t>( cNumPoints ), points );
+
+   EXPECT_EQ( vectorReader.read(), static_cast<unsigned>( cNumPoints ) );
+   EXPECT_EQ( points.cartesianX[cNumPoints - 1], static_cast<double>( cNumPoints - 1 ) );
+   EXPECT_EQ( points.cartesianY[cNumPoints - 1], -static_cast<double>( cNumPoints - 1 ) );
+}
+
+namespace
+{
+   // Counts the calls, and fails the writes past failAfter bytes
+   class CountingSink : public e57::MemoryWriteSink
+   {
+   public:
+      void writeAt( uint64_t offset, const char *buffer, size_t count ) override
+      {
+         if ( offset + count > failAfter )
+         {
+            throw std::runtime_error( "out of space" );
+         }
+
+         ++writeCount;
+         MemoryWriteSink::writeAt( offset, buffer, count );
+      }
+
+      void finish() override
+      {
+         ++finishCount;
+      }
+
+      void discard() override
+      {
+         ++discardCount;
+      }
+
+      uint64_t failAfter = std::numeric_limits<uint64_t>::max();
+      int writeCount = 0;
+      int finishCount = 0;
+      int discardCount = 0;
+   };
+}
+
+TEST( SimpleWriter, WriteSinkFinishDiscard )
+{
+   auto sink = std::make_shared<CountingSink>();
+
+   {
+      e57::ImageFile imf( sink );
+
+      imf.root().set( "answer", e57::IntegerNode( imf, 42 ) );
+      imf.close();
+   }
+
+   EXPECT_GT( sink->writeCount, 0 );
+   EXPECT_EQ( sink->finishCount, 1 );
+   EXPECT_EQ( sink->discardCount, 0 );
+
+   {
+      e57::ImageFile imf( sink->data().data(), sink->data().size() );
+
+      EXPECT_EQ( e57::IntegerNode( imf.root().get( "answer" ) ).value(), 42 );
+   }
+
+   // Cancelled, or never closed
+   auto cancelled = std::make_shared<CountingSink>();
+
+   e57::ImageFile( cancelled ).cancel();
+
+   {
+      e57::ImageFile imf( cancelled );
+   }
+
+   EXPECT_EQ( cancelled->finishCount, 0 );
+   EXPECT_EQ( cancelled->discardCount, 2 );
+
+   // The errors of the sink are reported as write failures
+   auto failing = std::make_shared<CountingSink>();
+   failing->failAfter = 0;
+
+   try
+   {
+      e57::ImageFile imf( failing );
+
+      imf.close();
+      FAIL() << "Expected ErrorWriteFailed";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorWriteFailed );
+   }
+
+   EXPECT_EQ( failing->finishCount, 0 );
+
+   // A sink can't be appended to
+   try
+   {
+      e57::WriterOptions options;
+      options.append = true;
+
+      e57::Writer writer( std::make_shared<e57::MemoryWriteSink>(), options );
+      FAIL() << "Expected ErrorBadAPIArgument";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorBadAPIArgument );
+   }
+}
+
 TEST( SimpleWriterData, VisualRefImage )
 {
    e57::WriterOptions options;
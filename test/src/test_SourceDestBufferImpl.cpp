@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: BSL-1.0
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "SourceDestBufferImpl.h"
+
+#include "RandomNum.h"
+
+namespace
+{
+   // Each block function must give the same results as the single value one, so fill two
+   // buffers & compare them.
+   template <typename T> struct BufferPair
+   {
+      BufferPair( e57::ImageFile &imf, size_t count, bool doConversion, bool doScaling ) :
+         single( count ), block( count ),
+         singleBuffer( imf, "value", single.data(), count, doConversion, doScaling ),
+         blockBuffer( imf, "value", block.data(), count, doConversion, doScaling )
+      {
+      }
+
+      std::vector<T> single;
+      std::vector<T> block;
+
+      e57::SourceDestBuffer singleBuffer;
+      e57::SourceDestBuffer blockBuffer;
+   };
+
+   std::vector<int64_t> randomIntegers( size_t count, int64_t minimum, int64_t maximum )
+   {
+      std::vector<int64_t> values( count );
+
+      for ( auto &value : values )
+      {
+         value = minimum + static_cast<int64_t>( Random::num() * ( maximum - minimum ) );
+      }
+
+      return values;
+   }
+}
+
+TEST( SourceDestBufferImpl, SetNextInt64Block )
+{
+   e57::ImageFile imf( "./SourceDestBufferBlock.e57", "w" );
+
+   constexpr size_t cCount = 600;
+
+   const auto values = randomIntegers( cCount, -20000, 20000 );
+
+   {
+      BufferPair<int16_t> buffers( imf, cCount, false, false );
+
+      for ( const auto value : values )
+      {
+         buffers.singleBuffer.impl()->setNextInt64( value );
+      }
+
+      buffers.blockBuffer.impl()->setNextInt64Block( values.data(), 100 );
+      buffers.blockBuffer.impl()->setNextInt64Block( values.data() + 100, cCount - 100 );
+
+      EXPECT_EQ( buffers.single, buffers.block );
+      EXPECT_EQ( buffers.blockBuffer.impl()->nextIndex(), cCount );
+   }
+
+   {
+      BufferPair<float> buffers( imf, cCount, true, true );
+
+      for ( const auto value : values )
+      {
+         buffers.singleBuffer.impl()->setNextInt64( value, 0.001, 12.5 );
+      }
+
+      buffers.blockBuffer.impl()->setNextInt64Block( values.data(), cCount, 0.001, 12.5 );
+
+      EXPECT_EQ( buffers.single, buffers.block );
+   }
+
+   {
+      BufferPair<uint8_t> buffers( imf, cCount, true, true );
+
+      for ( size_t i = 0; i < 100; ++i )
+      {
+         buffers.singleBuffer.impl()->setNextInt64( values[i] / 100, 0.5, 100.0 );
+      }
+
+      std::vector<int64_t> scaled( values.begin(), values.begin() + 100 );
+
+      for ( auto &value : scaled )
+      {
+         value /= 100;
+      }
+
+      buffers.blockBuffer.impl()->setNextInt64Block( scaled.data(), 100, 0.5, 100.0 );
+
+      EXPECT_EQ( buffers.single, buffers.block );
+   }
+
+   imf.cancel();
+}
+
+TEST( SourceDestBufferImpl, SetNextInt64BlockOutOfRange )
+{
+   e57::ImageFile imf( "./SourceDestBufferBlock.e57", "w" );
+
+   std::vector<int64_t> values( 20, 5 );
+   values[7] = 300;
+
+   std::vector<uint8_t> buffer( values.size() );
+
+   e57::SourceDestBuffer sdb( imf, "value", buffer.data(), buffer.size(), false, false );
+
+   try
+   {
+      sdb.impl()->setNextInt64Block( values.data(), values.size() );
+      FAIL() << "Expected ErrorValueNotRepresentable";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorValueNotRepresentable );
+   }
+
+   // The values before the bad one were stored
+   EXPECT_EQ( sdb.impl()->nextIndex(), 7u );
+   EXPECT_EQ( buffer[6], 5 );
+
+   imf.cancel();
+}
+
+TEST( SourceDestBufferImpl, FillNextInt64 )
+{
+   e57::ImageFile imf( "./SourceDestBufferBlock.e57", "w" );
+
+   constexpr size_t cCount = 300;
+
+   {
+      BufferPair<uint8_t> buffers( imf, cCount, false, false );
+
+      for ( size_t i = 0; i < cCount; ++i )
+      {
+         buffers.singleBuffer.impl()->setNextInt64( 7 );
+      }
+
+      buffers.blockBuffer.impl()->fillNextInt64( 7, 1 );
+      buffers.blockBuffer.impl()->fillNextInt64( 7, 0 );
+      buffers.blockBuffer.impl()->fillNextInt64( 7, cCount - 1 );
+
+      EXPECT_EQ( buffers.single, buffers.block );
+      EXPECT_EQ( buffers.blockBuffer.impl()->nextIndex(), cCount );
+   }
+
+   {
+      BufferPair<double> buffers( imf, cCount, true, true );
+
+      for ( size_t i = 0; i < cCount; ++i )
+      {
+         buffers.singleBuffer.impl()->setNextInt64( -12345, 0.001, 12.5 );
+      }
+
+      buffers.blockBuffer.impl()->fillNextInt64( -12345, cCount, 0.001, 12.5 );
+
+      EXPECT_EQ( buffers.single, buffers.block );
+   }
+
+   // Strided buffer, leaving the other members alone
+   struct Point
+   {
+      int16_t returnIndex;
+      int16_t other;
+   };
+
+   std::vector<Point> points( cCount, Point{ 0, 99 } );
+
+   e57::SourceDestBuffer strided( imf, "returnIndex", &points[0].returnIndex, cCount, false, false,
+                                  sizeof( Point ) );
+
+   strided.impl()->fillNextInt64( 3, cCount );
+
+   for ( const auto &point : points )
+   {
+      ASSERT_EQ( point.returnIndex, 3 );
+      ASSERT_EQ( point.other, 99 );
+   }
+
+   // Values which don't fit are rejected without storing anything
+   std::vector<uint8_t> small( 10 );
+   e57::SourceDestBuffer smallBuffer( imf, "value", small.data(), small.size(), false, false );
+
+   try
+   {
+      smallBuffer.impl()->fillNextInt64( 300, small.size() );
+      FAIL() << "Expected ErrorValueNotRepresentable";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorValueNotRepresentable );
+   }
+
+   EXPECT_EQ( smallBuffer.impl()->nextIndex(), 0u );
+
+   imf.cancel();
+}
+
+TEST( SourceDestBufferImpl, GetNextBlock )
+{
+   e57::ImageFile imf( "./SourceDestBufferBlock.e57", "w" );
+
+   constexpr size_t cCount = 300;
+
+   // Use a strided buffer
+   struct Point
+   {
+      double x;
+      float y;
+   };
+
+   std::vector<Point> points( cCount );
+
+   for ( auto &point : points )
+   {
+      point.x = Random::num() * 1000.0 - 500.0;
+      point.y = Random::num() * 10.0f;
+   }
+
+   e57::SourceDestBuffer xSingle( imf, "x", &points[0].x, cCount, true, true, sizeof( Point ) );
+   e57::SourceDestBuffer xBlock( imf, "x", &points[0].x, cCount, true, true, sizeof( Point ) );
+   e57::SourceDestBuffer ySingle( imf, "y", &points[0].y, cCount, true, false, sizeof( Point ) );
+   e57::SourceDestBuffer yBlock( imf, "y", &points[0].y, cCount, true, false, sizeof( Point ) );
+
+   std::vector<int64_t> single( cCount );
+   std::vector<int64_t> block( cCount );
+
+   for ( size_t i = 0; i < cCount; ++i )
+   {
+      single[i] = xSingle.impl()->getNextInt64( 0.001, -3.0 );
+   }
+
+   xBlock.impl()->getNextInt64Block( block.data(), cCount, 0.001, -3.0 );
+
+   EXPECT_EQ( single, block );
+
+   std::vector<double> singleDouble( cCount );
+   std::vector<double> blockDouble( cCount );
+
+   for ( size_t i = 0; i < cCount; ++i )
+   {
+      singleDouble[i] = ySingle.impl()->getNextDouble();
+   }
+
+   yBlock.impl()->getNextDoubleBlock( blockDouble.data(), cCount );
+
+   EXPECT_EQ( singleDouble, blockDouble );
+
+   // Doubles too large for a float are rejected
+   points[3].x = std::numeric_limits<double>::infinity();
+
+   std::vector<float> floats( cCount );
+
+   e57::SourceDestBuffer xFloat( imf, "x", &points[0].x, cCount, true, false, sizeof( Point ) );
+
+   try
+   {
+      xFloat.impl()->getNextFloatBlock( floats.data(), cCount );
+      FAIL() << "Expected ErrorReal64TooLarge";
+   }
+   catch ( e57::E57Exception &err )
+   {
+      EXPECT_EQ( err.errorCode(), e57::ErrorReal64TooLarge );
+   }
+
+   EXPECT_EQ( xFloat.impl()->nextIndex(), 3u );
+
+   imf.cancel();
+}
+
+TEST( SourceDestBufferImpl, SetNextRawBlock )
+{
+   e57::ImageFile imf( "./SourceDestBufferBlock.e57", "w" );
+
+   const std::vector<double> values = { 1.5, -2.25, 1.0e300, 0.0 };
+
+   // Start the source at an odd address, as in a packet
+   std::vector<char> bytes( 1 + values.size() * sizeof( double ) );
+   memcpy( bytes.data() + 1, values.data(), values.size() * sizeof( double ) );
+
+   std::vector<double> packed( values.size() );
+   e57::SourceDestBuffer packedBuffer( imf, "x", packed.data(), packed.size(), false );
+
+   EXPECT_TRUE( packedBuffer.impl()->setNextRawBlock( e57::Real64, bytes.data() + 1, 4 ) );
+   EXPECT_EQ( packed, values );
+   EXPECT_EQ( packedBuffer.impl()->nextIndex(), 4u );
+
+   // Other types & strided buffers must go through the converting functions
+   std::vector<float> floats( values.size() );
+   e57::SourceDestBuffer floatBuffer( imf, "x", floats.data(), floats.size(), true );
+
+   EXPECT_FALSE( floatBuffer.impl()->setNextRawBlock( e57::Real64, bytes.data() + 1, 4 ) );
+
+   std::vector<double> strided( 2 * values.size() );
+   e57::SourceDestBuffer stridedBuffer( imf, "x", strided.data(), values.size(), false, false,
+                                        2 * sizeof( double ) );
+
+   EXPECT_FALSE( stridedBuffer.impl()->setNextRawBlock( e57::Real64, bytes.data() + 1, 4 ) );
+   EXPECT_EQ( stridedBuffer.impl()->nextIndex(), 0u );
+
+   imf.cancel();
+}
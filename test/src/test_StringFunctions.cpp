@@ -2,6 +2,9 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include <clocale>
+#include <cmath>
+#include <cstring>
+#include <random>
 
 #include "gtest/gtest.h"
 
@@ -65,3 +68,54 @@ TEST( StringFunctions, FloatToStrLocale )
 
    std::locale::global( std::locale::classic() );
 }
+
+TEST( StringFunctions, ShortestFloatingPointToStr )
+{
+   EXPECT_EQ( e57::floatingPointToShortestStr<double>( 0.1 ), "1e-01" );
+   EXPECT_EQ( e57::floatingPointToShortestStr<double>( 3.141592653589793238 ),
+              "3.141592653589793" );
+   EXPECT_EQ( e57::floatingPointToShortestStr<double>( -2.5 ), "-2.5" );
+   EXPECT_EQ( e57::floatingPointToShortestStr<double>( 0.0 ), "0" );
+   EXPECT_EQ( e57::floatingPointToShortestStr<float>( 3.14159265f ), "3.1415927" );
+   EXPECT_EQ( e57::floatingPointToShortestStr<float>( 123456.0f ), "1.23456e+05" );
+   EXPECT_EQ( e57::floatingPointToShortestStr<float>( 0.1f ), "1e-01" );
+
+   // Every value reads back exactly
+   std::mt19937_64 generator( 57 );
+
+   for ( int i = 0; i < 10000; ++i )
+   {
+      const uint64_t bits = generator();
+
+      double d = 0.0;
+      memcpy( &d, &bits, sizeof( d ) );
+
+      float f = 0.0f;
+      memcpy( &f, &bits, sizeof( f ) );
+
+      if ( std::isfinite( d ) )
+      {
+         ASSERT_EQ( e57::strToDouble( e57::floatingPointToShortestStr( d ) ), d );
+      }
+
+      if ( std::isfinite( f ) )
+      {
+         ASSERT_EQ( strtof( e57::floatingPointToShortestStr( f ).c_str(), nullptr ), f );
+      }
+   }
+}
+
+// The C locale's decimal point must not be used either
+TEST( StringFunctions, ShortestFloatingPointToStrLocale )
+{
+   if ( setlocale( LC_NUMERIC, "fr_FR.UTF-8" ) == nullptr )
+   {
+      GTEST_SKIP() << "fr_FR.UTF-8 locale not available";
+   }
+
+   const auto converted = e57::floatingPointToShortestStr<double>( 1.5e10 );
+
+   setlocale( LC_NUMERIC, "C" );
+
+   ASSERT_EQ( converted, "1.5e+10" );
+}
@@ -0,0 +1,904 @@
+// SPDX-License-Identifier: BSL-1.0
+
+// e57perf: measure how fast the library reads a given E57 file on this machine, and print the
+// results as JSON (see tools/README.md).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <locale>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "E57Format.h"
+#include "E57Memory.h"
+#include "E57SimpleReader.h"
+#include "E57Version.h"
+
+namespace
+{
+   struct Options
+   {
+      std::string path;
+      std::string outputPath; // standard output if empty
+
+      /// Thread counts of the scaling runs. If empty, 1, 2, 4... up to the hardware threads.
+      std::vector<unsigned> threadCounts;
+
+      /// Records read at once by the sequential reads
+      size_t blockRecordCount = 65536;
+
+      /// The scaling runs read whole scans into memory, so they skip scans larger than this
+      uint64_t scalingMaxPoints = 100000000;
+
+      bool checksums = true;
+      bool scaling = true;
+   };
+
+   const char cUsage[] =
+      "Usage: e57perf [options] <file.e57>\n"
+      "\n"
+      "Reads the file several ways and prints how long each took as JSON.\n"
+      "\n"
+      "Options:\n"
+      "  --output <file>              Write the JSON to <file> instead of standard output\n"
+      "  --threads <n,n,...>          Thread counts of the scaling runs (default 1, 2, 4...\n"
+      "                               up to the number of hardware threads)\n"
+      "  --block-records <n>          Records read at once by the sequential reads (65536)\n"
+      "  --scaling-max-points <n>     Skip larger scans in the scaling runs (100000000)\n"
+      "  --no-checksums               Don't compare the checksum policies\n"
+      "  --no-scaling                 Don't measure the parallel reads\n"
+      "  --help                       Show this help\n";
+
+   using Clock = std::chrono::steady_clock;
+
+   double secondsSince( Clock::time_point start )
+   {
+      return std::chrono::duration<double>( Clock::now() - start ).count();
+   }
+
+   double ratio( double count, double seconds )
+   {
+      return ( seconds > 0.0 ) ? ( count / seconds ) : 0.0;
+   }
+
+   /// Writes indented JSON, adding the commas between members.
+   class JsonWriter
+   {
+   public:
+      explicit JsonWriter( std::ostream &os ) : os_( os )
+      {
+         os_.imbue( std::locale::classic() );
+         os_.precision( 9 );
+      }
+
+      void beginObject( const char *key = nullptr )
+      {
+         begin( key, '{' );
+      }
+
+      void endObject()
+      {
+         end( '}' );
+      }
+
+      void beginArray( const char *key = nullptr )
+      {
+         begin( key, '[' );
+      }
+
+      void endArray()
+      {
+         end( ']' );
+      }
+
+      void value( const char *key, const std::string &text )
+      {
+         member( key );
+         writeString( text );
+      }
+
+      void value( const char *key, const char *text )
+      {
+         value( key, std::string( text ) );
+      }
+
+      void value( const char *key, double number )
+      {
+         member( key );
+
+         // JSON has no infinities or NaNs
+         if ( std::isfinite( number ) )
+         {
+            os_ << number;
+         }
+         else
+         {
+            os_ << "null";
+         }
+      }
+
+      void value( const char *key, uint64_t number )
+      {
+         member( key );
+         os_ << number;
+      }
+
+      void value( const char *key, int64_t number )
+      {
+         member( key );
+         os_ << number;
+      }
+
+      void value( const char *key, unsigned number )
+      {
+         value( key, static_cast<uint64_t>( number ) );
+      }
+
+      void value( const char *key, bool flag )
+      {
+         member( key );
+         os_ << ( flag ? "true" : "false" );
+      }
+
+      void finish()
+      {
+         os_ << '\n';
+      }
+
+   private:
+      void member( const char *key )
+      {
+         if ( !first_.empty() )
+         {
+            os_ << ( first_.back() ? "\n" : ",\n" );
+            first_.back() = false;
+         }
+
+         os_ << std::string( first_.size() * 2, ' ' );
+
+         if ( key != nullptr )
+         {
+            writeString( key );
+            os_ << ": ";
+         }
+      }
+
+      void begin( const char *key, char bracket )
+      {
+         member( key );
+         os_ << bracket;
+         first_.push_back( true );
+      }
+
+      void end( char bracket )
+      {
+         const bool cEmpty = first_.back();
+
+         first_.pop_back();
+
+         if ( !cEmpty )
+         {
+            os_ << '\n' << std::string( first_.size() * 2, ' ' );
+         }
+
+         os_ << bracket;
+      }
+
+      void writeString( const std::string &text )
+      {
+         static const char cHex[] = "0123456789abcdef";
+
+         os_ << '"';
+
+         for ( const char c : text )
+         {
+            switch ( c )
+            {
+               case '"':
+                  os_ << "\\\"";
+                  break;
+               case '\\':
+                  os_ << "\\\\";
+                  break;
+               case '\n':
+                  os_ << "\\n";
+                  break;
+               case '\r':
+                  os_ << "\\r";
+                  break;
+               case '\t':
+                  os_ << "\\t";
+                  break;
+               default:
+                  if ( static_cast<unsigned char>( c ) < 0x20 )
+                  {
+                     os_ << "\\u00" << cHex[( c >> 4 ) & 0xF] << cHex[c & 0xF];
+                  }
+                  else
+                  {
+                     os_ << c; // UTF-8 is passed through
+                  }
+                  break;
+            }
+         }
+
+         os_ << '"';
+      }
+
+      std::ostream &os_;
+      std::vector<bool> first_; /// for each open object or array, whether it has no members yet
+   };
+
+   /// A field of the prototype, read into doubles (numbers) or strings.
+   struct Field
+   {
+      std::string path;
+      bool isString = false;
+   };
+
+   void collectFields( const e57::Node &node, const std::string &path, std::vector<Field> &fields )
+   {
+      switch ( node.type() )
+      {
+         case e57::TypeStructure:
+         {
+            const e57::StructureNode cStructure( node );
+
+            for ( int64_t i = 0; i < cStructure.childCount(); ++i )
+            {
+               const e57::Node cChild = cStructure.get( i );
+               const std::string cName = cChild.elementName();
+
+               collectFields( cChild, path.empty() ? cName : ( path + "/" + cName ), fields );
+            }
+            break;
+         }
+
+         case e57::TypeVector:
+         {
+            const e57::VectorNode cVector( node );
+
+            for ( int64_t i = 0; i < cVector.childCount(); ++i )
+            {
+               const std::string cName = std::to_string( i );
+
+               collectFields( cVector.get( i ), path.empty() ? cName : ( path + "/" + cName ),
+                              fields );
+            }
+            break;
+         }
+
+         case e57::TypeInteger:
+         case e57::TypeScaledInteger:
+         case e57::TypeFloat:
+            fields.push_back( { path, false } );
+            break;
+
+         case e57::TypeString:
+            fields.push_back( { path, true } );
+            break;
+
+         default:
+            break;
+      }
+   }
+
+   /// Buffers for each field of a scan, which hold @a capacity records.
+   struct ScanBuffers
+   {
+      ScanBuffers( const e57::ImageFile &imf, const std::vector<Field> &fields, size_t capacity ) :
+         numbers( fields.size() ), strings( fields.size() )
+      {
+         for ( size_t i = 0; i < fields.size(); ++i )
+         {
+            if ( fields[i].isString )
+            {
+               buffers.emplace_back( imf, fields[i].path, &strings[i] );
+            }
+            else
+            {
+               numbers[i].resize( capacity );
+               buffers.emplace_back( imf, fields[i].path, numbers[i].data(), capacity, true,
+                                     true );
+            }
+         }
+      }
+
+      std::vector<std::vector<double>> numbers;
+      std::vector<std::vector<e57::ustring>> strings;
+      std::vector<e57::SourceDestBuffer> buffers;
+   };
+
+   struct Scan
+   {
+      int64_t index = 0;
+      std::string name;
+      uint64_t pointCount = 0;
+      std::vector<Field> fields;
+   };
+
+   e57::CompressedVectorNode scanPoints( const e57::ImageFile &imf, int64_t index )
+   {
+      const e57::VectorNode cData3D( imf.root().get( "/data3D" ) );
+      const e57::StructureNode cScan( cData3D.get( index ) );
+
+      return e57::CompressedVectorNode( cScan.get( "points" ) );
+   }
+
+   std::vector<Scan> findScans( const e57::ImageFile &imf )
+   {
+      std::vector<Scan> scans;
+
+      if ( !imf.root().isDefined( "/data3D" ) )
+      {
+         return scans;
+      }
+
+      const e57::VectorNode cData3D( imf.root().get( "/data3D" ) );
+
+      for ( int64_t i = 0; i < cData3D.childCount(); ++i )
+      {
+         const e57::StructureNode cScanNode( cData3D.get( i ) );
+
+         if ( !cScanNode.isDefined( "points" ) ||
+              ( cScanNode.get( "points" ).type() != e57::TypeCompressedVector ) )
+         {
+            continue;
+         }
+
+         Scan scan;
+         scan.index = i;
+
+         if ( cScanNode.isDefined( "name" ) &&
+              ( cScanNode.get( "name" ).type() == e57::TypeString ) )
+         {
+            scan.name = e57::StringNode( cScanNode.get( "name" ) ).value();
+         }
+
+         const e57::CompressedVectorNode cPoints( cScanNode.get( "points" ) );
+
+         scan.pointCount = static_cast<uint64_t>( cPoints.childCount() );
+         collectFields( cPoints.prototype(), "", scan.fields );
+
+         scans.push_back( scan );
+      }
+
+      return scans;
+   }
+
+   struct ScanRead
+   {
+      double seconds = 0.0;
+      uint64_t recordCount = 0;
+      e57::CompressedVectorReaderStatistics statistics;
+   };
+
+   /// Read all the records of @a scan with one reader, @a blockRecordCount at a time.
+   ScanRead readScan( const e57::ImageFile &imf, const Scan &scan, size_t blockRecordCount )
+   {
+      ScanRead result;
+
+      e57::CompressedVectorNode points = scanPoints( imf, scan.index );
+      ScanBuffers buffers( imf, scan.fields, blockRecordCount );
+
+      const auto cStart = Clock::now();
+
+      e57::CompressedVectorReader reader = points.reader( buffers.buffers );
+
+      while ( const unsigned cCount = reader.read() )
+      {
+         result.recordCount += cCount;
+      }
+
+      result.statistics = reader.statistics();
+      reader.close();
+
+      result.seconds = secondsSince( cStart );
+
+      return result;
+   }
+
+   void reportOpen( JsonWriter &json, const Options &options )
+   {
+      // Open it twice: the first open brings the file into the operating system's cache (when it
+      // fits), so the second is comparable between runs.
+      for ( const char *label : { "open", "openCached" } )
+      {
+         const auto cStart = Clock::now();
+
+         e57::ImageFile imf( options.path, "r" );
+
+         const double cSeconds = secondsSince( cStart );
+         const e57::ImageFileStatistics cStatistics = imf.statistics();
+
+         json.beginObject( label );
+         json.value( "seconds", cSeconds );
+         json.value( "xmlParseSeconds", cStatistics.xmlParseSeconds );
+         json.value( "pagesRead", cStatistics.pagesRead );
+         json.value( "checksumSeconds", cStatistics.checksumSeconds );
+         json.endObject();
+
+         imf.close();
+      }
+   }
+
+   void reportScans( JsonWriter &json, const Options &options, const std::vector<Scan> &scans )
+   {
+      e57::ImageFile imf( options.path, "r" );
+
+      json.beginArray( "data3D" );
+
+      for ( const Scan &scan : scans )
+      {
+         const e57::ImageFileStatistics cBefore = imf.statistics();
+         const ScanRead cRead = readScan( imf, scan, options.blockRecordCount );
+         const e57::ImageFileStatistics cAfter = imf.statistics();
+
+         const auto &cStatistics = cRead.statistics;
+
+         uint64_t byteCount = 0;
+
+         for ( const auto &bytestream : cStatistics.bytestreams )
+         {
+            byteCount += bytestream.byteCount;
+         }
+
+         const uint64_t cLookups = cStatistics.packetCacheHits + cStatistics.packetCacheMisses;
+
+         json.beginObject();
+         json.value( "index", scan.index );
+         json.value( "name", scan.name );
+         json.value( "pointCount", scan.pointCount );
+         json.value( "seconds", cRead.seconds );
+         json.value( "bytes", byteCount );
+         json.value( "megabytesPerSecond", ratio( byteCount / 1.0e6, cRead.seconds ) );
+         json.value( "pointsPerSecond", ratio( cRead.recordCount, cRead.seconds ) );
+
+         json.beginObject( "packetCache" );
+         json.value( "hits", cStatistics.packetCacheHits );
+         json.value( "misses", cStatistics.packetCacheMisses );
+         json.value( "evictions", cStatistics.packetCacheEvictions );
+         json.value( "hitRate", ratio( cStatistics.packetCacheHits, cLookups ) );
+         json.endObject();
+
+         json.value( "pagesRead", cAfter.pagesRead - cBefore.pagesRead );
+         json.value( "checksumSeconds", cAfter.checksumSeconds - cBefore.checksumSeconds );
+
+         // The rates of each field only count the time spent decoding it
+         json.beginArray( "fields" );
+
+         for ( const auto &bytestream : cStatistics.bytestreams )
+         {
+            json.beginObject();
+            json.value( "name", bytestream.pathName );
+            json.value( "bytes", bytestream.byteCount );
+            json.value( "decodeSeconds", bytestream.decodeSeconds );
+            json.value( "megabytesPerSecond",
+                        ratio( bytestream.byteCount / 1.0e6, bytestream.decodeSeconds ) );
+            json.value( "pointsPerSecond", ratio( cRead.recordCount, bytestream.decodeSeconds ) );
+            json.endObject();
+         }
+
+         json.endArray();
+         json.endObject();
+      }
+
+      json.endArray();
+
+      imf.close();
+   }
+
+   void reportChecksums( JsonWriter &json, const Options &options, const std::vector<Scan> &scans )
+   {
+      struct Policy
+      {
+         const char *name;
+         e57::ReadChecksumPolicy policy;
+      };
+
+      const Policy cPolicies[] = { { "ChecksumNone", e57::ChecksumNone },
+                                   { "ChecksumSparse", e57::ChecksumSparse },
+                                   { "ChecksumHalf", e57::ChecksumHalf },
+                                   { "ChecksumAll", e57::ChecksumAll } };
+
+      json.beginArray( "checksumPolicies" );
+
+      for ( const Policy &policy : cPolicies )
+      {
+         const auto cStart = Clock::now();
+
+         e57::ImageFile imf( options.path, "r", policy.policy );
+
+         uint64_t recordCount = 0;
+
+         for ( const Scan &scan : scans )
+         {
+            recordCount += readScan( imf, scan, options.blockRecordCount ).recordCount;
+         }
+
+         const e57::ImageFileStatistics cStatistics = imf.statistics();
+
+         imf.close();
+
+         const double cSeconds = secondsSince( cStart );
+
+         json.beginObject();
+         json.value( "policy", policy.name );
+         json.value( "percent", static_cast<int64_t>( policy.policy ) );
+         json.value( "seconds", cSeconds );
+         json.value( "pointsPerSecond", ratio( recordCount, cSeconds ) );
+         json.value( "pagesRead", cStatistics.pagesRead );
+         json.value( "checksumsVerified", cStatistics.checksumsVerified );
+         json.value( "checksumSeconds", cStatistics.checksumSeconds );
+         json.endObject();
+      }
+
+      json.endArray();
+   }
+
+   std::vector<unsigned> scalingThreadCounts( const Options &options )
+   {
+      if ( !options.threadCounts.empty() )
+      {
+         return options.threadCounts;
+      }
+
+      const unsigned cHardware = std::max( std::thread::hardware_concurrency(), 1u );
+
+      std::vector<unsigned> counts;
+
+      for ( unsigned count = 1; count < cHardware; count *= 2 )
+      {
+         counts.push_back( count );
+      }
+
+      counts.push_back( cHardware );
+
+      return counts;
+   }
+
+   /// Write one run of a parallel read mode, with its speedup over the first run of the mode.
+   void reportRun( JsonWriter &json, unsigned threadCount, double seconds, uint64_t pointCount,
+                   double firstSeconds )
+   {
+      json.beginObject();
+      json.value( "threads", threadCount );
+      json.value( "seconds", seconds );
+      json.value( "pointsPerSecond", ratio( pointCount, seconds ) );
+      json.value( "speedup", ratio( firstSeconds, seconds ) );
+      json.endObject();
+   }
+
+   void reportScaling( JsonWriter &json, const Options &options, const std::vector<Scan> &scans )
+   {
+      const std::vector<unsigned> cThreadCounts = scalingThreadCounts( options );
+
+      std::vector<const Scan *> scaled;
+      uint64_t scaledPointCount = 0;
+
+      for ( const Scan &scan : scans )
+      {
+         if ( ( scan.pointCount > 0 ) && ( scan.pointCount <= options.scalingMaxPoints ) )
+         {
+            scaled.push_back( &scan );
+            scaledPointCount += scan.pointCount;
+         }
+      }
+
+      json.beginObject( "threadScaling" );
+      json.value( "scanCount", static_cast<uint64_t>( scaled.size() ) );
+      json.value( "skippedScanCount", static_cast<uint64_t>( scans.size() - scaled.size() ) );
+      json.value( "pointCount", scaledPointCount );
+
+      // Each scan split into chunks using its index (CompressedVectorNode::readParallel()), one
+      // scan after the other
+      json.beginArray( "chunks" );
+
+      double firstSeconds = 0.0;
+
+      for ( const unsigned cThreads : cThreadCounts )
+      {
+         e57::ImageFile imf( options.path, "r" );
+
+         double seconds = 0.0;
+
+         for ( const Scan *scan : scaled )
+         {
+            e57::CompressedVectorNode points = scanPoints( imf, scan->index );
+            ScanBuffers buffers( imf, scan->fields, static_cast<size_t>( scan->pointCount ) );
+
+            const auto cStart = Clock::now();
+
+            points.readParallel( buffers.buffers, cThreads );
+
+            seconds += secondsSince( cStart );
+         }
+
+         imf.close();
+
+         firstSeconds = ( firstSeconds == 0.0 ) ? seconds : firstSeconds;
+
+         reportRun( json, cThreads, seconds, scaledPointCount, firstSeconds );
+      }
+
+      json.endArray();
+
+      // All the scans at once through the Simple API (Reader::ReadData3DPointsDataParallel()),
+      // which only reads the standard fields
+      json.beginArray( "scans" );
+
+      firstSeconds = 0.0;
+
+      for ( const unsigned cThreads : cThreadCounts )
+      {
+         e57::Reader reader( options.path, {} );
+
+         std::vector<int64_t> indices;
+         std::vector<std::unique_ptr<e57::Data3DPointsDouble>> data;
+         std::vector<e57::Data3DPointsDouble *> buffers;
+
+         for ( const Scan *scan : scaled )
+         {
+            e57::Data3D header;
+            reader.ReadData3D( scan->index, header );
+
+            indices.push_back( scan->index );
+            data.emplace_back( new e57::Data3DPointsDouble( header ) );
+            buffers.push_back( data.back().get() );
+         }
+
+         e57::ParallelReadOptions readOptions;
+         readOptions.threadCount = cThreads;
+
+         const auto cStart = Clock::now();
+
+         if ( !indices.empty() )
+         {
+            reader.ReadData3DPointsDataParallel( indices, buffers, readOptions );
+         }
+
+         const double cSeconds = secondsSince( cStart );
+
+         reader.Close();
+
+         firstSeconds = ( firstSeconds == 0.0 ) ? cSeconds : firstSeconds;
+
+         reportRun( json, cThreads, cSeconds, scaledPointCount, firstSeconds );
+      }
+
+      json.endArray();
+      json.endObject();
+   }
+
+   void report( std::ostream &os, const Options &options )
+   {
+      JsonWriter json( os );
+
+      uint64_t fileBytes = 0;
+
+      {
+         std::ifstream file( options.path, std::ios::binary | std::ios::ate );
+
+         if ( !file )
+         {
+            throw std::runtime_error( "cannot open " + options.path );
+         }
+
+         fileBytes = static_cast<uint64_t>( file.tellg() );
+      }
+
+      json.beginObject();
+      json.value( "tool", "e57perf" );
+      json.value( "library", e57::Version::library() );
+      json.value( "file", options.path );
+      json.value( "fileBytes", fileBytes );
+      json.value( "hardwareThreads", std::thread::hardware_concurrency() );
+      json.value( "blockRecords", static_cast<uint64_t>( options.blockRecordCount ) );
+
+      reportOpen( json, options );
+
+      std::vector<Scan> scans;
+
+      {
+         e57::ImageFile imf( options.path, "r" );
+         scans = findScans( imf );
+         imf.close();
+      }
+
+      reportScans( json, options, scans );
+
+      if ( options.checksums )
+      {
+         reportChecksums( json, options, scans );
+      }
+
+      if ( options.scaling )
+      {
+         reportScaling( json, options, scans );
+      }
+
+      const e57::Memory::Statistics cMemory = e57::Memory::statistics();
+
+      json.beginObject( "memory" );
+      json.value( "peakBytes", cMemory.total.peakBytes );
+      json.value( "packetCachesPeakBytes", cMemory.packetCaches.peakBytes );
+      json.value( "decodersPeakBytes", cMemory.decoders.peakBytes );
+      json.endObject();
+
+      json.endObject();
+      json.finish();
+   }
+
+   bool parseCount( const char *text, uint64_t &count )
+   {
+      char *end = nullptr;
+      const unsigned long long cValue = std::strtoull( text, &end, 10 );
+
+      if ( ( end == text ) || ( *end != '\0' ) || ( cValue == 0 ) )
+      {
+         return false;
+      }
+
+      count = cValue;
+
+      return true;
+   }
+
+   bool parseThreadCounts( const std::string &text, std::vector<unsigned> &counts )
+   {
+      std::istringstream stream( text );
+      std::string item;
+
+      while ( std::getline( stream, item, ',' ) )
+      {
+         uint64_t count = 0;
+
+         if ( !parseCount( item.c_str(), count ) || ( count > 4096 ) )
+         {
+            return false;
+         }
+
+         counts.push_back( static_cast<unsigned>( count ) );
+      }
+
+      return !counts.empty();
+   }
+
+   /// Returns false (having printed why) if the arguments are wrong.
+   bool parseArguments( int argc, char **argv, Options &options, bool &help )
+   {
+      for ( int i = 1; i < argc; ++i )
+      {
+         const std::string cArgument = argv[i];
+         const bool cHasValue = ( i + 1 ) < argc;
+
+         uint64_t count = 0;
+
+         if ( cArgument == "--help" || cArgument == "-h" )
+         {
+            help = true;
+            return true;
+         }
+
+         if ( cArgument == "--no-checksums" )
+         {
+            options.checksums = false;
+         }
+         else if ( cArgument == "--no-scaling" )
+         {
+            options.scaling = false;
+         }
+         else if ( ( cArgument == "--output" ) && cHasValue )
+         {
+            options.outputPath = argv[++i];
+         }
+         else if ( ( cArgument == "--threads" ) && cHasValue )
+         {
+            if ( !parseThreadCounts( argv[++i], options.threadCounts ) )
+            {
+               std::cerr << "e57perf: bad thread counts: " << argv[i] << '\n';
+               return false;
+            }
+         }
+         else if ( ( cArgument == "--block-records" ) && cHasValue )
+         {
+            if ( !parseCount( argv[++i], count ) || ( count > ( 1u << 30 ) ) )
+            {
+               std::cerr << "e57perf: bad record count: " << argv[i] << '\n';
+               return false;
+            }
+
+            options.blockRecordCount = static_cast<size_t>( count );
+         }
+         else if ( ( cArgument == "--scaling-max-points" ) && cHasValue )
+         {
+            if ( !parseCount( argv[++i], count ) )
+            {
+               std::cerr << "e57perf: bad point count: " << argv[i] << '\n';
+               return false;
+            }
+
+            options.scalingMaxPoints = count;
+         }
+         else if ( ( cArgument.compare( 0, 2, "--" ) == 0 ) || !options.path.empty() )
+         {
+            std::cerr << "e57perf: unexpected argument: " << cArgument << '\n';
+            return false;
+         }
+         else
+         {
+            options.path = cArgument;
+         }
+      }
+
+      if ( options.path.empty() )
+      {
+         std::cerr << "e57perf: no file given\n";
+         return false;
+      }
+
+      return true;
+   }
+}
+
+int main( int argc, char **argv )
+{
+   Options options;
+   bool help = false;
+
+   if ( !parseArguments( argc, argv, options, help ) )
+   {
+      std::cerr << '\n' << cUsage;
+      return 2;
+   }
+
+   if ( help )
+   {
+      std::cout << cUsage;
+      return 0;
+   }
+
+   try
+   {
+      if ( options.outputPath.empty() )
+      {
+         report( std::cout, options );
+      }
+      else
+      {
+         // Write to a string first, so a failure leaves no partial file behind
+         std::ostringstream json;
+
+         report( json, options );
+
+         std::ofstream output( options.outputPath, std::ios::binary );
+         output << json.str();
+
+         if ( !output )
+         {
+            std::cerr << "e57perf: cannot write " << options.outputPath << '\n';
+            return 1;
+         }
+      }
+   }
+   catch ( const e57::E57Exception &err )
+   {
+      std::cerr << "e57perf: " << err.errorStr() << " (" << err.context() << ")\n";
+      return 1;
+   }
+   catch ( const std::exception &err )
+   {
+      std::cerr << "e57perf: " << err.what() << '\n';
+      return 1;
+   }
+
+   return 0;
+}